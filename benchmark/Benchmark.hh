@@ -0,0 +1,123 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <chrono>
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <cstdlib>
+
+using std::atof;
+
+#include <iostream>
+
+using std::cout;
+
+#include <string>
+
+using std::string;
+
+/**
+ * \brief Minimal harness for the micro benchmarks of alpaca.
+ *
+ * Each benchmark repeats a function until a minimum time has passed, and
+ * writes the result as a single line in the JSON format to the standard
+ * output:
+ *
+ * ```
+ * {"benchmark": "...", "parameter": "...", "calls": ..., "items": ...,
+ *  "seconds": ..., "items_per_second": ...}
+ * ```
+ *
+ * (without the line break), where an 'item' is the unit of work that the
+ * benchmark measures, for example an evaluation or a sampled event.
+ * The output of several runs can be collected in a file with one JSON object
+ * per line and compared to detect performance regressions.
+ */
+namespace benchmark {
+
+/**
+ * \brief Value that the benchmarked functions can write their results to, to
+ * prevent the compiler from removing the calculation.
+ */
+inline volatile double sink = 0.;
+
+/**
+ * \brief Minimum run time of a benchmark in seconds.
+ *
+ * Can be set with the first command-line argument of the benchmark
+ * executables (see init()).
+ */
+inline double min_time = 0.5;
+
+/**
+ * \brief Read the minimum run time from the command line.
+ */
+inline void init(int argc, char **argv) {
+  if (argc > 1) {
+    min_time = atof(argv[1]);
+  }
+}
+
+/**
+ * \brief Run a benchmark and print the result.
+ *
+ * The function is called once before the measurement to warm up caches and
+ * lazily initialized data.
+ * After that, it is called repeatedly, doubling the number of calls between
+ * readings of the clock, until the total time exceeds min_time.
+ *
+ * \param name Name of the benchmark.
+ * \param parameter Description of the parameters of the benchmark, for
+ * example the spins of a cascade.
+ * \param items_per_call Number of items that are processed in a single call
+ * of f.
+ * \param f Function without arguments.
+ */
+template <typename F>
+void run(const string &name, const string &parameter,
+         const size_t items_per_call, F f) {
+  f();
+
+  size_t calls = 0;
+  double seconds = 0.;
+  const auto start = steady_clock::now();
+  for (size_t n = 1; seconds < min_time; n *= 2) {
+    for (size_t i = 0; i < n; ++i) {
+      f();
+    }
+    calls += n;
+    seconds = duration<double>(steady_clock::now() - start).count();
+  }
+
+  const size_t items = calls * items_per_call;
+  cout << "{\"benchmark\": \"" << name << "\", \"parameter\": \"" << parameter
+       << "\", \"calls\": " << calls << ", \"items\": " << items
+       << ", \"seconds\": " << seconds
+       << ", \"items_per_second\": " << (double)items / seconds << "}\n";
+}
+
+} // namespace benchmark
@@ -0,0 +1,136 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <string>
+
+using std::to_string;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "Benchmark.hh"
+#include "State.hh"
+#include "Transition.hh"
+
+/**
+ * Dir-dir cascade with n_steps dipole transitions between states of
+ * increasing spin, starting from two_J.
+ */
+pair<State, vector<pair<Transition, State>>> cascade(const int two_J,
+                                                     const size_t n_steps) {
+  vector<pair<Transition, State>> cascade_steps;
+  for (size_t i = 1; i <= n_steps; ++i) {
+    cascade_steps.push_back({Transition(2, 4, 0.1), State(two_J + 2 * (int)i)});
+  }
+  return {State(two_J), cascade_steps};
+}
+
+extern "C" {
+int evaluate_angular_correlations(const size_t n_cascades, size_t *offsets,
+                                  int *two_J, short *par, short *em_char,
+                                  int *two_L, short *em_charp, int *two_Lp,
+                                  double *delta, const size_t n_angles,
+                                  double *theta, double *phi, double *result);
+}
+
+int main(int argc, char **argv) {
+  benchmark::init(argc, argv);
+
+  // Construction vs. length of the cascade and spin of the initial state.
+  for (size_t n_steps = 2; n_steps <= 5; ++n_steps) {
+    const auto cas = cascade(0, n_steps);
+    benchmark::run("AngularCorrelation::AngularCorrelation",
+                   "n_steps=" + to_string(n_steps), 1, [&]() {
+                     benchmark::sink =
+                         AngularCorrelation(cas.first, cas.second)(0.1, 0.2);
+                   });
+  }
+  for (int two_J = 0; two_J <= 12; two_J += 4) {
+    const auto cas = cascade(two_J, 2);
+    benchmark::run("AngularCorrelation::AngularCorrelation",
+                   "two_J=" + to_string(two_J), 1, [&]() {
+                     benchmark::sink =
+                         AngularCorrelation(cas.first, cas.second)(0.1, 0.2);
+                   });
+  }
+
+  // Evaluation of a dir-dir and a pol-dir correlation.
+  const AngularCorrelation dir_dir(cascade(0, 2).first, cascade(0, 2).second);
+  const AngularCorrelation pol_dir(
+      State(4, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.5), State(6, positive)},
+       {Transition(magnetic, 2, electric, 4, 2.), State(4, positive)}});
+
+  const size_t n = 4096;
+  vector<double> theta(n), phi(n), result(n);
+  for (size_t i = 0; i < n; ++i) {
+    theta[i] = M_PI * i / (n - 1.);
+    phi[i] = 2. * M_PI * ((7 * i) % n) / n;
+  }
+
+  for (auto &[name, ang_cor] :
+       {pair<string, const AngularCorrelation &>{"dir_dir", dir_dir},
+        pair<string, const AngularCorrelation &>{"pol_dir", pol_dir}}) {
+    benchmark::run("AngularCorrelation::operator()", name, n, [&]() {
+      double sum = 0.;
+      for (size_t i = 0; i < n; ++i) {
+        sum += ang_cor(theta[i], phi[i]);
+      }
+      benchmark::sink = sum;
+    });
+    benchmark::run("AngularCorrelation::evaluate", name, n, [&]() {
+      ang_cor.evaluate(n, theta.data(), phi.data(), result.data());
+      benchmark::sink = result[n - 1];
+    });
+  }
+
+  // Batch path of the C interface, which constructs and evaluates several
+  // cascades in a single call.
+  const size_t n_cascades = 4;
+  vector<size_t> offsets{0, 2, 4, 6, 8};
+  vector<int> two_J{0, 2, 0, 0, 2, 4, 4, 6, 4, 0, 6, 0};
+  vector<short> par{1, -1, 1, 1, -1, 1, 1, 1, 1, 1, 1, 1};
+  vector<short> em_char{-1, -1, -1, -1, 1, 1, 1, 1};
+  vector<int> two_L{2, 2, 2, 2, 2, 2, 6, 6};
+  vector<short> em_charp{1, 1, 1, 1, -1, -1, -1, -1};
+  vector<int> two_Lp{4, 4, 4, 4, 4, 4, 8, 8};
+  vector<double> delta{0., 0., 0., 0.3, 0.5, 2., 0., 0.};
+  vector<double> batch_result(n_cascades * n);
+  benchmark::run("evaluate_angular_correlations", "n_cascades=4", n_cascades,
+                 [&]() {
+                   evaluate_angular_correlations(
+                       n_cascades, offsets.data(), two_J.data(), par.data(),
+                       em_char.data(), two_L.data(), em_charp.data(),
+                       two_Lp.data(), delta.data(), n, theta.data(),
+                       phi.data(), batch_result.data());
+                   benchmark::sink = batch_result[0];
+                 });
+}
@@ -0,0 +1,57 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <string>
+
+using std::to_string;
+
+#include "Benchmark.hh"
+#include "FCoefficient.hh"
+#include "UvCoefficient.hh"
+#include "WignerSymbolCache.hh"
+
+/**
+ * Benchmarks for the construction of F and U coefficients, with and without
+ * the WignerSymbolCache.
+ */
+void benchmark_coefficients(const string &cache) {
+  for (int two_j = 2; two_j <= 10; two_j += 4) {
+    benchmark::run("FCoefficient" + cache, "two_j=" + to_string(two_j), 1,
+                   [&]() {
+                     benchmark::sink =
+                         FCoefficient(4, 2, 4, two_j, two_j).get_value();
+                   });
+    benchmark::run("UvCoefficient" + cache, "two_j=" + to_string(two_j), 1,
+                   [&]() {
+                     benchmark::sink =
+                         UvCoefficient(4, two_j, 2, 4, 0.5, two_j + 2)
+                             .get_value();
+                   });
+  }
+}
+
+int main(int argc, char **argv) {
+  benchmark::init(argc, argv);
+
+  benchmark_coefficients("");
+
+  WignerSymbolCache::set_max_size(0);
+  WignerSymbolCache::clear();
+  benchmark_coefficients("_uncached");
+}
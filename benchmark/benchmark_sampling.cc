@@ -0,0 +1,95 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <memory>
+
+using std::make_shared;
+using std::shared_ptr;
+
+#include <string>
+
+using std::to_string;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngCorrRejectionSampler.hh"
+#include "AngularCorrelation.hh"
+#include "Benchmark.hh"
+#include "CascadeSampler.hh"
+#include "SpherePointSampler.hh"
+#include "SphereRejectionSampler.hh"
+#include "State.hh"
+#include "Transition.hh"
+
+int main(int argc, char **argv) {
+  benchmark::init(argc, argv);
+
+  const size_t n_events = 4096;
+  vector<double> Phi(n_events), Theta(n_events), Psi(n_events);
+
+  // Rejection sampling of an analytical distribution and of an angular
+  // correlation.
+  SphereRejectionSampler sphere_sampler(
+      [](const double theta, const double) {
+        return 1. + 0.5 * cos(theta) * cos(theta);
+      },
+      1.5, 0);
+  benchmark::run("SphereRejectionSampler", "1+cos^2/2", n_events, [&]() {
+    sphere_sampler(n_events, Phi.data(), Theta.data(), Psi.data());
+    benchmark::sink = Theta[0];
+  });
+
+  const AngularCorrelation ang_cor_1(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+  const AngularCorrelation ang_cor_2(
+      State(4, positive),
+      {{Transition(electric, 4, magnetic, 6, 0.), State(0, positive)},
+       {Transition(electric, 4, magnetic, 6, 0.), State(4, positive)}});
+
+  AngCorrRejectionSampler ang_cor_sampler(ang_cor_1, 0);
+  benchmark::run("AngCorrRejectionSampler", "0+->1-->0+", n_events, [&]() {
+    ang_cor_sampler(n_events, Phi.data(), Theta.data(), Psi.data());
+    benchmark::sink = Theta[0];
+  });
+
+  // Cascade with an isotropic first step and two angular correlations.
+  CascadeSampler cascade_sampler(vector<shared_ptr<ReferenceFrameSampler>>{
+      make_shared<SphereRejectionSampler>(
+          [](const double, const double) { return 1.; }, 1., 0),
+      make_shared<AngCorrRejectionSampler>(ang_cor_1, 1),
+      make_shared<AngCorrRejectionSampler>(ang_cor_2, 2)});
+  vector<double> Phi_Theta_Psi(3 * cascade_sampler.get_n_steps() * n_events);
+  benchmark::run("CascadeSampler::sample", "n_steps=3", n_events, [&]() {
+    cascade_sampler.sample(n_events, Phi_Theta_Psi.data());
+    benchmark::sink = Phi_Theta_Psi[0];
+  });
+
+  // Scaling of the deterministic point generation with the number of points.
+  SpherePointSampler sphere_point_sampler;
+  for (unsigned int n = 100; n <= 100000; n *= 10) {
+    benchmark::run("SpherePointSampler::sample", "n=" + to_string(n), n,
+                   [&]() {
+                     benchmark::sink = sphere_point_sampler.sample(n)[0][0];
+                   });
+  }
+}
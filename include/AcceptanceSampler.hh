@@ -0,0 +1,213 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <random>
+
+using std::mt19937;
+using std::seed_seq;
+using std::uniform_real_distribution;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "EulerAngleRotation.hh"
+
+/**
+ * \brief Sample the direction of a step of a cascade only inside the
+ * acceptance of a set of detectors, and weight it with the probability of the
+ * acceptance.
+ *
+ * If most of the solid angle is not covered by detectors, most of the
+ * cascades that are sampled by CascadeSampler are lost after the tracking
+ * through the setup.
+ * For the step \f$i\f$ of the cascade whose photon is observed, the present
+ * class samples the direction only inside the acceptance \f$\mathcal{A}\f$,
+ * a union of disjoint cones with the axes \f$\left( \theta_c, \varphi_c
+ * \right)\f$ and the half opening angles \f$\alpha_c\f$ in the laboratory
+ * frame (see also SpotlightSampler and SphereRegion).
+ * Since the angular correlation \f$W\f$ of the step is defined in the
+ * reference frame \f$A_{i-1}\f$ of the previous step, the axes of the cones
+ * are transformed into that frame for each cascade, and the integrals of
+ * \f$W\f$ over the cones are given by the attenuated Legendre series of
+ * AngularCorrelation::integrate_cone(), whose attenuation factors depend only
+ * on the opening angles and are calculated once by the constructor.
+ *
+ * The direction is sampled by composition: a cone \f$c\f$ is selected with
+ * the probability
+ *
+ * \f[
+ *      P \left( c \right) = \frac{\int_{\Omega_c} W \mathrm{d} \Omega}{
+ * \sum_{c^\prime} \int_{\Omega_{c^\prime}} W \mathrm{d} \Omega}, \f]
+ *
+ * and a direction inside the cone is sampled from \f$W\f$ by rejection from a
+ * uniform distribution on the cone with the upper limit
+ * AngularCorrelation::get_upper_limit().
+ * The result is distributed like \f$W\f$ restricted to \f$\mathcal{A}\f$.
+ * The weight of the cascade is the probability that an unrestricted
+ * direction would have been inside the acceptance,
+ *
+ * \f[
+ *      w = \frac{\sum_c \int_{\Omega_c} W \mathrm{d} \Omega}{\int_{4 \pi} W
+ * \mathrm{d} \Omega},
+ * \f]
+ *
+ * which is exact up to rounding errors.
+ * Therefore, the sum of the weights of \f$n\f$ cascades estimates the number
+ * of the \f$n\f$ unrestricted cascades whose photon hits a detector, i.e.
+ * absolute rates are preserved.
+ * The cones must not overlap, because the integral over a union of
+ * overlapping cones has no closed form.
+ *
+ * For each cascade, the ratio of the expected number of evaluations of
+ * \f$W\f$ to the number of accepted directions is the upper limit divided by
+ * the mean value of \f$W\f$ in the selected cone, which is usually close to 1
+ * for small detectors.
+ * See CascadeSampler::restrict_to_acceptance() for the use in a cascade.
+ */
+class AcceptanceSampler {
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param w Angular correlation of the step.
+   * \param theta_phi Polar and azimuthal angles of the axes of the cones in
+   * the laboratory frame in radians.
+   * \param opening_angles Half opening angles \f$\alpha_c\f$ of the cones in
+   * radians.
+   * \param seed Random number seed.
+   * \param max_tri Maximum number of proposed directions per cascade
+   * (default: 1000).
+   *
+   * \throw invalid_argument if there are no cones, if the numbers of axes and
+   * opening angles differ, if an opening angle is not in \f$\left( 0, \pi
+   * \right]\f$, or if two cones overlap.
+   */
+  AcceptanceSampler(const AngularCorrelation &w,
+                    const vector<array<double, 2>> &theta_phi,
+                    const vector<double> &opening_angles, const int seed,
+                    const unsigned int max_tri = 1000);
+
+  /**
+   * \brief Sample the reference frame of the step relative to the frame of
+   * the previous step.
+   *
+   * The rotation matrix \f$R\f$ has the same meaning as the ones of
+   * ReferenceFrameSampler::sample_rotation_matrix(), i.e. the direction of
+   * the photon in the laboratory frame is euler_angle_transform::direction()
+   * of \f$A_{i-1} R\f$, which is always inside the acceptance.
+   * If no direction is accepted after max_tri proposals, the last proposal
+   * is returned.
+   * If \f$W\f$ vanishes in the whole acceptance, the weight is zero and the
+   * direction is the axis of the first cone.
+   *
+   * \param A_previous Cumulative rotation \f$A_{i-1}\f$ of the previous step
+   * (the identity matrix for the first step).
+   *
+   * \return std::pair which contains the weight \f$w\f$ and \f$R\f$.
+   */
+  pair<double, euler_angle_transform::RotationMatrix>
+  operator()(const euler_angle_transform::RotationMatrix &A_previous);
+
+  /**
+   * \brief Sample the reference frames of many cascades.
+   *
+   * \param n Number of cascades.
+   * \param A_previous Array of length n for the cumulative rotations of the
+   * previous step, or a null pointer for the identity matrix.
+   * \param R Array of length n for the sampled rotations.
+   * \param weights Array of length n for the weights.
+   */
+  void operator()(const size_t n,
+                  const euler_angle_transform::RotationMatrix *A_previous,
+                  euler_angle_transform::RotationMatrix *R, double *weights);
+
+  /**
+   * \brief Probability that the direction of the step is inside the
+   * acceptance, i.e. the weight \f$w\f$ for a given frame of the previous
+   * step.
+   *
+   * \param A_previous Cumulative rotation \f$A_{i-1}\f$ of the previous step.
+   */
+  double get_acceptance_probability(
+      const euler_angle_transform::RotationMatrix &A_previous);
+
+  /**
+   * \brief Reinitialize the random number engine.
+   *
+   * See ReferenceFrameSampler::reseed().
+   */
+  void reseed(seed_seq &seq);
+
+  /**
+   * \brief Number of cones.
+   */
+  size_t get_n_cones() const { return axes.size(); }
+
+protected:
+  /**
+   * \brief Calculate the axes of the cones in the frame of the previous step
+   * and the integrals of \f$W\f$ over the cones.
+   *
+   * \return Sum of the integrals.
+   */
+  double
+  integrate_cones(const euler_angle_transform::RotationMatrix &A_previous);
+
+  /**
+   * \brief Rotation matrix whose direction is a given unit vector.
+   */
+  static euler_angle_transform::RotationMatrix
+  rotation_matrix(const array<double, 3> &direction);
+
+  AngularCorrelation angular_correlation; /**< \f$W\f$ */
+  vector<array<double, 3>>
+      axes; /**< Axes of the cones in the laboratory frame. */
+  vector<double> cos_opening_angles; /**< \f$\cos \left( \alpha_c \right)\f$ */
+  vector<vector<double>>
+      attenuation; /**< Attenuation factors of the cones, see
+                      legendre_series::cone_integrals(). */
+  double total_integral; /**< \f$\int_{4 \pi} W \mathrm{d} \Omega\f$ */
+  double upper_limit;    /**< Upper limit of \f$W\f$. */
+  unsigned int max_tries; /**< Maximum number of proposals per cascade. */
+
+  vector<array<double, 3>>
+      local_axes; /**< Axes of the cones in the frame of the previous step. */
+  vector<double> integrals; /**< Integrals of \f$W\f$ over the cones. */
+
+  mt19937 random_engine; /**< Deterministic random number engine. */
+  uniform_real_distribution<double>
+      uniform_random; /**< Uniform distribution from which all random numbers
+                         are derived here. */
+};
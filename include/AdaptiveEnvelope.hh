@@ -0,0 +1,245 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * \brief Piecewise-constant envelope of an angular correlation for rejection
+ * sampling, which is refined automatically.
+ *
+ * The angular correlations in this library have the form (see W_dir_dir and
+ * W_pol_dir)
+ *
+ * \f[
+ *      W \left( \theta, \varphi \right) = A \left( x \right) + \cos \left(
+ * 2 \varphi \right) B \left( x \right), \f]
+ *
+ * with \f$x = \cos \left( \theta \right)\f$, a series \f$A\f$ of Legendre
+ * polynomials \f$P_{2i}\f$, and a series \f$B\f$ of associated Legendre
+ * polynomials \f$P_{2i+2}^{\left| 2 \right|}\f$ (see
+ * legendre_series::legendre() and legendre_series::associated_legendre_2()).
+ * For a sharply peaked distribution, like a cascade of high-spin E2
+ * transitions with a large coefficient of \f$P_4\f$, even the exact maximum
+ * \f$W_\mathrm{max}\f$ is a poor constant envelope, since most candidates
+ * with a uniform distribution on the sphere are proposed where \f$W \ll
+ * W_\mathrm{max}\f$.
+ *
+ * This class splits the coordinates \f$\left( x, \varphi \right)\f$, in
+ * which the surface element is uniform, into rectangular strata, and bounds
+ * \f$W\f$ on each of them.
+ * Since \f$W\f$ is even in \f$x\f$, and \f$\cos \left( 2 \varphi \right)\f$
+ * is symmetric with respect to \f$\varphi = 0\f$ and \f$\varphi = \pi / 2\f$,
+ * only the domain \f$x \in \left[ 0, 1 \right]\f$, \f$\varphi \in \left[ 0,
+ * \pi / 2 \right]\f$ is stratified, and the other seven copies are obtained
+ * by reflection.
+ * On a stratum \f$\left[ x_0, x_1 \right] \times \left[ \varphi_0,
+ * \varphi_1 \right]\f$, \f$W\f$ is a linear function of \f$c = \cos \left(
+ * 2 \varphi \right) \in \left[ \cos \left( 2 \varphi_1 \right), \cos \left(
+ * 2 \varphi_0 \right) \right]\f$, so its maximum is the maximum of one of the
+ * two polynomials \f$A + c B\f$ at the limits of the range of \f$c\f$.
+ * The polynomials are converted to a power series (see
+ * legendre_series::power_series()), mapped to \f$t \in \left[ 0, 1
+ * \right]\f$ with \f$x = x_0 + \left( x_1 - x_0 \right) t\f$, and converted
+ * to the Bernstein basis.
+ * The largest Bernstein coefficient is an upper bound of the polynomial on
+ * the interval, which converges to its maximum quadratically in the width of
+ * the interval (see, e.g., \cite Farouki2012).
+ * A margin for the rounding errors is added.
+ *
+ * The integral of \f$W\f$ over a stratum is known exactly from the power
+ * series.
+ * The construction starts with a single stratum and repeatedly refines the
+ * stratum with the largest difference between the integral of the envelope
+ * and the integral of \f$W\f$, i.e. the largest expected number of rejected
+ * candidates.
+ * It is bisected along \f$x\f$ or, for a pol-dir correlation, along
+ * \f$\varphi\f$, whichever reduces the integral of the envelope more.
+ * The refinement stops when the expected efficiency of the rejection
+ * sampling,
+ *
+ * \f[
+ *      \epsilon = \frac{\int W \mathrm{d}\Omega}{\int W_\mathrm{env}
+ * \mathrm{d}\Omega}, \f]
+ *
+ * reaches a target, or when the maximum number of strata is reached.
+ * The construction cost is reported by get_n_bound_evaluations() and
+ * get_construction_time().
+ *
+ * A candidate is proposed with propose() by selecting a stratum with a
+ * probability proportional to its integral of the envelope, and a uniformly
+ * distributed point on it.
+ * TypedSphereRejectionSampler uses the envelope as an alternative to the
+ * constant envelope \f$W_\mathrm{max}\f$ (see
+ * TypedSphereRejectionSampler::enable_envelope()).
+ */
+class AdaptiveEnvelope {
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param legendre_coefficients Coefficients of the series \f$A\f$ (see
+   * W_gamma_gamma::get_legendre_coefficients()).
+   * \param associated_legendre_coefficients Coefficients of the series
+   * \f$B\f$ (see W_gamma_gamma::get_associated_legendre_coefficients()).
+   * If empty, the distribution does not depend on \f$\varphi\f$, and only
+   * \f$x\f$ is stratified.
+   * \param target_efficiency Expected efficiency \f$\epsilon\f$ at which the
+   * refinement stops (default: 0.9).
+   * \param max_strata Maximum number of strata (default: 4096).
+   *
+   * \throw invalid_argument if there are no Legendre coefficients, if the
+   * integral of \f$W\f$ is not positive, if the target efficiency is not in
+   * \f$\left( 0, 1 \right)\f$, or if max_strata is zero.
+   */
+  AdaptiveEnvelope(const vector<double> &legendre_coefficients,
+                   const vector<double> &associated_legendre_coefficients = {},
+                   const double target_efficiency = 0.9,
+                   const size_t max_strata = 4096);
+
+  /**
+   * \brief Propose a candidate from the envelope.
+   *
+   * The first uniform random number selects the stratum by inverse transform
+   * sampling of the cumulative integrals of the envelope.
+   * Its position inside the interval of the selected stratum determines the
+   * sign and the absolute value of \f$x\f$.
+   * The second uniform random number determines the quadrant of
+   * \f$\varphi\f$ and the position inside the interval of the stratum.
+   *
+   * \param u_0 Uniform random number in \f$\left[ 0, 1 \right)\f$.
+   * \param u_1 Uniform random number in \f$\left[ 0, 1 \right)\f$.
+   * \param cos_theta \f$x = \cos \left( \theta \right)\f$ of the candidate.
+   * \param phi \f$\varphi \in \left[ 0, 2 \pi \right]\f$ of the candidate in
+   * radians.
+   * \param bound Value of the envelope at the candidate, which is an upper
+   * bound of \f$W\f$ there.
+   */
+  void propose(const double u_0, const double u_1, double &cos_theta,
+               double &phi, double &bound) const;
+
+  /**
+   * \brief Value of the envelope at a point.
+   *
+   * The stratum which contains the point is found by a linear search, so this
+   * function is intended for tests and diagnostics, not for sampling.
+   *
+   * \param cos_theta \f$x = \cos \left( \theta \right)\f$.
+   * \param phi \f$\varphi\f$ in radians.
+   *
+   * \return \f$W_\mathrm{env} \left( \theta, \varphi \right)\f$.
+   */
+  double operator()(const double cos_theta, const double phi) const;
+
+  /**
+   * \brief Expected efficiency \f$\epsilon\f$ of the rejection sampling with
+   * the envelope.
+   */
+  double get_efficiency() const { return integral / envelope_integral; }
+
+  /**
+   * \brief Integral of \f$W\f$ over the unit sphere, \f$4 \pi\f$ times the
+   * first Legendre coefficient.
+   */
+  double get_integral() const { return integral; }
+
+  /**
+   * \brief Integral of the envelope over the unit sphere.
+   */
+  double get_envelope_integral() const { return envelope_integral; }
+
+  /**
+   * \brief Number of strata.
+   */
+  size_t get_n_strata() const { return strata.size(); }
+
+  /**
+   * \brief Number of upper bounds of a polynomial on an interval that were
+   * calculated during the construction.
+   */
+  size_t get_n_bound_evaluations() const { return n_bound_evaluations; }
+
+  /**
+   * \brief Wall-clock time of the construction in seconds.
+   */
+  double get_construction_time() const { return construction_time; }
+
+  /**
+   * \brief Upper bound of a polynomial on an interval from its coefficients
+   * in the Bernstein basis.
+   *
+   * \param power_series Coefficients \f$a_k\f$ of \f$x^k\f$, ordered by
+   * increasing \f$k\f$.
+   * \param x_min Lower limit of the interval.
+   * \param x_max Upper limit of the interval.
+   *
+   * \return Largest Bernstein coefficient of the polynomial on the interval.
+   */
+  static double bernstein_bound(const vector<double> &power_series,
+                                const double x_min, const double x_max);
+
+protected:
+  /**
+   * \brief Rectangle in \f$\left( x, \varphi \right)\f$ with a constant
+   * envelope.
+   */
+  struct Stratum {
+    double x_min;    /**< Lower limit of \f$x\f$. */
+    double x_max;    /**< Upper limit of \f$x\f$. */
+    double phi_min;  /**< Lower limit of \f$\varphi\f$. */
+    double phi_max;  /**< Upper limit of \f$\varphi\f$. */
+    double bound;    /**< Upper bound of \f$W\f$ on the stratum. */
+    double integral; /**< Integral of \f$W\f$ over the stratum. */
+
+    /**
+     * \brief Integral of the envelope over the stratum.
+     */
+    double envelope_integral() const {
+      return bound * (x_max - x_min) * (phi_max - phi_min);
+    }
+  };
+
+  /**
+   * \brief Create a stratum and calculate its bound and integral.
+   */
+  Stratum make_stratum(const double x_min, const double x_max,
+                       const double phi_min, const double phi_max);
+
+  vector<double> a; /**< Power series of \f$A\f$. */
+  vector<double> b; /**< Power series of \f$B\f$, empty for a dir-dir
+                       correlation. */
+  double rounding_margin; /**< Margin for the rounding errors of the bounds. */
+
+  vector<Stratum> strata;       /**< Strata. */
+  vector<double> cumulative;    /**< Cumulative integrals of the envelope,
+                                   normalized to 1. */
+  double integral;              /**< \f$\int W \mathrm{d}\Omega\f$. */
+  double envelope_integral;     /**< \f$\int W_\mathrm{env}
+                                   \mathrm{d}\Omega\f$. */
+  size_t n_bound_evaluations = 0; /**< Number of calls of
+                                     bernstein_bound(). */
+  double construction_time;     /**< Wall-clock time of the construction. */
+};
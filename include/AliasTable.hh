@@ -0,0 +1,108 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <random>
+
+using std::uniform_real_distribution;
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * \brief Sample indices from a discrete probability distribution in constant
+ * time with the alias method.
+ *
+ * For \f$n\f$ weights \f$w_i\f$, Vose's algorithm \cite Vose1991 builds a
+ * table of \f$n\f$ columns of equal probability \f$1/n\f$ in
+ * \f$\mathcal{O} \left( n \right)\f$ time.
+ * Column \f$i\f$ contains the index \f$i\f$ with the probability \f$q_i\f$
+ * and an alias \f$a_i\f$ with the probability \f$1 - q_i\f$.
+ * An index is sampled with a single uniform random number \f$u \in
+ * \left[ 0, 1 \right)\f$: the integer part of \f$n u\f$ selects the column,
+ * and its fractional part is compared to \f$q_i\f$.
+ * Therefore, the cost of a draw does not depend on the number of weights or
+ * on their distribution.
+ */
+class AliasTable {
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param weights Weights \f$w_i\f$. They are normalized by their sum.
+   *
+   * \throw invalid_argument if there are no weights, if a weight is negative
+   * or not finite, or if all weights are zero.
+   */
+  explicit AliasTable(const vector<double> &weights);
+
+  /**
+   * \brief Sample an index with a uniform random number.
+   *
+   * \param u Uniform random number \f$u \in \left[ 0, 1 \right)\f$.
+   *
+   * \return Index \f$i\f$, which is sampled with the probability
+   * \f$w_i / \sum_j w_j\f$.
+   */
+  size_t operator()(const double u) const {
+    const double x = u * thresholds.size();
+    size_t column = static_cast<size_t>(x);
+    if (column >= thresholds.size()) {
+      column = thresholds.size() - 1;
+    }
+    return x - column < thresholds[column] ? column : aliases[column];
+  }
+
+  /**
+   * \brief Sample an index with a random number engine.
+   *
+   * \param random_engine Random number engine.
+   *
+   * \return Index \f$i\f$, see operator()(const double) const.
+   */
+  template <typename Engine> size_t operator()(Engine &random_engine) const {
+    return (*this)(uniform_real_distribution<double>()(random_engine));
+  }
+
+  /**
+   * \brief Number of weights.
+   */
+  size_t size() const { return probabilities.size(); }
+
+  /**
+   * \brief Normalized probability \f$w_i / \sum_j w_j\f$ of an index.
+   *
+   * \throw out_of_range if the index does not exist.
+   */
+  double get_probability(const size_t i) const {
+    return probabilities.at(i);
+  }
+
+protected:
+  vector<double> probabilities; /**< Normalized probabilities. */
+  vector<double> thresholds;    /**< Probabilities \f$q_i\f$ of keeping the
+                                   index of a column. */
+  vector<size_t> aliases;       /**< Aliases \f$a_i\f$ of the columns. */
+};
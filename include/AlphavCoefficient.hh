@@ -19,6 +19,17 @@
 
 #pragma once
 
+#include <array>
+
+using std::array;
+
+#include <atomic>
+
+using std::atomic;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+
 #include "FCoefficient.hh"
 #include "KappaCoefficient.hh"
 #include "StringRepresentable.hh"
@@ -45,6 +56,10 @@
  * + \delta_n^2 \kappa_\nu \left( L_n^\prime, L_n^\prime \right) F_\nu \left(
  * L_n^\prime, L_n^\prime, j_n, j \right). \f]
  *
+ * Like for AvCoefficient, the constructor only calculates the term with
+ * \f$L_n\f$, and the F and \f$\kappa_\nu\f$ coefficients with
+ * \f$L_n^\prime\f$ are calculated when they are needed for the first time.
+ *
  * See also the definition of the AvCoefficient class for more information.
  */
 
@@ -63,6 +78,59 @@ public:
   AlphavCoefficient(const int two_nu, const int two_L, const int two_Lp,
                     const int two_jn, const int two_j);
 
+  /**
+   * \brief Constructor for known F and \f$\kappa_\nu\f$ coefficients.
+   *
+   * No Wigner symbol is calculated, see get_f_values() and
+   * get_kappa_values().
+   *
+   * \param two_nu \f$2 \nu\f$
+   * \param two_L Primary multipolarity \f$2 L\f$
+   * \param two_Lp Secondary multipolarity \f$2 L^\prime\f$
+   * \param two_jn Angular momentum quantum number \f$2 j_n\f$ of the initial or
+   * final state of a transition
+   * \param two_j Angular momentum quantum number \f$2 j\f$ of the
+   * intermediate state of a transition
+   * \param f_values Values of the F coefficients for the multipolarities
+   * \f$\left( L, L \right)\f$, \f$\left( L, L^\prime \right)\f$, and
+   * \f$\left( L^\prime, L^\prime \right)\f$.
+   * \param kappa_values Values of the \f$\kappa_\nu\f$ coefficients in the
+   * same order.
+   */
+  AlphavCoefficient(const int two_nu, const int two_L, const int two_Lp,
+                    const int two_jn, const int two_j,
+                    const array<double, 3> &f_values,
+                    const array<double, 3> &kappa_values);
+
+  /**
+   * \brief Constructor for a known F coefficient with \f$L\f$ only.
+   *
+   * The F coefficients are the same as for the \f$A_\nu\f$ coefficient
+   * with the same arguments, i.e. the value can be taken from
+   * AvCoefficient::get_constant_f_value() if that one exists already.
+   *
+   * \param two_nu \f$2 \nu\f$
+   * \param two_L Primary multipolarity \f$2 L\f$
+   * \param two_Lp Secondary multipolarity \f$2 L^\prime\f$
+   * \param two_jn Angular momentum quantum number \f$2 j_n\f$ of the initial or
+   * final state of a transition
+   * \param two_j Angular momentum quantum number \f$2 j\f$ of the
+   * intermediate state of a transition
+   * \param constant_f_value Value of \f$F_\nu \left( L, L, j_n, j
+   * \right)\f$.
+   */
+  AlphavCoefficient(const int two_nu, const int two_L, const int two_Lp,
+                    const int two_jn, const int two_j,
+                    const double constant_f_value);
+
+  /**
+   * \brief Copy constructor
+   *
+   * Copies the terms with \f$L^\prime\f$ only if they were already
+   * calculated.
+   */
+  AlphavCoefficient(const AlphavCoefficient &alphav_coefficient);
+
   /**
    * \brief Return value of a specific \f$\alpha_\nu\f$ coefficient.
    *
@@ -72,22 +140,162 @@ public:
    */
   double operator()(const double delta) const;
 
-  string string_representation(const unsigned int n_digits = 0,
-                               const vector<string> variable_names = {}) const;
+  /**
+   * \brief Return the value of an \f$\alpha_\nu\f$ coefficient for a fixed
+   * multipole mixing ratio without constructing an object.
+   *
+   * Like AvCoefficient::evaluate(), only the terms that can contribute are
+   * calculated.
+   * In addition, a \f$\kappa_\nu\f$ coefficient is only calculated if
+   * the F coefficient that it multiplies is nonzero.
+   *
+   * \param two_nu \f$2 \nu\f$
+   * \param two_L Primary multipolarity \f$2 L\f$
+   * \param two_Lp Secondary multipolarity \f$2 L^\prime\f$
+   * \param two_jn Angular momentum quantum number \f$2 j_n\f$ of the initial or
+   * final state of a transition
+   * \param two_j Angular momentum quantum number \f$2 j\f$ of the
+   * intermediate state of a transition
+   * \param delta Multipole mixing ratio \f$\delta\f$
+   *
+   * \return \f$\alpha_\nu \left( L, L^\prime, j_n, j, \delta_n \right)\f$
+   */
+  static double evaluate(const int two_nu, const int two_L, const int two_Lp,
+                         const int two_jn, const int two_j,
+                         const double delta);
+
+  /**
+   * \brief Return the derivative of the coefficient with respect to the
+   * multipole mixing ratio.
+   *
+   * \param delta Multipole mixing ratio \f$\delta\f$
+   *
+   * \return \f$\mathrm{d} \alpha_\nu / \mathrm{d} \delta = c_1 + 2 c_2
+   * \delta\f$ (see get_constant_coefficient())
+   */
+  double derivative(const double delta) const {
+    return get_linear_coefficient() + 2. * delta * get_quadratic_coefficient();
+  }
+
+  /**
+   * \brief Return the \f$\delta\f$-independent term of the coefficient.
+   *
+   * Together with the linear and the quadratic term, this function provides the
+   * representation of the coefficient as a polynomial in \f$\delta\f$:
+   *
+   * \f[
+   *      \alpha_\nu \left( \delta \right) = c_0 + c_1 \delta + c_2 \delta^2.
+   * \f]
+   *
+   * \return \f$c_0\f$
+   */
+  double get_constant_coefficient() const { return constant_coefficient; }
+
+  /**
+   * \brief Return the term of the coefficient which is linear in \f$\delta\f$.
+   *
+   * \return \f$c_1\f$
+   */
+  double get_linear_coefficient() const {
+    require_mixed_terms();
+    return 2. * linear_kappa_value.load(memory_order_relaxed) *
+           linear_f_value.load(memory_order_relaxed);
+  }
+
+  /**
+   * \brief Return the term of the coefficient which is quadratic in
+   * \f$\delta\f$.
+   *
+   * \return \f$c_2\f$
+   */
+  double get_quadratic_coefficient() const {
+    require_mixed_terms();
+    return quadratic_kappa_value.load(memory_order_relaxed) *
+           quadratic_f_value.load(memory_order_relaxed);
+  }
+
+  /**
+   * \brief Return the values of the F coefficients, see
+   * AlphavCoefficient(const int, const int, const int, const int, const int,
+   * const array<double, 3> &, const array<double, 3> &).
+   */
+  array<double, 3> get_f_values() const {
+    require_mixed_terms();
+    return {constant_f_coefficient.get_value(),
+            linear_f_value.load(memory_order_relaxed),
+            quadratic_f_value.load(memory_order_relaxed)};
+  }
+
+  /**
+   * \brief Return the values of the \f$\kappa_\nu\f$ coefficients, see
+   * get_f_values().
+   */
+  array<double, 3> get_kappa_values() const {
+    require_mixed_terms();
+    return {constant_kappa_coefficient.get_value(),
+            linear_kappa_value.load(memory_order_relaxed),
+            quadratic_kappa_value.load(memory_order_relaxed)};
+  }
+
+  void write_string_representation(
+      string &str_rep, const unsigned int n_digits = 0,
+      const vector<string> &variable_names = {}) const override;
+
+  /**
+   * \brief Append string representation with a given name of the multipole
+   * mixing ratio.
+   *
+   * Equivalent to write_string_representation(string &, const unsigned int,
+   * const vector<string> &) const with a single variable name, without
+   * creating a vector.
+   *
+   * \param str_rep String to which the representation is appended.
+   * \param n_digits Number of digits, see
+   * StringRepresentable::string_representation().
+   * \param delta_variable Name of the multipole mixing ratio.
+   */
+  void write_string_representation(string &str_rep,
+                                   const unsigned int n_digits,
+                                   const string &delta_variable) const;
 
 protected:
+  /**
+   * \brief Make sure that the terms with \f$L^\prime\f$ are available.
+   */
+  void require_mixed_terms() const {
+    if (!mixed_terms_calculated.load(memory_order_acquire)) {
+      calculate_mixed_terms();
+    }
+  }
+
+  /**
+   * \brief Calculate the F and \f$\kappa_\nu\f$ coefficients with
+   * \f$L^\prime\f$.
+   *
+   * Threads that call this function at the same time calculate and store the
+   * same values.
+   */
+  void calculate_mixed_terms() const;
+
   const int two_nu;
   const int two_L;
   const int two_Lp;
   const int two_jn;
   const int two_j;
 
-  const FCoefficient constant_f_coefficient, linear_f_coefficient,
-      quadratic_f_coefficient;
-  const KappaCoefficient constant_kappa_coefficient, linear_kappa_coefficient,
-      quadratic_kappa_coefficient;
-
+  const FCoefficient constant_f_coefficient;
+  const KappaCoefficient constant_kappa_coefficient;
   double constant_coefficient;
-  double linear_coefficient;
-  double quadratic_coefficient;
+
+  mutable atomic<bool> mixed_terms_calculated; /**< Whether the values below
+                                                  are valid. */
+  mutable atomic<double> linear_f_value; /**< \f$F_\nu \left( L, L^\prime,
+                                            j_n, j \right)\f$ */
+  mutable atomic<double> quadratic_f_value; /**< \f$F_\nu \left( L^\prime,
+                                               L^\prime, j_n, j \right)\f$ */
+  mutable atomic<double> linear_kappa_value; /**< \f$\kappa_\nu \left( L,
+                                                L^\prime \right)\f$ */
+  mutable atomic<double> quadratic_kappa_value; /**< \f$\kappa_\nu \left(
+                                                   L^\prime, L^\prime
+                                                   \right)\f$ */
 };
@@ -21,6 +21,9 @@
 
 #include "AngularCorrelation.hh"
 #include "SphereRejectionSampler.hh"
+#include "TypedSphereRejectionSampler.hh"
+#include "W_dir_dir.hh"
+#include "W_pol_dir.hh"
 
 /**
  * \brief Sample directions in spherical coordinates from an angular
@@ -39,7 +42,10 @@ public:
    *
    * In contrast to the base class, the upper limit \f$W_\mathrm{max}\f$ does
    * not have to be provided explicitly. The member function
-   * AngularCorrelation::get_upper_limit() is called instead.
+   * AngularCorrelation::get_upper_limit() is called instead, or
+   * AngularCorrelation::get_maximum() if exact_maximum is true.
+   * The exact maximum is the tightest possible envelope, which maximizes the
+   * efficiency of the rejection sampling, but it takes longer to compute.
    *
    * \param w \f$W \left( \theta, \varphi \right)\f$, angular correlation
    * \param seed Random number seed.
@@ -47,7 +53,70 @@ public:
    * \f$\left( \theta_\mathrm{rand}, \varphi_\mathrm{rand} \right)\f$
    * before the algorithm terminates without success and returns \f$\left( 0, 0
    * \right)\f$.
+   * \param exact_maximum Use the exact maximum of \f$W\f$ instead of the
+   * upper limit (default: false).
    */
-  AngCorrRejectionSampler(AngularCorrelation &w, const int seed,
-                          const unsigned int max_tri = 1000);
-};
\ No newline at end of file
+  AngCorrRejectionSampler(const AngularCorrelation &w, const int seed,
+                          const unsigned int max_tri = 1000,
+                          const bool exact_maximum = false);
+
+  /**
+   * \brief Propose the candidates from an AdaptiveEnvelope of the angular
+   * correlation.
+   *
+   * For sharply peaked angular correlations, this is much more efficient than
+   * the constant envelope, even if it is the exact maximum (see
+   * TypedSphereRejectionSampler::enable_envelope()).
+   *
+   * \param target_efficiency See AdaptiveEnvelope::AdaptiveEnvelope().
+   * \param max_strata See AdaptiveEnvelope::AdaptiveEnvelope().
+   */
+  void enable_adaptive_envelope(const double target_efficiency = 0.9,
+                                const size_t max_strata = 4096);
+
+protected:
+  /**
+   * \brief Evaluate the angular correlation for a block of candidates with
+   * AngularCorrelation::evaluate_cos_theta().
+   */
+  void evaluate_block(const size_t n, const double *cos_theta,
+                      const double *phi, double *result) override;
+};
+
+/**
+ * \brief Rejection sampler for a dir-dir correlation whose type is known at
+ * compile time.
+ *
+ * In contrast to AngCorrRejectionSampler, the correlation is not called
+ * through std::function and AngularCorrelation (see
+ * TypedSphereRejectionSampler).
+ * The upper limit has to be passed to the constructor, for example
+ * W_dir_dir::get_upper_limit() or W_dir_dir::get_maximum().
+ */
+typedef TypedSphereRejectionSampler<W_dir_dir> DirDirRejectionSampler;
+
+/**
+ * \brief Rejection sampler for a pol-dir correlation whose type is known at
+ * compile time.
+ *
+ * See DirDirRejectionSampler.
+ */
+typedef TypedSphereRejectionSampler<W_pol_dir> PolDirRejectionSampler;
+
+/**
+ * \brief Rejection sampler for a dir-dir correlation which is evaluated in
+ * single precision.
+ *
+ * See DirDirRejectionSampler and TypedSphereRejectionSampler.
+ */
+typedef TypedSphereRejectionSampler<W_dir_dir, mt19937, float>
+    DirDirRejectionSamplerFloat;
+
+/**
+ * \brief Rejection sampler for a pol-dir correlation which is evaluated in
+ * single precision.
+ *
+ * See DirDirRejectionSamplerFloat.
+ */
+typedef TypedSphereRejectionSampler<W_pol_dir, mt19937, float>
+    PolDirRejectionSamplerFloat;
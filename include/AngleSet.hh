@@ -0,0 +1,216 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+
+/**
+ * \brief Precomputed (associated) Legendre polynomials for a fixed set of
+ * directions.
+ *
+ * Any angular correlation in this library is a series of Legendre
+ * polynomials and associated Legendre polynomials of the second order (see
+ * W_gamma_gamma::get_legendre_coefficients()):
+ *
+ * \f[
+ *      W \left( \theta_m, \varphi_m \right) = \sum_{i=0}^{\nu_\mathrm{max} /
+ * 2} c_i P_{2i} \left( \cos \theta_m \right) + \sum_{i=0}^{\nu_\mathrm{max} /
+ * 2 - 1} d_i \cos \left( 2 \varphi_m \right) P_{2i+2}^{\left| 2 \right|}
+ * \left( \cos \theta_m \right). \f]
+ *
+ * In an experiment, the directions \f$\left( \theta_m, \varphi_m \right)\f$
+ * are usually the same fixed set, for example the positions of the
+ * detectors.
+ * This class calculates the functions of the angles only once, up to a given
+ * order \f$\nu_\mathrm{max}\f$, and stores them as the rows of a basis
+ * matrix:
+ * the first \f$\nu_\mathrm{max} / 2 + 1\f$ rows contain \f$P_{2i} \left(
+ * \cos \theta_m \right)\f$, the remaining \f$\nu_\mathrm{max} / 2\f$ ones the
+ * products \f$\cos \left( 2 \varphi_m \right) P_{2i+2}^{\left| 2 \right|}
+ * \left( \cos \theta_m \right)\f$.
+ * The evaluation of an angular correlation is then a short sum over the rows
+ * for each direction, without any trigonometric function or recurrence.
+ *
+ * Each row is padded with zeros to a multiple of AngleSet::alignment values,
+ * and the storage is aligned to a cache line, so the rows start at
+ * addresses that are suitable for SIMD instructions.
+ * The length of a row is given by get_leading_dimension().
+ *
+ * The same set can be passed to HypothesisMatrixEvaluator to evaluate many
+ * hypotheses as a matrix product, and DetectorArray::angle_set() creates one
+ * for the coincidence matrix of an array of detectors.
+ */
+class AngleSet {
+public:
+  /**
+   * \brief Number of values of type double per cache line.
+   *
+   * The leading dimension of the basis is a multiple of this number.
+   */
+  static constexpr size_t alignment = 8;
+
+  /**
+   * \brief Constructor for directions in spherical coordinates.
+   *
+   * \param theta Polar angles in radians.
+   * \param phi Azimuthal angles in radians, same length as theta.
+   * \param nu_max Maximum order \f$\nu_\mathrm{max}\f$ of the Legendre
+   * expansions.
+   *
+   * \throw invalid_argument if theta is empty, if theta and phi have
+   * different lengths, or if nu_max is negative or odd.
+   */
+  AngleSet(const vector<double> &theta, const vector<double> &phi,
+           const int nu_max);
+
+  /**
+   * \brief Constructor for directions given by \f$\cos \theta\f$ and \f$\cos
+   * \left( 2 \varphi \right)\f$.
+   *
+   * An angular correlation depends on the direction only via these two
+   * quantities (see AngularCorrelation::evaluate(const array<double, 3> &)
+   * const), so no trigonometric function is evaluated.
+   *
+   * \param n Number of directions.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param cos_2phi Cosines of twice the azimuthal angles, array of length n.
+   * \param nu_max Maximum order \f$\nu_\mathrm{max}\f$ of the Legendre
+   * expansions.
+   *
+   * \throw invalid_argument if n is zero, or if nu_max is negative or odd.
+   */
+  AngleSet(const size_t n, const double *cos_theta, const double *cos_2phi,
+           const int nu_max);
+
+  /**
+   * \brief Evaluate an angular correlation for all directions.
+   *
+   * \param ang_cor Angular correlation.
+   * \param result Array of length get_n_directions() for the values.
+   *
+   * \throw invalid_argument if the order of the angular correlation is
+   * larger than nu_max.
+   */
+  void evaluate(const AngularCorrelation &ang_cor, double *result) const {
+    evaluate(ang_cor.get_legendre_coefficients(),
+             ang_cor.get_associated_legendre_coefficients(), result);
+  }
+
+  /**
+   * \brief Evaluate many angular correlations for all directions.
+   *
+   * \param ang_cors Angular correlations.
+   * \param result Array of length \f$n M\f$, where \f$n\f$ is the number of
+   * angular correlations and \f$M\f$ the number of directions. The values of
+   * the \f$k\f$-th angular correlation start at the index \f$k M\f$.
+   *
+   * \throw invalid_argument if the order of an angular correlation is
+   * larger than nu_max.
+   */
+  void evaluate(const vector<AngularCorrelation> &ang_cors,
+                double *result) const;
+
+  /**
+   * \brief Evaluate a series with given coefficients for all directions.
+   *
+   * \param legendre_coefficients Coefficients \f$c_i\f$, at most
+   * \f$\nu_\mathrm{max} / 2 + 1\f$.
+   * \param associated_legendre_coefficients Coefficients \f$d_i\f$, at most
+   * \f$\nu_\mathrm{max} / 2\f$. May be empty.
+   * \param result Array of length get_n_directions() for the values.
+   *
+   * \throw invalid_argument if there are more coefficients than rows of the
+   * basis.
+   */
+  void evaluate(const vector<double> &legendre_coefficients,
+                const vector<double> &associated_legendre_coefficients,
+                double *result) const;
+
+  /**
+   * \brief Number of directions \f$M\f$.
+   */
+  size_t get_n_directions() const { return n_directions; }
+
+  /**
+   * \brief Maximum order \f$\nu_\mathrm{max}\f$ of the Legendre expansions.
+   */
+  int get_nu_max() const { return nu_max; }
+
+  /**
+   * \brief Number of values per row of the basis, i.e. the number of
+   * directions rounded up to a multiple of AngleSet::alignment.
+   */
+  size_t get_leading_dimension() const { return leading_dimension; }
+
+  /**
+   * \brief Number of rows of the basis, \f$\nu_\mathrm{max} + 1\f$.
+   */
+  size_t get_n_rows() const { return 2 * n_legendre - 1; }
+
+  /**
+   * \brief Basis matrix in row-major order.
+   *
+   * The row \f$r\f$ (see the description of the class) starts at the index
+   * \f$r\f$ times get_leading_dimension(). The padding at the end of a row
+   * contains zeros.
+   */
+  const double *get_basis() const {
+    return reinterpret_cast<const double *>(basis.data());
+  }
+
+protected:
+  /**
+   * \brief Cache line of the basis.
+   */
+  struct alignas(alignment * sizeof(double)) CacheLine {
+    double values[alignment];
+  };
+
+  /**
+   * \brief Check the arguments and allocate the basis.
+   *
+   * \throw invalid_argument, see AngleSet().
+   */
+  void allocate();
+
+  /**
+   * \brief Calculate the rows of the basis.
+   */
+  void calculate_basis(const double *cos_theta, const double *cos_2phi);
+
+  double *get_row(const size_t i) {
+    return reinterpret_cast<double *>(basis.data()) + i * leading_dimension;
+  }
+
+  const size_t n_directions; /**< \f$M\f$ */
+  const int nu_max;          /**< \f$\nu_\mathrm{max}\f$ */
+  const size_t n_legendre; /**< Number of Legendre polynomials in the basis,
+                              \f$\nu_\mathrm{max} / 2 + 1\f$. */
+  const size_t leading_dimension; /**< See get_leading_dimension(). */
+  vector<CacheLine> basis; /**< Basis matrix, see get_basis(). */
+};
@@ -21,18 +21,60 @@
 
 #include <array>
 #include <memory>
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "BatchArena.hh"
 #include "State.hh"
 #include "Transition.hh"
 #include "W_gamma_gamma.hh"
+#include "W_gamma_gamma_fixed.hh"
 
 using std::array;
+using std::optional;
 using std::pair;
+using std::shared_ptr;
+using std::string;
 using std::unique_ptr;
 using std::vector;
 
+/**
+ * \brief Result of the validation of a cascade.
+ *
+ * See AngularCorrelation::validate().
+ * The values are also returned by the C interface, therefore they are fixed.
+ */
+enum CascadeStatus : int {
+  cascade_valid = 0,                  ///< The cascade is valid.
+  cascade_too_short = 1,              ///< Less than two cascade steps.
+  cascade_invalid_quantum_number = 2, ///< Invalid spin, parity, EM character,
+                                      ///< or multipolarity.
+  cascade_mixed_spins = 3,          ///< Mixed integer and half-integer spins.
+  cascade_spin_0_to_0 = 4,          ///< Transition between two spin-0 states.
+  cascade_triangle_inequality = 5,  ///< No multipolarity fulfils the
+                                    ///< triangle inequality.
+  cascade_invalid_em_character = 6, ///< Parity selection rule violated.
+  cascade_incomplete_em_character = 7, ///< Only one EM character defined.
+  cascade_missing_parity = 8, ///< EM character defined, but parities missing.
+};
+
+/**
+ * \brief Sign convention of the analyzing power.
+ *
+ * See AngularCorrelation::analyzing_power().
+ * The values are the signs of the analyzing power in the respective
+ * convention, and they are also used by the C interface.
+ */
+enum AnalyzingPowerConvention : int {
+  natural_convention = 1, ///< \f$A \propto W \left( \theta, \varphi \right) -
+                          ///< W \left( \theta^\prime, \varphi^\prime
+                          ///< \right)\f$
+  kpz_convention = -1,    ///< Convention of Kneissl, Pitz, and Zilges,
+                          ///< opposite sign.
+};
+
 /**
  * \brief Class for a gamma-gamma correlation.
  *
@@ -184,6 +226,9 @@ public:
    * others must also be specified for the given transition and the states which
    * it links. Note that this also applies to so-called 'pure' transitions where
    * only a single multipolarity is allowed.
+   *
+   * The same checks are available without exceptions via validate() and
+   * try_create().
    */
   AngularCorrelation(const State ini_sta,
                      const vector<pair<Transition, State>> cas_ste);
@@ -220,16 +265,37 @@ public:
    * be observed.
    *
    * \throw invalid_argument if the number of cascade steps is smaller or equal
-   * to one, because two transitions are needed for a gamma-gamma correlation.
+   * to one, because two transitions are needed for a gamma-gamma correlation,
+   * if integer and half-integer spins are mixed, or if two neighboring states
+   * have spin 0.
    */
   AngularCorrelation(const State ini_sta, const vector<State> cas_sta);
 
   /**
-   * Copy constructor
+   * \brief Copy constructor
+   *
+   * The W_gamma_gamma object, which contains all expansion coefficients, is
+   * immutable after construction.
+   * Therefore, copies share it instead of recalculating the coefficients.
+   */
+  AngularCorrelation(const AngularCorrelation &ang_cor) = default;
+
+  /**
+   * \brief Move constructor
+   *
+   * The moved-from object may only be assigned to or destroyed.
+   */
+  AngularCorrelation(AngularCorrelation &&ang_cor) = default;
+
+  /**
+   * \brief Copy assignment, see the copy constructor.
    */
-  AngularCorrelation(const AngularCorrelation &ang_cor)
-      : AngularCorrelation(ang_cor.get_initial_state(),
-                           ang_cor.get_cascade_steps()){};
+  AngularCorrelation &operator=(const AngularCorrelation &ang_cor) = default;
+
+  /**
+   * \brief Move assignment, see the move constructor.
+   */
+  AngularCorrelation &operator=(AngularCorrelation &&ang_cor) = default;
 
   /**
    * \brief Return the angular correlation for given spherical coordinates.
@@ -238,6 +304,10 @@ public:
    * is in the positive z direction. If the correlation is a pol-dir
    * correlation, the function assumes that the polarization axis is the x axis.
    *
+   * If the largest even order is at most fixed_order_nu_max_limit, the
+   * correlation is evaluated by a W_dir_dir_fixed or W_pol_dir_fixed object
+   * without a call of a virtual function.
+   *
    * \param theta Polar angle in spherical coordinates in radians
    * (\f$\theta \in \left[ 0, \pi \right]\f$).
    * \param phi Azimuthal angle in spherical coordinates in radians
@@ -247,6 +317,458 @@ public:
    */
   double operator()(const double theta, const double phi) const;
 
+  /**
+   * \brief Return the angular correlation for given spherical coordinates and
+   * multipole mixing ratios.
+   *
+   * Evaluates the angular correlation with the given mixing ratios instead of
+   * the ones of the cascade steps of this object. Since only the polynomial
+   * dependence on the mixing ratios is evaluated, this is much faster than
+   * constructing a new AngularCorrelation object. The same conventions for the
+   * angles as in AngularCorrelation::operator()(const double, const double)
+   * const apply.
+   *
+   * \param theta Polar angle in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$).
+   * \param phi Azimuthal angle in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$).
+   * \param deltas Multipole mixing ratios \f$\delta_i\f$, one for each
+   * cascade step.
+   *
+   * \return \f$W_{\gamma \gamma} \left( \theta, \varphi, \delta_1, ...,
+   * \delta_{n-1} \right)\f$
+   *
+   * \throw invalid_argument if the number of mixing ratios is not equal to the
+   * number of cascade steps.
+   */
+  double operator()(const double theta, const double phi,
+                    const vector<double> &deltas) const;
+
+  /**
+   * \brief Evaluate the angular correlation for many sets of multipole mixing
+   * ratios and many directions at once.
+   *
+   * This is the vectorized version of operator()(const double, const double,
+   * const vector<double> &) const for a scan of the mixing ratios, for example
+   * to plot an analyzing power as a function of \f$\delta\f$.
+   * The polynomials in the mixing ratios are evaluated once per set of mixing
+   * ratios, and the (associated) Legendre polynomials are evaluated for all
+   * directions in a batch.
+   *
+   * \param n_deltas Number of sets of mixing ratios.
+   * \param deltas Mixing ratios, array of length n_deltas times the number of
+   * cascade steps. The set \f$k\f$ starts at the index \f$k\f$ times the
+   * number of cascade steps.
+   * \param n_angles Number of directions.
+   * \param theta Polar angles in spherical coordinates in radians, array of
+   * length n_angles.
+   * \param phi Azimuthal angles in spherical coordinates in radians, array of
+   * length n_angles.
+   * \param result Array of length n_deltas times n_angles. The values for the
+   * set \f$k\f$ of mixing ratios start at the index \f$k\f$ times n_angles.
+   */
+  void scan_deltas(const size_t n_deltas, const double *deltas,
+                   const size_t n_angles, const double *theta,
+                   const double *phi, double *result) const;
+
+  /**
+   * \brief Evaluate the analyzing power for many pairs of directions.
+   *
+   * The analyzing power relates the angular correlation in two directions
+   * \f$\left( \theta, \varphi \right)\f$ and \f$\left( \theta^\prime,
+   * \varphi^\prime \right)\f$:
+   *
+   * \f[
+   *      A = s P Q \frac{W \left( \theta, \varphi \right) - W \left(
+   * \theta^\prime, \varphi^\prime \right)}{W \left( \theta, \varphi \right)
+   * + W \left( \theta^\prime, \varphi^\prime \right)}. \f]
+   *
+   * The sign \f$s\f$ is given by the convention, which is +1 in the
+   * 'natural' convention and -1 in the convention of Kneissl, Pitz, and
+   * Zilges (KPZ).
+   * The product \f$P Q\f$ of the polarization of the photon beam and the
+   * polarization sensitivity of the polarimeter turns the analyzing power
+   * into the expected asymmetry of a measurement.
+   * Usually, \f$\theta = \theta^\prime\f$, \f$\varphi = 0\f$, and
+   * \f$\varphi^\prime = \pi / 2\f$.
+   *
+   * \param n_angles Number of pairs of directions.
+   * \param theta Polar angles \f$\theta\f$ in radians, array of length
+   * n_angles.
+   * \param thetap Polar angles \f$\theta^\prime\f$ in radians, array of
+   * length n_angles.
+   * \param phi Azimuthal angles \f$\varphi\f$ in radians, array of length
+   * n_angles.
+   * \param phip Azimuthal angles \f$\varphi^\prime\f$ in radians, array of
+   * length n_angles.
+   * \param PQ Product \f$P Q\f$, \f$\left| P Q \right| \leq 1\f$.
+   * \param convention Sign convention.
+   * \param result Array of length n_angles for the values of \f$A\f$.
+   *
+   * \throw invalid_argument if \f$\left| P Q \right| > 1\f$.
+   */
+  void analyzing_power(const size_t n_angles, const double *theta,
+                       const double *thetap, const double *phi,
+                       const double *phip, const double PQ,
+                       const AnalyzingPowerConvention convention,
+                       double *result) const;
+
+  /**
+   * \brief Evaluate the analyzing power for many sets of multipole mixing
+   * ratios and many pairs of directions at once.
+   *
+   * Combination of analyzing_power() and scan_deltas(): both directions of
+   * all pairs are evaluated with a single call of scan_deltas(), so the
+   * polynomials in the mixing ratios are evaluated only once per set of
+   * mixing ratios, for example for all points of a plot of the analyzing
+   * power as a function of \f$\delta\f$.
+   *
+   * \param n_deltas Number of sets of mixing ratios.
+   * \param deltas Mixing ratios, see scan_deltas().
+   * \param n_angles Number of pairs of directions.
+   * \param theta Polar angles \f$\theta\f$ in radians, array of length
+   * n_angles.
+   * \param thetap Polar angles \f$\theta^\prime\f$ in radians, array of
+   * length n_angles.
+   * \param phi Azimuthal angles \f$\varphi\f$ in radians, array of length
+   * n_angles.
+   * \param phip Azimuthal angles \f$\varphi^\prime\f$ in radians, array of
+   * length n_angles.
+   * \param PQ Product \f$P Q\f$, \f$\left| P Q \right| \leq 1\f$.
+   * \param convention Sign convention.
+   * \param result Array of length n_deltas times n_angles. The values for the
+   * set \f$k\f$ of mixing ratios start at the index \f$k\f$ times n_angles.
+   *
+   * \throw invalid_argument if \f$\left| P Q \right| > 1\f$.
+   */
+  void scan_analyzing_power(const size_t n_deltas, const double *deltas,
+                            const size_t n_angles, const double *theta,
+                            const double *thetap, const double *phi,
+                            const double *phip, const double PQ,
+                            const AnalyzingPowerConvention convention,
+                            double *result) const;
+
+  /**
+   * \brief Evaluate the angular correlation and its gradient with respect to
+   * the angles and the multipole mixing ratios.
+   *
+   * The derivatives are calculated analytically from the polynomial
+   * dependence of the expansion coefficients on the mixing ratios and from
+   * the derivatives of the (associated) Legendre polynomials, which is
+   * faster and more accurate than finite differences, for example for a
+   * gradient-based fit of mixing ratios and detector positions.
+   *
+   * \param theta Polar angle in spherical coordinates in radians.
+   * \param phi Azimuthal angle in spherical coordinates in radians.
+   * \param deltas Multipole mixing ratios \f$\delta_j\f$, one for each
+   * cascade step.
+   *
+   * \return \f$W_{\gamma \gamma}\f$, \f$\partial W_{\gamma \gamma} /
+   * \partial \theta\f$, \f$\partial W_{\gamma \gamma} / \partial
+   * \varphi\f$, and \f$\partial W_{\gamma \gamma} / \partial \delta_j\f$
+   * for all cascade steps, in this order.
+   *
+   * \throw invalid_argument if the number of mixing ratios is not equal to the
+   * number of cascade steps.
+   */
+  vector<double> evaluate_with_gradient(const double theta, const double phi,
+                                        const vector<double> &deltas) const;
+
+  /**
+   * \brief Evaluate the angular correlation and its gradient for many
+   * directions at once.
+   *
+   * See W_gamma_gamma::evaluate_with_gradient().
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in spherical coordinates in radians, array of
+   * length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians, array of
+   * length n.
+   * \param deltas Multipole mixing ratios \f$\delta_j\f$, one for each
+   * cascade step.
+   * \param result Array of length n for the values of the angular
+   * correlation.
+   * \param gradient Array of length n times (number of cascade steps + 2)
+   * for the derivatives with respect to \f$\theta\f$, \f$\varphi\f$, and
+   * the mixing ratios. The row for the direction \f$k\f$ starts at the
+   * index \f$k\f$ times the row length.
+   *
+   * \throw invalid_argument if the number of mixing ratios is not equal to the
+   * number of cascade steps.
+   */
+  void evaluate_with_gradient(const size_t n, const double *theta,
+                              const double *phi, const vector<double> &deltas,
+                              double *result, double *gradient) const {
+    w_gamma_gamma->evaluate_with_gradient(n, theta, phi, deltas, result,
+                                          gradient);
+  }
+
+  /**
+   * \brief Evaluate the angular correlation for many directions at once.
+   *
+   * Equivalent to calling AngularCorrelation::operator()(const double, const
+   * double) const for each pair of angles, but the internal angular
+   * correlation object is called only once, and the (associated) Legendre
+   * polynomials for a whole batch of directions are calculated by a single
+   * recurrence (see W_gamma_gamma::evaluate()). This is the most efficient way
+   * to evaluate an angular correlation for a large number of directions.
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$), array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$), array of length n.
+   * \param result Array of length n for the values \f$W_{\gamma \gamma}
+   * \left( \theta_i, \varphi_i \right)\f$.
+   */
+  void evaluate(const size_t n, const double *theta, const double *phi,
+                double *result) const {
+    w_gamma_gamma->evaluate(n, theta, phi, result);
+  }
+
+  /**
+   * \brief Evaluate the angular correlation for many directions at once,
+   * given the cosines of the polar angles.
+   *
+   * See W_gamma_gamma::evaluate_cos_theta().
+   *
+   * \param n Number of directions.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$), array of length n.
+   * \param result Array of length n for the values \f$W_{\gamma \gamma}
+   * \left( \theta_i, \varphi_i \right)\f$.
+   */
+  void evaluate_cos_theta(const size_t n, const double *cos_theta,
+                          const double *phi, double *result) const {
+    w_gamma_gamma->evaluate_cos_theta(n, cos_theta, phi, result);
+  }
+
+  /**
+   * \brief Evaluate the angular correlation with attenuated expansion
+   * coefficients for many directions at once.
+   *
+   * See W_gamma_gamma::evaluate_attenuated_cos_theta().
+   *
+   * \param n Number of directions.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$), array of length n.
+   * \param attenuation Factors for the terms of order \f$2i\f$, array of
+   * length \f$\nu_\mathrm{max} / 2 + 1\f$.
+   * \param result Array of length n for the results.
+   */
+  void evaluate_attenuated_cos_theta(const size_t n, const double *cos_theta,
+                                     const double *phi,
+                                     const double *attenuation,
+                                     double *result) const {
+    w_gamma_gamma->evaluate_attenuated_cos_theta(n, cos_theta, phi,
+                                                 attenuation, result);
+  }
+
+  /**
+   * \brief Evaluate the rotated angular correlation for many directions at
+   * once.
+   *
+   * The direction of propagation and the polarization axis of the first photon
+   * are rotated by the three Euler angles \f$\Phi\f$, \f$\Theta\f$, and
+   * \f$\Psi\f$ in the 'zxz' convention (see euler_angle_transform). The
+   * angles \f$\theta\f$ and \f$\varphi\f$ are still defined in the original
+   * coordinate system, i.e. the function returns
+   *
+   * \f[
+   *      W_{\gamma \gamma} \left[ A^{-1} \left( \Phi, \Theta, \Psi \right)
+   * \vec{r} \left( \theta, \varphi \right) \right], \f]
+   *
+   * where \f$\vec{r}\f$ is the unit vector in the direction \f$\theta\f$,
+   * \f$\varphi\f$, and \f$A\f$ the rotation matrix.
+   *
+   * The rotation matrix is calculated only once per call, and the directions
+   * are transformed and evaluated in blocks without any memory allocation.
+   * For many directions in the same rotated frame, RotatedAngularCorrelation
+   * rotates the expansion of the angular correlation instead of every single
+   * direction.
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$), array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$), array of length n.
+   * \param Phi_Theta_Psi Euler angles \f$\Phi\f$, \f$\Theta\f$, and
+   * \f$\Psi\f$ in radians.
+   * \param result Array of length n for the values of the rotated angular
+   * correlation.
+   */
+  void evaluate(const size_t n, const double *theta, const double *phi,
+                const array<double, 3> Phi_Theta_Psi, double *result) const;
+
+  /**
+   * \brief Evaluate the angular correlation on a grid of polar and azimuthal
+   * angles.
+   *
+   * The angular correlation is a sum of a function of \f$\theta\f$ and the
+   * product of another function of \f$\theta\f$ and \f$\cos \left( 2
+   * \varphi \right)\f$:
+   *
+   * \f[
+   *      W_{\gamma \gamma} \left( \theta_i, \varphi_j \right) = A \left(
+   * \theta_i \right) + B \left( \theta_i \right) \cos \left( 2 \varphi_j
+   * \right). \f]
+   *
+   * On a grid of \f$N_\theta \times N_\varphi\f$ directions, the Legendre
+   * series \f$A\f$ and \f$B\f$ are evaluated only once per polar angle, and
+   * \f$\cos \left( 2 \varphi \right)\f$ only once per azimuthal angle.
+   * The grid is filled by a rank-2 update, i.e. with a single
+   * multiplication and addition per direction.
+   *
+   * \param n_theta Number of polar angles \f$N_\theta\f$.
+   * \param theta Polar angles in radians, array of length n_theta.
+   * \param n_phi Number of azimuthal angles \f$N_\varphi\f$.
+   * \param phi Azimuthal angles in radians, array of length n_phi.
+   * \param result Array of length \f$N_\theta N_\varphi\f$ for the values
+   * \f$W_{\gamma \gamma} \left( \theta_i, \varphi_j \right)\f$ at the index
+   * \f$i N_\varphi + j\f$.
+   */
+  void evaluate_grid(const size_t n_theta, const double *theta,
+                     const size_t n_phi, const double *phi,
+                     double *result) const;
+
+  /**
+   * \brief Evaluate the rotated angular correlation on a grid of polar and
+   * azimuthal angles.
+   *
+   * Same as evaluate(const size_t, const double *, const double *, const
+   * array<double, 3>, double *) const on the grid of evaluate_grid(const
+   * size_t, const double *, const size_t, const double *, double *) const.
+   * The rotated expansion is evaluated by
+   * RotatedAngularCorrelation::evaluate_grid().
+   *
+   * \param n_theta Number of polar angles \f$N_\theta\f$.
+   * \param theta Polar angles in radians, array of length n_theta.
+   * \param n_phi Number of azimuthal angles \f$N_\varphi\f$.
+   * \param phi Azimuthal angles in radians, array of length n_phi.
+   * \param Phi_Theta_Psi Euler angles \f$\Phi\f$, \f$\Theta\f$, and
+   * \f$\Psi\f$ in radians.
+   * \param result Array of length \f$N_\theta N_\varphi\f$ for the values at
+   * the index \f$i N_\varphi + j\f$.
+   */
+  void evaluate_grid(const size_t n_theta, const double *theta,
+                     const size_t n_phi, const double *phi,
+                     const array<double, 3> Phi_Theta_Psi,
+                     double *result) const;
+
+  /**
+   * \brief Return the angular correlation for a given direction.
+   *
+   * Same as operator()(const double, const double) const, but the direction
+   * is given as a unit vector \f$\vec{r} = \left( x, y, z \right)\f$ in
+   * Cartesian coordinates.
+   * The angular correlation depends on the direction only via
+   *
+   * \f[
+   *      \cos \left( \theta \right) = z, ~~ \cos \left( 2 \varphi \right) =
+   * \frac{x^2 - y^2}{x^2 + y^2},
+   * \f]
+   *
+   * which are evaluated without any trigonometric functions (see
+   * W_gamma_gamma::evaluate_cos_theta_cos_2phi()).
+   * For \f$x = y = 0\f$, \f$\varphi = 0\f$ is assumed, which is irrelevant
+   * because the polarization-dependent part vanishes along the z axis.
+   *
+   * \param direction Unit vector \f$\vec{r}\f$. It is not normalized by this
+   * function.
+   *
+   * \return \f$W_{\gamma \gamma} \left( \vec{r} \right)\f$
+   */
+  double evaluate(const array<double, 3> &direction) const;
+
+  /**
+   * \brief Evaluate the angular correlation for many directions at once,
+   * given as unit vectors.
+   *
+   * See evaluate(const array<double, 3> &) const.
+   *
+   * \param n Number of directions.
+   * \param xyz Cartesian coordinates \f$x_0, y_0, z_0, x_1, y_1, ...\f$ of the
+   * unit vectors, array of length \f$3n\f$.
+   * \param result Array of length n for the values \f$W_{\gamma \gamma}
+   * \left( \vec{r}_i \right)\f$.
+   */
+  void evaluate(const size_t n, const double *xyz, double *result) const;
+
+  /**
+   * \brief Evaluate the rotated angular correlation for many directions at
+   * once, given as unit vectors.
+   *
+   * See evaluate(const size_t, const double *, const double *, const
+   * array<double, 3>, double *) const and evaluate(const size_t, const double
+   * *, double *) const.
+   * The unit vectors are rotated by the inverse of the rotation matrix, and
+   * the result is evaluated without converting them to spherical coordinates.
+   *
+   * \param n Number of directions.
+   * \param xyz Cartesian coordinates \f$x_0, y_0, z_0, x_1, y_1, ...\f$ of the
+   * unit vectors, array of length \f$3n\f$.
+   * \param Phi_Theta_Psi Euler angles \f$\Phi\f$, \f$\Theta\f$, and
+   * \f$\Psi\f$ in radians.
+   * \param result Array of length n for the values of the rotated angular
+   * correlation.
+   */
+  void evaluate(const size_t n, const double *xyz,
+                const array<double, 3> Phi_Theta_Psi, double *result) const;
+
+  /**
+   * \brief Integral of the angular correlation over a cone.
+   *
+   * \f[
+   *      \int_{\Omega_\alpha \left( \theta, \varphi \right)} W_{\gamma
+   * \gamma} \left( \Omega \right) \mathrm{d} \Omega = \sum_\nu J_\nu
+   * \left( \alpha \right) W_\nu \left( \theta, \varphi \right), \f]
+   *
+   * where \f$\Omega_\alpha \left( \theta, \varphi \right)\f$ is a cone
+   * with the opening angle (half angle) \f$\alpha\f$ around the direction
+   * \f$\theta\f$, \f$\varphi\f$, and \f$W_\nu\f$ is the term of order
+   * \f$\nu\f$ in the expansion of \f$W_{\gamma \gamma}\f$ in (associated)
+   * Legendre polynomials.
+   * The integrals \f$J_\nu\f$ are given by legendre_series::cone_integrals().
+   * The result is exact up to rounding errors, and its cost is comparable to
+   * a single evaluation of the angular correlation.
+   * Dividing it by the solid angle \f$J_0\f$ gives the mean value of
+   * \f$W_{\gamma \gamma}\f$ inside the cone, for example the expected
+   * relative coincidence rate of a circular detector which is uniformly
+   * efficient (see also SpotlightSampler, which uses the same definition of
+   * the opening angle).
+   *
+   * \param theta_phi Polar and azimuthal angle of the axis of the cone in
+   * radians.
+   * \param opening_angle Opening angle \f$\alpha \in \left[ 0, \pi
+   * \right]\f$ in radians.
+   *
+   * \return Integral of \f$W_{\gamma \gamma}\f$ over the cone.
+   */
+  double integrate_cone(const array<double, 2> theta_phi,
+                        const double opening_angle) const;
+
+  /**
+   * \brief Integral of the angular correlation over many cones.
+   *
+   * Same as integrate_cone(const array<double, 2>, const double) const for n
+   * cones at once.
+   * Consecutive cones with the same opening angle share the integrals
+   * \f$J_\nu\f$ and are evaluated in a single batch.
+   *
+   * \param n Number of cones.
+   * \param theta Polar angles of the axes of the cones in radians, array of
+   * length n.
+   * \param phi Azimuthal angles of the axes of the cones in radians, array of
+   * length n.
+   * \param opening_angle Opening angles in radians, array of length n.
+   * \param result Array of length n for the integrals.
+   */
+  void integrate_cone(const size_t n, const double *theta, const double *phi,
+                      const double *opening_angle, double *result) const;
+
   /**
    * \brief Return the initial state of the angular correlation.
    *
@@ -263,6 +785,87 @@ public:
     return w_gamma_gamma->get_cascade_steps();
   }
 
+  /**
+   * \brief Change the multipole mixing ratio of a single cascade step.
+   *
+   * The result is the same as for a new AngularCorrelation object with the
+   * changed mixing ratio, but only the factors of the expansion that depend on
+   * this mixing ratio are recalculated, see W_gamma_gamma::set_delta().
+   * If the W_gamma_gamma object is shared with other copies of this object,
+   * or if it was obtained with get_w_gamma_gamma(), it is copied before the
+   * change, so that the other owners are not affected.
+   *
+   * \param step Index of the cascade step, starting at 0.
+   * \param delta New multipole mixing ratio \f$\delta\f$.
+   *
+   * \throw out_of_range if step is not smaller than the number of cascade
+   * steps.
+   */
+  void set_delta(const size_t step, const double delta);
+
+  /**
+   * \brief Set the degree of linear polarization of the first photon of a
+   * pol-dir correlation.
+   *
+   * The polarization-dependent part of the correlation is multiplied by
+   * \f$P\f$, see W_pol_dir::set_polarization_degree(). The W_gamma_gamma
+   * object is copied before the change if it is shared, like in set_delta().
+   *
+   * \param P Degree of polarization \f$P \in \left[ -1, 1 \right]\f$.
+   *
+   * \throw invalid_argument if the correlation is not a pol-dir correlation,
+   * or if \f$\left| P \right| > 1\f$.
+   */
+  void set_polarization_degree(const double P);
+
+  /**
+   * \brief Return the degree of linear polarization of the first photon.
+   *
+   * \return Degree of polarization of a pol-dir correlation, or 0 for a
+   * dir-dir correlation.
+   */
+  double get_polarization_degree() const;
+
+  /**
+   * \brief Write the state of the angular correlation to a byte string.
+   *
+   * The byte string contains the cascade, the degree of polarization, and
+   * the values of all F, \f$\kappa_\nu\f$, and \f$U_\nu\f$ coefficients,
+   * i.e. the results of all calculations of Wigner symbols.
+   * Restoring it with deserialize() is much faster than the construction of
+   * a new object, for example in the worker processes of a parallel
+   * analysis.
+   *
+   * The values are stored in the byte order of the machine, after a header
+   * with a magic string, the format version serialization_version, and a
+   * byte-order mark, like the files of CoefficientTable.
+   *
+   * \return Byte string.
+   */
+  vector<char> serialize() const;
+
+  /**
+   * \brief Restore an angular correlation from the output of serialize().
+   *
+   * No Wigner symbol is calculated.
+   *
+   * \param data Start of the byte string.
+   * \param size Size of the byte string in bytes.
+   *
+   * \return Angular correlation with the same cascade, coefficients, and
+   * degree of polarization as the serialized one.
+   *
+   * \throw invalid_argument if the data are truncated, if they were written
+   * with a different format version or byte order, or if they do not
+   * describe a valid cascade.
+   */
+  static AngularCorrelation deserialize(const char *data, const size_t size);
+
+  /**
+   * \brief Version of the format written by serialize().
+   */
+  static constexpr unsigned int serialization_version = 1;
+
   /**
    * \brief Return an upper limit for possible values of the gamma-gamma angular
    * correlation.
@@ -291,23 +894,304 @@ public:
    */
   double get_upper_limit() const { return w_gamma_gamma->get_upper_limit(); }
 
+  /**
+   * \brief Return the W_gamma_gamma object that contains the expansion
+   * coefficients.
+   *
+   * Copies of an AngularCorrelation share the same object until
+   * set_delta() is called.
+   */
+  shared_ptr<const W_gamma_gamma> get_w_gamma_gamma() const {
+    return w_gamma_gamma;
+  }
+
+  /**
+   * \brief Return the maximum order \f$\nu_\mathrm{max}\f$ of the Legendre
+   * expansion.
+   *
+   * See W_gamma_gamma::get_nu_max().
+   */
+  int get_nu_max() const { return w_gamma_gamma->get_nu_max(); }
+
+  /**
+   * \brief Return the normalized coefficients of the series of Legendre
+   * polynomials.
+   *
+   * See W_gamma_gamma::get_legendre_coefficients().
+   */
+  vector<double> get_legendre_coefficients() const {
+    return w_gamma_gamma->get_legendre_coefficients();
+  }
+
+  /**
+   * \brief Return the normalized coefficients of the series of associated
+   * Legendre polynomials.
+   *
+   * See W_gamma_gamma::get_associated_legendre_coefficients().
+   */
+  vector<double> get_associated_legendre_coefficients() const {
+    return w_gamma_gamma->get_associated_legendre_coefficients();
+  }
+
+  /**
+   * \brief Global maximum of the absolute value of the angular correlation.
+   *
+   * This method calls the equivalent method of the W_gamma_gamma member object.
+   *
+   * \return \f$\mathrm{max}_{\theta \in \left[ 0, \pi \right], \varphi \in
+   * \left[ 0, 2\pi \right]} | W \left( \theta, \varphi \right) | \f$
+   */
+  double get_maximum() const { return w_gamma_gamma->get_maximum(); }
+
+  /**
+   * \brief Checks the parity selection rule for a single transition.
+   *
+   * The transition of interest is assumed to have the label \f$i\f$.
+   *
+   * \param p0 \f$p_i\f$Parity of initial state
+   * \param p1 \f$p_{i+1}\f$Parity of final state
+   * \param two_L \f$2L_i\f$, two times the multipolarity of the transition.
+   * \param em \f$\lambda_i\f$ EM character of the transition with multipolarity
+   * \f$L\f$.
+   *
+   * \return true, if the parity selection rule is fulfilled, false otherwise.
+   */
+  static bool valid_em_character(const Parity p0, const Parity p1,
+                                 const int two_L, const EMCharacter em);
+
+  /**
+   * \brief Infer the most likely transition that connects two given states.
+   *
+   * This method is used in connection with the simplified constructor of the
+   * AngularCorrelation class. Given two states of a cascade, it infers the most
+   * likely transition that connects them. See the corresponding constructor for
+   * more information.
+   *
+   * \param states Two states for which the most likely transition should be
+   * inferred.
+   *
+   * \return Transition object.
+   *
+   * \throw invalid_argument, if both states have spin 0. In this case, no EM
+   * transition is possible.
+   */
+  static Transition infer_transition(const pair<State, State> states);
+
+  /**
+   * \brief Check the consistency of a cascade without throwing an exception.
+   *
+   * Performs the same checks as the constructor (see check_cascade()), but
+   * reports the first failed check by its return value.
+   * Since most candidates in a scan of many hypotheses are usually invalid,
+   * the error message is only formatted if it is requested.
+   *
+   * \param ini_sta Initial state of the cascade.
+   * \param cas_ste Cascade steps, given as a list of arbitrary length which
+   * contains Transition-State pairs.
+   * \param message If not a null pointer, the string is replaced by the
+   * error message of the first failed check.
+   * It is not modified for a valid cascade.
+   *
+   * \return cascade_valid, or the reason why the cascade is invalid.
+   */
+  static CascadeStatus validate(const State ini_sta,
+                                const vector<pair<Transition, State>> &cas_ste,
+                                string *message = nullptr);
+
+  /**
+   * \brief Check the consistency of a cascade of states without throwing an
+   * exception.
+   *
+   * Version of validate() for the constructor with transition inference.
+   * The inferred transitions fulfil the triangle inequality and the parity
+   * selection rules by construction, therefore only the number of cascade
+   * steps, the spins, and transitions between two spin-0 states are checked.
+   *
+   * \param ini_sta Initial state of the cascade.
+   * \param cas_sta Cascade states.
+   * \param message If not a null pointer, the string is replaced by the
+   * error message of the first failed check.
+   *
+   * \return cascade_valid, or the reason why the cascade is invalid.
+   */
+  static CascadeStatus validate(const State ini_sta,
+                                const vector<State> &cas_sta,
+                                string *message = nullptr);
+
+  /**
+   * \brief Construct an angular correlation if the cascade is valid.
+   *
+   * Exception-free alternative to the constructor.
+   *
+   * \param ini_sta Initial state of the cascade.
+   * \param cas_ste Cascade steps.
+   * \param ang_cor Set to the new angular correlation if the cascade is
+   * valid, set to a null pointer otherwise.
+   * \param message See validate().
+   *
+   * \return Result of validate().
+   */
+  static CascadeStatus
+  try_create(const State ini_sta,
+             const vector<pair<Transition, State>> &cas_ste,
+             unique_ptr<AngularCorrelation> &ang_cor,
+             string *message = nullptr);
+
+  /**
+   * \brief Construct an angular correlation with transition inference if the
+   * cascade is valid.
+   *
+   * See try_create() and the constructor with transition inference.
+   *
+   * \param ini_sta Initial state of the cascade.
+   * \param cas_sta Cascade states.
+   * \param ang_cor Set to the new angular correlation if the cascade is
+   * valid, set to a null pointer otherwise.
+   * \param message See validate().
+   *
+   * \return Result of validate().
+   */
+  static CascadeStatus try_create(const State ini_sta,
+                                  const vector<State> &cas_sta,
+                                  unique_ptr<AngularCorrelation> &ang_cor,
+                                  string *message = nullptr);
+
+  /**
+   * \brief Construct an angular correlation in place if the cascade is valid,
+   * and take the memory of its coefficients from a BatchArena.
+   *
+   * This version of try_create() is used to create many angular correlations
+   * at once.
+   * The W_dir_dir and W_pol_dir objects are placed in the slot of the
+   * allocator.
+   * A slot of batch_arena_slot_size bytes is enough for a single angular
+   * correlation.
+   *
+   * \param ini_sta Initial state of the cascade.
+   * \param cas_ste Cascade steps.
+   * \param ang_cor Set to the new angular correlation if the cascade is
+   * valid, reset otherwise.
+   * \param allocator Allocator for a slot of a BatchArena.
+   * \param message See validate().
+   *
+   * \return Result of validate().
+   */
+  static CascadeStatus
+  try_create(const State ini_sta,
+             const vector<pair<Transition, State>> &cas_ste,
+             optional<AngularCorrelation> &ang_cor,
+             const BatchArena::Allocator<char> &allocator,
+             string *message = nullptr);
+
+  /**
+   * \brief Construct an angular correlation with transition inference in
+   * place if the cascade is valid, and take the memory of its coefficients
+   * from a BatchArena.
+   *
+   * See try_create() and the constructor with transition inference.
+   *
+   * \param ini_sta Initial state of the cascade.
+   * \param cas_sta Cascade states.
+   * \param ang_cor Set to the new angular correlation if the cascade is
+   * valid, reset otherwise.
+   * \param allocator Allocator for a slot of a BatchArena.
+   * \param message See validate().
+   *
+   * \return Result of validate().
+   */
+  static CascadeStatus try_create(const State ini_sta,
+                                  const vector<State> &cas_sta,
+                                  optional<AngularCorrelation> &ang_cor,
+                                  const BatchArena::Allocator<char> &allocator,
+                                  string *message = nullptr);
+
+  /**
+   * \brief Size of a slot of a BatchArena for the coefficients of a single
+   * angular correlation in bytes.
+   *
+   * See try_create(const State, const vector<pair<Transition, State>> &,
+   * optional<AngularCorrelation> &, const BatchArena::Allocator<char> &,
+   * string *).
+   */
+  static const size_t batch_arena_slot_size;
+
 protected:
+  /**
+   * \brief Constructor for try_create(), which sets w_gamma_gamma after the
+   * validation.
+   */
+  AngularCorrelation() : w_gamma_gamma(nullptr) {}
+
+  /**
+   * \brief Set w_gamma_gamma and the matching w_gamma_gamma_fixed.
+   *
+   * \param w Angular correlation.
+   */
+  void set_w_gamma_gamma(shared_ptr<const W_gamma_gamma> w);
+
+  /**
+   * \brief Create the W_dir_dir or W_pol_dir object for a validated cascade.
+   *
+   * \param ini_sta Initial state of the cascade.
+   * \param cas_ste Cascade steps.
+   *
+   * \return W_pol_dir object if the first EM character is known, W_dir_dir
+   * object otherwise.
+   */
+  static shared_ptr<const W_gamma_gamma>
+  create_w_gamma_gamma(const State ini_sta,
+                       const vector<pair<Transition, State>> &cas_ste);
+
+  /**
+   * \brief Create the W_dir_dir or W_pol_dir object for a validated cascade
+   * in the memory of an allocator.
+   *
+   * A W_pol_dir object and its dir-dir part are both allocated with the
+   * allocator.
+   *
+   * \param ini_sta Initial state of the cascade.
+   * \param cas_ste Cascade steps.
+   * \param allocator Allocator.
+   *
+   * \return W_pol_dir object if the first EM character is known, W_dir_dir
+   * object otherwise.
+   */
+  static shared_ptr<const W_gamma_gamma>
+  create_w_gamma_gamma(const State ini_sta,
+                       const vector<pair<Transition, State>> &cas_ste,
+                       const BatchArena::Allocator<char> &allocator);
+
+  /**
+   * \brief Infer the most likely transitions for a cascade of states.
+   *
+   * See infer_transition().
+   *
+   * \param ini_sta Initial state of the cascade.
+   * \param cas_sta Cascade states.
+   *
+   * \return Cascade steps.
+   */
+  static vector<pair<Transition, State>>
+  infer_transitions(const State ini_sta, const vector<State> &cas_sta);
+
   /**
    * \brief Check consistency of the input.
    *
    * Checks whether the cascade has more than one step.
    * After that, calls the functions
-   * AngularCorrelation::check_triangle_inequalities() and
-   * AngularCorrelation::check_em_transitions().
+   * AngularCorrelation::check_angular_momenta(),
+   * AngularCorrelation::check_triangle_inequalities(), and
+   * AngularCorrelation::check_em_transitions() via validate().
    *
    * \param ini_sta Initial state of the cascade.
    * \param cas_ste Cascade steps, given as a list of arbitrary length which
    * contains Transition-State pairs.
    *
-   * \throw invalid_argument if the cascade has less than two steps.
+   * \throw invalid_argument with the message of validate() if any check
+   * fails.
    */
-  void check_cascade(const State ini_sta,
-                     const vector<pair<Transition, State>> cas_ste) const;
+  static void check_cascade(const State ini_sta,
+                            const vector<pair<Transition, State>> &cas_ste);
 
   /**
    * \brief Check whether angular momenta are either all half integer or all
@@ -323,12 +1207,15 @@ protected:
    * \param cas_ste Cascade steps, given as a list of arbitrary length which
    * contains Transition-State pairs.
    *
-   * \throw invalid_argument if a mixed use of half-integer and integer angular
-   * momentum quantum numbers is detected.
+   * \param message If not a null pointer, set to the error message.
+   *
+   * \return cascade_mixed_spins if a mixed use of half-integer and integer
+   * angular momentum quantum numbers is detected, cascade_valid otherwise.
    */
-  void
+  static CascadeStatus
   check_angular_momenta(const State ini_sta,
-                        const vector<pair<Transition, State>> cas_ste) const;
+                        const vector<pair<Transition, State>> &cas_ste,
+                        string *message);
   /**
    * \brief Check triangle inequality for all cascade steps.
    *
@@ -350,11 +1237,16 @@ protected:
    * \param cas_ste Cascade steps, given as a list of arbitrary length which
    * contains Transition-State pairs.
    *
-   * \throw invalid_argument if none of the two multipolarities fulfils the
-   * triangle inequality for any cascade step.
+   * \param message If not a null pointer, set to the error message.
+   *
+   * \return cascade_triangle_inequality if none of the two multipolarities
+   * fulfils the triangle inequality for any cascade step, cascade_valid
+   * otherwise.
    */
-  void check_triangle_inequalities(
-      const State ini_sta, const vector<pair<Transition, State>> cas_ste) const;
+  static CascadeStatus
+  check_triangle_inequalities(const State ini_sta,
+                              const vector<pair<Transition, State>> &cas_ste,
+                              string *message);
 
   /**
    * \brief Check parity selections rules for all cascade steps.
@@ -382,56 +1274,33 @@ protected:
    * \param cas_ste Cascade steps, given as a list of arbitrary length which
    * contains Transition-State pairs.
    *
-   * \throw invalid_argument if at least one of the following conditions is not
-   * fulfilled for any cascade step:
+   * \param message If not a null pointer, set to the error message.
+   *
+   * \return cascade_incomplete_em_character, cascade_missing_parity, or
+   * cascade_invalid_em_character if at least one of the following conditions
+   * is not fulfilled for any cascade step, cascade_valid otherwise:
    * 1. Either all information about parities and EM characters for a cascade
    * step is given, or none.
    * 2. The parity selection rules apply for both multipolarities of the
    * transition.
    */
-  void
+  static CascadeStatus
   check_em_transitions(const State ini_sta,
-                       const vector<pair<Transition, State>> cas_ste) const;
-
-  /**
-   * \brief Checks the parity selection rule for a single transition.
-   *
-   * The transition of interest is assumed to have the label \f$i\f$.
-   *
-   * \param p0 \f$p_i\f$Parity of initial state
-   * \param p1 \f$p_{i+1}\f$Parity of final state
-   * \param two_L \f$2L_i\f$, two times the multipolarity of the transition.
-   * \param em \f$\lambda_i\f$ EM character of the transition with multipolarity
-   * \f$L\f$.
-   *
-   * \return true, if the parity selection rule is fulfilled, false otherwise.
-   */
-  bool valid_em_character(const Parity p0, const Parity p1, const int two_L,
-                          const EMCharacter em) const;
-
-  /**
-   * \brief Infer the most likely transition that connects two given states.
-   *
-   * This method is used in connection with the simplified constructor of the
-   * AngularCorrelation class. Given two states of a cascade, it infers the most
-   * likely transition that connects them. See the corresponding constructor for
-   * more information.
-   *
-   * \param states Two states for which the most likely transition should be
-   * inferred.
-   *
-   * \return Transition object.
-   *
-   * \throw invalid_argument, if both states have spin 0. In this case, no EM
-   * transition is possible.
-   */
-  Transition infer_transition(const pair<State, State> states) const;
+                       const vector<pair<Transition, State>> &cas_ste,
+                       string *message);
 
   /**
    * \brief Pointer to an object of the W_gamma_gamma class.
    *
    * W_gamma_gamma is the base class of the W_dir_dir and W_pol_dir classes.
    * The user input decides which one is stored by this pointer.
+   * The object is shared by all copies of an AngularCorrelation.
+   */
+  shared_ptr<const W_gamma_gamma> w_gamma_gamma;
+
+  /**
+   * \brief Fixed-order copy of the coefficients of w_gamma_gamma for a fast
+   * evaluation, or std::monostate if \f$\nu_\mathrm{max}\f$ is too large.
    */
-  unique_ptr<W_gamma_gamma> w_gamma_gamma;
+  W_gamma_gamma_fixed w_gamma_gamma_fixed;
 };
\ No newline at end of file
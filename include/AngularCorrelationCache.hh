@@ -0,0 +1,226 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstdint>
+
+using std::uint64_t;
+
+#include <list>
+
+using std::list;
+
+#include <memory>
+
+using std::shared_ptr;
+
+#include <mutex>
+
+using std::mutex;
+
+#include <unordered_map>
+
+using std::unordered_map;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "State.hh"
+#include "Transition.hh"
+
+/**
+ * \brief Least-recently-used cache of constructed angular correlations.
+ *
+ * The construction of an AngularCorrelation object calculates all expansion
+ * coefficients of the Legendre series, which is much more expensive than an
+ * evaluation.
+ * Applications that receive the same few cascades over and over again can
+ * use this class to construct each of them only once.
+ * Unlike the process-wide WignerSymbolCache, a cache of angular correlations
+ * is an object that has to be created explicitly.
+ *
+ * The key of an entry is the canonical representation of the cascade, i.e.
+ * the spins and parities of all states, and the EM characters and
+ * multipolarities of all transitions.
+ * By default, the multipole mixing ratios are compared by the bits of their
+ * floating-point representation (with \f$-0 = +0\f$), i.e. two cascades
+ * share an entry only if all mixing ratios are identical.
+ * If a resolution \f$\Delta \delta > 0\f$ is given, the mixing ratios are
+ * rounded to the nearest multiple of \f$\Delta \delta\f$ for the comparison,
+ * and the cached object is the one that was constructed with the mixing
+ * ratios of the first request.
+ *
+ * The cached objects are returned as shared pointers to constant objects.
+ * The const member functions of AngularCorrelation do not modify the object,
+ * therefore the same object may be evaluated in several threads at once.
+ * A pointer stays valid after its entry has been evicted.
+ *
+ * Access to the cache is protected by a mutex.
+ * The angular correlation of a missing entry is constructed without holding
+ * the lock, which means that two threads that request the same new cascade at
+ * the same time may both construct it.
+ */
+class AngularCorrelationCache {
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param capacity Maximum number of cached angular correlations.
+   * A capacity of zero disables caching.
+   * \param delta_resolution Resolution \f$\Delta \delta\f$ for the comparison
+   * of multipole mixing ratios. A value of zero (default) requires identical
+   * mixing ratios.
+   *
+   * \throw invalid_argument if delta_resolution is negative.
+   */
+  AngularCorrelationCache(const size_t capacity = 1024,
+                          const double delta_resolution = 0.);
+
+  /**
+   * \brief Return the angular correlation for a cascade.
+   *
+   * \param ini_sta Initial state of the cascade.
+   * \param cas_ste Cascade steps (see AngularCorrelation).
+   *
+   * \return Cached angular correlation, or a new object if the cascade was not
+   * requested before or if its entry was evicted.
+   *
+   * \throw invalid_argument if the cascade is invalid (see
+   * AngularCorrelation::AngularCorrelation()). Invalid cascades are not
+   * cached.
+   */
+  shared_ptr<const AngularCorrelation>
+  get(const State ini_sta, const vector<pair<Transition, State>> &cas_ste);
+
+  /**
+   * \brief Number of requests that could be answered from the cache.
+   */
+  size_t get_hits() const;
+
+  /**
+   * \brief Number of requests that required the construction of an angular
+   * correlation.
+   */
+  size_t get_misses() const;
+
+  /**
+   * \brief Fraction of requests that could be answered from the cache.
+   *
+   * \return \f$n_\mathrm{hits} / \left( n_\mathrm{hits} + n_\mathrm{misses}
+   * \right)\f$, or zero if there were no requests.
+   */
+  double get_hit_rate() const;
+
+  /**
+   * \brief Number of evicted entries.
+   */
+  size_t get_evictions() const;
+
+  /**
+   * \brief Number of cached angular correlations.
+   */
+  size_t size() const;
+
+  /**
+   * \brief Maximum number of cached angular correlations.
+   */
+  size_t get_capacity() const;
+
+  /**
+   * \brief Set the maximum number of cached angular correlations.
+   *
+   * If the new capacity is smaller than the current number of entries, the
+   * least recently used entries are evicted.
+   *
+   * \param capacity Maximum number of cached angular correlations.
+   */
+  void set_capacity(const size_t capacity);
+
+  /**
+   * \brief Resolution \f$\Delta \delta\f$ for the comparison of multipole
+   * mixing ratios.
+   */
+  double get_delta_resolution() const { return delta_resolution; }
+
+  /**
+   * \brief Remove all entries and reset the statistics.
+   */
+  void clear();
+
+protected:
+  /**
+   * \brief Canonical representation of a cascade.
+   *
+   * For each state, the spin and the parity, and for each transition, the EM
+   * characters, multipolarities, and the key of the mixing ratio (see
+   * delta_key()).
+   */
+  typedef vector<uint64_t> Key;
+
+  /**
+   * \brief Hash function for Key.
+   */
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+
+  /**
+   * \brief Entry of the list of cached objects, ordered from the most
+   * recently to the least recently used one.
+   */
+  typedef list<pair<Key, shared_ptr<const AngularCorrelation>>> EntryList;
+
+  /**
+   * \brief Create the key of a cascade.
+   */
+  Key create_key(const State ini_sta,
+                 const vector<pair<Transition, State>> &cas_ste) const;
+
+  /**
+   * \brief Key of a multipole mixing ratio.
+   *
+   * \return Bits of the floating-point representation of \f$\delta\f$, or of
+   * the nearest integer multiple of \f$\Delta \delta\f$ if a resolution was
+   * given.
+   */
+  uint64_t delta_key(const double delta) const;
+
+  /**
+   * \brief Evict least recently used entries until the size does not exceed
+   * the capacity. The caller must hold the lock.
+   */
+  void shrink();
+
+  mutable mutex cache_mutex; /**< Protects all members below. */
+  EntryList entries; /**< Cached objects, most recently used first. */
+  /** Position of each key in the list of entries. */
+  unordered_map<Key, EntryList::iterator, KeyHash> index;
+  size_t capacity;               /**< Maximum number of entries. */
+  size_t hits;                   /**< Requests answered from the cache. */
+  size_t misses;                 /**< Constructed objects. */
+  size_t evictions;              /**< Evicted entries. */
+  const double delta_resolution; /**< \f$\Delta \delta\f$ */
+};
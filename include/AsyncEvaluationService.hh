@@ -0,0 +1,237 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <atomic>
+
+using std::atomic;
+
+#include <chrono>
+
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+
+#include <condition_variable>
+
+using std::condition_variable;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <deque>
+
+using std::deque;
+
+#include <future>
+
+using std::future;
+using std::promise;
+
+#include <memory>
+
+using std::make_shared;
+using std::shared_ptr;
+
+#include <mutex>
+
+using std::mutex;
+
+#include <thread>
+
+using std::thread;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelationCache.hh"
+#include "State.hh"
+#include "Transition.hh"
+
+/**
+ * \brief Asynchronous evaluation of angular correlations for many concurrent
+ * clients.
+ *
+ * A service that receives many small requests (one cascade and a few
+ * directions each) from concurrent clients would spend most of its time on
+ * the construction of angular correlations and on the overhead of single
+ * evaluations, if each request was processed separately.
+ * This class accepts requests with submit(), which returns immediately with a
+ * future for the result, and processes them in a set of worker threads.
+ *
+ * A worker that finds a pending request waits until either the oldest
+ * pending request has waited for the maximum batching delay, or until enough
+ * requests for a full batch are pending.
+ * Then, it takes up to get_max_batch_size() requests out of the queue and
+ * processes them as one batch:
+ *
+ * 1. The angular correlation of each request is obtained from an
+ *    AngularCorrelationCache, which returns the same object for identical
+ *    cascades.
+ * 2. The directions of all requests with the same angular correlation are
+ *    concatenated and evaluated with a single call of
+ *    AngularCorrelation::evaluate().
+ * 3. The results are split up again and handed to the futures.
+ *
+ * The maximum batching delay bounds the additional latency of a request when
+ * the load is low, while the batch size grows with the load, which amortizes
+ * the construction and the overhead of the evaluation over more directions.
+ * Invalid requests do not affect the other requests of a batch: the
+ * exception of the construction of the angular correlation (see
+ * AngularCorrelation::AngularCorrelation()) is stored in the future of the
+ * invalid request.
+ *
+ * The destructor processes all pending requests before it stops the
+ * workers.
+ * All member functions may be called from several threads at the same time.
+ */
+class AsyncEvaluationService {
+public:
+  /**
+   * \brief Constructor, starts the worker threads.
+   *
+   * \param n_workers Number of worker threads. If zero, the number of
+   * concurrent threads supported by the hardware is used.
+   * \param max_batch_delay Maximum time that a worker waits for more requests
+   * after the oldest pending request has arrived (default: 200
+   * microseconds). A delay of zero disables waiting, i.e. a batch contains
+   * only the requests that arrived while the workers were busy.
+   * \param max_batch_size Maximum number of requests per batch (default:
+   * 256).
+   * \param cache Cache of angular correlations, which may be shared with
+   * other objects. By default, a new cache with the default capacity is
+   * created.
+   *
+   * \throw invalid_argument if max_batch_size is zero or cache is a null
+   * pointer.
+   */
+  AsyncEvaluationService(
+      const unsigned int n_workers = 1,
+      const microseconds max_batch_delay = microseconds(200),
+      const size_t max_batch_size = 256,
+      shared_ptr<AngularCorrelationCache> cache =
+          make_shared<AngularCorrelationCache>());
+
+  /**
+   * \brief Destructor, processes all pending requests and stops the
+   * workers.
+   */
+  ~AsyncEvaluationService();
+
+  AsyncEvaluationService(const AsyncEvaluationService &) = delete;
+  AsyncEvaluationService &operator=(const AsyncEvaluationService &) = delete;
+
+  /**
+   * \brief Submit a request.
+   *
+   * \param ini_sta Initial state of the cascade.
+   * \param cas_ste Cascade steps (see AngularCorrelation).
+   * \param theta Polar angles in radians.
+   * \param phi Azimuthal angles in radians, same length as theta.
+   *
+   * \return Future for the values \f$W \left( \theta, \varphi \right)\f$. If
+   * the cascade is invalid, the future stores the exception of
+   * AngularCorrelation::AngularCorrelation().
+   *
+   * \throw invalid_argument if theta and phi have different lengths.
+   */
+  future<vector<double>>
+  submit(const State ini_sta, const vector<pair<Transition, State>> &cas_ste,
+         vector<double> theta, vector<double> phi);
+
+  /**
+   * \brief Number of worker threads.
+   */
+  size_t get_n_workers() const { return workers.size(); }
+
+  /**
+   * \brief Maximum batching delay.
+   */
+  microseconds get_max_batch_delay() const { return max_batch_delay; }
+
+  /**
+   * \brief Maximum number of requests per batch.
+   */
+  size_t get_max_batch_size() const { return max_batch_size; }
+
+  /**
+   * \brief Cache of angular correlations.
+   */
+  shared_ptr<AngularCorrelationCache> get_cache() const { return cache; }
+
+  /**
+   * \brief Number of processed requests.
+   */
+  size_t get_n_requests() const { return n_requests; }
+
+  /**
+   * \brief Number of processed batches.
+   */
+  size_t get_n_batches() const { return n_batches; }
+
+  /**
+   * \brief Number of calls of AngularCorrelation::evaluate(), i.e. the
+   * number of distinct angular correlations summed over all batches.
+   */
+  size_t get_n_evaluations() const { return n_evaluations; }
+
+protected:
+  /**
+   * \brief Pending request.
+   */
+  struct Request {
+    State initial_state;
+    vector<pair<Transition, State>> cascade_steps;
+    vector<double> theta;
+    vector<double> phi;
+    promise<vector<double>> result;
+    steady_clock::time_point arrival; /**< Time of the submission. */
+  };
+
+  /**
+   * \brief Main loop of a worker thread.
+   */
+  void work();
+
+  /**
+   * \brief Evaluate a batch of requests and fulfill their promises.
+   */
+  void process(vector<Request> &batch);
+
+  const microseconds max_batch_delay;
+  const size_t max_batch_size;
+  const shared_ptr<AngularCorrelationCache> cache;
+
+  mutex queue_mutex; /**< Protects pending and stopping. */
+  condition_variable request_available;
+  deque<Request> pending; /**< Pending requests, oldest first. */
+  bool stopping = false;  /**< Set by the destructor. */
+
+  atomic<size_t> n_requests{0};
+  atomic<size_t> n_batches{0};
+  atomic<size_t> n_evaluations{0};
+
+  vector<thread> workers;
+};
@@ -0,0 +1,188 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+
+/**
+ * \brief Angular correlation with attenuation coefficients for finite
+ * detectors.
+ *
+ * For detectors with a finite solid angle, the measured angular correlation
+ * is [see, e.g., \cite Rose1953]
+ *
+ * \f[
+ *      W_{\gamma \gamma}^Q \left( \theta, \varphi \right) = \sum_\nu Q_\nu
+ * W_\nu \left( \theta, \varphi \right), \f]
+ *
+ * where \f$W_\nu\f$ is the term of order \f$\nu\f$ in the expansion of
+ * \f$W_{\gamma \gamma}\f$ in (associated) Legendre polynomials, and
+ * \f$Q_\nu\f$ is an attenuation coefficient.
+ * For two detectors with the coefficients \f$Q_\nu^{(1)}\f$ and
+ * \f$Q_\nu^{(2)}\f$, \f$Q_\nu = Q_\nu^{(1)} Q_\nu^{(2)}\f$.
+ * The coefficients can be calculated for a given geometry (for example with
+ * cone_attenuation_coefficients()), or they can be measured.
+ *
+ * This class is a view of an AngularCorrelation object, i.e. it stores a
+ * reference to the angular correlation and its own copy of the attenuation
+ * coefficients.
+ * The expansion coefficients of the angular correlation are scaled during the
+ * evaluation, so no coefficient of the angular correlation is recalculated,
+ * and the same AngularCorrelation object can be used for any number of
+ * detector geometries.
+ * The AngularCorrelation object must outlive all its views.
+ *
+ * The attenuation coefficients are given for the even orders \f$\nu = 2i\f$
+ * of the expansion, where the element \f$i\f$ of the vector contains
+ * \f$Q_{2i}\f$.
+ * Elements beyond \f$i = \nu_\mathrm{max} / 2\f$ are ignored.
+ */
+class AttenuatedAngularCorrelation {
+
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param ang_cor Angular correlation \f$W_{\gamma \gamma}\f$.
+   * \param attenuation Attenuation coefficients \f$Q_{2i}\f$,
+   * \f$0 \leq i \leq \nu_\mathrm{max} / 2\f$.
+   *
+   * \throw invalid_argument if there are less than \f$\nu_\mathrm{max} / 2 +
+   * 1\f$ coefficients.
+   */
+  AttenuatedAngularCorrelation(const AngularCorrelation &ang_cor,
+                               const vector<double> &attenuation);
+
+  /**
+   * \brief Constructor for a pair of detectors
+   *
+   * The attenuation coefficients are the products of the coefficients of the
+   * two detectors.
+   *
+   * \param ang_cor Angular correlation \f$W_{\gamma \gamma}\f$.
+   * \param attenuation_1 Attenuation coefficients \f$Q_{2i}^{(1)}\f$ of the
+   * first detector.
+   * \param attenuation_2 Attenuation coefficients \f$Q_{2i}^{(2)}\f$ of the
+   * second detector.
+   *
+   * \throw invalid_argument if there are less than \f$\nu_\mathrm{max} / 2 +
+   * 1\f$ coefficients for any of the detectors.
+   */
+  AttenuatedAngularCorrelation(const AngularCorrelation &ang_cor,
+                               const vector<double> &attenuation_1,
+                               const vector<double> &attenuation_2);
+
+  /**
+   * \brief Call operator of the attenuated angular correlation
+   *
+   * \param theta Polar angle in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$).
+   * \param phi Azimuthal angle in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$).
+   *
+   * \return \f$W_{\gamma \gamma}^Q \left( \theta, \varphi \right)\f$
+   */
+  double operator()(const double theta, const double phi) const;
+
+  /**
+   * \brief Evaluate the attenuated angular correlation for many directions at
+   * once.
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$), array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$), array of length n.
+   * \param result Array of length n for the values \f$W_{\gamma \gamma}^Q
+   * \left( \theta_i, \varphi_i \right)\f$.
+   */
+  void evaluate(const size_t n, const double *theta, const double *phi,
+                double *result) const;
+
+  /**
+   * \brief Evaluate the attenuated angular correlation for many directions at
+   * once, given the cosines of the polar angles.
+   *
+   * See W_gamma_gamma::evaluate_attenuated_cos_theta().
+   *
+   * \param n Number of directions.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$), array of length n.
+   * \param result Array of length n for the values \f$W_{\gamma \gamma}^Q
+   * \left( \theta_i, \varphi_i \right)\f$.
+   */
+  void evaluate_cos_theta(const size_t n, const double *cos_theta,
+                          const double *phi, double *result) const {
+    angular_correlation.evaluate_attenuated_cos_theta(n, cos_theta, phi,
+                                                      attenuation.data(),
+                                                      result);
+  }
+
+  /**
+   * \brief Attenuation coefficients of a detector which covers a cone
+   * uniformly.
+   *
+   * \f[
+   *      Q_{2i} = \frac{J_{2i} \left( \alpha \right)}{J_0 \left( \alpha
+   * \right)}, \f]
+   *
+   * with the cone integrals \f$J_{2i}\f$ of legendre_series::cone_integrals().
+   * The opening angle (half angle) \f$\alpha\f$ is defined as in
+   * SpotlightSampler.
+   *
+   * \param nu_max Maximum order \f$\nu_\mathrm{max}\f$ of the expansion
+   * (see AngularCorrelation::get_nu_max()).
+   * \param opening_angle Opening angle \f$\alpha \in \left( 0, \pi
+   * \right]\f$ in radians.
+   *
+   * \return Attenuation coefficients \f$Q_{2i}\f$, \f$0 \leq i \leq
+   * \nu_\mathrm{max} / 2\f$.
+   *
+   * \throw invalid_argument if \f$\alpha \leq 0\f$ or \f$\alpha > \pi\f$.
+   */
+  static vector<double>
+  cone_attenuation_coefficients(const int nu_max, const double opening_angle);
+
+  /**
+   * \brief Return the angular correlation.
+   */
+  const AngularCorrelation &get_angular_correlation() const {
+    return angular_correlation;
+  }
+
+  /**
+   * \brief Return the attenuation coefficients \f$Q_{2i}\f$, \f$0 \leq i \leq
+   * \nu_\mathrm{max} / 2\f$.
+   */
+  const vector<double> &get_attenuation() const { return attenuation; }
+
+protected:
+  const AngularCorrelation &angular_correlation; /**< Angular correlation */
+  vector<double> attenuation; /**< Attenuation coefficients \f$Q_{2i}\f$ */
+};
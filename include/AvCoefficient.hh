@@ -19,6 +19,17 @@
 
 #pragma once
 
+#include <array>
+
+using std::array;
+
+#include <atomic>
+
+using std::atomic;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+
 #include "FCoefficient.hh"
 #include "StringRepresentable.hh"
 
@@ -305,6 +316,14 @@
  * \f$\nu = 0, 2, 4\f$ for photonic transitions with \f$L \leq 2\f$ of even-even
  nuclei.
  *
+ * Only \f$F_\nu \left( L_n, L_n, j_n, j \right)\f$ is calculated by the
+ * constructor.
+ * The two F coefficients with \f$L_n^\prime\f$ are calculated when they are
+ * needed for the first time, i.e. when the coefficient is evaluated for
+ * \f$\delta_n \neq 0\f$ or one of the terms of the polynomial is requested.
+ * For a pure transition, this avoids two thirds of the Wigner symbols.
+ * The calculation is safe if several threads use the same object.
+ *
  * \f$^1\f$ To the author, the notation in Sec. B of Ref. \cite FaggHanna1959
  appeared confusing
  * at first, because the parameters of the \f$A_\nu \left( n \right)\f$ are
@@ -340,6 +359,34 @@ public:
   AvCoefficient(const int two_nu, const int two_L, const int two_Lp,
                 const int two_jn, const int two_j);
 
+  /**
+   * \brief Constructor for known F coefficients.
+   *
+   * No Wigner symbol is calculated, see get_f_values().
+   *
+   * \param two_nu \f$2 \nu\f$
+   * \param two_L Primary multipolarity \f$2 L\f$
+   * \param two_Lp Secondary multipolarity \f$2 L^\prime\f$
+   * \param two_jn Angular momentum quantum number \f$2 j_n\f$ of the initial or
+   * final state of a transition
+   * \param two_j Angular momentum quantum number \f$2 j\f$ of the
+   * intermediate state of a transition
+   * \param f_values Values of \f$F_\nu \left( L, L, j_n, j \right)\f$,
+   * \f$F_\nu \left( L, L^\prime, j_n, j \right)\f$, and \f$F_\nu \left(
+   * L^\prime, L^\prime, j_n, j \right)\f$.
+   */
+  AvCoefficient(const int two_nu, const int two_L, const int two_Lp,
+                const int two_jn, const int two_j,
+                const array<double, 3> &f_values);
+
+  /**
+   * \brief Copy constructor
+   *
+   * Copies the F coefficients with \f$L^\prime\f$ only if they were already
+   * calculated.
+   */
+  AvCoefficient(const AvCoefficient &av_coefficient);
+
   /**
    * \brief Return value of a specific \f$A_\nu\f$ coefficient.
    *
@@ -349,18 +396,160 @@ public:
    */
   double operator()(const double delta) const;
 
-  string string_representation(const unsigned int n_digits = 0,
-                               const vector<string> variable_names = {}) const;
+  /**
+   * \brief Return the value of an \f$A_\nu\f$ coefficient for a fixed
+   * multipole mixing ratio without constructing an object.
+   *
+   * Only the F coefficients that can contribute are calculated: the terms
+   * with \f$L^\prime\f$ are skipped for \f$\delta = 0\f$, and
+   * FCoefficient::is_nonzero() avoids the Wigner symbols of the vanishing
+   * ones.
+   * Use this function if the coefficient is needed for a single value of
+   * \f$\delta\f$.
+   * The result is identical to the one of operator()() of an object that was
+   * created with the same arguments.
+   *
+   * \param two_nu \f$2 \nu\f$
+   * \param two_L Primary multipolarity \f$2 L\f$
+   * \param two_Lp Secondary multipolarity \f$2 L^\prime\f$
+   * \param two_jn Angular momentum quantum number \f$2 j_n\f$ of the initial or
+   * final state of a transition
+   * \param two_j Angular momentum quantum number \f$2 j\f$ of the
+   * intermediate state of a transition
+   * \param delta Multipole mixing ratio \f$\delta\f$
+   *
+   * \return \f$A_\nu \left( L, L^\prime, j_n, j, \delta_n \right)\f$
+   */
+  static double evaluate(const int two_nu, const int two_L, const int two_Lp,
+                         const int two_jn, const int two_j,
+                         const double delta);
+
+  /**
+   * \brief Return the derivative of the coefficient with respect to the
+   * multipole mixing ratio.
+   *
+   * \param delta Multipole mixing ratio \f$\delta\f$
+   *
+   * \return \f$\mathrm{d} A_\nu / \mathrm{d} \delta = c_1 + 2 c_2
+   * \delta\f$ (see get_constant_coefficient())
+   */
+  double derivative(const double delta) const {
+    return get_linear_coefficient() + 2. * delta * get_quadratic_coefficient();
+  }
+
+  /**
+   * \brief Return the \f$\delta\f$-independent term of the coefficient.
+   *
+   * Together with the linear and the quadratic term, this function provides the
+   * representation of the coefficient as a polynomial in \f$\delta\f$:
+   *
+   * \f[
+   *      A_\nu \left( \delta \right) = c_0 + c_1 \delta + c_2 \delta^2.
+   * \f]
+   *
+   * \return \f$c_0\f$
+   */
+  double get_constant_coefficient() const { return constant_coefficient; }
+
+  /**
+   * \brief Return the term of the coefficient which is linear in \f$\delta\f$.
+   *
+   * \return \f$c_1\f$
+   */
+  double get_linear_coefficient() const {
+    require_mixed_terms();
+    return 2. * linear_f_value.load(memory_order_relaxed);
+  }
+
+  /**
+   * \brief Return the term of the coefficient which is quadratic in
+   * \f$\delta\f$.
+   *
+   * \return \f$c_2\f$
+   */
+  double get_quadratic_coefficient() const {
+    require_mixed_terms();
+    return quadratic_f_value.load(memory_order_relaxed);
+  }
+
+  /**
+   * \brief Return the values of the F coefficients.
+   *
+   * \return The argument f_values of AvCoefficient(const int, const int,
+   * const int, const int, const int, const array<double, 3> &) that restores
+   * this object.
+   */
+  array<double, 3> get_f_values() const {
+    require_mixed_terms();
+    return {constant_f_coefficient.get_value(),
+            linear_f_value.load(memory_order_relaxed),
+            quadratic_f_value.load(memory_order_relaxed)};
+  }
+
+  /**
+   * \brief Return the value of \f$F_\nu \left( L, L, j_n, j \right)\f$.
+   *
+   * Unlike get_f_values(), this does not calculate the F coefficients with
+   * \f$L^\prime\f$.
+   */
+  double get_constant_f_value() const {
+    return constant_f_coefficient.get_value();
+  }
+
+  void write_string_representation(
+      string &str_rep, const unsigned int n_digits = 0,
+      const vector<string> &variable_names = {}) const override;
+
+  /**
+   * \brief Append string representation with a given name of the multipole
+   * mixing ratio.
+   *
+   * Equivalent to write_string_representation(string &, const unsigned int,
+   * const vector<string> &) const with a single variable name, without
+   * creating a vector.
+   *
+   * \param str_rep String to which the representation is appended.
+   * \param n_digits Number of digits, see
+   * StringRepresentable::string_representation().
+   * \param delta_variable Name of the multipole mixing ratio.
+   */
+  void write_string_representation(string &str_rep,
+                                   const unsigned int n_digits,
+                                   const string &delta_variable) const;
 
 protected:
+  /**
+   * \brief Make sure that the F coefficients with \f$L^\prime\f$ are
+   * available.
+   */
+  void require_mixed_terms() const {
+    if (!mixed_terms_calculated.load(memory_order_acquire)) {
+      calculate_mixed_terms();
+    }
+  }
+
+  /**
+   * \brief Calculate the F coefficients with \f$L^\prime\f$.
+   *
+   * Threads that call this function at the same time calculate and store the
+   * same values.
+   */
+  void calculate_mixed_terms() const;
+
   const int two_nu;
   const int two_L;
   const int two_Lp;
   const int two_jn;
   const int two_j;
 
-  const FCoefficient constant_f_coefficient, linear_f_coefficient,
-      quadratic_f_coefficient;
+  const FCoefficient constant_f_coefficient;
+  double constant_coefficient;
 
-  double constant_coefficient, linear_coefficient, quadratic_coefficient;
+  mutable atomic<bool> mixed_terms_calculated; /**< Whether linear_f_value
+                                                  and quadratic_f_value are
+                                                  valid. */
+  mutable atomic<double> linear_f_value; /**< \f$F_\nu \left( L, L^\prime,
+                                            j_n, j \right)\f$ */
+  mutable atomic<double> quadratic_f_value; /**< \f$F_\nu \left( L^\prime,
+                                               L^\prime, j_n, j \right)\f$ */
 };
@@ -0,0 +1,190 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <atomic>
+
+using std::atomic;
+
+#include <cstddef>
+
+using std::max_align_t;
+using std::size_t;
+
+#include <functional>
+
+using std::less;
+
+#include <memory>
+
+using std::shared_ptr;
+using std::unique_ptr;
+
+#include <new>
+
+using std::align_val_t;
+
+#include <utility>
+
+using std::move;
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * \brief Single block of memory for the objects of a batch.
+ *
+ * The block is divided into a fixed number of slots of equal size, for
+ * example one for each element of a batch of angular correlations that are
+ * created together.
+ * A BatchArena::Allocator for a slot hands out the memory of its slot in the
+ * order of the requests.
+ * Memory inside the block is never reused, and deallocating it does nothing.
+ * The block is released together with the BatchArena, i.e. when the last
+ * allocator that refers to it is destroyed.
+ * With std::allocate_shared(), this happens after the last object of the batch
+ * has been destroyed, since each object keeps a copy of its allocator.
+ *
+ * Requests that do not fit into the remaining memory of a slot are passed on
+ * to the global operator new, so an underestimated slot size costs
+ * performance, but it is not an error.
+ *
+ * Different slots may be used by different threads at the same time, but each
+ * slot only by one thread at a time.
+ */
+class BatchArena {
+public:
+  /**
+   * \brief Allocator that takes memory from one slot of a BatchArena.
+   *
+   * All allocators of the same arena compare equal, since each of them can
+   * deallocate the memory of the others.
+   */
+  template <typename T> class Allocator {
+  public:
+    using value_type = T;
+
+    /**
+     * \brief Constructor
+     *
+     * \param arena Arena, which is kept alive by the allocator and its copies.
+     * \param slot Index of the slot.
+     */
+    Allocator(shared_ptr<BatchArena> arena, const size_t slot)
+        : arena(move(arena)), slot(slot) {}
+
+    /**
+     * \brief Copy of an allocator for another type.
+     */
+    template <typename U>
+    Allocator(const Allocator<U> &allocator)
+        : arena(allocator.arena), slot(allocator.slot) {}
+
+    T *allocate(const size_t n) {
+      return static_cast<T *>(
+          arena->allocate(slot, n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *pointer, const size_t) {
+      arena->deallocate(pointer, alignof(T));
+    }
+
+    template <typename U> bool operator==(const Allocator<U> &allocator) const {
+      return arena == allocator.arena;
+    }
+
+    template <typename U> bool operator!=(const Allocator<U> &allocator) const {
+      return arena != allocator.arena;
+    }
+
+  private:
+    template <typename U> friend class Allocator;
+
+    shared_ptr<BatchArena> arena; /**< Arena */
+    size_t slot;                  /**< Index of the slot */
+  };
+
+  /**
+   * \brief Constructor
+   *
+   * Allocates the block.
+   *
+   * \param n_slots Number of slots.
+   * \param slot_size Size of a slot in bytes. It is rounded up to a multiple of
+   * the alignment of std::max_align_t.
+   */
+  BatchArena(const size_t n_slots, const size_t slot_size)
+      : slot_size((slot_size + alignof(max_align_t) - 1) /
+                  alignof(max_align_t) * alignof(max_align_t)),
+        block_size(n_slots * this->slot_size), block(new char[block_size]),
+        used(n_slots, 0) {}
+
+  BatchArena(const BatchArena &) = delete;
+  BatchArena &operator=(const BatchArena &) = delete;
+
+  /**
+   * \brief Allocate memory in a slot, or on the heap if it does not fit.
+   *
+   * \param slot Index of the slot.
+   * \param size Size in bytes.
+   * \param alignment Alignment in bytes.
+   *
+   * \return Pointer to the memory.
+   */
+  void *allocate(const size_t slot, const size_t size, const size_t alignment) {
+    const size_t offset = (used[slot] + alignment - 1) / alignment * alignment;
+    if (alignment > alignof(max_align_t) || offset + size > slot_size) {
+      ++n_heap_allocations;
+      return ::operator new(size, align_val_t(alignment));
+    }
+    used[slot] = offset + size;
+    return block.get() + slot * slot_size + offset;
+  }
+
+  /**
+   * \brief Deallocate memory that was obtained with allocate().
+   *
+   * Memory inside the block is only released with the BatchArena.
+   *
+   * \param pointer Pointer to the memory.
+   * \param alignment Alignment that was passed to allocate().
+   */
+  void deallocate(void *pointer, const size_t alignment) {
+    const char *address = static_cast<const char *>(pointer);
+    if (less<const char *>()(address, block.get()) ||
+        !less<const char *>()(address, block.get() + block_size)) {
+      ::operator delete(pointer, align_val_t(alignment));
+    }
+  }
+
+  /**
+   * \brief Number of requests that did not fit into their slot.
+   */
+  size_t get_n_heap_allocations() const { return n_heap_allocations; }
+
+protected:
+  const size_t slot_size;  /**< Size of a slot in bytes */
+  const size_t block_size; /**< Size of the block in bytes */
+  unique_ptr<char[]> block; /**< Block of memory */
+  vector<size_t> used;      /**< Number of used bytes in each slot */
+  atomic<size_t> n_heap_allocations{
+      0}; /**< Number of requests that did not fit into their slot */
+};
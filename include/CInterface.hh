@@ -0,0 +1,51 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <string>
+
+using std::string;
+
+/**
+ * \brief Helper functions of the C interfaces of the angular_correlation
+ * library.
+ */
+namespace c_interface {
+
+/**
+ * \brief Copy a message into a buffer of a given length, including the
+ * terminating null character.
+ *
+ * Longer messages are truncated.
+ * Nothing is copied if message_buffer is a null pointer or if message_length
+ * is zero.
+ *
+ * \param message Message.
+ * \param message_length Length of the buffer in bytes.
+ * \param message_buffer Buffer.
+ */
+void copy_message(const string &message, const size_t message_length,
+                  char *message_buffer);
+
+} // namespace c_interface
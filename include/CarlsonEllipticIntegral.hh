@@ -0,0 +1,172 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+/**
+ * \brief Precision of the Carlson elliptic integrals.
+ */
+enum EllipticIntegralPrecision : short {
+  double_precision = 0,     ///< Relative error close to the machine precision.
+  approximate_precision = 1 ///< Relative error of the order of \f$10^{-9}\f$,
+                            ///< which requires fewer iterations.
+};
+
+/**
+ * \brief Elliptic integrals in the symmetric form of Carlson.
+ *
+ * The incomplete elliptic integrals of the first and second kind in Legendre's
+ * form can be expressed by Carlson's symmetric integrals \f$R_F\f$ and
+ * \f$R_D\f$ {Eqs. (19.25.5) and (19.25.9) in Ref. \cite DLMF2020}:
+ *
+ * \f[
+ *      F \left( \varphi | m \right) = \sin \left( \varphi \right) R_F \left(
+ * c^2, \Delta^2, 1 \right), \f]
+ *
+ * \f[
+ *      E \left( \varphi | m \right) = \sin \left( \varphi \right) R_F \left(
+ * c^2, \Delta^2, 1 \right) - \frac{m}{3} \sin^3 \left( \varphi \right) R_D
+ * \left( c^2, \Delta^2, 1 \right), \f]
+ *
+ * with \f$c = \cos \left( \varphi \right)\f$ and \f$\Delta^2 = 1 - m \sin^2
+ * \left( \varphi \right)\f$.
+ * These expressions are valid for any real parameter \f$m\f$ with \f$m
+ * \sin^2 \left( \varphi \right) \leq 1\f$, in particular for the large
+ * negative parameters \f$m = - c^2\f$ of the spiral of the
+ * SpherePointSampler, which GSL \cite Galassi2009 only supports via
+ * transformations of the parameter.
+ *
+ * The symmetric integrals are calculated with the duplication algorithm of
+ * Carlson \cite Carlson1995, which reduces the differences of the arguments by
+ * a factor of 4 in each iteration, and a Taylor expansion of fifth order at
+ * the end.
+ * The number of iterations is determined in advance by the requested
+ * precision.
+ */
+namespace carlson_elliptic_integral {
+
+/**
+ * \brief Carlson's symmetric elliptic integral of the first kind
+ *
+ * \f[
+ *      R_F \left( x, y, z \right) = \frac{1}{2} \int_0^\infty \frac{\mathrm{d}
+ * t}{\sqrt{\left( t + x \right) \left( t + y \right) \left( t + z \right)}}.
+ * \f]
+ *
+ * \param x \f$x \geq 0\f$
+ * \param y \f$y \geq 0\f$
+ * \param z \f$z \geq 0\f$
+ * \param precision Precision of the result (default: double_precision).
+ *
+ * \return \f$R_F \left( x, y, z \right)\f$, or infinity if more than one
+ * argument vanishes.
+ *
+ * \throw invalid_argument if an argument is negative.
+ */
+double R_F(const double x, const double y, const double z,
+           const EllipticIntegralPrecision precision = double_precision);
+
+/**
+ * \brief Carlson's symmetric elliptic integral of the second kind
+ *
+ * \f[
+ *      R_D \left( x, y, z \right) = \frac{3}{2} \int_0^\infty \frac{\mathrm{d}
+ * t}{\sqrt{\left( t + x \right) \left( t + y \right) \left( t + z
+ * \right)^3}}. \f]
+ *
+ * \param x \f$x \geq 0\f$
+ * \param y \f$y \geq 0\f$
+ * \param z \f$z \geq 0\f$
+ * \param precision Precision of the result (default: double_precision).
+ *
+ * \return \f$R_D \left( x, y, z \right)\f$, or infinity if \f$z\f$ or both
+ * \f$x\f$ and \f$y\f$ vanish.
+ *
+ * \throw invalid_argument if an argument is negative.
+ */
+double R_D(const double x, const double y, const double z,
+           const EllipticIntegralPrecision precision = double_precision);
+
+/**
+ * \brief Incomplete elliptic integral of the first kind \f$F \left( \varphi |
+ * m \right)\f$
+ *
+ * Arbitrary angles are reduced to \f$\left| \varphi \right| \leq \pi / 2\f$
+ * with the quasi-periodicity \f$F \left( \varphi + k \pi | m \right) = F
+ * \left( \varphi | m \right) + 2 k K \left( m \right)\f$, which requires
+ * \f$m < 1\f$.
+ *
+ * \param phi \f$\varphi\f$
+ * \param m \f$m\f$, with \f$m \sin^2 \left( \varphi \right) \leq 1\f$.
+ * \param precision Precision of the result (default: double_precision).
+ *
+ * \return \f$F \left( \varphi | m \right)\f$
+ *
+ * \throw invalid_argument if \f$m \sin^2 \left( \varphi \right) > 1\f$, or if
+ * \f$\left| \varphi \right| > \pi / 2\f$ and \f$m \geq 1\f$.
+ */
+double F(const double phi, const double m,
+         const EllipticIntegralPrecision precision = double_precision);
+
+/**
+ * \brief Incomplete elliptic integral of the second kind \f$E \left( \varphi |
+ * m \right)\f$
+ *
+ * Arbitrary angles are reduced to \f$\left| \varphi \right| \leq \pi / 2\f$
+ * with the quasi-periodicity \f$E \left( \varphi + k \pi | m \right) = E
+ * \left( \varphi | m \right) + 2 k E \left( m \right)\f$, which requires
+ * \f$m \leq 1\f$.
+ *
+ * \param phi \f$\varphi\f$
+ * \param m \f$m\f$, with \f$m \sin^2 \left( \varphi \right) \leq 1\f$.
+ * \param precision Precision of the result (default: double_precision).
+ *
+ * \return \f$E \left( \varphi | m \right)\f$
+ *
+ * \throw invalid_argument if \f$m \sin^2 \left( \varphi \right) > 1\f$, or if
+ * \f$\left| \varphi \right| > \pi / 2\f$ and \f$m > 1\f$.
+ */
+double E(const double phi, const double m,
+         const EllipticIntegralPrecision precision = double_precision);
+
+/**
+ * \brief Complete elliptic integral of the first kind \f$K \left( m \right) =
+ * F \left( \pi / 2 | m \right) = R_F \left( 0, 1 - m, 1 \right)\f$
+ *
+ * \param m \f$m \leq 1\f$
+ * \param precision Precision of the result (default: double_precision).
+ *
+ * \throw invalid_argument if \f$m > 1\f$.
+ */
+double complete_K(const double m,
+                  const EllipticIntegralPrecision precision = double_precision);
+
+/**
+ * \brief Complete elliptic integral of the second kind \f$E \left( m \right) =
+ * E \left( \pi / 2 | m \right)\f$
+ *
+ * \param m \f$m \leq 1\f$
+ * \param precision Precision of the result (default: double_precision).
+ *
+ * \throw invalid_argument if \f$m > 1\f$.
+ */
+double complete_E(const double m,
+                  const EllipticIntegralPrecision precision = double_precision);
+
+} // namespace carlson_elliptic_integral
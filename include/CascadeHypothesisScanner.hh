@@ -0,0 +1,202 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "State.hh"
+
+/**
+ * \brief Enumerate and evaluate all spin-parity hypotheses for a cascade.
+ *
+ * Given a list of candidate states for each level of a cascade (for example
+ * all \f$J^\pi\f$ with \f$2J \in \left[ 0, 12 \right]\f$ and both
+ * parities), this class enumerates all combinations and constructs the
+ * corresponding angular correlations with the lowest multipolarities, as
+ * inferred by AngularCorrelation::infer_transition().
+ *
+ * Combinations that do not describe a valid cascade are rejected during the
+ * enumeration by cheap tests that do not throw exceptions:
+ * all angular momenta must be either integer or half integer, no transition
+ * may connect two spin-0 states, the inferred transitions must fulfil the
+ * triangle inequality and the parity selection rules
+ * (AngularCorrelation::valid_em_character()), and the multipolarity of the
+ * inferred transitions must not exceed a given value.
+ * Since the enumeration proceeds level by level, a rejected transition
+ * removes all combinations that contain it at once.
+ *
+ * The expansion coefficients of the accepted hypotheses are calculated in
+ * parallel by scan().
+ * Since the hypotheses are the leaves of a tree whose levels are the levels
+ * of the cascade, scan() walks through the tree with a CascadePrefixBuilder:
+ * the factors of a step are only calculated when the step differs from the
+ * one of the previous hypothesis.
+ * All threads share the cache of Wigner symbols (see WignerSymbolCache), so
+ * coupling coefficients that appear in several hypotheses are calculated only
+ * once.
+ * Only the normalized expansion coefficients (see
+ * W_gamma_gamma::get_legendre_coefficients() and
+ * W_gamma_gamma::get_associated_legendre_coefficients()) of each hypothesis
+ * are kept, in a single flat table:
+ * the coefficients of hypothesis \f$k\f$ are located in the range
+ * \f$\left[ o_k, o_{k+1} \right)\f$ of the table, where \f$o_k\f$ are the
+ * offsets.
+ * The first \f$\nu_\mathrm{max} / 2 + 1\f$ of them are the coefficients
+ * \f$c_i\f$ of the Legendre polynomials, the remaining ones (if any) are the
+ * coefficients \f$d_i\f$ of the associated Legendre polynomials.
+ */
+class CascadeHypothesisScanner {
+
+public:
+  /**
+   * \brief Constructor
+   *
+   * Enumerates all valid hypotheses.
+   * The hypotheses are ordered lexicographically by the indices of the
+   * candidates, with the last level changing fastest.
+   *
+   * \param state_candidates Candidates for the states of the cascade. The
+   * first element contains the candidates for the initial state, the element
+   * \f$i > 0\f$ the candidates for the state after step \f$i\f$.
+   * \param max_two_L Maximum value of \f$2L\f$ for the inferred transitions
+   * (default: 4, i.e. up to quadrupole transitions).
+   *
+   * \throw invalid_argument if less than three levels are given.
+   */
+  CascadeHypothesisScanner(const vector<vector<State>> &state_candidates,
+                           const int max_two_L = 4);
+
+  /**
+   * \brief All states with angular momenta in a given range.
+   *
+   * \param two_J_min Minimum of \f$2J\f$.
+   * \param two_J_max Maximum of \f$2J\f$.
+   * \param parities Parities (default: positive and negative).
+   *
+   * \return States with \f$2J = 2J_\mathrm{min}, 2J_\mathrm{min} + 2, ...,
+   * 2J_\mathrm{max}\f$, for each \f$2J\f$ with all given parities.
+   */
+  static vector<State>
+  spin_parity_candidates(const int two_J_min, const int two_J_max,
+                         const vector<Parity> &parities = {negative,
+                                                           positive});
+
+  /**
+   * \brief Check whether the inferred transition between two states is
+   * acceptable.
+   *
+   * \param state_0 Initial state of the transition.
+   * \param state_1 Final state of the transition.
+   * \param max_two_L Maximum value of \f$2L\f$.
+   *
+   * \return true if the transition is acceptable, false otherwise.
+   */
+  static bool accept_transition(const State &state_0, const State &state_1,
+                                const int max_two_L);
+
+  /**
+   * \brief Calculate the expansion coefficients of all hypotheses.
+   *
+   * \param n_threads Number of threads (default: 0, which means that the
+   * number of concurrent threads supported by the hardware is used).
+   */
+  void scan(const unsigned int n_threads = 0);
+
+  /**
+   * \brief Number of valid hypotheses.
+   */
+  size_t get_n_hypotheses() const { return states.size() / n_levels; }
+
+  /**
+   * \brief Number of levels of the cascade, including the initial state.
+   */
+  size_t get_n_levels() const { return n_levels; }
+
+  /**
+   * \brief States of a hypothesis.
+   *
+   * \param k Index of the hypothesis.
+   *
+   * \return Initial state, followed by the states after each step.
+   */
+  vector<State> get_states(const size_t k) const {
+    return vector<State>(states.begin() + k * n_levels,
+                         states.begin() + (k + 1) * n_levels);
+  }
+
+  /**
+   * \brief Construct the angular correlation of a hypothesis.
+   *
+   * \param k Index of the hypothesis.
+   */
+  AngularCorrelation get_angular_correlation(const size_t k) const;
+
+  /**
+   * \brief Offsets \f$o_k\f$ of the hypotheses in the coefficient table.
+   *
+   * The vector has get_n_hypotheses() + 1 elements. Before scan() is called,
+   * it is empty.
+   */
+  const vector<size_t> &get_offsets() const { return offsets; }
+
+  /**
+   * \brief Table of the expansion coefficients of all hypotheses.
+   */
+  const vector<double> &get_coefficients() const { return coefficients; }
+
+  /**
+   * \brief Number of coefficients of the Legendre polynomials for each
+   * hypothesis, i.e. \f$\nu_\mathrm{max} / 2 + 1\f$.
+   */
+  const vector<size_t> &get_n_legendre_coefficients() const {
+    return n_legendre_coefficients;
+  }
+
+  /**
+   * \brief Evaluate the angular correlation of a hypothesis from the
+   * coefficient table.
+   *
+   * \param k Index of the hypothesis.
+   * \param n Number of directions.
+   * \param theta Polar angles in radians, array of length n.
+   * \param phi Azimuthal angles in radians, array of length n.
+   * \param result Array of length n for the results.
+   *
+   * \throw invalid_argument if scan() has not been called.
+   */
+  void evaluate(const size_t k, const size_t n, const double *theta,
+                const double *phi, double *result) const;
+
+protected:
+  const size_t n_levels;
+  const int max_two_L;
+  vector<State> states; /**< States of all hypotheses, n_levels per
+                           hypothesis. */
+  vector<size_t> offsets;
+  vector<size_t> n_legendre_coefficients;
+  vector<double> coefficients;
+};
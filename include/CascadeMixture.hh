@@ -0,0 +1,266 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AliasTable.hh"
+#include "AngCorrRejectionSampler.hh"
+#include "AngularCorrelation.hh"
+#include "CompactAngularCorrelation.hh"
+#include "RandomEngine.hh"
+
+/**
+ * \brief Weighted mixture of angular correlations of several branches of a
+ * decay.
+ *
+ * An AngularCorrelation object describes a single linear cascade.
+ * In general, an excited state decays to several final states with known
+ * branching ratios, and unobserved intermediate steps of a cascade can
+ * proceed along several paths.
+ * This class holds a set of branches \f$b\f$, each given by an angular
+ * correlation \f$W_b\f$, a weight \f$w_b\f$, and the index \f$o_b\f$ of the
+ * observable that is measured for it (for example, the index of a
+ * \f$\gamma\f$-ray line).
+ * The weights are normalized to \f$\sum_b w_b = 1\f$, so that the combined
+ * distribution
+ *
+ * \f[
+ *      W \left( \theta, \varphi \right) = \sum_b w_b W_b \left( \theta,
+ * \varphi \right)
+ * \f]
+ *
+ * has the same normalization as a single angular correlation.
+ *
+ * Since all angular correlations are linear combinations of the same
+ * (associated) Legendre polynomials (see CompactAngularCorrelation), the
+ * weighted sums of the expansion coefficients are collapsed once in the
+ * constructor, both for all branches and for the branches of each
+ * observable
+ *
+ * \f[
+ *      W_o \left( \theta, \varphi \right) = \sum_{b, o_b = o} w_b W_b \left(
+ * \theta, \varphi \right).
+ * \f]
+ *
+ * The distributions \f$W_o\f$ are not renormalized, their integrals are
+ * proportional to the probabilities of the observables.
+ * Therefore, evaluating a mixture takes a single pass over the directions,
+ * independent of the number of branches.
+ *
+ * Events are sampled in two steps: the branch is selected with an AliasTable
+ * in constant time, and the direction is sampled from
+ * the angular correlation of the branch with an AngCorrRejectionSampler.
+ */
+class CascadeMixture {
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param branches Angular correlations of the branches.
+   * \param weights Weights of the branches, for example branching ratios.
+   * They are normalized by their sum.
+   * \param observables Indices of the observables of the branches
+   * (default: all branches belong to the observable 0).
+   * \param seed Random number seed (default: 0).
+   *
+   * \throw invalid_argument if there are no branches, if the numbers of
+   * branches, weights, and observables do not match, if a weight is
+   * negative, or if all weights are zero.
+   */
+  CascadeMixture(const vector<AngularCorrelation> &branches,
+                 const vector<double> &weights,
+                 const vector<size_t> &observables = {},
+                 const unsigned int seed = 0);
+
+  /**
+   * \brief Evaluate the combined distribution of all branches.
+   *
+   * \param theta Polar angle in radians.
+   * \param phi Azimuthal angle in radians.
+   *
+   * \return \f$W \left( \theta, \varphi \right)\f$
+   */
+  double operator()(const double theta, const double phi) const {
+    return mixture(theta, phi);
+  }
+
+  /**
+   * \brief Evaluate the combined distribution of all branches for many
+   * directions at once.
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in radians, array of length n.
+   * \param phi Azimuthal angles in radians, array of length n.
+   * \param result Array of length n for the results.
+   */
+  void evaluate(const size_t n, const double *theta, const double *phi,
+                double *result) const {
+    mixture.evaluate(n, theta, phi, result);
+  }
+
+  /**
+   * \brief Evaluate the combined distribution of the branches of a single
+   * observable for many directions at once.
+   *
+   * \param observable Index of the observable.
+   * \param n Number of directions.
+   * \param theta Polar angles in radians, array of length n.
+   * \param phi Azimuthal angles in radians, array of length n.
+   * \param result Array of length n for the results of \f$W_o\f$.
+   *
+   * \throw out_of_range if the observable does not exist.
+   */
+  void evaluate(const size_t observable, const size_t n, const double *theta,
+                const double *phi, double *result) const {
+    observable_mixtures.at(observable).evaluate(n, theta, phi, result);
+  }
+
+  /**
+   * \brief Sample a branch and a direction.
+   *
+   * \return Index of the branch, and the polar and azimuthal angle of the
+   * direction in radians.
+   */
+  pair<size_t, array<double, 2>> sample();
+
+  /**
+   * \brief Sample many branches and directions.
+   *
+   * Gives the same result as \f$n\f$ consecutive calls of sample().
+   *
+   * \param n Number of events.
+   * \param branches Array of length n for the indices of the branches.
+   * \param theta Array of length n for the polar angles in radians.
+   * \param phi Array of length n for the azimuthal angles in radians.
+   */
+  void sample(const size_t n, size_t *branches, double *theta, double *phi);
+
+  /**
+   * \brief Sample the index of a branch.
+   */
+  size_t sample_branch();
+
+  /**
+   * \brief Reinitialize the random number engines of the alias table and of
+   * the samplers of all branches.
+   *
+   * \param seed Random number seed.
+   */
+  void reseed(const unsigned int seed);
+
+  /**
+   * \brief Collapsed expansion of all branches.
+   */
+  const CompactAngularCorrelation &get_mixture() const { return mixture; }
+
+  /**
+   * \brief Collapsed expansion of the branches of an observable.
+   *
+   * \throw out_of_range if the observable does not exist.
+   */
+  const CompactAngularCorrelation &
+  get_observable_mixture(const size_t observable) const {
+    return observable_mixtures.at(observable);
+  }
+
+  /**
+   * \brief Number of branches.
+   */
+  size_t get_n_branches() const { return weights.size(); }
+
+  /**
+   * \brief Number of observables, i.e. the largest index of an observable
+   * plus one.
+   */
+  size_t get_n_observables() const { return observable_mixtures.size(); }
+
+  /**
+   * \brief Normalized weight \f$w_b\f$ of a branch.
+   *
+   * \throw out_of_range if the branch does not exist.
+   */
+  double get_weight(const size_t branch) const { return weights.at(branch); }
+
+  /**
+   * \brief Index of the observable of a branch.
+   *
+   * \throw out_of_range if the branch does not exist.
+   */
+  size_t get_observable(const size_t branch) const {
+    return observables.at(branch);
+  }
+
+  /**
+   * \brief Probability of an observable, i.e. the sum of the normalized
+   * weights of its branches.
+   *
+   * \throw out_of_range if the observable does not exist.
+   */
+  double get_observable_probability(const size_t observable) const {
+    return observable_probabilities.at(observable);
+  }
+
+  /**
+   * \brief Upper limit for the maximum of the combined distribution.
+   *
+   * Weighted sum of AngularCorrelation::get_upper_limit() of all branches.
+   */
+  double get_upper_limit() const { return upper_limit; }
+
+protected:
+  /**
+   * \brief Weighted sum of the expansion coefficients of a set of branches.
+   *
+   * The number of coefficients is the maximum of all branches, shorter
+   * expansions are padded with zeros.
+   */
+  static CompactAngularCorrelation
+  collapse(const vector<CompactAngularCorrelation> &compact,
+           const vector<double> &weights, const vector<bool> &selected);
+
+  vector<double> weights;      /**< Normalized weights of the branches. */
+  vector<size_t> observables;  /**< Observables of the branches. */
+  vector<double> observable_probabilities; /**< Probabilities of the
+                                              observables. */
+  CompactAngularCorrelation mixture; /**< Collapsed expansion. */
+  vector<CompactAngularCorrelation>
+      observable_mixtures; /**< Collapsed expansions of the observables. */
+  double upper_limit;      /**< Upper limit for the maximum of the mixture. */
+
+  AliasTable branch_table;          /**< Alias table of the branches. */
+  Xoshiro256PlusPlus random_engine; /**< Engine of the alias table. */
+  vector<AngCorrRejectionSampler>
+      samplers; /**< Samplers of the directions of the branches. */
+};
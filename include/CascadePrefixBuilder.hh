@@ -0,0 +1,166 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <vector>
+
+using std::vector;
+
+#include "State.hh"
+#include "Transition.hh"
+
+/**
+ * \brief Build the expansion coefficients of many cascades that share their
+ * first steps.
+ *
+ * The hypotheses of a scan of spin-parity assignments form a tree (a trie):
+ * the initial state is the root, and each path from the root to a leaf is a
+ * cascade. Hypotheses which differ only in the last levels share the steps
+ * above them. The expansion coefficients of W_dir_dir and W_pol_dir are
+ * products of factors that belong to single steps:
+ *
+ * \f[
+ *      c_\nu = \left[ \prod_{i} \frac{1}{1 + \delta_i^2} \right]
+ *              A_\nu \left( 1 \right) U_\nu \left( 2 \right) ...
+ *              U_\nu \left( n-1 \right) A_\nu \left( n \right),
+ * \f]
+ *
+ * and analogously with \f$\alpha_\nu \left( 1 \right)\f$ instead of
+ * \f$A_\nu \left( 1 \right)\f$ for the coefficients \f$d_\nu\f$ of a pol-dir
+ * correlation.
+ * This class stores, for each step \f$k\f$ of the current path, the
+ * \f$A_\nu\f$ and \f$\alpha_\nu\f$ coefficients of the first step, the
+ * partial products of \f$U_\nu\f$ coefficients up to step \f$k\f$, and the
+ * partial product of normalization factors.
+ * When a step is replaced by set_step(), only this step is recalculated and
+ * all steps below it are discarded. Walking through the tree depth first
+ * therefore calculates one factor per edge of the tree, instead of one factor
+ * per step of each leaf.
+ *
+ * The coefficients are the same, bit by bit, as the ones of an
+ * AngularCorrelation object with the same cascade (see
+ * W_gamma_gamma::get_legendre_coefficients() and
+ * W_gamma_gamma::get_associated_legendre_coefficients()), because the
+ * products are evaluated in the same order.
+ * The cascade is not checked for validity, see
+ * AngularCorrelation::validate() or
+ * CascadeHypothesisScanner::accept_transition().
+ */
+class CascadePrefixBuilder {
+
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param n_steps Number of transition - state pairs of the cascades.
+   *
+   * \throw invalid_argument if n_steps < 2.
+   */
+  CascadePrefixBuilder(const size_t n_steps);
+
+  /**
+   * \brief Set the initial state, which discards all steps.
+   *
+   * \param initial_state Initial state of the cascade.
+   */
+  void set_initial_state(const State &initial_state);
+
+  /**
+   * \brief Set a step of the cascade, which discards all following steps.
+   *
+   * If the last step is set, the expansion coefficients of the complete
+   * cascade are calculated.
+   *
+   * \param step Index of the step, starting at 0.
+   * \param transition Transition that leads to state.
+   * \param state State after the transition.
+   *
+   * \throw invalid_argument if the initial state or a previous step has not
+   * been set, or if step is not smaller than the number of steps.
+   */
+  void set_step(const size_t step, const Transition &transition,
+                const State &state);
+
+  /**
+   * \brief Number of transition - state pairs of the cascades.
+   */
+  size_t get_n_steps() const { return n_steps; }
+
+  /**
+   * \brief Number of steps of the current path, starting from the initial
+   * state.
+   */
+  size_t get_n_set_steps() const { return n_set_steps; }
+
+  /**
+   * \brief Normalized coefficients of the Legendre polynomials of the
+   * complete cascade.
+   *
+   * \throw invalid_argument if not all steps have been set.
+   */
+  const vector<double> &get_legendre_coefficients() const;
+
+  /**
+   * \brief Normalized coefficients of the associated Legendre polynomials of
+   * the complete cascade.
+   *
+   * Empty if the EM character of the first transition is unknown.
+   *
+   * \throw invalid_argument if not all steps have been set.
+   */
+  const vector<double> &get_associated_legendre_coefficients() const;
+
+protected:
+  /**
+   * \brief Calculate the coefficients of the complete cascade from the
+   * factors of the steps and the last transition.
+   */
+  void complete();
+
+  void check_complete() const;
+
+  const size_t n_steps;
+  size_t n_set_steps;
+  bool initial_state_set;
+  int two_J_initial;
+  vector<int> two_J; /**< \f$2J\f$ of the states after each step. */
+  vector<Transition> transitions;
+
+  /** Upper limit for \f$2\nu\f$ from the states and the first transition up to
+   * each step. */
+  vector<int> two_nu_limits;
+  /** Partial products of normalization factors. */
+  vector<double> normalization_factors;
+  /** \f$A_\nu\f$ coefficients of the first transition, evaluated at its
+   * mixing ratio. */
+  vector<double> av_excitation;
+  /** \f$\alpha_\nu\f$ coefficients of the first transition, starting at
+   * \f$\nu = 2\f$. */
+  vector<double> alphav_excitation;
+  /** Partial products of \f$U_\nu\f$ coefficients up to each step. */
+  vector<vector<double>> uv_coefficient_products;
+
+  vector<double> legendre_coefficients;
+  vector<double> associated_legendre_coefficients;
+};
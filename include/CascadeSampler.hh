@@ -23,18 +23,28 @@
 
 using std::array;
 
+#include <cstddef>
+
+using std::size_t;
+
 #include <memory>
 
 using std::shared_ptr;
 
+#include <utility>
+
+using std::pair;
+
 #include <vector>
 
 using std::vector;
 
 #include <gsl/gsl_math.h>
 
+#include "AcceptanceSampler.hh"
 #include "AngCorrRejectionSampler.hh"
 #include "AngularCorrelation.hh"
+#include "EulerAngleRotation.hh"
 #include "ReferenceFrameSampler.hh"
 
 /**
@@ -160,12 +170,367 @@ public:
    * coordinates in radians. The first pair describes the direction of emission
    * of the first (depends on the setting of return_first_direction) gamma ray
    * in the cascade, the second pair describes the second gamma ray, and so on.
+   *
+   * \throw runtime_error if the direction of a step is restricted to an
+   * acceptance (see restrict_to_acceptance()).
    */
   vector<array<double, 3>> operator()();
 
+  /**
+   * \brief Sample the reference frames of many cascades at once.
+   *
+   * In contrast to operator()(), this function does not allocate memory for
+   * each cascade.
+   * The events are processed in blocks of CascadeSampler::block_size, and the
+   * samplers for the individual steps are called once per block (see
+   * ReferenceFrameSampler::operator()(const size_t, double*, double*,
+   * double*)).
+   * Since each step has its own sampler, the result is the same as for
+   * n_events consecutive calls of operator()().
+   *
+   * \param n_events Number of cascades \f$n\f$.
+   * \param Phi_Theta_Psi Array of length \f$3 n_s n\f$, where \f$n_s\f$ is
+   * the number of steps of the cascade, for the Euler angles in radians.
+   * The Euler angles are stored as a structure of arrays: the element with
+   * the index \f$\left( 3 i + j \right) n + k\f$ is the angle \f$j\f$
+   * (\f$\Phi\f$, \f$\Theta\f$, or \f$\Psi\f$) of step \f$i\f$ of cascade
+   * \f$k\f$.
+   * In other words, the array contains all values of \f$\Phi\f$ of the
+   * first step, followed by all values of \f$\Theta\f$ of the first step,
+   * and so on.
+   *
+   * \throw runtime_error if the direction of a step is restricted to an
+   * acceptance (see restrict_to_acceptance()).
+   */
+  void sample(const size_t n_events, double *Phi_Theta_Psi);
+
+  /**
+   * \brief Sample the reference frames of many cascades into a part of a
+   * larger array.
+   *
+   * Same as sample(const size_t, double*), but the distance between the
+   * arrays for the individual angles is given by the leading dimension
+   * \f$n_\mathrm{ld} \geq n\f$ instead of \f$n\f$, i.e. the element with
+   * the index \f$\left( 3 i + j \right) n_\mathrm{ld} + k\f$ is the angle
+   * \f$j\f$ of step \f$i\f$ of cascade \f$k\f$.
+   *
+   * \param n_events Number of cascades \f$n\f$.
+   * \param Phi_Theta_Psi Array for the Euler angles in radians.
+   * \param leading_dimension \f$n_\mathrm{ld}\f$.
+   *
+   * \throw runtime_error if the direction of a step is restricted to an
+   * acceptance (see restrict_to_acceptance()).
+   */
+  void sample(const size_t n_events, double *Phi_Theta_Psi,
+              const size_t leading_dimension);
+
+  /**
+   * \brief Sample random gamma-ray directions from the cascade with a
+   * statistical weight.
+   *
+   * All steps are sampled with ReferenceFrameSampler::sample_weighted(), i.e.
+   * no proposed direction is rejected.
+   * The weight of the cascade is the product of the weights of all steps,
+   *
+   * \f[
+   *      w = \prod_{i=0}^{n_s - 1} w_i.
+   * \f]
+   *
+   * The weight and its square are added to the running sums
+   * get_sum_of_weights() and get_sum_of_squared_weights().
+   *
+   * \return std::pair which contains \f$w\f$ and the reference frames
+   * like operator()().
+   */
+  pair<double, vector<array<double, 3>>> sample_weighted();
+
+  /**
+   * \brief Sample the reference frames of many weighted cascades at once.
+   *
+   * Same as sample(const size_t, double*, const size_t), but with
+   * ReferenceFrameSampler::sample_weighted(const size_t, double*, double*,
+   * double*, double*) for all steps.
+   *
+   * \param n_events Number of cascades \f$n\f$.
+   * \param Phi_Theta_Psi Array for the Euler angles in radians, see
+   * sample(const size_t, double*, const size_t).
+   * \param leading_dimension \f$n_\mathrm{ld}\f$.
+   * \param weights Array of length \f$n\f$ for the weights of the cascades.
+   */
+  void sample_weighted(const size_t n_events, double *Phi_Theta_Psi,
+                       const size_t leading_dimension, double *weights);
+
+  /**
+   * \brief Sample the reference frames of a cascade as rotation matrices.
+   *
+   * Same as operator()(), but the reference frames are returned as the
+   * cumulative rotation matrices \f$A_i = A_{i-1} R_i\f$, where \f$R_i\f$
+   * is the rotation matrix from ReferenceFrameSampler::sample_rotation_matrix()
+   * of step \f$i\f$.
+   * The direction of emission and the polarization plane of step \f$i\f$ are
+   * given by euler_angle_transform::direction() and
+   * euler_angle_transform::polarization_axis() of \f$A_i\f$.
+   * Neither the samplers nor the composition convert rotation matrices to
+   * Euler angles, which saves the calls of inverse trigonometric functions
+   * for each step.
+   * The sequence of random numbers is the same as for operator()(), and
+   * \f$A_i\f$ is equal to euler_angle_transform::rotation_matrix() of the
+   * Euler angles of step \f$i\f$ up to rounding errors.
+   *
+   * \return List of rotation matrices, one for each step.
+   *
+   * \throw runtime_error if the direction of a step is restricted to an
+   * acceptance (see restrict_to_acceptance()).
+   */
+  vector<euler_angle_transform::RotationMatrix> sample_rotation_matrices();
+
+  /**
+   * \brief Sample the reference frames of many cascades as rotation matrices.
+   *
+   * Block mode of sample_rotation_matrices(), like sample(const size_t,
+   * double*, const size_t).
+   *
+   * \param n_events Number of cascades \f$n\f$.
+   * \param A Array for the rotation matrices. The element with the index
+   * \f$i n_\mathrm{ld} + k\f$ is the matrix of step \f$i\f$ of cascade
+   * \f$k\f$.
+   * \param leading_dimension \f$n_\mathrm{ld} \geq n\f$.
+   *
+   * \throw runtime_error if the direction of a step is restricted to an
+   * acceptance (see restrict_to_acceptance()).
+   */
+  void sample_rotation_matrices(const size_t n_events,
+                                euler_angle_transform::RotationMatrix *A,
+                                const size_t leading_dimension);
+
+  /**
+   * \brief Sample the reference frames of a weighted cascade as rotation
+   * matrices.
+   *
+   * Same as sample_weighted(), but with rotation matrices like
+   * sample_rotation_matrices().
+   *
+   * \return std::pair which contains \f$w\f$ and the rotation matrices.
+   */
+  pair<double, vector<euler_angle_transform::RotationMatrix>>
+  sample_weighted_rotation_matrices();
+
+  /**
+   * \brief Sample the reference frames of many weighted cascades as rotation
+   * matrices.
+   *
+   * \param n_events Number of cascades \f$n\f$.
+   * \param A Array for the rotation matrices, see
+   * sample_rotation_matrices(const size_t,
+   * euler_angle_transform::RotationMatrix*, const size_t).
+   * \param leading_dimension \f$n_\mathrm{ld}\f$.
+   * \param weights Array of length \f$n\f$ for the weights of the cascades.
+   */
+  void sample_weighted_rotation_matrices(
+      const size_t n_events, euler_angle_transform::RotationMatrix *A,
+      const size_t leading_dimension, double *weights);
+
+  /**
+   * \brief Sum of the weights \f$\sum_k w_k\f$ of all weighted cascades
+   * since the construction or the last call of reset_weight_sums().
+   */
+  double get_sum_of_weights() const { return sum_of_weights; }
+
+  /**
+   * \brief Sum of the squared weights \f$\sum_k w_k^2\f$ of all weighted
+   * cascades since the construction or the last call of reset_weight_sums().
+   */
+  double get_sum_of_squared_weights() const { return sum_of_squared_weights; }
+
+  /**
+   * \brief Effective sample size of the weighted cascades.
+   *
+   * \f[
+   *      n_\mathrm{eff} = \frac{\left( \sum_k w_k \right)^2}{\sum_k w_k^2}
+   * \f]
+   *
+   * \return \f$n_\mathrm{eff}\f$, or 0 if no cascade with a nonzero weight
+   * has been sampled.
+   */
+  double get_effective_sample_size() const {
+    return sum_of_squared_weights > 0.
+               ? sum_of_weights * sum_of_weights / sum_of_squared_weights
+               : 0.;
+  }
+
+  /**
+   * \brief Set the sums of the weights and squared weights to zero.
+   */
+  void reset_weight_sums() {
+    sum_of_weights = 0.;
+    sum_of_squared_weights = 0.;
+  }
+
+  /**
+   * \brief Sample the direction of a step only inside the acceptance of a set
+   * of detectors.
+   *
+   * In the weighted modes sample_weighted() and
+   * sample_weighted_rotation_matrices(), the reference frame of the step is
+   * sampled by the AcceptanceSampler instead of the ReferenceFrameSampler of
+   * the step, given the cumulative rotation of the previous step.
+   * The weight of each cascade is multiplied by the probability that the
+   * direction of the step would have been inside the acceptance, so the sum
+   * of the weights estimates the number of cascades that reach the
+   * detectors.
+   * The angular correlation of the AcceptanceSampler should be the one of the
+   * ReferenceFrameSampler of the step, which is not called anymore (and
+   * whose statistics are not updated).
+   * The unweighted modes cannot be combined with a restriction.
+   *
+   * \param step Index of the step.
+   * \param acceptance_sampler AcceptanceSampler, or a null pointer to remove
+   * the restriction of the step.
+   *
+   * \throw out_of_range if the step does not exist.
+   */
+  void restrict_to_acceptance(const size_t step,
+                              shared_ptr<AcceptanceSampler> acceptance_sampler);
+
+  /**
+   * \brief Whether the direction of at least one step is restricted to an
+   * acceptance (see restrict_to_acceptance()).
+   */
+  bool is_restricted() const;
+
+  /**
+   * \brief Reinitialize the random number engines of all steps.
+   *
+   * The engine of step \f$i\f$ is seeded with the sequence \f$\left(
+   * s, t_\mathrm{low}, t_\mathrm{high}, i \right)\f$, where \f$s\f$ is the
+   * seed and \f$t_\mathrm{low}\f$ and \f$t_\mathrm{high}\f$ are the lower and
+   * upper 32 bits of the stream index.
+   * Different stream indices therefore give independent random number streams
+   * for the same seed.
+   * An AcceptanceSampler of step \f$i\f$ is seeded with the same sequence.
+   *
+   * \param seed Seed \f$s\f$.
+   * \param stream Stream index \f$t\f$.
+   */
+  void reseed(const unsigned int seed, const unsigned long long stream = 0);
+
+  /**
+   * \brief Number of steps of the cascade, i.e. number of reference frames
+   * per event.
+   */
+  size_t get_n_steps() const { return angular_correlation_samplers.size(); }
+
+  /**
+   * \brief Enable or disable the collection of statistics.
+   *
+   * Enables the SamplingStatistics of the samplers of all steps (see
+   * ReferenceFrameSampler::enable_statistics()), and measures the time that
+   * is spent in each step in the block modes sample() and sample_weighted()
+   * with a number of events.
+   * The clock is read twice per step and block of block_size cascades.
+   *
+   * \param enable Collect statistics (default: true).
+   */
+  void enable_statistics(const bool enable = true);
+
+  /**
+   * \brief Whether statistics are collected.
+   */
+  bool statistics_enabled() const { return collect_statistics; }
+
+  /**
+   * \brief Number of sampled cascades since statistics were enabled or reset.
+   */
+  size_t get_n_events() const { return n_events_sampled; }
+
+  /**
+   * \brief SamplingStatistics of the sampler of a step.
+   *
+   * The acceptance of step \f$i\f$ is
+   * `get_step_statistics(i).get_acceptance()`.
+   *
+   * \param i Index of the step.
+   */
+  const SamplingStatistics &get_step_statistics(const size_t i) const {
+    return angular_correlation_samplers[i]->get_statistics();
+  }
+
+  /**
+   * \brief Time in seconds that was spent in the block modes to sample the
+   * reference frames of a step, including the rotation into the frame of the
+   * previous step.
+   *
+   * \param i Index of the step.
+   */
+  double get_step_seconds(const size_t i) const { return step_seconds[i]; }
+
+  /**
+   * \brief Set all statistics of the cascade and its steps to zero.
+   */
+  void reset_statistics();
+
+  /**
+   * \brief Number of cascades that are processed at once by sample().
+   */
+  static constexpr size_t block_size = 64;
+
+  /**
+   * \brief Number of values per step and event in the block mode sample(),
+   * i.e. the three Euler angles.
+   */
+  static constexpr size_t n_components = 3;
+
 protected:
   vector<shared_ptr<ReferenceFrameSampler>>
       angular_correlation_samplers; /**< List of AngCorrRejectionSamplers which
                                        are initialized on construction with
                                        AngularCorrelation objects. */
+
+  vector<shared_ptr<AcceptanceSampler>>
+      acceptance_samplers; /**< Samplers for the steps whose direction is
+                              restricted to an acceptance, null pointers for
+                              the other steps. */
+
+  vector<double>
+      Phi_Theta_Psi_block; /**< Euler angles of a single step for a block of
+                              cascades. */
+  vector<euler_angle_transform::RotationMatrix>
+      cumulative_rotations; /**< Cumulative rotations for a block of cascades.
+                             */
+  vector<double> weight_block; /**< Weights of a single step for a block of
+                                  cascades. */
+  vector<euler_angle_transform::RotationMatrix>
+      rotation_block; /**< Rotation matrices of a single step for a block of
+                         cascades. */
+
+  bool collect_statistics = false; /**< Collect statistics. */
+  size_t n_events_sampled = 0;     /**< Number of sampled cascades. */
+  vector<double> step_seconds;     /**< Time spent in each step. */
+
+  double sum_of_weights = 0.; /**< \f$\sum_k w_k\f$ */
+  double sum_of_squared_weights = 0.; /**< \f$\sum_k w_k^2\f$ */
+
+  /**
+   * \brief Throw a runtime_error if the direction of a step is restricted to
+   * an acceptance, which requires a weighted mode.
+   */
+  void check_unrestricted() const;
+
+  /**
+   * \brief Implementation of the weighted and unweighted block modes.
+   *
+   * If weights is a null pointer, the cascades are sampled without weights.
+   */
+  void sample_block(const size_t n_events, double *Phi_Theta_Psi,
+                    const size_t leading_dimension, double *weights);
+
+  /**
+   * \brief Implementation of the weighted and unweighted block modes with
+   * rotation matrices.
+   *
+   * If weights is a null pointer, the cascades are sampled without weights.
+   */
+  void sample_block(const size_t n_events,
+                    euler_angle_transform::RotationMatrix *A,
+                    const size_t leading_dimension, double *weights);
 };
\ No newline at end of file
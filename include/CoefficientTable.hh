@@ -0,0 +1,306 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <cstdint>
+
+using std::int32_t;
+using std::uint32_t;
+using std::uint64_t;
+
+#include <functional>
+
+using std::function;
+
+#include <string>
+
+using std::string;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "State.hh"
+#include "Transition.hh"
+
+/**
+ * \brief Precomputed expansion coefficients of many angular correlations,
+ * stored in a binary file.
+ *
+ * Analyses that test the same set of cascades over and over again spend a
+ * significant fraction of their start-up time on the calculation of the
+ * expansion coefficients.
+ * The function write() stores the cascades together with the normalized
+ * coefficients \f$c_i\f$ and \f$d_i\f$ of their Legendre series (see
+ * W_gamma_gamma::get_legendre_coefficients()), which already contain the
+ * normalization factors of W_dir_dir and W_pol_dir and the sign of the
+ * polarization-dependent part.
+ * The constructor maps such a file into memory with mmap(), and the angular
+ * correlations are evaluated directly from the mapped coefficients, i.e.
+ * nothing is copied or recalculated.
+ * The mapping is read-only, therefore a table can be evaluated in several
+ * threads at once, and the operating system shares the pages of the same
+ * file between processes.
+ *
+ * The file consists of sections that are aligned to 8 bytes and stored in
+ * the byte order of the machine that wrote them:
+ *
+ * - A header of 48 bytes: the magic string `ALPACACT`, the format version
+ *   and a byte-order mark (both uint32_t), the number of entries, the total
+ *   size of the file in bytes, and the offset of the index (all uint64_t).
+ * - The index, one Entry per angular correlation.
+ * - For each entry, one QuantumNumbers record for the initial state and one
+ *   for each cascade step, followed by the coefficients \f$c_i\f$ and
+ *   \f$d_i\f$ as doubles.
+ *
+ * The constructor checks the header, the bounds of all entries and their
+ * numbers of cascade steps and coefficients, so that a truncated, corrupt or
+ * foreign file is rejected before any coefficients are read.
+ *
+ * Several processes on the same node can share a single copy of a table:
+ * the first one that needs it calculates the coefficients and writes the
+ * file, and all later ones only map it (see CoefficientTable(const string &,
+ * const function<vector<AngularCorrelation>()> &)).
+ * A file on a memory-backed file system, for example `/dev/shm`, which is
+ * the location of POSIX shared memory objects on Linux, is never written to
+ * a disk.
+ * Since write() replaces a file atomically, a process never maps a partially
+ * written table, and existing mappings of a replaced table stay valid.
+ */
+class CoefficientTable {
+public:
+  /**
+   * \brief Version of the file format written by write().
+   */
+  static constexpr uint32_t format_version = 1;
+
+  /**
+   * \brief Index entry of an angular correlation.
+   */
+  struct Entry {
+    uint64_t offset; /**< Offset of the data of the entry in bytes. */
+    uint32_t n_cascade_steps; /**< Number of cascade steps. */
+    uint32_t n_legendre_coefficients; /**< Number of coefficients \f$c_i\f$ */
+    uint32_t n_associated_legendre_coefficients; /**< Number of coefficients
+                                                    \f$d_i\f$ */
+    uint32_t reserved; /**< Unused, zero. */
+  };
+
+  /**
+   * \brief Quantum numbers of a state and the transition that populates it.
+   *
+   * For the initial state, the transition is empty.
+   */
+  struct QuantumNumbers {
+    int32_t two_J;    /**< Two times the angular momentum quantum number. */
+    int32_t parity;   /**< Parity, see Parity. */
+    int32_t em_char;  /**< Primary EM character, see EMCharacter. */
+    int32_t two_L;    /**< Two times the primary multipolarity. */
+    int32_t em_charp; /**< Secondary EM character. */
+    int32_t two_Lp;   /**< Two times the secondary multipolarity. */
+    double delta;     /**< Multipole mixing ratio. */
+  };
+
+  /**
+   * \brief Write a table of angular correlations to a file.
+   *
+   * The table is first written to a temporary file in the same directory,
+   * which is then renamed.
+   *
+   * \param file_name Name of the file. An existing file is replaced.
+   * \param angular_correlations Angular correlations.
+   *
+   * \throw runtime_error if the file can not be written.
+   */
+  static void write(const string &file_name,
+                    const vector<AngularCorrelation> &angular_correlations);
+
+  /**
+   * \brief Constructor, maps an existing file into memory.
+   *
+   * \param file_name Name of the file.
+   *
+   * \throw runtime_error if the file can not be mapped, or if it is not a
+   * valid table of the current format_version.
+   */
+  explicit CoefficientTable(const string &file_name);
+
+  /**
+   * \brief Constructor, maps a file and creates it first if it does not exist.
+   *
+   * If the file does not exist, the angular correlations are obtained from
+   * the function build and written to the file with write().
+   * Several processes may call this constructor for the same file at the
+   * same time.
+   * They synchronize with an exclusive lock (see flock()) on the file with the
+   * suffix `.lock`, which is created next to the table and not removed
+   * afterwards, so build is called only once, and all other processes wait
+   * for the file and map it.
+   *
+   * \param file_name Name of the file.
+   * \param build Function that returns the angular correlations of the
+   * table.
+   *
+   * \throw runtime_error if the lock file can not be created, or for the
+   * reasons given for write() and CoefficientTable(const string &).
+   * Exceptions of build are passed on.
+   */
+  CoefficientTable(const string &file_name,
+                   const function<vector<AngularCorrelation>()> &build);
+
+  /**
+   * \brief Destructor, unmaps the file.
+   */
+  ~CoefficientTable();
+
+  CoefficientTable(const CoefficientTable &) = delete;
+  CoefficientTable &operator=(const CoefficientTable &) = delete;
+
+  /**
+   * \brief Number of angular correlations.
+   */
+  size_t size() const { return n_entries; }
+
+  /**
+   * \brief Initial state of an entry.
+   *
+   * \param index Index of the entry.
+   *
+   * \throw out_of_range if index is not smaller than size().
+   */
+  State get_initial_state(const size_t index) const;
+
+  /**
+   * \brief Cascade steps of an entry.
+   *
+   * \param index Index of the entry.
+   *
+   * \throw out_of_range if index is not smaller than size().
+   */
+  vector<pair<Transition, State>> get_cascade_steps(const size_t index) const;
+
+  /**
+   * \brief Maximum order \f$\nu_\mathrm{max}\f$ of the Legendre expansion of
+   * an entry.
+   *
+   * \param index Index of the entry.
+   *
+   * \throw out_of_range if index is not smaller than size().
+   */
+  int get_nu_max(const size_t index) const;
+
+  /**
+   * \brief Coefficients \f$c_i\f$ of an entry.
+   *
+   * \param index Index of the entry.
+   *
+   * \return Pointer to the mapped coefficients, valid as long as the table
+   * exists. The number of coefficients is \f$\nu_\mathrm{max} / 2 + 1\f$.
+   *
+   * \throw out_of_range if index is not smaller than size().
+   */
+  const double *get_legendre_coefficients(const size_t index) const;
+
+  /**
+   * \brief Coefficients \f$d_i\f$ of an entry.
+   *
+   * \param index Index of the entry.
+   *
+   * \return Pointer to the mapped coefficients, valid as long as the table
+   * exists, or a null pointer for a dir-dir correlation.
+   * The number of coefficients is \f$\nu_\mathrm{max} / 2\f$.
+   *
+   * \throw out_of_range if index is not smaller than size().
+   */
+  const double *get_associated_legendre_coefficients(const size_t index) const;
+
+  /**
+   * \brief Evaluate an entry.
+   *
+   * \param index Index of the entry.
+   * \param theta Polar angle in radians.
+   * \param phi Azimuthal angle in radians.
+   *
+   * \return \f$W \left( \theta, \varphi \right)\f$
+   *
+   * \throw out_of_range if index is not smaller than size().
+   */
+  double operator()(const size_t index, const double theta,
+                    const double phi) const;
+
+  /**
+   * \brief Evaluate an entry for many directions at once.
+   *
+   * See AngularCorrelation::evaluate().
+   *
+   * \param index Index of the entry.
+   * \param n Number of directions.
+   * \param theta Polar angles in radians, array of length n.
+   * \param phi Azimuthal angles in radians, array of length n.
+   * \param result Array of length n for the results.
+   *
+   * \throw out_of_range if index is not smaller than size().
+   */
+  void evaluate(const size_t index, const size_t n, const double *theta,
+                const double *phi, double *result) const;
+
+  /**
+   * \brief Construct the full angular correlation of an entry.
+   *
+   * This recalculates all coefficients, which is only necessary to access
+   * the functionality of AngularCorrelation that goes beyond evaluation,
+   * like the string representation.
+   *
+   * \param index Index of the entry.
+   *
+   * \throw out_of_range if index is not smaller than size().
+   */
+  AngularCorrelation get_angular_correlation(const size_t index) const;
+
+protected:
+  /**
+   * \brief Write a table if it does not exist yet.
+   *
+   * See CoefficientTable(const string &, const
+   * function<vector<AngularCorrelation>()> &).
+   *
+   * \return file_name
+   */
+  static const string &
+  create_once(const string &file_name,
+              const function<vector<AngularCorrelation>()> &build);
+
+  const Entry &get_entry(const size_t index) const;
+  const QuantumNumbers *get_quantum_numbers(const Entry &entry) const;
+
+  const char *data;  /**< Start of the mapping. */
+  size_t file_size;  /**< Size of the mapping in bytes. */
+  size_t n_entries;  /**< Number of entries. */
+  const Entry *entries; /**< Start of the index. */
+};
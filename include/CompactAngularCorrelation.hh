@@ -0,0 +1,201 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <memory>
+
+using std::shared_ptr;
+
+#include <string>
+
+using std::string;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "State.hh"
+#include "StringRepresentable.hh"
+#include "Transition.hh"
+
+/**
+ * \brief Evaluation-only representation of an angular correlation.
+ *
+ * An AngularCorrelation object stores the full cascade and all coefficient
+ * objects (AvCoefficient, AlphavCoefficient, UvCoefficient, and the
+ * FCoefficient objects they contain), mainly to be able to create the
+ * string representation of the correlation.
+ * For the evaluation, only the normalized coefficients \f$c_i\f$ and
+ * \f$d_i\f$ of the series of Legendre polynomials
+ *
+ * \f[
+ *      W \left( \theta, \varphi \right) = \sum_{i=0}^{\nu_\mathrm{max}/2}
+ * c_i P_{2i} \left[ \cos \left( \theta \right) \right] + \cos \left(
+ * 2 \varphi \right) \sum_{i=0}^{\nu_\mathrm{max}/2 - 1} d_i
+ * P_{2i+2}^{\left| 2 \right|} \left[ \cos \left( \theta \right)
+ * \right] \f]
+ *
+ * are needed (see W_gamma_gamma::get_legendre_coefficients()), which
+ * already contain the normalization factor and the sign of the
+ * polarization-dependent part.
+ * This class stores only these coefficients in a single flat array, which
+ * makes it suitable for tables of a large number of hypotheses.
+ * For the dir-dir correlation, there are no coefficients \f$d_i\f$.
+ *
+ * Optionally, the quantum numbers of the cascade can be kept.
+ * In this case, the LaTeX string representation is rebuilt from them
+ * whenever string_representation() is called, by constructing a temporary
+ * AngularCorrelation object.
+ */
+class CompactAngularCorrelation : public StringRepresentable {
+public:
+  /**
+   * \brief Constructor from an angular correlation
+   *
+   * \param ang_cor Angular correlation.
+   * \param keep_cascade If true, keep the initial state and cascade steps to
+   * be able to rebuild the string representation (default: false).
+   */
+  CompactAngularCorrelation(const AngularCorrelation &ang_cor,
+                            const bool keep_cascade = false);
+
+  /**
+   * \brief Constructor from expansion coefficients
+   *
+   * \param legendre_coefficients Coefficients \f$c_i\f$, at least one.
+   * \param associated_legendre_coefficients Coefficients \f$d_i\f$. Either
+   * empty, or one less than \f$c_i\f$.
+   *
+   * \throw invalid_argument if the numbers of coefficients are inconsistent.
+   */
+  CompactAngularCorrelation(
+      const vector<double> &legendre_coefficients,
+      const vector<double> &associated_legendre_coefficients = {});
+
+  /**
+   * \brief Evaluate the angular correlation.
+   *
+   * \param theta Polar angle in radians.
+   * \param phi Azimuthal angle in radians.
+   *
+   * \return \f$W \left( \theta, \varphi \right)\f$
+   */
+  double operator()(const double theta, const double phi) const;
+
+  /**
+   * \brief Evaluate the angular correlation for many directions at once.
+   *
+   * See AngularCorrelation::evaluate().
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in radians, array of length n.
+   * \param phi Azimuthal angles in radians, array of length n.
+   * \param result Array of length n for the results.
+   */
+  void evaluate(const size_t n, const double *theta, const double *phi,
+                double *result) const;
+
+  /**
+   * \brief Evaluate the angular correlation for many directions, given by
+   * the cosines of their polar angles.
+   *
+   * \param n Number of directions.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param phi Azimuthal angles in radians, array of length n.
+   * \param result Array of length n for the results.
+   */
+  void evaluate_cos_theta(const size_t n, const double *cos_theta,
+                          const double *phi, double *result) const;
+
+  /**
+   * \brief Maximum order \f$\nu_\mathrm{max}\f$ of the Legendre expansion.
+   */
+  int get_nu_max() const { return 2 * ((int)n_legendre_coefficients - 1); }
+
+  /**
+   * \brief Return the coefficients \f$c_i\f$.
+   */
+  vector<double> get_legendre_coefficients() const {
+    return vector<double>(coefficients.begin(),
+                          coefficients.begin() + n_legendre_coefficients);
+  }
+
+  /**
+   * \brief Return the coefficients \f$d_i\f$, or an empty vector for a
+   * dir-dir correlation.
+   */
+  vector<double> get_associated_legendre_coefficients() const {
+    return vector<double>(coefficients.begin() + n_legendre_coefficients,
+                          coefficients.end());
+  }
+
+  /**
+   * \brief Whether the correlation depends on \f$\varphi\f$.
+   */
+  bool is_polarized() const {
+    return coefficients.size() > n_legendre_coefficients;
+  }
+
+  /**
+   * \brief Whether the quantum numbers of the cascade were kept.
+   */
+  bool has_cascade() const { return cascade != nullptr; }
+
+  /**
+   * \brief Reconstruct the full angular correlation.
+   *
+   * \return AngularCorrelation object for the cascade.
+   *
+   * \throw runtime_error if the cascade was not kept.
+   */
+  AngularCorrelation get_angular_correlation() const;
+
+  /**
+   * \brief Memory used by the object, including its heap allocations.
+   */
+  size_t get_size_in_bytes() const;
+
+  /**
+   * \brief Append the string representation of the angular correlation.
+   *
+   * The string is rebuilt from the quantum numbers of the cascade at every
+   * call, see W_gamma_gamma::write_string_representation().
+   *
+   * \throw runtime_error if the cascade was not kept.
+   */
+  void write_string_representation(
+      string &str_rep, const unsigned int n_digits = 0,
+      const vector<string> &variable_names = {}) const override;
+
+protected:
+  vector<double> coefficients; /**< \f$c_i\f$, followed by \f$d_i\f$ */
+  size_t n_legendre_coefficients; /**< Number of coefficients \f$c_i\f$ */
+  /** Initial state and cascade steps, or a null pointer. */
+  shared_ptr<const pair<State, vector<pair<Transition, State>>>> cascade;
+};
@@ -0,0 +1,294 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cmath>
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <random>
+
+using std::uniform_real_distribution;
+
+#include "EulerAngleRotation.hh"
+#include "RandomEngine.hh"
+
+/**
+ * \brief Sample the Compton scattering of linearly polarized photons, e.g. in
+ * a segmented Compton polarimeter.
+ *
+ * The polarization-direction correlations of alpaca are usually measured by
+ * detecting the azimuthal asymmetry of the Compton scattering of a photon.
+ * The present class samples the scattering angles of a photon with the energy
+ * \f$E_\gamma\f$ and the degree of linear polarization \f$P\f$ from the
+ * Klein-Nishina cross section for a free electron at rest \cite
+ * KleinNishina1929,
+ *
+ * \f[
+ *      \frac{\mathrm{d} \sigma}{\mathrm{d} \Omega} = \frac{r_e^2}{2}
+ * \varepsilon^2 \left[ \varepsilon + \frac{1}{\varepsilon} - \sin^2 \left(
+ * \theta \right) - P \sin^2 \left( \theta \right) \cos \left( 2 \varphi
+ * \right) \right], \f]
+ *
+ * where \f$r_e\f$ is the classical electron radius, \f$\theta\f$ the
+ * scattering angle, and \f$\varphi\f$ the azimuthal angle between the
+ * scattering plane and the polarization axis, i.e. the direction of the
+ * electric field vector of the photon.
+ * The ratio of the energy \f$E_\gamma^\prime\f$ of the scattered photon and
+ * \f$E_\gamma\f$ is
+ *
+ * \f[
+ *      \varepsilon = \frac{E_\gamma^\prime}{E_\gamma} = \frac{1}{1 + k \left[
+ * 1 - \cos \left( \theta \right) \right]}, \f]
+ *
+ * with \f$k = E_\gamma / m_e c^2\f$.
+ * A negative \f$P\f$ corresponds to a rotation of the polarization axis by
+ * \f$\pi / 2\f$, like in W_pol_dir::set_polarization_degree().
+ *
+ * The reference frame of the photon is given by a rotation matrix \f$A\f$
+ * like the ones of CascadeSampler::sample_rotation_matrices(): its direction
+ * is euler_angle_transform::direction() of \f$A\f$, and its polarization axis
+ * is euler_angle_transform::polarization_axis() of \f$A\f$.
+ * The direction of the scattered photon in the laboratory frame is
+ *
+ * \f[
+ *      A \left( \sin \left( \theta \right) \cos \left( \varphi \right), \sin
+ * \left( \theta \right) \sin \left( \varphi \right), \cos \left( \theta
+ * \right) \right)^T. \f]
+ *
+ * Note that alpaca does not implement pol-pol correlations (see
+ * CascadeSampler), i.e. it is up to the user to provide frames whose
+ * polarization axes are meaningful, for example the frames of the observed
+ * step of a pol-dir correlation interpreted for a polarized photon in the
+ * exit channel \cite FaggHanna1959.
+ *
+ * The scattering angle is sampled from the distribution of \f$\varepsilon\f$
+ * with the composition and rejection method of Butcher and Messel \cite
+ * ButcherMessel1960, whose efficiency is above 0.5 for all energies.
+ * For a given \f$\theta\f$, the conditional distribution of \f$\varphi\f$ is
+ * proportional to \f$1 - P \Sigma \left( \theta \right) \cos \left( 2 \varphi
+ * \right)\f$, with the analyzing power (see analyzing_power())
+ *
+ * \f[
+ *      \Sigma \left( \theta \right) = \frac{\sin^2 \left( \theta
+ * \right)}{\varepsilon + 1 / \varepsilon - \sin^2 \left( \theta \right)}
+ * \leq 1, \f]
+ *
+ * and it is sampled by rejection from a uniform distribution with an
+ * efficiency above 0.5.
+ *
+ * Expected counting rates and asymmetries, which are usually compared to the
+ * experiment, do not require sampling.
+ * The integrals of \f$\mathrm{d} \sigma / \mathrm{d} \Omega\f$ over
+ * \f$\cos \left( \theta \right)\f$ are elementary functions of \f$k\f$ (see
+ * integrate() and expected_asymmetry()).
+ * They are evaluated in closed form, which loses about
+ * \f$-3 \log_{10} \left( k \right)\f$ significant digits for small energies.
+ */
+class ComptonScatteringSampler {
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param energy \f$E_\gamma\f$ in MeV.
+   * \param seed Random number seed.
+   * \param polarization_degree \f$P \in \left[ -1, 1 \right]\f$ (default: 1).
+   *
+   * \throw invalid_argument if \f$E_\gamma \leq 0\f$, or if \f$\left| P
+   * \right| > 1\f$.
+   */
+  ComptonScatteringSampler(const double energy, const int seed,
+                           const double polarization_degree = 1.);
+
+  /**
+   * \brief Sample the scattering angles in the frame of the photon.
+   *
+   * \return \f$\left( \cos \left( \theta \right), \varphi \right)\f$, with
+   * \f$\varphi\f$ in radians.
+   */
+  array<double, 2> sample_angles() { return scatter(k); }
+
+  /**
+   * \brief Sample the scattering of a single photon.
+   *
+   * \param A Reference frame of the photon.
+   *
+   * \return Energy \f$E_\gamma^\prime\f$ of the scattered photon in MeV,
+   * \f$\cos \left( \theta \right)\f$, \f$\varphi\f$ in radians, and the
+   * three Cartesian components of the direction of the scattered photon in
+   * the laboratory frame, in this order.
+   */
+  array<double, 6> operator()(const euler_angle_transform::RotationMatrix &A);
+
+  /**
+   * \brief Sample the scattering of many photons at once.
+   *
+   * The frames may be taken directly from
+   * CascadeSampler::sample_rotation_matrices(const size_t,
+   * euler_angle_transform::RotationMatrix*, const size_t): the frames of step
+   * \f$i\f$ start at the index \f$i n_\mathrm{ld}\f$.
+   * Like FourMomentumSampler::sample(), the results are stored as a structure
+   * of arrays.
+   *
+   * \param n Number of photons \f$n\f$.
+   * \param A Array of length \f$n\f$ for the reference frames of the photons.
+   * \param energies Array of length \f$n\f$ for individual energies of the
+   * photons in MeV, for example the Doppler-shifted energies of
+   * FourMomentumSampler, or a null pointer for \f$E_\gamma\f$.
+   * \param result Array for the results. The element with the index \f$j
+   * n_\mathrm{ld} + k\f$ is the component \f$j\f$ of the return value of
+   * operator()() for photon \f$k\f$.
+   * \param leading_dimension \f$n_\mathrm{ld} \geq n\f$.
+   */
+  void sample(const size_t n, const euler_angle_transform::RotationMatrix *A,
+              const double *energies, double *result,
+              const size_t leading_dimension);
+
+  /**
+   * \brief Sample the scattering of many photons with \f$E_\gamma\f$ and
+   * \f$n_\mathrm{ld} = n\f$.
+   */
+  void sample(const size_t n, const euler_angle_transform::RotationMatrix *A,
+              double *result) {
+    sample(n, A, nullptr, result, n);
+  }
+
+  /**
+   * \brief Analyzing power \f$\Sigma \left( \theta \right)\f$ of the
+   * scattering of a completely polarized photon.
+   *
+   * \param cos_theta \f$\cos \left( \theta \right)\f$.
+   */
+  double analyzing_power(const double cos_theta) const;
+
+  /**
+   * \brief Probability that the scattering angles are inside a given range.
+   *
+   * \param cos_theta_min Lower limit \f$\cos_\mathrm{min}\f$ of \f$\cos
+   * \left( \theta \right)\f$.
+   * \param cos_theta_max Upper limit \f$\cos_\mathrm{max}\f$ of \f$\cos
+   * \left( \theta \right)\f$.
+   * \param phi_min Lower limit of \f$\varphi\f$ in radians.
+   * \param phi_max Upper limit of \f$\varphi\f$ in radians.
+   *
+   * \return Integral of \f$\mathrm{d} \sigma / \mathrm{d} \Omega\f$ over the
+   * range, divided by the total cross section.
+   *
+   * \throw invalid_argument if \f$-1 \leq \cos_\mathrm{min} \leq
+   * \cos_\mathrm{max} \leq 1\f$ does not hold for the limits of \f$\cos
+   * \left( \theta \right)\f$.
+   */
+  double integrate(const double cos_theta_min, const double cos_theta_max,
+                   const double phi_min, const double phi_max) const;
+
+  /**
+   * \brief Expected azimuthal asymmetry for detectors perpendicular and
+   * parallel to the polarization axis.
+   *
+   * For detectors which cover \f$\cos \left( \theta \right) \in \left[
+   * \cos_\mathrm{min}, \cos_\mathrm{max} \right]\f$ and the azimuthal ranges
+   * \f$\left[ \varphi_c - \Delta, \varphi_c + \Delta \right]\f$ around
+   * \f$\varphi_c = \pi / 2\f$ (\f$N_\perp\f$) and \f$\varphi_c = 0\f$
+   * (\f$N_\parallel\f$), the asymmetry is
+   *
+   * \f[
+   *      \frac{N_\perp - N_\parallel}{N_\perp + N_\parallel} = P \frac{\sin
+   * \left( 2 \Delta \right)}{2 \Delta} \frac{\int \varepsilon^2 \sin^2 \left(
+   * \theta \right) \mathrm{d} \cos \left( \theta \right)}{\int \varepsilon^2
+   * \left[ \varepsilon + 1 / \varepsilon - \sin^2 \left( \theta \right)
+   * \right] \mathrm{d} \cos \left( \theta \right)}. \f]
+   *
+   * \param cos_theta_min \f$\cos_\mathrm{min}\f$.
+   * \param cos_theta_max \f$\cos_\mathrm{max}\f$.
+   * \param half_width \f$\Delta \in \left( 0, \pi / 2 \right]\f$ in radians
+   * (default: \f$\pi / 4\f$, i.e. four quadrants).
+   *
+   * \throw invalid_argument if the limits of \f$\cos \left( \theta \right)\f$
+   * are not valid (see integrate()), or if \f$\Delta\f$ is not in the allowed
+   * range.
+   */
+  double expected_asymmetry(const double cos_theta_min,
+                            const double cos_theta_max,
+                            const double half_width = M_PI_4) const;
+
+  /**
+   * \brief Reinitialize the random number engine.
+   *
+   * Like CascadeSampler::reseed(), the engine is seeded with the sequence
+   * \f$\left( s, t_\mathrm{low}, t_\mathrm{high} \right)\f$.
+   *
+   * \param seed Seed \f$s\f$.
+   * \param stream Stream index \f$t\f$.
+   */
+  void reseed(const unsigned int seed, const unsigned long long stream = 0);
+
+  /**
+   * \brief Return \f$E_\gamma\f$ in MeV.
+   */
+  double get_energy() const { return k * electron_mass; }
+
+  /**
+   * \brief Return \f$P\f$.
+   */
+  double get_polarization_degree() const { return polarization_degree; }
+
+  /**
+   * \brief \f$m_e c^2\f$ in MeV.
+   */
+  static constexpr double electron_mass = 0.51099895000;
+
+  /**
+   * \brief Number of values per photon in the block mode sample().
+   */
+  static constexpr size_t n_components = 6;
+
+protected:
+  /**
+   * \brief Sample the scattering angles for a given \f$k\f$.
+   */
+  array<double, 2> scatter(const double k_photon);
+
+  /**
+   * \brief Integrals of \f$\varepsilon^2 \left[ \varepsilon + 1 /
+   * \varepsilon - \sin^2 \left( \theta \right) \right]\f$ and
+   * \f$\varepsilon^2 \sin^2 \left( \theta \right)\f$ over \f$\cos \left(
+   * \theta \right)\f$.
+   *
+   * \throw invalid_argument if the limits are not valid (see integrate()).
+   */
+  array<double, 2> integrate_cos_theta(const double cos_theta_min,
+                                       const double cos_theta_max) const;
+
+  double k;                   /**< \f$E_\gamma / m_e c^2\f$ */
+  double polarization_degree; /**< \f$P\f$ */
+  double total_integral; /**< Integral of \f$\mathrm{d} \sigma / \mathrm{d}
+                            \Omega\f$ over the sphere, in units of
+                            \f$r_e^2 / 2\f$. */
+  Xoshiro256PlusPlus random_engine; /**< Deterministic random number engine. */
+  uniform_real_distribution<double>
+      uniform_random; /**< Uniform distribution from which all random numbers
+                         are derived here. */
+};
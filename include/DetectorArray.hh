@@ -0,0 +1,172 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngleSet.hh"
+#include "AngularCorrelation.hh"
+
+/**
+ * \brief Precomputed geometry of an array of detectors for the evaluation of
+ * angular correlations.
+ *
+ * In a coincidence experiment with \f$N\f$ detectors, the angular correlation
+ * is needed for each ordered pair \f$\left( i, j \right)\f$ of detectors.
+ * The first detector \f$i\f$ defines the reference frame of the angular
+ * correlation, i.e. the direction of propagation (the z axis) and the
+ * polarization axis (the x axis) of the first photon.
+ * Its orientation is given by the Euler angles \f$\Phi_i\f$, \f$\Theta_i\f$,
+ * and \f$\Psi_i\f$ in the 'zxz' convention (see euler_angle_transform), like
+ * in AngularCorrelation::evaluate(const size_t, const double *, const double *,
+ * const array<double, 3>, double *) const.
+ * The second detector \f$j\f$ is located in the direction \f$\vec{r}_j =
+ * A \left( \Phi_j, \Theta_j, \Psi_j \right) \vec{e}_z\f$.
+ * The element \f$\left( i, j \right)\f$ of the coincidence matrix is
+ *
+ * \f[
+ *      W_{ij} = W_{\gamma \gamma} \left[ A^{-1} \left( \Phi_i, \Theta_i,
+ * \Psi_i \right) \vec{r}_j \right]. \f]
+ *
+ * The relative directions \f$A^{-1}_i \vec{r}_j\f$ depend only on the
+ * geometry.
+ * They are calculated once by the constructor, so that filling the
+ * \f$N \times N\f$ matrix for an angular correlation is a single call of
+ * AngularCorrelation::evaluate_cos_theta() without any transformation of
+ * coordinates.
+ * The same geometry can be reused for any number of angular correlations,
+ * for example to compare different hypotheses for a cascade.
+ * If many angular correlations are evaluated, angle_set() also precomputes
+ * the (associated) Legendre polynomials of the relative directions.
+ */
+class DetectorArray {
+
+public:
+  /**
+   * \brief Constructor
+   *
+   * The Euler angles of each detector are chosen such that the rotation
+   * matrix euler_angle_transform::rotation_matrix() turns the z axis into the
+   * direction of the detector, i.e. \f$\Theta_i = \theta_i\f$ and \f$\Psi_i
+   * = \varphi_i + \pi / 2\f$.
+   * The first Euler angle is \f$\Phi_i = \chi_i - \Psi_i\f$.
+   * For \f$\chi_i = 0\f$, this is a rotation around an axis in the xy plane,
+   * which leaves the frame of a detector on the z axis unchanged.
+   * The additional angle \f$\chi_i\f$ rotates the polarization axis around
+   * the direction of the detector, so all possible orientations of the
+   * reference frame can be described.
+   *
+   * \param theta_phi Polar and azimuthal angles of the detectors in radians.
+   * \param chi Angles \f$\chi_i\f$ of the polarization axes in radians
+   * (default: empty vector, i.e. \f$\chi_i = 0\f$ for all detectors).
+   *
+   * \throw invalid_argument if chi is not empty and its length does not match
+   * the number of detectors.
+   */
+  DetectorArray(const vector<array<double, 2>> &theta_phi,
+                const vector<double> &chi = {});
+
+  /**
+   * \brief Fill the coincidence matrix for an angular correlation.
+   *
+   * \param ang_cor Angular correlation.
+   * \param result Array of length \f$N^2\f$ for the matrix elements
+   * \f$W_{ij}\f$ in row-major order, i.e. the element \f$\left( i, j
+   * \right)\f$ is stored at the index \f$i N + j\f$.
+   */
+  void operator()(const AngularCorrelation &ang_cor, double *result) const {
+    ang_cor.evaluate_cos_theta(cos_theta.size(), cos_theta.data(), phi.data(),
+                               result);
+  }
+
+  /**
+   * \brief Fill the coincidence matrices for many angular correlations.
+   *
+   * \param ang_cors Angular correlations.
+   * \param result Array of length \f$n N^2\f$, where \f$n\f$ is the number of
+   * angular correlations. The matrix for the \f$k\f$-th angular correlation
+   * starts at the index \f$k N^2\f$ (see operator()(const AngularCorrelation
+   * &, double *) const).
+   */
+  void operator()(const vector<AngularCorrelation> &ang_cors,
+                  double *result) const;
+
+  /**
+   * \brief Precompute the (associated) Legendre polynomials of the relative
+   * directions.
+   *
+   * AngleSet::evaluate(const AngularCorrelation &, double *) const of the
+   * returned object fills the coincidence matrix in the same order as
+   * operator()(const AngularCorrelation &, double *) const, and the object can
+   * be passed to HypothesisMatrixEvaluator.
+   *
+   * \param nu_max Maximum order \f$\nu_\mathrm{max}\f$ of the angular
+   * correlations.
+   *
+   * \return Set of the \f$N^2\f$ relative directions in row-major order.
+   *
+   * \throw invalid_argument if there are no detectors, or if nu_max is
+   * negative or odd.
+   */
+  AngleSet angle_set(const int nu_max) const;
+
+  /**
+   * \brief Return the number of detectors \f$N\f$.
+   */
+  size_t get_n_detectors() const { return Phi_Theta_Psi.size(); }
+
+  /**
+   * \brief Return the Euler angles of the detectors.
+   */
+  const vector<array<double, 3>> &get_Phi_Theta_Psi() const {
+    return Phi_Theta_Psi;
+  }
+
+  /**
+   * \brief Return the cosines of the polar angles of the relative directions
+   * in row-major order.
+   */
+  const vector<double> &get_cos_theta() const { return cos_theta; }
+
+  /**
+   * \brief Return the azimuthal angles of the relative directions in
+   * row-major order.
+   */
+  const vector<double> &get_phi() const { return phi; }
+
+protected:
+  /**
+   * \brief Calculate the relative directions of all pairs of detectors.
+   */
+  void calculate_relative_directions();
+
+  vector<array<double, 3>>
+      Phi_Theta_Psi; /**< Euler angles \f$\Phi_i\f$, \f$\Theta_i\f$, and
+                        \f$\Psi_i\f$ of the detectors. */
+  vector<double> cos_theta; /**< Cosines of the polar angles of the relative
+                               directions. */
+  vector<double> phi; /**< Azimuthal angles of the relative directions. */
+};
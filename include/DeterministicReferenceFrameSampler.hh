@@ -31,6 +31,7 @@ public:
       : Phi_Theta_Psi(Phi_Theta_Psi) {}
 
   pair<unsigned int, array<double, 3>> sample() override {
+    record(1, true);
     return {1, Phi_Theta_Psi};
   }
 
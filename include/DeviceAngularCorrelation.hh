@@ -0,0 +1,224 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <cstdint>
+
+using std::uint64_t;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+
+/**
+ * \brief Batched evaluation and rejection sampling of many angular
+ * correlations on a GPU.
+ *
+ * Evaluating an angular correlation for \f$10^9\f$ directions, or sampling
+ * \f$10^8\f$ reference frames from it, is embarrassingly parallel, and the
+ * state of an angular correlation is only a few dozen doubles: its normalized
+ * expansion coefficients \f$c_i\f$ and \f$d_i\f$ (see
+ * AngularCorrelation::get_legendre_coefficients() and
+ * AngularCorrelation::get_associated_legendre_coefficients()), which already
+ * contain the normalization factors and the sign of the polarization-dependent
+ * part, and the upper limit \f$W_\mathrm{max}\f$ (see
+ * AngularCorrelation::get_upper_limit()).
+ * The constructor copies these for a list of angular correlations into a
+ * single table, which is uploaded to the device once.
+ * evaluate() and sample() have the same interface as the batch functions of
+ * the CPU code (AngularCorrelation::evaluate() and the block mode of
+ * ReferenceFrameSampler), i.e. they take and return host buffers.
+ * The buffers are transferred to and from the device in every call, and one
+ * device thread processes one argument or event with the functions in
+ * device_kernels.
+ *
+ * The backend is selected when alpaca is configured:
+ *
+ * - With the CMake option ALPACA_ENABLE_CUDA, the work is done on the current
+ * CUDA device.
+ * - Otherwise, the same kernels are executed on the host, one argument after
+ * the other.
+ * This backend produces the same results (up to the rounding differences of
+ * the mathematical functions of the device), and it allows code that uses
+ * this class to run on machines without a GPU.
+ *
+ * The events of sample() are numbered consecutively from the last call of
+ * reseed(), and the random numbers of event \f$k\f$ only depend on the seed,
+ * the stream index, and \f$k\f$ (see device_kernels::SplitMix64).
+ * The samples are therefore independent of the backend and of the number of
+ * device threads, but they differ from the ones of AngCorrRejectionSampler.
+ *
+ * The device buffers are reused between calls, so an object must not be used
+ * by several threads at the same time.
+ */
+class DeviceAngularCorrelation {
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param angular_correlations Angular correlations.
+   * \param max_trials Maximum number of candidates per event in sample()
+   * (default: 1000).
+   *
+   * \throw invalid_argument if an angular correlation has no upper limit.
+   * \throw runtime_error if the device memory can not be allocated.
+   */
+  explicit DeviceAngularCorrelation(
+      const vector<AngularCorrelation> &angular_correlations,
+      const unsigned int max_trials = 1000);
+
+  /**
+   * \brief Destructor, frees the device memory.
+   */
+  ~DeviceAngularCorrelation();
+
+  DeviceAngularCorrelation(const DeviceAngularCorrelation &) = delete;
+  DeviceAngularCorrelation &
+  operator=(const DeviceAngularCorrelation &) = delete;
+
+  /**
+   * \brief Number of angular correlations.
+   */
+  size_t size() const { return entries.size(); }
+
+  /**
+   * \brief Upper limit \f$W_\mathrm{max}\f$ of an angular correlation, which
+   * is used by sample().
+   *
+   * \param index Index of the angular correlation.
+   *
+   * \throw out_of_range if index is not smaller than size().
+   */
+  double get_upper_limit(const size_t index) const {
+    return get_entry(index).upper_limit;
+  }
+
+  /**
+   * \brief Evaluate an angular correlation for many directions.
+   *
+   * See AngularCorrelation::evaluate(const size_t, const double*, const
+   * double*, double*) const.
+   *
+   * \param index Index of the angular correlation.
+   * \param n Number of directions.
+   * \param theta Polar angles in radians, array of length n.
+   * \param phi Azimuthal angles in radians, array of length n.
+   * \param result Array of length n for the results.
+   *
+   * \throw out_of_range if index is not smaller than size().
+   * \throw runtime_error if the device reports an error.
+   */
+  void evaluate(const size_t index, const size_t n, const double *theta,
+                const double *phi, double *result);
+
+  /**
+   * \brief Sample the reference frames of many events from an angular
+   * correlation.
+   *
+   * The layout of the output is the one of the block mode of
+   * ReferenceFrameSampler, and the algorithm is the one of
+   * TypedSphereRejectionSampler (see device_kernels::sample()).
+   *
+   * \param index Index of the angular correlation.
+   * \param n Number of events.
+   * \param Phi Array of length n for the Euler angles \f$\Phi\f$ in radians.
+   * \param Theta Array of length n for the Euler angles \f$\Theta\f$ in
+   * radians.
+   * \param Psi Array of length n for the Euler angles \f$\Psi\f$ in radians.
+   *
+   * \throw out_of_range if index is not smaller than size().
+   * \throw runtime_error if the device reports an error.
+   */
+  void sample(const size_t index, const size_t n, double *Phi, double *Theta,
+              double *Psi);
+
+  /**
+   * \brief Select a new random number stream for sample().
+   *
+   * The event counter is reset to zero.
+   *
+   * \param seed Seed.
+   * \param stream Index of the stream (default: 0).
+   */
+  void reseed(const unsigned int seed, const unsigned long long stream = 0);
+
+  /**
+   * \brief Name of the backend, "CUDA" or "host".
+   */
+  static const char *get_backend();
+
+protected:
+  /**
+   * \brief Location of the coefficients of an angular correlation in the
+   * table.
+   */
+  struct Entry {
+    size_t offset;    /**< Index of \f$c_0\f$ in the table. */
+    unsigned int n_c; /**< Number of coefficients \f$c_i\f$. */
+    unsigned int n_d; /**< Number of coefficients \f$d_i\f$, which follow
+                         the \f$c_i\f$. */
+    double upper_limit; /**< \f$W_\mathrm{max}\f$ */
+  };
+
+  const Entry &get_entry(const size_t index) const;
+
+  /**
+   * \brief Backend-specific part of the constructor, which copies the
+   * coefficients to the device.
+   */
+  void upload();
+
+  /**
+   * \brief Backend-specific part of the destructor.
+   */
+  void release();
+
+  /**
+   * \brief Backend-specific part of evaluate(), called after the index check.
+   */
+  void evaluate_on_backend(const Entry &entry, const size_t n,
+                           const double *theta, const double *phi,
+                           double *result);
+
+  /**
+   * \brief Backend-specific part of sample(), called after the index check.
+   */
+  void sample_on_backend(const Entry &entry, const size_t n, double *Phi,
+                         double *Theta, double *Psi);
+
+  vector<Entry> entries;       /**< One entry per angular correlation. */
+  vector<double> coefficients; /**< Coefficients of all entries. */
+  unsigned int max_trials; /**< Maximum number of candidates per event. */
+  uint64_t seed;           /**< Seed of sample(). */
+  uint64_t stream;         /**< Stream index of sample(). */
+  uint64_t n_sampled;      /**< Number of events sampled since reseed(). */
+
+  void *device_coefficients = nullptr; /**< Copy of coefficients on the
+                                          device. */
+  void *device_buffer = nullptr;       /**< Device memory for the arguments
+                                          and results. */
+  size_t device_buffer_size = 0;       /**< Size of device_buffer in bytes. */
+};
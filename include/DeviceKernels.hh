@@ -0,0 +1,196 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cmath>
+
+#include <cstdint>
+
+using std::uint64_t;
+
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define ALPACA_HOST_DEVICE __host__ __device__
+#else
+#define ALPACA_HOST_DEVICE
+#endif
+
+/**
+ * \brief Functions for the evaluation and sampling of angular correlations
+ * that can be executed on the host as well as on a GPU.
+ *
+ * The functions operate on a single argument or event and only use the
+ * normalized expansion coefficients of an angular correlation (see
+ * AngularCorrelation::get_legendre_coefficients() and
+ * AngularCorrelation::get_associated_legendre_coefficients()), i.e. no
+ * objects, virtual functions, or dynamic memory.
+ * When they are compiled by a CUDA or HIP compiler, they are marked as
+ * `__host__ __device__`, so DeviceAngularCorrelation executes exactly the same
+ * code on every backend.
+ *
+ * The random numbers for the rejection sampling are generated by a SplitMix64
+ * generator \cite Steele2014 whose initial state is a hash of the seed, the
+ * stream index, and the index of the event.
+ * Therefore, each event can be sampled by an independent GPU thread, and the
+ * result does not depend on the order in which the events are processed.
+ */
+namespace device_kernels {
+
+/**
+ * \brief Evaluate an angular correlation.
+ *
+ * \f[
+ *      W = \sum_{i=0}^{n_c - 1} c_i P_{2i} \left( x \right) + \cos \left(
+ * 2 \varphi \right) \sum_{i=0}^{n_d - 1} d_i P_{2i+2}^{\left| 2 \right|}
+ * \left( x \right)
+ * \f]
+ *
+ * The (associated) Legendre polynomials are calculated with the recurrence
+ * relations in legendre_series.
+ *
+ * \param n_c Number of coefficients \f$c_i\f$.
+ * \param c Coefficients \f$c_i\f$.
+ * \param n_d Number of coefficients \f$d_i\f$, zero for a dir-dir
+ * correlation.
+ * \param d Coefficients \f$d_i\f$.
+ * \param x \f$\cos \left( \theta \right)\f$
+ * \param cos_2phi \f$\cos \left( 2 \varphi \right)\f$
+ *
+ * \return \f$W\f$
+ */
+ALPACA_HOST_DEVICE inline double evaluate(const unsigned int n_c,
+                                          const double *c,
+                                          const unsigned int n_d,
+                                          const double *d, const double x,
+                                          const double cos_2phi) {
+  double p_previous = 1., p = x;
+  double result = c[0];
+  for (unsigned int i = 1; i < n_c; ++i) {
+    for (unsigned int l = 2 * i; l < 2 * i + 2; ++l) {
+      const double p_next =
+          ((2. * l - 1.) * x * p - (l - 1.) * p_previous) / l;
+      p_previous = p;
+      p = p_next;
+    }
+    result += c[i] * p_previous;
+  }
+
+  if (n_d == 0) {
+    return result;
+  }
+
+  // P_1^2 = 0 and P_2^2.
+  double q_previous = 0., q = 3. * (1. - x * x);
+  double sum = d[0] * q;
+  for (unsigned int i = 1; i < n_d; ++i) {
+    for (unsigned int l = 2 * i + 1; l < 2 * i + 3; ++l) {
+      const double q_next =
+          ((2. * l - 1.) * x * q - (l + 1.) * q_previous) / (l - 2.);
+      q_previous = q;
+      q = q_next;
+    }
+    sum += d[i] * q;
+  }
+
+  return result + cos_2phi * sum;
+}
+
+/**
+ * \brief Finalizer of the SplitMix64 generator, a bijective hash function.
+ */
+ALPACA_HOST_DEVICE inline uint64_t mix(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/**
+ * \brief SplitMix64 random number generator.
+ */
+struct SplitMix64 {
+  /**
+   * \brief Constructor
+   *
+   * \param seed Seed.
+   * \param stream Index of the random number stream.
+   * \param event Index of the event.
+   */
+  ALPACA_HOST_DEVICE SplitMix64(const uint64_t seed, const uint64_t stream,
+                                const uint64_t event)
+      : state(mix(mix(mix(seed) ^ stream) ^ event)) {}
+
+  /**
+   * \brief Uniform random number in \f$\left[ 0, 1 \right)\f$ with 53 random
+   * bits.
+   */
+  ALPACA_HOST_DEVICE double uniform() {
+    state += 0x9e3779b97f4a7c15ULL;
+    return (mix(state) >> 11) * (1. / 9007199254740992.);
+  }
+
+  uint64_t state; /**< State of the generator. */
+};
+
+/**
+ * \brief Sample the Euler angles of a reference frame from an angular
+ * correlation by rejection sampling.
+ *
+ * Each candidate consumes four uniform random numbers, which are used in the
+ * same way as in TypedSphereRejectionSampler: \f$\cos \left( \theta \right)
+ * = 2 u_0 - 1\f$, \f$\varphi = 2 \pi u_1\f$, \f$W_\mathrm{rand} = u_2
+ * W_\mathrm{max}\f$, and \f$\Phi = 2 \pi u_3\f$.
+ * The accepted direction is converted with
+ * euler_angle_transform::from_spherical().
+ * If no candidate is accepted after max_trials trials, the Euler angles
+ * \f$\left( 0, 0, 0 \right)\f$ are returned.
+ *
+ * \param n_c Number of coefficients \f$c_i\f$.
+ * \param c Coefficients \f$c_i\f$.
+ * \param n_d Number of coefficients \f$d_i\f$.
+ * \param d Coefficients \f$d_i\f$.
+ * \param upper_limit \f$W_\mathrm{max}\f$
+ * \param max_trials Maximum number of candidates.
+ * \param random_engine Random number generator of the event.
+ * \param Phi Sampled \f$\Phi\f$ in radians.
+ * \param Theta Sampled \f$\Theta\f$ in radians.
+ * \param Psi Sampled \f$\Psi\f$ in radians.
+ */
+ALPACA_HOST_DEVICE inline void
+sample(const unsigned int n_c, const double *c, const unsigned int n_d,
+       const double *d, const double upper_limit,
+       const unsigned int max_trials, SplitMix64 &random_engine, double &Phi,
+       double &Theta, double &Psi) {
+  for (unsigned int i = 0; i < max_trials; ++i) {
+    const double cos_theta = 2. * random_engine.uniform() - 1.;
+    const double phi = 2. * M_PI * random_engine.uniform();
+    const double w_rand = random_engine.uniform() * upper_limit;
+    const double Phi_rand = 2. * M_PI * random_engine.uniform();
+    if (w_rand <= evaluate(n_c, c, n_d, d, cos_theta, cos(2. * phi))) {
+      Phi = Phi_rand;
+      Theta = acos(cos_theta);
+      Psi = 0.5 * M_PI - phi;
+      return;
+    }
+  }
+  Phi = 0.;
+  Theta = 0.;
+  Psi = 0.;
+}
+
+} // namespace device_kernels
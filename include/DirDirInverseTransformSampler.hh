@@ -0,0 +1,197 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+#pragma once
+
+#include <cmath>
+
+#include <random>
+
+using std::mt19937;
+using std::uniform_real_distribution;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "ReferenceFrameSampler.hh"
+#include "W_dir_dir.hh"
+
+/**
+ * \brief Sample directions from a dir-dir correlation by inverting its
+ * cumulative distribution function.
+ *
+ * A dir-dir correlation (see W_dir_dir) does not depend on the azimuthal angle
+ * \f$\varphi\f$, and it is a finite series of Legendre polynomials in \f$x =
+ * \cos \left( \theta \right)\f$:
+ *
+ * \f[
+ *      W \left( x \right) = \sum_{i=0}^{\nu_\mathrm{max}/2} c_i P_{2i} \left(
+ * x \right). \f]
+ *
+ * Using the relation \f$\left( 2l + 1 \right) P_l = P_{l+1}^\prime -
+ * P_{l-1}^\prime\f$ and \f$P_l \left( -1 \right) = \left( -1 \right)^l\f$
+ * [see, e.g., Eqs. (14.10.5) and (14.7.17) in \cite DLMF2020], the cumulative
+ * distribution function of \f$x\f$ is also a polynomial:
+ *
+ * \f[
+ *      F \left( x \right) = \frac{1}{2 c_0} \left\{ c_0 \left( x + 1 \right) +
+ * \sum_{i=1}^{\nu_\mathrm{max}/2} \frac{c_i}{4 i + 1} \left[ P_{2i+1} \left( x
+ * \right) - P_{2i-1} \left( x \right) \right] \right\}. \f]
+ *
+ * For a uniformly distributed random number \f$u \in \left[ 0, 1 \right]\f$,
+ * the equation \f$F \left( x \right) = u\f$ is solved with Newton's method.
+ * Steps that would leave the current bracket of the solution are replaced by
+ * bisection steps, which guarantees convergence because \f$F\f$ is monotonic.
+ * The iteration stops when the bracket or the Newton step is smaller than
+ * DirDirInverseTransformSampler::x_tolerance (see
+ * DirDirInverseTransformSampler::solve_monotonic()).
+ * The azimuthal angle is sampled from a uniform distribution.
+ *
+ * In contrast to AngCorrRejectionSampler, every draw is accepted, i.e. the
+ * number of tries reported by sample() is always 1.
+ * The first Euler angle is sampled in the same way as in
+ * SphereRejectionSampler, so this class can replace an AngCorrRejectionSampler
+ * in a CascadeSampler.
+ */
+class DirDirInverseTransformSampler : public ReferenceFrameSampler {
+
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param w \f$W \left( \theta \right)\f$, dir-dir correlation
+   * \param seed Random number seed.
+   *
+   * \throw invalid_argument if w is not a dir-dir correlation.
+   */
+  DirDirInverseTransformSampler(const AngularCorrelation &w, const int seed);
+
+  /**
+   * \brief Sample a random reference frame.
+   *
+   * \return std::pair which contains the number of tries, which is always 1,
+   * and the reference frame \f$\left( \Phi_\mathrm{rand},
+   * \Theta_\mathrm{rand}, \Psi_\mathrm{rand}\right)\f$.
+   */
+  pair<unsigned int, array<double, 3>> sample() override;
+
+  void reseed(seed_seq &seq) override;
+
+  /**
+   * \brief Invert the cumulative distribution function.
+   *
+   * \param u \f$u \in \left[ 0, 1 \right]\f$.
+   *
+   * \return \f$x\f$ with \f$F \left( x \right) = u\f$.
+   */
+  double inverse_cdf(const double u) const;
+
+  /**
+   * \brief Cumulative distribution function.
+   *
+   * \param x \f$x \in \left[ -1, 1 \right]\f$.
+   *
+   * \return \f$F \left( x \right)\f$.
+   */
+  double cdf(const double x) const;
+
+  /**
+   * \brief Absolute tolerance for the solution \f$x\f$ of \f$F \left( x
+   * \right) = u\f$.
+   */
+  static constexpr double x_tolerance = 1e-13;
+
+protected:
+  /**
+   * \brief Constructor for derived classes, which sample the polar angle from
+   * the dir-dir part of a more general correlation.
+   *
+   * \param w_dir_dir Dir-dir correlation.
+   * \param seed Random number seed.
+   */
+  DirDirInverseTransformSampler(const W_dir_dir &w_dir_dir, const int seed);
+
+  /**
+   * \brief Solve \f$f \left( x \right) = y\f$ for a monotonically increasing
+   * function \f$f\f$.
+   *
+   * Newton's method is used, and steps that would leave the current bracket
+   * \f$\left[ x_\mathrm{low}, x_\mathrm{high} \right]\f$ of the solution
+   * are replaced by bisection steps.
+   *
+   * \param f_df Function that returns \f$f \left( x \right)\f$ and
+   * \f$f^\prime \left( x \right)\f$.
+   * \param y \f$y\f$.
+   * \param x_low Lower limit of the interval that contains the solution.
+   * \param x_high Upper limit of the interval that contains the solution.
+   * \param x Start value.
+   *
+   * \return \f$x\f$ with \f$f \left( x \right) = y\f$ up to
+   * DirDirInverseTransformSampler::x_tolerance.
+   */
+  template <typename F>
+  static double solve_monotonic(F f_df, const double y, double x_low,
+                                double x_high, double x) {
+    for (unsigned int i = 0; i < 200; ++i) {
+      const pair<double, double> f_df_x = f_df(x);
+      const double residual = f_df_x.first - y;
+
+      if (residual > 0.) {
+        x_high = x;
+      } else {
+        x_low = x;
+      }
+
+      double x_new = f_df_x.second > 0. ? x - residual / f_df_x.second
+                                        : 0.5 * (x_low + x_high);
+      if (x_new <= x_low || x_new >= x_high) {
+        x_new = 0.5 * (x_low + x_high);
+      }
+
+      if (fabs(x_new - x) < x_tolerance || x_high - x_low < x_tolerance) {
+        return x_new;
+      }
+      x = x_new;
+    }
+
+    return x;
+  }
+
+  /**
+   * \brief Evaluate the cumulative distribution function and the probability
+   * density.
+   *
+   * \param x \f$x \in \left[ -1, 1 \right]\f$.
+   *
+   * \return \f$F \left( x \right)\f$ and \f$F^\prime \left( x \right)\f$.
+   */
+  pair<double, double> cdf_and_pdf(const double x) const;
+
+  vector<double> coefficients; /**< Coefficients \f$c_i / c_0\f$. */
+
+  mt19937 random_engine; /**< Deterministic random number engine. */
+  uniform_real_distribution<double>
+      uniform_random; /**< Uniform distribution from which all random numbers
+                         are derived here. */
+};
@@ -25,6 +25,10 @@ using std::array;
 
 #include <cmath>
 
+#include <cstddef>
+
+using std::size_t;
+
 #include <gsl/gsl_blas.h>
 
 /**
@@ -128,46 +132,146 @@ using std::array;
  * For the representation and manipulation of vectors and matrices, this class
  * uses GSL \cite Galassi2009 and its BLAS \cite Lawson1979 \cite Dongarra1988
  * \cite Dongarra1990 interface.
+ * In addition, there are allocation-free versions of the basic operations
+ * which work on the fixed-size type euler_angle_transform::RotationMatrix.
  *
  */
 namespace euler_angle_transform {
 
-inline void rotation_matrix(gsl_matrix *A, gsl_vector *Phi_Theta_Psi) {
+/**
+ * \brief Rotation matrix \f$A\f$ with a fixed size.
+ *
+ * The first index denotes the row and the second one the column of the matrix.
+ * In contrast to a gsl_matrix, objects of this type live on the stack, so
+ * composing rotations and applying them to vectors does not allocate memory.
+ * This is relevant for the samplers, which perform a few of these operations
+ * for each event.
+ */
+typedef array<array<double, 3>, 3> RotationMatrix;
 
-  const double cos_phi{cos(gsl_vector_get(Phi_Theta_Psi, 0))},
-      sin_phi{sin(gsl_vector_get(Phi_Theta_Psi, 0))},
-      cos_the{cos(gsl_vector_get(Phi_Theta_Psi, 1))},
-      sin_the{sin(gsl_vector_get(Phi_Theta_Psi, 1))},
-      cos_psi{cos(gsl_vector_get(Phi_Theta_Psi, 2))},
-      sin_psi{sin(gsl_vector_get(Phi_Theta_Psi, 2))};
-
-  gsl_matrix_set(A, 0, 0, cos_psi * cos_phi - sin_psi * cos_the * sin_phi);
-  gsl_matrix_set(A, 0, 1, -cos_psi * sin_phi - sin_psi * cos_the * cos_phi);
-  gsl_matrix_set(A, 0, 2, sin_psi * sin_the);
-  gsl_matrix_set(A, 1, 0, sin_psi * cos_phi + cos_psi * cos_the * sin_phi);
-  gsl_matrix_set(A, 1, 1, cos_psi * cos_the * cos_phi - sin_psi * sin_phi);
-  gsl_matrix_set(A, 1, 2, -cos_psi * sin_the);
-  gsl_matrix_set(A, 2, 0, sin_the * sin_phi);
-  gsl_matrix_set(A, 2, 1, sin_the * cos_phi);
-  gsl_matrix_set(A, 2, 2, cos_the);
-};
+/**
+ * \brief Rotation matrix \f$A \left( \Phi, \Theta, \Psi \right)\f$ for a
+ * given set of Euler angles.
+ *
+ * \param Phi_Theta_Psi Euler angles in radians.
+ *
+ * \return Rotation matrix.
+ */
+inline RotationMatrix rotation_matrix(const array<double, 3> Phi_Theta_Psi) {
 
-inline void angles(gsl_vector *Phi_Theta_Psi, const gsl_matrix *A) {
-  gsl_vector_set(Phi_Theta_Psi, 1, acos(gsl_matrix_get(A, 2, 2)));
-  if (fabs(gsl_matrix_get(A, 2, 2)) == 1.0) {
+  const double cos_phi{cos(Phi_Theta_Psi[0])}, sin_phi{sin(Phi_Theta_Psi[0])},
+      cos_the{cos(Phi_Theta_Psi[1])}, sin_the{sin(Phi_Theta_Psi[1])},
+      cos_psi{cos(Phi_Theta_Psi[2])}, sin_psi{sin(Phi_Theta_Psi[2])};
+
+  return {array<double, 3>{cos_psi * cos_phi - sin_psi * cos_the * sin_phi,
+                           -cos_psi * sin_phi - sin_psi * cos_the * cos_phi,
+                           sin_psi * sin_the},
+          array<double, 3>{sin_psi * cos_phi + cos_psi * cos_the * sin_phi,
+                           cos_psi * cos_the * cos_phi - sin_psi * sin_phi,
+                           -cos_psi * sin_the},
+          array<double, 3>{sin_the * sin_phi, sin_the * cos_phi, cos_the}};
+}
+
+/**
+ * \brief Euler angles of a given rotation matrix.
+ *
+ * Since the reconstruction of Euler angles from a matrix is not unique, the
+ * result may differ from the angles that were used to create the matrix, but
+ * they describe the same rotation.
+ *
+ * \param A Rotation matrix.
+ *
+ * \return Euler angles \f$\Phi\f$, \f$\Theta\f$, and \f$\Psi\f$ in radians.
+ */
+inline array<double, 3> angles(const RotationMatrix &A) {
+  if (fabs(A[2][2]) == 1.0) {
     // If the angle Theta is zero, that means the entire transformation consists
     // of two rotations around the z axis. In this case, only the difference
     // between Phi and Psi is fixed, but not their absolute values. Here, set
     // Psi arbitrarily and obtain Phi from the matrix element (0,1). The matrix
     // element to obtain Phi from must be one that contains a sine, because
     // otherwise the sign of the angle cannot be reconstructed.
-    gsl_vector_set(Phi_Theta_Psi, 0, asin(-gsl_matrix_get(A, 0, 1)));
-    gsl_vector_set(Phi_Theta_Psi, 2, 0.);
-  } else {
-    gsl_vector_set(Phi_Theta_Psi, 0,
-                   atan2(gsl_matrix_get(A, 2, 0), gsl_matrix_get(A, 2, 1)));
-    gsl_vector_set(Phi_Theta_Psi, 2,
-                   atan2(gsl_matrix_get(A, 0, 2), -gsl_matrix_get(A, 1, 2)));
+    return {asin(-A[0][1]), acos(A[2][2]), 0.};
+  }
+  return {atan2(A[2][0], A[2][1]), acos(A[2][2]), atan2(A[0][2], -A[1][2])};
+}
+
+/**
+ * \brief Product \f$A B\f$ of two rotation matrices.
+ *
+ * The product corresponds to a rotation by \f$B\f$ followed by a rotation by
+ * \f$A\f$.
+ */
+constexpr RotationMatrix multiply(const RotationMatrix &A,
+                                  const RotationMatrix &B) {
+  RotationMatrix AB{};
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      for (size_t k = 0; k < 3; ++k) {
+        AB[i][j] += A[i][k] * B[k][j];
+      }
+    }
+  }
+  return AB;
+}
+
+/**
+ * \brief Transpose \f$A^T\f$ of a rotation matrix, which is identical to the
+ * inverse \f$A^{-1}\f$.
+ */
+constexpr RotationMatrix transpose(const RotationMatrix &A) {
+  RotationMatrix AT{};
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      AT[i][j] = A[j][i];
+    }
+  }
+  return AT;
+}
+
+/**
+ * \brief Apply a rotation matrix to a vector.
+ *
+ * \param A Rotation matrix.
+ * \param x_y_z Cartesian vector.
+ *
+ * \return Rotated vector \f$A v\f$.
+ */
+constexpr array<double, 3> apply(const RotationMatrix &A,
+                                 const array<double, 3> &x_y_z) {
+  array<double, 3> xp_yp_zp{};
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      xp_yp_zp[i] += A[i][j] * x_y_z[j];
+    }
+  }
+  return xp_yp_zp;
+}
+
+inline void rotation_matrix(gsl_matrix *A, gsl_vector *Phi_Theta_Psi) {
+
+  const RotationMatrix A_array = rotation_matrix(array<double, 3>{
+      gsl_vector_get(Phi_Theta_Psi, 0), gsl_vector_get(Phi_Theta_Psi, 1),
+      gsl_vector_get(Phi_Theta_Psi, 2)});
+
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      gsl_matrix_set(A, i, j, A_array[i][j]);
+    }
+  }
+};
+
+inline void angles(gsl_vector *Phi_Theta_Psi, const gsl_matrix *A) {
+  RotationMatrix A_array;
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      A_array[i][j] = gsl_matrix_get(A, i, j);
+    }
+  }
+
+  const array<double, 3> Phi_Theta_Psi_array = angles(A_array);
+  for (size_t i = 0; i < 3; ++i) {
+    gsl_vector_set(Phi_Theta_Psi, i, Phi_Theta_Psi_array[i]);
   }
 }
 
@@ -183,42 +287,8 @@ inline void rotate(gsl_vector *xp_yp_zp, gsl_vector *Phi_Theta_Psi,
 
 inline array<double, 3> rotate(array<double, 3> Phi_Theta_Psi_reference,
                                array<double, 3> Phi_Theta_Psi) {
-  gsl_vector *Phi_Theta_Psi_reference_gsl = gsl_vector_alloc(3);
-  gsl_vector_set(Phi_Theta_Psi_reference_gsl, 0, Phi_Theta_Psi_reference[0]);
-  gsl_vector_set(Phi_Theta_Psi_reference_gsl, 1, Phi_Theta_Psi_reference[1]);
-  gsl_vector_set(Phi_Theta_Psi_reference_gsl, 2, Phi_Theta_Psi_reference[2]);
-  gsl_matrix *Phi_Theta_Psi_reference_matrix = gsl_matrix_alloc(3, 3);
-  gsl_vector *Phi_Theta_Psi_gsl = gsl_vector_alloc(3);
-  gsl_vector_set(Phi_Theta_Psi_gsl, 0, Phi_Theta_Psi[0]);
-  gsl_vector_set(Phi_Theta_Psi_gsl, 1, Phi_Theta_Psi[1]);
-  gsl_vector_set(Phi_Theta_Psi_gsl, 2, Phi_Theta_Psi[2]);
-  gsl_matrix *Phi_Theta_Psi_matrix = gsl_matrix_alloc(3, 3);
-  gsl_matrix *cumulative_rotation_matrix = gsl_matrix_alloc(3, 3);
-  gsl_vector *Phi_Theta_Psi_cumulative = gsl_vector_alloc(3);
-
-  rotation_matrix(Phi_Theta_Psi_reference_matrix, Phi_Theta_Psi_reference_gsl);
-  rotation_matrix(Phi_Theta_Psi_matrix, Phi_Theta_Psi_gsl);
-
-  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0,
-                 Phi_Theta_Psi_reference_matrix, Phi_Theta_Psi_matrix, 0.,
-                 cumulative_rotation_matrix);
-
-  angles(Phi_Theta_Psi_cumulative, cumulative_rotation_matrix);
-
-  array<double, 3> result{
-      gsl_vector_get(Phi_Theta_Psi_cumulative, 0),
-      gsl_vector_get(Phi_Theta_Psi_cumulative, 1),
-      gsl_vector_get(Phi_Theta_Psi_cumulative, 2),
-  };
-
-  gsl_vector_free(Phi_Theta_Psi_reference_gsl);
-  gsl_matrix_free(Phi_Theta_Psi_reference_matrix);
-  gsl_vector_free(Phi_Theta_Psi_gsl);
-  gsl_matrix_free(Phi_Theta_Psi_matrix);
-  gsl_matrix_free(cumulative_rotation_matrix);
-  gsl_vector_free(Phi_Theta_Psi_cumulative);
-
-  return result;
+  return angles(multiply(rotation_matrix(Phi_Theta_Psi_reference),
+                         rotation_matrix(Phi_Theta_Psi)));
 }
 
 inline void rotate_back(gsl_vector *x_y_z, gsl_vector *Phi_Theta_Psi,
@@ -251,7 +321,7 @@ inline void rotate_back(gsl_vector *x_y_z, gsl_vector *Phi_Theta_Psi,
  * @return array<double, 3> One possible set of Euler angles to rotate the z
  * axis into the given vector in spherical coordinates.
  */
-inline array<double, 3> from_spherical(const array<double, 2> theta_phi,
+constexpr array<double, 3> from_spherical(const array<double, 2> theta_phi,
                                        const double Phi = 0.) {
   return {Phi, theta_phi[0], M_PI_2 - theta_phi[1]};
 }
@@ -265,8 +335,84 @@ inline array<double, 3> from_spherical(const array<double, 2> theta_phi,
  * @return array<double, 2> Polar and azimuthal angle of the z axis after
  * rotation by three Euler angles in radians.
  */
-inline array<double, 2> to_spherical(const array<double, 3> Phi_Theta_Psi) {
+constexpr array<double, 2> to_spherical(const array<double, 3> Phi_Theta_Psi) {
   return {Phi_Theta_Psi[1], M_PI_2 - Phi_Theta_Psi[2]};
 }
 
+/**
+ * \brief Rotation matrix for the Euler angles from_spherical(), given the
+ * cosine of the polar angle.
+ *
+ * Gives the same result as
+ *
+ * ```
+ * rotation_matrix(from_spherical({acos(cos_theta), phi}, Phi))
+ * ```
+ *
+ * but calculates \f$\sin \left( \theta \right) = \sqrt{1 - \cos^2 \left(
+ * \theta \right)}\f$ instead of calling \f$\arccos\f$, \f$\sin\f$, and
+ * \f$\cos\f$.
+ * This is useful for samplers which sample \f$\cos \left( \theta \right)\f$
+ * directly.
+ *
+ * \param cos_theta \f$\cos \left( \theta \right)\f$
+ * \param phi Azimuthal angle \f$\varphi\f$ in spherical coordinates in
+ * radians.
+ * \param Phi Euler angle for the first rotation around the z axis in radians.
+ *
+ * \return Rotation matrix.
+ */
+inline RotationMatrix rotation_matrix_from_spherical(const double cos_theta,
+                                                     const double phi,
+                                                     const double Phi = 0.) {
+  // With Psi = pi/2 - phi, cos(Psi) = sin(phi) and sin(Psi) = cos(phi).
+  const double sin_the{sqrt(fmax(0., 1. - cos_theta * cos_theta))},
+      cos_psi{sin(phi)}, sin_psi{cos(phi)}, cos_phi{cos(Phi)}, sin_phi{sin(Phi)};
+  return {array<double, 3>{cos_psi * cos_phi - sin_psi * cos_theta * sin_phi,
+                           -cos_psi * sin_phi - sin_psi * cos_theta * cos_phi,
+                           sin_psi * sin_the},
+          array<double, 3>{sin_psi * cos_phi + cos_psi * cos_theta * sin_phi,
+                           cos_psi * cos_theta * cos_phi - sin_psi * sin_phi,
+                           -cos_psi * sin_the},
+          array<double, 3>{sin_the * sin_phi, sin_the * cos_phi, cos_theta}};
+}
+
+/**
+ * \brief Image \f$A \left( 0, 0, 1 \right)^T\f$ of the z axis under a
+ * rotation, i.e. the direction of emission of a gamma ray whose reference
+ * frame is described by \f$A\f$.
+ *
+ * Note that for \f$A\f$ = rotation_matrix(from_spherical({\f$\theta\f$,
+ * \f$\varphi\f$})), this is the vector with the polar angle \f$\theta\f$ and
+ * the azimuthal angle \f$-\varphi\f$, i.e. the mirror image of the vector
+ * given by to_spherical() with respect to the xz plane.
+ * Since \f$W \left( \theta, \varphi \right) = W \left( \theta, -\varphi
+ * \right)\f$ for all angular correlations, both have the same distribution.
+ * The composition of rotations in CascadeSampler refers to the image of the z
+ * axis.
+ *
+ * \param A Rotation matrix.
+ *
+ * \return Cartesian unit vector.
+ */
+constexpr array<double, 3> direction(const RotationMatrix &A) {
+  return {A[0][2], A[1][2], A[2][2]};
+}
+
+/**
+ * \brief Image \f$A \left( 1, 0, 0 \right)^T\f$ of the x axis under a
+ * rotation.
+ *
+ * The polarization of a gamma ray in a W_pol_dir correlation is measured with
+ * respect to the xz plane.
+ * Together with direction(), this vector spans the rotated polarization plane.
+ *
+ * \param A Rotation matrix.
+ *
+ * \return Cartesian unit vector which is perpendicular to direction().
+ */
+constexpr array<double, 3> polarization_axis(const RotationMatrix &A) {
+  return {A[0][0], A[1][0], A[2][0]};
+}
+
 }; // namespace euler_angle_transform
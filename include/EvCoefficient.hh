@@ -98,4 +98,6 @@ protected:
 
   const FCoefficient constant_f_coefficient, linear_f_coefficient,
       quadratic_f_coefficient;
+
+  double constant_coefficient, linear_coefficient, quadratic_coefficient;
 };
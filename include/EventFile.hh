@@ -0,0 +1,399 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <algorithm>
+
+using std::min;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <cstdint>
+
+using std::uint32_t;
+using std::uint64_t;
+
+#include <fstream>
+
+using std::ofstream;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <string>
+
+using std::string;
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * \brief Columnar binary file format for large numbers of sampled events.
+ *
+ * Offline analyses, for example the folding of sampled cascades with the
+ * response of a detector, need many millions of events, which are too large
+ * for text files.
+ * An event file stores events in the structure-of-arrays layout of the block
+ * mode of CascadeSampler and FourMomentumSampler: an event consists of
+ * \f$n_v\f$ components (for example, three Euler angles or the four
+ * components of a four momentum) for each of the \f$n_s\f$ steps of a
+ * cascade, and optionally a statistical weight.
+ * Each of these \f$n_\mathrm{col} = n_v n_s\f$ (+1 with weights) values is a
+ * column of the file.
+ *
+ * The events are grouped into chunks of \f$n_c\f$ events.
+ * A chunk contains the \f$n_c\f$ values of column 0, followed by the
+ * \f$n_c\f$ values of column 1, and so on, where column \f$n_v i + j\f$ is
+ * component \f$j\f$ of step \f$i\f$, and the weights are the last column.
+ * In other words, a chunk is exactly the array that the block mode of a
+ * sampler fills with a leading dimension of \f$n_c\f$.
+ * The last chunk is padded with zeros to the full length.
+ * The whole data section is therefore an array of doubles with the shape
+ * \f$\left( n_\mathrm{chunks}, n_\mathrm{col}, n_c \right)\f$ in C order,
+ * which can be mapped into memory without any conversion, for example as a
+ * NumPy array with numpy.memmap (see python/alpaca/event_file.py).
+ *
+ * The file consists of a header of 64 bytes and the data section.
+ * The header contains the magic string `ALPACAEV`, the format version, a
+ * byte-order mark, \f$n_s\f$, \f$n_v\f$, and a flag for the weights (all
+ * uint32_t), followed by a reserved uint32_t, \f$n_c\f$, the number of events,
+ * the total size of the file in bytes, and the offset of the data section
+ * (all uint64_t).
+ * All values are stored in the byte order of the machine that wrote them.
+ *
+ * The data are not compressed, because compressed chunks could not be mapped
+ * into memory.
+ */
+namespace event_file {
+
+/**
+ * \brief Version of the file format.
+ */
+constexpr uint32_t format_version = 1;
+
+/**
+ * \brief Header of an event file.
+ */
+struct Header {
+  char magic[8];       /**< `ALPACAEV` */
+  uint32_t version;    /**< Format version. */
+  uint32_t byte_order; /**< Byte-order mark 0x01020304. */
+  uint32_t n_steps;    /**< \f$n_s\f$, number of steps. */
+  uint32_t n_components; /**< \f$n_v\f$, number of components per step. */
+  uint32_t weighted;     /**< 1 if the last column contains weights. */
+  uint32_t reserved;     /**< Unused, zero. */
+  uint64_t chunk_size;   /**< \f$n_c\f$, number of events per chunk. */
+  uint64_t n_events;     /**< Number of events. */
+  uint64_t file_size;    /**< Size of the file in bytes. */
+  uint64_t data_offset;  /**< Offset of the first chunk in bytes. */
+};
+
+} // namespace event_file
+
+/**
+ * \brief Write events to an event file.
+ *
+ * The writer collects events in a buffer of one chunk, which is written to
+ * the file with a single call as soon as it is full.
+ * The block mode of a sampler can fill the buffer directly (sample() and
+ * sample_weighted()), so events go from the sampler to the disk without
+ * intermediate copies.
+ * The header is completed by close(), which is also called by the destructor.
+ * See event_file for a description of the format.
+ */
+class EventFileWriter {
+public:
+  /**
+   * \brief Constructor, creates the file.
+   *
+   * \param file_name Name of the file. An existing file is overwritten.
+   * \param n_steps \f$n_s\f$, number of steps per event.
+   * \param n_components \f$n_v\f$, number of components per step, for
+   * example CascadeSampler::n_components.
+   * \param weighted Whether each event has a weight (default: false).
+   * \param chunk_size \f$n_c\f$, number of events per chunk (default: 65536).
+   *
+   * \throw invalid_argument if n_steps, n_components, or chunk_size is zero.
+   * \throw runtime_error if the file can not be opened.
+   */
+  EventFileWriter(const string &file_name, const size_t n_steps,
+                  const size_t n_components, const bool weighted = false,
+                  const size_t chunk_size = 65536);
+
+  /**
+   * \brief Destructor, calls close().
+   *
+   * Errors are ignored. Call close() explicitly to detect them.
+   */
+  ~EventFileWriter();
+
+  EventFileWriter(const EventFileWriter &) = delete;
+  EventFileWriter &operator=(const EventFileWriter &) = delete;
+
+  /**
+   * \brief Append events.
+   *
+   * \param n_events Number of events \f$n\f$.
+   * \param values Values of the events in the layout of the block mode of the
+   * samplers, i.e. the element with the index \f$\left( n_v i + j \right)
+   * n_\mathrm{ld} + k\f$ is component \f$j\f$ of step \f$i\f$ of event
+   * \f$k\f$.
+   * \param leading_dimension \f$n_\mathrm{ld} \geq n\f$.
+   * \param weights Array of length \f$n\f$ for the weights. Must be given if
+   * and only if the file is weighted.
+   *
+   * \throw invalid_argument if the weights do not match the file.
+   * \throw runtime_error if the file can not be written.
+   */
+  void write(const size_t n_events, const double *values,
+             const size_t leading_dimension, const double *weights = nullptr);
+
+  /**
+   * \brief Sample events and append them.
+   *
+   * \tparam Sampler Sampler with a block mode
+   * `sample(const size_t, double*, const size_t)`, like CascadeSampler or
+   * FourMomentumSampler.
+   *
+   * \param sampler Sampler.
+   * \param n_events Number of events.
+   *
+   * \throw invalid_argument if the file is weighted or if the shape of the
+   * events of the sampler does not match the file.
+   * \throw runtime_error if the file can not be written.
+   */
+  template <typename Sampler>
+  void sample(Sampler &sampler, const size_t n_events) {
+    check_sampler(sampler.get_n_steps(), Sampler::n_components, false);
+    fill(n_events, [&](const size_t m, double *chunk_values, double *) {
+      sampler.sample(m, chunk_values, chunk_size);
+    });
+  }
+
+  /**
+   * \brief Sample weighted events and append them.
+   *
+   * \tparam Sampler Sampler with a block mode
+   * `sample_weighted(const size_t, double*, const size_t, double*)`, like
+   * CascadeSampler.
+   *
+   * \param sampler Sampler.
+   * \param n_events Number of events.
+   *
+   * \throw invalid_argument if the file is not weighted or if the shape of the
+   * events of the sampler does not match the file.
+   * \throw runtime_error if the file can not be written.
+   */
+  template <typename Sampler>
+  void sample_weighted(Sampler &sampler, const size_t n_events) {
+    check_sampler(sampler.get_n_steps(), Sampler::n_components, true);
+    fill(n_events,
+         [&](const size_t m, double *chunk_values, double *chunk_weights) {
+           sampler.sample_weighted(m, chunk_values, chunk_size, chunk_weights);
+         });
+  }
+
+  /**
+   * \brief Write the last chunk and complete the header.
+   *
+   * Subsequent calls have no effect.
+   *
+   * \throw runtime_error if the file can not be written.
+   */
+  void close();
+
+  /**
+   * \brief Number of events that have been appended so far.
+   */
+  size_t get_n_events() const { return n_events; }
+
+  /**
+   * \brief Number of values per event.
+   */
+  size_t get_n_columns() const { return n_columns; }
+
+protected:
+  /**
+   * \brief Append events by letting a function fill the buffer.
+   *
+   * \param n Number of events.
+   * \param f Function which is called with a number of events \f$m\f$ and
+   * pointers to the first free event in the buffer for the values (leading
+   * dimension chunk_size) and the weights (nullptr if not weighted).
+   */
+  template <typename F> void fill(size_t n, F f) {
+    check_open();
+    while (n > 0) {
+      const size_t m = min(n, chunk_size - n_buffered);
+      f(m, buffer.data() + n_buffered,
+        weighted ? buffer.data() + (n_columns - 1) * chunk_size + n_buffered
+                 : nullptr);
+      n_buffered += m;
+      n_events += m;
+      n -= m;
+      if (n_buffered == chunk_size) {
+        flush();
+      }
+    }
+  }
+
+  void check_open() const;
+  void check_sampler(const size_t sampler_n_steps,
+                     const size_t sampler_n_components,
+                     const bool sampler_weighted) const;
+
+  /**
+   * \brief Write the buffer as a chunk and clear it.
+   */
+  void flush();
+
+  string file_name;      /**< Name of the file. */
+  ofstream file;         /**< Output stream. */
+  event_file::Header header; /**< Header of the file. */
+  const size_t n_columns;    /**< \f$n_\mathrm{col}\f$ */
+  const size_t chunk_size;   /**< \f$n_c\f$ */
+  const bool weighted;       /**< Whether the last column contains weights. */
+  vector<double> buffer;     /**< Current chunk. */
+  size_t n_buffered;         /**< Number of events in the buffer. */
+  size_t n_events;           /**< Total number of events. */
+  bool closed;               /**< Whether close() was called. */
+};
+
+/**
+ * \brief Read-only view of an event file.
+ *
+ * The constructor maps the file into memory with mmap(), so the columns of a
+ * chunk can be used directly from the mapping without copying.
+ * The mapping is read-only and can be used by several threads at once.
+ * See event_file for a description of the format.
+ */
+class EventFileReader {
+public:
+  /**
+   * \brief Constructor, maps an existing file into memory.
+   *
+   * \param file_name Name of the file.
+   *
+   * \throw runtime_error if the file can not be mapped, or if it is not a
+   * complete event file of the current format version.
+   */
+  explicit EventFileReader(const string &file_name);
+
+  /**
+   * \brief Destructor, unmaps the file.
+   */
+  ~EventFileReader();
+
+  EventFileReader(const EventFileReader &) = delete;
+  EventFileReader &operator=(const EventFileReader &) = delete;
+
+  /**
+   * \brief Number of events.
+   */
+  size_t get_n_events() const { return header->n_events; }
+
+  /**
+   * \brief Number of steps per event \f$n_s\f$.
+   */
+  size_t get_n_steps() const { return header->n_steps; }
+
+  /**
+   * \brief Number of components per step \f$n_v\f$.
+   */
+  size_t get_n_components() const { return header->n_components; }
+
+  /**
+   * \brief Whether the last column contains weights.
+   */
+  bool is_weighted() const { return header->weighted != 0; }
+
+  /**
+   * \brief Number of values per event \f$n_\mathrm{col}\f$.
+   */
+  size_t get_n_columns() const { return n_columns; }
+
+  /**
+   * \brief Number of events per chunk \f$n_c\f$.
+   */
+  size_t get_chunk_size() const { return header->chunk_size; }
+
+  /**
+   * \brief Number of chunks.
+   */
+  size_t get_n_chunks() const { return n_chunks; }
+
+  /**
+   * \brief Number of valid events in a chunk.
+   *
+   * This is \f$n_c\f$ for all chunks except the last one.
+   *
+   * \param chunk Index of the chunk.
+   *
+   * \throw out_of_range if the index of the chunk is out of range.
+   */
+  size_t get_chunk_length(const size_t chunk) const;
+
+  /**
+   * \brief Column of a chunk.
+   *
+   * \param chunk Index of the chunk.
+   * \param column Index of the column, \f$n_v i + j\f$ for component \f$j\f$
+   * of step \f$i\f$, or \f$n_\mathrm{col} - 1\f$ for the weights.
+   *
+   * \return Pointer to the \f$n_c\f$ mapped values of the column, valid as
+   * long as the reader exists. Only the first get_chunk_length() values are
+   * events.
+   *
+   * \throw out_of_range if the index of the chunk or the column is out of
+   * range.
+   */
+  const double *get_column(const size_t chunk, const size_t column) const;
+
+  /**
+   * \brief Copy events out of the file.
+   *
+   * \param first Index of the first event.
+   * \param n_events Number of events \f$n\f$.
+   * \param values Array for the values in the layout of
+   * EventFileWriter::write(), i.e. the element with the index \f$\left( n_v i
+   * + j \right) n_\mathrm{ld} + k\f$ is component \f$j\f$ of step \f$i\f$ of
+   * event first + \f$k\f$.
+   * \param leading_dimension \f$n_\mathrm{ld} \geq n\f$.
+   * \param weights Array of length \f$n\f$ for the weights, or nullptr.
+   *
+   * \throw out_of_range if the events are out of range.
+   * \throw invalid_argument if weights are requested from a file without
+   * weights.
+   */
+  void read(const size_t first, const size_t n_events, double *values,
+            const size_t leading_dimension, double *weights = nullptr) const;
+
+protected:
+  const char *data;  /**< Start of the mapping. */
+  size_t file_size;  /**< Size of the mapping in bytes. */
+  const event_file::Header *header; /**< Header at the start of the mapping. */
+  size_t n_columns; /**< \f$n_\mathrm{col}\f$ */
+  size_t n_chunks;  /**< Number of chunks. */
+  const double *chunks; /**< Start of the data section. */
+};
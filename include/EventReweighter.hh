@@ -0,0 +1,266 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "EulerAngleRotation.hh"
+
+/**
+ * \brief Statistics of the weights of an event sample that was reweighted to
+ * a hypothesis.
+ */
+struct ReweightingStatistics {
+  size_t n_events = 0;                /**< Number of reweighted events. */
+  double sum_of_weights = 0.;         /**< \f$\sum_k w_k\f$. */
+  double sum_of_squared_weights = 0.; /**< \f$\sum_k w_k^2\f$. */
+  double maximum_weight = 0.;         /**< \f$\mathrm{max}_k w_k\f$. */
+
+  /**
+   * \brief Mean value of the weights.
+   *
+   * For a hypothesis that is well covered by the reference, the mean value
+   * is close to 1.
+   * A significantly smaller value indicates that the hypothesis has a
+   * considerable probability in regions where the reference has almost none.
+   *
+   * \return \f$\sum_k w_k / n\f$, or zero if there are no events.
+   */
+  double get_mean_weight() const {
+    return n_events > 0 ? sum_of_weights / (double)n_events : 0.;
+  }
+
+  /**
+   * \brief Effective sample size.
+   *
+   * \f[
+   *      n_\mathrm{eff} = \frac{\left( \sum_k w_k \right)^2}{\sum_k w_k^2}
+   * \f]
+   *
+   * \return \f$n_\mathrm{eff}\f$, or zero if all weights vanish.
+   */
+  double get_effective_sample_size() const {
+    return sum_of_squared_weights > 0.
+               ? sum_of_weights * sum_of_weights / sum_of_squared_weights
+               : 0.;
+  }
+
+  /**
+   * \brief Fraction of the events that contribute effectively,
+   * \f$n_\mathrm{eff} / n\f$.
+   *
+   * \return \f$n_\mathrm{eff} / n\f$, or zero if there are no events.
+   */
+  double get_coverage() const {
+    return n_events > 0 ? get_effective_sample_size() / (double)n_events : 0.;
+  }
+};
+
+/**
+ * \brief Reweight a sample of cascades that was generated with a reference
+ * hypothesis to other hypotheses.
+ *
+ * To compare many hypotheses for the angular correlations of a cascade with
+ * the same simulated detector response, it is not necessary to generate and
+ * track a new sample of events for each hypothesis.
+ * Instead, the events can be generated once with a reference hypothesis,
+ * for example with CascadeSampler, and each event \f$k\f$ is assigned the
+ * weight
+ *
+ * \f[
+ *      w_{hk} = \prod_{i} \frac{W_{h,i} \left( \theta_{ik}, \varphi_{ik}
+ * \right) / \left\langle W_{h,i} \right\rangle}{W_{\mathrm{ref},i} \left(
+ * \theta_{ik}, \varphi_{ik} \right) / \left\langle W_{\mathrm{ref},i}
+ * \right\rangle} \f]
+ *
+ * for hypothesis \f$h\f$ (importance sampling, see, e.g., Sec. 3.3 in
+ * \cite RobertCasella1999).
+ * Here, \f$W_{h,i}\f$ is the angular correlation of step \f$i\f$ of the
+ * cascade for the hypothesis \f$h\f$, and \f$\left\langle W \right\rangle\f$
+ * is its mean value on the sphere, i.e. the first Legendre coefficient (see
+ * AngularCorrelation::get_legendre_coefficients()), so that angular
+ * correlations with different normalizations can be compared.
+ * The mean value of a quantity over the reweighted events is an estimate of
+ * its expectation value for the hypothesis \f$h\f$.
+ *
+ * The angles \f$\left( \theta_{ik}, \varphi_{ik} \right)\f$ are the
+ * spherical coordinates of the direction of emission of step \f$i\f$ in the
+ * reference frame of step \f$i - 1\f$.
+ * They are calculated from the cumulative reference frames \f$A_i\f$ of
+ * CascadeSampler as the direction euler_angle_transform::direction() of
+ * \f$A_{i-1}^T A_i\f$, where \f$A_{-1}\f$ is the identity.
+ * Only the steps that differ between the hypotheses have to be reweighted.
+ * For example, the first step of a nuclear resonance fluorescence experiment
+ * is the fixed direction of the beam (see DeterministicReferenceFrameSampler),
+ * which does not have an angular correlation.
+ * Therefore, the reweighted steps are the steps \f$i_0, i_0 + 1, ...\f$,
+ * where \f$i_0\f$ is passed to the constructor.
+ *
+ * The weights for all hypotheses are calculated in a single pass over the
+ * events.
+ * The events are processed in blocks of EventReweighter::block_size
+ * elements, and the local angles of a block are calculated once and passed
+ * to AngularCorrelation::evaluate_cos_theta() for the reference and all
+ * hypotheses.
+ *
+ * If a hypothesis has a considerable probability in regions where the
+ * reference has almost none, the reweighted sample is dominated by a few
+ * events with large weights.
+ * Therefore, the statistics of the weights are recorded for each hypothesis
+ * (see ReweightingStatistics), and get_poorly_covered_hypotheses() flags the
+ * hypotheses whose effective sample size is only a small fraction of the
+ * number of events.
+ * An event for which the reference vanishes has a weight of zero, since it
+ * should not have been generated.
+ */
+class EventReweighter {
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param reference Angular correlations \f$W_{\mathrm{ref},i}\f$ of the
+   * reference hypothesis with which the events were generated, one for each
+   * reweighted step.
+   * \param hypotheses Angular correlations \f$W_{h,i}\f$ of the hypotheses,
+   * one list with the same length as reference for each hypothesis.
+   * \param first_step Index \f$i_0\f$ of the first reweighted step in the
+   * output of CascadeSampler (default: 0).
+   *
+   * \throw invalid_argument if there are no reweighted steps or no
+   * hypotheses, if the number of angular correlations of a hypothesis is
+   * different from the reference, or if the mean value of an angular
+   * correlation is not positive.
+   */
+  EventReweighter(const vector<AngularCorrelation> &reference,
+                  const vector<vector<AngularCorrelation>> &hypotheses,
+                  const size_t first_step = 0);
+
+  /**
+   * \brief Calculate the weights of many events from their Euler angles.
+   *
+   * \param n_events Number of events \f$n\f$.
+   * \param Phi_Theta_Psi Euler angles of the cumulative reference frames in
+   * the layout of CascadeSampler::sample(const size_t, double*, const
+   * size_t), i.e. the element with the index \f$\left( 3 i + j \right)
+   * n_\mathrm{ld} + k\f$ is the angle \f$j\f$ of step \f$i\f$ of event
+   * \f$k\f$.
+   * \param leading_dimension \f$n_\mathrm{ld} \geq n\f$.
+   * \param weights Array of length \f$n_h n\f$, where \f$n_h\f$ is the number
+   * of hypotheses, for the weights.
+   * The element with the index \f$h n + k\f$ is \f$w_{hk}\f$.
+   */
+  void operator()(const size_t n_events, const double *Phi_Theta_Psi,
+                  const size_t leading_dimension, double *weights);
+
+  /**
+   * \brief Calculate the weights of many events from their rotation
+   * matrices.
+   *
+   * Same as operator()(const size_t, const double*, const size_t, double*),
+   * but for the cumulative rotation matrices of
+   * CascadeSampler::sample_rotation_matrices(const size_t,
+   * euler_angle_transform::RotationMatrix*, const size_t), i.e. the element
+   * with the index \f$i n_\mathrm{ld} + k\f$ is the matrix of step \f$i\f$
+   * of event \f$k\f$.
+   */
+  void operator()(const size_t n_events,
+                  const euler_angle_transform::RotationMatrix *A,
+                  const size_t leading_dimension, double *weights);
+
+  /**
+   * \brief Number of hypotheses \f$n_h\f$.
+   */
+  size_t get_n_hypotheses() const { return hypotheses.size(); }
+
+  /**
+   * \brief Statistics of the weights of a hypothesis since the construction
+   * or the last call of reset_statistics().
+   *
+   * \param h Index of the hypothesis.
+   *
+   * \throw out_of_range if the index is out of range.
+   */
+  const ReweightingStatistics &get_statistics(const size_t h) const;
+
+  /**
+   * \brief Set the statistics of all hypotheses to zero.
+   */
+  void reset_statistics();
+
+  /**
+   * \brief Hypotheses which are poorly covered by the reference.
+   *
+   * \param minimum_coverage Minimum fraction
+   * ReweightingStatistics::get_coverage() of the events that contribute
+   * effectively (default: 0.1).
+   *
+   * \return Indices of the hypotheses whose coverage is smaller than
+   * minimum_coverage, in increasing order.
+   */
+  vector<size_t>
+  get_poorly_covered_hypotheses(const double minimum_coverage = 0.1) const;
+
+  /**
+   * \brief Number of events that are processed at once.
+   */
+  static constexpr size_t block_size = 256;
+
+protected:
+  /**
+   * \brief Calculate the weights of a block of events from the local
+   * angles of all reweighted steps, and update the statistics.
+   *
+   * \param m Number of events in the block.
+   * \param n_events Number of events \f$n\f$ of the entire call.
+   * \param start Index of the first event of the block.
+   * \param weights Array for the weights, see operator()().
+   */
+  void reweight_block(const size_t m, const size_t n_events,
+                      const size_t start, double *weights);
+
+  vector<AngularCorrelation> reference; /**< Reference hypothesis. */
+  vector<vector<AngularCorrelation>> hypotheses; /**< Hypotheses. */
+  vector<double> reference_normalization; /**< Mean values of the angular
+                                             correlations of the reference. */
+  vector<vector<double>>
+      normalization; /**< Mean values of the angular correlations of the
+                        hypotheses. */
+  size_t first_step; /**< Index of the first reweighted step. */
+
+  vector<ReweightingStatistics> statistics; /**< Statistics of the weights
+                                               of each hypothesis. */
+
+  vector<euler_angle_transform::RotationMatrix>
+      rotation_block; /**< Cumulative rotation matrices of the reweighted
+                         steps and the step before them for a block. */
+  vector<double> cos_theta_block; /**< Local \f$\cos \left( \theta \right)
+                                     \f$ of all reweighted steps. */
+  vector<double> phi_block;       /**< Local \f$\varphi\f$ of all reweighted
+                                     steps. */
+  vector<double> w_block;         /**< Values of an angular correlation. */
+  vector<double> w_reference_block; /**< Values of the reference. */
+};
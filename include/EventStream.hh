@@ -0,0 +1,398 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <algorithm>
+
+using std::copy;
+using std::max;
+
+#include <atomic>
+
+using std::atomic;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <functional>
+
+using std::function;
+
+#include <memory>
+
+using std::unique_ptr;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <thread>
+
+using std::thread;
+using std::this_thread::yield;
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * \brief Pre-sample events in background threads and hand them out to any
+ * number of consumer threads.
+ *
+ * A typical consumer is the primary generator of a Monte Carlo simulation,
+ * which needs one event at a time.
+ * Sampling events on demand couples the simulation to the latency of the
+ * sampler.
+ * Instead, this class starts a number of worker threads on construction, each
+ * with its own sampler, which fill a bounded ring buffer with chunks of
+ * events.
+ * Consumers take chunks out of the ring (pop()), or single events via a
+ * Consumer object, which buffers one chunk per consumer thread.
+ *
+ * The ring consists of \f$n_d\f$ slots ("depth") for chunks of \f$n_c\f$
+ * events each.
+ * Producers and consumers claim positions in the ring with an atomic counter
+ * each, and every slot has an atomic sequence number which tells whether it is
+ * free or filled for a given position (bounded queue by D. Vyukov).
+ * No locks are used.
+ * If the ring is full, the workers wait until a consumer has freed a slot
+ * (backpressure), so at most \f$n_d\f$ chunks plus one chunk per worker are
+ * sampled in advance.
+ * If the ring is empty, consumers wait for the workers.
+ * Waiting threads call std::this_thread::yield().
+ *
+ * Chunk number \f$c\f$ is always sampled after reseeding the sampler with the
+ * master seed and the stream index \f$c\f$, like in ParallelCascadeSampler.
+ * Therefore, the content of a chunk does not depend on the number of threads.
+ * The order in which the chunks leave the ring depends on the mode:
+ *
+ * - In the deterministic mode, the position of chunk \f$c\f$ in the ring is
+ * \f$c\f$, i.e. the chunks are popped in the order \f$0, 1, 2, ...\f$, and a
+ * single consumer always receives the same sequence of events for a given
+ * master seed.
+ * The workers sample directly into the ring.
+ * A slow worker holds back the consumers until its chunk is ready.
+ * - In the non-deterministic mode, a worker samples a chunk into a private
+ * buffer and claims the next free position only after it is done.
+ * The chunks are popped in the order in which they are finished.
+ *
+ * \tparam Sampler Sampler for the events, for example CascadeSampler or
+ * FourMomentumSampler.
+ * It must have member functions `sample(const size_t, double*, const size_t)`,
+ * `reseed(const unsigned int, const unsigned long long)`, and
+ * `get_n_steps()`, and a static member `n_components`.
+ * An event consists of `n_components` values for each step.
+ */
+template <typename Sampler> class EventStream {
+
+public:
+  /**
+   * \brief Constructor
+   *
+   * Creates the samplers and starts the worker threads.
+   *
+   * \param create_sampler Function that returns a new, independent sampler.
+   * All samplers must describe the same cascade.
+   * \param master_seed Master seed from which the random number streams of all
+   * chunks are derived.
+   * \param n_threads Number of worker threads (default: 1). If zero, the number
+   * of concurrent threads supported by the hardware is used.
+   * \param depth \f$n_d\f$, number of chunks in the ring (default: 8).
+   * \param chunk_size \f$n_c\f$, number of events per chunk (default: 4096).
+   * \param deterministic Whether the chunks are handed out in the order of
+   * their stream indices (default: true).
+   * \param max_chunks Total number of chunks. If zero (default), the stream
+   * produces chunks until it is destroyed.
+   *
+   * \throw invalid_argument if the depth or the chunk size is zero.
+   */
+  EventStream(function<Sampler()> create_sampler,
+              const unsigned int master_seed, const unsigned int n_threads = 1,
+              const size_t depth = 8, const size_t chunk_size = 4096,
+              const bool deterministic = true,
+              const unsigned long long max_chunks = 0)
+      : master_seed(master_seed), depth(depth), chunk_size(chunk_size),
+        deterministic(deterministic), max_chunks(max_chunks) {
+    if (depth == 0) {
+      throw invalid_argument("Depth must be larger than zero.");
+    }
+    if (chunk_size == 0) {
+      throw invalid_argument("Chunk size must be larger than zero.");
+    }
+
+    const unsigned int n_thr =
+        n_threads > 0 ? n_threads : max(1u, thread::hardware_concurrency());
+    for (unsigned int i = 0; i < n_thr; ++i) {
+      samplers.push_back(create_sampler());
+    }
+    event_size = Sampler::n_components * samplers[0].get_n_steps();
+
+    ring.resize(depth * chunk_size * event_size);
+    slot_chunks.resize(depth);
+    slots.reset(new Slot[depth]);
+    for (size_t s = 0; s < depth; ++s) {
+      slots[s].sequence.store(2 * s, memory_order_relaxed);
+    }
+
+    for (unsigned int i = 0; i < n_thr; ++i) {
+      workers.push_back(thread(&EventStream::produce, this, i));
+    }
+  }
+
+  EventStream(const EventStream &) = delete;
+  EventStream &operator=(const EventStream &) = delete;
+
+  /**
+   * \brief Destructor
+   *
+   * Stops the workers (see stop()).
+   */
+  ~EventStream() { stop(); }
+
+  /**
+   * \brief Take the next chunk of events out of the ring.
+   *
+   * Waits until the chunk is available.
+   * Can be called by any number of threads at the same time.
+   *
+   * \param events Array of length \f$n_c n_e\f$, where \f$n_e\f$ is
+   * get_event_size(), for the events.
+   * The layout is the one of the block mode of the sampler with a leading
+   * dimension of \f$n_c\f$, i.e. the element with the index \f$\left( n_v i +
+   * j \right) n_c + k\f$ is the component \f$j\f$ of step \f$i\f$ of event
+   * \f$k\f$, where \f$n_v\f$ is `Sampler::n_components`.
+   * \param chunk Optional pointer to a variable for the stream index of the
+   * chunk.
+   *
+   * \return false, and no events, if all max_chunks chunks have been taken or
+   * the stream was stopped, true otherwise.
+   */
+  bool pop(double *events, unsigned long long *chunk = nullptr) {
+    if (stopped.load(memory_order_relaxed)) {
+      return false;
+    }
+    const unsigned long long position =
+        read_position.value.fetch_add(1, memory_order_relaxed);
+    if (max_chunks > 0 && position >= max_chunks) {
+      return false;
+    }
+
+    Slot &slot = slots[position % depth];
+    while (slot.sequence.load(memory_order_acquire) != 2 * position + 1) {
+      if (stopped.load(memory_order_relaxed)) {
+        return false;
+      }
+      yield();
+    }
+
+    const double *data = ring.data() + (position % depth) * chunk_size *
+                                           event_size;
+    copy(data, data + chunk_size * event_size, events);
+    if (chunk != nullptr) {
+      *chunk = slot_chunks[position % depth];
+    }
+    slot.sequence.store(2 * (position + depth), memory_order_release);
+
+    return true;
+  }
+
+  /**
+   * \brief Hand out single events of an EventStream to one thread.
+   *
+   * A Consumer takes a whole chunk out of the ring with EventStream::pop()
+   * and returns its events one by one without any synchronization.
+   * Each consumer thread needs its own Consumer object.
+   */
+  class Consumer {
+  public:
+    /**
+     * \brief Constructor
+     *
+     * \param stream Stream from which the events are taken.
+     */
+    Consumer(EventStream &stream)
+        : stream(stream),
+          buffer(stream.get_chunk_size() * stream.get_event_size()) {}
+
+    /**
+     * \brief Next event.
+     *
+     * \param event Array of length get_event_size() for the event. The
+     * element with the index \f$n_v i + j\f$ is the component \f$j\f$ of step
+     * \f$i\f$.
+     *
+     * \return false if the stream is exhausted, true otherwise.
+     */
+    bool next(double *event) {
+      if (next_event == n_events) {
+        if (!stream.pop(buffer.data())) {
+          return false;
+        }
+        next_event = 0;
+        n_events = stream.get_chunk_size();
+      }
+      for (size_t l = 0; l < stream.get_event_size(); ++l) {
+        event[l] = buffer[l * n_events + next_event];
+      }
+      ++next_event;
+      return true;
+    }
+
+  protected:
+    EventStream &stream;   /**< Stream from which the events are taken. */
+    vector<double> buffer; /**< Current chunk. */
+    size_t next_event = 0; /**< Index of the next event in the buffer. */
+    size_t n_events = 0;   /**< Number of events in the buffer. */
+  };
+
+  /**
+   * \brief Stop the workers and wait until they have finished.
+   *
+   * Chunks that are being sampled are finished first.
+   * Consumers that are waiting for a chunk return without events.
+   */
+  void stop() {
+    stopped.store(true, memory_order_relaxed);
+    for (auto &t : workers) {
+      if (t.joinable()) {
+        t.join();
+      }
+    }
+  }
+
+  /**
+   * \brief Number of events per chunk \f$n_c\f$.
+   */
+  size_t get_chunk_size() const { return chunk_size; }
+
+  /**
+   * \brief Number of chunks in the ring \f$n_d\f$.
+   */
+  size_t get_depth() const { return depth; }
+
+  /**
+   * \brief Number of values per event \f$n_e\f$, i.e. `Sampler::n_components`
+   * times the number of steps.
+   */
+  size_t get_event_size() const { return event_size; }
+
+  /**
+   * \brief Number of worker threads.
+   */
+  unsigned int get_n_threads() const { return samplers.size(); }
+
+  /**
+   * \brief Whether the chunks are handed out in the order of their stream
+   * indices.
+   */
+  bool is_deterministic() const { return deterministic; }
+
+protected:
+  /**
+   * \brief Slot of the ring with a sequence number on its own cache line.
+   *
+   * If the sequence number of the slot with the index \f$p \bmod n_d\f$ is
+   * \f$2p\f$, the slot is free for position \f$p\f$. If it is \f$2p + 1\f$,
+   * it contains the chunk for position \f$p\f$.
+   * The factor of two keeps the two states apart even for \f$n_d = 1\f$,
+   * where the free state for position \f$p + 1\f$ would otherwise be the
+   * filled state for position \f$p\f$.
+   */
+  struct alignas(64) Slot {
+    atomic<unsigned long long> sequence;
+  };
+
+  /**
+   * \brief Counter on its own cache line.
+   */
+  struct alignas(64) Counter {
+    atomic<unsigned long long> value{0};
+  };
+
+  /**
+   * \brief Loop of a worker thread.
+   *
+   * \param i Index of the sampler of the worker.
+   */
+  void produce(const unsigned int i) {
+    Sampler &sampler = samplers[i];
+    const size_t chunk_length = chunk_size * event_size;
+    vector<double> buffer(deterministic ? 0 : chunk_length);
+
+    while (!stopped.load(memory_order_relaxed)) {
+      const unsigned long long chunk =
+          next_chunk.value.fetch_add(1, memory_order_relaxed);
+      if (max_chunks > 0 && chunk >= max_chunks) {
+        return;
+      }
+
+      if (!deterministic) {
+        sampler.reseed(master_seed, chunk);
+        sampler.sample(chunk_size, buffer.data(), chunk_size);
+      }
+
+      const unsigned long long position =
+          deterministic
+              ? chunk
+              : write_position.value.fetch_add(1, memory_order_relaxed);
+      Slot &slot = slots[position % depth];
+      while (slot.sequence.load(memory_order_acquire) != 2 * position) {
+        if (stopped.load(memory_order_relaxed)) {
+          return;
+        }
+        yield();
+      }
+
+      double *data = ring.data() + (position % depth) * chunk_length;
+      if (deterministic) {
+        sampler.reseed(master_seed, chunk);
+        sampler.sample(chunk_size, data, chunk_size);
+      } else {
+        copy(buffer.begin(), buffer.end(), data);
+      }
+      slot_chunks[position % depth] = chunk;
+      slot.sequence.store(2 * position + 1, memory_order_release);
+    }
+  }
+
+  vector<Sampler> samplers;       /**< One sampler per worker. */
+  vector<thread> workers;         /**< Worker threads. */
+  const unsigned int master_seed; /**< Seed from which all random number
+                                     streams are derived. */
+  const size_t depth;             /**< \f$n_d\f$, number of slots. */
+  const size_t chunk_size;        /**< \f$n_c\f$, number of events per chunk. */
+  const bool deterministic; /**< Hand out chunks in the order of their stream
+                               indices. */
+  const unsigned long long max_chunks; /**< Total number of chunks, or zero. */
+  size_t event_size;                   /**< \f$n_e\f$ */
+  vector<double> ring;                 /**< Data of all slots. */
+  vector<unsigned long long> slot_chunks; /**< Stream index of the chunk in
+                                             each slot. */
+  unique_ptr<Slot[]> slots;               /**< Sequence numbers of the slots. */
+  Counter next_chunk;     /**< Next stream index to be sampled. */
+  Counter write_position; /**< Next position to be filled in the
+                             non-deterministic mode. */
+  Counter read_position;  /**< Next position to be taken by a consumer. */
+  atomic<bool> stopped{false}; /**< Whether stop() was called. */
+};
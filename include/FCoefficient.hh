@@ -145,6 +145,25 @@ public:
   FCoefficient(const int two_nu, const int two_L, const int two_Lp,
                const int two_j1, const int two_j);
 
+  /**
+   * \brief Constructor for a known value.
+   *
+   * No Wigner symbol is calculated. This constructor is used to restore
+   * coefficients that were calculated before, see
+   * AngularCorrelation::deserialize().
+   *
+   * \param two_nu \f$2 \nu\f$
+   * \param two_L \f$2 L\f$
+   * \param two_Lp \f$2 L^\prime\f$
+   * \param two_j1 \f$2 j_1\f$
+   * \param two_j \f$2 j\f$
+   * \param value \f$F_\nu(L, L^\prime, j_1, j)\f$
+   */
+  FCoefficient(const int two_nu, const int two_L, const int two_Lp,
+               const int two_j1, const int two_j, const double value)
+      : two_nu(two_nu), two_L(two_L), two_Lp(two_Lp), two_j1(two_j1),
+        two_j(two_j), value(value) {}
+
   /**
    * \brief Check whether given F coefficient is nonzero.
    *
@@ -167,8 +186,9 @@ public:
 
   double get_value() const { return value; }
 
-  string string_representation([[maybe_unused]] const unsigned int n_digits = 0,
-                               vector<string> variable_names = {}) const;
+  void write_string_representation(
+      string &str_rep, const unsigned int n_digits = 0,
+      const vector<string> &variable_names = {}) const override;
 
   /**
    * \brief Check whether given Clebsch-Gordan coefficient is nonzero.
@@ -0,0 +1,94 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cstddef>
+
+using std::size_t;
+
+/**
+ * \brief Factorials and ratios of factorials at compile time.
+ *
+ * Several expansion coefficients of the angular correlations contain ratios
+ * of factorials like \f$\left( \nu - 2 \right)! / \left( \nu + 2 \right)!\f$
+ * (see, e.g., KappaCoefficient, EvCoefficient, and
+ * W_pol_dir::get_upper_limit()).
+ * Instead of calling gsl_sf_fact() \cite Galassi2009 for each factorial in
+ * hot code, the values are taken from a table that is generated by the
+ * compiler, and ratios with a small difference of the arguments are
+ * calculated as a product of the few remaining factors.
+ */
+namespace factorial {
+
+/**
+ * \brief Largest argument whose factorial can be represented by a double.
+ */
+constexpr size_t n_max = 170;
+
+/**
+ * \brief Generate the table of factorials.
+ */
+constexpr array<double, n_max + 1> generate_table() {
+  array<double, n_max + 1> table{};
+  table[0] = 1.;
+  for (size_t n = 1; n <= n_max; ++n) {
+    table[n] = table[n - 1] * n;
+  }
+  return table;
+}
+
+/**
+ * \brief Table of \f$n!\f$ for \f$0 \leq n \leq\f$ factorial::n_max.
+ */
+constexpr array<double, n_max + 1> table = generate_table();
+
+/**
+ * \brief Factorial
+ *
+ * \param n Argument \f$n \leq\f$ factorial::n_max.
+ *
+ * \return \f$n!\f$
+ */
+constexpr double factorial(const size_t n) { return table[n]; }
+
+/**
+ * \brief Ratio of two factorials
+ *
+ * The ratio is calculated as a product of \f$|n - m|\f$ factors, which is
+ * exact for small differences and does not overflow for large arguments.
+ *
+ * \param n Argument of the numerator.
+ * \param m Argument of the denominator.
+ *
+ * \return \f$n! / m!\f$
+ */
+constexpr double ratio(const size_t n, const size_t m) {
+  double product = 1.;
+  for (size_t k = (n < m ? n : m) + 1; k <= (n < m ? m : n); ++k) {
+    product *= k;
+  }
+  return n < m ? 1. / product : product;
+}
+
+} // namespace factorial
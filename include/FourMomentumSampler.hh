@@ -19,6 +19,26 @@
 
 #pragma once
 
+#include <array>
+
+using std::array;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <random>
+
+using std::normal_distribution;
+
+#include <vector>
+
+using std::vector;
+
+#include "CascadeSampler.hh"
+#include "EulerAngleRotation.hh"
+#include "RandomEngine.hh"
+
 /**
  * \brief Class for sampling the initial four-momenta of photons emitted in a
  * gamma-ray cascade.
@@ -451,5 +471,195 @@
  * negative sign. This makes sense, because by expanding the expressions at low
  * velocities, the classical-mechanics solution was obtained in which the
  * absorption and emission are symmetric.
+ *
+ * # Implementation
+ *
+ * Instead of the closed expressions above, the implementation works with the
+ * four momenta directly, which is equivalent, but also applies to a nucleus
+ * that is not at rest before the first step.
+ * The rest mass of the nucleus in the state \f$i\f$ is \f$m_i = M c^2 +
+ * \left( E_i - E_0 \right)\f$, where \f$E_0\f$ is the energy of the ground
+ * state.
+ * Below, the index \f$i\f$ denotes the initial and \f$j\f$ the final state
+ * of a step.
+ * The directions of the photons are the Cartesian unit vectors
+ * \f$\hat{\mathbf{n}}\f$ of the reference frames from
+ * CascadeSampler::sample_rotation_matrices() (see
+ * euler_angle_transform::direction()).
+ *
+ * - If the first step of the cascade excites the nucleus (\f$m_j > m_i\f$),
+ * it is the capture of a photon that propagates along \f$\hat{\mathbf{n}}\f$
+ * in the laboratory frame.
+ * The resonance condition \f$\left( p + p_\gamma \right)^2 c^2 = m_j^2\f$
+ * gives
+ *
+ * \f[
+ *      E_\gamma = \frac{m_j^2 - m_i^2}{2 \left( E - \mathbf{p} c \cdot
+ * \hat{\mathbf{n}} \right)}, \f]
+ *
+ * which reduces to the expression in the section "Capture" for a nucleus at
+ * rest.
+ * - All other steps are emissions.
+ * In the rest frame of the nucleus, the photon has the energy
+ *
+ * \f[
+ *      E_{\gamma, R} = \frac{m_i^2 - m_j^2}{2 m_i},
+ * \f]
+ *
+ * which is the expression in the section "Recoil", and it is emitted along
+ * \f$\hat{\mathbf{n}}\f$.
+ * Its four momentum is Lorentz boosted into the laboratory frame with the
+ * four velocity \f$u = p / m_i\f$ of the nucleus,
+ *
+ * \f[
+ *      E_\gamma = u_0 E_{\gamma, R} + \mathbf{u} \cdot
+ * \mathbf{p}_{\gamma, R} c, ~~ \mathbf{p}_\gamma c = \mathbf{p}_{\gamma, R} c
+ * + \mathbf{u} \left( \frac{\mathbf{u} \cdot \mathbf{p}_{\gamma, R} c}{1 +
+ * u_0} + E_{\gamma, R} \right), \f]
+ *
+ * which includes the Doppler shift and the aberration of the direction of
+ * emission.
+ *
+ * After each step, the four momentum of the nucleus is updated by the
+ * conservation of four momentum.
+ * In other words, the angular correlations are sampled in the rest frame of
+ * the emitting nucleus.
+ * The reference frame of the next step is the direction of the previous
+ * photon as given by the CascadeSampler, which neglects the aberration of the
+ * reference axis, an effect of the order of \f$\beta\f$.
+ *
+ * Before the first step, the nucleus moves with a velocity
+ * \f$\boldsymbol{\beta} = \boldsymbol{\beta}_\mathrm{beam} +
+ * \boldsymbol{\beta}_\mathrm{thermal}\f$.
+ * The components of the thermal part are sampled from independent normal
+ * distributions with the standard deviation \f$\sqrt{k_B T / M c^2}\f$
+ * (Maxwell-Boltzmann distribution in the nonrelativistic limit).
+ * For \f$T = 0\f$, no random numbers are needed for the motion of the nucleus.
+ *
+ * The four momenta are written into an array in the same layout as the Euler
+ * angles of CascadeSampler::sample(const size_t, double*, const size_t), i.e.
+ * as a structure of arrays.
  */
-class FourMomentumSampler {};
\ No newline at end of file
+class FourMomentumSampler {
+
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param cascade_sampler Sampler for the directions of the photons. Each of
+   * its \f$n_s\f$ steps corresponds to one photon.
+   * \param energies Excitation energies of the \f$n_s + 1\f$ states of
+   * the cascade in the order in which they are populated, starting with the
+   * initial state, in the same unit as the mass.
+   * Only the first step may excite the nucleus, all other steps must be
+   * emissions, i.e. the energies of all states after the second one must
+   * decrease.
+   * \param mass \f$M c^2\f$, mass of the nucleus in its ground state.
+   * \param beta \f$\boldsymbol{\beta}_\mathrm{beam}\f$, velocity of the
+   * nucleus before the first step in units of the speed of light (default:
+   * at rest).
+   * \param temperature \f$k_B T\f$ in the same unit as the mass (default:
+   * 0).
+   * \param seed Random number seed for the thermal motion (default: 0).
+   *
+   * \throw invalid_argument if the number of energies does not match the
+   * number of steps, if the energies are not in the required order, if the
+   * mass is not positive, if the temperature is negative, or if
+   * \f$\left| \boldsymbol{\beta}_\mathrm{beam} \right| \geq 1\f$.
+   */
+  FourMomentumSampler(CascadeSampler cascade_sampler,
+                      const vector<double> &energies, const double mass,
+                      const array<double, 3> beta = {0., 0., 0.},
+                      const double temperature = 0., const int seed = 0);
+
+  /**
+   * \brief Sample the four momenta of the photons of a single cascade.
+   *
+   * \return List of four momenta \f$\left( E_\gamma, p_{\gamma, x} c,
+   * p_{\gamma, y} c, p_{\gamma, z} c \right)\f$, one for each step.
+   */
+  vector<array<double, 4>> operator()();
+
+  /**
+   * \brief Sample the four momenta of the photons of many cascades at once.
+   *
+   * The events are processed in blocks of CascadeSampler::block_size.
+   * For each block, the directions of all steps are sampled with a single
+   * call of CascadeSampler::sample_rotation_matrices(const size_t,
+   * euler_angle_transform::RotationMatrix*, const size_t), and the kinematics
+   * are calculated in a single pass over the block.
+   *
+   * \param n_events Number of cascades \f$n\f$.
+   * \param p Array for the four momenta. The element with the index \f$\left(
+   * 4 i + j \right) n_\mathrm{ld} + k\f$ is the component \f$j\f$
+   * (\f$E_\gamma\f$, \f$p_{\gamma, x} c\f$, \f$p_{\gamma, y} c\f$, or
+   * \f$p_{\gamma, z} c\f$) of the photon of step \f$i\f$ of cascade
+   * \f$k\f$.
+   * \param leading_dimension \f$n_\mathrm{ld} \geq n\f$.
+   */
+  void sample(const size_t n_events, double *p, const size_t leading_dimension);
+
+  /**
+   * \brief Sample the four momenta of many cascades with \f$n_\mathrm{ld} =
+   * n\f$.
+   */
+  void sample(const size_t n_events, double *p) {
+    sample(n_events, p, n_events);
+  }
+
+  /**
+   * \brief Reinitialize the random number engines.
+   *
+   * Reseeds the CascadeSampler (see CascadeSampler::reseed()), and the engine
+   * for the thermal motion with the sequence \f$\left( s, t_\mathrm{low},
+   * t_\mathrm{high}, n_s \right)\f$, i.e. as if it was an additional step of
+   * the cascade.
+   *
+   * \param seed Seed \f$s\f$.
+   * \param stream Stream index \f$t\f$.
+   */
+  void reseed(const unsigned int seed, const unsigned long long stream = 0);
+
+  /**
+   * \brief Number of steps of the cascade, i.e. number of photons per event.
+   */
+  size_t get_n_steps() const { return cascade_sampler.get_n_steps(); }
+
+  /**
+   * \brief Sampler for the directions of the photons.
+   */
+  CascadeSampler &get_cascade_sampler() { return cascade_sampler; }
+
+  /**
+   * \brief Number of values per step and event in the block mode sample(),
+   * i.e. the four components of a four momentum.
+   */
+  static constexpr size_t n_components = 4;
+
+protected:
+  /**
+   * \brief Calculate the four momenta of the photons of a single cascade.
+   *
+   * \param A Pointer to the rotation matrix of the first step.
+   * \param stride Distance between the rotation matrices of two consecutive
+   * steps.
+   * \param p Pointer to the energy of the first photon.
+   * \param leading_dimension Distance between two components of the four
+   * momenta in p.
+   */
+  void kinematics(const euler_angle_transform::RotationMatrix *A,
+                  const size_t stride, double *p,
+                  const size_t leading_dimension);
+
+  CascadeSampler cascade_sampler; /**< Sampler for the directions. */
+  vector<double> masses;          /**< Rest masses \f$m_i\f$. */
+  array<double, 3> beta;          /**< \f$\boldsymbol{\beta}_\mathrm{beam}\f$
+                                   */
+  double thermal_beta; /**< \f$\sqrt{k_B T / M c^2}\f$ */
+  Xoshiro256PlusPlus random_engine; /**< Engine for the thermal motion. */
+  normal_distribution<double>
+      normal; /**< Standard normal distribution for the thermal motion. */
+  vector<euler_angle_transform::RotationMatrix>
+      rotation_block; /**< Rotation matrices of all steps for a block of
+                         cascades. */
+};
\ No newline at end of file
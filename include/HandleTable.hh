@@ -0,0 +1,303 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <cstdint>
+
+using std::uint32_t;
+using std::uint64_t;
+
+#include <memory>
+
+using std::unique_ptr;
+
+#include <mutex>
+
+using std::lock_guard;
+using std::mutex;
+
+#include <optional>
+
+using std::optional;
+
+#include <utility>
+
+using std::move;
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * \brief Arena of reference-counted objects that are addressed by integer
+ * handles.
+ *
+ * This class is the storage behind the handle-based functions of the C
+ * interface, which are used by the Python bindings.
+ * A handle contains the index of a slot of the arena and the generation of
+ * the slot, which is incremented whenever an object in the slot is
+ * destroyed.
+ * Therefore, a handle of a destroyed object, or a handle that is released
+ * twice, is detected and ignored instead of accessing a reused slot.
+ * The value HandleTable::invalid_handle is never assigned to an object.
+ *
+ * Each object has a reference count, which is 1 after its insertion.
+ * The object is destroyed when the count drops to zero, but the memory of its
+ * slot is kept for the next insertion.
+ * The slots are allocated in blocks: an insertion of many objects at once
+ * allocates at most one block for all objects that do not fit into free
+ * slots.
+ *
+ * All member functions may be called from several threads at the same time.
+ * A pointer obtained with get() remains valid as long as the caller holds a
+ * reference to the object.
+ */
+template <typename T> class HandleTable {
+public:
+  using Handle = uint64_t;
+
+  /**
+   * \brief Handle that does not refer to any object.
+   */
+  static constexpr Handle invalid_handle = 0;
+
+  /**
+   * \brief Constructor
+   *
+   * \param min_block_size Minimum number of slots of a new block (default:
+   * 64).
+   */
+  explicit HandleTable(const size_t min_block_size = 64)
+      : min_block_size(min_block_size > 0 ? min_block_size : 1) {}
+
+  /**
+   * \brief Insert a single object.
+   *
+   * \param object Object, which is moved into the arena.
+   *
+   * \return Handle of the object.
+   */
+  Handle insert(T object) {
+    optional<T> wrapper(move(object));
+    Handle handle;
+    insert(1, &wrapper, &handle);
+    return handle;
+  }
+
+  /**
+   * \brief Insert many objects at once.
+   *
+   * \param n Number of objects.
+   * \param objects Array of length n. The objects are moved into the arena.
+   * Empty elements are skipped.
+   * \param handles Array of length n for the handles of the objects, or
+   * invalid_handle for empty elements.
+   */
+  void insert(const size_t n, optional<T> *objects, Handle *handles) {
+    size_t n_objects = 0;
+    for (size_t i = 0; i < n; ++i) {
+      n_objects += objects[i].has_value();
+    }
+
+    lock_guard<mutex> lock(table_mutex);
+
+    if (n_objects > free_slots.size()) {
+      const size_t block_size = n_objects - free_slots.size() > min_block_size
+                                    ? n_objects - free_slots.size()
+                                    : min_block_size;
+      blocks.emplace_back(new Slot[block_size]);
+      Slot *block = blocks.back().get();
+      // Push in reverse, so that the slots are used in the order of their
+      // addresses.
+      for (size_t i = block_size; i > 0; --i) {
+        free_slots.push_back(static_cast<uint32_t>(slots.size() + i - 1));
+      }
+      for (size_t i = 0; i < block_size; ++i) {
+        slots.push_back(block + i);
+      }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+      if (!objects[i].has_value()) {
+        handles[i] = invalid_handle;
+        continue;
+      }
+      const uint32_t index = free_slots.back();
+      free_slots.pop_back();
+      Slot &slot = *slots[index];
+      slot.object.emplace(move(*objects[i]));
+      slot.reference_count = 1;
+      handles[i] = (static_cast<Handle>(slot.generation) << 32) | index;
+    }
+    n_live += n_objects;
+  }
+
+  /**
+   * \brief Access an object.
+   *
+   * \param handle Handle of the object.
+   *
+   * \return Pointer to the object, or a null pointer if the handle does not
+   * refer to a live object.
+   */
+  T *get(const Handle handle) {
+    lock_guard<mutex> lock(table_mutex);
+    Slot *slot = find(handle);
+    return slot == nullptr ? nullptr : &*slot->object;
+  }
+
+  /**
+   * \brief Increment the reference count of an object.
+   *
+   * \param handle Handle of the object.
+   *
+   * \return True if the handle refers to a live object, false otherwise.
+   */
+  bool retain(const Handle handle) {
+    lock_guard<mutex> lock(table_mutex);
+    Slot *slot = find(handle);
+    if (slot == nullptr) {
+      return false;
+    }
+    ++slot->reference_count;
+    return true;
+  }
+
+  /**
+   * \brief Decrement the reference count of an object, and destroy the object
+   * if the count drops to zero.
+   *
+   * \param handle Handle of the object.
+   *
+   * \return True if the handle referred to a live object, false otherwise.
+   */
+  bool release(const Handle handle) {
+    lock_guard<mutex> lock(table_mutex);
+    return release_unlocked(handle);
+  }
+
+  /**
+   * \brief Release many objects at once.
+   *
+   * \param n Number of handles.
+   * \param handles Array of length n. Invalid handles are ignored.
+   *
+   * \return Number of handles that referred to live objects.
+   */
+  size_t release(const size_t n, const Handle *handles) {
+    lock_guard<mutex> lock(table_mutex);
+    size_t n_released = 0;
+    for (size_t i = 0; i < n; ++i) {
+      n_released += release_unlocked(handles[i]);
+    }
+    return n_released;
+  }
+
+  /**
+   * \brief Reference count of an object, or 0 for an invalid handle.
+   */
+  uint32_t get_reference_count(const Handle handle) {
+    lock_guard<mutex> lock(table_mutex);
+    Slot *slot = find(handle);
+    return slot == nullptr ? 0 : slot->reference_count;
+  }
+
+  /**
+   * \brief Number of live objects.
+   */
+  size_t size() {
+    lock_guard<mutex> lock(table_mutex);
+    return n_live;
+  }
+
+  /**
+   * \brief Number of slots, including the free ones.
+   */
+  size_t capacity() {
+    lock_guard<mutex> lock(table_mutex);
+    return slots.size();
+  }
+
+  /**
+   * \brief Number of allocated blocks of slots.
+   */
+  size_t get_n_blocks() {
+    lock_guard<mutex> lock(table_mutex);
+    return blocks.size();
+  }
+
+protected:
+  /**
+   * \brief Slot of the arena.
+   */
+  struct Slot {
+    optional<T> object;           /**< Object, empty if the slot is free */
+    uint32_t generation = 1;      /**< Generation, never 0 */
+    uint32_t reference_count = 0; /**< Reference count */
+  };
+
+  /**
+   * \brief Find the slot of a live object, or return a null pointer.
+   *
+   * The caller must hold the lock.
+   */
+  Slot *find(const Handle handle) {
+    const size_t index = static_cast<size_t>(handle & 0xffffffffULL);
+    if (index >= slots.size()) {
+      return nullptr;
+    }
+    Slot *slot = slots[index];
+    if (!slot->object.has_value() ||
+        slot->generation != static_cast<uint32_t>(handle >> 32)) {
+      return nullptr;
+    }
+    return slot;
+  }
+
+  /**
+   * \brief release() without the lock.
+   */
+  bool release_unlocked(const Handle handle) {
+    Slot *slot = find(handle);
+    if (slot == nullptr) {
+      return false;
+    }
+    if (--slot->reference_count == 0) {
+      slot->object.reset();
+      if (++slot->generation == 0) {
+        slot->generation = 1;
+      }
+      free_slots.push_back(static_cast<uint32_t>(handle & 0xffffffffULL));
+      --n_live;
+    }
+    return true;
+  }
+
+  size_t min_block_size;             /**< Minimum size of a new block */
+  mutex table_mutex;                 /**< Lock of all members below */
+  vector<unique_ptr<Slot[]>> blocks; /**< Blocks of slots */
+  vector<Slot *> slots;              /**< Slots by their index */
+  vector<uint32_t> free_slots;       /**< Indices of free slots */
+  size_t n_live = 0;                 /**< Number of live objects */
+};
@@ -0,0 +1,265 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "RotatedAngularCorrelation.hh"
+
+/**
+ * \brief Ordering schemes of the pixels of a HEALPix map.
+ */
+enum HealpixOrdering : short { ring_ordering = 0, nested_ordering = 1 };
+
+/**
+ * \brief Expected fractions of events in the pixels of a HEALPix map.
+ *
+ * The Hierarchical Equal Area isoLatitude Pixelization (HEALPix) of
+ * G&oacute;rski et al. \cite Gorski2005 divides the sphere into
+ * \f$N_\mathrm{pix} = 12 N_\mathrm{side}^2\f$ pixels of equal area \f$4 \pi /
+ * N_\mathrm{pix}\f$, whose centers lie on \f$4 N_\mathrm{side} - 1\f$ rings
+ * of constant \f$\cos \left( \theta \right)\f$.
+ * In the 'ring' ordering, the pixels are numbered from the north to the south
+ * pole along the rings, starting at \f$\varphi = 0\f$.
+ * In the 'nested' ordering, each of the 12 base pixels is divided
+ * hierarchically into four pixels, so that the pixels \f$4p, 4p + 1, 4p + 2,
+ * 4p + 3\f$ at the resolution \f$2 N_\mathrm{side}\f$ are the children of the
+ * pixel \f$p\f$ at the resolution \f$N_\mathrm{side}\f$.
+ * The nested ordering requires \f$N_\mathrm{side}\f$ to be a power of 2.
+ *
+ * The expected fraction of events in a pixel \f$P\f$ is
+ *
+ * \f[
+ *      f_P = \frac{\int_P W \left( \Omega \right) \mathrm{d}\Omega}{\int W
+ * \left( \Omega \right) \mathrm{d}\Omega}. \f]
+ *
+ * Since a (rotated) angular correlation is a finite expansion in real
+ * spherical harmonics (see RotatedAngularCorrelation), this is a linear
+ * combination
+ *
+ * \f[
+ *      f_P = \frac{1}{4 \pi a_0^{0 \prime}} \sum_{l=0}^{\nu_\mathrm{max}}
+ * \sum_{m=-l}^l a_l^{m \prime} \int_P Y_{l,m} \left( \Omega \right)
+ * \mathrm{d}\Omega \f]
+ *
+ * of the integrals of the spherical harmonics over the pixels, which only
+ * depend on the geometry of the map.
+ * They are calculated once by the constructor, for all even \f$l \leq
+ * l_\mathrm{max}\f$, so that the map of an angular correlation costs only
+ * \f$\left( l_\mathrm{max} + 1 \right) \left( l_\mathrm{max} + 2 \right) /
+ * 2\f$ multiplications per pixel.
+ * Many hypotheses can share a single object, which is immutable after its
+ * construction.
+ *
+ * The integrals are approximated by the mean of the integrand at the centers
+ * of the \f$4^k\f$ pixels of the map with the resolution \f$2^k
+ * N_\mathrm{side}\f$ that make up a pixel.
+ * Since these sub-pixels have equal areas as well, this is a midpoint rule
+ * whose relative error decreases like \f$4^{-k}\f$ for a smooth integrand.
+ * The integral of \f$Y_{0,0} = 1\f$ is exact for any \f$k\f$.
+ * For \f$l > 0\f$, the quadrature errors would not cancel in the sum over all
+ * pixels.
+ * Therefore, their mean is subtracted from the integrals of each spherical
+ * harmonic, which makes the sum of the fractions of all pixels exactly 1 up
+ * to rounding errors.
+ * The memory of the integrals is proportional to \f$N_\mathrm{pix}
+ * l_\mathrm{max}^2\f$, and the precomputation time to \f$4^k\f$ times that.
+ * Both the precomputation and the maps are parallelized with ThreadPool.
+ */
+class HealpixMap {
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param nside Resolution parameter \f$N_\mathrm{side}\f$, a power of 2.
+   * \param ordering Ordering of the pixels (default: ring_ordering).
+   * \param l_max Maximum order \f$l_\mathrm{max}\f$ of the angular
+   * correlations (default: 8). Since only spherical harmonics of even order
+   * contribute, an odd value is rounded down.
+   * \param n_subdivisions Number \f$k\f$ of hierarchical subdivisions of a
+   * pixel for the quadrature (default: 3, i.e. 64 points per pixel).
+   *
+   * \throw invalid_argument if nside is not a power of 2, if l_max is
+   * negative, or if n_subdivisions is larger than 10.
+   */
+  HealpixMap(const size_t nside, const HealpixOrdering ordering = ring_ordering,
+             const int l_max = 8, const unsigned int n_subdivisions = 3);
+
+  /**
+   * \brief Expected fractions of events in all pixels.
+   *
+   * \param ang_cor Angular correlation.
+   * \param Phi_Theta_Psi Euler angles \f$\Phi\f$, \f$\Theta\f$, and
+   * \f$\Psi\f$ of the rotation of the angular correlation in radians
+   * (default: no rotation).
+   *
+   * \return Fractions \f$f_P\f$ in the ordering of the map.
+   *
+   * \throw invalid_argument if \f$\nu_\mathrm{max} > l_\mathrm{max}\f$.
+   */
+  vector<double>
+  expected_fractions(const AngularCorrelation &ang_cor,
+                     const array<double, 3> Phi_Theta_Psi = {0., 0., 0.}) const;
+
+  /**
+   * \brief Expected fractions of events in all pixels.
+   *
+   * \param rot_ang_cor Rotated angular correlation.
+   *
+   * \return Fractions \f$f_P\f$ in the ordering of the map.
+   *
+   * \throw invalid_argument if \f$\nu_\mathrm{max} > l_\mathrm{max}\f$, or if
+   * the integral of the angular correlation is not positive.
+   */
+  vector<double>
+  expected_fractions(const RotatedAngularCorrelation &rot_ang_cor) const;
+
+  /**
+   * \brief Pixel that contains a direction.
+   *
+   * \param theta Polar angle in radians.
+   * \param phi Azimuthal angle in radians.
+   *
+   * \return Index of the pixel in the ordering of the map.
+   */
+  size_t pixel(const double theta, const double phi) const;
+
+  /**
+   * \brief Center of a pixel.
+   *
+   * \param pixel Index of the pixel in the ordering of the map.
+   *
+   * \return Polar and azimuthal angle \f$\left( \theta, \varphi \right)\f$
+   * of the center in radians.
+   *
+   * \throw out_of_range if the index is not smaller than the number of
+   * pixels.
+   */
+  array<double, 2> pixel_center(const size_t pixel) const;
+
+  size_t get_nside() const { return nside; }
+  size_t get_n_pixels() const { return n_pixels; }
+  HealpixOrdering get_ordering() const { return ordering; }
+  int get_l_max() const { return l_max; }
+  unsigned int get_n_subdivisions() const { return n_subdivisions; }
+
+  /**
+   * \brief Number of spherical harmonics of even order up to
+   * \f$l_\mathrm{max}\f$, i.e. the number of integrals per pixel.
+   */
+  size_t get_n_harmonics() const { return n_harmonics; }
+
+  /**
+   * \brief Integral of a real spherical harmonic over a pixel.
+   *
+   * \param pixel Index of the pixel in the ordering of the map.
+   * \param l Even order \f$l \leq l_\mathrm{max}\f$.
+   * \param m Index \f$m\f$, \f$\left| m \right| \leq l\f$.
+   *
+   * \return \f$\int_P Y_{l,m} \left( \Omega \right) \mathrm{d} \Omega\f$
+   *
+   * \throw out_of_range if the pixel or the harmonic does not exist.
+   */
+  double get_integral(const size_t pixel, const int l, const int m) const;
+
+  /**
+   * \brief Center of a pixel in the nested ordering.
+   *
+   * \param nside Resolution parameter \f$N_\mathrm{side}\f$, a power of 2.
+   * \param nested Index of the pixel in the nested ordering.
+   *
+   * \return \f$\cos \left( \theta \right)\f$ and \f$\varphi\f$ of the
+   * center, with \f$\varphi \in \left[ 0, 2 \pi \right)\f$.
+   */
+  static array<double, 2> nested_center(const size_t nside,
+                                        const size_t nested);
+
+  /**
+   * \brief Convert a pixel index from the nested to the ring ordering.
+   *
+   * \param nside Resolution parameter \f$N_\mathrm{side}\f$, a power of 2.
+   * \param nested Index of the pixel in the nested ordering.
+   *
+   * \return Index of the pixel in the ring ordering.
+   */
+  static size_t nested_to_ring(const size_t nside, const size_t nested);
+
+  /**
+   * \brief Pixel in the nested ordering that contains a direction.
+   *
+   * \param nside Resolution parameter \f$N_\mathrm{side}\f$, a power of 2.
+   * \param cos_theta Cosine of the polar angle.
+   * \param phi Azimuthal angle in radians.
+   *
+   * \return Index of the pixel in the nested ordering.
+   */
+  static size_t nested_pixel(const size_t nside, const double cos_theta,
+                             const double phi);
+
+  /**
+   * \brief Real spherical harmonics of even order at a point.
+   *
+   * Same definition as in RotatedAngularCorrelation.
+   *
+   * \param l_max Maximum even order \f$l_\mathrm{max}\f$.
+   * \param cos_theta Cosine of the polar angle.
+   * \param phi Azimuthal angle in radians.
+   * \param result Array of length \f$\left( l + 1 \right) \left( l + 2
+   * \right) / 2\f$ for the values, where \f$l\f$ is the largest even order
+   * that is not larger than \f$l_\mathrm{max}\f$.
+   * The value of \f$Y_{l,m}\f$ is stored at the index \f$l \left( l - 1
+   * \right) / 2 + l + m\f$.
+   */
+  static void even_spherical_harmonics(const int l_max,
+                                       const double cos_theta,
+                                       const double phi, double *result);
+
+protected:
+  /**
+   * \brief Index of \f$Y_{l,m}\f$ among the spherical harmonics of even
+   * order.
+   */
+  static size_t harmonic_index(const int l, const int m) {
+    return static_cast<size_t>(l * (l - 1) / 2 + l + m);
+  }
+
+  size_t nside;                /**< \f$N_\mathrm{side}\f$ */
+  size_t n_pixels;             /**< \f$12 N_\mathrm{side}^2\f$ */
+  HealpixOrdering ordering;    /**< Ordering of the pixels */
+  int l_max;                   /**< Even \f$l_\mathrm{max}\f$ */
+  unsigned int n_subdivisions; /**< \f$k\f$ */
+  size_t n_harmonics;          /**< Number of integrals per pixel */
+  /**
+   * Integrals of the spherical harmonics over the pixels, with the index of
+   * the harmonic running fastest.
+   */
+  vector<double> integrals;
+};
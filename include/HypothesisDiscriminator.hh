@@ -0,0 +1,179 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+
+/**
+ * \brief Maps of the discrimination between hypotheses for an angular
+ * correlation as a function of the detector position.
+ *
+ * For a set of \f$H\f$ hypotheses \f$W_a\f$, for example different spins,
+ * parities, or mixing ratios of a cascade, the following separation metrics
+ * are calculated for each pair \f$\left( a, b \right)\f$ of hypotheses and
+ * each direction \f$\left( \theta, \varphi \right)\f$:
+ *
+ * - The ratio \f$W_a / W_b\f$.
+ * - The difference \f$A_a - A_b\f$ of the asymmetries
+ * \f[
+ *      A = \frac{W \left( \theta, \varphi \right) - W \left( \theta, \varphi
+ * + \pi / 2 \right)}{W \left( \theta, \varphi \right) + W \left( \theta,
+ * \varphi + \pi / 2 \right)} \f]
+ * between a detector at the given direction and one rotated by
+ * \f$\pi / 2\f$ around the \f$z\f$ axis, i.e. the analyzing power in the
+ * 'natural' convention (see AngularCorrelation::analyzing_power()).
+ * - The expected \f$\chi^2\f$ per unit count
+ * \f[
+ *      \chi^2_{ab} = \frac{\left( W_a - W_b \right)^2}{\left( W_a + W_b
+ * \right) / 2}, \f]
+ * i.e. the contribution of a detector at this direction to the \f$\chi^2\f$
+ * that separates the two hypotheses, if the expected number of counts is
+ * the product of \f$W\f$ and the exposure, and the variance of the counts is
+ * estimated by the mean of the two hypotheses.
+ * In contrast to the Pearson form \f$\left( W_a - W_b \right)^2 / W_b\f$,
+ * this expression is symmetric and bounded by \f$2 \left( W_a + W_b
+ * \right)\f$, so it has a finite maximum even if one of the hypotheses
+ * vanishes in some direction.
+ * If both hypotheses vanish, \f$\chi^2_{ab} = 0\f$.
+ *
+ * The hypotheses are evaluated for all directions with a single call of
+ * AngularCorrelation::evaluate() each, and the metrics for all pairs are
+ * calculated from these values.
+ * The direction that maximizes \f$\chi^2_{ab}\f$ for a pair can be refined
+ * by a gradient ascent that uses the analytic derivatives of the angular
+ * correlations with respect to the angles (see refine()).
+ */
+class HypothesisDiscriminator {
+public:
+  /**
+   * \brief Constructor.
+   *
+   * The mixing ratios of the cascade steps of each hypothesis are stored for
+   * the calculation of the derivatives with respect to the angles (see
+   * AngularCorrelation::evaluate_with_gradient()).
+   *
+   * \param hypotheses Angular correlations for the hypotheses.
+   *
+   * \throw invalid_argument if there are less than two hypotheses.
+   */
+  explicit HypothesisDiscriminator(
+      const vector<AngularCorrelation> &hypotheses);
+
+  /**
+   * \brief Return the number of hypotheses \f$H\f$.
+   */
+  size_t get_n_hypotheses() const { return hypotheses.size(); }
+
+  /**
+   * \brief Calculate the separation metrics for all pairs of hypotheses and
+   * many directions.
+   *
+   * All result arrays have the length \f$H^2 n\f$. The value for the pair
+   * \f$\left( a, b \right)\f$ and the direction \f$k\f$ is stored at the
+   * index \f$\left( a H + b \right) n + k\f$.
+   * A null pointer can be passed for any metric that is not needed.
+   * If the ratio is requested and \f$W_b\f$ vanishes, the result follows the
+   * rules of floating-point division.
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in radians, array of length n.
+   * \param phi Azimuthal angles in radians, array of length n.
+   * \param ratio Array for the ratios \f$W_a / W_b\f$, or a null pointer.
+   * \param asymmetry_difference Array for the differences \f$A_a - A_b\f$,
+   * or a null pointer.
+   * \param chi_squared Array for the values \f$\chi^2_{ab}\f$, or a null
+   * pointer.
+   */
+  void evaluate(const size_t n, const double *theta, const double *phi,
+                double *ratio, double *asymmetry_difference,
+                double *chi_squared) const;
+
+  /**
+   * \brief Calculate \f$\chi^2_{ab}\f$ and its derivatives with respect to
+   * the angles for a single direction.
+   *
+   * \param a Index of the first hypothesis.
+   * \param b Index of the second hypothesis.
+   * \param theta Polar angle in radians.
+   * \param phi Azimuthal angle in radians.
+   *
+   * \return \f$\chi^2_{ab}\f$, \f$\partial \chi^2_{ab} / \partial
+   * \theta\f$, and \f$\partial \chi^2_{ab} / \partial \varphi\f$, in this
+   * order.
+   *
+   * \throw out_of_range if a or b is not smaller than \f$H\f$.
+   */
+  array<double, 3> chi_squared_with_gradient(const size_t a, const size_t b,
+                                             const double theta,
+                                             const double phi) const;
+
+  /**
+   * \brief Refine the direction that maximizes \f$\chi^2_{ab}\f$.
+   *
+   * Starting from a direction, for example the maximum of a map calculated
+   * with evaluate(), steps of the length \f$s\f$ (in radians) along the
+   * normalized gradient with respect to \f$\left( \theta, \varphi
+   * \right)\f$ are taken.
+   * After a step that increases \f$\chi^2_{ab}\f$, it is accepted and
+   * \f$s\f$ is doubled, otherwise it is rejected and \f$s\f$ is halved.
+   * The polar angle is restricted to \f$\left[ 0, \pi \right]\f$.
+   * The iteration stops when \f$s\f$ is smaller than the tolerance, when the
+   * gradient vanishes, or after the maximum number of iterations.
+   * Since \f$\chi^2_{ab}\f$ never decreases, the result is at least the
+   * value at the start, but it may be a local maximum.
+   *
+   * \param a Index of the first hypothesis.
+   * \param b Index of the second hypothesis.
+   * \param theta Initial polar angle in radians.
+   * \param phi Initial azimuthal angle in radians.
+   * \param max_iterations Maximum number of iterations (default: 1000).
+   * \param tolerance Smallest step length in radians (default:
+   * \f$10^{-10}\f$).
+   * \param initial_step Initial step length in radians (default: 0.1).
+   *
+   * \return \f$\theta\f$, \f$\varphi \in \left[ 0, 2 \pi \right)\f$, and
+   * \f$\chi^2_{ab}\f$ at the refined direction, in this order.
+   *
+   * \throw out_of_range if a or b is not smaller than \f$H\f$.
+   * \throw invalid_argument if tolerance or initial_step is not positive.
+   */
+  array<double, 3> refine(const size_t a, const size_t b, const double theta,
+                          const double phi,
+                          const unsigned int max_iterations = 1000,
+                          const double tolerance = 1e-10,
+                          const double initial_step = 0.1) const;
+
+protected:
+  vector<AngularCorrelation> hypotheses; /**< Hypotheses \f$W_a\f$. */
+  vector<vector<double>>
+      deltas; /**< Mixing ratios of the cascade steps of each hypothesis. */
+};
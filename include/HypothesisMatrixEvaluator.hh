@@ -0,0 +1,185 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngleSet.hh"
+#include "CascadeHypothesisScanner.hh"
+
+/**
+ * \brief Evaluate many hypotheses for a cascade at a fixed set of directions
+ * as a product of matrices.
+ *
+ * For a fixed set of \f$M\f$ directions \f$\left( \theta_m, \varphi_m
+ * \right)\f$, the angular correlation of a hypothesis \f$k\f$ (see
+ * CascadeHypothesisScanner) is a linear function of its expansion
+ * coefficients:
+ *
+ * \f[
+ *      W_{km} = \sum_{i=0}^{\nu_\mathrm{max} / 2} c_{ki} P_{2i} \left( \cos
+ * \theta_m \right) + \cos \left( 2 \varphi_m \right)
+ * \sum_{i=0}^{\nu_\mathrm{max} / 2 - 1} d_{ki} P_{2i+2}^{\left| 2 \right|}
+ * \left( \cos \theta_m \right). \f]
+ *
+ * The (associated) Legendre polynomials, including the factor \f$\cos
+ * \left( 2 \varphi_m \right)\f$, are evaluated once by an AngleSet and stored
+ * as the rows of a basis matrix \f$B\f$ with \f$\nu_\mathrm{max} + 1\f$ rows
+ * and \f$M\f$ columns.
+ * The coefficients of \f$K\f$ hypotheses are copied into the rows of a
+ * matrix \f$C\f$ (with zeros for missing orders), and the values for all
+ * hypotheses and directions are the matrix product \f$W = C B\f$, which is
+ * calculated by the BLAS function `cblas_dgemm()`.
+ * By default, this is the CBLAS library of GSL, which can be replaced by an
+ * optimized BLAS library at link time.
+ *
+ * The product is calculated in blocks of block_size hypotheses.
+ * The goodness of fit of each hypothesis is calculated from its block while
+ * it is still in the cache, so the full \f$K \times M\f$ matrix never has to
+ * be stored if only the \f$\chi^2\f$ values are needed (see chi_squared()).
+ */
+class HypothesisMatrixEvaluator {
+public:
+  /**
+   * \brief Number of hypotheses per matrix product.
+   */
+  static constexpr size_t block_size = 256;
+
+  /**
+   * \brief Constructor, calculates the basis matrix.
+   *
+   * \param theta Polar angles in radians.
+   * \param phi Azimuthal angles in radians, same length as theta.
+   * \param nu_max Maximum order \f$\nu_\mathrm{max}\f$ of the Legendre
+   * expansions.
+   *
+   * \throw invalid_argument if theta is empty, if theta and phi have
+   * different lengths, or if nu_max is negative or odd.
+   */
+  HypothesisMatrixEvaluator(const vector<double> &theta,
+                            const vector<double> &phi, const int nu_max)
+      : HypothesisMatrixEvaluator(AngleSet(theta, phi, nu_max)) {}
+
+  /**
+   * \brief Constructor for a precomputed set of directions.
+   *
+   * The basis matrix is copied from the AngleSet, which may be used for the
+   * evaluation of single angular correlations at the same directions.
+   *
+   * \param angle_set Directions and maximum order \f$\nu_\mathrm{max}\f$.
+   */
+  explicit HypothesisMatrixEvaluator(const AngleSet &angle_set);
+
+  /**
+   * \brief Number of directions \f$M\f$.
+   */
+  size_t get_n_directions() const { return n_directions; }
+
+  /**
+   * \brief Maximum order \f$\nu_\mathrm{max}\f$ of the Legendre expansions.
+   */
+  int get_nu_max() const { return nu_max; }
+
+  /**
+   * \brief Basis matrix \f$B\f$ in row-major order.
+   *
+   * The first \f$\nu_\mathrm{max} / 2 + 1\f$ rows contain the Legendre
+   * polynomials \f$P_{2i} \left( \cos \theta_m \right)\f$, the remaining
+   * ones the products \f$\cos \left( 2 \varphi_m \right) P_{2i+2}^{\left| 2
+   * \right|} \left( \cos \theta_m \right)\f$.
+   */
+  const vector<double> &get_basis() const { return basis; }
+
+  /**
+   * \brief Evaluate all hypotheses of a scanner.
+   *
+   * \param scanner Scanner whose coefficients have been calculated with
+   * CascadeHypothesisScanner::scan().
+   * \param result Array of length \f$K M\f$ for the values \f$W_{km}\f$ in
+   * row-major order, i.e. the value for hypothesis \f$k\f$ and direction
+   * \f$m\f$ is stored at the index \f$k M + m\f$.
+   *
+   * \throw invalid_argument if the coefficients have not been calculated or
+   * if a hypothesis has a larger order than nu_max.
+   */
+  void evaluate(const CascadeHypothesisScanner &scanner,
+                double *result) const;
+
+  /**
+   * \brief Compare all hypotheses of a scanner to measured rates.
+   *
+   * The measured rates \f$y_m\f$ are not normalized, therefore each
+   * hypothesis is scaled by the factor
+   *
+   * \f[
+   *      a_k = \frac{\sum_m y_m W_{km} / \sigma_m^2}{\sum_m W_{km}^2 /
+   * \sigma_m^2}
+   * \f]
+   *
+   * which minimizes
+   *
+   * \f[
+   *      \chi^2_k = \sum_m \frac{\left( y_m - a_k W_{km}
+   * \right)^2}{\sigma_m^2}. \f]
+   *
+   * If all \f$W_{km}\f$ vanish, \f$a_k = 0\f$.
+   *
+   * \param scanner Scanner whose coefficients have been calculated with
+   * CascadeHypothesisScanner::scan().
+   * \param rates Measured rates \f$y_m\f$, array of length \f$M\f$.
+   * \param uncertainties Uncertainties \f$\sigma_m\f$ of the rates, array of
+   * length \f$M\f$.
+   * \param chi2 Array of length \f$K\f$ for the values \f$\chi^2_k\f$.
+   * \param scale Array of length \f$K\f$ for the factors \f$a_k\f$, or a
+   * null pointer if they are not needed.
+   * \param result Array of length \f$K M\f$ for the values \f$W_{km}\f$ (see
+   * evaluate()), or a null pointer (default) if they are not needed.
+   *
+   * \throw invalid_argument if an uncertainty is not positive, or for the
+   * reasons given for evaluate().
+   */
+  void chi_squared(const CascadeHypothesisScanner &scanner,
+                   const double *rates, const double *uncertainties,
+                   double *chi2, double *scale,
+                   double *result = nullptr) const;
+
+protected:
+  /**
+   * \brief Calculate the matrix product block by block, and the
+   * \f$\chi^2\f$ values if weights are given.
+   *
+   * \param weights Inverse squared uncertainties, or a null pointer.
+   */
+  void multiply(const CascadeHypothesisScanner &scanner, const double *rates,
+                const double *weights, double *chi2, double *scale,
+                double *result) const;
+
+  const size_t n_directions; /**< \f$M\f$ */
+  const int nu_max;          /**< \f$\nu_\mathrm{max}\f$ */
+  const size_t n_legendre; /**< Number of Legendre polynomials in the basis,
+                              \f$\nu_\mathrm{max} / 2 + 1\f$. */
+  vector<double> basis; /**< Basis matrix \f$B\f$, see get_basis(). */
+};
@@ -106,10 +106,26 @@ public:
    */
   KappaCoefficient(const int two_nu, const int two_L, const int two_Lp);
 
+  /**
+   * \brief Constructor for a known value.
+   *
+   * See FCoefficient::FCoefficient(const int, const int, const int, const
+   * int, const int, const double).
+   *
+   * \param two_nu \f$2 \nu\f$
+   * \param two_L \f$2 L\f$
+   * \param two_Lp \f$2 L^\prime \f$
+   * \param value \f$\kappa_\nu \left( L, L^\prime \right)\f$
+   */
+  KappaCoefficient(const int two_nu, const int two_L, const int two_Lp,
+                   const double value)
+      : two_nu(two_nu), two_L(two_L), two_Lp(two_Lp), value(value) {}
+
   double get_value() const { return value; };
 
-  string string_representation([[maybe_unused]] const unsigned int n_digits = 0,
-                               vector<string> variable_names = {}) const;
+  void write_string_representation(
+      string &str_rep, const unsigned int n_digits = 0,
+      const vector<string> &variable_names = {}) const override;
 
 protected:
   const int two_nu;
@@ -0,0 +1,301 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <vector>
+
+using std::vector;
+
+#include "MixingRatioInverter.hh"
+
+/**
+ * \brief Result of a fit of the expansion coefficients of an angular
+ * distribution.
+ */
+struct LegendreFitResult {
+  /**
+   * Normalized coefficients \f$c_0 = 1, c_1, ...\f$, followed by
+   * \f$d_0, d_1, ...\f$ for a fit of a polarized distribution.
+   */
+  vector<double> coefficients;
+  /**
+   * Covariance matrix of the coefficients in row-major order. The row and
+   * column of \f$c_0\f$ vanish.
+   */
+  vector<double> covariance;
+  double amplitude; /**< Fitted value of the unnormalized \f$c_0\f$ for
+                      counts, or the sum of the weights of the events. */
+  double chi2;      /**< \f$\chi^2\f$ of a fit to counts, or zero. */
+  size_t n_degrees_of_freedom; /**< Number of degrees of freedom of a fit to
+                                  counts, or zero. */
+};
+
+/**
+ * \brief Result of the comparison of fitted expansion coefficients with the
+ * predictions of an angular correlation as a function of a mixing ratio.
+ */
+struct MixingRatioFitResult {
+  double x;    /**< Best-matching value of the variable \f$x\f$ of
+                  MixingRatioInverter, possibly \f$\pm \infty\f$. */
+  double chi2; /**< Value of \f$\chi^2\f$ at the minimum. */
+  vector<double> coefficients; /**< Predicted normalized coefficients at the
+                                  minimum, in the same order as in
+                                  LegendreFitResult. */
+};
+
+/**
+ * \brief Incremental linear least-squares fit of the expansion coefficients
+ * of an angular distribution.
+ *
+ * The angular correlations W_dir_dir and W_pol_dir are linear combinations of
+ * the functions
+ *
+ * \f[
+ *      g_i \left( \theta, \varphi \right) = P_{2i} \left[ \cos \left( \theta
+ * \right) \right], ~~ h_i \left( \theta, \varphi \right) = \cos \left(
+ * 2 \varphi \right) P_{2i+2}^{\left| 2 \right|} \left[ \cos \left( \theta
+ * \right) \right] \f]
+ *
+ * with the coefficients \f$c_i\f$ and \f$d_i\f$ (see
+ * W_gamma_gamma::get_legendre_coefficients()).
+ * A fitter accumulates sums over the measured data whose size depends only
+ * on \f$\nu_\mathrm{max}\f$, so adding data and solving for the coefficients
+ * is independent of the amount of data that has already been added.
+ * This makes it suitable for a monitoring application which updates the fit
+ * every few seconds.
+ * The data are given either as single events or as counts of detectors, and
+ * the two kinds cannot be mixed in a single fit.
+ *
+ * <b>Events</b>
+ *
+ * For events \f$\left( \theta_k, \varphi_k \right)\f$ with an acceptance
+ * that is uniform over the sphere (or corrected by the weights \f$w_k\f$ of
+ * the events), the functions \f$g_i\f$ and \f$h_i\f$ are orthogonal, and
+ * the coefficients are estimated by their moments [see, e.g., Eq. (14.17.6)
+ * in \cite DLMF2020]:
+ *
+ * \f[
+ *      \frac{c_i}{c_0} = \left( 4i + 1 \right) \left\langle g_i
+ * \right\rangle, ~~ \frac{d_i}{c_0} = \left( 4i + 5 \right) \frac{2
+ * \left( 2i \right)!}{\left( 2i + 4 \right)!} \left\langle h_i
+ * \right\rangle. \f]
+ *
+ * Here, \f$\langle f \rangle = \sum_k w_k f_k / \sum_k w_k\f$ is a weighted
+ * mean.
+ * The covariance matrix is estimated from the sample covariance of the
+ * functions, divided by the effective number of events
+ * \f$\left( \sum_k w_k \right)^2 / \sum_k w_k^2\f$.
+ *
+ * <b>Counts</b>
+ *
+ * The expected number of counts in a detector at the direction
+ * \f$\left( \theta_k, \varphi_k \right)\f$ with the relative efficiency
+ * \f$\epsilon_k\f$ and the attenuation coefficients \f$Q_{\nu, k}\f$ (see
+ * AttenuatedAngularCorrelation) is
+ *
+ * \f[
+ *      N_k = \epsilon_k \left[ \sum_i Q_{2i, k} c_i g_i \left( \theta_k,
+ * \varphi_k \right) + \sum_i Q_{2i + 2, k} d_i h_i \left( \theta_k, \varphi_k
+ * \right) \right], \f]
+ *
+ * which is linear in the unnormalized coefficients.
+ * The fitter accumulates the normal equations of a weighted linear
+ * least-squares fit with the variances \f$\mathrm{max} \left( N_k, 1
+ * \right)\f$ of the measured counts, and solves them with a Cholesky
+ * decomposition.
+ * The normalized coefficients and their covariance matrix are obtained by
+ * dividing by the fitted \f$c_0\f$ (the amplitude), with linear propagation
+ * of the uncertainties.
+ * At least as many counts as coefficients are needed, at directions which
+ * can distinguish all of them.
+ *
+ * <b>Mixing ratios</b>
+ *
+ * The coefficients of an angular correlation are ratios of polynomials in a
+ * mixing ratio (see MixingRatioInverter::coefficient_polynomials()).
+ * fit_mixing_ratio() minimizes
+ *
+ * \f[
+ *      \chi^2 \left( x \right) = \left[ \vec{a} - \vec{a} \left( x \right)
+ * \right]^T C^{-1} \left[ \vec{a} - \vec{a} \left( x \right) \right] \f]
+ *
+ * for the fitted normalized coefficients \f$\vec{a}\f$ (without \f$c_0\f$)
+ * and their covariance matrix \f$C\f$.
+ * Once the polynomials are known, \f$\chi^2 \left( x \right)\f$ costs only a
+ * few operations per coefficient, so the entire range \f$\arctan \left( x
+ * \right) \in \left[ -\pi/2, \pi/2 \right]\f$ is scanned on a grid, and the
+ * best grid point is refined by a golden-section search.
+ */
+class LegendreFitter {
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param nu_max Maximum order \f$\nu_\mathrm{max}\f$ of the expansion, an
+   * even number.
+   * \param polarized Determines whether the coefficients \f$d_i\f$ are
+   * fitted (default: false).
+   *
+   * \throw invalid_argument if nu_max is negative or odd.
+   */
+  LegendreFitter(const int nu_max, const bool polarized = false);
+
+  /**
+   * \brief Add an event.
+   *
+   * \param theta Polar angle in radians.
+   * \param phi Azimuthal angle in radians.
+   * \param weight Weight of the event (default: 1).
+   *
+   * \throw runtime_error if counts have been added.
+   */
+  void add_event(const double theta, const double phi,
+                 const double weight = 1.);
+
+  /**
+   * \brief Add many events.
+   *
+   * \param n Number of events.
+   * \param theta Polar angles in radians, array of length n.
+   * \param phi Azimuthal angles in radians, array of length n.
+   * \param weight Weights of the events, array of length n, or a null pointer
+   * for unit weights (default).
+   *
+   * \throw runtime_error if counts have been added.
+   */
+  void add_events(const size_t n, const double *theta, const double *phi,
+                  const double *weight = nullptr);
+
+  /**
+   * \brief Add the counts of a detector.
+   *
+   * Counts at the same direction may be added several times, for example for
+   * consecutive time intervals.
+   *
+   * \param theta Polar angle of the detector in radians.
+   * \param phi Azimuthal angle of the detector in radians.
+   * \param counts Number of counts.
+   * \param efficiency Relative efficiency \f$\epsilon\f$ (default: 1).
+   * \param attenuation Attenuation coefficients \f$Q_0, Q_2, ...,
+   * Q_{\nu_\mathrm{max}}\f$, or an empty vector for a point-like detector
+   * (default).
+   *
+   * \throw runtime_error if events have been added.
+   * \throw invalid_argument if the number of attenuation coefficients is
+   * wrong.
+   */
+  void add_counts(const double theta, const double phi, const double counts,
+                  const double efficiency = 1.,
+                  const vector<double> &attenuation = {});
+
+  /**
+   * \brief Solve for the expansion coefficients.
+   *
+   * \return Coefficients, their covariance matrix, and the quality of the
+   * fit.
+   *
+   * \throw runtime_error if no data have been added, or if the data do not
+   * determine all coefficients.
+   */
+  LegendreFitResult fit() const;
+
+  /**
+   * \brief Find the value of a mixing ratio whose angular correlation matches
+   * the fitted coefficients best.
+   *
+   * \param inverter Parametrization of the mixing ratios of an angular
+   * correlation. Coefficients of orders above its \f$\nu_\mathrm{max}\f$, and
+   * the coefficients \f$d_i\f$ of a dir-dir correlation, are predicted to be
+   * zero.
+   * \param n_grid Number of grid points for \f$\arctan \left( x \right)\f$
+   * (default: 1000).
+   *
+   * \return Best-matching value of \f$x\f$, \f$\chi^2\f$, and the
+   * predicted coefficients.
+   *
+   * \throw runtime_error in the same cases as fit().
+   */
+  MixingRatioFitResult fit_mixing_ratio(const MixingRatioInverter &inverter,
+                                        const size_t n_grid = 1000) const;
+
+  /**
+   * \brief Remove all data.
+   */
+  void reset();
+
+  /**
+   * \brief Maximum order \f$\nu_\mathrm{max}\f$ of the expansion.
+   */
+  int get_nu_max() const { return nu_max; }
+
+  /**
+   * \brief Whether the coefficients \f$d_i\f$ are fitted.
+   */
+  bool is_polarized() const { return polarized; }
+
+  /**
+   * \brief Number of coefficients, including \f$c_0\f$.
+   */
+  size_t get_n_coefficients() const { return n_coefficients; }
+
+  /**
+   * \brief Number of events or counts that have been added.
+   */
+  size_t get_n_entries() const { return n_entries; }
+
+protected:
+  /**
+   * \brief Evaluate the functions \f$g_i\f$ and \f$h_i\f$ at a direction.
+   */
+  void basis_functions(const double theta, const double phi,
+                       double *g) const;
+
+  /**
+   * \brief Add the weighted outer product of a vector with itself, and the
+   * vector times a weighted scalar, to the sums.
+   */
+  void accumulate(const double *g, const double weight, const double y);
+
+  /** Type of the data that have been added. */
+  enum class Mode { empty, events, counts };
+
+  int nu_max;            /**< \f$\nu_\mathrm{max}\f$ */
+  bool polarized;        /**< Whether the \f$d_i\f$ are fitted */
+  size_t n_coefficients; /**< Number of coefficients */
+  Mode mode;             /**< Type of the data */
+  size_t n_entries;      /**< Number of events or counts */
+  /**
+   * Sums of the products of two functions, times the weight of an event or
+   * the inverse variance of the counts, in row-major order.
+   */
+  vector<double> sum_gg;
+  /**
+   * Sums of the functions times the weight of an event, or times the counts
+   * divided by their variance.
+   */
+  vector<double> sum_g;
+  double sum_w;   /**< Sum of the weights of the events. */
+  double sum_w2;  /**< Sum of the squared weights of the events. */
+  double sum_wyy; /**< Sum of the squared counts divided by their variance. */
+};
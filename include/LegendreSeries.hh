@@ -0,0 +1,293 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * \brief Functions to evaluate series of Legendre polynomials for many
+ * arguments at once.
+ *
+ * The angular correlations in this library are series of Legendre polynomials
+ * \f$P_{2i}\f$ and associated Legendre polynomials \f$P_{2i}^{\left| 2
+ * \right|}\f$ of even order (see W_dir_dir and W_pol_dir).
+ * Instead of evaluating each polynomial separately as in the call operators of
+ * the angular correlations, the functions in this namespace calculate all
+ * orders at once using the standard three-term recurrence relation [see, e.g.,
+ * Eq. (14.10.3) in \cite DLMF2020]:
+ *
+ * \f[
+ *      \left( l - m \right) P_l^m \left( x \right) = \left( 2l - 1 \right) x
+ * P_{l-1}^m \left( x \right) - \left( l + m - 1 \right) P_{l-2}^m \left( x
+ * \right), \f]
+ *
+ * starting from \f$P_0 = 1\f$, \f$P_1 \left( x \right) = x\f$, and
+ * \f$P_1^2 = 0\f$, \f$P_2^2 \left( x \right) = 3 \left( 1 - x^2 \right)\f$.
+ * Up to rounding errors, the results agree with gsl_sf_legendre_Pl() and
+ * gsl_sf_legendre_Plm() \cite Galassi2009, i.e. they include the
+ * Condon-Shortley phase.
+ *
+ * The arguments are processed in blocks of
+ * legendre_series::block_size elements.
+ * Inside a block, the recurrence is advanced for all elements in a loop without
+ * branches or function calls, which allows the compiler to vectorize it using
+ * the instruction set of the target architecture (for example AVX2 or
+ * AVX-512 when alpaca is configured with the BUILD_NATIVE option).
+ * Without any vector extensions, the same code is executed element by element.
+ */
+namespace legendre_series {
+
+/**
+ * \brief Number of arguments which are processed at once.
+ */
+constexpr size_t block_size = 64;
+
+/**
+ * \brief Upper limit for the error of the single-precision evaluation of an
+ * angular correlation, relative to its upper limit.
+ *
+ * For \f$\nu_\mathrm{max} \leq 16\f$ and \f$\varphi \in \left[ 0, 2\pi
+ * \right]\f$, the single-precision batch evaluation of W_dir_dir and
+ * W_pol_dir deviates from the double-precision result by at most
+ * float_relative_error times W_gamma_gamma::get_upper_limit().
+ * The largest deviation found in tests is about \f$2 \times 10^{-6}\f$ for
+ * \f$\nu_\mathrm{max} = 16\f$, mostly due to the rounding of
+ * \f$\cos \left( \theta \right)\f$.
+ * Since the recurrence relations are stable for \f$\left| x \right| \leq
+ * 1\f$, the rounding errors of the individual terms do not grow
+ * exponentially, and the error is a small multiple of the machine epsilon of
+ * float, \f$2^{-23} \approx 1.2 \times 10^{-7}\f$.
+ * Close to the zeros of \f$W\f$, the error relative to \f$W\f$ itself can be
+ * much larger.
+ */
+constexpr double float_relative_error = 1e-5;
+
+/**
+ * \brief Evaluate a series of Legendre polynomials of even order.
+ *
+ * \f[
+ *      s \left( x_k \right) = \sum_{i=0}^{n_c - 1} c_i P_{2i} \left( x_k
+ * \right) \f]
+ *
+ * \param n Number of arguments.
+ * \param x Arguments \f$x_k \in \left[ -1, 1 \right]\f$ (usually \f$\cos
+ * \left( \theta_k \right)\f$), array of length n.
+ * \param n_coefficients Number of coefficients \f$n_c\f$.
+ * \param coefficients Coefficients \f$c_i\f$, array of length n_coefficients.
+ * \param result Array of length n for the values \f$s \left( x_k \right)\f$.
+ */
+void legendre(const size_t n, const double *x, const size_t n_coefficients,
+              const double *coefficients, double *result);
+
+/**
+ * \brief Evaluate a series of Legendre polynomials of even order in single
+ * precision.
+ *
+ * Same as legendre(const size_t, const double *, const size_t, const double
+ * *, double *), but all arguments, coefficients, and intermediate results are
+ * of type float.
+ * This doubles the number of elements per SIMD register and halves the memory
+ * bandwidth.
+ * The absolute error is of the order of a few units of \f$10^{-7}\f$ times
+ * \f$\sum_i \left| c_i \right|\f$ (see float_relative_error).
+ */
+void legendre(const size_t n, const float *x, const size_t n_coefficients,
+              const float *coefficients, float *result);
+
+/**
+ * \brief Evaluate a series of associated Legendre polynomials of even order
+ * with \f$m = 2\f$.
+ *
+ * \f[
+ *      s \left( x_k \right) = \sum_{i=0}^{n_c - 1} c_i P_{2i+2}^{\left| 2
+ * \right|} \left( x_k \right) \f]
+ *
+ * Note that the series starts with \f$P_2^{\left| 2 \right|}\f$, since the
+ * associated Legendre polynomials with \f$l < m\f$ vanish.
+ *
+ * \param n Number of arguments.
+ * \param x Arguments \f$x_k \in \left[ -1, 1 \right]\f$ (usually \f$\cos
+ * \left( \theta_k \right)\f$), array of length n.
+ * \param n_coefficients Number of coefficients \f$n_c\f$.
+ * \param coefficients Coefficients \f$c_i\f$, array of length n_coefficients.
+ * \param result Array of length n for the values \f$s \left( x_k \right)\f$.
+ */
+void associated_legendre_2(const size_t n, const double *x,
+                           const size_t n_coefficients,
+                           const double *coefficients, double *result);
+
+/**
+ * \brief Evaluate a series of associated Legendre polynomials of even order
+ * with \f$m = 2\f$ in single precision.
+ *
+ * See legendre(const size_t, const float *, const size_t, const float *,
+ * float *).
+ */
+void associated_legendre_2(const size_t n, const float *x,
+                           const size_t n_coefficients,
+                           const float *coefficients, float *result);
+
+/**
+ * \brief Evaluate the derivative of a series of Legendre polynomials of even
+ * order.
+ *
+ * \f[
+ *      s^\prime \left( x_k \right) = \sum_{i=0}^{n_c - 1} c_i
+ * \frac{\mathrm{d} P_{2i}}{\mathrm{d} x} \left( x_k \right) \f]
+ *
+ * The derivatives are obtained from the derivative of the three-term
+ * recurrence relation with respect to \f$x\f$:
+ *
+ * \f[
+ *      \left( l - m \right) P_l^{m \prime} = \left( 2l - 1 \right) \left(
+ * P_{l-1}^m + x P_{l-1}^{m \prime} \right) - \left( l + m - 1 \right)
+ * P_{l-2}^{m \prime}. \f]
+ *
+ * \param n Number of arguments.
+ * \param x Arguments \f$x_k \in \left[ -1, 1 \right]\f$, array of length n.
+ * \param n_coefficients Number of coefficients \f$n_c\f$.
+ * \param coefficients Coefficients \f$c_i\f$, array of length n_coefficients.
+ * \param result Array of length n for the values \f$s^\prime \left( x_k
+ * \right)\f$.
+ */
+void legendre_derivative(const size_t n, const double *x,
+                         const size_t n_coefficients,
+                         const double *coefficients, double *result);
+
+/**
+ * \brief Evaluate the derivative of a series of associated Legendre
+ * polynomials of even order with \f$m = 2\f$.
+ *
+ * Derivative of the series of associated_legendre_2() with respect to
+ * \f$x\f$, calculated like in legendre_derivative().
+ *
+ * \param n Number of arguments.
+ * \param x Arguments \f$x_k \in \left[ -1, 1 \right]\f$, array of length n.
+ * \param n_coefficients Number of coefficients \f$n_c\f$.
+ * \param coefficients Coefficients \f$c_i\f$, array of length n_coefficients.
+ * \param result Array of length n for the values \f$s^\prime \left( x_k
+ * \right)\f$.
+ */
+void associated_legendre_2_derivative(const size_t n, const double *x,
+                                      const size_t n_coefficients,
+                                      const double *coefficients,
+                                      double *result);
+
+/**
+ * \brief Power series of a combination of a series of Legendre polynomials and
+ * a series of associated Legendre polynomials.
+ *
+ * \f[
+ *      s \left( x \right) + \sigma s_2 \left( x \right) =
+ * \sum_{k=0}^{l_\mathrm{max}} a_k x^k, \f]
+ *
+ * where \f$s\f$ is the series of legendre() and \f$s_2\f$ the series of
+ * associated_legendre_2().
+ * The polynomials are constructed from the same recurrence relations as in
+ * legendre() and associated_legendre_2().
+ *
+ * \param n_coefficients Number of coefficients of \f$s\f$.
+ * \param coefficients Coefficients of \f$s\f$, array of length
+ * n_coefficients.
+ * \param n_coefficients_2 Number of coefficients of \f$s_2\f$.
+ * \param coefficients_2 Coefficients of \f$s_2\f$, array of length
+ * n_coefficients_2.
+ * \param sigma \f$\sigma\f$, factor of \f$s_2\f$.
+ *
+ * \return Coefficients \f$a_k\f$, ordered by increasing \f$k\f$.
+ */
+vector<double> power_series(const size_t n_coefficients,
+                            const double *coefficients,
+                            const size_t n_coefficients_2,
+                            const double *coefficients_2, const double sigma);
+
+/**
+ * \brief Global maximum of the sum of the absolute values of a series of
+ * Legendre polynomials and a series of associated Legendre polynomials.
+ *
+ * \f[
+ *      \mathrm{max}_{x \in \left[ -1, 1 \right]} \left| s \left( x \right)
+ * \right| + \left| s_2 \left( x \right) \right|, \f]
+ *
+ * where \f$s\f$ is the series of legendre() and \f$s_2\f$ the series of
+ * associated_legendre_2().
+ * This is the maximum of the absolute value of a function
+ * \f$s \left( x \right) + \cos \left( 2 \varphi \right) s_2 \left( x
+ * \right)\f$ on the unit sphere, like the pol-dir correlation W_pol_dir.
+ *
+ * Both series are polynomials in \f$x\f$.
+ * Since the maximum of each of the polynomials \f$\pm \left( s \pm s_2
+ * \right)\f$ is located either at the boundaries of the interval or at a
+ * root of the derivative of \f$s \pm s_2\f$, it is sufficient to evaluate
+ * \f$\left| s \right| + \left| s_2 \right|\f$ at these points.
+ * The series are converted to a power series, and the roots of its derivative
+ * are found with gsl_poly_complex_solve() \cite Galassi2009.
+ * The real parts of all roots are used as candidates, which makes the result
+ * insensitive to the numerical error of the imaginary parts of multiple
+ * roots.
+ *
+ * \param n_coefficients Number of coefficients \f$n_c\f$ of \f$s\f$.
+ * \param coefficients Coefficients of \f$s\f$, array of length
+ * n_coefficients.
+ * \param n_coefficients_2 Number of coefficients of \f$s_2\f$.
+ * \param coefficients_2 Coefficients of \f$s_2\f$, array of length
+ * n_coefficients_2.
+ *
+ * \return Global maximum.
+ */
+double maximum(const size_t n_coefficients, const double *coefficients,
+               const size_t n_coefficients_2, const double *coefficients_2);
+
+/**
+ * \brief Integrals of the Legendre polynomials of even order over a cone.
+ *
+ * \f[
+ *      J_{2i} \left( \alpha \right) = 2 \pi \int_{\cos \left( \alpha
+ * \right)}^1 P_{2i} \left( x \right) \mathrm{d} x = 2 \pi \frac{P_{2i-1}
+ * \left[ \cos \left( \alpha \right) \right] - P_{2i+1} \left[ \cos
+ * \left( \alpha \right) \right]}{4i + 1}, \f]
+ *
+ * with \f$J_0 = 2 \pi \left[ 1 - \cos \left( \alpha \right) \right]\f$,
+ * the solid angle of a cone with the opening angle (half angle) \f$\alpha\f$.
+ * The second equality follows from \f$\left( 2l + 1 \right) P_l =
+ * P_{l+1}^\prime - P_{l-1}^\prime\f$ [Eq. (14.10.7) in \cite DLMF2020].
+ *
+ * By the Funk-Hecke theorem, the integral of any spherical harmonic
+ * \f$Y_l\f$ of order \f$l\f$ over a cone around the direction
+ * \f$\Omega_0\f$ is \f$J_l \left( \alpha \right) Y_l \left( \Omega_0
+ * \right)\f$ (see, e.g., \cite Rose1953).
+ * The ratios \f$Q_l = J_l / J_0\f$ are the attenuation coefficients of a
+ * detector that covers the cone uniformly.
+ *
+ * \param n_orders Number of even orders.
+ * \param cos_alpha Cosine of the opening angle, \f$\cos \left( \alpha
+ * \right) \in \left[ -1, 1 \right]\f$.
+ * \param result Array of length n_orders for the values \f$J_{2i}\f$.
+ */
+void cone_integrals(const size_t n_orders, const double cos_alpha,
+                    double *result);
+
+} // namespace legendre_series
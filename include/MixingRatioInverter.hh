@@ -0,0 +1,289 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+
+/**
+ * \brief Find all multipole mixing ratios that are consistent with a measured
+ * angular correlation or asymmetry.
+ *
+ * It is assumed that all mixing ratios \f$\delta_j\f$ of a cascade depend on
+ * a single real variable \f$x\f$ via
+ *
+ * \f[
+ *      \delta_j \left( x \right) = a_j x + b_j.
+ * \f]
+ *
+ * This includes mixing ratios that are equal to the variable (\f$a_j = 1\f$,
+ * \f$b_j = 0\f$), fixed mixing ratios (\f$a_j = 0\f$, \f$b_j = \delta_j\f$),
+ * and mixing ratios with the opposite sign, as they appear when two
+ * conventions for the mixing ratio are mixed (\f$a_j = -1\f$, \f$b_j = 0\f$).
+ *
+ * The expansion coefficients of W_dir_dir and W_pol_dir are products of
+ * factors that are quadratic polynomials in the mixing ratio of a single
+ * transition, divided by the normalization factor \f$\prod_j \left( 1 +
+ * \delta_j^2 \right)\f$.
+ * At a fixed direction, the angular correlation is therefore a rational
+ * function
+ *
+ * \f[
+ *      W_{\gamma \gamma} \left( x \right) = \frac{\tilde{W} \left( x
+ * \right)}{\prod_j \left[ 1 + \delta_j^2 \left( x \right) \right]}, \f]
+ *
+ * whose numerator \f$\tilde{W}\f$ and denominator are polynomials of degree
+ * \f$2m\f$ or less, with \f$m\f$ the number of mixing ratios that depend on
+ * \f$x\f$ (a quartic polynomial for an elastic two-step cascade).
+ * The analyzing power (see the Python class AnalyzingPower)
+ *
+ * \f[
+ *      A \left( x \right) = P Q \frac{W_{\gamma \gamma} \left( \theta,
+ * \varphi, x \right) - W_{\gamma \gamma} \left( \theta^\prime,
+ * \varphi^\prime, x \right)}{W_{\gamma \gamma} \left( \theta, \varphi, x
+ * \right) + W_{\gamma \gamma} \left( \theta^\prime, \varphi^\prime, x
+ * \right)} \f]
+ *
+ * is a ratio of the same kind, since the normalization factor cancels.
+ *
+ * For a ratio \f$f = N / D\f$ with \f$D > 0\f$, the set of \f$x\f$ for which
+ * \f$f\f$ lies inside a measured range \f$\left[ f_0 - \Delta f, f_0 + \Delta
+ * f \right]\f$ is bounded by the real roots of the polynomials
+ * \f$N - \left( f_0 \pm \Delta f \right) D\f$.
+ * Their coefficients are obtained by interpolating \f$N\f$ and \f$D\f$ at
+ * \f$2m + 1\f$ values of \f$x\f$, and their roots are found with
+ * gsl_poly_complex_solve() \cite Galassi2009.
+ * Since \f$f\f$ is continuous, each range between two neighboring roots is
+ * either completely inside or completely outside of the solution set, which
+ * is tested at its center.
+ * In contrast to the inversion of a tabulated function (see
+ * inversion_by_grid_evaluation.py in the Python package), the limits of the
+ * intervals are exact up to rounding errors, and no interval can be missed
+ * due to a coarse grid.
+ *
+ * The range of \f$x\f$ is the entire real axis, including the limits
+ * \f$x \to \pm \infty\f$ which correspond to pure transitions with the
+ * secondary multipolarity.
+ * For this reason, the intervals are determined for \f$\arctan \left( x
+ * \right) \in \left[ -\pi/2, \pi/2 \right]\f$.
+ * If they are requested in terms of \f$x\f$, the limits \f$\pm \pi/2\f$ are
+ * converted to \f$\pm \infty\f$.
+ * Note that \f$x \to -\infty\f$ and \f$x \to \infty\f$ describe the same
+ * physical situation, so an interval that contains one of the limits is
+ * continued at the other limit.
+ * Such intervals are returned as two separate intervals.
+ *
+ * The intervals are sorted in ascending order, and the lower limit of each
+ * interval comes first.
+ * This is the format of the lists of intervals in interval_intersections.py.
+ * Intervals whose lower and upper limits are equal indicate single values
+ * of \f$x\f$, for example if the uncertainty of the measured value is zero.
+ *
+ * An object of this class stores a reference to an AngularCorrelation object,
+ * which must outlive it.
+ */
+class MixingRatioInverter {
+
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param ang_cor Angular correlation.
+   * \param slope Coefficients \f$a_j\f$, one for each cascade step.
+   * \param offset Coefficients \f$b_j\f$, one for each cascade step (default:
+   * empty vector, i.e. \f$b_j = 0\f$ for all steps).
+   *
+   * \throw invalid_argument if the number of coefficients does not match the
+   * number of cascade steps.
+   */
+  MixingRatioInverter(const AngularCorrelation &ang_cor,
+                      const vector<double> &slope,
+                      const vector<double> &offset = {});
+
+  /**
+   * \brief Mixing ratios for a given value of the variable.
+   *
+   * \param x Variable \f$x\f$.
+   *
+   * \return \f$\delta_j \left( x \right) = a_j x + b_j\f$ for all cascade
+   * steps.
+   */
+  vector<double> get_deltas(const double x) const;
+
+  /**
+   * \brief Power-series coefficients of the unnormalized angular correlation
+   * at a given direction.
+   *
+   * \param theta Polar angle in spherical coordinates in radians.
+   * \param phi Azimuthal angle in spherical coordinates in radians.
+   *
+   * \return Coefficients \f$c_k\f$ of \f$\tilde{W} \left( x \right) =
+   * \sum_{k=0}^{2m} c_k x^k\f$.
+   */
+  vector<double> polynomial(const double theta, const double phi) const;
+
+  /**
+   * \brief Power-series coefficients of the unnormalized expansion
+   * coefficients.
+   *
+   * Like the angular correlation at a fixed direction, each of the normalized
+   * expansion coefficients \f$c_i\f$ and \f$d_i\f$ (see
+   * W_gamma_gamma::get_legendre_coefficients()) is a polynomial of degree
+   * \f$2m\f$ or less in \f$x\f$, divided by the normalization polynomial.
+   * The polynomials are interpolated from the coefficients of angular
+   * correlations with the mixing ratios at \f$2m + 1\f$ values of \f$x\f$.
+   *
+   * \return Coefficients of the polynomials for \f$c_0, c_1, ...\f$,
+   * followed by those for \f$d_0, d_1, ...\f$.
+   */
+  vector<vector<double>> coefficient_polynomials() const;
+
+  /**
+   * \brief Power-series coefficients of the normalization polynomial.
+   *
+   * \return Coefficients \f$c_k\f$ of \f$\prod_j \left[ 1 + \delta_j^2
+   * \left( x \right) \right] = \sum_{k=0}^{2m} c_k x^k\f$.
+   */
+  vector<double> normalization_polynomial() const;
+
+  /**
+   * \brief Find all intervals of the variable for which the angular
+   * correlation at a given direction is consistent with a measured value.
+   *
+   * \param theta Polar angle in spherical coordinates in radians.
+   * \param phi Azimuthal angle in spherical coordinates in radians.
+   * \param value Measured value \f$W_0\f$.
+   * \param uncertainty Uncertainty \f$\Delta W \geq 0\f$ of the measured
+   * value.
+   * \param return_arctan Determines whether the limits of the intervals are
+   * given as \f$x\f$ (false, default) or \f$\arctan \left( x \right)\f$ (true).
+   *
+   * \return Sorted intervals of \f$x\f$ (or \f$\arctan \left( x \right)\f$)
+   * for which \f$W_{\gamma \gamma} \left( \theta, \varphi, x \right) \in
+   * \left[ W_0 - \Delta W, W_0 + \Delta W \right]\f$.
+   *
+   * \throw invalid_argument if the uncertainty is negative.
+   */
+  vector<array<double, 2>>
+  invert_angular_correlation(const double theta, const double phi,
+                             const double value, const double uncertainty,
+                             const bool return_arctan = false) const;
+
+  /**
+   * \brief Find all intervals of the variable for which the asymmetry
+   * between two directions is consistent with a measured value.
+   *
+   * \param theta Polar angle \f$\theta\f$ in radians.
+   * \param thetap Polar angle \f$\theta^\prime\f$ in radians.
+   * \param phi Azimuthal angle \f$\varphi\f$ in radians.
+   * \param phip Azimuthal angle \f$\varphi^\prime\f$ in radians.
+   * \param PQ Product of the photon polarization and the polarization
+   * sensitivity. A negative sign switches to the KPZ convention of the
+   * analyzing power.
+   * \param value Measured asymmetry \f$\epsilon_0\f$.
+   * \param uncertainty Uncertainty \f$\Delta \epsilon \geq 0\f$ of the
+   * measured asymmetry.
+   * \param return_arctan Determines whether the limits of the intervals are
+   * given as \f$x\f$ (false, default) or \f$\arctan \left( x \right)\f$ (true).
+   *
+   * \return Sorted intervals of \f$x\f$ (or \f$\arctan \left( x \right)\f$)
+   * for which \f$A \left( x \right) \in \left[ \epsilon_0 - \Delta \epsilon,
+   * \epsilon_0 + \Delta \epsilon \right]\f$.
+   *
+   * \throw invalid_argument if the uncertainty is negative.
+   */
+  vector<array<double, 2>>
+  invert_analyzing_power(const double theta, const double thetap,
+                         const double phi, const double phip, const double PQ,
+                         const double value, const double uncertainty,
+                         const bool return_arctan = false) const;
+
+  /**
+   * \brief Find all intervals for which a ratio of two polynomials lies
+   * inside a given range.
+   *
+   * \param numerator Power-series coefficients of \f$N\f$.
+   * \param denominator Power-series coefficients of \f$D\f$, which must be
+   * positive for all finite \f$x\f$.
+   * \param lower Lower limit of the range.
+   * \param upper Upper limit of the range.
+   * \param return_arctan Determines whether the limits of the intervals are
+   * given as \f$x\f$ (false) or \f$\arctan \left( x \right)\f$ (true).
+   *
+   * \return Sorted intervals of \f$x\f$ (or \f$\arctan \left( x \right)\f$)
+   * for which \f$N \left( x \right) / D \left( x \right) \in \left[
+   * \mathrm{lower}, \mathrm{upper} \right]\f$.
+   */
+  static vector<array<double, 2>>
+  invert_rational_function(const vector<double> &numerator,
+                           const vector<double> &denominator,
+                           const double lower, const double upper,
+                           const bool return_arctan);
+
+  /**
+   * \brief Number of cascade steps whose mixing ratio depends on the
+   * variable.
+   */
+  size_t get_n_variable_deltas() const { return n_variable_deltas; }
+
+  /**
+   * \brief Return the angular correlation.
+   */
+  const AngularCorrelation &get_angular_correlation() const {
+    return angular_correlation;
+  }
+
+protected:
+  /**
+   * \brief Interpolate the polynomials \f$\tilde{W}\f$ for several
+   * directions.
+   *
+   * \param theta Polar angles in radians.
+   * \param phi Azimuthal angles in radians.
+   *
+   * \return Power-series coefficients for each direction.
+   */
+  vector<vector<double>> polynomials(const vector<double> &theta,
+                                     const vector<double> &phi) const;
+
+  /**
+   * \brief Values of the variable at which the polynomials are interpolated.
+   */
+  vector<double> nodes() const;
+
+  /**
+   * \brief Power-series coefficients of the polynomial of degree n - 1 that
+   * passes through n points.
+   */
+  static vector<double> interpolate(const vector<double> &x,
+                                    const vector<double> &y);
+
+  const AngularCorrelation &angular_correlation;
+  vector<double> slope;
+  vector<double> offset;
+  size_t n_variable_deltas;
+};
@@ -0,0 +1,250 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <cstdint>
+
+using std::uint64_t;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "RandomEngine.hh"
+
+/**
+ * \brief Types of distributions of a multipole mixing ratio.
+ */
+enum MixingRatioDistributionType : short {
+  fixed_delta = 0,    /**< Fixed value of \f$\delta\f$. */
+  gaussian_delta = 1, /**< Normal distribution of \f$\delta\f$. */
+  gaussian_arctan_delta =
+      2, /**< Normal distribution of \f$\arctan \left( \delta \right)\f$. */
+  proportional_delta =
+      3, /**< Proportional to the mixing ratio of a previous cascade step. */
+};
+
+/**
+ * \brief Distribution of the multipole mixing ratio of a single cascade step.
+ *
+ * The meaning of the parameters depends on the type:
+ *
+ *  - fixed_delta: \f$\delta_j\f$ = value.
+ *  - gaussian_delta: \f$\delta_j\f$ is normally distributed with the mean
+ * value and the standard deviation sigma.
+ *  - gaussian_arctan_delta: \f$\arctan \left( \delta_j \right)\f$ is normally
+ * distributed with the mean \f$\arctan \left( \mathrm{value} \right)\f$ and
+ * the standard deviation sigma in radians.
+ * This is the natural choice for a mixing ratio that was determined on the
+ * arctangent-compressed axis of arctan_grid() in the Python package.
+ * Since \f$\delta \to -\infty\f$ and \f$\delta \to \infty\f$ describe the
+ * same physical situation, the distribution wraps around at \f$\pm \pi / 2\f$.
+ *  - proportional_delta: \f$\delta_j\f$ = value times
+ * \f$\delta_\mathrm{step}\f$.
+ * For example, the two mixing ratios of an elastic two-step cascade are equal
+ * (value = 1) in the convention of Biedenharn and Rose, and have opposite
+ * signs (value = -1) if the convention of Krane, Steffen, and Wheeler is used
+ * for the first one.
+ */
+struct MixingRatioDistribution {
+  MixingRatioDistributionType type; /**< Type of the distribution. */
+  double value;                     /**< Central value or factor. */
+  double sigma = 0.;                /**< Standard deviation. */
+  size_t step = 0; /**< Index of the cascade step for proportional_delta. */
+};
+
+/**
+ * \brief Statistics of a set of observables over random draws of the mixing
+ * ratios.
+ */
+struct PropagationResult {
+  size_t n_draws;        /**< Number of draws \f$n\f$. */
+  size_t n_observables;  /**< Number of observables \f$m\f$. */
+  vector<double> mean;   /**< Mean values, length \f$m\f$. */
+  vector<double>
+      covariance; /**< Sample covariance matrix (normalized by
+                     \f$n - 1\f$), \f$m \times m\f$ in row-major order. */
+  vector<double> probabilities; /**< Probabilities of the quantiles. */
+  vector<double> quantiles; /**< Quantiles, one row of length \f$m\f$ for each
+                               probability. */
+  vector<double> samples; /**< Values of the observables, one row of length
+                             \f$m\f$ for each draw. */
+};
+
+/**
+ * \brief Monte Carlo propagation of the uncertainties of multipole mixing
+ * ratios, and of the spins of a cascade, to angular correlations and
+ * analyzing powers.
+ *
+ * Each draw selects one of several hypotheses for the cascade, for example
+ * different spin assignments, according to their probabilities, and draws
+ * the mixing ratios of all its steps from their distributions (see
+ * MixingRatioDistribution).
+ * Instead of creating a new AngularCorrelation object for each draw, all
+ * draws of a hypothesis are evaluated in a single call of
+ * AngularCorrelation::scan_deltas(), which evaluates the expansion
+ * coefficients as polynomials of the mixing ratios and the (associated)
+ * Legendre polynomials for all directions in a batch.
+ * The mean values, the covariance matrix, and the quantiles of the
+ * observables are accumulated from the matrix of all draws.
+ * The quantiles are interpolated linearly between the order statistics,
+ * which is the default method of numpy.quantile().
+ *
+ * The draws are reproducible for a given seed.
+ */
+class MixingRatioPropagator {
+public:
+  /**
+   * \brief Constructor for several hypotheses
+   *
+   * \param hypotheses Angular correlations of the hypotheses. The mixing
+   * ratios of their transitions are ignored.
+   * \param distributions Distributions of the mixing ratios of all cascade
+   * steps for each hypothesis.
+   * \param probabilities Probabilities of the hypotheses. They are
+   * normalized by their sum.
+   * \param seed Random number seed (default: 0).
+   *
+   * \throw invalid_argument if the numbers of hypotheses, distributions, or
+   * probabilities do not match, if a probability or a standard deviation is
+   * negative, or if a proportional_delta refers to the same or a later step.
+   */
+  MixingRatioPropagator(
+      const vector<AngularCorrelation> &hypotheses,
+      const vector<vector<MixingRatioDistribution>> &distributions,
+      const vector<double> &probabilities, const uint64_t seed = 0);
+
+  /**
+   * \brief Constructor for a single cascade
+   *
+   * \param ang_cor Angular correlation.
+   * \param distributions Distributions of the mixing ratios of all cascade
+   * steps.
+   * \param seed Random number seed (default: 0).
+   *
+   * \throw invalid_argument in the same cases as the general constructor.
+   */
+  MixingRatioPropagator(const AngularCorrelation &ang_cor,
+                        const vector<MixingRatioDistribution> &distributions,
+                        const uint64_t seed = 0)
+      : MixingRatioPropagator(vector<AngularCorrelation>{ang_cor},
+                              {distributions}, {1.}, seed) {}
+
+  /**
+   * \brief Propagate the uncertainties to the angular correlation at several
+   * directions.
+   *
+   * \param n_draws Number of draws, at least two.
+   * \param theta Polar angles in radians.
+   * \param phi Azimuthal angles in radians, same length as theta.
+   * \param probabilities Probabilities of the quantiles (default: the median
+   * and the limits of the central 68.27 % interval).
+   *
+   * \return Statistics of \f$W \left( \theta_k, \varphi_k \right)\f$.
+   *
+   * \throw invalid_argument if the numbers of angles do not match, if there
+   * are less than two draws, or if a probability is outside of
+   * \f$\left[ 0, 1 \right]\f$.
+   */
+  PropagationResult
+  angular_correlation(const size_t n_draws, const vector<double> &theta,
+                      const vector<double> &phi,
+                      const vector<double> &probabilities = {
+                          0.158655, 0.5, 0.841345});
+
+  /**
+   * \brief Propagate the uncertainties to the analyzing power for several
+   * pairs of directions.
+   *
+   * The analyzing power is defined like in the Python class AnalyzingPower
+   * and in MixingRatioInverter::invert_analyzing_power().
+   *
+   * \param n_draws Number of draws, at least two.
+   * \param theta Polar angles \f$\theta_k\f$ in radians.
+   * \param thetap Polar angles \f$\theta_k^\prime\f$ in radians.
+   * \param phi Azimuthal angles \f$\varphi_k\f$ in radians.
+   * \param phip Azimuthal angles \f$\varphi_k^\prime\f$ in radians.
+   * \param PQ Product of the photon polarization and the polarization
+   * sensitivity.
+   * \param probabilities Probabilities of the quantiles.
+   *
+   * \return Statistics of the analyzing powers \f$A_k\f$.
+   *
+   * \throw invalid_argument in the same cases as angular_correlation().
+   */
+  PropagationResult
+  analyzing_power(const size_t n_draws, const vector<double> &theta,
+                  const vector<double> &thetap, const vector<double> &phi,
+                  const vector<double> &phip, const double PQ,
+                  const vector<double> &probabilities = {0.158655, 0.5,
+                                                         0.841345});
+
+  /**
+   * \brief Draw sets of mixing ratios for a hypothesis.
+   *
+   * \param hypothesis Index of the hypothesis.
+   * \param n Number of sets.
+   *
+   * \return Mixing ratios, the set \f$k\f$ starts at the index \f$k\f$ times
+   * the number of cascade steps of the hypothesis (see
+   * AngularCorrelation::scan_deltas()).
+   */
+  vector<double> draw_deltas(const size_t hypothesis, const size_t n);
+
+  /**
+   * \brief Reseed the random number generator.
+   */
+  void reseed(const uint64_t seed) { random_engine.seed(seed); }
+
+  /**
+   * \brief Number of hypotheses.
+   */
+  size_t get_n_hypotheses() const { return hypotheses.size(); }
+
+protected:
+  /**
+   * \brief Draw the mixing ratios and evaluate the angular correlation at
+   * several directions.
+   *
+   * \return Values for all draws, one row of length n_angles per draw.
+   */
+  vector<double> scan(const size_t n_draws, const vector<double> &theta,
+                      const vector<double> &phi);
+
+  /**
+   * \brief Calculate the statistics of a matrix of draws.
+   */
+  static PropagationResult statistics(const size_t n_draws,
+                                      const size_t n_observables,
+                                      vector<double> samples,
+                                      const vector<double> &probabilities);
+
+  vector<AngularCorrelation> hypotheses; /**< Hypotheses for the cascade. */
+  vector<vector<MixingRatioDistribution>>
+      distributions;              /**< Distributions of the mixing ratios. */
+  vector<double> probabilities;   /**< Cumulative probabilities of the
+                                     hypotheses. */
+  Xoshiro256PlusPlus random_engine; /**< Random number generator. */
+};
@@ -0,0 +1,114 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <functional>
+
+using std::function;
+
+#include <vector>
+
+using std::vector;
+
+#include "CascadeSampler.hh"
+
+/**
+ * \brief Sample many cascades in parallel with reproducible results.
+ *
+ * The samplers of the individual steps of a cascade (ReferenceFrameSampler)
+ * are stateful objects with their own random number engines.
+ * Therefore, this class does not share samplers between threads, but a
+ * user-defined function creates an independent CascadeSampler for each
+ * thread.
+ * The function is called once per thread on construction.
+ *
+ * The events are divided into chunks of a fixed size \f$n_c\f$, which are
+ * distributed dynamically among the threads.
+ * Before chunk number \f$c\f$ is sampled, the random number engines of the
+ * CascadeSampler are reseeded with the master seed and the stream index
+ * \f$c\f$ (see CascadeSampler::reseed()).
+ * Each chunk is written to its own part of the output array.
+ * Since neither the random numbers of a chunk nor its position in the output
+ * depend on the thread that processed it, the result for a given master seed
+ * and chunk size is independent of the number of threads.
+ *
+ * The threads do not share any data except for a counter of processed chunks
+ * and the objects that are referenced by the samplers, for example an
+ * AngularCorrelation, which must be safe to evaluate concurrently (the const
+ * members of AngularCorrelation are).
+ */
+class ParallelCascadeSampler {
+
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param create_cascade_sampler Function that returns a new, independent
+   * CascadeSampler. All samplers must describe the same cascade.
+   * \param master_seed Master seed from which the random number streams of all
+   * chunks are derived.
+   * \param n_threads Number of threads (default: 0, which means that the
+   * number of concurrent threads supported by the hardware is used).
+   * \param chunk_size \f$n_c\f$, number of events per chunk (default: 4096).
+   *
+   * \throw invalid_argument if the chunk size is zero.
+   */
+  ParallelCascadeSampler(function<CascadeSampler()> create_cascade_sampler,
+                         const unsigned int master_seed,
+                         const unsigned int n_threads = 0,
+                         const size_t chunk_size = 4096);
+
+  /**
+   * \brief Sample the reference frames of many cascades.
+   *
+   * The layout of the output is the same as for
+   * CascadeSampler::sample(const size_t, double*).
+   * Each call continues with the next unused random number streams, so
+   * consecutive calls give different events.
+   *
+   * \param n_events Number of cascades \f$n\f$.
+   * \param Phi_Theta_Psi Array of length \f$3 n_s n\f$, where \f$n_s\f$ is
+   * the number of steps of the cascade, for the Euler angles in radians.
+   */
+  void sample(const size_t n_events, double *Phi_Theta_Psi);
+
+  /**
+   * \brief Number of steps of the cascade, i.e. number of reference frames
+   * per event.
+   */
+  size_t get_n_steps() const { return cascade_samplers[0].get_n_steps(); }
+
+  /**
+   * \brief Number of threads.
+   */
+  unsigned int get_n_threads() const { return cascade_samplers.size(); }
+
+protected:
+  vector<CascadeSampler>
+      cascade_samplers; /**< One CascadeSampler per thread. */
+  const unsigned int master_seed; /**< Seed from which all random number
+                                     streams are derived. */
+  const size_t chunk_size;        /**< \f$n_c\f$, number of events per chunk. */
+  unsigned long long n_chunks_sampled{
+      0}; /**< Number of chunks sampled in previous calls of sample(). */
+};
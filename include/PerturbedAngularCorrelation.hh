@@ -0,0 +1,253 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+
+/**
+ * \brief Time-dependent perturbation factors \f$G_{2i} \left( t \right)\f$
+ * of the orders of an angular correlation.
+ *
+ * \f[
+ *      G_{2i} \left( t \right) = \exp \left( - \lambda_{2i} t \right)
+ * \sum_n s_{2i, n} \cos \left( \omega_{2i, n} t \right). \f]
+ *
+ * Orders without amplitudes have no oscillating part, and orders without a
+ * relaxation rate are not damped.
+ * The unit of time is arbitrary, but it must be the inverse of the unit of
+ * the frequencies and rates.
+ */
+struct PerturbationFactor {
+  /** Amplitudes \f$s_{2i, n}\f$, the element \f$i\f$ for the order
+   * \f$2i\f$. */
+  vector<vector<double>> amplitudes;
+  /** Angular frequencies \f$\omega_{2i, n}\f$, same shape as amplitudes. */
+  vector<vector<double>> frequencies;
+  /** Relaxation rates \f$\lambda_{2i}\f$. */
+  vector<double> relaxation_rates;
+
+  /**
+   * \brief Evaluate the perturbation factor.
+   *
+   * \param i Index of the order \f$2i\f$.
+   * \param t Time.
+   *
+   * \return \f$G_{2i} \left( t \right)\f$
+   */
+  double operator()(const size_t i, const double t) const;
+
+  /**
+   * \brief Static electric quadrupole interaction in a polycrystalline
+   * source.
+   *
+   * For an axially symmetric electric field gradient, the sublevels of the
+   * intermediate state with the spin \f$I\f$ have the energies \f$E_m =
+   * \hbar \omega_Q \left[ 3 m^2 - I \left( I + 1 \right) \right]\f$.
+   * The average over random orientations of the field gradient is
+   * [see, e.g., \cite FrauenfelderSteffen1965]
+   *
+   * \f[
+   *      G_{kk} \left( t \right) = \sum_{m, m^\prime} \left( \begin{array}{ccc}
+   * I & I & k \\ m^\prime & -m & m - m^\prime \end{array} \right)^2 \cos
+   * \left( 3 \left| m^2 - m^{\prime 2} \right| \omega_Q t \right), \f]
+   *
+   * which is 1 at \f$t = 0\f$.
+   * Terms with the same frequency are merged.
+   * Orders \f$k > 2I\f$ do not contribute to the angular correlation of a
+   * cascade through the intermediate state, and their amplitudes are empty.
+   *
+   * \param two_I Two times the spin \f$I\f$ of the intermediate state.
+   * \param omega_Q Quadrupole frequency \f$\omega_Q\f$.
+   * \param nu_max Maximum order \f$\nu_\mathrm{max}\f$.
+   *
+   * \throw invalid_argument if two_I or nu_max is negative.
+   */
+  static PerturbationFactor static_quadrupole(const int two_I,
+                                              const double omega_Q,
+                                              const int nu_max);
+
+  /**
+   * \brief Exponential relaxation
+   *
+   * \param rates Relaxation rates \f$\lambda_{2i}\f$.
+   *
+   * \throw invalid_argument if a rate is negative.
+   */
+  static PerturbationFactor relaxation(const vector<double> &rates);
+};
+
+/**
+ * \brief Time-differential perturbed angular correlation.
+ *
+ * In a time-differential measurement, extranuclear fields perturb the
+ * orientation of the intermediate state of a cascade during its lifetime.
+ * For a direction-direction correlation, the correlation of the two photons
+ * after a time \f$t\f$ is
+ *
+ * \f[
+ *      W \left( \theta, t \right) = \sum_{i=0}^{\nu_\mathrm{max} / 2} c_i
+ * G_{2i} \left( t \right) P_{2i} \left[ \cos \left( \theta - \omega_L t
+ * \right) \right], \f]
+ *
+ * where the \f$c_i\f$ are the expansion coefficients of the unperturbed
+ * correlation (see W_gamma_gamma::get_legendre_coefficients()), the
+ * \f$G_{2i}\f$ are products of any number of PerturbationFactor objects, and
+ * the exponential decay of the intermediate state is not included.
+ * The Larmor precession in a magnetic field perpendicular to the plane of
+ * the detectors rotates the pattern with the angular frequency
+ * \f$\omega_L\f$, where \f$\theta\f$ is the angle between the detectors in
+ * this plane.
+ * The sign of \f$\omega_L\f$ is the sense of rotation, which includes the
+ * sign of the g factor.
+ *
+ * With the expansion of the Legendre polynomials in a cosine series
+ * (see fourier_coefficients()), the correlation becomes a sum of products of
+ * functions of the time and functions of the angle:
+ *
+ * \f[
+ *      W \left( \theta, t \right) = \sum_{j=0}^{\nu_\mathrm{max} / 2} f_j
+ * \left( t \right) \left[ \cos \left( 2 j \omega_L t \right) \cos \left( 2j
+ * \theta \right) + \sin \left( 2 j \omega_L t \right) \sin \left( 2j \theta
+ * \right) \right], ~~ f_j \left( t \right) = \sum_{i=j}^{\nu_\mathrm{max} /
+ * 2} c_i G_{2i} \left( t \right) F_{ij}. \f]
+ *
+ * Therefore, evaluate() calculates the functions of the time once per time
+ * bin and the functions of the angle once per angle, and the grid is a
+ * small matrix product, which is parallelized over the time bins with
+ * ThreadPool.
+ * The object copies the coefficients of the angular correlation once and
+ * is immutable after its construction.
+ */
+class PerturbedAngularCorrelation {
+public:
+  /**
+   * \brief Constructor from expansion coefficients
+   *
+   * \param legendre_coefficients Coefficients \f$c_i\f$, at least one.
+   * \param factors Perturbation factors (default: none).
+   * \param larmor_frequency Larmor frequency \f$\omega_L\f$ (default: 0).
+   *
+   * \throw invalid_argument if there are no coefficients.
+   */
+  PerturbedAngularCorrelation(const vector<double> &legendre_coefficients,
+                              const vector<PerturbationFactor> &factors = {},
+                              const double larmor_frequency = 0.);
+
+  /**
+   * \brief Constructor from a direction-direction correlation
+   *
+   * \param ang_cor Angular correlation.
+   * \param factors Perturbation factors (default: none).
+   * \param larmor_frequency Larmor frequency \f$\omega_L\f$ (default: 0).
+   *
+   * \throw invalid_argument if the angular correlation depends on the
+   * azimuthal angle.
+   */
+  PerturbedAngularCorrelation(const AngularCorrelation &ang_cor,
+                              const vector<PerturbationFactor> &factors = {},
+                              const double larmor_frequency = 0.);
+
+  /**
+   * \brief Evaluate the perturbed angular correlation.
+   *
+   * \param theta Angle \f$\theta\f$ between the detectors in radians.
+   * \param t Time.
+   *
+   * \return \f$W \left( \theta, t \right)\f$
+   */
+  double operator()(const double theta, const double t) const;
+
+  /**
+   * \brief Evaluate the perturbed angular correlation on a grid of times
+   * and angles.
+   *
+   * \param n_times Number of times.
+   * \param t Times, array of length n_times.
+   * \param n_angles Number of angles.
+   * \param theta Angles \f$\theta\f$ between the detectors in radians, array
+   * of length n_angles.
+   * \param result Array of length n_times \f$\times\f$ n_angles for the
+   * values \f$W \left( \theta_k, t_l \right)\f$, where the index of the
+   * angle runs fastest.
+   */
+  void evaluate(const size_t n_times, const double *t, const size_t n_angles,
+                const double *theta, double *result) const;
+
+  /**
+   * \brief Perturbation coefficients at a given time.
+   *
+   * \param t Time.
+   *
+   * \return \f$G_{2i} \left( t \right)\f$, \f$0 \leq i \leq \nu_\mathrm{max}
+   * / 2\f$, the products of all perturbation factors.
+   */
+  vector<double> get_perturbation_coefficients(const double t) const;
+
+  /**
+   * \brief Coefficients of the cosine series of the Legendre polynomials.
+   *
+   * \f[
+   *      P_{2i} \left[ \cos \left( \alpha \right) \right] = \sum_{j=0}^i
+   * F_{ij} \cos \left( 2 j \alpha \right), ~~ F_{ij} = \left( 2 -
+   * \delta_{j0} \right) u_{i-j} u_{i+j}, ~~ u_k = 4^{-k} \left(
+   * \begin{array}{c} 2k \\ k \end{array} \right). \f]
+   *
+   * \param nu_max Maximum order \f$\nu_\mathrm{max}\f$.
+   *
+   * \return \f$F_{ij}\f$ for \f$0 \leq i \leq \nu_\mathrm{max} / 2\f$.
+   * The element \f$i\f$ has \f$i + 1\f$ entries.
+   */
+  static vector<vector<double>> fourier_coefficients(const int nu_max);
+
+  int get_nu_max() const {
+    return 2 * (static_cast<int>(legendre_coefficients.size()) - 1);
+  }
+  const vector<double> &get_legendre_coefficients() const {
+    return legendre_coefficients;
+  }
+  const vector<PerturbationFactor> &get_factors() const { return factors; }
+  double get_larmor_frequency() const { return larmor_frequency; }
+
+protected:
+  /**
+   * \brief Calculate the perturbation coefficients \f$G_{2i} \left( t
+   * \right)\f$ without an allocation.
+   */
+  void perturbation_coefficients(const double t, double *G) const;
+
+  /**
+   * \brief Calculate the functions \f$f_j \left( t \right)\f$ of the cosine
+   * series from the perturbation coefficients.
+   */
+  void time_functions(const double *G, double *f) const;
+
+  vector<double> legendre_coefficients; /**< \f$c_i\f$ */
+  vector<PerturbationFactor> factors;   /**< Perturbation factors */
+  double larmor_frequency;              /**< \f$\omega_L\f$ */
+  vector<vector<double>> fourier;       /**< \f$F_{ij}\f$ */
+};
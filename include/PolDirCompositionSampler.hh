@@ -0,0 +1,108 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+#pragma once
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "DirDirInverseTransformSampler.hh"
+#include "W_pol_dir.hh"
+
+/**
+ * \brief Sample directions from a pol-dir correlation by composition.
+ *
+ * A pol-dir correlation (see W_pol_dir) has the structure
+ *
+ * \f[
+ *      W \left( x, \varphi \right) \propto a \left( x \right) + s \cos \left(
+ * 2 \varphi \right) b \left( x \right), \f]
+ *
+ * with \f$x = \cos \left( \theta \right)\f$, the dir-dir part \f$a\f$, the
+ * series of associated Legendre polynomials \f$b\f$, and a factor \f$s = \pm
+ * P\f$ that depends on the electromagnetic character of the first transition
+ * and the degree of polarization \f$P\f$ (see
+ * W_pol_dir::set_polarization_degree()).
+ * Since the integral over \f$\varphi\f$ of the second term vanishes, the
+ * marginal distribution of \f$x\f$ is the dir-dir correlation \f$a\f$, which
+ * is sampled as in DirDirInverseTransformSampler.
+ * For a given \f$x\f$, the conditional distribution of \f$\varphi\f$ is
+ * proportional to \f$1 + r \cos \left( 2 \varphi \right)\f$ with \f$r = s b
+ * \left( x \right) / a \left( x \right)\f$, and its cumulative distribution
+ * function is
+ *
+ * \f[
+ *      G \left( \varphi \right) = \frac{1}{2 \pi} \left[ \varphi + \frac{r}{2}
+ * \sin \left( 2 \varphi \right) \right], \f]
+ *
+ * which is inverted in the same way as the one for \f$x\f$.
+ *
+ * Every draw is accepted, independent of the degree of polarization, and no
+ * upper limit of \f$W\f$ is required.
+ */
+class PolDirCompositionSampler : public DirDirInverseTransformSampler {
+
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param w \f$W \left( \theta, \varphi \right)\f$, pol-dir correlation
+   * \param seed Random number seed.
+   *
+   * \throw invalid_argument if w is not a pol-dir correlation.
+   */
+  PolDirCompositionSampler(const AngularCorrelation &w, const int seed);
+
+  /**
+   * \brief Sample a random reference frame.
+   *
+   * \return std::pair which contains the number of tries, which is always 1,
+   * and the reference frame \f$\left( \Phi_\mathrm{rand},
+   * \Theta_\mathrm{rand}, \Psi_\mathrm{rand}\right)\f$.
+   */
+  pair<unsigned int, array<double, 3>> sample() override;
+
+  /**
+   * \brief Invert the conditional cumulative distribution function of
+   * \f$\varphi\f$.
+   *
+   * \param x \f$x \in \left[ -1, 1 \right]\f$.
+   * \param v \f$v \in \left[ 0, 1 \right]\f$.
+   *
+   * \return \f$\varphi \in \left[ 0, 2 \pi \right]\f$ with \f$G \left( \varphi
+   * \right) = v\f$ for the given \f$x\f$.
+   */
+  double inverse_conditional_cdf(const double x, const double v) const;
+
+protected:
+  /**
+   * \brief Ratio \f$r = s b \left( x \right) / a \left( x \right)\f$,
+   * limited to the interval \f$\left[ -1, 1 \right]\f$.
+   */
+  double anisotropy(const double x) const;
+
+  vector<double>
+      coefficients_2; /**< Coefficients of \f$b\f$, divided by \f$c_0\f$. */
+  double polarization_factor; /**< \f$s\f$ */
+};
@@ -0,0 +1,151 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <atomic>
+
+using std::atomic;
+
+#include <chrono>
+
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+#include <cstdint>
+
+using std::uint64_t;
+
+#include <ostream>
+
+using std::ostream;
+
+#include <string>
+
+using std::string;
+
+/**
+ * \brief Opt-in profiling of the expensive parts of alpaca.
+ *
+ * If alpaca is configured with the ALPACA_ENABLE_PROFILING option, the macro
+ * ALPACA_PROFILE_SCOPE(name) measures the time from its location to the end
+ * of the enclosing scope and counts the number of calls.
+ * It is placed in the construction of the coefficients (for example around
+ * the calculation of the Wigner symbols in WignerSymbolCache, and
+ * in FCoefficient, KappaCoefficient, and UvCoefficient), in
+ * W_pol_dir::get_upper_limit(), and in the evaluation of the Legendre series.
+ * Without the option, the macro expands to nothing, i.e. the profiling has no
+ * cost at all.
+ *
+ * The counters are collected in a registry for the whole process and can be
+ * written with report_text() or report_json() at any time.
+ * If the environment variable `ALPACA_PROFILE_REPORT` contains a file name,
+ * the report is written to this file when the process exits, in JSON format
+ * if the name ends with `.json` and as text otherwise.
+ * This allows to profile existing programs without modifying them.
+ *
+ * The counters are atomic, i.e. profiled code may be called from several
+ * threads.
+ * Note that the times of nested scopes (for example a coefficient and the
+ * Wigner symbols that it requires) are included in the time of the outer
+ * scope, and that the times of concurrent calls in different threads add up.
+ */
+namespace profiler {
+
+/**
+ * \brief Number of calls and total time of a profiled scope.
+ */
+struct Counter {
+  atomic<uint64_t> calls{0};       /**< Number of calls. */
+  atomic<uint64_t> nanoseconds{0}; /**< Total time in nanoseconds. */
+};
+
+/**
+ * \brief Return the counter with a given name, and create it if it does not
+ * exist yet.
+ *
+ * The reference stays valid until the end of the process.
+ *
+ * \param name Name of the counter.
+ */
+Counter &counter(const string &name);
+
+/**
+ * \brief Measure the lifetime of the object and add it to a counter.
+ */
+class ScopedTimer {
+public:
+  explicit ScopedTimer(Counter &c) : counter(c), start(steady_clock::now()) {}
+
+  ~ScopedTimer() {
+    counter.nanoseconds +=
+        duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    ++counter.calls;
+  }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  Counter &counter;
+  const steady_clock::time_point start;
+};
+
+/**
+ * \brief Set all counters to zero.
+ */
+void reset();
+
+/**
+ * \brief Write all counters as a table.
+ *
+ * Each line contains the name of a counter, the number of calls, the total
+ * time in seconds, and the mean time per call in microseconds.
+ */
+void report_text(ostream &stream);
+
+/**
+ * \brief Write all counters as a JSON object.
+ *
+ * The object maps the name of each counter to an object with the members
+ * `calls` and `seconds`.
+ */
+void report_json(ostream &stream);
+
+} // namespace profiler
+
+#define ALPACA_PROFILE_CONCATENATE_IMPL(a, b) a##b
+#define ALPACA_PROFILE_CONCATENATE(a, b) ALPACA_PROFILE_CONCATENATE_IMPL(a, b)
+
+#ifdef ALPACA_ENABLE_PROFILING
+/**
+ * \brief Profile the rest of the enclosing scope under a given name.
+ *
+ * The counter is looked up only once per location.
+ */
+#define ALPACA_PROFILE_SCOPE(name)                                             \
+  static profiler::Counter &ALPACA_PROFILE_CONCATENATE(                        \
+      alpaca_profile_counter_, __LINE__) = profiler::counter(name);            \
+  profiler::ScopedTimer ALPACA_PROFILE_CONCATENATE(alpaca_profile_timer_,      \
+                                                   __LINE__)(                  \
+      ALPACA_PROFILE_CONCATENATE(alpaca_profile_counter_, __LINE__))
+#else
+#define ALPACA_PROFILE_SCOPE(name)
+#endif
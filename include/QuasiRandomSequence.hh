@@ -0,0 +1,286 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <cstdint>
+
+using std::uint32_t;
+using std::uint64_t;
+
+#include <random>
+
+using std::seed_seq;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <string>
+
+using std::to_string;
+
+/**
+ * \brief Sobol sequence with hash-based Owen scrambling.
+ *
+ * Quasi-Monte Carlo (QMC) methods replace the pseudo-random points of a
+ * Monte Carlo integration or sampling by a low-discrepancy sequence, which
+ * covers the unit hypercube more evenly.
+ * For smooth integrands, the error of an integral with \f$n\f$ points
+ * decreases almost like \f$n^{-1}\f$ instead of \f$n^{-1/2}\f$.
+ *
+ * This class generates the Sobol sequence \cite Sobol1967 in up to
+ * ScrambledSobolSequence::max_dimensions dimensions with the direction
+ * numbers of Joe and Kuo \cite JoeKuo2008, in the order of the Gray code,
+ * with 32 bits per coordinate.
+ * The first \f$2^m\f$ points of any two-dimensional projection of the first
+ * two dimensions form a \f$\left( 0, m, 2 \right)\f$-net, i.e. each of the
+ * \f$2^m\f$ elementary intervals of equal area contains exactly one point.
+ *
+ * Each coordinate is randomized with a nested uniform (Owen) scrambling
+ * \cite Owen1995, implemented with the hash-based permutation of Burley
+ * \cite Burley2020.
+ * The scrambling preserves the net property, makes every point uniformly
+ * distributed, and makes the estimates of integrals unbiased.
+ * Independently scrambled replicates of a point set, obtained with different
+ * seeds, give an estimate of the uncertainty of a QMC integral (see
+ * SphereIntegrator::integrate_qmc()).
+ *
+ * After \f$2^{32}\f$ points, the sequence starts from the beginning.
+ */
+class ScrambledSobolSequence {
+public:
+  /**
+   * \brief Maximum number of dimensions.
+   */
+  static constexpr unsigned int max_dimensions = 8;
+
+  /**
+   * \brief Constructor
+   *
+   * \param n_dim Number of dimensions.
+   * \param seed Seed of the scrambling (default: 0).
+   *
+   * \throw invalid_argument if the number of dimensions is zero or larger
+   * than ScrambledSobolSequence::max_dimensions.
+   */
+  explicit ScrambledSobolSequence(const unsigned int n_dim,
+                                  const uint64_t seed = 0)
+      : n_dimensions(n_dim) {
+    if (n_dimensions == 0 || n_dimensions > max_dimensions) {
+      throw invalid_argument("Number of dimensions must be between 1 and " +
+                             to_string(max_dimensions) + ".");
+    }
+    this->seed(seed);
+  }
+
+  /**
+   * \brief Draw new scrambling seeds from an integer seed with SplitMix64,
+   * and restart the sequence.
+   */
+  void seed(const uint64_t seed) {
+    uint64_t x = seed;
+    for (auto &s : scrambling_seeds) {
+      uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      s = static_cast<uint32_t>((z ^ (z >> 31)) >> 32);
+    }
+    set_index(0);
+  }
+
+  /**
+   * \brief Draw new scrambling seeds from a seed sequence, and restart the
+   * sequence.
+   */
+  void seed(seed_seq &seq) {
+    seq.generate(scrambling_seeds.begin(), scrambling_seeds.end());
+    set_index(0);
+  }
+
+  /**
+   * \brief Write the next point to an array of length get_n_dimensions().
+   *
+   * All coordinates are in the range \f$\left[ 0, 1 \right)\f$.
+   */
+  void operator()(double *u) {
+    for (unsigned int d = 0; d < n_dimensions; ++d) {
+      u[d] = to_unit_interval(owen_scramble(state[d], scrambling_seeds[d]));
+    }
+    ++index;
+    const uint32_t i = static_cast<uint32_t>(index);
+    if (i == 0) {
+      state.fill(0);
+      return;
+    }
+    const uint32_t v = trailing_zeros(i);
+    for (unsigned int d = 0; d < n_dimensions; ++d) {
+      state[d] ^= direction_numbers()[d][v];
+    }
+  }
+
+  /**
+   * \brief Write the next \f$n\f$ points to an array of length \f$n\f$ times
+   * get_n_dimensions().
+   *
+   * The coordinates of a point are stored contiguously, i.e. the same
+   * layout as \f$n\f$ consecutive calls of operator()().
+   */
+  void generate(const size_t n, double *u) {
+    for (size_t i = 0; i < n; ++i) {
+      (*this)(u + i * n_dimensions);
+    }
+  }
+
+  /**
+   * \brief Jump to a given index in the sequence.
+   */
+  void set_index(const uint64_t ind) {
+    index = ind;
+    const uint32_t i = static_cast<uint32_t>(index);
+    const uint32_t gray = i ^ (i >> 1);
+    for (unsigned int d = 0; d < n_dimensions; ++d) {
+      state[d] = 0;
+      for (unsigned int k = 0; k < 32; ++k) {
+        if ((gray >> k) & 1U) {
+          state[d] ^= direction_numbers()[d][k];
+        }
+      }
+    }
+  }
+
+  /**
+   * \brief Index of the next point.
+   */
+  uint64_t get_index() const { return index; }
+
+  /**
+   * \brief Number of dimensions.
+   */
+  unsigned int get_n_dimensions() const { return n_dimensions; }
+
+  /**
+   * \brief Nested uniform scrambling of a 32-bit coordinate.
+   *
+   * The bits are reversed, permuted with the Laine-Karras hash in the
+   * variant of \cite Burley2020, and reversed again.
+   * Therefore, the permutation of each bit depends only on the more
+   * significant bits, which is the structure of an Owen scrambling.
+   */
+  static uint32_t owen_scramble(uint32_t x, const uint32_t seed) {
+    x = reverse_bits(x);
+    x += seed;
+    x ^= x * 0x6c50b47cU;
+    x ^= x * 0xb82f1e52U;
+    x ^= x * 0xc7afe638U;
+    x ^= x * 0x8d22f6e6U;
+    return reverse_bits(x);
+  }
+
+  /**
+   * \brief Direction numbers \f$v_{d,k}\f$ of all dimensions \f$d\f$ and
+   * bits \f$k\f$.
+   *
+   * The first dimension is the van der Corput sequence in base 2.
+   * The others are built from the primitive polynomials (degree \f$s\f$,
+   * coefficients \f$a\f$) and the initial numbers \f$m_k\f$ of
+   * \cite JoeKuo2008.
+   */
+  static const array<array<uint32_t, 32>, max_dimensions> &
+  direction_numbers() {
+    static const array<array<uint32_t, 32>, max_dimensions> v = []() {
+      const unsigned int s[max_dimensions] = {0, 1, 2, 3, 3, 4, 4, 5};
+      const unsigned int a[max_dimensions] = {0, 0, 1, 1, 2, 1, 4, 2};
+      const uint32_t m[max_dimensions][5] = {
+          {0, 0, 0, 0, 0},  {1, 0, 0, 0, 0}, {1, 3, 0, 0, 0},
+          {1, 3, 1, 0, 0},  {1, 1, 1, 0, 0}, {1, 1, 3, 3, 0},
+          {1, 3, 5, 13, 0}, {1, 1, 5, 5, 17}};
+
+      array<array<uint32_t, 32>, max_dimensions> directions{};
+      for (unsigned int k = 0; k < 32; ++k) {
+        directions[0][k] = 1U << (31 - k);
+      }
+      for (unsigned int d = 1; d < max_dimensions; ++d) {
+        for (unsigned int k = 0; k < 32; ++k) {
+          if (k < s[d]) {
+            directions[d][k] = m[d][k] << (31 - k);
+          } else {
+            uint32_t v_k =
+                directions[d][k - s[d]] ^ (directions[d][k - s[d]] >> s[d]);
+            for (unsigned int j = 1; j < s[d]; ++j) {
+              if ((a[d] >> (s[d] - 1 - j)) & 1U) {
+                v_k ^= directions[d][k - j];
+              }
+            }
+            directions[d][k] = v_k;
+          }
+        }
+      }
+      return directions;
+    }();
+    return v;
+  }
+
+protected:
+  /**
+   * \brief Convert a 32-bit coordinate to the range \f$\left[ 0, 1
+   * \right)\f$.
+   */
+  static constexpr double to_unit_interval(const uint32_t x) {
+    return x * (1. / 4294967296.);
+  }
+
+  /**
+   * \brief Reverse the order of the bits of a 32-bit number.
+   */
+  static uint32_t reverse_bits(uint32_t x) {
+    x = ((x >> 1) & 0x55555555U) | ((x & 0x55555555U) << 1);
+    x = ((x >> 2) & 0x33333333U) | ((x & 0x33333333U) << 2);
+    x = ((x >> 4) & 0x0f0f0f0fU) | ((x & 0x0f0f0f0fU) << 4);
+    x = ((x >> 8) & 0x00ff00ffU) | ((x & 0x00ff00ffU) << 8);
+    return (x >> 16) | (x << 16);
+  }
+
+  /**
+   * \brief Number of trailing zero bits of a positive number.
+   */
+  static uint32_t trailing_zeros(uint32_t x) {
+    uint32_t n = 0;
+    while ((x & 1U) == 0) {
+      x >>= 1;
+      ++n;
+    }
+    return n;
+  }
+
+  unsigned int n_dimensions; /**< Number of dimensions. */
+  uint64_t index;            /**< Index of the next point. */
+  array<uint32_t, max_dimensions>
+      state; /**< Unscrambled coordinates of the next point. */
+  array<uint32_t, max_dimensions>
+      scrambling_seeds; /**< Seeds of the scrambling of each dimension. */
+};
@@ -0,0 +1,192 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <cstdint>
+
+using std::uint32_t;
+using std::uint64_t;
+
+#include <limits>
+
+using std::numeric_limits;
+
+#include <random>
+
+using std::seed_seq;
+using std::uniform_real_distribution;
+
+/**
+ * \brief xoshiro256++ pseudo-random number generator \cite BlackmanVigna2021.
+ *
+ * A fast pseudo-random number generator with a state of 256 bits and a period
+ * of \f$2^{256} - 1\f$.
+ * Compared to std::mt19937 with its 2.5 kB state, it is cheap to construct and
+ * to seed, which pays off if many short-lived samplers are created.
+ * The class satisfies the requirements of a std::uniform_random_bit_generator,
+ * so it can be used with the random number distributions of the standard
+ * library, and it can be passed as the template parameter Engine of
+ * TypedSphereRejectionSampler.
+ *
+ * An integer seed is expanded to the state with the SplitMix64 generator, as
+ * recommended by the authors of xoshiro256++.
+ */
+class Xoshiro256PlusPlus {
+
+public:
+  typedef uint64_t result_type;
+
+  /**
+   * \brief Constructor
+   *
+   * \param seed Random number seed (default: 0).
+   */
+  explicit Xoshiro256PlusPlus(const result_type seed = 0) { this->seed(seed); }
+
+  /**
+   * \brief Constructor from a seed sequence
+   *
+   * \param seq Seed sequence.
+   */
+  explicit Xoshiro256PlusPlus(seed_seq &seq) { seed(seq); }
+
+  /**
+   * \brief Constructor from an explicit state.
+   *
+   * \param st State of the generator. Must not be zero everywhere.
+   */
+  explicit Xoshiro256PlusPlus(const array<uint64_t, 4> st) : state(st) {}
+
+  /**
+   * \brief Reinitialize the state from an integer seed with SplitMix64.
+   *
+   * \param seed Random number seed.
+   */
+  void seed(const result_type seed) {
+    uint64_t x = seed;
+    for (size_t i = 0; i < 4; ++i) {
+      uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      state[i] = z ^ (z >> 31);
+    }
+  }
+
+  /**
+   * \brief Reinitialize the state from a seed sequence.
+   *
+   * \param seq Seed sequence.
+   */
+  void seed(seed_seq &seq) {
+    array<uint32_t, 8> words;
+    seq.generate(words.begin(), words.end());
+    for (size_t i = 0; i < 4; ++i) {
+      state[i] = (uint64_t(words[2 * i]) << 32) | words[2 * i + 1];
+    }
+    // The all-zero state is a fixed point of the generator.
+    if ((state[0] | state[1] | state[2] | state[3]) == 0) {
+      seed(0);
+    }
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return numeric_limits<result_type>::max();
+  }
+
+  /**
+   * \brief Generate the next random number.
+   *
+   * \return Uniformly distributed integer in the range \f$\left[ 0, 2^{64} - 1
+   * \right]\f$.
+   */
+  result_type operator()() {
+    const uint64_t result = rotl(state[0] + state[3], 23) + state[0];
+    const uint64_t t = state[1] << 17;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+
+    return result;
+  }
+
+  /**
+   * \brief Generate a uniformly distributed random number in the range
+   * \f$\left[ 0, 1 \right)\f$.
+   *
+   * Uses the upper 53 bits of a random integer, which fills the mantissa of a
+   * double-precision number.
+   */
+  double uniform() { return (operator()() >> 11) * 0x1.0p-53; }
+
+private:
+  static constexpr uint64_t rotl(const uint64_t x, const int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  array<uint64_t, 4> state; /**< State of the generator. */
+};
+
+/**
+ * \brief Fill an array with uniformly distributed random numbers in the range
+ * \f$\left[ 0, 1 \right)\f$.
+ *
+ * This generic implementation uses std::uniform_real_distribution, i.e. for a
+ * given engine, the result is the same as for \f$n\f$ consecutive calls of
+ * std::uniform_real_distribution<double>::operator().
+ *
+ * \param engine Random number engine.
+ * \param u Array of length n for the random numbers.
+ * \param n Number of random numbers.
+ */
+template <typename Engine>
+void fill_uniform(Engine &engine, double *u, const size_t n) {
+  uniform_real_distribution<double> uniform_random;
+  for (size_t i = 0; i < n; ++i) {
+    u[i] = uniform_random(engine);
+  }
+}
+
+/**
+ * \brief Fill an array with uniformly distributed random numbers in the range
+ * \f$\left[ 0, 1 \right)\f$ using Xoshiro256PlusPlus::uniform().
+ *
+ * \param engine Random number engine.
+ * \param u Array of length n for the random numbers.
+ * \param n Number of random numbers.
+ */
+inline void fill_uniform(Xoshiro256PlusPlus &engine, double *u,
+                         const size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    u[i] = engine.uniform();
+  }
+}
@@ -23,10 +23,69 @@
 
 using std::array;
 
+#include <cstddef>
+
+using std::size_t;
+
+#include <random>
+
+using std::seed_seq;
+
 #include <utility>
 
 using std::pair;
 
+#include "EulerAngleRotation.hh"
+
+/**
+ * \brief Acceptance statistics of a ReferenceFrameSampler.
+ *
+ * The number of tries \f$N\f$ that were needed for a reference frame are
+ * collected in a histogram with logarithmic bins: bin \f$k\f$ contains the
+ * number of accepted reference frames with \f$2^k \leq N < 2^{k+1}\f$.
+ */
+struct SamplingStatistics {
+  /**
+   * \brief Number of bins of the histogram of tries per accepted reference
+   * frame.
+   */
+  static constexpr size_t n_histogram_bins = 32;
+
+  size_t n_samples = 0;  /**< Number of requested reference frames. */
+  size_t n_tries = 0;    /**< Total number of tries. */
+  size_t n_accepted = 0; /**< Number of accepted reference frames. */
+  size_t n_failures = 0; /**< Number of requests that reached the maximum
+                            number of tries without success. */
+  array<size_t, n_histogram_bins>
+      tries_histogram{}; /**< Histogram of the tries per accepted reference
+                            frame. */
+
+  /**
+   * \brief Fraction of accepted tries.
+   *
+   * \return \f$n_\mathrm{accepted} / n_\mathrm{tries}\f$, or zero if there
+   * were no tries.
+   */
+  double get_acceptance() const {
+    return n_tries > 0 ? (double)n_accepted / (double)n_tries : 0.;
+  }
+
+  /**
+   * \brief Add the statistics of another sampler, for example of a copy that
+   * was used in a different thread.
+   */
+  SamplingStatistics &operator+=(const SamplingStatistics &other) {
+    n_samples += other.n_samples;
+    n_tries += other.n_tries;
+    n_accepted += other.n_accepted;
+    n_failures += other.n_failures;
+    for (size_t k = 0; k < n_histogram_bins; ++k) {
+      tries_histogram[k] += other.tries_histogram[k];
+    }
+    return *this;
+  }
+};
+
 /**
  * @brief Abstract class for sampling an arbitrarily oriented reference frame.
  *
@@ -39,6 +98,16 @@ using std::pair;
  * This class defines the abstract interface for the samplers, including a
  * method to report the number of tries until a valid vector was found
  *
+ * Optionally, a sampler collects SamplingStatistics about all reference frames
+ * that it returns from sample() and the block mode
+ * operator()(const size_t, double*, double*, double*) (see
+ * enable_statistics()).
+ * This allows to monitor the efficiency of the sampling in a running
+ * simulation, as opposed to estimate_efficiency(), which samples additional
+ * reference frames.
+ * The collection is disabled by default, and costs a single branch per
+ * reference frame if it is disabled.
+ * Weighted reference frames are not counted, since no candidate is rejected.
  */
 class ReferenceFrameSampler {
 public:
@@ -65,6 +134,144 @@ public:
    */
   array<double, 3> operator()();
 
+  /**
+   * \brief Sample a block of random reference frames.
+   *
+   * The Euler angles are written into three separate arrays (structure of
+   * arrays).
+   * The default implementation calls sample() \f$n\f$ times.
+   * Derived classes may override it with an algorithm that processes several
+   * reference frames at once.
+   * If the maximum number of trials is reached for a reference frame, the
+   * angles \f$\left( 0, 0, 0 \right)\f$ are returned for it, like in
+   * operator()().
+   *
+   * \param n \f$n\f$, number of reference frames.
+   * \param Phi Array of length \f$n\f$ for the Euler angles \f$\Phi\f$.
+   * \param Theta Array of length \f$n\f$ for the Euler angles \f$\Theta\f$.
+   * \param Psi Array of length \f$n\f$ for the Euler angles \f$\Psi\f$.
+   */
+  virtual void operator()(const size_t n, double *Phi, double *Theta,
+                          double *Psi);
+
+  /**
+   * \brief Sample a random reference frame with a statistical weight.
+   *
+   * Instead of rejecting reference frames, a weighted sampler returns every
+   * proposed reference frame together with a weight \f$w\f$ (importance
+   * sampling, see, e.g., Sec. 3.3 in Ref. \cite RobertCasella1999).
+   * The weighted reference frames are distributed according to the same
+   * distribution as the ones from sample().
+   * The default implementation returns the result of operator()() with the
+   * weight \f$w = 1\f$, which is appropriate for samplers that sample from
+   * the distribution directly.
+   *
+   * \return std::pair which contains the weight \f$w\f$ and the reference
+   * frame \f$\left( \Phi_\mathrm{rand}, \Theta_\mathrm{rand},
+   * \Psi_\mathrm{rand}\right)\f$.
+   */
+  virtual pair<double, array<double, 3>> sample_weighted();
+
+  /**
+   * \brief Sample a block of random reference frames with statistical
+   * weights.
+   *
+   * Same as operator()(const size_t, double*, double*, double*), but for
+   * sample_weighted().
+   * The default implementation calls sample_weighted() \f$n\f$ times.
+   *
+   * \param n \f$n\f$, number of reference frames.
+   * \param Phi Array of length \f$n\f$ for the Euler angles \f$\Phi\f$.
+   * \param Theta Array of length \f$n\f$ for the Euler angles \f$\Theta\f$.
+   * \param Psi Array of length \f$n\f$ for the Euler angles \f$\Psi\f$.
+   * \param weights Array of length \f$n\f$ for the weights \f$w\f$.
+   */
+  virtual void sample_weighted(const size_t n, double *Phi, double *Theta,
+                               double *Psi, double *weights);
+
+  /**
+   * \brief Sample a random reference frame as a rotation matrix.
+   *
+   * The rotation matrix \f$A\f$ is the same as
+   * euler_angle_transform::rotation_matrix() for the Euler angles from
+   * sample().
+   * Its third column, euler_angle_transform::direction(), is the Cartesian
+   * unit vector of the direction of emission, and its first column,
+   * euler_angle_transform::polarization_axis(), defines the orientation of
+   * the polarization plane.
+   * Since consecutive reference frames of a cascade are composed by
+   * multiplying their rotation matrices (see CascadeSampler), this avoids the
+   * conversion to Euler angles and back.
+   * The default implementation converts the Euler angles from sample().
+   * Derived classes may override it to calculate the matrix directly from the
+   * sampled trigonometric functions.
+   *
+   * \return std::pair which contains \f$N\f$, the number of tries, and
+   * \f$A\f$.
+   * Returns the identity matrix if the maximum number of trials was reached,
+   * which corresponds to the Euler angles \f$\left( 0, 0, 0 \right)\f$.
+   */
+  virtual pair<unsigned int, euler_angle_transform::RotationMatrix>
+  sample_rotation_matrix();
+
+  /**
+   * \brief Sample a block of random reference frames as rotation matrices.
+   *
+   * Same as operator()(const size_t, double*, double*, double*), but for
+   * sample_rotation_matrix().
+   * The default implementation calls sample_rotation_matrix() \f$n\f$ times.
+   *
+   * \param n \f$n\f$, number of reference frames.
+   * \param A Array of length \f$n\f$ for the rotation matrices.
+   */
+  virtual void sample_rotation_matrices(const size_t n,
+                                        euler_angle_transform::RotationMatrix *A);
+
+  /**
+   * \brief Sample a random reference frame as a rotation matrix with a
+   * statistical weight.
+   *
+   * Same as sample_weighted(), but returns the rotation matrix like
+   * sample_rotation_matrix().
+   * The default implementation converts the Euler angles from
+   * sample_weighted().
+   *
+   * \return std::pair which contains the weight \f$w\f$ and the rotation
+   * matrix.
+   */
+  virtual pair<double, euler_angle_transform::RotationMatrix>
+  sample_weighted_rotation_matrix();
+
+  /**
+   * \brief Sample a block of random reference frames as rotation matrices
+   * with statistical weights.
+   *
+   * The default implementation calls sample_weighted_rotation_matrix()
+   * \f$n\f$ times.
+   *
+   * \param n \f$n\f$, number of reference frames.
+   * \param A Array of length \f$n\f$ for the rotation matrices.
+   * \param weights Array of length \f$n\f$ for the weights \f$w\f$.
+   */
+  virtual void
+  sample_weighted_rotation_matrices(const size_t n,
+                                    euler_angle_transform::RotationMatrix *A,
+                                    double *weights);
+
+  /**
+   * \brief Reinitialize the random number engine.
+   *
+   * After reseeding with equal seed sequences, two instances of the same
+   * sampler produce the same sequence of reference frames.
+   * This allows a parallel driver to assign an independent random number
+   * stream to each part of a simulation (see ParallelCascadeSampler).
+   * The default implementation does nothing, which is appropriate for samplers
+   * that do not use random numbers.
+   *
+   * \param seq Seed sequence.
+   */
+  virtual void reseed(seed_seq &seq);
+
   /**
    * \brief Estimate the efficiency of sampling for the given
    * distribution.
@@ -78,4 +285,64 @@ public:
    * \return Estimate for \f$\epsilon\f$ from the \f$n\f$ samples.
    */
   double estimate_efficiency(const unsigned int n_tries);
+
+  /**
+   * \brief Enable or disable the collection of SamplingStatistics.
+   *
+   * Disabling the collection keeps the statistics collected so far.
+   *
+   * \param enable Collect statistics (default: true).
+   */
+  void enable_statistics(const bool enable = true) {
+    collect_statistics = enable;
+  }
+
+  /**
+   * \brief Whether SamplingStatistics are collected.
+   */
+  bool statistics_enabled() const { return collect_statistics; }
+
+  /**
+   * \brief Statistics since the construction or the last call of
+   * reset_statistics().
+   */
+  const SamplingStatistics &get_statistics() const { return statistics; }
+
+  /**
+   * \brief Set all statistics to zero.
+   */
+  void reset_statistics() { statistics = SamplingStatistics(); }
+
+protected:
+  /**
+   * \brief Add a requested reference frame to the statistics, if they are
+   * collected.
+   *
+   * To be called by the implementations of sample().
+   *
+   * \param n_tries \f$N\f$, number of tries.
+   * \param accepted Whether a reference frame was accepted, or the maximum
+   * number of tries was reached.
+   */
+  void record(const unsigned int n_tries, const bool accepted) {
+    if (!collect_statistics) {
+      return;
+    }
+    ++statistics.n_samples;
+    statistics.n_tries += n_tries;
+    if (!accepted) {
+      ++statistics.n_failures;
+      return;
+    }
+    ++statistics.n_accepted;
+    size_t bin = 0;
+    while (bin + 1 < SamplingStatistics::n_histogram_bins &&
+           n_tries >> (bin + 1)) {
+      ++bin;
+    }
+    ++statistics.tries_histogram[bin];
+  }
+
+  bool collect_statistics = false; /**< Collect SamplingStatistics. */
+  SamplingStatistics statistics;   /**< Statistics of the sampler. */
 };
\ No newline at end of file
@@ -0,0 +1,273 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "EulerAngleRotation.hh"
+
+/**
+ * \brief Angular correlation in a rotated coordinate system, expanded in real
+ * spherical harmonics of the laboratory frame.
+ *
+ * AngularCorrelation::evaluate(const size_t, const double *, const double *,
+ * const array<double, 3>, double *) const rotates every single direction back
+ * into the coordinate system of the angular correlation before it is
+ * evaluated.
+ * However, an angular correlation with a maximum order \f$\nu_\mathrm{max}\f$
+ * is a band-limited function on the sphere, and so is the rotated function.
+ * This class calculates the expansion of the rotated function
+ *
+ * \f[
+ *      W^\prime \left( \vec{r} \right) = W \left[ A^{-1} \left( \Phi, \Theta,
+ * \Psi \right) \vec{r} \right] = \sum_{l=0}^{\nu_\mathrm{max}} \sum_{m=-l}^l
+ * a_l^{m \prime} Y_{l, m} \left( \vec{r} \right) \f]
+ *
+ * once, and evaluates it for any number of directions without a rotation.
+ * Here, \f$A\f$ is the rotation matrix of the Euler angles in the 'zxz'
+ * convention (see euler_angle_transform), and the \f$Y_{l,m}\f$ are real
+ * spherical harmonics without the Condon-Shortley phase:
+ *
+ * \f[
+ *      Y_{l, m} = N_l^m P_l^{\left| m \right|} \left[ \cos \left( \theta
+ * \right) \right] \times \left\lbrace \begin{array}{ll} \sqrt{2} \cos \left(
+ * m \varphi \right) & m > 0 \\ 1 & m = 0 \\ \sqrt{2} \sin \left( \left| m
+ * \right| \varphi \right) & m < 0 \end{array} \right. , ~~ N_l^m = \sqrt{
+ * \frac{\left( l - \left| m \right| \right)!}{\left( l + \left| m \right|
+ * \right)!}} \left( -1 \right)^m. \f]
+ *
+ * The factor \f$\left( -1 \right)^m\f$ cancels the Condon-Shortley phase of
+ * \f$P_l^m\f$ (see legendre_series).
+ * For each \f$l\f$, these functions are orthogonal and have the same norm
+ * \f$4 \pi / \left( 2l + 1 \right)\f$.
+ * In the coordinate system of the angular correlation, only the coefficients
+ * \f$a_l^0 = c_{l/2}\f$ and \f$a_l^2 = d_{l/2-1} / \left( \sqrt{2} N_l^2
+ * \right)\f$ of even \f$l\f$ are nonzero (see
+ * W_gamma_gamma::get_legendre_coefficients() for \f$c_i\f$ and \f$d_i\f$).
+ * The coefficients in the laboratory frame are obtained with the Wigner
+ * D-matrices \f$D^l\f$ in the basis of the real spherical harmonics:
+ *
+ * \f[
+ *      a_l^{m \prime} = \sum_{n=-l}^l D^l_{m n} \left( A \right) a_l^n. \f]
+ *
+ * The matrices are calculated from the rotation matrix \f$A\f$ itself, which
+ * is the matrix \f$D^1\f$ up to a permutation of the coordinates, with the
+ * recursion of Ivanic and Ruedenberg \cite IvanicRuedenberg1996.
+ * This avoids the Euler angles, and with them any ambiguity in the phase
+ * conventions of the complex Wigner D-matrices.
+ * The cost is proportional to \f$\nu_\mathrm{max}^3\f$ and independent of
+ * the number of directions.
+ *
+ * The evaluation uses Cartesian coordinates.
+ * Since \f$\sin^{\left| m \right|} \left( \theta \right) \exp \left( i m
+ * \varphi \right) = \left( x + i y \right)^m\f$ and
+ * \f$P_l^m \left( z \right) / \sin^m \left( \theta \right)\f$ is a polynomial
+ * in \f$z\f$, the spherical harmonics are polynomials in the coordinates of
+ * the unit vector, which are calculated by the three-term recurrence relation
+ * of legendre_series for each \f$m\f$, and by complex multiplication for
+ * \f$\left( x + i y \right)^m\f$.
+ * The normalization factors are absorbed into the stored coefficients.
+ * For \f$\nu_\mathrm{max} = 4\f$, the evaluation of a direction in spherical
+ * coordinates needs only the sine and cosine of the two angles, while the
+ * rotation of every direction also needs an inverse cosine, an inverse
+ * tangent, and two more cosines.
+ *
+ * Several detectors in the same frame can share a single object, which is
+ * immutable after its construction.
+ */
+class RotatedAngularCorrelation {
+public:
+  /**
+   * \brief Constructor from expansion coefficients
+   *
+   * \param legendre_coefficients Coefficients \f$c_i\f$, at least one.
+   * \param associated_legendre_coefficients Coefficients \f$d_i\f$. Either
+   * empty, or one less than \f$c_i\f$.
+   * \param Phi_Theta_Psi Euler angles \f$\Phi\f$, \f$\Theta\f$, and
+   * \f$\Psi\f$ in radians.
+   *
+   * \throw invalid_argument if the numbers of coefficients are inconsistent.
+   */
+  RotatedAngularCorrelation(
+      const vector<double> &legendre_coefficients,
+      const vector<double> &associated_legendre_coefficients,
+      const array<double, 3> Phi_Theta_Psi);
+
+  /**
+   * \brief Constructor from an angular correlation
+   *
+   * \param ang_cor Angular correlation.
+   * \param Phi_Theta_Psi Euler angles \f$\Phi\f$, \f$\Theta\f$, and
+   * \f$\Psi\f$ in radians.
+   */
+  RotatedAngularCorrelation(const AngularCorrelation &ang_cor,
+                            const array<double, 3> Phi_Theta_Psi)
+      : RotatedAngularCorrelation(
+            ang_cor.get_legendre_coefficients(),
+            ang_cor.get_associated_legendre_coefficients(), Phi_Theta_Psi) {}
+
+  /**
+   * \brief Evaluate the rotated angular correlation.
+   *
+   * \param theta Polar angle in radians.
+   * \param phi Azimuthal angle in radians.
+   *
+   * \return \f$W^\prime \left( \theta, \varphi \right)\f$
+   */
+  double operator()(const double theta, const double phi) const;
+
+  /**
+   * \brief Evaluate the rotated angular correlation for many directions at
+   * once.
+   *
+   * Equivalent to AngularCorrelation::evaluate(const size_t, const double *,
+   * const double *, const array<double, 3>, double *) const up to rounding
+   * errors.
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in radians, array of length n.
+   * \param phi Azimuthal angles in radians, array of length n.
+   * \param result Array of length n for the results.
+   */
+  void evaluate(const size_t n, const double *theta, const double *phi,
+                double *result) const;
+
+  /**
+   * \brief Evaluate the rotated angular correlation for a direction given as
+   * a unit vector.
+   *
+   * \param direction Unit vector \f$\vec{r}\f$. It is not normalized by this
+   * function.
+   *
+   * \return \f$W^\prime \left( \vec{r} \right)\f$
+   */
+  double evaluate(const array<double, 3> &direction) const;
+
+  /**
+   * \brief Evaluate the rotated angular correlation for many directions at
+   * once, given as unit vectors.
+   *
+   * \param n Number of directions.
+   * \param xyz Cartesian coordinates \f$x_0, y_0, z_0, x_1, y_1, ...\f$ of the
+   * unit vectors, array of length \f$3n\f$.
+   * \param result Array of length n for the results.
+   */
+  void evaluate(const size_t n, const double *xyz, double *result) const;
+
+  /**
+   * \brief Evaluate the rotated angular correlation on a grid of polar and
+   * azimuthal angles.
+   *
+   * The expansion separates into functions of \f$\theta\f$ and
+   * \f$\varphi\f$:
+   *
+   * \f[
+   *      W^\prime \left( \theta_i, \varphi_j \right) =
+   * \sum_{m=0}^{\nu_\mathrm{max}}
+   * \left[ C_m \left( \theta_i \right) \cos \left( m \varphi_j \right) + S_m
+   * \left( \theta_i \right) \sin \left( m \varphi_j \right) \right]. \f]
+   *
+   * The \f$2 \nu_\mathrm{max} + 1\f$ functions are evaluated once per polar
+   * and azimuthal angle, and the grid is filled by a rank-\f$\left( 2
+   * \nu_\mathrm{max} + 1 \right)\f$ update.
+   *
+   * \param n_theta Number of polar angles \f$N_\theta\f$.
+   * \param theta Polar angles in radians, array of length n_theta.
+   * \param n_phi Number of azimuthal angles \f$N_\varphi\f$.
+   * \param phi Azimuthal angles in radians, array of length n_phi.
+   * \param result Array of length \f$N_\theta N_\varphi\f$ for the values
+   * \f$W^\prime \left( \theta_i, \varphi_j \right)\f$ at the index
+   * \f$i N_\varphi + j\f$.
+   */
+  void evaluate_grid(const size_t n_theta, const double *theta,
+                     const size_t n_phi, const double *phi,
+                     double *result) const;
+
+  /**
+   * \brief Maximum order \f$\nu_\mathrm{max}\f$ of the expansion.
+   */
+  int get_nu_max() const { return nu_max; }
+
+  /**
+   * \brief Euler angles of the rotation in radians.
+   */
+  array<double, 3> get_Phi_Theta_Psi() const { return Phi_Theta_Psi; }
+
+  /**
+   * \brief Coefficient \f$a_l^{m \prime}\f$ of the expansion in the laboratory
+   * frame.
+   *
+   * \param l Order \f$l\f$. Coefficients with \f$l > \nu_\mathrm{max}\f$ are
+   * zero.
+   * \param m Index \f$m\f$, \f$\left| m \right| \leq l\f$.
+   *
+   * \throw invalid_argument if l is negative or \f$\left| m \right| > l\f$.
+   */
+  double get_coefficient(const int l, const int m) const;
+
+  /**
+   * \brief Wigner D-matrices in the basis of the real spherical harmonics.
+   *
+   * \param l_max Maximum order \f$l_\mathrm{max}\f$.
+   * \param A Rotation matrix.
+   *
+   * \return Matrices \f$D^l\f$ for \f$l = 0, 1, ..., l_\mathrm{max}\f$.
+   * The element \f$D^l_{mn}\f$ is stored at the index
+   * \f$\left( m + l \right) \left( 2l + 1 \right) + n + l\f$ of the entry
+   * \f$l\f$.
+   * The matrices are orthogonal.
+   */
+  static vector<vector<double>>
+  wigner_D_matrices(const int l_max,
+                    const euler_angle_transform::RotationMatrix &A);
+
+protected:
+  /**
+   * \brief Evaluate the expansion for a block of at most
+   * legendre_series::block_size unit vectors.
+   */
+  void evaluate_block(const size_t n, const double *x, const double *y,
+                      const double *z, double *result) const;
+
+  int nu_max; /**< \f$\nu_\mathrm{max}\f$ */
+  array<double, 3> Phi_Theta_Psi; /**< Euler angles */
+  /** Coefficients \f$a_l^{m \prime}\f$ at the index \f$l^2 + l + m\f$. */
+  vector<double> coefficients;
+  /**
+   * Coefficients of \f$\mathrm{Re} \left[ \left( x + i y \right)^m \right]
+   * \left( -1 \right)^m P_l^m \left( z \right) / \sin^m \left( \theta
+   * \right)\f$ for \f$m = 0, 1, ..., \nu_\mathrm{max}\f$ and \f$l = m, m + 1,
+   * ..., \nu_\mathrm{max}\f$, including the normalization factors.
+   */
+  vector<double> cos_coefficients;
+  /** Same as cos_coefficients for the imaginary part. */
+  vector<double> sin_coefficients;
+};
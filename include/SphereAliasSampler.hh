@@ -0,0 +1,169 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <functional>
+
+using std::function;
+
+#include <random>
+
+using std::uniform_real_distribution;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AliasTable.hh"
+#include "EulerAngleRotation.hh"
+#include "RandomEngine.hh"
+#include "ReferenceFrameSampler.hh"
+
+/**
+ * \brief Sample directions from a tabulated probability distribution in
+ * spherical coordinates with the alias method.
+ *
+ * The sphere is divided into a grid of \f$n_{\cos \theta} \times
+ * n_\varphi\f$ cells that are equidistant in \f$\cos \left( \theta \right)
+ * \in \left[ -1, 1 \right]\f$ and \f$\varphi \in \left[ 0, 2 \pi \right]\f$.
+ * Since \f$\mathrm{d}\Omega = \mathrm{d} \cos \left( \theta \right)
+ * \mathrm{d} \varphi\f$, all cells cover the same solid angle, and the
+ * probability of a cell is proportional to the value of the distribution
+ * \f$W\f$ at its center.
+ * The constructor evaluates \f$W\f$ once for each cell and builds an
+ * AliasTable of the cells.
+ * A draw selects a cell in constant time and distributes the direction
+ * uniformly within the cell.
+ *
+ * In contrast to SphereRejectionSampler, \f$W\f$ can be any non-negative
+ * callable, for example an AngularCorrelation, a distribution with measured
+ * attenuation coefficients, or one that is weighted with the efficiency of a
+ * detector, and no upper limit is needed.
+ * Every draw is accepted, i.e. the number of tries reported by sample() is
+ * always 1, and the cost of a draw does not depend on the shape of the
+ * distribution.
+ * The price is the discretization: the sampled distribution is piecewise
+ * constant, which approximates a smooth \f$W\f$ up to corrections of second
+ * order in the size of the cells.
+ * The setup cost is proportional to the number of cells, which pays off for
+ * a large number of draws.
+ *
+ * The first Euler angle is sampled in the same way as in
+ * SphereRejectionSampler, so this class can replace an AngCorrRejectionSampler
+ * in a CascadeSampler.
+ */
+class SphereAliasSampler : public ReferenceFrameSampler {
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param dis \f$W \left( \theta, \varphi \right)\f$, non-negative
+   * probability distribution in spherical coordinates.
+   * \param n_cos_the \f$n_{\cos \theta}\f$, number of cells in
+   * \f$\cos \left( \theta \right)\f$.
+   * \param n_ph \f$n_\varphi\f$, number of cells in \f$\varphi\f$.
+   * \param seed Random number seed.
+   *
+   * \throw invalid_argument if a number of cells is zero, or if the values
+   * of the distribution at the centers of the cells are not valid weights
+   * (see AliasTable).
+   */
+  SphereAliasSampler(function<double(const double, const double)> dis,
+                     const size_t n_cos_the, const size_t n_ph,
+                     const int seed);
+
+  /**
+   * \brief Sample a random reference frame.
+   *
+   * \return std::pair which contains the number of tries, which is always 1,
+   * and the reference frame \f$\left( \Phi_\mathrm{rand},
+   * \Theta_\mathrm{rand}, \Psi_\mathrm{rand}\right)\f$.
+   */
+  pair<unsigned int, array<double, 3>> sample() override;
+
+  /**
+   * \brief Sample a random reference frame as a rotation matrix.
+   *
+   * Uses the same random numbers as sample(), but calculates the rotation
+   * matrix directly from \f$\cos \left( \theta_\mathrm{rand} \right)\f$ with
+   * euler_angle_transform::rotation_matrix_from_spherical().
+   */
+  pair<unsigned int, euler_angle_transform::RotationMatrix>
+  sample_rotation_matrix() override;
+
+  void reseed(seed_seq &seq) override;
+
+  /**
+   * \brief Number of cells in \f$\cos \left( \theta \right)\f$.
+   */
+  size_t get_n_cos_theta() const { return n_cos_theta; }
+
+  /**
+   * \brief Number of cells in \f$\varphi\f$.
+   */
+  size_t get_n_phi() const { return n_phi; }
+
+  /**
+   * \brief Probability of a cell.
+   *
+   * \param i Index of the cell in \f$\cos \left( \theta \right)\f$.
+   * \param j Index of the cell in \f$\varphi\f$.
+   *
+   * \throw out_of_range if the cell does not exist.
+   */
+  double get_cell_probability(const size_t i, const size_t j) const;
+
+protected:
+  /**
+   * \brief Sample the cosine of the polar angle, the azimuthal angle, and
+   * the first Euler angle.
+   */
+  array<double, 3> sample_cos_theta_phi_Phi();
+
+  /**
+   * \brief Evaluate the distribution at the centers of all cells.
+   */
+  static vector<double>
+  tabulate(const function<double(const double, const double)> &dis,
+           const size_t n_cos_theta, const size_t n_phi);
+
+  size_t n_cos_theta; /**< Number of cells in \f$\cos \left( \theta
+                         \right)\f$. */
+  size_t n_phi;       /**< Number of cells in \f$\varphi\f$. */
+  AliasTable cells;   /**< Alias table of the cells, with the index \f$i
+                         n_\varphi + j\f$ for the cell \f$\left( i, j
+                         \right)\f$. */
+  Xoshiro256PlusPlus random_engine; /**< Random number engine. */
+  uniform_real_distribution<double>
+      uniform_random; /**< Uniform distribution in \f$\left[ 0, 1
+                         \right)\f$. */
+};
@@ -19,7 +19,24 @@
 
 #pragma once
 
-#include "SpherePointSampler.hh"
+#include <cstddef>
+
+using std::size_t;
+
+#include <cstdint>
+
+using std::uint64_t;
+
+#include <functional>
+
+using std::function;
+
+#include <vector>
+
+using std::vector;
+
+#include "SpherePointCache.hh"
+#include "SphereRegion.hh"
 
 /**
  * \brief Simple integration of a function of 2 variables on a sphere surface
@@ -63,12 +80,51 @@
  * Note also that the present integration method does not require the weighting
  * factor \f$\sin\left( \theta \right)\f$ which must be used in spherical
  * coordinates.
+ *
+ * The point sets are taken from the SpherePointCache, i.e. they are only
+ * calculated once for each \f$n\f$ in a process, or read in place from a
+ * file that is attached with SpherePointCache::attach().
+ * To integrate several functions, for example many angular correlations, over
+ * the same domain, the overloads that take a list of integrands evaluate all of
+ * them on a single point set in one pass.
+ *
+ * The deterministic spiral gives no estimate of the integration error.
+ * As an alternative, integrate_qmc() uses randomized quasi-Monte Carlo
+ * points from a ScrambledSobolSequence, which are equidistant in
+ * \f$\cos \left( \theta \right)\f$ and \f$\varphi\f$, and estimates the
+ * uncertainty from independent scramblings.
+ *
+ * For regions that are unions of cones and boxes in spherical coordinates
+ * (see SphereRegion), the overloads that take a SphereRegion instead of a
+ * function that selects the points generate points only inside the region,
+ * each of which is weighted by the solid angle it represents.
+ * For a small region, for example the solid angle covered by a detector,
+ * this avoids the generation and the test of the points on the rest of the
+ * sphere, and all \f$n\f$ points contribute to the precision of the integral.
+ */
+
+/**
+ * \brief Estimate of an integral and its uncertainty.
  */
+struct IntegralEstimate {
+  double value;       /**< Mean value of the replicates. */
+  double uncertainty; /**< Standard error of the mean value. */
+};
 
 class SphereIntegrator {
 
 public:
-  SphereIntegrator() : sph_poi_samp(SpherePointSampler()) {}
+  /**
+   * \brief Integrand that is evaluated for many points at once.
+   *
+   * The arguments are the number of points \f$m\f$, arrays of length \f$m\f$
+   * with the values of \f$\theta_i\f$ and \f$\varphi_i\f$, and an array of
+   * length \f$m\f$ for the values \f$f \left( \theta_i, \varphi_i \right)\f$.
+   * This is the signature of AngularCorrelation::evaluate().
+   */
+  typedef function<void(const size_t, const double *, const double *,
+                        double *)>
+      BatchIntegrand;
 
   /**
    * \brief Integrate an arbitary function on a subdomain of a sphere surface
@@ -82,10 +138,125 @@ public:
    *
    * \return Value of the integral \f$\int f \mathrm{d} \Omega\f$
    */
-  double operator()(double f(double theta, double phi), const unsigned int n,
-                    bool is_in_omega(double theta, double phi));
+  double operator()(function<double(const double, const double)> f,
+                    const unsigned int n,
+                    function<bool(const double, const double)> is_in_omega);
 
-protected:
-  const SpherePointSampler
-      sph_poi_samp; /**< Instance of the SpherePointSampler class. */
+  /**
+   * \brief Integrate an arbitrary function on a region of a sphere surface
+   * with points inside the region only
+   *
+   * \param f Function of two variables theta and phi.
+   * \param n Approximate number of points inside the region (see
+   * SphereRegion::sample()).
+   * \param region Domain of the integration.
+   *
+   * \return Value of the integral \f$\int f \mathrm{d} \Omega\f$
+   */
+  double operator()(function<double(const double, const double)> f,
+                    const unsigned int n, const SphereRegion &region);
+
+  /**
+   * \brief Integrate several functions on the same subdomain of a sphere
+   * surface
+   *
+   * The domain is checked only once per point, and all functions are evaluated
+   * at the same points.
+   *
+   * \param f List of functions of two variables theta and phi.
+   * \param n Number of points to be sampled on the sphere surface.
+   * \param is_in_omega Function which returns true if a given point is inside
+   * the desired domain, and false otherwise.
+   *
+   * \return Values of the integrals, in the same order as the functions.
+   */
+  vector<double>
+  operator()(const vector<function<double(const double, const double)>> &f,
+             const unsigned int n,
+             function<bool(const double, const double)> is_in_omega);
+
+  /**
+   * \brief Integrate several functions that can be evaluated for many points
+   * at once on the same subdomain of a sphere surface
+   *
+   * The points inside the domain are collected once, and each integrand is
+   * called a single time for all of them.
+   *
+   * \param f List of integrands.
+   * \param n Number of points to be sampled on the sphere surface.
+   * \param is_in_omega Function which returns true if a given point is inside
+   * the desired domain, and false otherwise.
+   *
+   * \return Values of the integrals, in the same order as the functions.
+   */
+  vector<double>
+  integrate_batch(const vector<BatchIntegrand> &f, const unsigned int n,
+                  function<bool(const double, const double)> is_in_omega);
+
+  /**
+   * \brief Integrate several functions on the same region of a sphere surface
+   * with points inside the region only
+   *
+   * \param f List of functions of two variables theta and phi.
+   * \param n Approximate number of points inside the region (see
+   * SphereRegion::sample()).
+   * \param region Domain of the integration.
+   *
+   * \return Values of the integrals, in the same order as the functions.
+   */
+  vector<double>
+  operator()(const vector<function<double(const double, const double)>> &f,
+             const unsigned int n, const SphereRegion &region);
+
+  /**
+   * \brief Integrate several functions that can be evaluated for many points
+   * at once on the same region of a sphere surface with points inside the
+   * region only
+   *
+   * The points are generated once, and each integrand is called a single
+   * time for all of them.
+   *
+   * \param f List of integrands.
+   * \param n Approximate number of points inside the region (see
+   * SphereRegion::sample()).
+   * \param region Domain of the integration.
+   *
+   * \return Values of the integrals, in the same order as the functions.
+   */
+  vector<double> integrate_batch(const vector<BatchIntegrand> &f,
+                                 const unsigned int n,
+                                 const SphereRegion &region);
+
+  /**
+   * \brief Integrate several functions on a subdomain of a sphere surface
+   * with randomized quasi-Monte Carlo points
+   *
+   * For each of \f$r\f$ replicates, \f$n\f$ points
+   * \f$\left( \cos \theta_i, \varphi_i \right) = \left( 2 u_{i,0} - 1, 2
+   * \pi u_{i,1} \right)\f$ are taken from a two-dimensional
+   * ScrambledSobolSequence with an independent scrambling, and the integral
+   * is estimated like in operator()().
+   * The mean value of the \f$r\f$ estimates is unbiased, and their standard
+   * deviation divided by \f$\sqrt{r}\f$ is an estimate of its uncertainty.
+   * For smooth integrands and \f$n\f$ a power of two, the error decreases
+   * almost like \f$n^{-1}\f$.
+   * Discontinuities, for example at the boundary of the domain, reduce the
+   * rate of convergence, but the estimate of the uncertainty remains valid.
+   *
+   * \param f List of integrands.
+   * \param n Number of points per replicate.
+   * \param is_in_omega Function which returns true if a given point is inside
+   * the desired domain, and false otherwise.
+   * \param n_replicates \f$r\f$, number of independent scramblings, at least
+   * two (default: 8).
+   * \param seed Random number seed of the scramblings (default: 0).
+   *
+   * \return Estimates of the integrals, in the same order as the functions.
+   *
+   * \throw invalid_argument if there are less than two replicates.
+   */
+  vector<IntegralEstimate>
+  integrate_qmc(const vector<BatchIntegrand> &f, const unsigned int n,
+                function<bool(const double, const double)> is_in_omega,
+                const unsigned int n_replicates = 8, const uint64_t seed = 0);
 };
\ No newline at end of file
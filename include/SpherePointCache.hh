@@ -0,0 +1,202 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <memory>
+
+using std::shared_ptr;
+
+#include <string>
+
+using std::string;
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * \brief Process-wide cache for the point sets of SpherePointSampler.
+ *
+ * Sampling \f$n\f$ points with SpherePointSampler::sample() requires the
+ * solution of an equation for the parameter \f$c\f$ of the spiral and of one
+ * equation per point, each of which involves the evaluation of elliptic
+ * integrals.
+ * Since the result only depends on \f$n\f$, this class stores every point set
+ * that has been calculated once.
+ * The point sets are returned as shared pointers to constant objects, so they
+ * can be used by several integrations at the same time without being copied.
+ * Access to the cache is protected by a mutex, i.e. it may be used from
+ * several threads at the same time.
+ *
+ * The content of the cache can be written to and read from a binary file with
+ * SpherePointCache::save() and SpherePointCache::load() to avoid the
+ * calculation in subsequent runs of a program.
+ * The file format is specific to the (floating-point) architecture of the
+ * machine on which it was written.
+ *
+ * Instead of being loaded, a file can also be attached with
+ * SpherePointCache::attach().
+ * It is then mapped read-only into memory with mmap(), and
+ * SpherePointCache::get_view() returns pointers into the mapping, so
+ * processes on the same node that attach the same file share a single copy
+ * of the point sets.
+ */
+class SpherePointCache {
+public:
+  /**
+   * \brief Read-only view of a point set.
+   *
+   * The angles are either stored in the cache or in an attached file.
+   * The view keeps them alive, even if the cache is cleared or the file is
+   * detached.
+   */
+  struct PointSetView {
+    const double *theta; /**< Polar angles, array of length n. */
+    const double *phi;   /**< Azimuthal angles, array of length n. */
+    size_t n;            /**< Number of points. */
+    shared_ptr<const void> owner; /**< Owner of the angles. */
+  };
+
+  /**
+   * \brief Point set with \f$n\f$ points from SpherePointSampler::sample().
+   *
+   * \param n \f$n\f$, number of points.
+   *
+   * \return Polar and azimuthal angles of the points, see
+   * SpherePointSampler::sample().
+   */
+  static shared_ptr<const array<vector<double>, 2>> get(const unsigned int n);
+
+  /**
+   * \brief View of the point set with \f$n\f$ points.
+   *
+   * If the point set is contained in the attached file, the view points into
+   * the mapping, and nothing is calculated or copied.
+   * Otherwise, the point set is taken from get().
+   *
+   * \param n \f$n\f$, number of points.
+   *
+   * \return View of the polar and azimuthal angles of the points.
+   */
+  static PointSetView get_view(const unsigned int n);
+
+  /**
+   * \brief Number of requests that could be answered from the cache.
+   */
+  static size_t get_hits();
+
+  /**
+   * \brief Number of requests that required a call of
+   * SpherePointSampler::sample().
+   */
+  static size_t get_misses();
+
+  /**
+   * \brief Number of point sets stored in the cache.
+   */
+  static size_t size();
+
+  /**
+   * \brief Remove all point sets from the cache, detach the attached file,
+   * and reset the hit and miss counters.
+   */
+  static void clear();
+
+  /**
+   * \brief Write all point sets to a binary file.
+   *
+   * The point sets are first written to a temporary file in the same
+   * directory, which is then renamed, so that other processes never read or
+   * attach a partially written file.
+   *
+   * \param file_name Name of the file. An existing file is replaced.
+   *
+   * \throw invalid_argument if the file cannot be written.
+   */
+  static void save(const string &file_name);
+
+  /**
+   * \brief Add the point sets from a file written by save() to the cache.
+   *
+   * Point sets which are already in the cache are not replaced.
+   *
+   * \param file_name Name of the file.
+   *
+   * \throw invalid_argument if the file cannot be read or has an invalid
+   * format.
+   */
+  static void load(const string &file_name);
+
+  /**
+   * \brief Map a file written by save() into memory and use it for
+   * get_view().
+   *
+   * A previously attached file is detached.
+   *
+   * \param file_name Name of the file.
+   *
+   * \throw invalid_argument if the file cannot be mapped or has an invalid
+   * format.
+   */
+  static void attach(const string &file_name);
+
+  /**
+   * \brief Attach a file, and create it first if it does not exist.
+   *
+   * If the file does not exist, the point sets with the given numbers of
+   * points are calculated with get(), and the cache is written to the file
+   * with save().
+   * Several processes may call this function for the same file at the same
+   * time.
+   * They synchronize with an exclusive lock (see flock()) on the file with
+   * the suffix `.lock`, which is created next to the point sets and not
+   * removed afterwards, so only one of them calculates the point sets, and
+   * all others wait for the file and attach it.
+   * This is the same protocol as for CoefficientTable.
+   *
+   * \param file_name Name of the file.
+   * \param n Numbers of points of the point sets.
+   *
+   * \throw invalid_argument if the lock file cannot be created, or for the
+   * reasons given for save() and attach(const string &).
+   */
+  static void attach(const string &file_name, const vector<unsigned int> &n);
+
+  /**
+   * \brief Detach the attached file.
+   *
+   * The mapping is released when the last view into it is destroyed.
+   */
+  static void detach();
+
+  /**
+   * \brief Number of point sets in the attached file, zero if no file is
+   * attached.
+   */
+  static size_t get_n_attached();
+};
@@ -25,6 +25,8 @@
 using std::array;
 using std::vector;
 
+#include "CarlsonEllipticIntegral.hh"
+
 /**
  * \brief Class for sampling points approximately uniformly on the surface of a
  * sphere
@@ -56,6 +58,25 @@ using std::vector;
 class SpherePointSampler {
 
 public:
+  /**
+   * \brief Constructor
+   *
+   * \param precision Precision of the elliptic integrals that are used
+   * throughout the sampler (default: double_precision).
+   * The convergence criteria of the iterations for \f$c\f$ and
+   * \f$\Theta_j\f$ are much larger than the error of the
+   * approximate_precision mode, which is therefore sufficient for sampling
+   * and saves some iterations of the duplication algorithm.
+   */
+  explicit SpherePointSampler(
+      const EllipticIntegralPrecision precision = double_precision)
+      : precision(precision) {}
+
+  /**
+   * \brief Return the precision of the elliptic integrals.
+   */
+  EllipticIntegralPrecision get_precision() const { return precision; }
+
   /**
    * \brief Sample \f$n\f$ points approximately uniformly on the surface of a
    * unit sphere
@@ -65,7 +86,25 @@ public:
    * by the polar angles \f$\theta_i\f$ and the azimuthal angles
    * \f$\varphi_i\f$, with \f$0 \leq i < n\f$.
    *
+   * The polar angles \f$\Theta_j\f$ of the points are found with the same
+   * iteration as in SpherePointSampler::find_Theta_j, with the default
+   * convergence criterion.
+   * Instead of the initial guess of Ref. \cite Koay2011, the iteration for
+   * \f$\Theta_j\f$ starts from the result for \f$\Theta_{j-1}\f$, advanced by
+   * the difference \f$2\pi / c\f$ of the segment lengths
+   * \f$S \left( \Theta_j \right)\f$ and \f$S \left( \Theta_{j-1} \right)\f$.
+   * The complete elliptic integral that is required by
+   * SpherePointSampler::segment_length is calculated only once.
+   *
+   * The points can be calculated by several threads.
+   * Each thread processes a contiguous range of \f$j\f$, and only the first
+   * point of each range uses the initial guess of Ref. \cite Koay2011.
+   * Therefore, results for different numbers of threads agree within the
+   * convergence criterion, but they are not necessarily identical bit by bit.
+   *
    * \param n \f$n\f$, desired number of points
+   * \param n_threads Number of threads (default: 1). If 0, the number of
+   * concurrent threads supported by the hardware is used.
    *
    * \return std::array that contains two std::vectors with size \f$n\f$. The
    * first vector contains the values \f$\theta_i\f$, and the second vector
@@ -73,7 +112,8 @@ public:
    * \f$\varphi_i\f$ are strictly increasing, i.e. values of \f$\varphi_i >
    * 2\pi\f$ will always be sampled, except for cases with \f$c \approx 1\f$.
    */
-  array<vector<double>, 2> sample(const unsigned int n) const;
+  array<vector<double>, 2> sample(const unsigned int n,
+                                  const unsigned int n_threads = 1) const;
 
   /**
    * \brief Sample \f$n\f$ points approximately uniformly on the surface of a
@@ -132,48 +172,12 @@ public:
    *      k^2 = m.
    * \f]
    *
-   * However, for any real parameter \f$m\f$ that is negative or has an absolute
-   * value larger than 1, the evaluation of the integral can be traced back to
-   * an evaluation in the interval \f$ 0 \leq m < 1 \f$ according to Eqs.
-   * (17.4.16) and (17.4.18) in \cite AbramowitzStegun1974. These
-   * transformations assume a formulation of the incomplete elliptic integral in
-   * terms of the parameter \f$u\f$ instead of \f$\varphi\f$, i.e. \f$E \left( u
-   * | m \right)\f$. The quantity \f$u\f$ is the generalized angle \f$\varphi\f$
-   * for the case of an ellipse , such that, for example, an elliptic equivalent
-   * \f$\mathrm{sn}\f$ {a 'Jacobi Elliptic Function', see, e.g., Sec. 16 in Ref.
-   * \cite abromowitzStegun1974} of the trigonometric function \f$\sin\f$ can be
-   * defined {Eq. (17.2.2) in Ref. \cite AbramowitzStegun1974}:
-   *
-   * \f[
-   *      \mathrm{sn} \left( u \right) = \sin \left( \varphi \right).
-   * \f]
-   *
-   * The equation above provides a straightforward conversion from the Jacobi
-   * elliptic function \f$\mathrm{sn} \left( u \right)\f$ to \f$\varphi\f$ via
-   * the inverse sine. The Jacobi elliptic functions are also implemented in GSL
-   * for the argument \f$u\f$, but it should be noted that this implementation
-   * utilizes the parameter \f$m\f$ instead of \f$k\f$. The conversion from
-   * \f$\varphi\f$ to \f$u\f$ is possible via the definition of the incomplete
-   * elliptic integral of the first kind {Eq. (17.2.7) in Ref. \cite
-   * AbramowitzStegun1974}:
-   *
-   * \f[
-   *      F \left( \varphi | m \right) = u.
-   * \f]
-   *
-   * For an arbitrary \f$m\f$, the function
-   * SpherePointSampler::elliptic_integral_2nd_kind_arbitrary_m will be called
-   * recursively with transformed parameters until the parameter can be handled
-   * by the GSL implementation.
-   *
-   * In fact, the implementation does not only use the formalism of Abramowitz
-   * and Stegun, but the transformation to the interval \f$ 0 \leq m < 1 \f$ of
-   * the incomplete elliptic integral of the second kind is performed using Eq.
-   * (19.7.5) ('Imaginary Modulus Transformation') of the NIST Digital Library
-   * of Mathematical Functions (DLMF) \cite DLMF2020. This equation has the
-   * advantage that it does not require the back-and-forth conversion between
-   * \f$\varphi\f$ and \f$u\f$, and that it handles \f$m < 0\f$ and \f$|m| >
-   * 1\f$ at the same time.
+   * Instead of transformations of the parameter to this range, which would
+   * require recursive calls for large negative \f$m\f$, the integral is
+   * expressed by Carlson's symmetric integrals, which are valid for any real
+   * \f$m\f$ with \f$m \sin^2 \left( \varphi \right) \leq 1\f$ (see
+   * carlson_elliptic_integral::E()).
+   * The precision is the one given to the constructor.
    *
    * \param phi \f$\varphi\f$
    * \param m \f$m\f$
@@ -334,20 +338,21 @@ public:
    *
    * \return \f$\Theta_j\f$
    */
-  double find_Theta_j(const unsigned int j, const unsigned int n,
-                      const double c, const double epsilon = 1e-3,
-                      const unsigned int max_n_iterations = 10000) const;
+  double find_Theta_j(
+      const unsigned int j, const unsigned int n, const double c,
+      const double epsilon = default_epsilon_Theta_j,
+      const unsigned int max_n_iterations = default_max_n_iterations_Theta_j)
+      const;
 
   /**
    * \brief Elliptic integral of the first kind \f$F\left( \varphi | m
    * \right)\f$ for arbitrary real parameters
    *
    * Needed for the determination of the optimum value for \f$c\f$ according to
-   * Eq. (14) in Ref. \cite Koay2011. The transformation from arbitrary real
-   * \f$m\f$ to the range \f$0 \leq m < 1\f$ is given by Eqs. (19.7.5) in Ref.
-   * \cite DLMF2020. See also the definition of
-   * SpherePointSampler::elliptic_integral_2nd_kind_arbitrary_m for more
-   * information.
+   * Eq. (14) in Ref. \cite Koay2011. Like
+   * SpherePointSampler::elliptic_integral_2nd_kind_arbitrary_m, it is
+   * calculated from Carlson's symmetric integrals (see
+   * carlson_elliptic_integral::F()).
    *
    * \param phi \f$\varphi\f$
    * \param m \f$m\f$
@@ -356,4 +361,58 @@ public:
    */
   double elliptic_integral_1st_kind_arbitrary_m(const double phi,
                                                 const double m) const;
+
+  /**
+   * \brief Default convergence criterion of SpherePointSampler::find_Theta_j.
+   */
+  static constexpr double default_epsilon_Theta_j = 1e-3;
+
+  /**
+   * \brief Default maximum number of iterations of
+   * SpherePointSampler::find_Theta_j.
+   */
+  static constexpr unsigned int default_max_n_iterations_Theta_j = 10000;
+
+protected:
+  /**
+   * \brief Length of a spiral segment with a precalculated complete elliptic
+   * integral
+   *
+   * Same as SpherePointSampler::segment_length(const double, const double),
+   * but the complete elliptic integral \f$E \left( \pi / 2 | -c^2 \right)\f$,
+   * which is required for \f$\Theta > \pi / 2\f$, is passed as an argument.
+   *
+   * \param Theta \f$\Theta\f$
+   * \param c \f$c\f$
+   * \param complete_elliptic_integral_2nd \f$E \left( \pi / 2 | -c^2
+   * \right)\f$
+   *
+   * \return \f$S \left( \Theta, c \right)\f$
+   */
+  double segment_length(const double Theta, const double c,
+                        const double complete_elliptic_integral_2nd) const;
+
+  /**
+   * \brief Iteration of SpherePointSampler::find_Theta_j with an arbitrary
+   * initial value
+   *
+   * \param j \f$j\f$, index of the spiral segment.
+   * \param c \f$c\f$
+   * \param Theta_j_0 Initial value for \f$\Theta_j\f$.
+   * \param epsilon_segment Absolute convergence criterion, i.e. \f$\epsilon
+   * S\left( \pi \right) n^{-1}\f$ in the notation of
+   * SpherePointSampler::find_Theta_j.
+   * \param complete_elliptic_integral_2nd \f$E \left( \pi / 2 | -c^2
+   * \right)\f$
+   * \param max_n_iterations Maximum number of iterations.
+   *
+   * \return \f$\Theta_j\f$
+   */
+  double solve_Theta_j(const unsigned int j, const double c,
+                       const double Theta_j_0, const double epsilon_segment,
+                       const double complete_elliptic_integral_2nd,
+                       const unsigned int max_n_iterations) const;
+
+  EllipticIntegralPrecision
+      precision; /**< Precision of the elliptic integrals. */
 };
\ No newline at end of file
@@ -0,0 +1,175 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+
+/**
+ * \brief Types of quadrature rules of SphereQuadrature.
+ */
+enum QuadratureRule : short { lebedev = 0, gauss_legendre_trapezoid = 1 };
+
+/**
+ * \brief Quadrature rules on the unit sphere that are exact for polynomials up
+ * to a given degree.
+ *
+ * A quadrature rule approximates the integral of a function over the surface
+ * of the unit sphere by a weighted sum over \f$n\f$ points
+ * \f$\left( \theta_i, \varphi_i \right)\f$:
+ *
+ * \f[
+ *      \int f \left( \theta, \varphi \right) \mathrm{d} \Omega \approx
+ * \sum_{i=0}^{n-1} w_i f \left( \theta_i, \varphi_i \right). \f]
+ *
+ * A rule of degree \f$d\f$ is exact for all polynomials up to degree \f$d\f$
+ * in the Cartesian coordinates \f$x\f$, \f$y\f$, and \f$z\f$, i.e. for all
+ * spherical harmonics \f$Y_l^m\f$ with \f$l \leq d\f$.
+ * An angular correlation with a maximum order \f$\nu_\mathrm{max}\f$ of the
+ * Legendre expansion (see W_dir_dir and W_pol_dir) is a polynomial of degree
+ * \f$\nu_\mathrm{max}\f$, which is integrated exactly (up to rounding errors)
+ * by a rule of degree \f$\nu_\mathrm{max}\f$.
+ * The integral of the product of two such functions requires the sum of their
+ * degrees.
+ * Compared to the SphereIntegrator, which needs thousands of points for a
+ * precision of about \f$10^{-3}\f$, the rules here need only tens of points.
+ *
+ * Two types of rules are available:
+ *
+ *  - QuadratureRule::lebedev: Lebedev rules \cite Lebedev1976 with octahedral
+ * symmetry, which are the most efficient ones.
+ * They are implemented for the degrees 3, 5, 7, 9, 11, 13, and 15 with 6, 14,
+ * 26, 38, 50, 74, and 86 points, respectively.
+ *  - QuadratureRule::gauss_legendre_trapezoid: Product of a Gauss-Legendre rule
+ * with \f$d / 2 + 1\f$ points in \f$\cos \left( \theta \right)\f$ and a
+ * trapezoidal rule with \f$d + 1\f$ points in \f$\varphi\f$, which is
+ * available for any degree \f$d\f$.
+ *
+ * The smallest rule of the requested type whose degree is at least \f$d\f$ is
+ * used.
+ */
+class SphereQuadrature {
+
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param degree \f$d\f$, minimum degree of the rule.
+   * \param rule Type of the rule (default: QuadratureRule::lebedev).
+   *
+   * \throw invalid_argument if no Lebedev rule with a degree of at least
+   * \f$d\f$ is implemented.
+   */
+  SphereQuadrature(const unsigned int degree,
+                   const QuadratureRule rule = lebedev);
+
+  /**
+   * \brief Constructor for the smallest rule that integrates an angular
+   * correlation exactly.
+   *
+   * \param ang_corr Angular correlation.
+   * \param rule Type of the rule (default: QuadratureRule::lebedev).
+   */
+  SphereQuadrature(const AngularCorrelation &ang_corr,
+                   const QuadratureRule rule = lebedev)
+      : SphereQuadrature(ang_corr.get_nu_max(), rule) {}
+
+  /**
+   * \brief Integrate a function over the unit sphere.
+   *
+   * \tparam F Type of the function, any callable object with two arguments.
+   * \param f \f$f \left( \theta, \varphi \right)\f$, function of the polar and
+   * azimuthal angle in radians.
+   *
+   * \return \f$\sum_i w_i f \left( \theta_i, \varphi_i \right)\f$
+   */
+  template <typename F> double operator()(F &&f) const {
+    double integral = 0.;
+    for (size_t i = 0; i < weights.size(); ++i) {
+      integral += weights[i] * f(theta[i], phi[i]);
+    }
+    return integral;
+  }
+
+  /**
+   * \brief Maximum degree of the implemented Lebedev rules.
+   */
+  static constexpr unsigned int max_lebedev_degree = 15;
+
+  /**
+   * \brief Degree of the rule, which may be larger than the requested degree.
+   */
+  unsigned int get_degree() const { return degree; }
+
+  /**
+   * \brief Number of points \f$n\f$.
+   */
+  size_t get_n_points() const { return weights.size(); }
+
+  /**
+   * \brief Polar angles \f$\theta_i\f$ of the points in radians.
+   */
+  const vector<double> &get_theta() const { return theta; }
+
+  /**
+   * \brief Azimuthal angles \f$\varphi_i \in \left[ 0, 2 \pi \right)\f$ of the
+   * points in radians.
+   */
+  const vector<double> &get_phi() const { return phi; }
+
+  /**
+   * \brief Weights \f$w_i\f$ of the points, which sum to \f$4 \pi\f$.
+   */
+  const vector<double> &get_weights() const { return weights; }
+
+protected:
+  /**
+   * \brief Set up a Lebedev rule.
+   *
+   * \param min_degree Minimum degree of the rule.
+   */
+  void create_lebedev(const unsigned int min_degree);
+
+  /**
+   * \brief Set up a Gauss-Legendre-trapezoid product rule.
+   *
+   * \param min_degree Minimum degree of the rule.
+   */
+  void create_gauss_legendre_trapezoid(const unsigned int min_degree);
+
+  /**
+   * \brief Add a point given in Cartesian coordinates.
+   *
+   * \param x \f$x\f$ coordinate.
+   * \param y \f$y\f$ coordinate.
+   * \param z \f$z\f$ coordinate.
+   * \param weight Weight of the point.
+   */
+  void add_point(const double x, const double y, const double z,
+                 const double weight);
+
+  unsigned int degree;    /**< Degree of the rule. */
+  vector<double> theta;   /**< Polar angles of the points. */
+  vector<double> phi;     /**< Azimuthal angles of the points. */
+  vector<double> weights; /**< Weights of the points. */
+};
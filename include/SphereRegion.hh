@@ -0,0 +1,186 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * \brief Region on the surface of a sphere that can be covered by
+ * quadrature points without sampling the rest of the sphere.
+ *
+ * A region is a union of parts, each of which is either
+ *
+ * - a cone (a spherical cap) with the axis \f$\left( \theta_0, \varphi_0
+ * \right)\f$ and the half opening angle \f$\alpha\f$, i.e. all directions
+ * whose angle with the axis is at most \f$\alpha\f$, like the solid angle
+ * covered by a circular detector, or
+ * - a box \f$\theta_\mathrm{min} \leq \theta \leq \theta_\mathrm{max}\f$,
+ * \f$\varphi_\mathrm{min} \leq \varphi \leq \varphi_\mathrm{max}\f$ (modulo
+ * \f$2 \pi\f$) in spherical coordinates.
+ *
+ * In a local coordinate system whose \f$z\f$ axis is the axis of the cone
+ * (or the \f$z\f$ axis itself for a box), each part is a rectangle in the
+ * coordinates \f$\left( \cos \theta^\prime, \varphi^\prime \right)\f$, in
+ * which the surface element is uniform.
+ * Therefore, the points of a Fibonacci lattice in the rectangle
+ * (see sample()) are uniformly distributed on the part, and all of them have
+ * the same weight, i.e. the area of the part divided by the number of
+ * points.
+ * For a union, the points of a part that are also inside one of the
+ * previous parts are dropped, so the overlap of two parts is not counted
+ * twice.
+ *
+ * Compared to the selection of points from a set on the entire sphere with
+ * a function that indicates whether a point is inside the region (see
+ * SphereIntegrator), all points are inside the region, which is much more
+ * efficient and accurate for small regions like detectors.
+ */
+class SphereRegion {
+public:
+  /**
+   * \brief Constructor for a cone.
+   *
+   * \param theta_phi Polar and azimuthal angle of the axis in radians.
+   * \param opening_angle Half opening angle \f$\alpha\f$ in radians.
+   *
+   * \throw invalid_argument if \f$\alpha \notin \left( 0, \pi \right]\f$.
+   */
+  SphereRegion(const array<double, 2> theta_phi, const double opening_angle);
+
+  /**
+   * \brief Constructor for a box in spherical coordinates.
+   *
+   * \param theta_range \f$\theta_\mathrm{min}\f$ and
+   * \f$\theta_\mathrm{max}\f$ in radians.
+   * \param phi_range \f$\varphi_\mathrm{min}\f$ and
+   * \f$\varphi_\mathrm{max}\f$ in radians.
+   * The azimuthal range may extend beyond \f$2 \pi\f$, for example
+   * \f$\left[ -\pi / 4, \pi / 4 \right]\f$ for a box around the \f$x\f$
+   * axis.
+   *
+   * \throw invalid_argument unless \f$0 \leq \theta_\mathrm{min} <
+   * \theta_\mathrm{max} \leq \pi\f$ and \f$0 < \varphi_\mathrm{max} -
+   * \varphi_\mathrm{min} \leq 2 \pi\f$.
+   */
+  SphereRegion(const array<double, 2> theta_range,
+               const array<double, 2> phi_range);
+
+  /**
+   * \brief Constructor for a union of regions.
+   *
+   * \param regions Regions whose parts are combined in this order.
+   *
+   * \throw invalid_argument if regions is empty.
+   */
+  explicit SphereRegion(const vector<SphereRegion> &regions);
+
+  /**
+   * \brief Check whether a direction is inside the region.
+   *
+   * \param theta Polar angle in radians.
+   * \param phi Azimuthal angle in radians.
+   */
+  bool contains(const double theta, const double phi) const;
+
+  /**
+   * \brief Number of parts of the region.
+   */
+  size_t get_n_parts() const { return parts.size(); }
+
+  /**
+   * \brief Sum of the solid angles of the parts.
+   *
+   * This is the solid angle of the region if the parts do not overlap.
+   */
+  double get_solid_angle_of_parts() const;
+
+  /**
+   * \brief Generate quadrature points inside the region.
+   *
+   * The \f$n\f$ points are distributed among the parts in proportion to
+   * their solid angles, with at least one point per part.
+   * For a part with \f$n_j\f$ points, the local coordinates of the point
+   * \f$i\f$ are
+   *
+   * \f[
+   *      \cos \theta^\prime_i = z_\mathrm{max} - \frac{i + 1/2}{n_j} \left(
+   * z_\mathrm{max} - z_\mathrm{min} \right), \quad
+   *      \varphi^\prime_i = \varphi^\prime_\mathrm{min} + \left\{ i g
+   * \right\} \left( \varphi^\prime_\mathrm{max} -
+   * \varphi^\prime_\mathrm{min} \right), \f]
+   *
+   * where \f$\left\{ x \right\}\f$ is the fractional part of \f$x\f$ and
+   * \f$g = \left( \sqrt{5} - 1 \right) / 2\f$.
+   * Points that are inside a previous part are dropped, so the number of
+   * returned points may be smaller than \f$n\f$ (or larger by at most the
+   * number of parts due to rounding).
+   *
+   * \param n Approximate number of points.
+   * \param theta Polar angles of the points in radians, the previous content
+   * is replaced.
+   * \param phi Azimuthal angles of the points in radians, in the range
+   * \f$\left[ 0, 2 \pi \right)\f$, the previous content is replaced.
+   * \param weight Solid angle represented by each point, the previous content
+   * is replaced.
+   */
+  void sample(const unsigned int n, vector<double> &theta, vector<double> &phi,
+              vector<double> &weight) const;
+
+protected:
+  /**
+   * \brief Rectangle in the local coordinates \f$\left( \cos \theta^\prime,
+   * \varphi^\prime \right)\f$, and the orientation of the local coordinate
+   * system.
+   */
+  struct Part {
+    double z_min;       /**< Minimum of \f$\cos \theta^\prime\f$. */
+    double z_max;       /**< Maximum of \f$\cos \theta^\prime\f$. */
+    double phi_min;     /**< Minimum of \f$\varphi^\prime\f$. */
+    double phi_max;     /**< Maximum of \f$\varphi^\prime\f$. */
+    bool rotated;       /**< Whether the local \f$z\f$ axis differs from the
+                           global one. */
+    double cos_theta_0; /**< Cosine of the polar angle of the local \f$z\f$
+                           axis. */
+    double sin_theta_0; /**< Sine of the polar angle of the local \f$z\f$
+                           axis. */
+    double cos_phi_0;   /**< Cosine of the azimuthal angle of the local
+                           \f$z\f$ axis. */
+    double sin_phi_0;   /**< Sine of the azimuthal angle of the local \f$z\f$
+                           axis. */
+  };
+
+  /**
+   * \brief Check whether a direction is inside a part.
+   */
+  static bool part_contains(const Part &part, const double theta,
+                            const double phi);
+
+  vector<Part> parts; /**< Parts of the region. */
+};
@@ -23,17 +23,12 @@
 
 using std::function;
 
-#include <random>
-
-using std::mt19937;
-using std::uniform_real_distribution;
-
 #include <utility>
 
 using std::pair;
 using std::tuple;
 
-#include "ReferenceFrameSampler.hh"
+#include "TypedSphereRejectionSampler.hh"
 
 /**
  * \brief Sample from a probability distribution in spherical coordinates using
@@ -116,8 +111,14 @@ using std::tuple;
  * vectors \f$N_\mathrm{max}\f$. If this maximum number is reached, the Euler
  * angles \f$\left( 0, 0, 0 \right)\f$ are returned, which correspond to
  * spherical coordinates \f$\theta = 0\f$ and \f$\varphi = \pi/2\f$.
+ *
+ * The distribution is stored as a std::function, which allows arbitrary
+ * callable objects. For distributions whose type is known at compile time, see
+ * TypedSphereRejectionSampler.
  */
-class SphereRejectionSampler : public ReferenceFrameSampler {
+class SphereRejectionSampler
+    : public TypedSphereRejectionSampler<
+          function<double(const double, const double)>> {
 
 public:
   /**
@@ -134,55 +135,4 @@ public:
   SphereRejectionSampler(function<double(const double, const double)> dis,
                          const double dis_max, const int seed,
                          const unsigned int max_tri = 1000);
-
-  /**
-   * \brief Sample a random vector from probability distribution and record the
-   * number of tries.
-   *
-   * \return std::pair which contains \f$N\f$, the number of tries that were
-   * needed to find a valid vector, and the accepted vector \f$\left(
-   * \theta_\mathrm{rand}, \varphi_\mathrm{rand}\right)\f$. Returns a std::pair
-   * of \f$N_\mathrm{max}\f$ and \f$\left(0, 0 \right)\f$, if the maximum number
-   * of trials \f$N_\mathrm{max}\f$ is reached by the algorithm and no random
-   * vector was accepted.
-   */
-  virtual pair<unsigned int, array<double, 3>> sample() override;
-
-protected:
-  /**
-   * \brief Sample polar angle of a uniformly randomly distributed point on a
-   * sphere surface.
-   *
-   * \return \f$\theta_\mathrm{rand}\f$, random polar angle.
-   */
-  double sample_theta();
-
-  /**
-   * \brief Sample azimuthal angle of a uniformly randomly distributed point on
-   * a sphere surface.
-   *
-   * \return \f$\varphi_\mathrm{rand}\f$, random azimuthal angle.
-   */
-  double sample_phi();
-
-  /**
-   * \brief Sample uniformly randomly distributed point on a sphere surface.
-   *
-   * \return \f$\left( \theta_\mathrm{rand}, \varphi_\mathrm{rand} \right)\f$,
-   * random point on sphere surface.
-   */
-  array<double, 2> sample_theta_phi();
-
-  function<double(const double, const double)>
-      distribution; /**< \f$W \left( \theta, \varphi \right)\f$, (unnormalized)
-                       probability distribution. */
-  const double distribution_maximum; /**< \f$W_\mathrm{max}\f$, maximum of
-                                        probability distribution. */
-  const unsigned int max_tries; /**< \f$N_\mathrm{max}\f$, maximum number of
-                                   tries to find a random vector. */
-
-  mt19937 random_engine; /**< Deterministic random number engine. */
-  uniform_real_distribution<double>
-      uniform_random; /**< Uniform distribution from which all random numbers
-                         are derived here. */
-};
\ No newline at end of file
+};
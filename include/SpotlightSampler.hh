@@ -35,11 +35,24 @@ public:
   SpotlightSampler(const array<double, 2> theta_phi, const double distance,
                    const double radius, const int seed);
   pair<unsigned int, array<double, 3>> sample();
+  /**
+   * \brief Sample a reference frame as a rotation matrix.
+   *
+   * Uses the same random numbers as sample(), but calculates the rotation
+   * matrix directly from the sampled \f$\cos \left( \theta \right)\f$.
+   * For an opening angle of zero, the rotation matrix is calculated only once
+   * in the constructor.
+   */
+  pair<unsigned int, euler_angle_transform::RotationMatrix>
+  sample_rotation_matrix() override;
+  void reseed(seed_seq &seq) override;
 
 protected:
   const array<double, 2> theta_phi;
   const double opening_angle;
   double u_min{0.5};
+  euler_angle_transform::RotationMatrix
+      fixed_rotation; /**< Rotation matrix for an opening angle of zero. */
   const int seed;
 
   mt19937 random_engine; /**< Deterministic random number engine. */
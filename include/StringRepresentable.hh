@@ -19,13 +19,9 @@
 
 #pragma once
 
-#include <iomanip>
+#include <cstdio>
 
-using std::setprecision;
-
-#include <sstream>
-
-using std::stringstream;
+using std::snprintf;
 
 #include <string>
 
@@ -37,6 +33,12 @@ using std::vector;
 
 /**'
  * \brief Abstract class for string-representable expressions
+ *
+ * Derived classes implement write_string_representation(), which appends the
+ * expression to an existing string. Nested expressions are written into the
+ * same buffer, so that a caller who exports many expressions can reserve the
+ * memory once and reuse it. The function string_representation() is a
+ * wrapper that returns the expression as a new string.
  */
 class StringRepresentable {
 
@@ -56,20 +58,63 @@ public:
    *
    * \return String representation.
    */
-  virtual string
-  string_representation(const unsigned int n_digits = 0,
-                        const vector<string> variable_names = {}) const = 0;
+  string string_representation(const unsigned int n_digits = 0,
+                               const vector<string> variable_names = {}) const {
+    string str_rep;
+    write_string_representation(str_rep, n_digits, variable_names);
+    return str_rep;
+  }
+
+  /**
+   * \brief Append string representation of expression to a string.
+   *
+   * See also string_representation(). The existing content of str_rep is
+   * kept, and its capacity is only increased if necessary.
+   *
+   * \param str_rep String to which the representation is appended.
+   * \param n_digits Determines whether the expression
+   * should be evaluated numerically, (n_digits > 0). If yes, indicates how many
+   * digits should be displayed (default: 0).
+   * \param variable_names Names for the variables of a function (default: {}
+   * i.e. use default names).
+   */
+  virtual void write_string_representation(
+      string &str_rep, const unsigned int n_digits = 0,
+      const vector<string> &variable_names = {}) const = 0;
 
 protected:
   string float_string_representation(const unsigned int n_digits,
                                      const double number) const {
-    stringstream str_rep;
+    string str_rep;
+    write_float_string_representation(str_rep, n_digits, number);
+    return str_rep;
+  };
+
+  /**
+   * \brief Append a number to a string.
+   *
+   * The format is the same as the one of an output stream with
+   * std::setprecision(n_digits). Negative numbers are enclosed in brackets.
+   *
+   * \param str_rep String to which the number is appended.
+   * \param n_digits Number of significant digits.
+   * \param number Number.
+   */
+  static void write_float_string_representation(string &str_rep,
+                                                const unsigned int n_digits,
+                                                const double number) {
     if (number < 0.) {
-      str_rep << "\\left(" << std::setprecision(n_digits) << number
-              << "\\right)";
-    } else {
-      str_rep << std::setprecision(n_digits) << number;
+      str_rep += "\\left(";
     }
-    return str_rep.str();
-  };
-};
\ No newline at end of file
+    const int precision = static_cast<int>(n_digits);
+    const size_t offset = str_rep.size();
+    const int length = snprintf(nullptr, 0, "%.*g", precision, number);
+    str_rep.resize(offset + static_cast<size_t>(length) + 1);
+    snprintf(&str_rep[offset], static_cast<size_t>(length) + 1, "%.*g",
+             precision, number);
+    str_rep.pop_back();
+    if (number < 0.) {
+      str_rep += "\\right)";
+    }
+  }
+};
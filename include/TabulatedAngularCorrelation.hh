@@ -0,0 +1,299 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <memory>
+
+using std::shared_ptr;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+
+/**
+ * \brief Angular correlation which is evaluated by interpolation in a table.
+ *
+ * Any angular correlation in this library can be written as (see
+ * W_gamma_gamma::get_legendre_coefficients())
+ *
+ * \f[
+ *      W \left( \theta, \varphi \right) = A \left[ \cos \left( \theta \right)
+ * \right] + \cos \left( 2 \varphi \right) B \left[ \cos \left( \theta \right)
+ * \right], \f]
+ *
+ * with
+ *
+ * \f[
+ *      A \left( x \right) = \sum_{i=0}^{\nu_\mathrm{max}/2} c_i P_{2i}
+ * \left( x \right), ~~ B \left( x \right) = \sum_{i=0}^{\nu_\mathrm{max}/2 -
+ * 1} d_i P_{2i+2}^{\left| 2 \right|} \left( x \right). \f]
+ *
+ * For a dir-dir correlation, \f$B = 0\f$.
+ * This class tabulates the one-dimensional functions \f$A\f$ and \f$B\f$ on a
+ * uniform grid of \f$n\f$ intervals of width \f$h = 2/n\f$ in \f$x = \cos
+ * \left( \theta \right)\f$.
+ * On each interval, \f$A\f$ and \f$B\f$ are replaced by the cubic Hermite
+ * polynomials which reproduce their values and first derivatives at the
+ * boundaries of the interval.
+ * After the table has been built once, an evaluation costs a constant number of
+ * operations, independent of \f$\nu_\mathrm{max}\f$.
+ *
+ * The error of cubic Hermite interpolation is bounded by \cite Stoer2002
+ *
+ * \f[
+ *      \left| f \left( x \right) - p \left( x \right) \right| \leq
+ * \frac{h^4}{384} \mathrm{max}_{x \in \left[ -1, 1 \right]} \left| f^{(4)}
+ * \left( x \right) \right|. \f]
+ *
+ * The maximum of the fourth derivative is bounded by the triangle inequality
+ * and the fact that all derivatives of \f$P_l\f$ attain their maximum
+ * absolute value on \f$\left[ -1, 1 \right]\f$ at \f$x = 1\f$:
+ *
+ * \f[
+ *      P_l^{(k)} \left( 1 \right) = \frac{\left( l + k \right)!}{2^k k!
+ * \left( l - k \right)!}. \f]
+ *
+ * With \f$P_l^{\left| 2 \right|} = \left( 1 - x^2 \right) P_l^{\prime
+ * \prime}\f$, this gives
+ *
+ * \f[
+ *      \left| A^{(4)} \right| + \left| B^{(4)} \right| \leq \sum_i \left|
+ * c_i \right| P_{2i}^{(4)} \left( 1 \right) + \sum_i \left| d_i \right|
+ * \left[ P_{2i+2}^{(6)} \left( 1 \right) + 8 P_{2i+2}^{(5)} \left( 1 \right) +
+ * 12 P_{2i+2}^{(4)} \left( 1 \right) \right] \equiv M_4. \f]
+ *
+ * The constructor chooses the smallest number of intervals for which
+ * \f$h^4 M_4 / 384\f$ is smaller than the requested maximum error, which is
+ * therefore a certified upper limit for the interpolation error, up to
+ * rounding errors of the order of the machine epsilon.
+ * For \f$\nu_\mathrm{max} \leq 2\f$, \f$A\f$ and \f$B\f$ are quadratic and a
+ * single interval reproduces them exactly.
+ *
+ * The table is immutable after construction and shared by all copies of a
+ * TabulatedAngularCorrelation object.
+ * Since all member functions are const and do not modify any state, the same
+ * object can be used by any number of threads at the same time.
+ * The object has a member function evaluate_cos_theta() with the same
+ * signature as W_gamma_gamma::evaluate_cos_theta(), so it can be used as the
+ * distribution of a TypedSphereRejectionSampler together with
+ * get_upper_limit().
+ */
+class TabulatedAngularCorrelation {
+
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param ang_cor Angular correlation \f$W_{\gamma \gamma}\f$.
+   * \param max_error Maximum absolute error of the interpolation (default:
+   * \f$10^{-6}\f$).
+   * Since the angular correlations in this library are normalized such that
+   * their mean value on the sphere is 1, this is approximately also the
+   * relative error.
+   *
+   * \throw invalid_argument if max_error is not positive, or if it would
+   * require more than max_n_intervals intervals.
+   */
+  TabulatedAngularCorrelation(const AngularCorrelation &ang_cor,
+                              const double max_error = 1e-6);
+
+  /**
+   * \brief Constructor from expansion coefficients
+   *
+   * See CompactAngularCorrelation.
+   *
+   * \param legendre_coefficients Coefficients \f$c_i\f$, at least one.
+   * \param associated_legendre_coefficients Coefficients \f$d_i\f$. Either
+   * empty, or one less than \f$c_i\f$.
+   * \param max_error Maximum absolute error of the interpolation.
+   *
+   * \throw invalid_argument if the numbers of coefficients are inconsistent,
+   * if max_error is not positive, or if it would require more than
+   * max_n_intervals intervals.
+   */
+  TabulatedAngularCorrelation(
+      const vector<double> &legendre_coefficients,
+      const vector<double> &associated_legendre_coefficients,
+      const double max_error = 1e-6);
+
+  /**
+   * \brief Evaluate the tabulated angular correlation.
+   *
+   * \param theta Polar angle in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$).
+   * \param phi Azimuthal angle in spherical coordinates in radians.
+   *
+   * \return \f$W \left( \theta, \varphi \right)\f$
+   */
+  double operator()(const double theta, const double phi) const;
+
+  /**
+   * \brief Evaluate the tabulated angular correlation for many directions at
+   * once.
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$), array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians, array of
+   * length n. May be a nullptr for a dir-dir correlation.
+   * \param result Array of length n for the values \f$W \left( \theta_i,
+   * \varphi_i \right)\f$.
+   */
+  void evaluate(const size_t n, const double *theta, const double *phi,
+                double *result) const;
+
+  /**
+   * \brief Evaluate the tabulated angular correlation for many directions at
+   * once, given the cosines of the polar angles.
+   *
+   * \param n Number of directions.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians, array of
+   * length n. May be a nullptr for a dir-dir correlation.
+   * \param result Array of length n for the values \f$W \left( \theta_i,
+   * \varphi_i \right)\f$.
+   */
+  void evaluate_cos_theta(const size_t n, const double *cos_theta,
+                          const double *phi, double *result) const;
+
+  /**
+   * \brief Evaluate the rotated tabulated angular correlation for many
+   * directions at once.
+   *
+   * See AngularCorrelation::evaluate(const size_t, const double *, const
+   * double *, const array<double, 3>, double *) const.
+   * The rotated directions are not converted back to spherical coordinates.
+   * Instead, \f$\cos \left( \theta \right)\f$ is the z component of the
+   * rotated unit vector \f$\vec{r}\f$, and
+   *
+   * \f[
+   *      \cos \left( 2 \varphi \right) = \frac{r_x^2 - r_y^2}{r_x^2 + r_y^2},
+   * \f]
+   *
+   * so that no inverse trigonometric function is called.
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$), array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians, array of
+   * length n.
+   * \param Phi_Theta_Psi Euler angles \f$\Phi\f$, \f$\Theta\f$, and
+   * \f$\Psi\f$ in radians.
+   * \param result Array of length n for the values of the rotated angular
+   * correlation.
+   */
+  void evaluate(const size_t n, const double *theta, const double *phi,
+                const array<double, 3> Phi_Theta_Psi, double *result) const;
+
+  /**
+   * \brief Upper limit for the interpolation error.
+   *
+   * \return \f$h^4 M_4 / 384\f$, which is smaller than or equal to the
+   * maximum error that was requested in the constructor.
+   */
+  double get_error_bound() const { return error_bound; }
+
+  /**
+   * \brief Upper limit for the tabulated angular correlation.
+   *
+   * \return Maximum of \f$\left| A \right| + \left| B \right|\f$ (see
+   * legendre_series::maximum()) plus get_error_bound().
+   */
+  double get_upper_limit() const { return upper_limit; }
+
+  /**
+   * \brief Number of intervals \f$n\f$ of the table.
+   */
+  size_t get_n_intervals() const { return n_intervals; }
+
+  /**
+   * \brief Maximum order \f$\nu_\mathrm{max}\f$ of the Legendre expansion of
+   * the original angular correlation.
+   */
+  int get_nu_max() const { return nu_max; }
+
+  /**
+   * \brief Whether the correlation depends on \f$\varphi\f$, i.e. whether
+   * there is a table for \f$B\f$.
+   */
+  bool is_polarized() const { return polarized; }
+
+  /**
+   * \brief Memory used by the table.
+   */
+  size_t get_size_in_bytes() const {
+    return sizeof(*this) + table->size() * sizeof(double);
+  }
+
+  /**
+   * \brief Upper limit for the maximum absolute value of the fourth derivative
+   * of the series of Legendre polynomials.
+   *
+   * \param legendre_coefficients Coefficients \f$c_i\f$.
+   * \param associated_legendre_coefficients Coefficients \f$d_i\f$.
+   *
+   * \return \f$M_4\f$
+   */
+  static double
+  fourth_derivative_limit(const vector<double> &legendre_coefficients,
+                          const vector<double> &associated_legendre_coefficients);
+
+  /**
+   * \brief Maximum number of intervals of the table.
+   */
+  static constexpr size_t max_n_intervals = 1 << 20;
+
+protected:
+  /**
+   * \brief Evaluate the table for a single point.
+   *
+   * \param cos_theta \f$\cos \left( \theta \right)\f$
+   * \param cos_2phi \f$\cos \left( 2 \varphi \right)\f$ (ignored for a
+   * dir-dir correlation).
+   *
+   * \return \f$A \left( \cos \theta \right) + \cos \left( 2 \varphi
+   * \right) B \left( \cos \theta \right)\f$
+   */
+  double interpolate(const double cos_theta, const double cos_2phi) const;
+
+  int nu_max;             /**< \f$\nu_\mathrm{max}\f$ */
+  bool polarized;         /**< Whether there is a table for \f$B\f$. */
+  size_t n_intervals;     /**< Number of intervals \f$n\f$. */
+  double inverse_width;   /**< \f$1/h\f$ */
+  double error_bound;     /**< \f$h^4 M_4 / 384\f$ */
+  double upper_limit;     /**< Upper limit for \f$W\f$. */
+  size_t stride;          /**< Number of table entries per interval. */
+  /**
+   * \brief Coefficients of the cubic polynomials in \f$t = x/h - k\f$ on
+   * each interval \f$k\f$, ordered by increasing power of \f$t\f$, first for
+   * \f$A\f$ and then for \f$B\f$.
+   */
+  shared_ptr<const vector<double>> table;
+};
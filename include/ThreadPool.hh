@@ -0,0 +1,105 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <functional>
+
+using std::function;
+
+/**
+ * \brief Process-wide pool of worker threads for the batch functions of the
+ * C interface.
+ *
+ * The Python bindings call the C interface of alpaca with NumPy arrays of
+ * millions of elements, and ctypes releases the global interpreter lock during
+ * the call.
+ * ThreadPool::parallel_for() divides such a loop into contiguous ranges of
+ * indices, which are processed by a set of worker threads and by the calling
+ * thread.
+ * The workers are started when they are needed for the first time and wait for
+ * new work afterwards, so a call does not pay for the creation of threads.
+ *
+ * The number of threads includes the calling thread.
+ * It is initialized from the environment variable `ALPACA_NUM_THREADS`, or
+ * with the number of concurrent threads supported by the hardware if the
+ * variable is not set, and it can be changed with set_n_threads().
+ * A value of 1 disables the parallelization.
+ *
+ * Small loops are not worth the synchronization: a loop is only divided if
+ * each range contains at least get_min_work() units of work (for example,
+ * evaluations of an angular correlation for a single direction).
+ * Calls of parallel_for() inside a range that is already executed in parallel
+ * are executed serially.
+ *
+ * All functions may be called from several threads at the same time.
+ */
+class ThreadPool {
+public:
+  /**
+   * \brief Default value of get_min_work().
+   */
+  static constexpr size_t default_min_work = 16384;
+
+  /**
+   * \brief Execute a function for all indices in \f$\left[ 0, n \right)\f$,
+   * in parallel if the amount of work is large enough.
+   *
+   * \param n Number of indices.
+   * \param f Function which is called with the first index and one past the
+   * last index of a range. The ranges of different calls do not overlap and
+   * together cover all indices.
+   * \param work_per_index Units of work per index (default: 1).
+   *
+   * \throw Any exception thrown by f. If several ranges throw an exception,
+   * one of them is rethrown after all ranges have finished.
+   */
+  static void parallel_for(const size_t n,
+                           const function<void(size_t, size_t)> &f,
+                           const size_t work_per_index = 1);
+
+  /**
+   * \brief Number of threads, including the calling thread.
+   */
+  static unsigned int get_n_threads();
+
+  /**
+   * \brief Set the number of threads.
+   *
+   * \param n_threads Number of threads, including the calling thread. If zero,
+   * the number of concurrent threads supported by the hardware is used.
+   */
+  static void set_n_threads(const unsigned int n_threads);
+
+  /**
+   * \brief Minimum number of units of work per range.
+   */
+  static size_t get_min_work();
+
+  /**
+   * \brief Set the minimum number of units of work per range.
+   *
+   * \param min_work Minimum number of units of work. Zero is treated as one.
+   */
+  static void set_min_work(const size_t min_work);
+};
@@ -0,0 +1,580 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+#pragma once
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <array>
+
+using std::array;
+
+#include <cmath>
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <cstdint>
+
+using std::uint64_t;
+
+#include <optional>
+
+using std::optional;
+
+#include <random>
+
+using std::mt19937;
+
+#include <type_traits>
+
+using std::false_type;
+using std::is_same_v;
+using std::true_type;
+using std::void_t;
+
+#include <utility>
+
+using std::declval;
+using std::move;
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AdaptiveEnvelope.hh"
+#include "EulerAngleRotation.hh"
+#include "QuasiRandomSequence.hh"
+#include "RandomEngine.hh"
+#include "ReferenceFrameSampler.hh"
+
+/**
+ * \brief Check whether a type has a member function evaluate_cos_theta() like
+ * W_gamma_gamma::evaluate_cos_theta() for arrays of the floating-point type
+ * Real.
+ */
+template <typename D, typename Real = double, typename = void>
+struct has_evaluate_cos_theta : false_type {};
+
+template <typename D, typename Real>
+struct has_evaluate_cos_theta<
+    D, Real,
+    void_t<decltype(declval<const D &>().evaluate_cos_theta(
+        size_t{}, declval<const Real *>(), declval<const Real *>(),
+        declval<Real *>()))>> : true_type {};
+
+/**
+ * \brief Check whether a type has the member functions
+ * get_legendre_coefficients() and get_associated_legendre_coefficients() like
+ * W_gamma_gamma.
+ */
+template <typename D, typename = void>
+struct has_legendre_coefficients : false_type {};
+
+template <typename D>
+struct has_legendre_coefficients<
+    D, void_t<decltype(declval<const D &>().get_legendre_coefficients()),
+              decltype(declval<const D &>()
+                           .get_associated_legendre_coefficients())>>
+    : true_type {};
+
+/**
+ * \brief Rejection sampling from a probability distribution in spherical
+ * coordinates, with the type of the distribution as a template parameter.
+ *
+ * The algorithm is described in the documentation of SphereRejectionSampler,
+ * which is this class with a type-erased distribution
+ * (std::function).
+ * If the concrete type of the distribution is known at compile time, for
+ * example W_dir_dir or W_pol_dir, storing the distribution as an object of
+ * this type avoids the indirect call through std::function and allows the
+ * compiler to resolve the call of its operator() statically, which is a
+ * prerequisite for inlining the accept/reject loop.
+ *
+ * Candidates are generated in blocks of
+ * TypedSphereRejectionSampler::candidate_block_size elements.
+ * All uniform random numbers of a block are drawn in a single loop,
+ * \f$\cos \left( \theta_\mathrm{rand} \right) = 2u - 1\f$ is sampled
+ * directly, and the distribution is evaluated for the whole block with
+ * evaluate_block().
+ * If the distribution has a member function evaluate_cos_theta() with the
+ * same signature as W_gamma_gamma::evaluate_cos_theta(), like W_dir_dir and
+ * W_pol_dir, this uses the batched Legendre-series kernels.
+ * The function \f$\arccos\f$ is only called for accepted candidates.
+ * sample() and the block mode operator()(const size_t, double*, double*,
+ * double*) take candidates from the same buffer, so both give the same
+ * sequence of reference frames.
+ *
+ * Optionally, the four coordinates of the candidates are taken from a
+ * scrambled Sobol sequence instead of the random number engine (see
+ * enable_quasi_random()).
+ * This is most useful for the weighted mode sample_weighted(), where every
+ * candidate is used: the mean value of a smooth function over the weighted
+ * reference frames then converges almost like \f$n^{-1}\f$ instead of
+ * \f$n^{-1/2}\f$.
+ * Since the Sobol points are stratified, consecutive reference frames are
+ * not independent, so the sequence should not be split into small,
+ * separately analyzed parts.
+ *
+ * For sharply peaked distributions, the constant envelope \f$W_\mathrm{max}\f$
+ * can be replaced by a piecewise-constant AdaptiveEnvelope (see
+ * enable_envelope()).
+ * The candidates are then proposed from the envelope instead of uniformly on
+ * the sphere surface, and estimate_efficiency() reports the higher
+ * efficiency.
+ *
+ * \tparam Distribution Type of the distribution. Objects of this type must be
+ * callable with a polar angle \f$\theta\f$ and an azimuthal angle \f$\varphi\f$
+ * in radians and return \f$W \left( \theta, \varphi \right)\f$.
+ * \tparam Engine Random number engine (default: std::mt19937).
+ * It must be constructible from an integer seed, have a member function
+ * seed(std::seed_seq&), and be usable with fill_uniform().
+ * The default reproduces the random numbers of previous versions of alpaca.
+ * Engines with a smaller state, like Xoshiro256PlusPlus, are faster to
+ * construct and seed.
+ * \tparam Real Floating-point type in which the distribution is evaluated
+ * (default: double).
+ * With float, the batched kernels process twice as many candidates per SIMD
+ * instruction, for example with W_dir_dir::evaluate_cos_theta(const size_t,
+ * const float *, const float *, float *) const.
+ * The random numbers and the returned angles are still calculated in double
+ * precision, only \f$W\f$ is rounded, with an error given by
+ * legendre_series::float_relative_error.
+ * Therefore, a candidate is only accepted or rejected differently than with
+ * double if \f$W_\mathrm{rand}\f$ is within this error of \f$W\f$.
+ */
+template <typename Distribution, typename Engine = mt19937,
+          typename Real = double>
+class TypedSphereRejectionSampler : public ReferenceFrameSampler {
+
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param dis \f$W \left( \theta, \varphi \right)\f$, probability
+   * distribution in spherical coordinates.
+   * \param dis_max \f$W_\mathrm{max}\f$, upper limit for the maximum of the
+   * probability distribution.
+   * \param seed Random number seed.
+   * \param max_tri Maximum number of sampled points \f$\left(
+   * \theta_\mathrm{rand}, \varphi_\mathrm{rand} \right)\f$ before the algorithm
+   * terminates without success and returns \f$\left( 0, 0 \right)\f$ (default:
+   * 1000).
+   */
+  TypedSphereRejectionSampler(Distribution dis, const double dis_max,
+                              const int seed, const unsigned int max_tri = 1000)
+      : distribution(dis), distribution_maximum(dis_max), max_tries(max_tri),
+        random_engine(seed) {}
+
+  /**
+   * \brief Sample a random vector from probability distribution and record the
+   * number of tries.
+   *
+   * \return std::pair which contains \f$N\f$, the number of tries that were
+   * needed to find a valid vector, and the accepted vector \f$\left(
+   * \theta_\mathrm{rand}, \varphi_\mathrm{rand}\right)\f$. Returns a std::pair
+   * of \f$N_\mathrm{max}\f$ and \f$\left(0, 0 \right)\f$, if the maximum number
+   * of trials \f$N_\mathrm{max}\f$ is reached by the algorithm and no random
+   * vector was accepted.
+   */
+  pair<unsigned int, array<double, 3>> sample() override {
+
+    for (unsigned int i = 0; i < max_tries; ++i) {
+
+      if (next_candidate == n_candidates) {
+        refill_candidates();
+      }
+      const size_t k = next_candidate++;
+
+      if (w_rand_block[k] <= w_block[k]) {
+        record(i + 1, true);
+        return {i + 1, euler_angle_transform::from_spherical(
+                           // 1) Random point on unit sphere surface
+                           {acos(cos_theta_block[k]), phi_block[k]},
+                           // 2) Random rotation by first Euler angle
+                           // corresponding to a lack of knowledge about the
+                           // orientation of the third coordinate-system axis.
+                           Phi_block[k])};
+      }
+    }
+
+    record(max_tries, false);
+    return {max_tries, {0., 0., 0.}};
+  }
+
+  using ReferenceFrameSampler::operator();
+
+  /**
+   * \brief Sample a block of random reference frames.
+   *
+   * Gives the same result as \f$n\f$ consecutive calls of sample(), but
+   * avoids the virtual function calls.
+   *
+   * \param n \f$n\f$, number of reference frames.
+   * \param Phi Array of length \f$n\f$ for the Euler angles \f$\Phi\f$.
+   * \param Theta Array of length \f$n\f$ for the Euler angles \f$\Theta\f$.
+   * \param Psi Array of length \f$n\f$ for the Euler angles \f$\Psi\f$.
+   */
+  void operator()(const size_t n, double *Phi, double *Theta,
+                  double *Psi) override {
+    for (size_t i = 0; i < n; ++i) {
+      const array<double, 3> Phi_Theta_Psi =
+          TypedSphereRejectionSampler::sample().second;
+      Phi[i] = Phi_Theta_Psi[0];
+      Theta[i] = Phi_Theta_Psi[1];
+      Psi[i] = Phi_Theta_Psi[2];
+    }
+  }
+
+  using ReferenceFrameSampler::sample_weighted;
+
+  /**
+   * \brief Return the next candidate with a weight instead of accepting or
+   * rejecting it.
+   *
+   * The proposed point is uniformly distributed on the sphere surface, and the
+   * weight is the ratio of the distribution and the constant envelope,
+   *
+   * \f[
+   *      w = \frac{W \left( \theta_\mathrm{rand}, \varphi_\mathrm{rand}
+   * \right)}{W_\mathrm{max}}. \f]
+   *
+   * If an AdaptiveEnvelope is enabled, the point is distributed like the
+   * envelope, and \f$W_\mathrm{max}\f$ is replaced by the value of the
+   * envelope at the point.
+   *
+   * No candidate is discarded, and the maximum number of tries is irrelevant.
+   * The mean value of the weights is the efficiency of the rejection sampling.
+   *
+   * \return std::pair which contains \f$w\f$ and the reference frame.
+   */
+  pair<double, array<double, 3>> sample_weighted() override {
+    if (next_candidate == n_candidates) {
+      refill_candidates();
+    }
+    const size_t k = next_candidate++;
+
+    return {weight(k),
+            euler_angle_transform::from_spherical(
+                {acos(cos_theta_block[k]), phi_block[k]}, Phi_block[k])};
+  }
+
+  /**
+   * \brief Sample a random reference frame as a rotation matrix.
+   *
+   * Takes the same candidates as sample(), but calculates the rotation matrix
+   * directly from \f$\cos \left( \theta_\mathrm{rand} \right)\f$ with
+   * euler_angle_transform::rotation_matrix_from_spherical(), i.e. without
+   * \f$\arccos\f$ and without converting Euler angles.
+   *
+   * \return std::pair which contains \f$N\f$ and the rotation matrix, or
+   * \f$N_\mathrm{max}\f$ and the identity matrix if no vector was accepted.
+   */
+  pair<unsigned int, euler_angle_transform::RotationMatrix>
+  sample_rotation_matrix() override {
+
+    for (unsigned int i = 0; i < max_tries; ++i) {
+
+      if (next_candidate == n_candidates) {
+        refill_candidates();
+      }
+      const size_t k = next_candidate++;
+
+      if (w_rand_block[k] <= w_block[k]) {
+        record(i + 1, true);
+        return {i + 1, euler_angle_transform::rotation_matrix_from_spherical(
+                           cos_theta_block[k], phi_block[k], Phi_block[k])};
+      }
+    }
+
+    record(max_tries, false);
+    return {max_tries, euler_angle_transform::rotation_matrix({0., 0., 0.})};
+  }
+
+  void sample_rotation_matrices(
+      const size_t n, euler_angle_transform::RotationMatrix *A) override {
+    for (size_t i = 0; i < n; ++i) {
+      A[i] = TypedSphereRejectionSampler::sample_rotation_matrix().second;
+    }
+  }
+
+  /**
+   * \brief Return the next candidate as a rotation matrix with a weight.
+   *
+   * Same as sample_weighted(), but for sample_rotation_matrix().
+   */
+  pair<double, euler_angle_transform::RotationMatrix>
+  sample_weighted_rotation_matrix() override {
+    if (next_candidate == n_candidates) {
+      refill_candidates();
+    }
+    const size_t k = next_candidate++;
+
+    return {weight(k),
+            euler_angle_transform::rotation_matrix_from_spherical(
+                cos_theta_block[k], phi_block[k], Phi_block[k])};
+  }
+
+  void sample_weighted_rotation_matrices(
+      const size_t n, euler_angle_transform::RotationMatrix *A,
+      double *weights) override {
+    for (size_t i = 0; i < n; ++i) {
+      const pair<double, euler_angle_transform::RotationMatrix> w_A =
+          TypedSphereRejectionSampler::sample_weighted_rotation_matrix();
+      A[i] = w_A.second;
+      weights[i] = w_A.first;
+    }
+  }
+
+  void reseed(seed_seq &seq) override {
+    random_engine.seed(seq);
+    if (quasi_random) {
+      quasi_random->seed(seq);
+    }
+    next_candidate = 0;
+    n_candidates = 0;
+  }
+
+  /**
+   * \brief Take the candidates from a four-dimensional ScrambledSobolSequence
+   * instead of the random number engine.
+   *
+   * Discards the remaining candidates of the current block.
+   * reseed() also reseeds the scrambling.
+   *
+   * \param seed Seed of the scrambling (default: 0).
+   */
+  void enable_quasi_random(const uint64_t seed = 0) {
+    quasi_random.emplace(4, seed);
+    next_candidate = 0;
+    n_candidates = 0;
+  }
+
+  /**
+   * \brief Take the candidates from the random number engine again.
+   */
+  void disable_quasi_random() {
+    quasi_random.reset();
+    next_candidate = 0;
+    n_candidates = 0;
+  }
+
+  /**
+   * \brief Whether the candidates are taken from a scrambled Sobol sequence.
+   */
+  bool quasi_random_enabled() const { return quasi_random.has_value(); }
+
+  /**
+   * \brief Propose the candidates from a piecewise-constant envelope instead
+   * of the constant envelope \f$W_\mathrm{max}\f$.
+   *
+   * The envelope must be an upper bound of the distribution, i.e. it must be
+   * constructed from the coefficients of the distribution.
+   * Discards the remaining candidates of the current block.
+   *
+   * \param env Envelope.
+   */
+  void enable_envelope(AdaptiveEnvelope env) {
+    envelope.emplace(move(env));
+    next_candidate = 0;
+    n_candidates = 0;
+  }
+
+  /**
+   * \brief Construct an AdaptiveEnvelope from the coefficients of the
+   * distribution and propose the candidates from it.
+   *
+   * Only available if the distribution has the member functions
+   * get_legendre_coefficients() and get_associated_legendre_coefficients(),
+   * like W_dir_dir and W_pol_dir.
+   *
+   * \param target_efficiency See AdaptiveEnvelope::AdaptiveEnvelope().
+   * \param max_strata See AdaptiveEnvelope::AdaptiveEnvelope().
+   */
+  void enable_adaptive_envelope(const double target_efficiency = 0.9,
+                                const size_t max_strata = 4096) {
+    static_assert(has_legendre_coefficients<Distribution>::value,
+                  "The distribution has no Legendre coefficients.");
+    enable_envelope(AdaptiveEnvelope(
+        distribution.get_legendre_coefficients(),
+        distribution.get_associated_legendre_coefficients(),
+        target_efficiency, max_strata));
+  }
+
+  /**
+   * \brief Use the constant envelope \f$W_\mathrm{max}\f$ again.
+   */
+  void disable_envelope() {
+    envelope.reset();
+    next_candidate = 0;
+    n_candidates = 0;
+  }
+
+  /**
+   * \brief Piecewise-constant envelope, if enabled.
+   */
+  const optional<AdaptiveEnvelope> &get_envelope() const { return envelope; }
+
+  /**
+   * \brief Number of candidates that are generated at once.
+   */
+  static constexpr size_t candidate_block_size = 2048;
+
+protected:
+  /**
+   * \brief Evaluate the distribution for a block of candidates.
+   *
+   * Uses the member function evaluate_cos_theta() of the distribution if it
+   * exists, and calls the distribution for each candidate otherwise.
+   *
+   * \param n Number of candidates.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param phi Azimuthal angles in radians, array of length n.
+   * \param result Array of length n for the values of the distribution.
+   */
+  virtual void evaluate_block(const size_t n, const Real *cos_theta,
+                              const Real *phi, Real *result) {
+    if constexpr (has_evaluate_cos_theta<Distribution, Real>::value) {
+      distribution.evaluate_cos_theta(n, cos_theta, phi, result);
+    } else {
+      for (size_t k = 0; k < n; ++k) {
+        result[k] = static_cast<Real>(
+            distribution(acos(static_cast<double>(cos_theta[k])),
+                         static_cast<double>(phi[k])));
+      }
+    }
+  }
+
+  /**
+   * \brief Weight of a candidate in the weighted mode, the ratio of the
+   * distribution and the envelope.
+   */
+  double weight(const size_t k) const {
+    return w_block[k] / (envelope ? envelope_block[k] : distribution_maximum);
+  }
+
+  /**
+   * \brief Generate a new block of candidates and evaluate the distribution
+   * for all of them.
+   *
+   * Each candidate consumes four uniform random numbers \f$u_i \in \left[ 0, 1
+   * \right)\f$ in a fixed order: \f$\cos \left( \theta_\mathrm{rand} \right) =
+   * 2 u_0 - 1\f$, \f$\varphi_\mathrm{rand} = 2 \pi u_1\f$, \f$W_\mathrm{rand}
+   * = u_2 W_\mathrm{max}\f$, and \f$\Phi_\mathrm{rand} = 2 \pi u_3\f$.
+   * Therefore, the sequence of candidates does not depend on the size of the
+   * blocks.
+   * For quasi-random candidates, \f$u_0\f$ to \f$u_3\f$ are the coordinates
+   * of a point of the Sobol sequence.
+   * If an envelope is enabled, \f$u_0\f$ and \f$u_1\f$ are passed to
+   * AdaptiveEnvelope::propose() instead, and \f$W_\mathrm{max}\f$ is
+   * replaced by the value of the envelope at the candidate.
+   * If Real is not double, the cosines and azimuthal angles are rounded to
+   * Real before the evaluation.
+   */
+  void refill_candidates() {
+    if (cos_theta_block.empty()) {
+      uniform_block.resize(4 * candidate_block_size);
+      cos_theta_block.resize(candidate_block_size);
+      phi_block.resize(candidate_block_size);
+      w_rand_block.resize(candidate_block_size);
+      Phi_block.resize(candidate_block_size);
+      w_block.resize(candidate_block_size);
+      envelope_block.resize(candidate_block_size);
+      if constexpr (!is_same_v<Real, double>) {
+        cos_theta_real_block.resize(candidate_block_size);
+        phi_real_block.resize(candidate_block_size);
+      }
+    }
+
+    if (quasi_random) {
+      quasi_random->generate(candidate_block_size, uniform_block.data());
+    } else {
+      fill_uniform(random_engine, uniform_block.data(), uniform_block.size());
+    }
+
+    if (envelope) {
+      for (size_t k = 0; k < candidate_block_size; ++k) {
+        envelope->propose(uniform_block[4 * k], uniform_block[4 * k + 1],
+                          cos_theta_block[k], phi_block[k], envelope_block[k]);
+        w_rand_block[k] = uniform_block[4 * k + 2] * envelope_block[k];
+        Phi_block[k] = 2. * M_PI * uniform_block[4 * k + 3];
+      }
+    } else {
+      for (size_t k = 0; k < candidate_block_size; ++k) {
+        cos_theta_block[k] = 2. * uniform_block[4 * k] - 1.;
+        phi_block[k] = 2. * M_PI * uniform_block[4 * k + 1];
+        w_rand_block[k] = uniform_block[4 * k + 2] * distribution_maximum;
+        Phi_block[k] = 2. * M_PI * uniform_block[4 * k + 3];
+      }
+    }
+
+    if constexpr (is_same_v<Real, double>) {
+      evaluate_block(candidate_block_size, cos_theta_block.data(),
+                     phi_block.data(), w_block.data());
+    } else {
+      for (size_t k = 0; k < candidate_block_size; ++k) {
+        cos_theta_real_block[k] = static_cast<Real>(cos_theta_block[k]);
+        phi_real_block[k] = static_cast<Real>(phi_block[k]);
+      }
+      evaluate_block(candidate_block_size, cos_theta_real_block.data(),
+                     phi_real_block.data(), w_block.data());
+    }
+
+    next_candidate = 0;
+    n_candidates = candidate_block_size;
+  }
+
+  Distribution distribution; /**< \f$W \left( \theta, \varphi \right)\f$,
+                                (unnormalized) probability distribution. */
+  const double distribution_maximum; /**< \f$W_\mathrm{max}\f$, maximum of
+                                        probability distribution. */
+  const unsigned int max_tries; /**< \f$N_\mathrm{max}\f$, maximum number of
+                                   tries to find a random vector. */
+
+  Engine random_engine; /**< Deterministic random number engine. */
+  optional<ScrambledSobolSequence>
+      quasi_random; /**< Quasi-random source of the candidates, if enabled. */
+  optional<AdaptiveEnvelope>
+      envelope; /**< Piecewise-constant envelope, if enabled. */
+
+  vector<double> uniform_block; /**< Uniform random numbers for a block of
+                                   candidates. */
+
+  vector<double> cos_theta_block; /**< Candidates for \f$\cos \left( \theta
+                                     \right)\f$ in the block mode. */
+  vector<double> phi_block;    /**< Candidates for \f$\varphi\f$. */
+  vector<double> w_rand_block; /**< Random values \f$W_\mathrm{rand}\f$. */
+  vector<double> Phi_block;    /**< Candidates for \f$\Phi\f$. */
+  vector<Real> w_block; /**< Values of the distribution for the candidates. */
+  vector<double> envelope_block; /**< Values of the envelope for the
+                                    candidates, only used if an envelope is
+                                    enabled. */
+  vector<Real> cos_theta_real_block; /**< cos_theta_block rounded to Real, only
+                                        used if Real is not double. */
+  vector<Real> phi_real_block; /**< phi_block rounded to Real, only used if
+                                  Real is not double. */
+  size_t next_candidate = 0; /**< Index of the next unused candidate. */
+  size_t n_candidates = 0;   /**< Number of candidates in the buffers. */
+};
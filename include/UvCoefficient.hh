@@ -241,10 +241,106 @@ public:
   UvCoefficient(const unsigned int two_nu, const int two_j, const int two_L,
                 const int two_Lp, const double delta, const int two_jp);
 
+  /**
+   * \brief Constructor for known values of the terms of a mixed transition.
+   *
+   * No Wigner symbol is calculated, see get_value_L() and
+   * get_coefficient_Lp().
+   *
+   * \param two_nu \f$2 \nu\f$
+   * \param two_j \f$2 j_m\f$
+   * \param two_L \f$2 L_{m+1}\f$
+   * \param two_Lp \f$2 L_{m+1}^\prime\f$
+   * \param delta \f$\delta_m\f$
+   * \param two_jp \f$2 j_{m+1}\f$
+   * \param value_L \f$U_\nu \left( j_m, L_{m+1}, j_{m+1} \right)\f$
+   * \param coefficient_Lp \f$U_\nu \left( j_m, L_{m+1}^\prime, j_{m+1}
+   * \right)\f$
+   */
+  UvCoefficient(const unsigned int two_nu, const int two_j, const int two_L,
+                const int two_Lp, const double delta, const int two_jp,
+                const double value_L, const double coefficient_Lp);
+
   double get_value() const { return value; };
 
-  string string_representation(const unsigned int n_digits = 0,
-                               vector<string> variable_names = {}) const;
+  /**
+   * \brief Return the unnormalized term of the primary multipolarity,
+   * \f$U_\nu \left( j_m, L_{m+1}, j_{m+1} \right)\f$.
+   */
+  double get_value_L() const { return value_L; };
+
+  /**
+   * \brief Return the unnormalized term of the secondary multipolarity
+   * without the factor \f$\delta^2\f$, \f$U_\nu \left( j_m, L_{m+1}^\prime,
+   * j_{m+1} \right)\f$.
+   */
+  double get_coefficient_Lp() const { return coefficient_Lp; };
+
+  /**
+   * \brief Change the multipole mixing ratio.
+   *
+   * Updates get_value() without recalculating any Wigner symbol.
+   *
+   * \param delta \f$\delta_m\f$
+   */
+  void set_delta(const double delta);
+
+  /**
+   * \brief Return the \f$U_\nu\f$ coefficient for an arbitrary multipole
+   * mixing ratio.
+   *
+   * The coefficient is a polynomial in \f$\delta\f$ whose constant and
+   * quadratic terms are independent of the mixing ratio given to the
+   * constructor. This function returns the unnormalized sum
+   *
+   * \f[
+   *      U_\nu \left( j_m, L_{m+1}, j_{m+1} \right) + \delta^2 U_\nu \left(
+   * j_m, L_{m+1}^\prime, j_{m+1} \right). \f]
+   *
+   * For an object created with the constructor for a pure transition, the
+   * quadratic term is zero.
+   *
+   * \param delta Multipole mixing ratio \f$\delta_m\f$
+   *
+   * \return \f$U_\nu\f$ for the given mixing ratio
+   */
+  double operator()(const double delta) const {
+    return value_L + delta * delta * coefficient_Lp;
+  };
+
+  /**
+   * \brief Return the derivative of operator()() with respect to the
+   * multipole mixing ratio.
+   *
+   * \param delta Multipole mixing ratio \f$\delta_m\f$
+   *
+   * \return \f$2 \delta U_\nu \left( j_m, L_{m+1}^\prime, j_{m+1}
+   * \right)\f$
+   */
+  double derivative(const double delta) const {
+    return 2. * delta * coefficient_Lp;
+  };
+
+  void write_string_representation(
+      string &str_rep, const unsigned int n_digits = 0,
+      const vector<string> &variable_names = {}) const override;
+
+  /**
+   * \brief Append string representation with a given name of the multipole
+   * mixing ratio.
+   *
+   * Equivalent to write_string_representation(string &, const unsigned int,
+   * const vector<string> &) const with a single variable name, without
+   * creating a vector.
+   *
+   * \param str_rep String to which the representation is appended.
+   * \param n_digits Number of digits, see
+   * StringRepresentable::string_representation().
+   * \param delta_variable Name of the multipole mixing ratio.
+   */
+  void write_string_representation(string &str_rep,
+                                   const unsigned int n_digits,
+                                   const string &delta_variable) const;
 
 protected:
   double phase_norm_6j_symbol(const int two_nu, const int two_j,
@@ -254,8 +350,9 @@ protected:
   const int two_j;
   const int two_L;
   const int two_Lp;
-  const double delta;
+  double delta;
   const int two_jp;
 
   double value, value_L, value_Lp;
+  double coefficient_Lp; /**< \f$\delta\f$-independent part of value_Lp */
 };
\ No newline at end of file
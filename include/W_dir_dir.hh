@@ -76,6 +76,25 @@ public:
   W_dir_dir(const State &ini_sta,
             const vector<pair<Transition, State>> cas_ste);
 
+  /**
+   * \brief Constructor that restores the coefficients of a dir-dir
+   * correlation instead of calculating them.
+   *
+   * The result is the same as for W_dir_dir(const State &, const
+   * vector<pair<Transition, State>>), but no Wigner symbol is calculated.
+   *
+   * \param ini_sta Oriented intial state.
+   * \param cas_ste Steps of the cascade.
+   * \param coefficient_values Output of get_coefficient_values() of a
+   * correlation with the same cascade.
+   *
+   * \throw invalid_argument if the number of values does not match the
+   * cascade.
+   */
+  W_dir_dir(const State &ini_sta,
+            const vector<pair<Transition, State>> cas_ste,
+            const vector<double> &coefficient_values);
+
   /**
    * \brief Return value of the dir-dir correlation at an angle \f$\theta\f$
    *
@@ -133,6 +152,130 @@ public:
     return operator()(theta);
   }
 
+  /**
+   * \brief Call operator of the dir-dir correlation for arbitrary multipole
+   * mixing ratios
+   *
+   * See also W_gamma_gamma::operator()(const double, const double, const
+   * vector<double> &) const.
+   *
+   * \param theta Polar angle in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$).
+   * \param deltas Multipole mixing ratios \f$\delta_i\f$, one for each
+   * cascade step.
+   *
+   * \return \f$W_{\gamma \gamma} \left( \theta, \delta_1, ..., \delta_{n-1}
+   * \right)\f$
+   *
+   * \throw invalid_argument if the number of mixing ratios is not equal to the
+   * number of cascade steps.
+   */
+  double operator()(const double theta, const vector<double> &deltas) const;
+
+  /**
+   * \brief Call operator of the dir-dir correlation for arbitrary multipole
+   * mixing ratios
+   *
+   * Since the dir-dir correlation is independent of the azimuthal angle, this
+   * function simply calls W_dir_dir::operator()(const double, const
+   * vector<double> &) const.
+   */
+  double operator()(const double theta, const double,
+                    const vector<double> &deltas) const override {
+    return operator()(theta, deltas);
+  }
+
+  /**
+   * \brief Evaluate the dir-dir correlation for many directions at once.
+   *
+   * The Legendre polynomials of all orders are obtained from their recurrence
+   * relation, and blocks of directions are processed together (see
+   * legendre_series). The azimuthal angles are ignored, therefore phi may also
+   * be a nullptr.
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$), array of length n.
+   * \param phi Azimuthal angles (ignored).
+   * \param result Array of length n for the values \f$W_{\gamma \gamma}
+   * \left( \theta_i \right)\f$.
+   */
+  void evaluate(const size_t n, const double *theta, const double *phi,
+                double *result) const override;
+
+  /**
+   * \brief Evaluate the dir-dir correlation for many directions at once,
+   * given the cosines of the polar angles.
+   *
+   * See evaluate() and W_gamma_gamma::evaluate_cos_theta().
+   */
+  void evaluate_cos_theta(const size_t n, const double *cos_theta,
+                          const double *phi, double *result) const override;
+
+  /**
+   * \brief Evaluate the dir-dir correlation for many directions at once in
+   * single precision.
+   *
+   * The coefficients are calculated in double precision by the constructor
+   * and rounded to float only once.
+   * For the accuracy, see legendre_series::float_relative_error.
+   *
+   * \param n Number of directions.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param phi Azimuthal angles (ignored).
+   * \param result Array of length n for the values \f$W_{\gamma \gamma}
+   * \left( \theta_i \right)\f$.
+   */
+  void evaluate_cos_theta(const size_t n, const float *cos_theta,
+                          const float *phi, float *result) const;
+
+  /**
+   * \brief Evaluate the dir-dir correlation for many directions at once,
+   * given the cosines of the polar angles.
+   *
+   * See W_gamma_gamma::evaluate_cos_theta_cos_2phi().
+   * The cosines of the azimuthal angles are ignored, therefore cos_2phi may
+   * also be a nullptr.
+   */
+  void evaluate_cos_theta_cos_2phi(const size_t n, const double *cos_theta,
+                                   const double *cos_2phi,
+                                   double *result) const override {
+    evaluate_cos_theta(n, cos_theta, cos_2phi, result);
+  }
+
+  /**
+   * \brief Evaluate the dir-dir correlation for arbitrary mixing ratios and
+   * many directions at once.
+   *
+   * See W_gamma_gamma::evaluate_cos_theta(const size_t, const double *, const
+   * double *, const vector<double> &, double *) const.
+   */
+  void evaluate_cos_theta(const size_t n, const double *cos_theta,
+                          const double *phi, const vector<double> &deltas,
+                          double *result) const override;
+
+  /**
+   * \brief Evaluate the dir-dir correlation with attenuated expansion
+   * coefficients for many directions at once.
+   *
+   * See W_gamma_gamma::evaluate_attenuated_cos_theta().
+   */
+  void evaluate_attenuated_cos_theta(const size_t n, const double *cos_theta,
+                                     const double *phi,
+                                     const double *attenuation,
+                                     double *result) const override;
+
+  /**
+   * \brief Evaluate the dir-dir correlation and its gradient for arbitrary
+   * multipole mixing ratios and many directions at once.
+   *
+   * See W_gamma_gamma::evaluate_with_gradient().
+   * The derivative with respect to \f$\varphi\f$ is zero.
+   */
+  void evaluate_with_gradient(const size_t n, const double *theta,
+                              const double *phi, const vector<double> &deltas,
+                              double *result, double *gradient) const override;
+
   /**
    * \brief Return upper limit for the dir-dir correlation.
    *
@@ -194,6 +337,34 @@ public:
    */
   double get_upper_limit() const override;
 
+  /**
+   * \brief Global maximum of the absolute value of the angular correlation.
+   *
+   * See legendre_series::maximum().
+   *
+   * \return \f$\mathrm{max}_{\theta \in \left[ 0, \pi \right]} | W \left(
+   * \theta \right) | \f$
+   */
+  double get_maximum() const override;
+
+  /**
+   * \brief Return the normalized coefficients of the series of Legendre
+   * polynomials.
+   *
+   * See W_gamma_gamma::get_legendre_coefficients().
+   */
+  vector<double> get_legendre_coefficients() const override;
+
+  /**
+   * \brief Return the normalized coefficients of the series of associated
+   * Legendre polynomials.
+   *
+   * See W_gamma_gamma::get_associated_legendre_coefficients().
+   * Since the dir-dir correlation does not depend on \f$\varphi\f$, this
+   * is an empty vector.
+   */
+  vector<double> get_associated_legendre_coefficients() const override;
+
   /**
    * \brief Return \f$\nu_\mathrm{max}\f$
    */
@@ -223,7 +394,7 @@ public:
    * index) and the cascade step number (second index, runs from \f$2\f$ to
    * \f$n-1\f$).
    */
-  vector<vector<UvCoefficient>> get_Uv_coefficients() const {
+  const vector<vector<UvCoefficient>> &get_Uv_coefficients() const {
     return uv_coefficients;
   };
 
@@ -244,13 +415,156 @@ public:
    * \return List of products of \f$U_\nu\f$ coefficients for all values of
    * \f$\nu\f$.
    */
-  vector<double> get_Uv_coefficient_products() const {
+  const vector<double> &get_Uv_coefficient_products() const {
     return uv_coefficient_products;
   };
 
-  string string_representation(
-      const unsigned int n_digits = 0,
-      const vector<string> variable_names = {}) const override;
+  /**
+   * \brief Return \f$A_\nu\f$ coefficients of the first transition.
+   *
+   * Together with W_dir_dir::get_Av_coefficients_decay() and
+   * W_dir_dir::get_Uv_coefficients(), this function gives access to the
+   * representation of the expansion coefficients as products of polynomials in
+   * the multipole mixing ratios.
+   *
+   * \return \f$A_\nu\f$ coefficients, sorted by \f$\nu\f$.
+   */
+  const vector<AvCoefficient> &get_Av_coefficients_excitation() const {
+    return av_coefficients_excitation;
+  };
+
+  /**
+   * \brief Return \f$A_\nu\f$ coefficients of the last transition.
+   *
+   * \return \f$A_\nu\f$ coefficients, sorted by \f$\nu\f$.
+   */
+  const vector<AvCoefficient> &get_Av_coefficients_decay() const {
+    return av_coefficients_decay;
+  };
+
+  /**
+   * \brief Return the values of all F and \f$U_\nu\f$ coefficients.
+   *
+   * For each \f$\nu\f$, the values of AvCoefficient::get_f_values() of the
+   * first and the last transition, followed by
+   * UvCoefficient::get_value_L() and UvCoefficient::get_coefficient_Lp() of
+   * all intermediate transitions for each \f$\nu\f$.
+   * These are the values which are required by W_dir_dir(const State &,
+   * const vector<pair<Transition, State>>, const vector<double> &) to
+   * restore the correlation.
+   */
+  vector<double> get_coefficient_values() const;
+
+  /**
+   * \brief Change the multipole mixing ratio of a single cascade step.
+   *
+   * For the first and the last step, only the expansion coefficients are
+   * recalculated from the \f$A_\nu\f$ coefficients. For an intermediate
+   * step, the \f$U_\nu\f$ coefficients of this step and their products are
+   * updated as well. See also W_gamma_gamma::set_delta().
+   *
+   * \param step Index of the cascade step, starting at 0.
+   * \param delta New multipole mixing ratio \f$\delta\f$.
+   *
+   * \throw out_of_range if step is not smaller than the number of cascade
+   * steps.
+   */
+  void set_delta(const size_t step, const double delta) override;
+
+  /**
+   * \brief Return expansion coefficients for the current values of the
+   * multipole mixing ratios, see also set_delta().
+   *
+   * \return Unnormalized coefficients of the Legendre polynomials
+   * \f$P_\nu\f$, sorted by \f$\nu\f$.
+   */
+  const vector<double> &get_expansion_coefficients() const {
+    return expansion_coefficients;
+  };
+
+  /**
+   * \brief Evaluate the expansion coefficients for arbitrary multipole mixing
+   * ratios.
+   *
+   * The expansion coefficients are products of polynomials in the mixing
+   * ratios, whose coefficients are stored in the \f$A_\nu\f$ and \f$U_\nu\f$
+   * coefficient objects. This function evaluates the polynomials without
+   * recalculating any Wigner symbol. Only the first call with a nonzero
+   * mixing ratio of a transition that was pure on construction calculates
+   * the terms with \f$L^\prime\f$ (see AvCoefficient).
+   *
+   * \param deltas Multipole mixing ratios \f$\delta_i\f$, one for each
+   * cascade step.
+   *
+   * \return Unnormalized coefficients of the Legendre polynomials
+   * \f$P_\nu\f$, sorted by \f$\nu\f$.
+   */
+  vector<double>
+  calculate_expansion_coefficients(const vector<double> &deltas) const;
+
+  /**
+   * \brief Evaluate the products of \f$U_\nu\f$ coefficients for arbitrary
+   * multipole mixing ratios.
+   *
+   * See also W_dir_dir::get_Uv_coefficient_products().
+   *
+   * \param deltas Multipole mixing ratios \f$\delta_i\f$, one for each
+   * cascade step. The first and the last one are ignored.
+   *
+   * \return List of products of \f$U_\nu\f$ coefficients for all values of
+   * \f$\nu\f$.
+   */
+  vector<double>
+  calculate_Uv_coefficient_products(const vector<double> &deltas) const;
+
+  /**
+   * \brief Derivatives of the expansion coefficients with respect to the
+   * multipole mixing ratios.
+   *
+   * \param deltas Multipole mixing ratios \f$\delta_j\f$, one for each
+   * cascade step.
+   *
+   * \return Derivatives of the coefficients of
+   * calculate_expansion_coefficients(const vector<double> &) const. The
+   * element \f$\left[ j \right] \left[ i \right]\f$ is the derivative of
+   * the coefficient \f$i\f$ with respect to \f$\delta_j\f$.
+   */
+  vector<vector<double>> calculate_expansion_coefficient_derivatives(
+      const vector<double> &deltas) const;
+
+  /**
+   * \brief Derivatives of the products of \f$U_\nu\f$ coefficients with
+   * respect to the multipole mixing ratios.
+   *
+   * \param deltas Multipole mixing ratios \f$\delta_j\f$, one for each
+   * cascade step.
+   *
+   * \return Derivatives of the products of
+   * calculate_Uv_coefficient_products(). The element \f$\left[ j \right]
+   * \left[ i \right]\f$ is the derivative of the product for the index
+   * \f$i\f$ with respect to \f$\delta_j\f$. The rows for the first and
+   * the last cascade step are zero.
+   */
+  vector<vector<double>>
+  calculate_Uv_coefficient_product_derivatives(
+      const vector<double> &deltas) const;
+
+  /**
+   * \brief Evaluate the normalization factor for arbitrary multipole mixing
+   * ratios.
+   *
+   * See also W_gamma_gamma::calculate_normalization_factor().
+   *
+   * \param deltas Multipole mixing ratios \f$\delta_i\f$, one for each
+   * cascade step.
+   *
+   * \return Normalization factor.
+   */
+  static double calculate_normalization_factor(const vector<double> &deltas);
+
+  void write_string_representation(
+      string &str_rep, const unsigned int n_digits = 0,
+      const vector<string> &variable_names = {}) const override;
 
 protected:
   /**
@@ -375,6 +689,15 @@ protected:
    */
   double calculate_normalization_factor() const;
 
+  /**
+   * \brief Recalculate expansion_coefficients and
+   * legendre_coefficients_float from the existing coefficient objects.
+   *
+   * Used by set_delta(). The products are evaluated in the same order as
+   * in calculate_expansion_coefficients().
+   */
+  void update_expansion_coefficients();
+
   vector<AvCoefficient>
       av_coefficients_excitation; /**< Vector of AvCoefficient objects for the
                                      excitation */
@@ -386,4 +709,7 @@ protected:
                                              coefficients */
   vector<double>
       expansion_coefficients; /**< Vector to store expansion coefficients */
+  vector<float>
+      legendre_coefficients_float; /**< Normalized expansion coefficients in
+                                      single precision */
 };
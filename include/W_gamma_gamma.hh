@@ -19,6 +19,17 @@
 
 #pragma once
 
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+
+#include <string>
+
+using std::to_string;
+
 #include <vector>
 
 using std::vector;
@@ -84,6 +95,212 @@ public:
    */
   virtual double operator()(const double theta, const double phi) const = 0;
 
+  /**
+   * \brief Call operator of the gamma-gamma angular correlation for arbitrary
+   * multipole mixing ratios
+   *
+   * The expansion coefficients of an angular correlation are products of
+   * polynomials in the multipole mixing ratios of the individual transitions.
+   * Only the coefficients of these polynomials are calculated when an object is
+   * constructed, therefore the angular correlation can be evaluated for any
+   * set of mixing ratios without constructing a new object.
+   * The mixing ratios of the cascade steps which were given to the constructor
+   * are ignored by this function.
+   *
+   * \param theta Polar angle in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$).
+   * \param phi Azimuthal angle in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$).
+   * \param deltas Multipole mixing ratios \f$\delta_i\f$, one for each
+   * cascade step.
+   *
+   * \return \f$W_{\gamma \gamma} \left( \theta, \varphi, \delta_1, ...,
+   * \delta_{n-1} \right)\f$
+   *
+   * \throw invalid_argument if the number of mixing ratios is not equal to the
+   * number of cascade steps.
+   */
+  virtual double operator()(const double theta, const double phi,
+                            const vector<double> &deltas) const = 0;
+
+  /**
+   * \brief Evaluate the gamma-gamma angular correlation for many directions at
+   * once.
+   *
+   * Equivalent to calling W_gamma_gamma::operator()(const double, const
+   * double) const for each pair of angles, but derived classes may override
+   * this function with a more efficient implementation. The default
+   * implementation simply loops over the call operator.
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$), array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$), array of length n.
+   * \param result Array of length n for the values \f$W_{\gamma \gamma}
+   * \left( \theta_i, \varphi_i \right)\f$.
+   */
+  virtual void evaluate(const size_t n, const double *theta, const double *phi,
+                        double *result) const {
+    for (size_t i = 0; i < n; ++i) {
+      result[i] = operator()(theta[i], phi[i]);
+    }
+  }
+
+  /**
+   * \brief Evaluate the gamma-gamma angular correlation for many directions at
+   * once, given the cosines of the polar angles.
+   *
+   * Same as evaluate(), but the polar angles are given as \f$\cos \left(
+   * \theta \right)\f$, which is the argument of the (associated) Legendre
+   * polynomials.
+   * This is useful if the directions are sampled uniformly on a sphere, where
+   * \f$\cos \left( \theta \right)\f$ is obtained directly from a uniform
+   * random number.
+   * The default implementation calls the call operator with \f$\theta =
+   * \arccos \left[ \cos \left( \theta \right) \right]\f$.
+   *
+   * \param n Number of directions.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$), array of length n.
+   * \param result Array of length n for the values \f$W_{\gamma \gamma}
+   * \left( \theta_i, \varphi_i \right)\f$.
+   */
+  virtual void evaluate_cos_theta(const size_t n, const double *cos_theta,
+                                  const double *phi, double *result) const {
+    for (size_t i = 0; i < n; ++i) {
+      result[i] = operator()(acos(cos_theta[i]), phi[i]);
+    }
+  }
+
+  /**
+   * \brief Evaluate the gamma-gamma angular correlation for many directions at
+   * once, given the cosines of the polar angles and of twice the azimuthal
+   * angles.
+   *
+   * Since \f$W\f$ depends on \f$\varphi\f$ only via \f$\cos \left( 2
+   * \varphi \right)\f$, it is sufficient to know this quantity instead of
+   * \f$\varphi\f$ itself.
+   * For a unit vector \f$\left( x, y, z \right)\f$, both \f$\cos \left(
+   * \theta \right) = z\f$ and
+   *
+   * \f[
+   *      \cos \left( 2 \varphi \right) = \frac{x^2 - y^2}{x^2 + y^2}
+   * \f]
+   *
+   * are rational functions of the Cartesian coordinates (see
+   * AngularCorrelation::evaluate(const size_t, const double *, double *)
+   * const).
+   * The default implementation calls the call operator with \f$\theta =
+   * \arccos \left[ \cos \left( \theta \right) \right]\f$ and \f$\varphi =
+   * \arccos \left[ \cos \left( 2 \varphi \right) \right] / 2\f$.
+   *
+   * \param n Number of directions.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param cos_2phi Cosines of twice the azimuthal angles, array of length n.
+   * \param result Array of length n for the values \f$W_{\gamma \gamma}
+   * \left( \theta_i, \varphi_i \right)\f$.
+   */
+  virtual void evaluate_cos_theta_cos_2phi(const size_t n,
+                                           const double *cos_theta,
+                                           const double *cos_2phi,
+                                           double *result) const {
+    for (size_t i = 0; i < n; ++i) {
+      result[i] = operator()(acos(cos_theta[i]),
+                             0.5 * acos(fmax(-1., fmin(1., cos_2phi[i]))));
+    }
+  }
+
+  /**
+   * \brief Evaluate the gamma-gamma angular correlation for arbitrary mixing
+   * ratios and many directions at once.
+   *
+   * Same as evaluate_cos_theta(), but with the multipole mixing ratios given
+   * as an argument, like in operator()(const double, const double, const
+   * vector<double>&) const.
+   * The default implementation calls that operator for each direction.
+   * Derived classes should evaluate the polynomials in the mixing ratios only
+   * once per call.
+   *
+   * \param n Number of directions.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$), array of length n.
+   * \param deltas Multipole mixing ratios, one for each cascade step.
+   * \param result Array of length n for the values \f$W_{\gamma \gamma}
+   * \left( \theta_i, \varphi_i \right)\f$.
+   *
+   * \throw invalid_argument if the number of mixing ratios does not match the
+   * number of cascade steps.
+   */
+  virtual void evaluate_cos_theta(const size_t n, const double *cos_theta,
+                                  const double *phi,
+                                  const vector<double> &deltas,
+                                  double *result) const {
+    check_deltas(deltas);
+    for (size_t i = 0; i < n; ++i) {
+      result[i] = operator()(acos(cos_theta[i]), phi[i], deltas);
+    }
+  }
+
+  /**
+   * \brief Evaluate the gamma-gamma angular correlation with attenuated
+   * expansion coefficients for many directions at once.
+   *
+   * Same as evaluate_cos_theta(), but the term of order \f$2i\f$ in the
+   * expansion of \f$W\f$ in (associated) Legendre polynomials is multiplied by
+   * the factor \f$a_{2i}\f$ (\f$0 \leq i \leq \nu_\mathrm{max} / 2\f$).
+   * With the integrals \f$J_{2i}\f$ of legendre_series::cone_integrals(), for
+   * example, this gives the integral of \f$W\f$ over cones around the given
+   * directions (see AngularCorrelation::integrate_cone()).
+   *
+   * \param n Number of directions.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$), array of length n.
+   * \param attenuation Factors \f$a_{2i}\f$, array of length
+   * \f$\nu_\mathrm{max} / 2 + 1\f$.
+   * \param result Array of length n for the results.
+   */
+  virtual void evaluate_attenuated_cos_theta(const size_t n,
+                                             const double *cos_theta,
+                                             const double *phi,
+                                             const double *attenuation,
+                                             double *result) const = 0;
+
+  /**
+   * \brief Evaluate the gamma-gamma angular correlation and its gradient for
+   * arbitrary multipole mixing ratios and many directions at once.
+   *
+   * The expansion coefficients are explicit polynomials in the mixing ratios,
+   * and the angular dependence is given by (associated) Legendre polynomials,
+   * so all derivatives are calculated exactly, without finite differences.
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in spherical coordinates in radians, array of
+   * length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians, array of
+   * length n.
+   * \param deltas Multipole mixing ratios \f$\delta_j\f$, one for each
+   * cascade step.
+   * \param result Array of length n for the values \f$W \left( \theta_k,
+   * \varphi_k \right)\f$.
+   * \param gradient Array of length n times (number of cascade steps + 2).
+   * The row for the direction \f$k\f$ starts at the index \f$k\f$ times
+   * the row length and contains \f$\partial W / \partial \theta\f$,
+   * \f$\partial W / \partial \varphi\f$, and \f$\partial W / \partial
+   * \delta_j\f$ for all cascade steps.
+   *
+   * \throw invalid_argument if the number of mixing ratios does not match the
+   * number of cascade steps.
+   */
+  virtual void evaluate_with_gradient(const size_t n, const double *theta,
+                                      const double *phi,
+                                      const vector<double> &deltas,
+                                      double *result,
+                                      double *gradient) const = 0;
+
   /**
    * \brief Return an upper limit for possible values of the gamma-gamma angular
    * correlation.
@@ -110,6 +327,20 @@ public:
    */
   virtual double get_upper_limit() const = 0;
 
+  /**
+   * \brief Global maximum of the absolute value of the angular correlation.
+   *
+   * In contrast to get_upper_limit(), which returns a quickly calculable
+   * estimate that may be significantly larger than the true maximum, this
+   * function determines the maximum exactly (up to rounding errors).
+   * This requires finding the roots of a polynomial, so the result should be
+   * calculated once and stored if it is needed many times.
+   *
+   * \return \f$\mathrm{max}_{\theta \in \left[ 0, \pi \right], \varphi \in
+   * \left[ 0, 2\pi \right]} | W \left( \theta, \varphi \right) | \f$
+   */
+  virtual double get_maximum() const = 0;
+
   /**
    * \brief Return the initial state of the angular correlation.
    *
@@ -126,6 +357,66 @@ public:
     return cascade_steps;
   }
 
+  /**
+   * \brief Change the multipole mixing ratio of a single cascade step.
+   *
+   * Only the factors of the expansion coefficients that depend on the mixing
+   * ratio of the given step are updated. No Wigner symbol is recalculated.
+   * Afterwards, all members of the object, including get_cascade_steps(),
+   * are the same as for an object which was constructed with the new value.
+   *
+   * \param step Index of the cascade step, starting at 0.
+   * \param delta New multipole mixing ratio \f$\delta\f$.
+   *
+   * \throw out_of_range if step is not smaller than the number of cascade
+   * steps.
+   */
+  virtual void set_delta(const size_t step, const double delta) = 0;
+
+  /**
+   * \brief Return the maximum order \f$\nu_\mathrm{max}\f$ of the Legendre
+   * expansion.
+   *
+   * \f$W\f$ is a polynomial of degree \f$\nu_\mathrm{max}\f$ in the
+   * Cartesian coordinates of a point on the unit sphere.
+   *
+   * \return \f$\nu_\mathrm{max}\f$
+   */
+  int get_nu_max() const { return nu_max; }
+
+  /**
+   * \brief Return the normalized coefficients of the series of Legendre
+   * polynomials.
+   *
+   * Any angular correlation in this library can be written as
+   *
+   * \f[
+   *      W \left( \theta, \varphi \right) = \sum_{i=0}^{\nu_\mathrm{max}/2}
+   * c_i P_{2i} \left[ \cos \left( \theta \right) \right] + \cos \left(
+   * 2 \varphi \right) \sum_{i=0}^{\nu_\mathrm{max}/2 - 1} d_i
+   * P_{2i+2}^{\left| 2 \right|} \left[ \cos \left( \theta \right)
+   * \right], \f]
+   *
+   * where the coefficients include the normalization factor and, for the
+   * pol-dir correlation, the sign of the polarization-dependent part.
+   * The two series can be evaluated with legendre_series::legendre() and
+   * legendre_series::associated_legendre_2().
+   *
+   * \return \f$c_i\f$, vector of length \f$\nu_\mathrm{max}/2 + 1\f$.
+   */
+  virtual vector<double> get_legendre_coefficients() const = 0;
+
+  /**
+   * \brief Return the normalized coefficients of the series of associated
+   * Legendre polynomials.
+   *
+   * See get_legendre_coefficients().
+   *
+   * \return \f$d_i\f$, vector of length \f$\nu_\mathrm{max}/2\f$, or an
+   * empty vector if the angular correlation does not depend on \f$\varphi\f$.
+   */
+  virtual vector<double> get_associated_legendre_coefficients() const = 0;
+
   /**
    * @brief Calculate the normalization factor for the angular correlation.
    *
@@ -249,21 +540,56 @@ public:
   // virtual double calculate_normalization_factor() const = 0;
 
   /**
-   * @brief Return string representation of gamma-gamma angular correlation.
+   * @brief Append string representation of gamma-gamma angular correlation.
    *
+   * \param str_rep String to which the representation is appended.
    * \param n_digits Determines whether the expression
    * should be evaluated numerically, (n_digits > 0). If yes, indicates how many
    * digits should be displayed (default: 0).
    * \param variable_names Names for the variables of a function (default: {}
    * i.e. use default names).
-   *
-   * \return String representation.
    */
-  virtual string string_representation(
-      const unsigned int n_digits = 0,
-      const vector<string> variable_names = {}) const override = 0;
+  virtual void write_string_representation(
+      string &str_rep, const unsigned int n_digits = 0,
+      const vector<string> &variable_names = {}) const override = 0;
 
 protected:
+  /**
+   * \brief Check whether a set of multipole mixing ratios matches the cascade.
+   *
+   * \param deltas Multipole mixing ratios \f$\delta_i\f$.
+   *
+   * \throw invalid_argument if the number of mixing ratios is not equal to the
+   * number of cascade steps.
+   */
+  void check_deltas(const vector<double> &deltas) const {
+    if (deltas.size() != n_cascade_steps) {
+      throw invalid_argument("Number of multipole mixing ratios (" +
+                             to_string(deltas.size()) +
+                             ") does not match the number of cascade steps (" +
+                             to_string(n_cascade_steps) + ").");
+    }
+  }
+
+  /**
+   * \brief Set the multipole mixing ratio of a cascade step after checking
+   * the index.
+   *
+   * \param step Index of the cascade step.
+   * \param delta Multipole mixing ratio.
+   *
+   * \throw out_of_range if step is not smaller than the number of cascade
+   * steps.
+   */
+  void set_cascade_step_delta(const size_t step, const double delta) {
+    if (step >= n_cascade_steps) {
+      throw out_of_range("Cascade step " + to_string(step) +
+                         " does not exist, the cascade has " +
+                         to_string(n_cascade_steps) + " steps.");
+    }
+    cascade_steps[step].first.delta = delta;
+  }
+
   State initial_state; /**< Initial state */
                        /**
                         * Steps of the gamma-ray cascade following an excitation.
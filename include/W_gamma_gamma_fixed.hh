@@ -0,0 +1,312 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <array>
+
+using std::array;
+
+#include <cmath>
+
+using std::cos;
+
+#include <cstddef>
+
+using std::size_t;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <variant>
+
+using std::monostate;
+using std::variant;
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * \brief Dir-dir correlation with a maximum order \f$\nu_\mathrm{max}\f$ of
+ * the expansion which is fixed at compile time.
+ *
+ * Most cascades of interest, like \f$0 \to 1 \to 0\f$ or
+ * \f$0 \to 2 \to 0\f$, have a small maximum order \f$\nu_\mathrm{max} \leq
+ * 4\f$.
+ * For them, the general implementation in W_dir_dir, with its coefficients in
+ * a vector, a loop over the orders whose length is only known at runtime, and
+ * a call of a virtual function per evaluation, has a large overhead compared
+ * to the actual arithmetic.
+ * This class stores only the normalized coefficients \f$c_i\f$ of the series
+ * of Legendre polynomials (see W_gamma_gamma::get_legendre_coefficients())
+ * in an array.
+ * Since the number of terms is a constant, the compiler can unroll the
+ * recurrence relation of the Legendre polynomials completely.
+ *
+ * AngularCorrelation uses this class automatically if
+ * \f$\nu_\mathrm{max} \leq\f$ fixed_order_nu_max_limit.
+ *
+ * \tparam nu_max Maximum order \f$\nu_\mathrm{max}\f$, an even number.
+ */
+template <int nu_max> class W_dir_dir_fixed {
+  static_assert(nu_max >= 0 && nu_max % 2 == 0,
+                "nu_max must be a non-negative even number.");
+
+public:
+  /**
+   * \brief Number of coefficients \f$c_i\f$.
+   */
+  static constexpr size_t n_legendre = nu_max / 2 + 1;
+
+  /**
+   * \brief Constructor
+   *
+   * \param legendre_coefficients Normalized coefficients \f$c_i\f$, vector of
+   * length \f$\nu_\mathrm{max}/2 + 1\f$.
+   *
+   * \throw invalid_argument if the number of coefficients does not match
+   * nu_max.
+   */
+  explicit W_dir_dir_fixed(const vector<double> &legendre_coefficients) {
+    if (legendre_coefficients.size() != n_legendre) {
+      throw invalid_argument("Number of Legendre coefficients does not match "
+                             "the maximum order of the expansion.");
+    }
+    for (size_t i = 0; i < n_legendre; ++i) {
+      coefficients[i] = legendre_coefficients[i];
+    }
+  }
+
+  /**
+   * \brief Evaluate the angular correlation.
+   *
+   * \param cos_theta \f$\cos \left( \theta \right)\f$
+   *
+   * \return \f$W \left( \theta \right)\f$
+   */
+  double evaluate_cos_theta(const double cos_theta) const {
+    const double x = cos_theta;
+    double sum = coefficients[0];
+    double p_lm2 = 1., p_lm1 = x;
+    for (int l = 2; l <= nu_max; ++l) {
+      const double p_l = ((2 * l - 1) * x * p_lm1 - (l - 1) * p_lm2) / l;
+      if (l % 2 == 0) {
+        sum += coefficients[l / 2] * p_l;
+      }
+      p_lm2 = p_lm1;
+      p_lm1 = p_l;
+    }
+    return sum;
+  }
+
+  /**
+   * \brief Evaluate the angular correlation.
+   *
+   * Same signature as W_pol_dir_fixed::evaluate_cos_theta_cos_2phi().
+   *
+   * \param cos_theta \f$\cos \left( \theta \right)\f$
+   *
+   * \return \f$W \left( \theta \right)\f$
+   */
+  double evaluate_cos_theta_cos_2phi(const double cos_theta,
+                                     const double) const {
+    return evaluate_cos_theta(cos_theta);
+  }
+
+  /**
+   * \brief Evaluate the angular correlation.
+   *
+   * \param theta Polar angle \f$\theta\f$ in radians.
+   *
+   * \return \f$W \left( \theta \right)\f$
+   */
+  double operator()(const double theta, const double) const {
+    return evaluate_cos_theta(cos(theta));
+  }
+
+protected:
+  array<double, n_legendre> coefficients;
+};
+
+/**
+ * \brief Pol-dir correlation with a maximum order \f$\nu_\mathrm{max}\f$ of
+ * the expansion which is fixed at compile time.
+ *
+ * In addition to the coefficients of W_dir_dir_fixed, stores the normalized
+ * coefficients \f$d_i\f$ of the series of associated Legendre polynomials
+ * (see W_gamma_gamma::get_associated_legendre_coefficients()), which contain
+ * the sign of the polarization-dependent part.
+ *
+ * \tparam nu_max Maximum order \f$\nu_\mathrm{max}\f$, an even number.
+ */
+template <int nu_max> class W_pol_dir_fixed : public W_dir_dir_fixed<nu_max> {
+public:
+  /**
+   * \brief Number of coefficients \f$d_i\f$.
+   */
+  static constexpr size_t n_associated = nu_max / 2;
+
+  /**
+   * \brief Constructor
+   *
+   * \param legendre_coefficients Normalized coefficients \f$c_i\f$, vector of
+   * length \f$\nu_\mathrm{max}/2 + 1\f$.
+   * \param associated_legendre_coefficients Normalized coefficients
+   * \f$d_i\f$, vector of length \f$\nu_\mathrm{max}/2\f$.
+   *
+   * \throw invalid_argument if the number of coefficients does not match
+   * nu_max.
+   */
+  W_pol_dir_fixed(const vector<double> &legendre_coefficients,
+                  const vector<double> &associated_legendre_coefficients)
+      : W_dir_dir_fixed<nu_max>(legendre_coefficients) {
+    if (associated_legendre_coefficients.size() != n_associated) {
+      throw invalid_argument(
+          "Number of associated Legendre coefficients does not match the "
+          "maximum order of the expansion.");
+    }
+    for (size_t i = 0; i < n_associated; ++i) {
+      associated_coefficients[i] = associated_legendre_coefficients[i];
+    }
+  }
+
+  /**
+   * \brief Evaluate the angular correlation.
+   *
+   * \param cos_theta \f$\cos \left( \theta \right)\f$
+   * \param phi Azimuthal angle \f$\varphi\f$ in radians.
+   *
+   * \return \f$W \left( \theta, \varphi \right)\f$
+   */
+  double evaluate_cos_theta(const double cos_theta, const double phi) const {
+    return evaluate_cos_theta_cos_2phi(cos_theta, cos(2. * phi));
+  }
+
+  /**
+   * \brief Evaluate the angular correlation.
+   *
+   * \param cos_theta \f$\cos \left( \theta \right)\f$
+   * \param cos_2phi \f$\cos \left( 2 \varphi \right)\f$
+   *
+   * \return \f$W \left( \theta, \varphi \right)\f$
+   */
+  double evaluate_cos_theta_cos_2phi(const double cos_theta,
+                                     const double cos_2phi) const {
+    const double x = cos_theta;
+    const double one_minus_x2 = 1. - x * x;
+    double sum = 0.;
+    if constexpr (nu_max >= 2) {
+      double p_lm2 = 3. * one_minus_x2, p_lm1 = 15. * x * one_minus_x2;
+      sum = associated_coefficients[0] * p_lm2;
+      for (int l = 4; l <= nu_max; ++l) {
+        const double p_l =
+            ((2 * l - 1) * x * p_lm1 - (l + 1) * p_lm2) / (l - 2);
+        if (l % 2 == 0) {
+          sum += associated_coefficients[l / 2 - 1] * p_l;
+        }
+        p_lm2 = p_lm1;
+        p_lm1 = p_l;
+      }
+    }
+    return W_dir_dir_fixed<nu_max>::evaluate_cos_theta(x) + cos_2phi * sum;
+  }
+
+  /**
+   * \brief Evaluate the angular correlation.
+   *
+   * \param theta Polar angle \f$\theta\f$ in radians.
+   * \param phi Azimuthal angle \f$\varphi\f$ in radians.
+   *
+   * \return \f$W \left( \theta, \varphi \right)\f$
+   */
+  double operator()(const double theta, const double phi) const {
+    return evaluate_cos_theta(cos(theta), phi);
+  }
+
+protected:
+  array<double, n_associated> associated_coefficients;
+};
+
+/**
+ * \brief Largest maximum order \f$\nu_\mathrm{max}\f$ for which
+ * AngularCorrelation uses W_dir_dir_fixed or W_pol_dir_fixed.
+ */
+constexpr int fixed_order_nu_max_limit = 8;
+
+/**
+ * \brief One of the fixed-order correlations, or std::monostate if the
+ * largest even order is larger than fixed_order_nu_max_limit.
+ */
+typedef variant<monostate, W_dir_dir_fixed<0>, W_dir_dir_fixed<2>,
+                W_dir_dir_fixed<4>, W_dir_dir_fixed<6>, W_dir_dir_fixed<8>,
+                W_pol_dir_fixed<2>, W_pol_dir_fixed<4>, W_pol_dir_fixed<6>,
+                W_pol_dir_fixed<8>>
+    W_gamma_gamma_fixed;
+
+/**
+ * \brief Create the fixed-order correlation for given coefficients.
+ *
+ * For cascades with half-integer spins, \f$\nu_\mathrm{max}\f$ can be odd.
+ * Since only even orders contribute, the correlation has the same
+ * coefficients as one with the maximum order \f$\nu_\mathrm{max} - 1\f$.
+ *
+ * \param nu_max Maximum order \f$\nu_\mathrm{max}\f$.
+ * \param legendre_coefficients Normalized coefficients \f$c_i\f$.
+ * \param associated_legendre_coefficients Normalized coefficients \f$d_i\f$,
+ * empty for a dir-dir correlation.
+ *
+ * \return W_dir_dir_fixed if associated_legendre_coefficients is empty,
+ * W_pol_dir_fixed otherwise, or std::monostate if there is no specialization
+ * for nu_max.
+ */
+inline W_gamma_gamma_fixed make_w_gamma_gamma_fixed(
+    const int nu_max, const vector<double> &legendre_coefficients,
+    const vector<double> &associated_legendre_coefficients) {
+  const vector<double> &c = legendre_coefficients;
+  const vector<double> &d = associated_legendre_coefficients;
+  const int nu_max_even = nu_max & ~1;
+  if (d.empty()) {
+    switch (nu_max_even) {
+    case 0:
+      return W_dir_dir_fixed<0>(c);
+    case 2:
+      return W_dir_dir_fixed<2>(c);
+    case 4:
+      return W_dir_dir_fixed<4>(c);
+    case 6:
+      return W_dir_dir_fixed<6>(c);
+    case 8:
+      return W_dir_dir_fixed<8>(c);
+    }
+  } else {
+    switch (nu_max_even) {
+    case 2:
+      return W_pol_dir_fixed<2>(c, d);
+    case 4:
+      return W_pol_dir_fixed<4>(c, d);
+    case 6:
+      return W_pol_dir_fixed<6>(c, d);
+    case 8:
+      return W_pol_dir_fixed<8>(c, d);
+    }
+  }
+  return monostate();
+}
@@ -19,6 +19,10 @@
 
 #pragma once
 
+#include <memory>
+
+using std::shared_ptr;
+
 #include <vector>
 
 using std::vector;
@@ -60,6 +64,45 @@ public:
   W_pol_dir(const State &ini_sta,
             const vector<pair<Transition, State>> cas_ste);
 
+  /**
+   * \brief Constructor that uses an existing dir-dir part.
+   *
+   * The result is the same as for W_pol_dir(const State &, const
+   * vector<pair<Transition, State>>), but the dir-dir part is not constructed
+   * here.
+   * This allows the caller to choose the memory of both objects, for example
+   * with std::allocate_shared().
+   *
+   * \param ini_sta Oriented intial state.
+   * \param cas_ste Steps of the cascade.
+   * \param w_dir Dir-dir correlation of the same cascade.
+   */
+  W_pol_dir(const State &ini_sta,
+            const vector<pair<Transition, State>> cas_ste,
+            shared_ptr<W_dir_dir> w_dir);
+
+  /**
+   * \brief Constructor that restores the coefficients of a pol-dir
+   * correlation instead of calculating them.
+   *
+   * The result is the same as for W_pol_dir(const State &, const
+   * vector<pair<Transition, State>>), but no Wigner symbol is calculated.
+   * The degree of polarization is 1.
+   *
+   * \param ini_sta Oriented intial state.
+   * \param cas_ste Steps of the cascade.
+   * \param dir_dir_coefficient_values Output of
+   * W_dir_dir::get_coefficient_values() of the dir-dir part.
+   * \param coefficient_values Output of get_coefficient_values().
+   *
+   * \throw invalid_argument if the number of values does not match the
+   * cascade.
+   */
+  W_pol_dir(const State &ini_sta,
+            const vector<pair<Transition, State>> cas_ste,
+            const vector<double> &dir_dir_coefficient_values,
+            const vector<double> &coefficient_values);
+
   /**
    * \brief Return value of the pol-dir correlation at angles \f$\theta\f$ and
    * \f$\varphi\f$
@@ -103,6 +146,115 @@ public:
    */
   double operator()(const double theta, const double phi) const override;
 
+  /**
+   * \brief Call operator of the pol-dir correlation for arbitrary multipole
+   * mixing ratios
+   *
+   * See also W_gamma_gamma::operator()(const double, const double, const
+   * vector<double> &) const.
+   *
+   * \param theta Polar angle in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$).
+   * \param phi Azimuthal angle in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$).
+   * \param deltas Multipole mixing ratios \f$\delta_i\f$, one for each
+   * cascade step.
+   *
+   * \return \f$W_{\gamma \gamma} \left( \theta, \varphi, \delta_1, ...,
+   * \delta_{n-1} \right)\f$
+   *
+   * \throw invalid_argument if the number of mixing ratios is not equal to the
+   * number of cascade steps.
+   */
+  double operator()(const double theta, const double phi,
+                    const vector<double> &deltas) const override;
+
+  /**
+   * \brief Evaluate the pol-dir correlation for many directions at once.
+   *
+   * The (associated) Legendre polynomials of all orders are obtained from
+   * their recurrence relations, and blocks of directions are processed together
+   * (see legendre_series).
+   *
+   * \param n Number of directions.
+   * \param theta Polar angles in spherical coordinates in radians
+   * (\f$\theta \in \left[ 0, \pi \right]\f$), array of length n.
+   * \param phi Azimuthal angles in spherical coordinates in radians
+   * (\f$\varphi \in \left[ 0, 2 \pi \right]\f$), array of length n.
+   * \param result Array of length n for the values \f$W_{\gamma \gamma}
+   * \left( \theta_i, \varphi_i \right)\f$.
+   */
+  void evaluate(const size_t n, const double *theta, const double *phi,
+                double *result) const override;
+
+  /**
+   * \brief Evaluate the pol-dir correlation for many directions at once,
+   * given the cosines of the polar angles.
+   *
+   * See evaluate() and W_gamma_gamma::evaluate_cos_theta().
+   */
+  void evaluate_cos_theta(const size_t n, const double *cos_theta,
+                          const double *phi, double *result) const override;
+
+  /**
+   * \brief Evaluate the pol-dir correlation for many directions at once,
+   * given the cosines of the polar angles and of twice the azimuthal angles.
+   *
+   * See W_gamma_gamma::evaluate_cos_theta_cos_2phi().
+   */
+  void evaluate_cos_theta_cos_2phi(const size_t n, const double *cos_theta,
+                                   const double *cos_2phi,
+                                   double *result) const override;
+
+  /**
+   * \brief Evaluate the pol-dir correlation for many directions at once in
+   * single precision.
+   *
+   * The coefficients are calculated in double precision by the constructor
+   * and rounded to float only once.
+   * For the accuracy, see legendre_series::float_relative_error.
+   *
+   * \param n Number of directions.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param phi Azimuthal angles in radians, array of length n.
+   * \param result Array of length n for the values \f$W_{\gamma \gamma}
+   * \left( \theta_i, \varphi_i \right)\f$.
+   */
+  void evaluate_cos_theta(const size_t n, const float *cos_theta,
+                          const float *phi, float *result) const;
+
+  /**
+   * \brief Evaluate the pol-dir correlation for arbitrary mixing ratios and
+   * many directions at once.
+   *
+   * See W_gamma_gamma::evaluate_cos_theta(const size_t, const double *, const
+   * double *, const vector<double> &, double *) const.
+   */
+  void evaluate_cos_theta(const size_t n, const double *cos_theta,
+                          const double *phi, const vector<double> &deltas,
+                          double *result) const override;
+
+  /**
+   * \brief Evaluate the pol-dir correlation with attenuated expansion
+   * coefficients for many directions at once.
+   *
+   * See W_gamma_gamma::evaluate_attenuated_cos_theta().
+   */
+  void evaluate_attenuated_cos_theta(const size_t n, const double *cos_theta,
+                                     const double *phi,
+                                     const double *attenuation,
+                                     double *result) const override;
+
+  /**
+   * \brief Evaluate the pol-dir correlation and its gradient for arbitrary
+   * multipole mixing ratios and many directions at once.
+   *
+   * See W_gamma_gamma::evaluate_with_gradient().
+   */
+  void evaluate_with_gradient(const size_t n, const double *theta,
+                              const double *phi, const vector<double> &deltas,
+                              double *result, double *gradient) const override;
+
   /**
    * \brief Return upper limit for the pol-dir correlation.
    *
@@ -168,11 +320,170 @@ public:
    */
   double get_upper_limit() const override;
 
-  string string_representation(
-      const unsigned int n_digits = 0,
-      const vector<string> variable_names = {}) const override;
+  /**
+   * \brief Global maximum of the absolute value of the angular correlation.
+   *
+   * Since the correlation has the structure
+   *
+   * \f[
+   *      W \left( \theta, \varphi \right) = a \left( \theta \right) \pm
+   * \cos \left( 2 \varphi \right) b \left( \theta \right), \f]
+   *
+   * the maximum with respect to \f$\varphi\f$ is \f$\left| a \left( \theta
+   * \right) \right| + \left| b \left( \theta \right) \right|\f$.
+   * The maximum with respect to \f$\theta\f$ is found by
+   * legendre_series::maximum().
+   *
+   * \return \f$\mathrm{max}_{\theta \in \left[ 0, \pi \right], \varphi \in
+   * \left[ 0, 2\pi \right]} | W \left( \theta, \varphi \right) | \f$
+   */
+  double get_maximum() const override;
+
+  /**
+   * \brief Return the normalized coefficients of the series of Legendre
+   * polynomials.
+   *
+   * See W_gamma_gamma::get_legendre_coefficients().
+   */
+  vector<double> get_legendre_coefficients() const override;
+
+  /**
+   * \brief Return the normalized coefficients of the series of associated
+   * Legendre polynomials.
+   *
+   * See W_gamma_gamma::get_associated_legendre_coefficients().
+   */
+  vector<double> get_associated_legendre_coefficients() const override;
+
+  /**
+   * \brief Change the multipole mixing ratio of a single cascade step.
+   *
+   * The dir-dir part is updated with W_dir_dir::set_delta(). If it is shared
+   * with copies of this object, it is copied before. The polarization-dependent
+   * expansion coefficients are recalculated from the existing \f$\alpha_\nu\f$
+   * and \f$A_\nu\f$ coefficients. See also W_gamma_gamma::set_delta().
+   *
+   * \param step Index of the cascade step, starting at 0.
+   * \param delta New multipole mixing ratio \f$\delta\f$.
+   *
+   * \throw out_of_range if step is not smaller than the number of cascade
+   * steps.
+   */
+  void set_delta(const size_t step, const double delta) override;
+
+  /**
+   * \brief Set the degree of linear polarization of the first photon.
+   *
+   * For a partially linearly polarized photon with a degree of polarization
+   * \f$P\f$, the correlation is the weighted sum of the pol-dir correlation
+   * and the dir-dir correlation, which is equivalent to a multiplication of
+   * the polarization-dependent part by \f$P\f$. Since the expansion
+   * coefficients are not changed, evaluating and sampling a partially
+   * polarized correlation is as fast as for a completely polarized one.
+   * A negative value corresponds to a rotation of the polarization plane by
+   * \f$90^\circ\f$.
+   *
+   * \param P Degree of polarization \f$P \in \left[ -1, 1 \right]\f$. The
+   * default value of a new object is 1.
+   *
+   * \throw invalid_argument if \f$\left| P \right| > 1\f$.
+   */
+  void set_polarization_degree(const double P);
+
+  /**
+   * \brief Return the degree of linear polarization of the first photon, see
+   * set_polarization_degree().
+   */
+  double get_polarization_degree() const { return polarization_degree; };
+
+  /**
+   * \brief Return expansion coefficients of the polarization-dependent part
+   * for the current values of the multipole mixing ratios, see also
+   * set_delta().
+   *
+   * \return Unnormalized coefficients of the associated Legendre polynomials
+   * \f$P_\nu^{\left| 2 \right|}\f$, sorted by \f$\nu\f$, starting at
+   * \f$\nu = 2\f$.
+   */
+  const vector<double> &get_expansion_coefficients() const {
+    return expansion_coefficients;
+  };
+
+  /**
+   * \brief Return the direction-direction part of the correlation.
+   */
+  const W_dir_dir &get_w_dir_dir() const { return *w_dir_dir; };
+
+  /**
+   * \brief Return the values of the F and \f$\kappa_\nu\f$ coefficients of
+   * the polarization-dependent part.
+   *
+   * For each \f$\nu\f$, the values of AlphavCoefficient::get_f_values()
+   * followed by AlphavCoefficient::get_kappa_values(). Together with
+   * W_dir_dir::get_coefficient_values() of get_w_dir_dir(), these are the
+   * values which are required to restore the correlation.
+   */
+  vector<double> get_coefficient_values() const;
+
+  /**
+   * \brief Evaluate the expansion coefficients of the polarization-dependent
+   * part for arbitrary multipole mixing ratios.
+   *
+   * See also W_dir_dir::calculate_expansion_coefficients(const vector<double>
+   * &) const.
+   *
+   * \param deltas Multipole mixing ratios \f$\delta_i\f$, one for each
+   * cascade step.
+   *
+   * \return Unnormalized coefficients of the associated Legendre polynomials
+   * \f$P_\nu^{\left| 2 \right|}\f$, sorted by \f$\nu\f$, starting at
+   * \f$\nu = 2\f$.
+   */
+  vector<double>
+  calculate_expansion_coefficients(const vector<double> &deltas) const;
+
+  /**
+   * \brief Derivatives of the expansion coefficients of the
+   * polarization-dependent part with respect to the multipole mixing ratios.
+   *
+   * See also W_dir_dir::calculate_expansion_coefficient_derivatives().
+   *
+   * \param deltas Multipole mixing ratios \f$\delta_j\f$, one for each
+   * cascade step.
+   *
+   * \return Derivatives of the coefficients of
+   * calculate_expansion_coefficients(const vector<double> &) const. The
+   * element \f$\left[ j \right] \left[ i \right]\f$ is the derivative of
+   * the coefficient \f$i\f$ with respect to \f$\delta_j\f$.
+   */
+  vector<vector<double>> calculate_expansion_coefficient_derivatives(
+      const vector<double> &deltas) const;
+
+  void write_string_representation(
+      string &str_rep, const unsigned int n_digits = 0,
+      const vector<string> &variable_names = {}) const override;
 
 protected:
+  /**
+   * \brief Evaluate the pol-dir correlation for given expansion coefficients.
+   *
+   * Evaluate the series of Legendre polynomials and associated Legendre
+   * polynomials for many directions at once.
+   *
+   * \param n Number of directions.
+   * \param cos_theta Cosines of the polar angles, array of length n.
+   * \param phi Azimuthal angles in radians, array of length n.
+   * \param exp_coef_dir_dir Expansion coefficients of the dir-dir part.
+   * \param exp_coef Expansion coefficients of the polarization-dependent part.
+   * \param norm Normalization factor.
+   * \param result Array of length n for the results.
+   */
+  void evaluate_series_cos_theta(const size_t n, const double *cos_theta,
+                                 const double *phi,
+                                 const vector<double> &exp_coef_dir_dir,
+                                 const vector<double> &exp_coef,
+                                 const double norm, double *result) const;
+
   /**
    * \brief Calculate the set of expansion coefficients for the pol-dir
    * correlation.
@@ -220,10 +531,34 @@ protected:
    */
   vector<double> calculate_expansion_coefficients_alphav_Av();
 
-  vector<AvCoefficient> av_coefficients; /**< Vector of AvCoefficient objects */
+  /**
+   * \brief Factor of the polarization-dependent part.
+   *
+   * \return Degree of polarization, multiplied by -1 if the first transition
+   * has a magnetic character.
+   */
+  double get_polarization_factor() const;
+
+  /**
+   * \brief Set the single-precision copies of the normalized coefficients.
+   */
+  void initialize_coefficients_float();
+
+  vector<AvCoefficient> av_coefficients; /**< Vector of AvCoefficient objects,
+                                            shared with the decay branch of
+                                            w_dir_dir */
   vector<AlphavCoefficient>
       alphav_coefficients; /**< Vector of AlphavCoefficient objects */
   vector<double>
       expansion_coefficients; /**< Vector to store expansion coefficients */
-  W_dir_dir w_dir_dir;        /**< Instance of the W_dir_dir class */
+  shared_ptr<W_dir_dir>
+      w_dir_dir; /**< Dir-dir part of the correlation, which is shared by all
+                    copies of the W_pol_dir object until set_delta() is called
+                    on one of them. */
+  vector<float> legendre_coefficients_float; /**< get_legendre_coefficients()
+                                                in single precision */
+  vector<float> associated_legendre_coefficients_float; /**<
+    get_associated_legendre_coefficients() in single precision */
+  double polarization_degree =
+      1.; /**< Degree of linear polarization of the first photon */
 };
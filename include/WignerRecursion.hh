@@ -0,0 +1,148 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * \brief Wigner symbols for all allowed values of one angular momentum.
+ *
+ * Contains the values of a Wigner-3j or 6j symbol for
+ * \f$j_1 = j_{1, \mathrm{min}}, j_{1, \mathrm{min}} + 1, ...,
+ * j_{1, \mathrm{max}}\f$, where \f$j_1\f$ is the first argument of the symbol
+ * and all other arguments are fixed.
+ * Like all angular momenta in alpaca, the limits are stored as twice their
+ * actual value.
+ */
+struct WignerSymbolSequence {
+  int two_j1_min; /**< \f$2 j_{1, \mathrm{min}}\f$ */
+  int two_j1_max; /**< \f$2 j_{1, \mathrm{max}}\f$ (smaller than two_j1_min
+                     if all symbols vanish) */
+  vector<double> values; /**< Values of the symbol, starting at
+                            \f$j_{1, \mathrm{min}}\f$ */
+
+  /**
+   * \brief Value of the symbol for a given \f$j_1\f$.
+   *
+   * \param two_j1 \f$2 j_1\f$
+   *
+   * \return Value of the symbol, or zero if two_j1 is outside the range of
+   * allowed values or has the wrong parity.
+   */
+  double operator()(const int two_j1) const;
+};
+
+/**
+ * \brief Calculation of Wigner-3j and 6j symbols by three-term recursion in
+ * one angular momentum.
+ *
+ * The expansion coefficients of the angular correlations contain Wigner
+ * symbols for all orders \f$\nu\f$ of the expansion, while the other angular
+ * momenta are fixed by the cascade.
+ * Evaluating each symbol with the Racah formula, as gsl_sf_coupling_3j() and
+ * gsl_sf_coupling_6j() \cite Galassi2009 do, requires a sum over products of
+ * factorials for every single value, which becomes slow and suffers from
+ * cancellations for large angular momenta.
+ *
+ * Instead, the functions in this namespace calculate the symbols for all
+ * allowed values of the first angular momentum \f$j_1\f$ at once, using the
+ * three-term recurrence relations of Schulten and Gordon
+ * \cite SchultenGordon1975:
+ *
+ * \f[
+ *      j_1 E \left( j_1 + 1 \right) f \left( j_1 + 1 \right) + F \left( j_1
+ * \right) f \left( j_1 \right) + \left( j_1 + 1 \right) E \left( j_1 \right) f
+ * \left( j_1 - 1 \right) = 0.
+ * \f]
+ *
+ * The recursion is started at both ends of the range of \f$j_1\f$ and
+ * advanced in the direction in which the magnitude of the symbols grows, which
+ * is numerically stable.
+ * Both parts are matched in the classically allowed region, where the symbols
+ * oscillate.
+ * Finally, the sequence is normalized with the orthogonality relation of the
+ * symbols, and the sign is fixed by the phase convention of the symbol with
+ * the largest \f$j_1\f$.
+ * The cost is linear in the number of values, and the relative accuracy is
+ * close to the machine precision even for angular momenta of the order of
+ * 100.
+ */
+namespace wigner_recursion {
+
+/**
+ * \brief Wigner-3j symbols for all allowed values of \f$j_1\f$
+ *
+ * \f[
+ *	\left(
+ *		\begin{array}{ccc}
+ *			j_1 & j_2 & j_3 \\
+ *			m_1 & m_2 & m_3
+ *		\end{array}
+ *	\right),
+ * \f]
+ *
+ * with \f$m_1 = - m_2 - m_3\f$ and
+ * \f$\mathrm{max} \left( \left| j_2 - j_3 \right|, \left| m_1 \right| \right)
+ * \leq j_1 \leq j_2 + j_3\f$.
+ *
+ * \param two_j2 \f$2 j_2\f$
+ * \param two_j3 \f$2 j_3\f$
+ * \param two_m2 \f$2 m_2\f$
+ * \param two_m3 \f$2 m_3\f$
+ *
+ * \return Sequence of Wigner-3j symbols. The arguments are in the same order
+ * as for gsl_sf_coupling_3j().
+ */
+WignerSymbolSequence coupling_3j_sequence(const int two_j2, const int two_j3,
+                                          const int two_m2, const int two_m3);
+
+/**
+ * \brief Wigner-6j symbols for all allowed values of \f$j_1\f$
+ *
+ * \f[
+ *	\left\lbrace
+ *		\begin{array}{ccc}
+ *			j_1 & j_2 & j_3 \\
+ *			l_1 & l_2 & l_3
+ *		\end{array}
+ *	\right\rbrace,
+ * \f]
+ *
+ * with
+ * \f$\mathrm{max} \left( \left| j_2 - j_3 \right|, \left| l_2 - l_3 \right|
+ * \right) \leq j_1 \leq \mathrm{min} \left( j_2 + j_3, l_2 + l_3
+ * \right)\f$.
+ *
+ * \param two_j2 \f$2 j_2\f$
+ * \param two_j3 \f$2 j_3\f$
+ * \param two_l1 \f$2 l_1\f$
+ * \param two_l2 \f$2 l_2\f$
+ * \param two_l3 \f$2 l_3\f$
+ *
+ * \return Sequence of Wigner-6j symbols. The arguments are in the same order
+ * as for gsl_sf_coupling_6j().
+ */
+WignerSymbolSequence coupling_6j_sequence(const int two_j2, const int two_j3,
+                                          const int two_l1, const int two_l2,
+                                          const int two_l3);
+
+} // namespace wigner_recursion
@@ -0,0 +1,181 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#pragma once
+
+#include <cstddef>
+
+using std::size_t;
+
+/**
+ * \brief Ways to calculate the Wigner symbols of WignerSymbolCache.
+ */
+enum WignerSymbolBackend : short {
+  gsl_backend = 0,      ///< Single symbols with gsl_sf_coupling_3j() and
+                        ///< gsl_sf_coupling_6j().
+  recursion_backend = 1 ///< All values of the first angular momentum at once
+                        ///< with wigner_recursion.
+};
+
+/**
+ * \brief Process-wide memo cache for Wigner-3j and 6j symbols.
+ *
+ * All coefficient classes of alpaca (FCoefficient, KappaCoefficient, and
+ * UvCoefficient) are expressed in terms of Wigner-3j and 6j symbols, which are
+ * calculated by the GNU Scientific Library (GSL) \cite Galassi2009. Scans over
+ * spin-parity hypotheses construct a large number of AngularCorrelation
+ * objects, but the set of distinct arguments of the Wigner symbols is small.
+ * Therefore, this class stores all symbols that have been calculated once in a
+ * table that is shared by all coefficient objects of a process.
+ *
+ * The arguments of the Wigner symbols are the actual values multiplied by two,
+ * in accordance with the GSL functions gsl_sf_coupling_3j() and
+ * gsl_sf_coupling_6j().
+ * Access to the tables is protected by a mutex, i.e. the cache may be used
+ * from several threads at the same time.
+ *
+ * The number of entries per table is limited by
+ * WignerSymbolCache::get_max_size().
+ * Once a table is full, new values are still calculated correctly, but they are
+ * not stored any more.
+ *
+ * By default, a request that cannot be answered from the cache calculates the
+ * symbols for all allowed values of the first argument \f$j_a\f$ at once
+ * with the three-term recursion of wigner_recursion, and stores all of them.
+ * Since the coefficient classes pass the order \f$\nu\f$ of the expansion as
+ * the first argument, the construction of all orders of an angular
+ * correlation requires only a single calculation per combination of the
+ * other angular momenta.
+ * The recursion is also more accurate than the Racah formula for large
+ * angular momenta.
+ * The previous behavior, one call of a GSL function per symbol, can be
+ * restored with WignerSymbolCache::set_backend().
+ *
+ * The cache does not apply the selection rules of the Wigner symbols by
+ * itself.
+ * Callers are expected to check the rules implemented in
+ * FCoefficient::cg_is_nonzero() and FCoefficient::racah_is_nonzero() before,
+ * so that vanishing symbols neither cause a call of a GSL function nor occupy
+ * an entry of the cache.
+ */
+class WignerSymbolCache {
+public:
+  /**
+   * \brief Wigner-3j symbol
+   *
+   * \f[
+   *	\left(
+   *		\begin{array}{ccc}
+   *			j_a & j_b & j_c \\
+   *			m_a & m_b & m_c
+   *		\end{array}
+   *	\right)
+   * \f]
+   *
+   * \param two_ja \f$2 j_a\f$
+   * \param two_jb \f$2 j_b\f$
+   * \param two_jc \f$2 j_c\f$
+   * \param two_ma \f$2 m_a\f$
+   * \param two_mb \f$2 m_b\f$
+   * \param two_mc \f$2 m_c\f$
+   *
+   * \return Value of the Wigner-3j symbol, either from the cache or from the
+   * backend.
+   */
+  static double coupling_3j(const int two_ja, const int two_jb,
+                            const int two_jc, const int two_ma,
+                            const int two_mb, const int two_mc);
+
+  /**
+   * \brief Wigner-6j symbol
+   *
+   * \f[
+   *	\left\lbrace
+   *		\begin{array}{ccc}
+   *			j_a & j_b & j_c \\
+   *			j_d & j_e & j_f
+   *		\end{array}
+   *	\right\rbrace
+   * \f]
+   *
+   * \param two_ja \f$2 j_a\f$
+   * \param two_jb \f$2 j_b\f$
+   * \param two_jc \f$2 j_c\f$
+   * \param two_jd \f$2 j_d\f$
+   * \param two_je \f$2 j_e\f$
+   * \param two_jf \f$2 j_f\f$
+   *
+   * \return Value of the Wigner-6j symbol, either from the cache or from the
+   * backend.
+   */
+  static double coupling_6j(const int two_ja, const int two_jb,
+                            const int two_jc, const int two_jd,
+                            const int two_je, const int two_jf);
+
+  /**
+   * \brief Number of requests that could be answered from the cache.
+   */
+  static size_t get_hits();
+
+  /**
+   * \brief Number of requests that required a calculation by the backend.
+   */
+  static size_t get_misses();
+
+  /**
+   * \brief Total number of Wigner symbols stored in the cache.
+   */
+  static size_t size();
+
+  /**
+   * \brief Maximum number of entries of each of the 3j and the 6j table.
+   */
+  static size_t get_max_size();
+
+  /**
+   * \brief Set the maximum number of entries of each of the 3j and 6j tables.
+   *
+   * If the new limit is smaller than the current number of entries, the cache
+   * is cleared. A limit of zero disables caching.
+   *
+   * \param max_size Maximum number of entries per table.
+   */
+  static void set_max_size(const size_t max_size);
+
+  /**
+   * \brief Method for the calculation of symbols which are not in the cache.
+   */
+  static WignerSymbolBackend get_backend();
+
+  /**
+   * \brief Set the method for the calculation of symbols which are not in the
+   * cache.
+   *
+   * Entries which are already in the cache are kept.
+   *
+   * \param backend Calculation method.
+   */
+  static void set_backend(const WignerSymbolBackend backend);
+
+  /**
+   * \brief Remove all entries from the cache and reset the hit and miss
+   * counters.
+   */
+  static void clear();
+};
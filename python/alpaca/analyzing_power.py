@@ -15,12 +15,12 @@
 
 # Copyright (C) 2021-2023 Udo Friman-Gayer
 
+from ctypes import c_double
 import warnings
 
 import numpy as np
 
-from alpaca.angular_correlation import AngularCorrelation
-from alpaca.transition import Transition
+from alpaca.angular_correlation import AngularCorrelation, libangular_correlation
 
 CONVENTION = {"natural": 1.0, "KPZ": -1.0}
 
@@ -196,18 +196,12 @@ class AnalyzingPower:
 
         Returns
         -------
-        float, :math:`A \left( \theta \right)`
+        float or ndarray
+            :math:`A \left( \theta \right)`, with the shape of the broadcast angles.
         """
 
-        w_para = self.angular_correlation(theta, phi)
-        w_perp = self.angular_correlation(thetap if thetap is not None else theta, phip)
-
-        return (
-            self.PQ
-            * CONVENTION[self.convention]
-            * (w_para - w_perp)
-            / (w_para + w_perp)
-        )
+        # All pairs of directions are evaluated with a single call of the C++ code.
+        return self._evaluate(None, theta, thetap, phi, phip)[0][()]
 
     def evaluate(
         self,
@@ -220,8 +214,8 @@ class AnalyzingPower:
     ):
         r"""Evaluate the analyzing power for a given value of the multipole mixing ratio
 
-        Based on the cascade in this AnalyzingPower object, this function creates a new object
-        with the given values of the multipole mixing ratio.
+        Based on the cascade in this AnalyzingPower object, this function evaluates the
+        angular correlation with the given values of the multipole mixing ratio.
         It is assumed that only one variable is needed to obtain all the mixing ratios of the
         cascade.
 
@@ -251,71 +245,196 @@ class AnalyzingPower:
             Polar angle :math:`\theta^\prime` in radians (default: None, i.e. use the same value as theta).
         phi, phip: float or ndarray
             Azimuthal angles :math:`\varphi` and :math:`\varphi^\prime` in radians (default: 0 and 90 degrees).
+            All angles are broadcast to a common shape.
 
         Returns
         -------
-        float
-            Value of the analyzing power at the given multipole mixing ratio.
+        float or ndarray
+            Value of the analyzing power at the given multipole mixing ratio(s), with the same
+            shape as delta if all angles are scalars.
+            Otherwise, the shape of delta is followed by the shape of the broadcast angles.
+
+        Raises
+        ------
+        ValueError
+            If the number of entries in delta_values does not match the number of cascade steps.
         """
         original_shape = np.shape(delta)
         scalar_output = isinstance(delta, (int, float))
-        delta = np.reshape(delta, (np.size(delta),))
-        asymmetries = np.zeros(len(delta))
-
-        for i, d in enumerate(delta):
-            cascade_steps = []
-            for j, cas_ste in enumerate(self.angular_correlation.cascade_steps):
-                if isinstance(delta_values[j], str):
-                    cascade_steps.append(
-                        [
-                            Transition(
-                                cas_ste[0].em_char,
-                                cas_ste[0].two_L,
-                                cas_ste[0].em_charp,
-                                cas_ste[0].two_Lp,
-                                d,
-                            ),
-                            cas_ste[1],
-                        ]
-                    )
-                elif callable(delta_values[j]):
-                    cascade_steps.append(
-                        [
-                            Transition(
-                                cas_ste[0].em_char,
-                                cas_ste[0].two_L,
-                                cas_ste[0].em_charp,
-                                cas_ste[0].two_Lp,
-                                delta_values[j](d),
-                            ),
-                            cas_ste[1],
-                        ]
-                    )
-                else:
-                    cascade_steps.append(
-                        [
-                            Transition(
-                                cas_ste[0].em_char,
-                                cas_ste[0].two_L,
-                                cas_ste[0].em_charp,
-                                cas_ste[0].two_Lp,
-                                delta_values[j],
-                            ),
-                            cas_ste[1],
-                        ]
-                    )
-            ana_pow = AnalyzingPower(
-                AngularCorrelation(
-                    self.angular_correlation.initial_state, cascade_steps
-                ),
-                PQ=self.PQ,
-                convention=self.convention,
-            )
-            asymmetries[i] = ana_pow(
-                theta, thetap if thetap is not None else theta, phi, phip
+        delta = np.reshape(delta, (np.size(delta),)).astype(float)
+
+        if len(delta_values) != self.angular_correlation.n_cas_ste:
+            raise ValueError(
+                "Number of multipole-mixing ratios ({:d}) does not match the number of cascade steps ({:d}).".format(
+                    len(delta_values), self.angular_correlation.n_cas_ste
+                )
             )
-            # Avoid memory leaking by deleting the temporarily created AngularCorrelation objects.
-            ana_pow.angular_correlation.free()
+
+        # All mixing ratios are collected in a single array.
+        deltas = np.zeros((len(delta), len(delta_values)))
+        for j, delta_value in enumerate(delta_values):
+            if isinstance(delta_value, str):
+                deltas[:, j] = delta
+            elif callable(delta_value):
+                deltas[:, j] = [delta_value(d) for d in delta]
+            else:
+                deltas[:, j] = delta_value
+
+        # The analyzing powers for all mixing ratios and directions are calculated with a
+        # single call of the C++ code.
+        asymmetries = self._evaluate(deltas, theta, thetap, phi, phip)
+        angle_shape = asymmetries.shape[1:]
         if scalar_output:
-            return asymmetries[0]
-        return np.reshape(asymmetries, original_shape)
+            return asymmetries[0][()]
+        return np.reshape(asymmetries, original_shape + angle_shape)
+
+    def invert(
+        self,
+        asymmetry,
+        delta_values,
+        theta=0.5 * np.pi,
+        thetap=None,
+        phi=0.0,
+        phip=0.5 * np.pi,
+        return_arctan=False,
+    ):
+        r"""Find all values of the multipole mixing ratio that agree with a measured asymmetry
+
+        In contrast to `alpaca.inversion_by_grid_evaluation.invert_grid` and
+        `alpaca.inversion_by_piecewise_interpolation.interpolate_and_invert`, this function does
+        not evaluate the analyzing power on a grid.
+        At fixed angles, the analyzing power is a ratio of two polynomials in the mixing ratio.
+        The limits of the intervals are found as the real roots of polynomials by the C++ class
+        MixingRatioInverter, i.e. they are exact up to rounding errors.
+
+        The returned list of intervals can be used as an input for the functions in
+        `alpaca.interval_intersections`, for example to combine the results of several
+        measurements.
+
+        Parameters
+        ----------
+        asymmetry: float or [float, float]
+            Measured asymmetry :math:`\epsilon` or range
+            :math:`\left[ \epsilon - \Delta \epsilon, \epsilon + \Delta \epsilon \right]`.
+            The two limits of the range do not have to be sorted.
+        delta_values: list of str or float or callable
+            See `alpaca.AnalyzingPower.evaluate`.
+            Since the inversion requires the mixing ratios to be linear functions of the
+            variable, a callable must be of the form `lambda x: a*x + b`.
+        theta: float
+            Polar angle :math:`\theta` in radians (default: 90 degrees).
+        thetap: float
+            Polar angle :math:`\theta^\prime` in radians (default: None, i.e. use the same value as theta).
+        phi, phip: float
+            Azimuthal angles :math:`\varphi` and :math:`\varphi^\prime` in radians (default: 0 and 90 degrees).
+        return_arctan: bool
+            Determines whether the limits of the intervals are given as mixing ratios (False,
+            default) or as their arctangents (True).
+            Mixing ratios of :math:`\pm \infty` are represented by :math:`\pm \pi/2`.
+
+        Returns
+        -------
+        list of [float, float]
+            Sorted list of intervals of the variable, or of its arctangent.
+            Intervals whose limits are equal indicate single values.
+
+        Raises
+        ------
+        ValueError
+            If the number of entries in delta_values does not match the number of cascade steps,
+            or if a callable in delta_values is not a linear function.
+        """
+        if len(delta_values) != self.angular_correlation.n_cas_ste:
+            raise ValueError(
+                "Number of multipole-mixing ratios ({:d}) does not match the number of cascade steps ({:d}).".format(
+                    len(delta_values), self.angular_correlation.n_cas_ste
+                )
+            )
+
+        slope = np.zeros(len(delta_values))
+        offset = np.zeros(len(delta_values))
+        for j, delta_value in enumerate(delta_values):
+            if isinstance(delta_value, str):
+                slope[j] = 1.0
+            elif callable(delta_value):
+                offset[j] = delta_value(0.0)
+                slope[j] = delta_value(1.0) - offset[j]
+                for x in (-3.7, 0.4, 12.9):
+                    if not np.isclose(delta_value(x), slope[j] * x + offset[j]):
+                        raise ValueError(
+                            "Mixing ratio {:d} is not a linear function of the variable.".format(
+                                j + 1
+                            )
+                        )
+            else:
+                offset[j] = delta_value
+
+        if isinstance(asymmetry, (int, float)):
+            asymmetry = [asymmetry, asymmetry]
+        value = 0.5 * (asymmetry[0] + asymmetry[1])
+        uncertainty = 0.5 * np.abs(asymmetry[1] - asymmetry[0])
+
+        n_cas_ste = self.angular_correlation.n_cas_ste
+        max_intervals = 4 * n_cas_ste + 2
+        intervals = (c_double * (2 * max_intervals))()
+        n_intervals = libangular_correlation.invert_analyzing_power(
+            self.angular_correlation.angular_correlation,
+            (c_double * n_cas_ste)(*slope),
+            (c_double * n_cas_ste)(*offset),
+            theta,
+            thetap if thetap is not None else theta,
+            phi,
+            phip,
+            self.PQ * CONVENTION[self.convention],
+            value,
+            uncertainty,
+            return_arctan,
+            max_intervals,
+            intervals,
+        )
+
+        return [
+            [intervals[2 * i], intervals[2 * i + 1]]
+            for i in range(min(n_intervals, max_intervals))
+        ]
+
+    def _evaluate(self, deltas, theta, thetap, phi, phip):
+        r"""Evaluate the analyzing power for sets of mixing ratios and pairs of directions
+
+        Parameters
+        ----------
+        deltas: ndarray or None
+            Mixing ratios, one row per set, or None to use the mixing ratios of the cascade.
+        theta, thetap, phi, phip: float or ndarray
+            Angles in radians, which are broadcast to a common shape.
+            If thetap is None, the values of theta are used.
+
+        Returns
+        -------
+        ndarray
+            Analyzing powers with the shape (number of sets,) + shape of the broadcast angles.
+        """
+        theta, thetap, phi, phip = np.broadcast_arrays(
+            np.asarray(theta, dtype=float),
+            np.asarray(thetap if thetap is not None else theta, dtype=float),
+            np.asarray(phi, dtype=float),
+            np.asarray(phip, dtype=float),
+        )
+        n_angles = theta.size
+        n_deltas = 1 if deltas is None else len(deltas)
+
+        result = (c_double * (n_deltas * n_angles))()
+        libangular_correlation.analyzing_power_grid(
+            self.angular_correlation.angular_correlation,
+            n_deltas,
+            None if deltas is None else (c_double * deltas.size)(*deltas.ravel()),
+            n_angles,
+            (c_double * n_angles)(*theta.ravel()),
+            (c_double * n_angles)(*thetap.ravel()),
+            (c_double * n_angles)(*phi.ravel()),
+            (c_double * n_angles)(*phip.ravel()),
+            self.PQ,
+            int(CONVENTION[self.convention]),
+            result,
+        )
+        return np.reshape(np.array(result), (n_deltas,) + theta.shape)
@@ -19,12 +19,10 @@ import matplotlib.pyplot as plt
 import numpy as np
 
 from .analyzing_power import AnalyzingPower, arctan_grid
-from .angular_correlation import AngularCorrelation
 from .interval_intersections import intersection
 from .inversion_by_grid_evaluation import invert_grid
 from .level_scheme_plotter import LevelSchemePlotter
 from .state import State
-from .transition import Transition
 
 
 class AnalyzingPowerPlotter:
@@ -110,49 +108,13 @@ class AnalyzingPowerPlotter:
         self.marker_positive_infinity = "^"
 
     def evaluate(self, deltas):
-        ana_pow_1 = np.zeros(len(deltas))
-        ana_pow_2 = np.zeros(len(deltas))
+        # The existing angular correlation is evaluated for all mixing ratios and both polar
+        # angles at once, instead of constructing a new object for each of them.
+        ana_pow = AnalyzingPower(
+            self.angular_correlation, convention=self.convention
+        ).evaluate(deltas, self.delta_values, theta=[self.theta_1, self.theta_2])
 
-        for i, delta in enumerate(deltas):
-            initial_state = self.angular_correlation.initial_state
-            cascade_steps = []
-            for j, cas in enumerate(self.angular_correlation.cascade_steps):
-                if isinstance(self.delta_values[j], str):
-                    cascade_steps.append(
-                        [
-                            Transition(
-                                cas[0].em_char,
-                                cas[0].two_L,
-                                cas[0].em_charp,
-                                cas[0].two_Lp,
-                                delta,
-                            ),
-                            cas[1],
-                        ]
-                    )
-                else:
-                    cascade_steps.append(
-                        [
-                            Transition(
-                                cas[0].em_char,
-                                cas[0].two_L,
-                                cas[0].em_charp,
-                                cas[0].two_Lp,
-                                self.delta_values[j],
-                            ),
-                            cas[1],
-                        ]
-                    )
-            ana_pow_1[i] = AnalyzingPower(
-                AngularCorrelation(initial_state, cascade_steps),
-                convention=self.convention,
-            )(theta=self.theta_1)
-            ana_pow_2[i] = AnalyzingPower(
-                AngularCorrelation(initial_state, cascade_steps),
-                convention=self.convention,
-            )(theta=self.theta_2)
-
-        return (ana_pow_1, ana_pow_2)
+        return (ana_pow[..., 0], ana_pow[..., 1])
 
     def plot(self, n_delta=100):
         abs_delta_max = 100.0
@@ -15,7 +15,22 @@
 
 # Copyright (C) 2021-2023 Udo Friman-Gayer
 
-from ctypes import byref, cdll, c_double, c_int, c_short, c_size_t, c_void_p, POINTER
+from ctypes import (
+    Array,
+    byref,
+    cdll,
+    c_bool,
+    c_char_p,
+    c_double,
+    c_int,
+    c_short,
+    c_size_t,
+    c_uint,
+    c_uint64,
+    c_void_p,
+    create_string_buffer,
+    POINTER,
+)
 import warnings
 
 import numpy as np
@@ -48,10 +63,131 @@ libangular_correlation.create_angular_correlation_with_transition_inference.argt
     POINTER(c_short),  # Parities
 ]
 
+libangular_correlation.try_create_angular_correlation.restype = c_void_p
+libangular_correlation.try_create_angular_correlation.argtypes = [
+    c_size_t,  # Number of cascade steps
+    POINTER(c_int),  # Angular momenta
+    POINTER(c_short),  # Parities
+    POINTER(c_short),  # EM characters
+    POINTER(c_int),  # Multipolarities
+    POINTER(c_short),  # Alternative EM characters
+    POINTER(c_int),  # Alternative multipolarities
+    POINTER(c_double),  # Multipole mixing ratios
+    POINTER(c_int),  # Status of the validation
+    c_size_t,  # Length of the buffer for the error message
+    c_char_p,  # Buffer for the error message
+]
+
+libangular_correlation.try_create_angular_correlation_with_transition_inference.restype = (
+    c_void_p
+)
+libangular_correlation.try_create_angular_correlation_with_transition_inference.argtypes = [
+    c_size_t,  # Number of cascade steps
+    POINTER(c_int),  # Angular momenta
+    POINTER(c_short),  # Parities
+    POINTER(c_int),  # Status of the validation
+    c_size_t,  # Length of the buffer for the error message
+    c_char_p,  # Buffer for the error message
+]
+
+libangular_correlation.validate_cascade.restype = c_int
+libangular_correlation.validate_cascade.argtypes = [
+    c_size_t,  # Number of cascade steps
+    POINTER(c_int),  # Angular momenta
+    POINTER(c_short),  # Parities
+    POINTER(c_short),  # EM characters
+    POINTER(c_int),  # Multipolarities
+    POINTER(c_short),  # Alternative EM characters
+    POINTER(c_int),  # Alternative multipolarities
+    c_size_t,  # Length of the buffer for the error message
+    c_char_p,  # Buffer for the error message
+]
+
+MESSAGE_LENGTH = 512
+
 libangular_correlation.free_angular_correlation.argtypes = [
     c_void_p,  # Pointer to AngularCorrelation object
 ]
 
+libangular_correlation.try_create_angular_correlation_handle.restype = c_uint64
+libangular_correlation.try_create_angular_correlation_handle.argtypes = [
+    c_size_t,  # Number of cascade steps
+    POINTER(c_int),  # Angular momenta
+    POINTER(c_short),  # Parities
+    POINTER(c_short),  # EM characters
+    POINTER(c_int),  # Multipolarities
+    POINTER(c_short),  # Alternative EM characters
+    POINTER(c_int),  # Alternative multipolarities
+    POINTER(c_double),  # Multipole mixing ratios
+    POINTER(c_int),  # Status of the validation
+    c_size_t,  # Length of the buffer for the error message
+    c_char_p,  # Buffer for the error message
+]
+
+libangular_correlation.create_angular_correlation_handles.restype = c_int
+libangular_correlation.create_angular_correlation_handles.argtypes = [
+    c_size_t,  # Number of cascades
+    POINTER(c_size_t),  # Offsets of the cascades in the arrays of transitions
+    POINTER(c_int),  # Angular momenta
+    POINTER(c_short),  # Parities
+    POINTER(c_short),  # EM characters
+    POINTER(c_int),  # Multipolarities
+    POINTER(c_short),  # Alternative EM characters
+    POINTER(c_int),  # Alternative multipolarities
+    POINTER(c_double),  # Multipole mixing ratios
+    POINTER(c_uint64),  # Array that contains the handles
+]
+
+libangular_correlation.set_angular_correlation_delta.restype = c_int
+libangular_correlation.set_angular_correlation_delta.argtypes = [
+    c_void_p,  # Pointer to AngularCorrelation object
+    c_size_t,  # Index of the cascade step
+    c_double,  # Multipole mixing ratio
+]
+
+libangular_correlation.serialize_angular_correlation.restype = c_size_t
+libangular_correlation.serialize_angular_correlation.argtypes = [
+    c_void_p,  # Pointer to AngularCorrelation object
+    c_char_p,  # Buffer for the serialized object
+    c_size_t,  # Size of the buffer
+]
+
+libangular_correlation.deserialize_angular_correlation_handle.restype = c_uint64
+libangular_correlation.deserialize_angular_correlation_handle.argtypes = [
+    c_char_p,  # Serialized object
+    c_size_t,  # Size of the serialized object
+]
+
+libangular_correlation.set_angular_correlation_polarization_degree.restype = c_int
+libangular_correlation.set_angular_correlation_polarization_degree.argtypes = [
+    c_void_p,  # Pointer to AngularCorrelation object
+    c_double,  # Degree of polarization
+]
+
+libangular_correlation.get_angular_correlation_from_handle.restype = c_void_p
+libangular_correlation.get_angular_correlation_from_handle.argtypes = [
+    c_uint64,  # Handle of AngularCorrelation object
+]
+
+libangular_correlation.retain_angular_correlation_handle.restype = c_int
+libangular_correlation.retain_angular_correlation_handle.argtypes = [
+    c_uint64,  # Handle of AngularCorrelation object
+]
+
+libangular_correlation.release_angular_correlation_handle.restype = c_int
+libangular_correlation.release_angular_correlation_handle.argtypes = [
+    c_uint64,  # Handle of AngularCorrelation object
+]
+
+libangular_correlation.release_angular_correlation_handles.restype = c_size_t
+libangular_correlation.release_angular_correlation_handles.argtypes = [
+    c_size_t,  # Number of handles
+    POINTER(c_uint64),  # Handles of AngularCorrelation objects
+]
+
+libangular_correlation.get_n_angular_correlation_handles.restype = c_size_t
+libangular_correlation.get_n_angular_correlation_handles.argtypes = []
+
 libangular_correlation.get_em_char.argtypes = [
     c_void_p,  # Pointer to AngularCorrelation object
     POINTER(c_short),  # Array that contains the results
@@ -70,6 +206,25 @@ libangular_correlation.evaluate_angular_correlation.argtypes = [
     POINTER(c_double),  # Array that contains the results
 ]
 
+libangular_correlation.evaluate_angular_correlation_with_deltas.argtypes = [
+    c_void_p,  # Pointer to AngularCorrelation object
+    c_size_t,  # Number of angles
+    POINTER(c_double),  # Polar angle theta
+    POINTER(c_double),  # Azimuthal angle phi
+    POINTER(c_double),  # Multipole mixing ratios
+    POINTER(c_double),  # Array that contains the results
+]
+
+libangular_correlation.evaluate_angular_correlation_with_gradient.argtypes = [
+    c_void_p,  # Pointer to AngularCorrelation object
+    c_size_t,  # Number of angles
+    POINTER(c_double),  # Polar angle theta
+    POINTER(c_double),  # Azimuthal angle phi
+    POINTER(c_double),  # Multipole mixing ratios
+    POINTER(c_double),  # Array that contains the results
+    POINTER(c_double),  # Array that contains the gradients
+]
+
 libangular_correlation.evaluate_angular_correlation_rotated.argtypes = [
     c_void_p,  # Pointer to AngularCorrelation object
     c_size_t,  # Number of angles
@@ -79,6 +234,119 @@ libangular_correlation.evaluate_angular_correlation_rotated.argtypes = [
     POINTER(c_double),  # Array that contains the results
 ]
 
+libangular_correlation.evaluate_angular_correlation_grid.argtypes = [
+    c_void_p,  # Pointer to AngularCorrelation object
+    c_size_t,  # Number of polar angles
+    POINTER(c_double),  # Polar angles theta
+    c_size_t,  # Number of azimuthal angles
+    POINTER(c_double),  # Azimuthal angles phi
+    POINTER(c_double),  # Euler angles Phi, Theta, and Psi, or None
+    POINTER(c_double),  # Array that contains the results
+]
+
+libangular_correlation.evaluate_angular_correlation_delta_scan.argtypes = [
+    c_void_p,  # Pointer to AngularCorrelation object
+    c_size_t,  # Number of sets of multipole mixing ratios
+    POINTER(c_double),  # Multipole mixing ratios
+    c_size_t,  # Number of angles
+    POINTER(c_double),  # Polar angle theta
+    POINTER(c_double),  # Azimuthal angle phi
+    POINTER(c_double),  # Array that contains the results
+]
+
+libangular_correlation.analyzing_power_delta_scan.argtypes = [
+    c_void_p,  # Pointer to AngularCorrelation object
+    c_size_t,  # Number of sets of multipole mixing ratios
+    POINTER(c_double),  # Multipole mixing ratios
+    c_double,  # Polar angle theta
+    c_double,  # Polar angle thetap
+    c_double,  # Azimuthal angle phi
+    c_double,  # Azimuthal angle phip
+    c_double,  # Product of polarization and polarization sensitivity
+    POINTER(c_double),  # Array that contains the results
+]
+
+libangular_correlation.analyzing_power_grid.argtypes = [
+    c_void_p,  # Pointer to AngularCorrelation object
+    c_size_t,  # Number of sets of multipole mixing ratios
+    POINTER(c_double),  # Multipole mixing ratios, or None
+    c_size_t,  # Number of pairs of directions
+    POINTER(c_double),  # Polar angles theta
+    POINTER(c_double),  # Polar angles thetap
+    POINTER(c_double),  # Azimuthal angles phi
+    POINTER(c_double),  # Azimuthal angles phip
+    c_double,  # Product of polarization and polarization sensitivity
+    c_int,  # Sign convention
+    POINTER(c_double),  # Array that contains the results
+]
+
+libangular_correlation.invert_analyzing_power.restype = c_size_t
+libangular_correlation.invert_analyzing_power.argtypes = [
+    c_void_p,  # Pointer to AngularCorrelation object
+    POINTER(c_double),  # Slopes of the multipole mixing ratios
+    POINTER(c_double),  # Offsets of the multipole mixing ratios
+    c_double,  # Polar angle theta
+    c_double,  # Polar angle thetap
+    c_double,  # Azimuthal angle phi
+    c_double,  # Azimuthal angle phip
+    c_double,  # Product of polarization and polarization sensitivity
+    c_double,  # Measured asymmetry
+    c_double,  # Uncertainty of the measured asymmetry
+    c_bool,  # Return the arctangents of the interval limits
+    c_size_t,  # Maximum number of intervals
+    POINTER(c_double),  # Array that contains the interval limits
+]
+
+libangular_correlation.integrate_angular_correlation_cone.argtypes = [
+    c_void_p,  # Pointer to AngularCorrelation object
+    c_size_t,  # Number of cones
+    POINTER(c_double),  # Polar angle theta of the axes
+    POINTER(c_double),  # Azimuthal angle phi of the axes
+    POINTER(c_double),  # Opening angles
+    POINTER(c_double),  # Array that contains the results
+]
+
+
+def _cascade_arrays(initial_state, cascade_steps):
+    r"""Convert a cascade to the arrays of the C interface
+
+    Parameters
+    ----------
+    initial_state: State
+        Initial state of the cascade.
+    cascade_steps: array of [Transition, State] pairs or array of State objects
+        Cascade steps, in the same format as for the constructor of AngularCorrelation.
+
+    Returns
+    -------
+    tuple of ctypes arrays
+        Angular momenta and parities of the states, and EM characters, multipolarities, and
+        mixing ratios of the transitions.
+        The arrays of the transitions are None if the cascade steps are State objects.
+    """
+    if isinstance(cascade_steps[0], State):
+        states = [initial_state] + list(cascade_steps)
+        transitions = None
+    else:
+        states = [initial_state] + [cas_ste[1] for cas_ste in cascade_steps]
+        transitions = [cas_ste[0] for cas_ste in cascade_steps]
+
+    two_J = (c_int * len(states))(*[state.two_J for state in states])
+    par = (c_short * len(states))(*[state.parity for state in states])
+    if transitions is None:
+        return two_J, par, None, None, None, None, None
+
+    n = len(transitions)
+    return (
+        two_J,
+        par,
+        (c_short * n)(*[t.em_char for t in transitions]),
+        (c_int * n)(*[t.two_L for t in transitions]),
+        (c_short * n)(*[t.em_charp for t in transitions]),
+        (c_int * n)(*[t.two_Lp for t in transitions]),
+        (c_double * n)(*[t.delta for t in transitions]),
+    )
+
 
 class AngularCorrelation:
     r"""Class for a gamma-gamma correlation.
@@ -225,28 +493,62 @@ class AngularCorrelation:
             Cascade steps, given as a list of arbitrary length which contains Transition-State pairs or State objects.
             The first and the last transition of this list are assumed to be observed.
             If no transition information is given, the most likely transitions (lowest multipole order, no mixing) are assumed to connect the given states.
+
+        Raises
+        ------
+        ValueError
+            If the cascade is invalid (see validate_cascade()).
         """
 
-        self.initial_state = initial_state
+        self.handle = 0
         self.angular_correlation = None
-        self.n_cas_ste = len(cascade_steps)
 
-        if isinstance(cascade_steps[0], State):
-            two_J = [cas_ste.two_J for cas_ste in cascade_steps]
-            two_J.insert(0, initial_state.two_J)
-            two_J = (c_int * len(two_J))(*two_J)
-            par = [cas_ste.parity for cas_ste in cascade_steps]
-            par.insert(0, initial_state.parity)
-            par = (c_short * len(par))(*par)
-            self.angular_correlation = libangular_correlation.create_angular_correlation_with_transition_inference(
-                self.n_cas_ste, two_J, par
+        two_J, par, em_char, two_L, em_charp, two_Lp, delta = _cascade_arrays(
+            initial_state, cascade_steps
+        )
+        status = c_int()
+        message = create_string_buffer(MESSAGE_LENGTH)
+        self._set_handle(
+            libangular_correlation.try_create_angular_correlation_handle(
+                len(cascade_steps),
+                two_J,
+                par,
+                em_char,
+                two_L,
+                em_charp,
+                two_Lp,
+                delta,
+                byref(status),
+                MESSAGE_LENGTH,
+                message,
             )
+        )
+        if not self.handle:
+            raise ValueError(message.value.decode())
+        self._set_cascade(initial_state, cascade_steps)
+
+    def _set_cascade(self, initial_state, cascade_steps):
+        """Store the cascade of the internal AngularCorrelation object
+
+        If the cascade steps are given as State objects, the transitions that were inferred by
+        the C++ code are stored.
+
+        Parameters
+        ----------
+        initial_state: State
+            Initial state of the cascade.
+        cascade_steps: array of [Transition, State] pairs or array of State objects
+            Cascade steps, in the same format as for the constructor.
+        """
+        self.initial_state = initial_state
+        self.n_cas_ste = len(cascade_steps)
 
+        if isinstance(cascade_steps[0], State):
             em_char = (c_short * self.n_cas_ste)()
             libangular_correlation.get_em_char(self.angular_correlation, em_char)
             two_L = (c_int * self.n_cas_ste)()
             libangular_correlation.get_two_L(self.angular_correlation, two_L)
-            self.cascade_steps = []
+            inferred_cascade_steps = []
             for i in range(self.n_cas_ste):
                 em_charp = EM_UNKNOWN
                 if em_char[i] == MAGNETIC:
@@ -254,49 +556,24 @@ class AngularCorrelation:
                 elif em_char[i] == ELECTRIC:
                     em_charp = MAGNETIC
 
-                self.cascade_steps.append(
+                inferred_cascade_steps.append(
                     [
                         Transition(em_char[i], two_L[i], em_charp, two_L[i] + 2, 0.0),
                         cascade_steps[i],
                     ]
                 )
-
-            two_Lp = [tL + 2 for tL in two_L]
-            delta = [0.0] * self.n_cas_ste
-
-        else:
-            two_J = [cas_ste[1].two_J for cas_ste in cascade_steps]
-            two_J.insert(0, initial_state.two_J)
-            two_J = (c_int * len(two_J))(*two_J)
-            par = [cas_ste[1].parity for cas_ste in cascade_steps]
-            par.insert(0, initial_state.parity)
-            par = (c_short * len(par))(*par)
-
-            em_char = [cas_ste[0].em_char for cas_ste in cascade_steps]
-            em_char = (c_short * len(em_char))(*em_char)
-            two_L = [cas_ste[0].two_L for cas_ste in cascade_steps]
-            two_L = (c_int * len(two_L))(*two_L)
-            em_charp = [cas_ste[0].em_charp for cas_ste in cascade_steps]
-            em_charp = (c_short * len(em_charp))(*em_charp)
-            two_Lp = [cas_ste[0].two_Lp for cas_ste in cascade_steps]
-            two_Lp = (c_int * len(two_Lp))(*two_Lp)
-            delta = [cas_ste[0].delta for cas_ste in cascade_steps]
-            delta = (c_double * len(delta))(*delta)
-
-            self.angular_correlation = (
-                libangular_correlation.create_angular_correlation(
-                    self.n_cas_ste, two_J, par, em_char, two_L, em_charp, two_Lp, delta
-                )
-            )
-            self.cascade_steps = cascade_steps
-
-        self.two_J = two_J
-        self.par = par
-        self.em_char = em_char
-        self.two_L = two_L
-        self.em_charp = em_charp
-        self.two_Lp = two_Lp
-        self.delta = delta
+            cascade_steps = inferred_cascade_steps
+
+        (
+            self.two_J,
+            self.par,
+            self.em_char,
+            self.two_L,
+            self.em_charp,
+            self.two_Lp,
+            self.delta,
+        ) = _cascade_arrays(initial_state, cascade_steps)
+        self.cascade_steps = cascade_steps
 
     def __call__(self, theta, phi, Phi_Theta_Psi=None, *delta):
         r"""Evaluate the angular correlation
@@ -319,8 +596,9 @@ class AngularCorrelation:
         assumed to be zero.
         If the list is longer than the number of cascade steps, the unnecessary deltas at the
         end of the list will be ignored.
-        Note that using the variable-length argument delta causes the creation of a new
-        AngularCorrelation object internally.
+        Note that using the variable-length argument delta changes the mixing ratios of the
+        internal AngularCorrelation object.
+        Only the parts of the expansion that depend on a changed mixing ratio are recalculated.
         This means that the following code raises no error if delta_1 is not equal to delta_2:
 
         ::
@@ -372,23 +650,16 @@ class AngularCorrelation:
                 delta_values = [d for d in delta]
 
             delta_values = (c_double * len(delta_values))(*delta_values)
-            self.angular_correlation = (
-                libangular_correlation.create_angular_correlation(
-                    self.n_cas_ste,
-                    self.two_J,
-                    self.par,
-                    self.em_char,
-                    self.two_L,
-                    self.em_charp,
-                    self.two_Lp,
-                    delta_values,
-                )
-            )
+            for i in range(self.n_cas_ste):
+                if delta_values[i] != self.delta[i]:
+                    libangular_correlation.set_angular_correlation_delta(
+                        self.angular_correlation, i, delta_values[i]
+                    )
             self.delta = delta_values
 
         return self.evaluate(theta, phi, Phi_Theta_Psi)
 
-    def evaluate(self, theta, phi, Phi_Theta_Psi):
+    def evaluate(self, theta, phi, Phi_Theta_Psi, delta=None):
         r"""Evaluate the angular correlation with scalar or numpy-array input
 
         This function implements a numpy-array compatible call of AngularCorrelation.
@@ -408,6 +679,12 @@ class AngularCorrelation:
             Azimuthal angle in spherical coordinates in radians (\f$\varphi \in \left[ 0, 2 \pi \right]\f$). If ndarray, must have the same shape as theta.
         Phi_Theta_Psi: (float, float, float)
             Euler angles \f$\Phi\f$, \f$\Theta\f$, and \f$\Psi\f$ in radians (default: None, i.e. no rotation).
+        delta: list of float
+            Multipole mixing ratios in the convention of Biedenharn, one for each cascade step
+            (default: None, i.e. use the mixing ratios given to the constructor).
+            As opposed to AngularCorrelation.__call__(), the internal AngularCorrelation object
+            is not recreated, and the mixing ratios of the object remain unchanged.
+            A rotation can not be combined with a change of the mixing ratios.
 
         Returns
         -------
@@ -416,7 +693,25 @@ class AngularCorrelation:
             correlation. If the values for theta and phi were scalars, a scalar will be returned.
             If at least one or both of theta and phi was a numpy array of shape (M, N, ...), a
             numpy array of shape (M, N, ...) will be returned.
+
+        Raises
+        ------
+        ValueError
+            If the number of mixing ratios does not match the number of cascade steps, or if
+            both mixing ratios and Euler angles are given.
         """
+        if delta is not None:
+            if len(delta) != self.n_cas_ste:
+                raise ValueError(
+                    "Number of multipole-mixing ratios ({:d}) does not match the number of cascade steps ({:d}).".format(
+                        len(delta), self.n_cas_ste
+                    )
+                )
+            if Phi_Theta_Psi is not None:
+                raise ValueError(
+                    "Rotations can not be combined with an evaluation for different multipole-mixing ratios."
+                )
+
         theta_reshape = None
         phi_reshape = None
         original_shape = None
@@ -454,7 +749,16 @@ class AngularCorrelation:
 
         size = len(theta_reshape)
         result = (c_double * size)()
-        if Phi_Theta_Psi is None:
+        if delta is not None:
+            libangular_correlation.evaluate_angular_correlation_with_deltas(
+                self.angular_correlation,
+                size,
+                (c_double * size)(*theta_reshape),
+                (c_double * size)(*phi_reshape),
+                (c_double * self.n_cas_ste)(*delta),
+                result,
+            )
+        elif Phi_Theta_Psi is None:
             libangular_correlation.evaluate_angular_correlation(
                 self.angular_correlation,
                 size,
@@ -475,19 +779,326 @@ class AngularCorrelation:
             return result[0]
         return np.reshape(np.array(result), original_shape)
 
+    def evaluate_grid(self, theta, phi, Phi_Theta_Psi=None):
+        r"""Evaluate the angular correlation on a grid of polar and azimuthal angles
+
+        On a grid of directions, the angular correlation separates into functions of
+        \f$\theta\f$ and \f$\varphi\f$, which are evaluated once per value of each angle by the
+        C++ code (see AngularCorrelation::evaluate_grid()).
+        This is much faster than an evaluation of AngularCorrelation.evaluate() on the arrays
+        created by np.meshgrid().
+
+        Parameters
+        ----------
+        theta: ndarray
+            Polar angles in spherical coordinates in radians, one-dimensional array of length M.
+        phi: ndarray
+            Azimuthal angles in spherical coordinates in radians, one-dimensional array of length
+            N.
+        Phi_Theta_Psi: (float, float, float)
+            Euler angles \f$\Phi\f$, \f$\Theta\f$, and \f$\Psi\f$ in radians (default: None, i.e.
+            no rotation).
+
+        Returns
+        -------
+        ndarray
+            Values of the angular correlation, array of shape (M, N). The element [i, j]
+            corresponds to theta[i] and phi[j], like the arrays of np.meshgrid(theta, phi,
+            indexing="ij").
+        """
+        theta = np.ravel(np.asarray(theta, dtype=float))
+        phi = np.ravel(np.asarray(phi, dtype=float))
+        n_theta = theta.size
+        n_phi = phi.size
+        result = (c_double * (n_theta * n_phi))()
+        libangular_correlation.evaluate_angular_correlation_grid(
+            self.angular_correlation,
+            n_theta,
+            (c_double * n_theta)(*theta),
+            n_phi,
+            (c_double * n_phi)(*phi),
+            None if Phi_Theta_Psi is None else (c_double * 3)(*Phi_Theta_Psi),
+            result,
+        )
+        return np.reshape(np.array(result), (n_theta, n_phi))
+
+    def scan_deltas(self, theta, phi, deltas):
+        r"""Evaluate the angular correlation for many sets of multipole mixing ratios
+
+        The mixing ratios are passed to the existing C++ object, which evaluates the polynomials
+        in the mixing ratios once per set and the angular dependence for all angles in a batch
+        (see AngularCorrelation::scan_deltas()).
+
+        Parameters
+        ----------
+        theta: float or ndarray
+            Polar angles in spherical coordinates in radians.
+        phi: float or ndarray
+            Azimuthal angles in spherical coordinates in radians. Broadcast against theta.
+        deltas: ndarray
+            Multipole mixing ratios, array of shape (N, n), where N is the number of sets of
+            mixing ratios and n the number of cascade steps.
+
+        Returns
+        -------
+        ndarray
+            Values of the angular correlation, array of shape (N,) + the broadcast shape of
+            theta and phi.
+
+        Raises
+        ------
+        ValueError
+            If the number of mixing ratios per set does not match the number of cascade steps.
+        """
+        deltas = np.asarray(deltas, dtype=float)
+        if deltas.ndim != 2 or deltas.shape[1] != self.n_cas_ste:
+            raise ValueError(
+                "Mixing ratios must be given as an array of shape (N, {:d}).".format(
+                    self.n_cas_ste
+                )
+            )
+        theta_b, phi_b = np.broadcast_arrays(
+            np.asarray(theta, dtype=float), np.asarray(phi, dtype=float)
+        )
+        n_deltas = deltas.shape[0]
+        n_angles = theta_b.size
+        result = (c_double * (n_deltas * n_angles))()
+        libangular_correlation.evaluate_angular_correlation_delta_scan(
+            self.angular_correlation,
+            n_deltas,
+            (c_double * deltas.size)(*deltas.ravel()),
+            n_angles,
+            (c_double * n_angles)(*theta_b.ravel()),
+            (c_double * n_angles)(*phi_b.ravel()),
+            result,
+        )
+        return np.reshape(np.array(result), (n_deltas,) + theta_b.shape)
+
+    def evaluate_with_gradient(self, theta, phi, delta):
+        r"""Evaluate the angular correlation and its gradient
+
+        The derivatives with respect to the angles and the multipole mixing ratios are
+        calculated analytically by the C++ code (see AngularCorrelation::evaluate_with_gradient()),
+        so they can be passed to gradient-based minimizers without finite differences.
+
+        Parameters
+        ----------
+        theta: float or ndarray
+            Polar angles in spherical coordinates in radians.
+        phi: float or ndarray
+            Azimuthal angles in spherical coordinates in radians. Broadcast against theta.
+        delta: list of float
+            Multipole mixing ratios, one for each cascade step.
+
+        Returns
+        -------
+        (ndarray, ndarray)
+            Values of the angular correlation with the broadcast shape of theta and phi, and
+            gradients with the same shape + (n + 2,), where n is the number of cascade steps.
+            The last axis contains the derivatives with respect to :math:`\theta`,
+            :math:`\varphi`, and the mixing ratios, in this order.
+
+        Raises
+        ------
+        ValueError
+            If the number of mixing ratios does not match the number of cascade steps.
+        """
+        if len(delta) != self.n_cas_ste:
+            raise ValueError(
+                "Number of multipole-mixing ratios ({:d}) does not match the number of cascade steps ({:d}).".format(
+                    len(delta), self.n_cas_ste
+                )
+            )
+        theta_b, phi_b = np.broadcast_arrays(
+            np.asarray(theta, dtype=float), np.asarray(phi, dtype=float)
+        )
+        n_angles = theta_b.size
+        result = (c_double * n_angles)()
+        gradient = (c_double * (n_angles * (self.n_cas_ste + 2)))()
+        libangular_correlation.evaluate_angular_correlation_with_gradient(
+            self.angular_correlation,
+            n_angles,
+            (c_double * n_angles)(*theta_b.ravel()),
+            (c_double * n_angles)(*phi_b.ravel()),
+            (c_double * self.n_cas_ste)(*delta),
+            result,
+            gradient,
+        )
+        return np.reshape(np.array(result), theta_b.shape), np.reshape(
+            np.array(gradient), theta_b.shape + (self.n_cas_ste + 2,)
+        )
+
+    def integrate_cone(self, theta, phi, opening_angle):
+        r"""Integrate the angular correlation over cones
+
+        The integral of a Legendre series over a cone around an arbitrary axis has a closed form,
+        which is evaluated by the C++ code (see AngularCorrelation::integrate_cone()).
+        Dividing the result by the solid angle
+        \f$2 \pi \left[ 1 - \cos \left( \alpha \right) \right]\f$ of the cone gives the mean
+        value of the angular correlation inside the cone.
+
+        Parameters
+        ----------
+        theta: float or ndarray
+            Polar angle of the axis of the cone in radians.
+        phi: float or ndarray
+            Azimuthal angle of the axis of the cone in radians.
+        opening_angle: float or ndarray
+            Opening angle (half angle) \f$\alpha\f$ of the cone in radians.
+
+        Returns
+        -------
+        float or ndarray
+            Integral of \f$W_{\gamma \gamma}\f$ over the cone(s). The array arguments are
+            broadcast against each other, and the result has the broadcast shape. If all
+            arguments were scalars, a scalar will be returned.
+        """
+        theta_b, phi_b, opening_angle_b = np.broadcast_arrays(
+            np.asarray(theta, dtype=float),
+            np.asarray(phi, dtype=float),
+            np.asarray(opening_angle, dtype=float),
+        )
+        size = theta_b.size
+        result = (c_double * size)()
+        libangular_correlation.integrate_angular_correlation_cone(
+            self.angular_correlation,
+            size,
+            (c_double * size)(*theta_b.ravel()),
+            (c_double * size)(*phi_b.ravel()),
+            (c_double * size)(*opening_angle_b.ravel()),
+            result,
+        )
+        if theta_b.ndim == 0:
+            return result[0]
+        return np.reshape(np.array(result), theta_b.shape)
+
+    def set_polarization_degree(self, P):
+        r"""Set the degree of linear polarization of the first photon
+
+        The polarization-dependent part of a pol-dir correlation is multiplied by \f$P\f$
+        (see AngularCorrelation::set_polarization_degree()).
+        This describes a partially polarized photon beam at the same cost as a completely
+        polarized one.
+
+        Parameters
+        ----------
+        P: float
+            Degree of polarization \f$P \in \left[ -1, 1 \right]\f$.
+
+        Raises
+        ------
+        ValueError
+            If the correlation is not a pol-dir correlation, or if \f$\left| P \right| > 1\f$.
+        """
+        if not libangular_correlation.set_angular_correlation_polarization_degree(
+            self.angular_correlation, P
+        ):
+            raise ValueError(
+                "The degree of polarization must be in the range [-1, 1], and it can "
+                "only be set for a pol-dir correlation."
+            )
+
+    def __getstate__(self):
+        """Return the state of the object for pickling
+
+        The internal C++ object is serialized (see AngularCorrelation::serialize()), so that
+        unpickling restores it without recalculating any coefficient.
+        This makes it cheap to send angular correlations to the worker processes of
+        multiprocessing, concurrent.futures, or Dask.
+
+        Returns
+        -------
+        dict
+            Attributes of the object, with ctypes arrays converted to lists, and the serialized
+            C++ object.
+        """
+        state = {}
+        ctypes_arrays = {}
+        for key, value in self.__dict__.items():
+            if key in ("handle", "angular_correlation"):
+                continue
+            if isinstance(value, Array):
+                ctypes_arrays[key] = (value._type_, list(value))
+            else:
+                state[key] = value
+        state["ctypes_arrays"] = ctypes_arrays
+
+        size = libangular_correlation.serialize_angular_correlation(
+            self.angular_correlation, None, 0
+        )
+        buffer = create_string_buffer(size)
+        libangular_correlation.serialize_angular_correlation(
+            self.angular_correlation, buffer, size
+        )
+        state["serialized"] = buffer.raw
+        return state
+
+    def __setstate__(self, state):
+        """Restore the object from the output of AngularCorrelation.__getstate__()
+
+        Parameters
+        ----------
+        state: dict
+            Output of AngularCorrelation.__getstate__().
+
+        Raises
+        ------
+        ValueError
+            If the serialized C++ object is invalid (see AngularCorrelation::deserialize()).
+        """
+        state = dict(state)
+        serialized = state.pop("serialized")
+        for key, (ctype, values) in state.pop("ctypes_arrays").items():
+            state[key] = (ctype * len(values))(*values)
+        self.__dict__.update(state)
+
+        self.handle = 0
+        self.angular_correlation = None
+        self._set_handle(
+            libangular_correlation.deserialize_angular_correlation_handle(
+                serialized, len(serialized)
+            )
+        )
+        if not self.handle:
+            raise ValueError("Invalid serialized angular correlation.")
+
+    def _set_handle(self, handle):
+        """Replace the internal AngularCorrelation object
+
+        The C++ object is owned by the handle table of the C interface.
+        This class holds one reference to it, which is released when the object is replaced,
+        freed, or garbage collected.
+
+        Parameters
+        ----------
+        handle: int
+            Handle of the new object, or 0 if the creation failed.
+        """
+        self.free()
+        self.handle = handle
+        if handle:
+            self.angular_correlation = (
+                libangular_correlation.get_angular_correlation_from_handle(handle)
+            )
+
     def free(self):
-        """Free the memory occupied by the internal AngularCorrelation object
-
-        Since the AngularCorrelation C++ object owned by this class is a raw pointer, it needs to
-        be deleted explicitly to prevent significant memory leaking when many AngularCorrelation
-        objects are created (for example in the AnalyzingPower.evaluate method of the
-        corresponding module).
-        This function initiates the deletion of the pointer to the object in the C++ code (via a
-        'delete' statement).
+        """Release the internal AngularCorrelation object
+
+        The memory is released automatically when this object is garbage collected, so an
+        explicit call is only needed to release it earlier.
+        Calling this function more than once is safe, since the C interface ignores handles of
+        objects that do not exist any more.
         The AngularCorrelation object can not be used to calculate angular correlations any more
         after calling AngularCorrelation.free().
         """
-        libangular_correlation.free_angular_correlation(self.angular_correlation)
+        # The library may already be unloaded when the interpreter exits.
+        if getattr(self, "handle", 0) and libangular_correlation is not None:
+            libangular_correlation.release_angular_correlation_handle(self.handle)
+        self.handle = 0
+        self.angular_correlation = None
+
+    def __del__(self):
+        self.free()
 
 
 libangular_correlation.angular_correlation.restype = c_double
@@ -542,3 +1153,277 @@ def angular_correlation(theta, phi, initial_state, cascade_steps, Phi_Theta_Psi=
         delta,
         (c_double * 3)(*Phi_Theta_Psi),
     )
+
+
+libangular_correlation.evaluate_angular_correlations.restype = c_int
+libangular_correlation.evaluate_angular_correlations.argtypes = [
+    c_size_t,  # Number of cascades
+    POINTER(c_size_t),  # Offsets of the cascade steps of each cascade
+    POINTER(c_int),  # Angular momenta
+    POINTER(c_short),  # Parities
+    POINTER(c_short),  # EM characters
+    POINTER(c_int),  # Multipolarities
+    POINTER(c_short),  # Alternative EM characters
+    POINTER(c_int),  # Alternative multipolarities
+    POINTER(c_double),  # Multipole mixing ratios
+    c_size_t,  # Number of angles
+    POINTER(c_double),  # Polar angle theta
+    POINTER(c_double),  # Azimuthal angle phi
+    POINTER(c_double),  # Array that contains the results
+]
+
+
+def validate_cascade(initial_state, cascade_steps):
+    r"""Check the consistency of a cascade without constructing an angular correlation
+
+    Performs the same checks as the constructor of AngularCorrelation, but reports the result
+    instead of raising an error.
+
+    Parameters
+    ----------
+    initial_state: State
+        Initial state of the cascade.
+    cascade_steps: array of [Transition, State] pairs or array of State objects
+        Cascade steps, in the same format as for the constructor of AngularCorrelation.
+
+    Returns
+    -------
+    (int, str)
+        Status code, which is 0 for a valid cascade (see the CascadeStatus enum of the C++
+        code), and the error message, which is empty for a valid cascade.
+    """
+    n_cas_ste = len(cascade_steps)
+    em_char, two_L, em_charp, two_Lp = None, None, None, None
+
+    if n_cas_ste > 0 and isinstance(cascade_steps[0], State):
+        states = [initial_state] + list(cascade_steps)
+    else:
+        states = [initial_state] + [cas_ste[1] for cas_ste in cascade_steps]
+        transitions = [cas_ste[0] for cas_ste in cascade_steps]
+        em_char = (c_short * n_cas_ste)(*[t.em_char for t in transitions])
+        two_L = (c_int * n_cas_ste)(*[t.two_L for t in transitions])
+        em_charp = (c_short * n_cas_ste)(*[t.em_charp for t in transitions])
+        two_Lp = (c_int * n_cas_ste)(*[t.two_Lp for t in transitions])
+
+    two_J = (c_int * len(states))(*[state.two_J for state in states])
+    par = (c_short * len(states))(*[state.parity for state in states])
+
+    message = create_string_buffer(MESSAGE_LENGTH)
+    status = libangular_correlation.validate_cascade(
+        n_cas_ste,
+        two_J,
+        par,
+        em_char,
+        two_L,
+        em_charp,
+        two_Lp,
+        MESSAGE_LENGTH,
+        message,
+    )
+    return status, message.value.decode()
+
+
+def create_angular_correlations(cascades):
+    r"""Construct the angular correlations of many cascades at once
+
+    All cascades are passed to the C++ code in a single call, which constructs them in parallel
+    (see create_angular_correlation_handles() in the C interface).
+    The W_dir_dir and W_pol_dir objects of all cascades share a single block of memory, which is
+    released when the last of them has been freed.
+
+    Parameters
+    ----------
+    cascades: list of (State, array of [Transition, State] pairs or array of State objects)
+        Initial states and cascade steps of the cascades, in the same format as for the
+        constructor of AngularCorrelation.
+        Either all or none of the cascades must be given as State objects.
+
+    Returns
+    -------
+    list of AngularCorrelation
+        Angular correlations.
+
+    Raises
+    ------
+    ValueError
+        If the formats of the cascades are mixed, or if any cascade is invalid (see
+        validate_cascade()). In this case, no angular correlation is created.
+    """
+    if not cascades:
+        return []
+
+    inference = [isinstance(cascade_steps[0], State) for _, cascade_steps in cascades]
+    if any(inference) != all(inference):
+        raise ValueError(
+            "Either all or none of the cascades must be given as State objects."
+        )
+
+    arrays = [
+        _cascade_arrays(initial_state, cascade_steps)
+        for initial_state, cascade_steps in cascades
+    ]
+    offsets = [0]
+    for _, cascade_steps in cascades:
+        offsets.append(offsets[-1] + len(cascade_steps))
+
+    def concatenate(i, ctype):
+        if arrays[0][i] is None:
+            return None
+        values = [value for array in arrays for value in array[i]]
+        return (ctype * len(values))(*values)
+
+    n = len(cascades)
+    handles = (c_uint64 * n)()
+    status = libangular_correlation.create_angular_correlation_handles(
+        n,
+        (c_size_t * (n + 1))(*offsets),
+        concatenate(0, c_int),
+        concatenate(1, c_short),
+        concatenate(2, c_short),
+        concatenate(3, c_int),
+        concatenate(4, c_short),
+        concatenate(5, c_int),
+        concatenate(6, c_double),
+        handles,
+    )
+    if status:
+        libangular_correlation.release_angular_correlation_handles(n, handles)
+        index = [handle for handle in handles].index(0)
+        raise ValueError(
+            "Cascade {:d}: {}".format(index, validate_cascade(*cascades[index])[1])
+        )
+
+    result = []
+    for (initial_state, cascade_steps), handle in zip(cascades, handles):
+        ang_cor = AngularCorrelation.__new__(AngularCorrelation)
+        ang_cor.handle = 0
+        ang_cor.angular_correlation = None
+        ang_cor._set_handle(handle)
+        ang_cor._set_cascade(initial_state, cascade_steps)
+        result.append(ang_cor)
+    return result
+
+
+def free_angular_correlations(angular_correlations):
+    r"""Release the internal objects of many angular correlations at once
+
+    Has the same effect as calling AngularCorrelation.free() for each element, but with a single
+    call of the C interface.
+
+    Parameters
+    ----------
+    angular_correlations: list of AngularCorrelation
+        Angular correlations.
+    """
+    handles = [ang_cor.handle for ang_cor in angular_correlations if ang_cor.handle]
+    libangular_correlation.release_angular_correlation_handles(
+        len(handles), (c_uint64 * len(handles))(*handles)
+    )
+    for ang_cor in angular_correlations:
+        ang_cor.handle = 0
+        ang_cor.angular_correlation = None
+
+
+def angular_correlations(theta, phi, cascades):
+    r"""Evaluate the angular correlations of many cascades at once
+
+    All cascades are packed into flat arrays and passed to the C++ code together with all
+    angles, so that the evaluation of an entire table of hypotheses requires a single call.
+    The cascade steps of cascade \f$k\f$ are the elements offsets[k] to offsets[k+1] - 1 of
+    the arrays for the transitions, and its states, starting with the initial state, are the
+    elements offsets[k] + k to offsets[k+1] + k of the arrays for the states.
+
+    Parameters
+    ----------
+    theta: float or ndarray
+        Polar angles in spherical coordinates in radians.
+    phi: float or ndarray
+        Azimuthal angles in spherical coordinates in radians. Broadcast against theta.
+    cascades: list of (State, array of [Transition, State] pairs)
+        Initial states and cascade steps of the cascades, in the same format as for the
+        constructor of AngularCorrelation.
+
+    Returns
+    -------
+    ndarray
+        Values of the angular correlations, array of shape (K,) + the broadcast shape of theta
+        and phi, where K is the number of cascades.
+        The values for invalid cascades are NaN.
+    """
+    theta_b, phi_b = np.broadcast_arrays(
+        np.asarray(theta, dtype=float), np.asarray(phi, dtype=float)
+    )
+    theta_flat = np.ascontiguousarray(theta_b.ravel())
+    phi_flat = np.ascontiguousarray(phi_b.ravel())
+
+    offsets = np.zeros(len(cascades) + 1, dtype=np.uintp)
+    offsets[1:] = np.cumsum([len(cascade_steps) for _, cascade_steps in cascades])
+    states = [
+        state
+        for initial_state, cascade_steps in cascades
+        for state in [initial_state] + [cas_ste[1] for cas_ste in cascade_steps]
+    ]
+    transitions = [
+        cas_ste[0] for _, cascade_steps in cascades for cas_ste in cascade_steps
+    ]
+
+    two_J = np.array([state.two_J for state in states], dtype=np.intc)
+    par = np.array([state.parity for state in states], dtype=np.short)
+    em_char = np.array([t.em_char for t in transitions], dtype=np.short)
+    two_L = np.array([t.two_L for t in transitions], dtype=np.intc)
+    em_charp = np.array([t.em_charp for t in transitions], dtype=np.short)
+    two_Lp = np.array([t.two_Lp for t in transitions], dtype=np.intc)
+    delta = np.array([t.delta for t in transitions], dtype=float)
+
+    result = np.empty((len(cascades), theta_flat.size))
+    libangular_correlation.evaluate_angular_correlations(
+        len(cascades),
+        offsets.ctypes.data_as(POINTER(c_size_t)),
+        two_J.ctypes.data_as(POINTER(c_int)),
+        par.ctypes.data_as(POINTER(c_short)),
+        em_char.ctypes.data_as(POINTER(c_short)),
+        two_L.ctypes.data_as(POINTER(c_int)),
+        em_charp.ctypes.data_as(POINTER(c_short)),
+        two_Lp.ctypes.data_as(POINTER(c_int)),
+        delta.ctypes.data_as(POINTER(c_double)),
+        theta_flat.size,
+        theta_flat.ctypes.data_as(POINTER(c_double)),
+        phi_flat.ctypes.data_as(POINTER(c_double)),
+        result.ctypes.data_as(POINTER(c_double)),
+    )
+    return np.reshape(result, (len(cascades),) + theta_b.shape)
+
+
+libangular_correlation.get_n_threads.restype = c_uint
+libangular_correlation.set_n_threads.argtypes = [
+    c_uint,  # Number of threads
+]
+
+
+def get_n_threads():
+    r"""Number of threads of the batch evaluations
+
+    Returns
+    -------
+    int
+        Number of threads, including the calling thread (see ThreadPool in the C++ code).
+    """
+    return libangular_correlation.get_n_threads()
+
+
+def set_n_threads(n_threads):
+    r"""Set the number of threads of the batch evaluations
+
+    The evaluation of an AngularCorrelation, and the function angular_correlations(), divide
+    large arrays of angles or cascades among a process-wide pool of threads.
+    The initial number of threads is given by the environment variable ALPACA_NUM_THREADS or,
+    if it is not set, by the number of concurrent threads supported by the hardware.
+
+    Parameters
+    ----------
+    n_threads: int
+        Number of threads, including the calling thread. A value of 1 disables the
+        parallelization, and a value of 0 selects the number of concurrent threads supported
+        by the hardware.
+    """
+    libangular_correlation.set_n_threads(n_threads)
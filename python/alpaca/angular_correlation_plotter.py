@@ -28,12 +28,14 @@ class AngularCorrelationPlotter:
         self, axis, Phi_Theta_Psi=None, n_points_per_dimension=100, max_abs_value=2.0
     ):
 
-        theta, phi = np.meshgrid(
-            np.linspace(0.0, np.pi, n_points_per_dimension),
-            np.linspace(0.0, 2.0 * np.pi, n_points_per_dimension),
-        )
-
-        ang_cor = self.angular_correlation(theta, phi, Phi_Theta_Psi=Phi_Theta_Psi)
+        theta_axis = np.linspace(0.0, np.pi, n_points_per_dimension)
+        phi_axis = np.linspace(0.0, 2.0 * np.pi, n_points_per_dimension)
+        theta, phi = np.meshgrid(theta_axis, phi_axis)
+
+        # The grid of np.meshgrid() has the shape (phi, theta).
+        ang_cor = self.angular_correlation.evaluate_grid(
+            theta_axis, phi_axis, Phi_Theta_Psi=Phi_Theta_Psi
+        ).T
 
         sine_theta = np.sin(theta)
         x = ang_cor * sine_theta * np.cos(phi)
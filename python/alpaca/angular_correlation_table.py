@@ -37,6 +37,10 @@ class AngularCorrelationTable:
 
         table = ""
 
+        # Evaluate all combinations of angles at once. The functions of theta and
+        # phi are evaluated only once per angle.
+        w = self.angular_correlation.evaluate_grid(theta, phi)
+
         for i in range(len(theta)):
             for j in range(len(phi)):
                 table += (
@@ -52,7 +56,7 @@ class AngularCorrelationTable:
                         else phi_labels[j]
                     )
                     + " {} ".format(separator)
-                    + number_format.format(self.angular_correlation(theta[i], phi[j]))
+                    + number_format.format(w[i][j])
                     + endline
                     + "\n"
                 )
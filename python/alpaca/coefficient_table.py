@@ -0,0 +1,328 @@
+# This file is part of alpaca.
+
+# alpaca is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# alpaca is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+# Copyright (C) 2021-2023 Udo Friman-Gayer
+
+from ctypes import (
+    c_char_p,
+    c_double,
+    c_int,
+    c_short,
+    c_size_t,
+    c_void_p,
+    create_string_buffer,
+    POINTER,
+)
+
+import fcntl
+import os
+
+import numpy as np
+
+from .angular_correlation import (
+    AngularCorrelation,
+    libangular_correlation,
+    MESSAGE_LENGTH,
+)
+from .state import State
+from .transition import Transition
+
+libangular_correlation.write_coefficient_table.restype = c_int
+libangular_correlation.write_coefficient_table.argtypes = [
+    c_char_p,  # File name
+    c_size_t,  # Number of angular correlations
+    POINTER(c_void_p),  # Pointers to AngularCorrelation objects
+    c_size_t,  # Length of the buffer for the error message
+    c_char_p,  # Buffer for the error message
+]
+
+libangular_correlation.open_coefficient_table.restype = c_void_p
+libangular_correlation.open_coefficient_table.argtypes = [
+    c_char_p,  # File name
+    c_size_t,  # Length of the buffer for the error message
+    c_char_p,  # Buffer for the error message
+]
+
+libangular_correlation.free_coefficient_table.argtypes = [
+    c_void_p,  # Pointer to CoefficientTable object
+]
+
+libangular_correlation.coefficient_table_size.restype = c_size_t
+libangular_correlation.coefficient_table_size.argtypes = [
+    c_void_p,  # Pointer to CoefficientTable object
+]
+
+libangular_correlation.coefficient_table_n_cascade_steps.restype = c_size_t
+libangular_correlation.coefficient_table_n_cascade_steps.argtypes = [
+    c_void_p,  # Pointer to CoefficientTable object
+    c_size_t,  # Index of the entry
+]
+
+libangular_correlation.get_coefficient_table_cascade.restype = c_int
+libangular_correlation.get_coefficient_table_cascade.argtypes = [
+    c_void_p,  # Pointer to CoefficientTable object
+    c_size_t,  # Index of the entry
+    POINTER(c_int),  # Angular momenta
+    POINTER(c_short),  # Parities
+    POINTER(c_short),  # EM characters
+    POINTER(c_int),  # Multipolarities
+    POINTER(c_short),  # Alternative EM characters
+    POINTER(c_int),  # Alternative multipolarities
+    POINTER(c_double),  # Multipole mixing ratios
+]
+
+libangular_correlation.evaluate_coefficient_table.restype = c_int
+libangular_correlation.evaluate_coefficient_table.argtypes = [
+    c_void_p,  # Pointer to CoefficientTable object
+    c_size_t,  # Index of the entry
+    c_size_t,  # Number of angles
+    POINTER(c_double),  # Polar angle theta
+    POINTER(c_double),  # Azimuthal angle phi
+    POINTER(c_double),  # Array that contains the results
+]
+
+
+def write_coefficient_table(file_name, angular_correlations):
+    r"""Store the expansion coefficients of many angular correlations in a file
+
+    The file can be opened with CoefficientTable to evaluate the angular correlations without
+    recalculating their coefficients (see CoefficientTable::write()).
+
+    Parameters
+    ----------
+    file_name: str
+        Name of the file. An existing file is replaced atomically, i.e. processes that
+        open the file at the same time see either the old or the new table.
+    angular_correlations: list of AngularCorrelation
+        Angular correlations.
+
+    Raises
+    ------
+    OSError
+        If the file can not be written.
+    """
+    n = len(angular_correlations)
+    pointers = (c_void_p * n)(
+        *[ang_cor.angular_correlation for ang_cor in angular_correlations]
+    )
+    message = create_string_buffer(MESSAGE_LENGTH)
+    if libangular_correlation.write_coefficient_table(
+        file_name.encode(), n, pointers, MESSAGE_LENGTH, message
+    ):
+        raise OSError(message.value.decode())
+
+
+class CoefficientTable:
+    r"""Precomputed angular correlations, evaluated directly from a memory-mapped file
+
+    Wrapper for the CoefficientTable class of the C++ code.
+    The file is mapped into memory by the constructor and stays mapped until close() is called
+    or the object is garbage collected.
+    The mapping is read-only and shared, so processes that open the same file share a single
+    copy of the coefficients in the page cache.
+    A file in '/dev/shm' is a POSIX shared-memory object.
+    """
+
+    def __init__(self, file_name, build=None):
+        r"""Open a file that was written by write_coefficient_table()
+
+        If a function build is given and the file does not exist, the table is written with the
+        angular correlations returned by build().
+        The check is protected by a lock on the file file_name + '.lock', so if several
+        processes open the same file at the same time, only one of them calls build(), and the
+        others wait for it and map the result.
+
+        Parameters
+        ----------
+        file_name: str
+            Name of the file.
+        build: callable or None
+            Function without arguments that returns a list of AngularCorrelation objects
+            (default: None).
+
+        Raises
+        ------
+        OSError
+            If the file can not be opened, or if it is not a valid table.
+        """
+        if build is not None and not os.path.exists(file_name):
+            with open(file_name + ".lock", "a") as lock:
+                fcntl.flock(lock, fcntl.LOCK_EX)
+                if not os.path.exists(file_name):
+                    write_coefficient_table(file_name, build())
+
+        message = create_string_buffer(MESSAGE_LENGTH)
+        self.coefficient_table = libangular_correlation.open_coefficient_table(
+            file_name.encode(), MESSAGE_LENGTH, message
+        )
+        if not self.coefficient_table:
+            raise OSError(message.value.decode())
+        self.size = libangular_correlation.coefficient_table_size(
+            self.coefficient_table
+        )
+
+    def __len__(self):
+        return self.size
+
+    def check_index(self, index):
+        if self.coefficient_table is None:
+            raise ValueError("The coefficient table has been closed.")
+        if index < 0 or index >= self.size:
+            raise IndexError(
+                "Index {:d} is out of range for a table with {:d} entries.".format(
+                    index, self.size
+                )
+            )
+
+    def __call__(self, index, theta, phi):
+        r"""Evaluate an angular correlation of the table
+
+        Parameters
+        ----------
+        index: int
+            Index of the angular correlation.
+        theta: float or ndarray
+            Polar angle in spherical coordinates in radians.
+        phi: float or ndarray
+            Azimuthal angle in spherical coordinates in radians.
+
+        Returns
+        -------
+        float or ndarray
+            \f$W_{\gamma \gamma} \left( \theta, \varphi \right)\f$. The array arguments are
+            broadcast against each other, and the result has the broadcast shape. If both
+            arguments were scalars, a scalar will be returned.
+
+        Raises
+        ------
+        IndexError
+            If the index is out of range.
+        """
+        self.check_index(index)
+        theta_b, phi_b = np.broadcast_arrays(
+            np.asarray(theta, dtype=float), np.asarray(phi, dtype=float)
+        )
+        size = theta_b.size
+        result = (c_double * size)()
+        if not libangular_correlation.evaluate_coefficient_table(
+            self.coefficient_table,
+            index,
+            size,
+            (c_double * size)(*theta_b.ravel()),
+            (c_double * size)(*phi_b.ravel()),
+            result,
+        ):
+            raise IndexError("Index {:d} is out of range.".format(index))
+        if theta_b.ndim == 0:
+            return result[0]
+        return np.reshape(np.array(result), theta_b.shape)
+
+    def cascade(self, index):
+        r"""Return the cascade of an angular correlation of the table
+
+        Parameters
+        ----------
+        index: int
+            Index of the angular correlation.
+
+        Returns
+        -------
+        (State, list of [Transition, State] pairs)
+            Initial state and cascade steps.
+
+        Raises
+        ------
+        IndexError
+            If the index is out of range.
+        ValueError
+            If the entry contains invalid quantum numbers.
+        """
+        self.check_index(index)
+        n_cas_ste = libangular_correlation.coefficient_table_n_cascade_steps(
+            self.coefficient_table, index
+        )
+        if n_cas_ste == 0:
+            raise ValueError(
+                "Entry {:d} contains invalid quantum numbers.".format(index)
+            )
+        two_J = (c_int * (n_cas_ste + 1))()
+        par = (c_short * (n_cas_ste + 1))()
+        em_char = (c_short * n_cas_ste)()
+        two_L = (c_int * n_cas_ste)()
+        em_charp = (c_short * n_cas_ste)()
+        two_Lp = (c_int * n_cas_ste)()
+        delta = (c_double * n_cas_ste)()
+        if not libangular_correlation.get_coefficient_table_cascade(
+            self.coefficient_table,
+            index,
+            two_J,
+            par,
+            em_char,
+            two_L,
+            em_charp,
+            two_Lp,
+            delta,
+        ):
+            raise ValueError(
+                "Entry {:d} contains invalid quantum numbers.".format(index)
+            )
+        return State(two_J[0], par[0]), [
+            [
+                Transition(em_char[i], two_L[i], em_charp[i], two_Lp[i], delta[i]),
+                State(two_J[i + 1], par[i + 1]),
+            ]
+            for i in range(n_cas_ste)
+        ]
+
+    def angular_correlation(self, index):
+        r"""Construct the full angular correlation of an entry of the table
+
+        This recalculates all coefficients.
+
+        Parameters
+        ----------
+        index: int
+            Index of the angular correlation.
+
+        Returns
+        -------
+        AngularCorrelation
+
+        Raises
+        ------
+        IndexError
+            If the index is out of range.
+        """
+        return AngularCorrelation(*self.cascade(index))
+
+    def close(self):
+        """Unmap the file
+
+        The file is unmapped automatically when this object is garbage collected, so an explicit
+        call is only needed to unmap it earlier.
+        Calling this function more than once is safe.
+        The table can not be used any more after calling CoefficientTable.close().
+        """
+        # The constructor may have failed before the file was mapped, and the library may
+        # already be unloaded when the interpreter exits.
+        if (
+            getattr(self, "coefficient_table", None) is not None
+            and libangular_correlation is not None
+        ):
+            libangular_correlation.free_coefficient_table(self.coefficient_table)
+        self.coefficient_table = None
+
+    def __del__(self):
+        self.close()
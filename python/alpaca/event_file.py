@@ -0,0 +1,176 @@
+# This file is part of alpaca.
+
+# alpaca is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# alpaca is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+# Copyright (C) 2021-2023 Udo Friman-Gayer
+
+import os
+
+import numpy as np
+
+FORMAT_VERSION = 1
+BYTE_ORDER_MARK = 0x01020304
+
+HEADER_DTYPE = np.dtype(
+    [
+        ("magic", "S8"),
+        ("version", "=u4"),
+        ("byte_order", "=u4"),
+        ("n_steps", "=u4"),
+        ("n_components", "=u4"),
+        ("weighted", "=u4"),
+        ("reserved", "=u4"),
+        ("chunk_size", "=u8"),
+        ("n_events", "=u8"),
+        ("file_size", "=u8"),
+        ("data_offset", "=u8"),
+    ]
+)
+
+
+class EventFile:
+    r"""Memory-mapped view of an event file written by EventFileWriter
+
+    See the documentation of the event_file namespace of the C++ code for the format.
+    The data section is mapped into memory as an array `chunks` of doubles with the shape
+    (n_chunks, n_columns, chunk_size), i.e. nothing is read until it is accessed.
+    Column n_components*i + j contains component j of step i, and the last column contains
+    the weights if the file is weighted.
+    """
+
+    def __init__(self, file_name):
+        r"""Open an event file
+
+        Parameters
+        ----------
+        file_name: str
+            Name of the file.
+
+        Raises
+        ------
+        OSError
+            If the file is not a complete event file of the current format version.
+        """
+        header = np.fromfile(file_name, dtype=HEADER_DTYPE, count=1)
+        if len(header) == 0 or header["magic"][0] != b"ALPACAEV":
+            raise OSError("File '{}' is not an event file.".format(file_name))
+        header = header[0]
+        if header["byte_order"] != BYTE_ORDER_MARK:
+            raise OSError(
+                "File '{}' was written on a machine with a different byte order.".format(
+                    file_name
+                )
+            )
+        if header["version"] != FORMAT_VERSION:
+            raise OSError(
+                "File '{}' has the unsupported format version {:d}.".format(
+                    file_name, header["version"]
+                )
+            )
+
+        self.n_steps = int(header["n_steps"])
+        self.n_components = int(header["n_components"])
+        self.weighted = bool(header["weighted"])
+        self.chunk_size = int(header["chunk_size"])
+        self.n_events = int(header["n_events"])
+        self.n_columns = self.n_steps * self.n_components + int(self.weighted)
+        self.n_chunks = -(-self.n_events // self.chunk_size)
+
+        data_offset = int(header["data_offset"])
+        if (
+            header["file_size"] != os.path.getsize(file_name)
+            or header["file_size"]
+            != data_offset + 8 * self.n_chunks * self.n_columns * self.chunk_size
+        ):
+            raise OSError("File '{}' is truncated or corrupt.".format(file_name))
+
+        if self.n_chunks > 0:
+            self.chunks = np.memmap(
+                file_name,
+                dtype=np.float64,
+                mode="r",
+                offset=data_offset,
+                shape=(self.n_chunks, self.n_columns, self.chunk_size),
+            )
+        else:
+            self.chunks = np.empty((0, self.n_columns, self.chunk_size))
+
+    def __len__(self):
+        return self.n_events
+
+    def column(self, index):
+        r"""Values of a column for all events
+
+        Parameters
+        ----------
+        index: int
+            Index of the column.
+
+        Returns
+        -------
+        ndarray
+            Array of length n_events. For a file with a single chunk, this is a view of the
+            mapped file. Otherwise, the values of the chunks are copied into a new array.
+            Use `chunks[:, index, :]` to access the columns of all chunks without copying.
+        """
+        if index < 0 or index >= self.n_columns:
+            raise IndexError(
+                "Column {:d} is out of range for a file with {:d} columns.".format(
+                    index, self.n_columns
+                )
+            )
+        return self.chunks[:, index, :].reshape(-1)[: self.n_events]
+
+    def values(self, step, component):
+        r"""Component of a step for all events
+
+        See column().
+
+        Parameters
+        ----------
+        step: int
+            Index of the step.
+        component: int
+            Index of the component, for example 0, 1, and 2 for the Euler angles Phi, Theta,
+            and Psi of a CascadeSampler.
+
+        Returns
+        -------
+        ndarray
+            Array of length n_events.
+        """
+        if step < 0 or step >= self.n_steps:
+            raise IndexError("Step {:d} is out of range.".format(step))
+        if component < 0 or component >= self.n_components:
+            raise IndexError("Component {:d} is out of range.".format(component))
+        return self.column(self.n_components * step + component)
+
+    def weights(self):
+        r"""Weights of all events
+
+        See column().
+
+        Returns
+        -------
+        ndarray
+            Array of length n_events.
+
+        Raises
+        ------
+        ValueError
+            If the file has no weights.
+        """
+        if not self.weighted:
+            raise ValueError("The event file has no weights.")
+        return self.column(self.n_columns - 1)
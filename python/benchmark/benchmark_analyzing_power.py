@@ -0,0 +1,112 @@
+
+# Benchmarks of the python workflows to find multipole mixing ratios from measured asymmetries,
+# from the evaluation of the analyzing power on a grid of mixing ratios to the inversion.
+# Usage (in ALPACA_BUILD_DIR/python): python3 -m benchmark.benchmark_analyzing_power [MIN_TIME]
+
+import numpy as np
+
+from alpaca.analyzing_power import AnalyzingPower, arctan_grid
+from alpaca.angular_correlation import AngularCorrelation
+from alpaca.inversion_by_grid_evaluation import invert_grid
+from alpaca.state import NEGATIVE, POSITIVE, State
+from alpaca.transition import ELECTRIC, MAGNETIC, Transition
+
+from .harness import init, run
+
+# The piecewise interpolation requires scipy.
+try:
+    from alpaca.inversion_by_piecewise_interpolation import interpolate_and_invert
+except ImportError:
+    interpolate_and_invert = None
+
+INITIAL_STATE = State(0, POSITIVE)
+CASCADE_STEPS = [
+    [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.0), State(2, NEGATIVE)],
+    [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.0), State(4, POSITIVE)],
+]
+
+
+def main():
+    init()
+
+    ana_pow = AnalyzingPower(AngularCorrelation(INITIAL_STATE, CASCADE_STEPS))
+
+    # Evaluation on grids of mixing ratios. A callable in delta_values is evaluated by a python
+    # loop over the grid.
+    for n in (101, 10001):
+        delta = arctan_grid(n)
+        run(
+            "AnalyzingPower.evaluate",
+            "n={:d}".format(n),
+            n,
+            lambda: ana_pow.evaluate(delta, [0.0, "delta"]),
+        )
+        run(
+            "AnalyzingPower.evaluate",
+            "n={:d},callable".format(n),
+            n,
+            lambda: ana_pow.evaluate(delta, ["delta", lambda x: -x]),
+        )
+
+    # Evaluation for many detector angles at once.
+    delta = arctan_grid(101)
+    theta = np.linspace(0.1, np.pi - 0.1, 64)
+    run(
+        "AnalyzingPower.evaluate",
+        "n=101,n_theta=64",
+        101 * len(theta),
+        lambda: ana_pow.evaluate(delta, [0.0, "delta"], theta),
+    )
+
+    # Inversion of a measured asymmetry. The items are the grid points for the inversion on a
+    # grid, and the measured asymmetries for the inversion without a grid.
+    for n in (101, 10001):
+        delta = arctan_grid(n)
+        asymmetry = ana_pow.evaluate(delta, [0.0, "delta"])
+        run(
+            "invert_grid",
+            "n={:d}".format(n),
+            n,
+            lambda: invert_grid(delta, asymmetry, [-0.5, -0.4], return_intervals=True),
+        )
+        if interpolate_and_invert is not None:
+            run(
+                "interpolate_and_invert",
+                "n={:d}".format(n),
+                n,
+                lambda: interpolate_and_invert(delta, asymmetry)(-0.45),
+            )
+    run(
+        "AnalyzingPower.invert",
+        "",
+        1,
+        lambda: ana_pow.invert([-0.5, -0.4], [0.0, "delta"]),
+    )
+
+    # End-to-end workflow of a Monte-Carlo propagation of the uncertainty of an asymmetry (see
+    # also test/test_memory_leak.py): construction of the angular correlation, evaluation on a
+    # grid, and inversion for a random asymmetry.
+    random_asymmetries = np.random.default_rng(0).normal(-0.45, 0.05, 1000000)
+    index = [0]
+
+    def workflow():
+        delta = arctan_grid(101)
+        asymmetry = AnalyzingPower(
+            AngularCorrelation(INITIAL_STATE, CASCADE_STEPS)
+        ).evaluate(delta, [0.0, "delta"])
+        index[0] = (index[0] + 1) % len(random_asymmetries)
+        measured = random_asymmetries[index[0]]
+        if interpolate_and_invert is not None:
+            return interpolate_and_invert(delta, asymmetry)(measured)
+        return invert_grid(delta, asymmetry, measured)
+
+    run(
+        "mixing_ratio_from_asymmetry",
+        "n=101" if interpolate_and_invert is not None else "n=101,grid",
+        1,
+        workflow,
+    )
+
+
+if __name__ == "__main__":
+    main()
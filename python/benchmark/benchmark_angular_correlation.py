@@ -0,0 +1,115 @@
+
+# Benchmarks of the python bindings of AngularCorrelation.
+# In contrast to benchmark/benchmark_angular_correlation.cc, the measured times include the
+# conversion of python objects and numpy arrays to ctypes arrays, and the overhead of the calls
+# of the C interface.
+# Usage (in ALPACA_BUILD_DIR/python): python3 -m benchmark.benchmark_angular_correlation [MIN_TIME]
+
+import numpy as np
+
+from alpaca.angular_correlation import AngularCorrelation, angular_correlations
+from alpaca.state import NEGATIVE, POSITIVE, State
+from alpaca.transition import ELECTRIC, MAGNETIC, Transition
+
+from .harness import init, run
+
+
+def cascade(two_J, n_steps):
+    """Dir-dir cascade with n_steps dipole transitions of increasing spin, starting at two_J"""
+    return State(two_J), [
+        [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.1), State(two_J + 2 * i)]
+        for i in range(1, n_steps + 1)
+    ]
+
+
+def main():
+    init()
+
+    # Construction, including the marshalling of the cascade into ctypes arrays.
+    for n_steps in range(2, 6):
+        initial_state, cascade_steps = cascade(0, n_steps)
+        run(
+            "AngularCorrelation.__init__",
+            "n_steps={:d}".format(n_steps),
+            1,
+            lambda: AngularCorrelation(initial_state, cascade_steps),
+        )
+
+    dir_dir = AngularCorrelation(*cascade(0, 2))
+    pol_dir = AngularCorrelation(
+        State(4, POSITIVE),
+        [
+            [Transition(MAGNETIC, 2, ELECTRIC, 4, 0.5), State(6, POSITIVE)],
+            [Transition(MAGNETIC, 2, ELECTRIC, 4, 2.0), State(4, POSITIVE)],
+        ],
+    )
+
+    # Evaluation for scalars, where the overhead of a single call dominates, and for arrays of
+    # realistic sizes, where the conversion of the arrays dominates.
+    for name, ang_cor in (("dir_dir", dir_dir), ("pol_dir", pol_dir)):
+        run(
+            "AngularCorrelation.__call__",
+            name + ",scalar",
+            1,
+            lambda: ang_cor(0.1, 0.2),
+        )
+        for n in (4096, 1048576):
+            theta = np.linspace(0.0, np.pi, n)
+            phi = np.linspace(0.0, 2.0 * np.pi, n)
+            parameter = name + ",n={:d}".format(n)
+            run(
+                "AngularCorrelation.__call__",
+                parameter,
+                n,
+                lambda: ang_cor(theta, phi),
+            )
+            run(
+                "AngularCorrelation.__call__",
+                parameter + ",rotated",
+                n,
+                lambda: ang_cor(theta, phi, [0.1, 0.2, 0.3]),
+            )
+            run(
+                "AngularCorrelation.evaluate",
+                parameter + ",delta",
+                n,
+                lambda: ang_cor.evaluate(theta, phi, None, [0.3, -0.2]),
+            )
+
+    # Fits of mixing ratios call the angular correlation with new mixing ratios each time.
+    n = 4096
+    theta = np.linspace(0.0, np.pi, n)
+    phi = np.linspace(0.0, 2.0 * np.pi, n)
+    deltas = np.tan(np.linspace(-1.5, 1.5, 101))
+    run(
+        "AngularCorrelation.__call__",
+        "pol_dir,n={:d},new_delta".format(n),
+        n * len(deltas),
+        lambda: [pol_dir(theta, phi, None, delta, 2.0) for delta in deltas],
+    )
+
+    # Separable grid, e.g. for a map of the angular correlation.
+    theta = np.linspace(0.0, np.pi, 181)
+    phi = np.linspace(0.0, 2.0 * np.pi, 361)
+    run(
+        "AngularCorrelation.evaluate_grid",
+        "pol_dir,181x361",
+        len(theta) * len(phi),
+        lambda: pol_dir.evaluate_grid(theta, phi),
+    )
+
+    # Several cascades in a single call of the C interface.
+    cascades = [cascade(2 * i, 2) for i in range(4)]
+    n = 4096
+    theta = np.linspace(0.0, np.pi, n)
+    phi = np.linspace(0.0, 2.0 * np.pi, n)
+    run(
+        "angular_correlations",
+        "n_cascades={:d},n={:d}".format(len(cascades), n),
+        len(cascades) * n,
+        lambda: angular_correlations(theta, phi, cascades),
+    )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,69 @@
+
+import json
+import sys
+import time
+
+# Minimal harness for the benchmarks of the python bindings.
+# It follows the C++ harness in benchmark/Benchmark.hh and writes the result of each benchmark
+# as a single line in the JSON format to the standard output, so that the results of the C++
+# and the python benchmarks can be collected in the same way and compared to detect
+# performance regressions.
+
+# Minimum run time of a benchmark in seconds, see init().
+min_time = 0.5
+
+
+def init():
+    """Read the minimum run time from the command line"""
+    global min_time
+    if len(sys.argv) > 1:
+        min_time = float(sys.argv[1])
+
+
+def run(name, parameter, items_per_call, f):
+    r"""Run a benchmark and print the result
+
+    The function is called once before the measurement to warm up caches and lazily
+    initialized data.
+    After that, it is called repeatedly, doubling the number of calls between readings of
+    the clock, until the total time exceeds `min_time`.
+
+    Parameters
+    ----------
+    name: str
+        Name of the benchmark.
+    parameter: str
+        Description of the parameters of the benchmark, e.g. the size of an array.
+    items_per_call: int
+        Number of items that are processed in a single call of f, for example the number
+        of evaluated angles.
+    f: callable
+        Function without arguments.
+    """
+    f()
+
+    calls = 0
+    seconds = 0.0
+    start = time.perf_counter()
+    n = 1
+    while seconds < min_time:
+        for _ in range(n):
+            f()
+        calls += n
+        n *= 2
+        seconds = time.perf_counter() - start
+
+    items = calls * items_per_call
+    print(
+        json.dumps(
+            {
+                "benchmark": name,
+                "parameter": parameter,
+                "calls": calls,
+                "items": items,
+                "seconds": seconds,
+                "items_per_second": items / seconds,
+            }
+        ),
+        flush=True,
+    )
@@ -82,7 +82,7 @@ def test_analyzing_power():
     )
     ana_pow = AnalyzingPower(ang_cor)
 
-    assert ana_pow.evaluate(0.5, ["delta", "delta"], theta) == ana_pow(theta)
+    assert np.isclose(ana_pow.evaluate(0.5, ["delta", "delta"], theta), ana_pow(theta))
 
     # Test AnalyzingPower.evaluate for scalar input when the relation between mixing ratios
     # is an arbitrary function.
@@ -96,7 +96,9 @@ def test_analyzing_power():
     )
     ana_pow = AnalyzingPower(ang_cor)
 
-    assert ana_pow.evaluate(0.5, ["delta", lambda x: -x], theta) == ana_pow(theta)
+    assert np.isclose(
+        ana_pow.evaluate(0.5, ["delta", lambda x: -x], theta), ana_pow(theta)
+    )
 
     # Test AnalyzingPower.evaluate when the input is a numpy array
     ang_cor_matrix_manual = [
@@ -153,3 +155,60 @@ def test_analyzing_power():
     ).evaluate(np.array([[0.1, 0.2], [0.3, 0.4]]), [0.0, "delta"], theta=theta)
 
     assert np.allclose(ang_cor_matrix, ang_cor_matrix_manual)
+
+    # Arrays of angles are evaluated in a single call, for the mixing ratios of the cascade
+    # and for a grid of mixing ratios.
+    ana_pow = AnalyzingPower(
+        AngularCorrelation(
+            State(0, POSITIVE),
+            [
+                [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.0), State(2, NEGATIVE)],
+                [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.1), State(4, POSITIVE)],
+            ],
+        ),
+        PQ=0.5,
+        convention="KPZ",
+    )
+    thetas = np.array([0.3, 0.5 * np.pi, 2.0])
+    phips = np.array([0.5 * np.pi, 1.0, 0.2])
+    assert np.shape(ana_pow(thetas, phip=phips)) == (3,)
+    assert np.allclose(
+        ana_pow(thetas, phip=phips),
+        [ana_pow(t, phip=p) for t, p in zip(thetas, phips)],
+    )
+    delta_grid = arctan_grid(5)
+    ana_pow_grid = ana_pow.evaluate(delta_grid, [0.0, "delta"], theta=thetas)
+    assert ana_pow_grid.shape == (5, 3)
+    for i, t in enumerate(thetas):
+        assert np.allclose(
+            ana_pow_grid[:, i], ana_pow.evaluate(delta_grid, [0.0, "delta"], theta=t)
+        )
+
+    # Test AnalyzingPower.invert against a dense grid evaluation.
+    ang_cor = AngularCorrelation(
+        State(3, POSITIVE),
+        [
+            [Transition(MAGNETIC, 2, ELECTRIC, 4, 0.0), State(5, POSITIVE)],
+            [Transition(MAGNETIC, 2, ELECTRIC, 4, 0.0), State(3, POSITIVE)],
+        ],
+    )
+    ana_pow = AnalyzingPower(ang_cor, convention="KPZ")
+    asymmetry = [-0.25, -0.15]
+    intervals = ana_pow.invert(asymmetry, ["delta", "delta"], return_arctan=True)
+    assert len(intervals) > 0
+
+    arctan_delta = np.linspace(-0.5 * np.pi, 0.5 * np.pi, 10001)[1:-1]
+    asymmetries = ana_pow.evaluate(np.tan(arctan_delta), ["delta", "delta"])
+    inside = (asymmetries >= asymmetry[0]) * (asymmetries <= asymmetry[1])
+    close_to_limits = np.isclose(asymmetries, asymmetry[0], atol=1e-4) + np.isclose(
+        asymmetries, asymmetry[1], atol=1e-4
+    )
+    inside_intervals = np.zeros(len(arctan_delta), dtype=bool)
+    for interval in intervals:
+        inside_intervals += (arctan_delta >= interval[0]) * (
+            arctan_delta <= interval[1]
+        )
+    assert np.all((inside == inside_intervals) + close_to_limits)
+
+    with pytest.raises(ValueError):
+        ana_pow.invert(asymmetry, ["delta", lambda x: x**2])
@@ -20,8 +20,20 @@
 # This is already done in the tests of the C++ code.
 # The purpose of this test is to ensure that the python API works correctly.
 
-from alpaca.angular_correlation import angular_correlation, AngularCorrelation
-from alpaca.state import POSITIVE, POSITIVE, State
+import pickle
+
+import numpy as np
+import pytest
+
+from alpaca.angular_correlation import (
+    angular_correlation,
+    angular_correlations,
+    AngularCorrelation,
+    get_n_threads,
+    set_n_threads,
+    validate_cascade,
+)
+from alpaca.state import NEGATIVE, POSITIVE, POSITIVE, State
 from alpaca.transition import ELECTRIC, MAGNETIC, Transition
 
 
@@ -40,3 +52,200 @@ def test_angular_correlation():
     assert ang_cor(0.1, 0.1, Phi_Theta_Psi=(0.1, 0.1, 0.1)) == angular_correlation(
         0.1, 0.1, initial_state, cascade_steps, Phi_Theta_Psi=(0.1, 0.1, 0.1)
     )
+
+    integral = ang_cor.integrate_cone(0.1, 0.2, 0.3)
+    assert isinstance(integral, float)
+    integrals = ang_cor.integrate_cone(np.array([0.1, 0.1]), 0.2, np.array([0.3, 1e-3]))
+    assert integrals.shape == (2,)
+    assert integrals[0] == integral
+    assert np.isclose(
+        integrals[1] / (2.0 * np.pi * (1.0 - np.cos(1e-3))), ang_cor(0.1, 0.2), rtol=1e-5
+    )
+
+    theta = np.linspace(0.0, np.pi, 7)
+    phi = np.linspace(0.0, 2.0 * np.pi, 5)
+    theta_grid, phi_grid = np.meshgrid(theta, phi, indexing="ij")
+    grid = ang_cor.evaluate_grid(theta, phi)
+    assert grid.shape == (7, 5)
+    assert np.allclose(grid, ang_cor(theta_grid, phi_grid))
+    assert np.allclose(
+        ang_cor.evaluate_grid(theta, phi, Phi_Theta_Psi=(0.1, 0.2, 0.3)),
+        ang_cor(theta_grid, phi_grid, Phi_Theta_Psi=(0.1, 0.2, 0.3)),
+    )
+
+
+def test_angular_correlations():
+    cascades = [
+        (
+            State(0, POSITIVE),
+            [
+                [Transition(MAGNETIC, 2, ELECTRIC, 4, 0.0), State(2, POSITIVE)],
+                [Transition(MAGNETIC, 2, ELECTRIC, 4, 0.5), State(4, POSITIVE)],
+            ],
+        ),
+        (
+            State(0, POSITIVE),
+            [
+                [Transition(MAGNETIC, 2, ELECTRIC, 4, 0.0), State(2, POSITIVE)],
+                [Transition(MAGNETIC, 2, ELECTRIC, 4, 0.0), State(2, POSITIVE)],
+                [Transition(MAGNETIC, 2, ELECTRIC, 4, -0.3), State(0, POSITIVE)],
+            ],
+        ),
+    ]
+    theta = np.array([[0.1, 0.5, 1.0], [1.5, 2.0, 3.0]])
+    phi = np.array([[0.0, 1.0, 2.0], [3.0, 4.0, 5.0]])
+
+    w = angular_correlations(theta, phi, cascades)
+    assert w.shape == (2, 2, 3)
+    for k, (initial_state, cascade_steps) in enumerate(cascades):
+        assert np.allclose(
+            w[k], AngularCorrelation(initial_state, cascade_steps)(theta, phi)
+        )
+
+
+def test_n_threads():
+    ang_cor = AngularCorrelation(
+        State(0, POSITIVE),
+        [
+            [Transition(MAGNETIC, 2, ELECTRIC, 4, 0.0), State(2, POSITIVE)],
+            [Transition(MAGNETIC, 2, ELECTRIC, 4, 0.5), State(4, POSITIVE)],
+        ],
+    )
+    theta = np.linspace(0.0, np.pi, 100000)
+    phi = np.linspace(0.0, 2.0 * np.pi, 100000)
+
+    n_threads = get_n_threads()
+    set_n_threads(1)
+    assert get_n_threads() == 1
+    w_serial = ang_cor(theta, phi)
+    w_rotated_serial = ang_cor(theta, phi, Phi_Theta_Psi=(0.1, 0.2, 0.3))
+    set_n_threads(4)
+    assert get_n_threads() == 4
+    assert np.array_equal(ang_cor(theta, phi), w_serial)
+    assert np.array_equal(
+        ang_cor(theta, phi, Phi_Theta_Psi=(0.1, 0.2, 0.3)), w_rotated_serial
+    )
+    set_n_threads(n_threads)
+
+
+def test_evaluate_with_gradient():
+    ang_cor = AngularCorrelation(
+        State(3, POSITIVE),
+        [
+            [Transition(MAGNETIC, 2, ELECTRIC, 4, 0.0), State(5, POSITIVE)],
+            [Transition(MAGNETIC, 2, ELECTRIC, 4, 0.0), State(3, POSITIVE)],
+        ],
+    )
+    theta = np.array([0.3, 1.2, 2.5])
+    phi = np.array([0.1, 2.0, 4.0])
+    delta = [0.4, -1.1]
+    h = 1e-6
+
+    w, gradient = ang_cor.evaluate_with_gradient(theta, phi, delta)
+    assert w.shape == (3,)
+    assert gradient.shape == (3, 4)
+    assert np.allclose(w, ang_cor.scan_deltas(theta, phi, [delta])[0])
+
+    deltas = [delta]
+    for j in range(2):
+        for sign in (1.0, -1.0):
+            d = list(delta)
+            d[j] += sign * h
+            deltas.append(d)
+    w_deltas = ang_cor.scan_deltas(theta, phi, deltas)
+    for j in range(2):
+        assert np.allclose(
+            gradient[:, 2 + j],
+            (w_deltas[1 + 2 * j] - w_deltas[2 + 2 * j]) / (2.0 * h),
+            atol=1e-6,
+        )
+    assert np.allclose(
+        gradient[:, 0],
+        (
+            ang_cor.scan_deltas(theta + h, phi, [delta])[0]
+            - ang_cor.scan_deltas(theta - h, phi, [delta])[0]
+        )
+        / (2.0 * h),
+        atol=1e-6,
+    )
+    assert np.allclose(
+        gradient[:, 1],
+        (
+            ang_cor.scan_deltas(theta, phi + h, [delta])[0]
+            - ang_cor.scan_deltas(theta, phi - h, [delta])[0]
+        )
+        / (2.0 * h),
+        atol=1e-6,
+    )
+
+
+def test_validate_cascade():
+    valid_steps = [
+        [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.0), State(2, NEGATIVE)],
+        [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.0), State(0, POSITIVE)],
+    ]
+    assert validate_cascade(State(0, POSITIVE), valid_steps) == (0, "")
+    assert validate_cascade(
+        State(0, POSITIVE), [State(2, NEGATIVE), State(0, POSITIVE)]
+    ) == (0, "")
+
+    # Wrong EM character of the second transition
+    invalid_steps = [
+        valid_steps[0],
+        [Transition(MAGNETIC, 2, MAGNETIC, 4, 0.0), State(0, POSITIVE)],
+    ]
+    status, message = validate_cascade(State(0, POSITIVE), invalid_steps)
+    assert status != 0
+    assert message.startswith("Incorrect electromagnetic character")
+    with pytest.raises(ValueError, match="Incorrect electromagnetic character"):
+        AngularCorrelation(State(0, POSITIVE), invalid_steps)
+
+    # Transition between two spin-0 states
+    status, message = validate_cascade(
+        State(0, POSITIVE), [State(0, NEGATIVE), State(2, POSITIVE)]
+    )
+    assert status != 0
+    with pytest.raises(ValueError):
+        AngularCorrelation(State(0, POSITIVE), [State(0, NEGATIVE), State(2, POSITIVE)])
+
+    # Invalid cascades in a table give NaN
+    result = angular_correlations(
+        0.5,
+        0.1,
+        [(State(0, POSITIVE), valid_steps), (State(0, POSITIVE), invalid_steps)],
+    )
+    assert np.all(np.isfinite(result[0]))
+    assert np.all(np.isnan(result[1]))
+
+
+
+def test_pickle():
+    theta = np.linspace(0.0, np.pi, 7)
+    phi = np.linspace(0.0, 2.0 * np.pi, 7)
+
+    # Unpickling restores the C++ object without recalculating the
+    # coefficients. The result is bitwise identical.
+    cascades = [
+        (
+            State(3, POSITIVE),
+            [
+                [Transition(MAGNETIC, 2, ELECTRIC, 4, 0.5), State(5, POSITIVE)],
+                [Transition(MAGNETIC, 2, ELECTRIC, 4, -1.5), State(3, POSITIVE)],
+            ],
+        ),
+        (
+            State(0, POSITIVE),
+            [State(2, NEGATIVE), State(2, POSITIVE), State(0, POSITIVE)],
+        ),
+    ]
+    for initial_state, cascade_steps in cascades:
+        ang_cor = AngularCorrelation(initial_state, cascade_steps)
+        ang_cor.set_polarization_degree(0.5)
+        restored = pickle.loads(pickle.dumps(ang_cor))
+        assert restored.handle != ang_cor.handle
+        assert np.array_equal(restored(theta, phi), ang_cor(theta, phi))
+
+        deltas = [0.3, -0.2, 0.1][: len(cascade_steps)]
+        assert np.array_equal(
+            restored(theta, phi, None, *deltas), ang_cor(theta, phi, None, *deltas)
+        )
@@ -0,0 +1,132 @@
+#    This file is part of alpaca.
+#
+#    alpaca is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    alpaca is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+#
+#    Copyright (C) 2021-2023 Udo Friman-Gayer
+
+import os
+
+import pytest
+
+import numpy as np
+
+from alpaca.angular_correlation import AngularCorrelation
+from alpaca.coefficient_table import CoefficientTable, write_coefficient_table
+from alpaca.state import NEGATIVE, PARITY_UNKNOWN, POSITIVE, State
+from alpaca.transition import ELECTRIC, EM_UNKNOWN, MAGNETIC, Transition
+
+
+def test_coefficient_table(tmp_path):
+    ang_cors = [
+        AngularCorrelation(
+            State(3, PARITY_UNKNOWN),
+            [
+                [
+                    Transition(EM_UNKNOWN, 2, EM_UNKNOWN, 4, 0.3),
+                    State(5, PARITY_UNKNOWN),
+                ],
+                [
+                    Transition(EM_UNKNOWN, 2, EM_UNKNOWN, 4, -0.7),
+                    State(3, PARITY_UNKNOWN),
+                ],
+            ],
+        ),
+        AngularCorrelation(
+            State(0, POSITIVE),
+            [
+                [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.0), State(2, NEGATIVE)],
+                [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.2), State(4, POSITIVE)],
+            ],
+        ),
+    ]
+
+    file_name = str(tmp_path / "table.bin")
+    write_coefficient_table(file_name, ang_cors)
+
+    table = CoefficientTable(file_name)
+    assert len(table) == len(ang_cors)
+
+    theta = np.linspace(0.0, np.pi, 7)
+    phi = np.linspace(0.0, 2.0 * np.pi, 7)
+    for i, ang_cor in enumerate(ang_cors):
+        assert np.allclose(table(i, theta, phi), ang_cor(theta, phi))
+        assert np.isclose(table(i, 0.3, 0.4), ang_cor(0.3, 0.4))
+
+        initial_state, cascade_steps = table.cascade(i)
+        assert initial_state.two_J == ang_cor.initial_state.two_J
+        assert initial_state.parity == ang_cor.initial_state.parity
+        for step, original_step in zip(cascade_steps, ang_cor.cascade_steps):
+            assert step[0].two_L == original_step[0].two_L
+            assert step[0].delta == original_step[0].delta
+            assert step[1].two_J == original_step[1].two_J
+
+        assert np.isclose(table.angular_correlation(i)(0.3, 0.4), ang_cor(0.3, 0.4))
+
+    with pytest.raises(IndexError):
+        table(len(ang_cors), 0.0, 0.0)
+
+    table.close()
+    with pytest.raises(ValueError):
+        table(0, 0.0, 0.0)
+
+    with pytest.raises(OSError):
+        CoefficientTable(str(tmp_path / "does_not_exist.bin"))
+
+    # A table that is not closed explicitly is unmapped when it is garbage collected.
+    if not os.path.exists("/proc/self/maps"):
+        return
+
+    def n_mappings():
+        with open("/proc/self/maps") as maps:
+            return sum(file_name in line for line in maps)
+
+    table = CoefficientTable(file_name)
+    assert n_mappings() == 1
+    del table
+    assert n_mappings() == 0
+
+
+def test_build_coefficient_table(tmp_path):
+    ang_cor = AngularCorrelation(
+        State(0, POSITIVE),
+        [
+            [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.0), State(2, NEGATIVE)],
+            [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.0), State(0, POSITIVE)],
+        ],
+    )
+    n_builds = []
+
+    def build():
+        n_builds.append(1)
+        return [ang_cor]
+
+    file_name = str(tmp_path / "table.bin")
+    table = CoefficientTable(file_name, build)
+    assert len(n_builds) == 1
+    assert np.isclose(table(0, 0.3, 0.4), ang_cor(0.3, 0.4))
+
+    # An existing table is opened without building it again.
+    other_table = CoefficientTable(file_name, build)
+    assert len(n_builds) == 1
+    assert len(other_table) == 1
+
+    # Replacing the file does not affect existing mappings.
+    write_coefficient_table(file_name, [])
+    assert np.isclose(table(0, 0.3, 0.4), ang_cor(0.3, 0.4))
+    empty_table = CoefficientTable(file_name)
+    assert len(empty_table) == 0
+
+    table.close()
+    other_table.close()
+    empty_table.close()
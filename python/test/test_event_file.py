@@ -0,0 +1,98 @@
+#    This file is part of alpaca.
+#
+#    alpaca is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    alpaca is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+#
+#    Copyright (C) 2021-2023 Udo Friman-Gayer
+
+
+import pytest
+
+import numpy as np
+
+from alpaca.event_file import BYTE_ORDER_MARK, EventFile, FORMAT_VERSION, HEADER_DTYPE
+
+
+def write_event_file(file_name, values, weights, chunk_size, n_components):
+    r"""Write an event file in the format of EventFileWriter
+
+    values is an array with the shape (n_steps*n_components, n_events).
+    """
+    n_events = values.shape[1]
+    columns = values if weights is None else np.vstack((values, weights))
+    n_chunks = -(-n_events // chunk_size)
+    chunks = np.zeros((n_chunks, columns.shape[0], chunk_size))
+    for c in range(n_chunks):
+        chunk = columns[:, c * chunk_size : (c + 1) * chunk_size]
+        chunks[c, :, : chunk.shape[1]] = chunk
+
+    header = np.zeros(1, dtype=HEADER_DTYPE)
+    header["magic"] = b"ALPACAEV"
+    header["version"] = FORMAT_VERSION
+    header["byte_order"] = BYTE_ORDER_MARK
+    header["n_steps"] = values.shape[0] // n_components
+    header["n_components"] = n_components
+    header["weighted"] = weights is not None
+    header["chunk_size"] = chunk_size
+    header["n_events"] = n_events
+    header["file_size"] = HEADER_DTYPE.itemsize + chunks.nbytes
+    header["data_offset"] = HEADER_DTYPE.itemsize
+
+    with open(file_name, "wb") as file:
+        file.write(header.tobytes())
+        file.write(chunks.tobytes())
+
+
+def test_event_file(tmp_path):
+    assert HEADER_DTYPE.itemsize == 64
+
+    rng = np.random.default_rng(0)
+    values = rng.uniform(size=(6, 250))
+    weights = rng.uniform(size=250)
+
+    file_name = str(tmp_path / "events.bin")
+    write_event_file(file_name, values, weights, 100, 3)
+    event_file = EventFile(file_name)
+    assert len(event_file) == 250
+    assert event_file.n_steps == 2
+    assert event_file.n_components == 3
+    assert event_file.weighted
+    assert event_file.chunks.shape == (3, 7, 100)
+    for i in range(2):
+        for j in range(3):
+            assert np.array_equal(event_file.values(i, j), values[3 * i + j])
+    assert np.array_equal(event_file.weights(), weights)
+    assert np.array_equal(event_file.chunks[2, 6, :50], weights[200:])
+
+    with pytest.raises(IndexError):
+        event_file.values(2, 0)
+    with pytest.raises(IndexError):
+        event_file.column(7)
+
+    # A file with a single chunk is not copied.
+    write_event_file(file_name, values, None, 256, 3)
+    event_file = EventFile(file_name)
+    assert np.shares_memory(event_file.values(1, 2), event_file.chunks)
+    assert np.array_equal(event_file.values(1, 2), values[5])
+    with pytest.raises(ValueError):
+        event_file.weights()
+
+    with open(file_name, "r+b") as file:
+        file.truncate(HEADER_DTYPE.itemsize + 8)
+    with pytest.raises(OSError):
+        EventFile(file_name)
+
+    with open(file_name, "wb") as file:
+        file.write(b"ALPACACT" + bytes(56))
+    with pytest.raises(OSError):
+        EventFile(file_name)
@@ -19,7 +19,12 @@ import pytest
 
 import numpy as np
 
-from alpaca.angular_correlation import AngularCorrelation
+from alpaca.angular_correlation import (
+    AngularCorrelation,
+    create_angular_correlations,
+    free_angular_correlations,
+    libangular_correlation,
+)
 from alpaca.inversion_by_piecewise_interpolation import interpolate_and_invert
 from alpaca.state import NEGATIVE, POSITIVE, State
 from alpaca.transition import ELECTRIC, MAGNETIC, Transition
@@ -52,3 +57,92 @@ def test_memory_leak():
 
         for d in delta_inv:
             delta_results.append(d)
+
+
+# The AngularCorrelation C++ objects are owned by the handle table of the C interface, and
+# each python object releases its reference when it is garbage collected.
+# Freeing an object explicitly before is allowed.
+def test_handle_release():
+    n_before = libangular_correlation.get_n_angular_correlation_handles()
+
+    angular_correlations = [
+        AngularCorrelation(
+            State(0, POSITIVE),
+            [
+                [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.0), State(2, NEGATIVE)],
+                [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.0), State(0, POSITIVE)],
+            ],
+        )
+        for _ in range(1000)
+    ]
+    assert (
+        libangular_correlation.get_n_angular_correlation_handles() == n_before + 1000
+    )
+
+    # A new set of mixing ratios replaces the internal object.
+    angular_correlations[0](0.5 * np.pi, 0.0, None, 0.1, 0.2)
+    angular_correlations[1].free()
+    angular_correlations[1].free()
+    assert (
+        libangular_correlation.get_n_angular_correlation_handles() == n_before + 999
+    )
+
+    del angular_correlations
+    assert libangular_correlation.get_n_angular_correlation_handles() == n_before
+
+
+# Many angular correlations can be created and released with a single call each.
+def test_bulk_handle_release():
+    n_before = libangular_correlation.get_n_angular_correlation_handles()
+
+    cascades = [
+        (
+            State(0, POSITIVE),
+            [
+                [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.1 * i), State(2, NEGATIVE)],
+                [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.0), State(0, POSITIVE)],
+            ],
+        )
+        for i in range(1000)
+    ]
+    angular_correlations = create_angular_correlations(cascades)
+    assert (
+        libangular_correlation.get_n_angular_correlation_handles() == n_before + 1000
+    )
+    for i in (0, 500, 999):
+        assert np.isclose(
+            angular_correlations[i](0.3, 0.4),
+            AngularCorrelation(*cascades[i])(0.3, 0.4),
+        )
+
+    # Transitions are inferred if the cascade steps are states.
+    inferred = create_angular_correlations(
+        [(State(0, POSITIVE), [State(2, POSITIVE), State(0, POSITIVE)])]
+    )
+    assert inferred[0].cascade_steps[0][0].two_L == 2
+    free_angular_correlations(inferred)
+
+    free_angular_correlations(angular_correlations[:10])
+    free_angular_correlations(angular_correlations[:10])
+    assert (
+        libangular_correlation.get_n_angular_correlation_handles() == n_before + 990
+    )
+
+    del angular_correlations
+    assert libangular_correlation.get_n_angular_correlation_handles() == n_before
+
+    # An invalid cascade creates no object.
+    with pytest.raises(ValueError):
+        create_angular_correlations(
+            cascades[:2]
+            + [
+                (
+                    State(0, POSITIVE),
+                    [
+                        [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.0), State(0, NEGATIVE)],
+                        [Transition(ELECTRIC, 2, MAGNETIC, 4, 0.0), State(0, POSITIVE)],
+                    ],
+                )
+            ]
+        )
+    assert libangular_correlation.get_n_angular_correlation_handles() == n_before
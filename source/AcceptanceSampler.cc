@@ -0,0 +1,174 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <gsl/gsl_math.h>
+
+#include "AcceptanceSampler.hh"
+#include "LegendreSeries.hh"
+
+AcceptanceSampler::AcceptanceSampler(const AngularCorrelation &w,
+                                     const vector<array<double, 2>> &theta_phi,
+                                     const vector<double> &opening_angles,
+                                     const int seed,
+                                     const unsigned int max_tri)
+    : angular_correlation(w), upper_limit(w.get_upper_limit()),
+      max_tries(max_tri), random_engine(seed) {
+  if (theta_phi.empty()) {
+    throw invalid_argument("At least one cone is required.");
+  }
+  if (theta_phi.size() != opening_angles.size()) {
+    throw invalid_argument(
+        "Number of axes and opening angles of the cones must be equal.");
+  }
+
+  for (size_t c = 0; c < theta_phi.size(); ++c) {
+    if (!(opening_angles[c] > 0.) || opening_angles[c] > M_PI) {
+      throw invalid_argument("Opening angles must be in the range (0, pi].");
+    }
+    const double sin_theta = sin(theta_phi[c][0]);
+    axes.push_back({sin_theta * cos(theta_phi[c][1]),
+                    sin_theta * sin(theta_phi[c][1]), cos(theta_phi[c][0])});
+
+    for (size_t d = 0; d < c; ++d) {
+      const double cos_angle = axes[c][0] * axes[d][0] +
+                               axes[c][1] * axes[d][1] +
+                               axes[c][2] * axes[d][2];
+      if (acos(max(-1., min(1., cos_angle))) <
+          opening_angles[c] + opening_angles[d]) {
+        throw invalid_argument("Cones of the acceptance must not overlap.");
+      }
+    }
+
+    cos_opening_angles.push_back(cos(opening_angles[c]));
+    attenuation.emplace_back(angular_correlation.get_nu_max() / 2 + 1);
+    legendre_series::cone_integrals(attenuation[c].size(),
+                                    cos_opening_angles[c],
+                                    attenuation[c].data());
+  }
+
+  // The integral over the full sphere is 4 pi times the coefficient of P_0.
+  total_integral =
+      4. * M_PI * angular_correlation.get_legendre_coefficients()[0];
+
+  local_axes.resize(axes.size());
+  integrals.resize(axes.size());
+}
+
+pair<double, euler_angle_transform::RotationMatrix>
+AcceptanceSampler::operator()(
+    const euler_angle_transform::RotationMatrix &A_previous) {
+  const double sum = integrate_cones(A_previous);
+  if (!(sum > 0.)) {
+    return {0., rotation_matrix(local_axes[0])};
+  }
+
+  // Composition: select a cone with a probability proportional to its
+  // integral.
+  double u = sum * uniform_random(random_engine);
+  size_t c = 0;
+  while (c + 1 < integrals.size() && u >= integrals[c]) {
+    u -= integrals[c];
+    ++c;
+  }
+
+  // Rejection inside the selected cone, with uniform proposals in the local
+  // coordinate system whose z axis is the axis of the cone.
+  const euler_angle_transform::RotationMatrix B =
+      rotation_matrix(local_axes[c]);
+  array<double, 3> direction{};
+  for (unsigned int i = 0; i < max_tries; ++i) {
+    const double cos_beta =
+        1. - (1. - cos_opening_angles[c]) * uniform_random(random_engine);
+    const double sin_beta = sqrt(max(0., 1. - cos_beta * cos_beta));
+    const double psi = 2. * M_PI * uniform_random(random_engine);
+    direction = euler_angle_transform::apply(
+        B, {sin_beta * cos(psi), sin_beta * sin(psi), cos_beta});
+
+    if (upper_limit * uniform_random(random_engine) <=
+        angular_correlation.evaluate(direction)) {
+      break;
+    }
+  }
+
+  return {sum / total_integral, rotation_matrix(direction)};
+}
+
+void AcceptanceSampler::operator()(
+    const size_t n, const euler_angle_transform::RotationMatrix *A_previous,
+    euler_angle_transform::RotationMatrix *R, double *weights) {
+  const euler_angle_transform::RotationMatrix identity =
+      euler_angle_transform::rotation_matrix({0., 0., 0.});
+
+  for (size_t k = 0; k < n; ++k) {
+    const pair<double, euler_angle_transform::RotationMatrix> w_R =
+        operator()(A_previous == nullptr ? identity : A_previous[k]);
+    weights[k] = w_R.first;
+    R[k] = w_R.second;
+  }
+}
+
+double AcceptanceSampler::get_acceptance_probability(
+    const euler_angle_transform::RotationMatrix &A_previous) {
+  return integrate_cones(A_previous) / total_integral;
+}
+
+void AcceptanceSampler::reseed(seed_seq &seq) {
+  random_engine.seed(seq);
+  uniform_random.reset();
+}
+
+double AcceptanceSampler::integrate_cones(
+    const euler_angle_transform::RotationMatrix &A_previous) {
+  // The inverse of a rotation matrix is its transpose.
+  const euler_angle_transform::RotationMatrix A_inv =
+      euler_angle_transform::transpose(A_previous);
+
+  double sum = 0.;
+  for (size_t c = 0; c < axes.size(); ++c) {
+    local_axes[c] = euler_angle_transform::apply(A_inv, axes[c]);
+    const double cos_theta = max(-1., min(1., local_axes[c][2]));
+    const double phi = atan2(local_axes[c][1], local_axes[c][0]);
+    angular_correlation.evaluate_attenuated_cos_theta(
+        1, &cos_theta, &phi, attenuation[c].data(), &integrals[c]);
+    // Rounding errors may give small negative values close to the zeros of W.
+    integrals[c] = max(0., integrals[c]);
+    sum += integrals[c];
+  }
+
+  return sum;
+}
+
+euler_angle_transform::RotationMatrix
+AcceptanceSampler::rotation_matrix(const array<double, 3> &direction) {
+  // euler_angle_transform::direction() of the matrix from
+  // rotation_matrix_from_spherical() has the azimuthal angle -phi.
+  return euler_angle_transform::rotation_matrix_from_spherical(
+      max(-1., min(1., direction[2])), -atan2(direction[1], direction[0]));
+}
@@ -0,0 +1,313 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+using std::upper_bound;
+
+#include <chrono>
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+#include <cmath>
+
+#include <queue>
+
+using std::priority_queue;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <utility>
+
+using std::pair;
+
+#include "AdaptiveEnvelope.hh"
+#include "LegendreSeries.hh"
+
+namespace {
+
+/**
+ * \brief Power series of \f$a + c b\f$.
+ */
+vector<double> combination(const vector<double> &a, const vector<double> &b,
+                           const double c) {
+  vector<double> result(max(a.size(), b.size()), 0.);
+  for (size_t k = 0; k < a.size(); ++k) {
+    result[k] += a[k];
+  }
+  for (size_t k = 0; k < b.size(); ++k) {
+    result[k] += c * b[k];
+  }
+  return result;
+}
+
+/**
+ * \brief Integral of a power series over the interval \f$\left[ x_0, x_1
+ * \right]\f$.
+ */
+double integrate(const vector<double> &power_series, const double x_0,
+                 const double x_1) {
+  double result = 0., x_0_power = x_0, x_1_power = x_1;
+  for (size_t k = 0; k < power_series.size(); ++k) {
+    result += power_series[k] * (x_1_power - x_0_power) / (k + 1.);
+    x_0_power *= x_0;
+    x_1_power *= x_1;
+  }
+  return result;
+}
+
+} // namespace
+
+AdaptiveEnvelope::AdaptiveEnvelope(
+    const vector<double> &legendre_coefficients,
+    const vector<double> &associated_legendre_coefficients,
+    const double target_efficiency, const size_t max_strata) {
+  const steady_clock::time_point start = steady_clock::now();
+
+  if (legendre_coefficients.empty()) {
+    throw invalid_argument("At least one Legendre coefficient is required.");
+  }
+  if (legendre_coefficients[0] <= 0.) {
+    throw invalid_argument("Integral of the distribution must be positive.");
+  }
+  if (target_efficiency <= 0. || target_efficiency >= 1.) {
+    throw invalid_argument("Target efficiency must be in (0, 1).");
+  }
+  if (max_strata == 0) {
+    throw invalid_argument("At least one stratum is required.");
+  }
+
+  a = legendre_series::power_series(legendre_coefficients.size(),
+                                    legendre_coefficients.data(), 0, nullptr,
+                                    0.);
+  if (!associated_legendre_coefficients.empty()) {
+    b = legendre_series::power_series(
+        0, nullptr, associated_legendre_coefficients.size(),
+        associated_legendre_coefficients.data(), 1.);
+  }
+  double scale = 0.;
+  for (double a_k : a) {
+    scale += fabs(a_k);
+  }
+  for (double b_k : b) {
+    scale += fabs(b_k);
+  }
+  rounding_margin = 1e-12 * scale;
+
+  // Refine the stratum with the largest expected number of rejected
+  // candidates first.
+  priority_queue<pair<double, size_t>> queue;
+  strata.push_back(make_stratum(0., 1., 0., M_PI_2));
+  queue.push({strata[0].envelope_integral() - strata[0].integral, 0});
+  double reduced_integral = strata[0].integral,
+         reduced_envelope_integral = strata[0].envelope_integral();
+
+  while (strata.size() < max_strata &&
+         reduced_integral < target_efficiency * reduced_envelope_integral) {
+    const size_t i = queue.top().second;
+    queue.pop();
+    const Stratum stratum = strata[i];
+
+    const double x_mid = 0.5 * (stratum.x_min + stratum.x_max);
+    Stratum first = make_stratum(stratum.x_min, x_mid, stratum.phi_min,
+                                 stratum.phi_max);
+    Stratum second = make_stratum(x_mid, stratum.x_max, stratum.phi_min,
+                                  stratum.phi_max);
+    if (!b.empty()) {
+      const double phi_mid = 0.5 * (stratum.phi_min + stratum.phi_max);
+      const Stratum first_phi = make_stratum(stratum.x_min, stratum.x_max,
+                                             stratum.phi_min, phi_mid);
+      const Stratum second_phi = make_stratum(stratum.x_min, stratum.x_max,
+                                              phi_mid, stratum.phi_max);
+      if (first_phi.envelope_integral() + second_phi.envelope_integral() <
+          first.envelope_integral() + second.envelope_integral()) {
+        first = first_phi;
+        second = second_phi;
+      }
+    }
+
+    reduced_envelope_integral += first.envelope_integral() +
+                                 second.envelope_integral() -
+                                 stratum.envelope_integral();
+    strata[i] = first;
+    strata.push_back(second);
+    queue.push({first.envelope_integral() - first.integral, i});
+    queue.push({second.envelope_integral() - second.integral,
+                strata.size() - 1});
+  }
+
+  // The strata cover one eighth of the sphere surface in the coordinates
+  // (x, phi), in which the surface element is uniform.
+  cumulative.resize(strata.size());
+  reduced_envelope_integral = 0.;
+  for (size_t i = 0; i < strata.size(); ++i) {
+    reduced_envelope_integral += strata[i].envelope_integral();
+    cumulative[i] = reduced_envelope_integral;
+  }
+  for (size_t i = 0; i < strata.size(); ++i) {
+    cumulative[i] /= reduced_envelope_integral;
+  }
+  cumulative.back() = 1.;
+  integral = 4. * M_PI * legendre_coefficients[0];
+  envelope_integral = 8. * reduced_envelope_integral;
+
+  construction_time =
+      duration<double>(steady_clock::now() - start).count();
+}
+
+void AdaptiveEnvelope::propose(const double u_0, const double u_1,
+                               double &cos_theta, double &phi,
+                               double &bound) const {
+  const size_t i =
+      min(static_cast<size_t>(
+              upper_bound(cumulative.begin(), cumulative.end(), u_0) -
+              cumulative.begin()),
+          strata.size() - 1);
+  const Stratum &stratum = strata[i];
+  bound = stratum.bound;
+
+  const double lower = i ? cumulative[i - 1] : 0.;
+  double r_0 = 2. * (u_0 - lower) / (cumulative[i] - lower);
+  const bool negative = r_0 >= 1.;
+  if (negative) {
+    r_0 -= 1.;
+  }
+  const double x =
+      min(stratum.x_max, stratum.x_min + (stratum.x_max - stratum.x_min) * r_0);
+  cos_theta = negative ? -x : x;
+
+  double r_1 = 4. * u_1;
+  const size_t quadrant = min(static_cast<size_t>(r_1), size_t{3});
+  r_1 -= static_cast<double>(quadrant);
+  const double phi_reduced =
+      min(stratum.phi_max,
+          stratum.phi_min + (stratum.phi_max - stratum.phi_min) * r_1);
+  switch (quadrant) {
+  case 0:
+    phi = phi_reduced;
+    break;
+  case 1:
+    phi = M_PI - phi_reduced;
+    break;
+  case 2:
+    phi = M_PI + phi_reduced;
+    break;
+  default:
+    phi = 2. * M_PI - phi_reduced;
+  }
+}
+
+double AdaptiveEnvelope::operator()(const double cos_theta,
+                                    const double phi) const {
+  const double x = fabs(cos_theta);
+  double phi_reduced = fmod(phi, M_PI);
+  if (phi_reduced < 0.) {
+    phi_reduced += M_PI;
+  }
+  if (phi_reduced > M_PI_2) {
+    phi_reduced = M_PI - phi_reduced;
+  }
+
+  double result = 0.;
+  for (const Stratum &stratum : strata) {
+    if (x >= stratum.x_min && x <= stratum.x_max &&
+        phi_reduced >= stratum.phi_min && phi_reduced <= stratum.phi_max) {
+      result = max(result, stratum.bound);
+    }
+  }
+  return result;
+}
+
+double AdaptiveEnvelope::bernstein_bound(const vector<double> &power_series,
+                                         const double x_min,
+                                         const double x_max) {
+  if (power_series.empty()) {
+    return 0.;
+  }
+  const size_t n = power_series.size();
+
+  // Taylor shift to x = x_min + h t.
+  vector<double> q(power_series);
+  for (size_t i = 0; i + 1 < n; ++i) {
+    for (size_t k = n - 1; k > i; --k) {
+      q[k - 1] += x_min * q[k];
+    }
+  }
+  const double h = x_max - x_min;
+  double h_power = 1.;
+  for (size_t k = 0; k < n; ++k) {
+    q[k] *= h_power;
+    h_power *= h;
+  }
+
+  // Bernstein coefficients of the degree n - 1,
+  // beta_j = sum_{i <= j} binomial(j, i) / binomial(n - 1, i) q_i.
+  vector<double> binomial_n(n, 1.), binomial_j(n, 0.);
+  for (size_t i = 1; i < n; ++i) {
+    binomial_n[i] = binomial_n[i - 1] * static_cast<double>(n - i) /
+                    static_cast<double>(i);
+  }
+  double result = q[0];
+  binomial_j[0] = 1.;
+  for (size_t j = 1; j < n; ++j) {
+    // Pascal's triangle for binomial(j, i).
+    for (size_t i = j; i > 0; --i) {
+      binomial_j[i] += binomial_j[i - 1];
+    }
+    double beta = 0.;
+    for (size_t i = 0; i <= j; ++i) {
+      beta += binomial_j[i] / binomial_n[i] * q[i];
+    }
+    result = max(result, beta);
+  }
+  return result;
+}
+
+AdaptiveEnvelope::Stratum AdaptiveEnvelope::make_stratum(const double x_min,
+                                                         const double x_max,
+                                                         const double phi_min,
+                                                         const double phi_max) {
+  Stratum stratum{x_min, x_max, phi_min, phi_max, 0., 0.};
+
+  if (b.empty()) {
+    stratum.bound = bernstein_bound(a, x_min, x_max);
+    ++n_bound_evaluations;
+  } else {
+    // cos(2 phi) decreases monotonically on [0, pi / 2].
+    stratum.bound = max(bernstein_bound(combination(a, b, cos(2. * phi_max)),
+                                        x_min, x_max),
+                        bernstein_bound(combination(a, b, cos(2. * phi_min)),
+                                        x_min, x_max));
+    n_bound_evaluations += 2;
+  }
+  stratum.bound = max(0., stratum.bound + rounding_margin);
+
+  stratum.integral = integrate(a, x_min, x_max) * (phi_max - phi_min);
+  if (!b.empty()) {
+    stratum.integral += integrate(b, x_min, x_max) * 0.5 *
+                        (sin(2. * phi_max) - sin(2. * phi_min));
+  }
+
+  return stratum;
+}
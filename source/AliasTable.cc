@@ -0,0 +1,81 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cmath>
+
+using std::isfinite;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include "AliasTable.hh"
+
+AliasTable::AliasTable(const vector<double> &weights)
+    : probabilities(weights) {
+  const size_t n = weights.size();
+  if (n == 0) {
+    throw invalid_argument("At least one weight is required.");
+  }
+
+  double sum = 0.;
+  for (auto w : weights) {
+    if (w < 0. || !isfinite(w)) {
+      throw invalid_argument("Weights must be finite and non-negative.");
+    }
+    sum += w;
+  }
+  if (sum <= 0.) {
+    throw invalid_argument("Sum of the weights must be positive.");
+  }
+  for (auto &p : probabilities) {
+    p /= sum;
+  }
+
+  // Columns with a scaled probability below 1 are filled up with the excess of
+  // the columns above 1.
+  thresholds.resize(n);
+  aliases.resize(n);
+  vector<double> scaled(n);
+  vector<size_t> small, large;
+  for (size_t i = 0; i < n; ++i) {
+    scaled[i] = probabilities[i] * n;
+    aliases[i] = i;
+    (scaled[i] < 1. ? small : large).push_back(i);
+  }
+
+  while (!small.empty() && !large.empty()) {
+    const size_t s = small.back(), l = large.back();
+    small.pop_back();
+    thresholds[s] = scaled[s];
+    aliases[s] = l;
+    scaled[l] -= 1. - scaled[s];
+    if (scaled[l] < 1.) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // The remaining columns are full, up to rounding errors.
+  for (auto l : large) {
+    thresholds[l] = 1.;
+  }
+  for (auto s : small) {
+    thresholds[s] = 1.;
+  }
+}
@@ -28,42 +28,160 @@ AlphavCoefficient::AlphavCoefficient(const int two_nu, const int two_L,
                                      const int two_j)
     : two_nu(two_nu), two_L(two_L), two_Lp(two_Lp), two_jn(two_jn),
       two_j(two_j), constant_f_coefficient(two_nu, two_L, two_L, two_jn, two_j),
-      linear_f_coefficient(two_nu, two_L, two_Lp, two_jn, two_j),
-      quadratic_f_coefficient(two_nu, two_Lp, two_Lp, two_jn, two_j),
       constant_kappa_coefficient(two_nu, two_L, two_L),
-      linear_kappa_coefficient(two_nu, two_L, two_Lp),
-      quadratic_kappa_coefficient(two_nu, two_Lp, two_Lp) {
-  constant_coefficient = -constant_kappa_coefficient.get_value() *
-                         constant_f_coefficient.get_value();
-  linear_coefficient = 2. * linear_kappa_coefficient.get_value() *
-                       linear_f_coefficient.get_value();
-  quadratic_coefficient = quadratic_kappa_coefficient.get_value() *
-                          quadratic_f_coefficient.get_value();
+      constant_coefficient(-constant_kappa_coefficient.get_value() *
+                           constant_f_coefficient.get_value()),
+      mixed_terms_calculated(false), linear_f_value(0.),
+      quadratic_f_value(0.), linear_kappa_value(0.),
+      quadratic_kappa_value(0.) {}
+
+AlphavCoefficient::AlphavCoefficient(const int two_nu, const int two_L,
+                                     const int two_Lp, const int two_jn,
+                                     const int two_j,
+                                     const array<double, 3> &f_values,
+                                     const array<double, 3> &kappa_values)
+    : two_nu(two_nu), two_L(two_L), two_Lp(two_Lp), two_jn(two_jn),
+      two_j(two_j),
+      constant_f_coefficient(two_nu, two_L, two_L, two_jn, two_j, f_values[0]),
+      constant_kappa_coefficient(two_nu, two_L, two_L, kappa_values[0]),
+      constant_coefficient(-constant_kappa_coefficient.get_value() *
+                           constant_f_coefficient.get_value()),
+      mixed_terms_calculated(true), linear_f_value(f_values[1]),
+      quadratic_f_value(f_values[2]), linear_kappa_value(kappa_values[1]),
+      quadratic_kappa_value(kappa_values[2]) {}
+
+AlphavCoefficient::AlphavCoefficient(const int two_nu, const int two_L,
+                                     const int two_Lp, const int two_jn,
+                                     const int two_j,
+                                     const double constant_f_value)
+    : two_nu(two_nu), two_L(two_L), two_Lp(two_Lp), two_jn(two_jn),
+      two_j(two_j), constant_f_coefficient(two_nu, two_L, two_L, two_jn, two_j,
+                                           constant_f_value),
+      constant_kappa_coefficient(two_nu, two_L, two_L),
+      constant_coefficient(-constant_kappa_coefficient.get_value() *
+                           constant_f_coefficient.get_value()),
+      mixed_terms_calculated(false), linear_f_value(0.),
+      quadratic_f_value(0.), linear_kappa_value(0.),
+      quadratic_kappa_value(0.) {}
+
+AlphavCoefficient::AlphavCoefficient(
+    const AlphavCoefficient &alphav_coefficient)
+    : StringRepresentable(alphav_coefficient),
+      two_nu(alphav_coefficient.two_nu), two_L(alphav_coefficient.two_L),
+      two_Lp(alphav_coefficient.two_Lp), two_jn(alphav_coefficient.two_jn),
+      two_j(alphav_coefficient.two_j),
+      constant_f_coefficient(alphav_coefficient.constant_f_coefficient),
+      constant_kappa_coefficient(alphav_coefficient.constant_kappa_coefficient),
+      constant_coefficient(alphav_coefficient.constant_coefficient),
+      mixed_terms_calculated(alphav_coefficient.mixed_terms_calculated.load(
+          memory_order_acquire)),
+      linear_f_value(
+          alphav_coefficient.linear_f_value.load(memory_order_relaxed)),
+      quadratic_f_value(
+          alphav_coefficient.quadratic_f_value.load(memory_order_relaxed)),
+      linear_kappa_value(
+          alphav_coefficient.linear_kappa_value.load(memory_order_relaxed)),
+      quadratic_kappa_value(
+          alphav_coefficient.quadratic_kappa_value.load(memory_order_relaxed)) {
 }
 
 double AlphavCoefficient::operator()(const double delta) const {
 
+  // For a pure transition, the terms with L' are not needed.
+  if (delta == 0.) {
+    return constant_coefficient;
+  }
+
+  return constant_coefficient + delta * get_linear_coefficient() +
+         delta * delta * get_quadratic_coefficient();
+}
+
+double AlphavCoefficient::evaluate(const int two_nu, const int two_L,
+                                   const int two_Lp, const int two_jn,
+                                   const int two_j, const double delta) {
+  double constant_coefficient =
+      FCoefficient(two_nu, two_L, two_L, two_jn, two_j).get_value();
+  if (constant_coefficient != 0.) {
+    constant_coefficient *= -KappaCoefficient(two_nu, two_L, two_L).get_value();
+  }
+
+  // For a pure transition, the coefficient is a single product.
+  if (delta == 0.) {
+    return constant_coefficient;
+  }
+
+  double linear_coefficient =
+      FCoefficient(two_nu, two_L, two_Lp, two_jn, two_j).get_value();
+  if (linear_coefficient != 0.) {
+    linear_coefficient =
+        2. * KappaCoefficient(two_nu, two_L, two_Lp).get_value() *
+        linear_coefficient;
+  }
+  double quadratic_coefficient =
+      FCoefficient(two_nu, two_Lp, two_Lp, two_jn, two_j).get_value();
+  if (quadratic_coefficient != 0.) {
+    quadratic_coefficient *=
+        KappaCoefficient(two_nu, two_Lp, two_Lp).get_value();
+  }
+
+  // Same order of the operations as in operator()().
   return constant_coefficient + delta * linear_coefficient +
          delta * delta * quadratic_coefficient;
 }
 
-string AlphavCoefficient::string_representation(
-    const unsigned int n_digits, const vector<string> variable_names) const {
-
-  string multipole_mixing_ratio_variable =
-      variable_names.size() ? variable_names[0] : "\\delta";
-
-  return string("(-1)") + (n_digits ? "\\times" : "") +
-         constant_kappa_coefficient.string_representation(n_digits, {}) +
-         (n_digits ? "\\times" : "") +
-         constant_f_coefficient.string_representation(n_digits, {}) + "+2" +
-         (n_digits ? "\\times" : "") +
-         linear_kappa_coefficient.string_representation(n_digits, {}) +
-         (n_digits ? "\\times" : "") +
-         linear_f_coefficient.string_representation(n_digits, {}) +
-         (n_digits ? "\\times" : "") + multipole_mixing_ratio_variable + "+" +
-         quadratic_kappa_coefficient.string_representation(n_digits, {}) +
-         (n_digits ? "\\times" : "") +
-         quadratic_f_coefficient.string_representation(n_digits, {}) +
-         (n_digits ? "\\times" : "") + multipole_mixing_ratio_variable + "^{2}";
+void AlphavCoefficient::calculate_mixed_terms() const {
+  linear_f_value.store(
+      FCoefficient(two_nu, two_L, two_Lp, two_jn, two_j).get_value(),
+      memory_order_relaxed);
+  quadratic_f_value.store(
+      FCoefficient(two_nu, two_Lp, two_Lp, two_jn, two_j).get_value(),
+      memory_order_relaxed);
+  linear_kappa_value.store(KappaCoefficient(two_nu, two_L, two_Lp).get_value(),
+                           memory_order_relaxed);
+  quadratic_kappa_value.store(
+      KappaCoefficient(two_nu, two_Lp, two_Lp).get_value(),
+      memory_order_relaxed);
+  mixed_terms_calculated.store(true, memory_order_release);
+}
+
+void AlphavCoefficient::write_string_representation(
+    string &str_rep, const unsigned int n_digits,
+    const vector<string> &variable_names) const {
+  if (variable_names.size()) {
+    write_string_representation(str_rep, n_digits, variable_names[0]);
+  } else {
+    write_string_representation(str_rep, n_digits, "\\delta");
+  }
+}
+
+void AlphavCoefficient::write_string_representation(
+    string &str_rep, const unsigned int n_digits,
+    const string &delta_variable) const {
+  const char *times = n_digits ? "\\times" : "";
+  const array<double, 3> f_values = get_f_values();
+  const array<double, 3> kappa_values = get_kappa_values();
+
+  str_rep += "(-1)";
+  str_rep += times;
+  constant_kappa_coefficient.write_string_representation(str_rep, n_digits);
+  str_rep += times;
+  constant_f_coefficient.write_string_representation(str_rep, n_digits);
+  str_rep += "+2";
+  str_rep += times;
+  KappaCoefficient(two_nu, two_L, two_Lp, kappa_values[1])
+      .write_string_representation(str_rep, n_digits);
+  str_rep += times;
+  FCoefficient(two_nu, two_L, two_Lp, two_jn, two_j, f_values[1])
+      .write_string_representation(str_rep, n_digits);
+  str_rep += times;
+  str_rep += delta_variable;
+  str_rep += "+";
+  KappaCoefficient(two_nu, two_Lp, two_Lp, kappa_values[2])
+      .write_string_representation(str_rep, n_digits);
+  str_rep += times;
+  FCoefficient(two_nu, two_Lp, two_Lp, two_jn, two_j, f_values[2])
+      .write_string_representation(str_rep, n_digits);
+  str_rep += times;
+  str_rep += delta_variable;
+  str_rep += "^{2}";
 }
\ No newline at end of file
@@ -24,7 +24,28 @@ using std::array;
 #include "AngCorrRejectionSampler.hh"
 #include "EulerAngleRotation.hh"
 
-AngCorrRejectionSampler::AngCorrRejectionSampler(AngularCorrelation &w,
+AngCorrRejectionSampler::AngCorrRejectionSampler(const AngularCorrelation &w,
                                                  const int seed,
-                                                 const unsigned int max_tri)
-    : SphereRejectionSampler(w, w.get_upper_limit(), seed, max_tri) {}
\ No newline at end of file
+                                                 const unsigned int max_tri,
+                                                 const bool exact_maximum)
+    : SphereRejectionSampler(
+          w, exact_maximum ? w.get_maximum() : w.get_upper_limit(), seed,
+          max_tri) {}
+
+void AngCorrRejectionSampler::enable_adaptive_envelope(
+    const double target_efficiency, const size_t max_strata) {
+  const AngularCorrelation &w = *distribution.target<AngularCorrelation>();
+  enable_envelope(AdaptiveEnvelope(w.get_legendre_coefficients(),
+                                   w.get_associated_legendre_coefficients(),
+                                   target_efficiency, max_strata));
+}
+
+void AngCorrRejectionSampler::evaluate_block(const size_t n,
+                                             const double *cos_theta,
+                                             const double *phi,
+                                             double *result) {
+  // The std::function member of the base class stores a copy of the
+  // AngularCorrelation object that was passed to the constructor.
+  distribution.target<AngularCorrelation>()->evaluate_cos_theta(n, cos_theta,
+                                                                phi, result);
+}
@@ -0,0 +1,129 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::fill;
+
+#include <cmath>
+
+using std::cos;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include "AngleSet.hh"
+#include "LegendreSeries.hh"
+
+AngleSet::AngleSet(const vector<double> &theta, const vector<double> &phi,
+                   const int nu_m)
+    : n_directions(theta.size()), nu_max(nu_m),
+      n_legendre(nu_m >= 0 ? nu_m / 2 + 1 : 0),
+      leading_dimension((theta.size() + alignment - 1) / alignment *
+                        alignment) {
+  if (theta.size() != phi.size()) {
+    throw invalid_argument("theta and phi must have the same length.");
+  }
+  allocate();
+
+  vector<double> cos_theta(n_directions), cos_2phi(n_directions);
+  for (size_t m = 0; m < n_directions; ++m) {
+    cos_theta[m] = cos(theta[m]);
+    cos_2phi[m] = cos(2. * phi[m]);
+  }
+  calculate_basis(cos_theta.data(), cos_2phi.data());
+}
+
+AngleSet::AngleSet(const size_t n, const double *cos_theta,
+                   const double *cos_2phi, const int nu_m)
+    : n_directions(n), nu_max(nu_m), n_legendre(nu_m >= 0 ? nu_m / 2 + 1 : 0),
+      leading_dimension((n + alignment - 1) / alignment * alignment) {
+  allocate();
+  calculate_basis(cos_theta, cos_2phi);
+}
+
+void AngleSet::evaluate(const vector<AngularCorrelation> &ang_cors,
+                        double *result) const {
+  for (size_t k = 0; k < ang_cors.size(); ++k) {
+    evaluate(ang_cors[k], result + k * n_directions);
+  }
+}
+
+void AngleSet::evaluate(const vector<double> &legendre_coefficients,
+                        const vector<double> &associated_legendre_coefficients,
+                        double *result) const {
+  if (legendre_coefficients.size() > n_legendre ||
+      associated_legendre_coefficients.size() + 1 > n_legendre) {
+    throw invalid_argument("Order of the expansion exceeds nu_max.");
+  }
+
+  // The rows are added one after the other, so the innermost loop runs over
+  // contiguous, aligned memory. For a fixed set of directions, the result
+  // stays in the cache.
+  fill(result, result + n_directions, 0.);
+  const double *row = get_basis();
+  for (const double c : legendre_coefficients) {
+    for (size_t m = 0; m < n_directions; ++m) {
+      result[m] += c * row[m];
+    }
+    row += leading_dimension;
+  }
+  row = get_basis() + n_legendre * leading_dimension;
+  for (const double d : associated_legendre_coefficients) {
+    for (size_t m = 0; m < n_directions; ++m) {
+      result[m] += d * row[m];
+    }
+    row += leading_dimension;
+  }
+}
+
+void AngleSet::allocate() {
+  if (n_directions == 0) {
+    throw invalid_argument("At least one direction is required.");
+  }
+  if (nu_max < 0 || nu_max % 2) {
+    throw invalid_argument("nu_max must be a nonnegative even number.");
+  }
+
+  // Value-initialization of the cache lines sets the padding to zero.
+  basis.resize(get_n_rows() * leading_dimension / alignment);
+}
+
+void AngleSet::calculate_basis(const double *cos_theta,
+                               const double *cos_2phi) {
+  // The rows of the basis are the series of the legendre_series functions
+  // with a single nonzero coefficient, so the conventions are the same as
+  // for the other evaluation functions.
+  vector<double> unit(n_legendre, 0.);
+  for (size_t i = 0; i < n_legendre; ++i) {
+    unit[i] = 1.;
+    legendre_series::legendre(n_directions, cos_theta, i + 1, unit.data(),
+                              get_row(i));
+    if (i + 1 < n_legendre) {
+      double *row = get_row(n_legendre + i);
+      legendre_series::associated_legendre_2(n_directions, cos_theta, i + 1,
+                                             unit.data(), row);
+      for (size_t m = 0; m < n_directions; ++m) {
+        row[m] *= cos_2phi[m];
+      }
+    }
+    unit[i] = 0.;
+  }
+}
@@ -17,41 +17,406 @@
     Copyright (C) 2021-2023 Udo Friman-Gayer
 */
 
+#include <algorithm>
+
+using std::fill;
+using std::max;
+using std::min;
+
+#include <cmath>
+
+#include <cstdint>
+
+using std::uint32_t;
+using std::uint64_t;
+
+#include <cstring>
+
+using std::memcmp;
+using std::memcpy;
+
+#include <limits>
+
+using std::numeric_limits;
+
+#include <memory>
+
+using std::allocate_shared;
+using std::const_pointer_cast;
+using std::dynamic_pointer_cast;
+using std::make_shared;
+using std::static_pointer_cast;
+
+#include <optional>
+
+using std::optional;
+
 #include <stdexcept>
 
 using std::invalid_argument;
+using std::out_of_range;
 
 #include <string>
 
+using std::string;
 using std::to_string;
 
+#include <type_traits>
+
+using std::decay_t;
+using std::is_same_v;
+
+#include <utility>
+
+using std::move;
+
+#include <variant>
+
+using std::visit;
+
 #include "AngularCorrelation.hh"
+#include "CInterface.hh"
+#include "CoefficientTable.hh"
 #include "EulerAngleRotation.hh"
+#include "HandleTable.hh"
+#include "LegendreSeries.hh"
+#include "RotatedAngularCorrelation.hh"
 #include "TestUtilities.hh"
+#include "ThreadPool.hh"
 #include "W_dir_dir.hh"
 #include "W_pol_dir.hh"
 
+using c_interface::copy_message;
+
+namespace {
+
+/*
+    Report a failed check. The message is only formatted if it was requested,
+    because validate() is called for many invalid candidates in hypothesis
+    scans.
+*/
+template <typename F>
+CascadeStatus report(const CascadeStatus status, string *message,
+                     F format_message) {
+  if (message != nullptr) {
+    *message = format_message();
+  }
+  return status;
+}
+
+const char serialization_magic[8] = {'A', 'L', 'P', 'A', 'C', 'A', 'A', 'C'};
+const uint32_t serialization_byte_order_mark = 0x01020304;
+
+/*
+    Serialization of an angular correlation, see
+    AngularCorrelation::serialize(). The quantum numbers of the cascade use the same record as the files of
+    CoefficientTable.
+*/
+template <typename T> void append(vector<char> &data, const T &value) {
+  const char *bytes = reinterpret_cast<const char *>(&value);
+  data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+void append_values(vector<char> &data, const vector<double> &values) {
+  append<uint64_t>(data, values.size());
+  for (auto value : values) {
+    append(data, value);
+  }
+}
+
+template <typename T>
+T read(const char *data, const size_t size, size_t &position) {
+  if (size - position < sizeof(T)) {
+    throw invalid_argument("Serialized angular correlation is truncated.");
+  }
+  T value;
+  memcpy(&value, data + position, sizeof(T));
+  position += sizeof(T);
+  return value;
+}
+
+vector<double> read_values(const char *data, const size_t size,
+                           size_t &position) {
+  const uint64_t n_values = read<uint64_t>(data, size, position);
+  if (n_values > (size - position) / sizeof(double)) {
+    throw invalid_argument("Serialized angular correlation is truncated.");
+  }
+  vector<double> values(n_values);
+  memcpy(values.data(), data + position, n_values * sizeof(double));
+  position += n_values * sizeof(double);
+  return values;
+}
+
+} // namespace
+
 AngularCorrelation::AngularCorrelation(
     const State ini_sta, const vector<pair<Transition, State>> cas_ste)
     : w_gamma_gamma(nullptr) {
   check_cascade(ini_sta, cas_ste);
 
-  if (cas_ste[0].first.em_char == em_unknown) {
-    w_gamma_gamma = std::make_unique<W_dir_dir>(ini_sta, cas_ste);
-  } else {
-    w_gamma_gamma = std::make_unique<W_pol_dir>(ini_sta, cas_ste);
-  }
+  set_w_gamma_gamma(create_w_gamma_gamma(ini_sta, cas_ste));
 }
 
 AngularCorrelation::AngularCorrelation(const State ini_sta,
                                        const vector<State> cas_sta)
     : w_gamma_gamma(nullptr) {
 
-  if (cas_sta.size() < 2) {
+  string message;
+  if (validate(ini_sta, cas_sta, &message) != cascade_valid) {
+    throw invalid_argument(message);
+  }
+
+  set_w_gamma_gamma(
+      create_w_gamma_gamma(ini_sta, infer_transitions(ini_sta, cas_sta)));
+}
+
+CascadeStatus
+AngularCorrelation::try_create(const State ini_sta,
+                               const vector<pair<Transition, State>> &cas_ste,
+                               unique_ptr<AngularCorrelation> &ang_cor,
+                               string *message) {
+  ang_cor.reset();
+
+  const CascadeStatus status = validate(ini_sta, cas_ste, message);
+  if (status == cascade_valid) {
+    ang_cor.reset(new AngularCorrelation());
+    ang_cor->set_w_gamma_gamma(create_w_gamma_gamma(ini_sta, cas_ste));
+  }
+
+  return status;
+}
+
+CascadeStatus AngularCorrelation::try_create(
+    const State ini_sta, const vector<State> &cas_sta,
+    unique_ptr<AngularCorrelation> &ang_cor, string *message) {
+  ang_cor.reset();
+
+  const CascadeStatus status = validate(ini_sta, cas_sta, message);
+  if (status == cascade_valid) {
+    ang_cor.reset(new AngularCorrelation());
+    ang_cor->set_w_gamma_gamma(
+        create_w_gamma_gamma(ini_sta, infer_transitions(ini_sta, cas_sta)));
+  }
+
+  return status;
+}
+
+CascadeStatus AngularCorrelation::try_create(
+    const State ini_sta, const vector<pair<Transition, State>> &cas_ste,
+    optional<AngularCorrelation> &ang_cor,
+    const BatchArena::Allocator<char> &allocator, string *message) {
+  ang_cor.reset();
+
+  const CascadeStatus status = validate(ini_sta, cas_ste, message);
+  if (status == cascade_valid) {
+    ang_cor = AngularCorrelation();
+    ang_cor->set_w_gamma_gamma(
+        create_w_gamma_gamma(ini_sta, cas_ste, allocator));
+  }
+
+  return status;
+}
+
+CascadeStatus AngularCorrelation::try_create(
+    const State ini_sta, const vector<State> &cas_sta,
+    optional<AngularCorrelation> &ang_cor,
+    const BatchArena::Allocator<char> &allocator, string *message) {
+  ang_cor.reset();
+
+  const CascadeStatus status = validate(ini_sta, cas_sta, message);
+  if (status == cascade_valid) {
+    ang_cor = AngularCorrelation();
+    ang_cor->set_w_gamma_gamma(create_w_gamma_gamma(
+        ini_sta, infer_transitions(ini_sta, cas_sta), allocator));
+  }
+
+  return status;
+}
+
+// Room for a W_pol_dir object and its W_dir_dir object, and for the control
+// blocks of their shared pointers, which contain a copy of the allocator.
+const size_t AngularCorrelation::batch_arena_slot_size =
+    sizeof(W_pol_dir) + sizeof(W_dir_dir) +
+    2 * (4 * sizeof(void *) + sizeof(BatchArena::Allocator<char>));
+
+shared_ptr<const W_gamma_gamma> AngularCorrelation::create_w_gamma_gamma(
+    const State ini_sta, const vector<pair<Transition, State>> &cas_ste) {
+  // The objects are not created const, so that set_delta() can modify an
+  // object that is not shared.
+  if (cas_ste[0].first.em_char == em_unknown) {
+    return make_shared<W_dir_dir>(ini_sta, cas_ste);
+  }
+  return make_shared<W_pol_dir>(ini_sta, cas_ste);
+}
+
+shared_ptr<const W_gamma_gamma> AngularCorrelation::create_w_gamma_gamma(
+    const State ini_sta, const vector<pair<Transition, State>> &cas_ste,
+    const BatchArena::Allocator<char> &allocator) {
+  const shared_ptr<W_dir_dir> w_dir_dir =
+      allocate_shared<W_dir_dir>(allocator, ini_sta, cas_ste);
+  if (cas_ste[0].first.em_char == em_unknown) {
+    return w_dir_dir;
+  }
+  return allocate_shared<W_pol_dir>(allocator, ini_sta, cas_ste, w_dir_dir);
+}
+
+void AngularCorrelation::set_delta(const size_t step, const double delta) {
+  shared_ptr<W_gamma_gamma> w;
+  if (w_gamma_gamma.use_count() == 1) {
+    w = const_pointer_cast<W_gamma_gamma>(w_gamma_gamma);
+  } else if (const shared_ptr<const W_pol_dir> w_pol_dir =
+                 dynamic_pointer_cast<const W_pol_dir>(w_gamma_gamma)) {
+    w = make_shared<W_pol_dir>(*w_pol_dir);
+  } else {
+    w = make_shared<W_dir_dir>(
+        *static_pointer_cast<const W_dir_dir>(w_gamma_gamma));
+  }
+
+  w->set_delta(step, delta);
+  set_w_gamma_gamma(w);
+}
+
+void AngularCorrelation::set_polarization_degree(const double P) {
+  const bool unique = w_gamma_gamma.use_count() == 1;
+  const shared_ptr<const W_pol_dir> w_pol_dir =
+      dynamic_pointer_cast<const W_pol_dir>(w_gamma_gamma);
+  if (!w_pol_dir) {
+    throw invalid_argument("The degree of polarization can only be set for "
+                           "a pol-dir correlation.");
+  }
+
+  shared_ptr<W_pol_dir> w;
+  if (unique) {
+    w = const_pointer_cast<W_pol_dir>(w_pol_dir);
+  } else {
+    w = make_shared<W_pol_dir>(*w_pol_dir);
+  }
+
+  w->set_polarization_degree(P);
+  set_w_gamma_gamma(w);
+}
+
+double AngularCorrelation::get_polarization_degree() const {
+  const shared_ptr<const W_pol_dir> w_pol_dir =
+      dynamic_pointer_cast<const W_pol_dir>(w_gamma_gamma);
+  return w_pol_dir ? w_pol_dir->get_polarization_degree() : 0.;
+}
+
+vector<char> AngularCorrelation::serialize() const {
+  const shared_ptr<const W_pol_dir> w_pol_dir =
+      dynamic_pointer_cast<const W_pol_dir>(w_gamma_gamma);
+  const State initial_state = get_initial_state();
+  const vector<pair<Transition, State>> cascade_steps = get_cascade_steps();
+
+  vector<char> data(serialization_magic,
+                    serialization_magic + sizeof(serialization_magic));
+  append<uint32_t>(data, serialization_version);
+  append<uint32_t>(data, serialization_byte_order_mark);
+  append<uint32_t>(data, cascade_steps.size());
+  append<uint32_t>(data, w_pol_dir ? 1 : 0);
+
+  append(data, CoefficientTable::QuantumNumbers{
+                   initial_state.two_J, initial_state.parity, em_unknown, 0,
+                   em_unknown, 0, 0.});
+  for (const auto &cas_ste : cascade_steps) {
+    append(data, CoefficientTable::QuantumNumbers{
+                     cas_ste.second.two_J, cas_ste.second.parity,
+                     cas_ste.first.em_char, cas_ste.first.two_L,
+                     cas_ste.first.em_charp, cas_ste.first.two_Lp,
+                     cas_ste.first.delta});
+  }
+
+  if (w_pol_dir) {
+    append(data, w_pol_dir->get_polarization_degree());
+    append_values(data, w_pol_dir->get_w_dir_dir().get_coefficient_values());
+    append_values(data, w_pol_dir->get_coefficient_values());
+  } else {
+    append_values(data, static_pointer_cast<const W_dir_dir>(w_gamma_gamma)
+                            ->get_coefficient_values());
+  }
+
+  return data;
+}
+
+AngularCorrelation AngularCorrelation::deserialize(const char *data,
+                                                   const size_t size) {
+  if (size < sizeof(serialization_magic) ||
+      memcmp(data, serialization_magic, sizeof(serialization_magic)) != 0) {
+    throw invalid_argument("Data are not a serialized angular correlation.");
+  }
+  size_t position = sizeof(serialization_magic);
+  if (read<uint32_t>(data, size, position) != serialization_version) {
+    throw invalid_argument("Serialized angular correlation has an "
+                           "unsupported format version.");
+  }
+  if (read<uint32_t>(data, size, position) !=
+      serialization_byte_order_mark) {
     throw invalid_argument(
-        "Cascade must have at least two transition - state pairs.");
+        "Serialized angular correlation has a different byte order.");
+  }
+  const uint32_t n_cascade_steps = read<uint32_t>(data, size, position);
+  const bool pol_dir = read<uint32_t>(data, size, position) != 0;
+  if (n_cascade_steps >=
+      (size - position) / sizeof(CoefficientTable::QuantumNumbers)) {
+    throw invalid_argument("Serialized angular correlation is truncated.");
   }
 
+  const CoefficientTable::QuantumNumbers q_ini =
+      read<CoefficientTable::QuantumNumbers>(data, size, position);
+  const State initial_state(q_ini.two_J, (Parity)q_ini.parity);
+  vector<pair<Transition, State>> cascade_steps;
+  for (uint32_t i = 0; i < n_cascade_steps; ++i) {
+    const CoefficientTable::QuantumNumbers q =
+        read<CoefficientTable::QuantumNumbers>(data, size, position);
+    cascade_steps.push_back(
+        {Transition((EMCharacter)q.em_char, q.two_L, (EMCharacter)q.em_charp,
+                    q.two_Lp, q.delta),
+         State(q.two_J, (Parity)q.parity)});
+  }
+
+  string message;
+  if (validate(initial_state, cascade_steps, &message) != cascade_valid) {
+    throw invalid_argument(message);
+  }
+  if (pol_dir != (cascade_steps[0].first.em_char != em_unknown)) {
+    throw invalid_argument("Type of the serialized angular correlation does "
+                           "not match the cascade.");
+  }
+
+  shared_ptr<W_gamma_gamma> w;
+  if (pol_dir) {
+    const double polarization_degree = read<double>(data, size, position);
+    const vector<double> dir_dir_values = read_values(data, size, position);
+    const vector<double> values = read_values(data, size, position);
+    const shared_ptr<W_pol_dir> w_pol_dir = make_shared<W_pol_dir>(
+        initial_state, cascade_steps, dir_dir_values, values);
+    w_pol_dir->set_polarization_degree(polarization_degree);
+    w = w_pol_dir;
+  } else {
+    w = make_shared<W_dir_dir>(initial_state, cascade_steps,
+                               read_values(data, size, position));
+  }
+  if (position != size) {
+    throw invalid_argument(
+        "Serialized angular correlation is followed by additional data.");
+  }
+
+  AngularCorrelation ang_cor;
+  ang_cor.set_w_gamma_gamma(w);
+  return ang_cor;
+}
+
+void AngularCorrelation::set_w_gamma_gamma(
+    shared_ptr<const W_gamma_gamma> w) {
+  w_gamma_gamma = w;
+  w_gamma_gamma_fixed = make_w_gamma_gamma_fixed(
+      w->get_nu_max(), w->get_legendre_coefficients(),
+      w->get_associated_legendre_coefficients());
+}
+
+vector<pair<Transition, State>>
+AngularCorrelation::infer_transitions(const State ini_sta,
+                                      const vector<State> &cas_sta) {
   vector<pair<Transition, State>> cascade_steps;
 
   cascade_steps.push_back(
@@ -62,15 +427,10 @@ AngularCorrelation::AngularCorrelation(const State ini_sta,
         {infer_transition({cas_sta[i], cas_sta[i + 1]}), cas_sta[i + 1]});
   }
 
-  if (cascade_steps[0].first.em_char == em_unknown) {
-    w_gamma_gamma = std::make_unique<W_dir_dir>(ini_sta, cascade_steps);
-  } else {
-    w_gamma_gamma = std::make_unique<W_pol_dir>(ini_sta, cascade_steps);
-  }
+  return cascade_steps;
 }
-
 Transition
-AngularCorrelation::infer_transition(const pair<State, State> states) const {
+AngularCorrelation::infer_transition(const pair<State, State> states) {
 
   if (states.first.two_J == 0 and states.second.two_J == 0) {
     throw invalid_argument(
@@ -110,167 +470,497 @@ AngularCorrelation::infer_transition(const pair<State, State> states) const {
 
 double AngularCorrelation::operator()(const double theta,
                                       const double phi) const {
-  return w_gamma_gamma->operator()(theta, phi);
+  return visit(
+      [&](const auto &w) -> double {
+        if constexpr (is_same_v<decay_t<decltype(w)>, monostate>) {
+          return w_gamma_gamma->operator()(theta, phi);
+        } else {
+          return w(theta, phi);
+        }
+      },
+      w_gamma_gamma_fixed);
+}
+
+double AngularCorrelation::operator()(const double theta, const double phi,
+                                      const vector<double> &deltas) const {
+  return w_gamma_gamma->operator()(theta, phi, deltas);
+}
+
+void AngularCorrelation::scan_deltas(const size_t n_deltas,
+                                     const double *deltas,
+                                     const size_t n_angles,
+                                     const double *theta, const double *phi,
+                                     double *result) const {
+
+  const size_t n_cascade_steps = w_gamma_gamma->get_cascade_steps().size();
+
+  vector<double> cos_theta(n_angles);
+  for (size_t i = 0; i < n_angles; ++i) {
+    cos_theta[i] = cos(theta[i]);
+  }
+
+  vector<double> deltas_k(n_cascade_steps);
+  for (size_t k = 0; k < n_deltas; ++k) {
+    deltas_k.assign(deltas + k * n_cascade_steps,
+                    deltas + (k + 1) * n_cascade_steps);
+    w_gamma_gamma->evaluate_cos_theta(n_angles, cos_theta.data(), phi,
+                                      deltas_k, result + k * n_angles);
+  }
+}
+
+namespace {
+
+void check_PQ(const double PQ) {
+  if (!(fabs(PQ) <= 1.)) {
+    throw invalid_argument(
+        "The absolute value of PQ must be smaller than or equal to 1.");
+  }
+}
+
+/**
+ * \brief Store the directions \f$\left( \theta, \varphi \right)\f$ of all
+ * pairs, followed by the directions \f$\left( \theta^\prime,
+ * \varphi^\prime \right)\f$.
+ */
+void concatenate_directions(const size_t n_angles, const double *theta,
+                            const double *thetap, const double *phi,
+                            const double *phip, vector<double> &theta_thetap,
+                            vector<double> &phi_phip) {
+  theta_thetap.assign(theta, theta + n_angles);
+  theta_thetap.insert(theta_thetap.end(), thetap, thetap + n_angles);
+  phi_phip.assign(phi, phi + n_angles);
+  phi_phip.insert(phi_phip.end(), phip, phip + n_angles);
+}
+
+/**
+ * \brief Calculate the analyzing power from the values of W in the
+ * directions of concatenate_directions().
+ */
+void combine_analyzing_power(const size_t n_angles, const double *w,
+                             const double sign_PQ, double *result) {
+  for (size_t i = 0; i < n_angles; ++i) {
+    result[i] =
+        sign_PQ * (w[i] - w[n_angles + i]) / (w[i] + w[n_angles + i]);
+  }
+}
+
+} // namespace
+
+void AngularCorrelation::analyzing_power(
+    const size_t n_angles, const double *theta, const double *thetap,
+    const double *phi, const double *phip, const double PQ,
+    const AnalyzingPowerConvention convention, double *result) const {
+
+  check_PQ(PQ);
+
+  vector<double> theta_thetap, phi_phip;
+  concatenate_directions(n_angles, theta, thetap, phi, phip, theta_thetap,
+                         phi_phip);
+  vector<double> w(2 * n_angles);
+  evaluate(2 * n_angles, theta_thetap.data(), phi_phip.data(), w.data());
+
+  combine_analyzing_power(n_angles, w.data(), convention * PQ, result);
+}
+
+void AngularCorrelation::scan_analyzing_power(
+    const size_t n_deltas, const double *deltas, const size_t n_angles,
+    const double *theta, const double *thetap, const double *phi,
+    const double *phip, const double PQ,
+    const AnalyzingPowerConvention convention, double *result) const {
+
+  check_PQ(PQ);
+
+  vector<double> theta_thetap, phi_phip;
+  concatenate_directions(n_angles, theta, thetap, phi, phip, theta_thetap,
+                         phi_phip);
+  vector<double> w(2 * n_angles * n_deltas);
+  scan_deltas(n_deltas, deltas, 2 * n_angles, theta_thetap.data(),
+              phi_phip.data(), w.data());
+
+  for (size_t k = 0; k < n_deltas; ++k) {
+    combine_analyzing_power(n_angles, w.data() + 2 * k * n_angles,
+                            convention * PQ, result + k * n_angles);
+  }
+}
+
+vector<double>
+AngularCorrelation::evaluate_with_gradient(const double theta, const double phi,
+                                           const vector<double> &deltas) const {
+
+  vector<double> result(deltas.size() + 3);
+  w_gamma_gamma->evaluate_with_gradient(1, &theta, &phi, deltas, result.data(),
+                                        result.data() + 1);
+
+  return result;
+}
+
+void AngularCorrelation::evaluate(const size_t n, const double *theta,
+                                  const double *phi,
+                                  const array<double, 3> Phi_Theta_Psi,
+                                  double *result) const {
+
+  // Number of directions that are transformed before the angular correlation
+  // is evaluated for all of them at once.
+  constexpr size_t block_size = 64;
+
+  // The inverse of a rotation matrix is its transpose.
+  const euler_angle_transform::RotationMatrix A_inv =
+      euler_angle_transform::transpose(
+          euler_angle_transform::rotation_matrix(Phi_Theta_Psi));
+
+  double theta_rot[block_size], phi_rot[block_size];
+
+  for (size_t start = 0; start < n; start += block_size) {
+    const size_t m = min(block_size, n - start);
+
+    for (size_t k = 0; k < m; ++k) {
+      const double sin_theta = sin(theta[start + k]);
+      const array<double, 3> r_rot = euler_angle_transform::apply(
+          A_inv, {sin_theta * cos(phi[start + k]),
+                  sin_theta * sin(phi[start + k]), cos(theta[start + k])});
+      theta_rot[k] = acos(max(-1., min(1., r_rot[2])));
+      phi_rot[k] = atan2(r_rot[1], r_rot[0]);
+    }
+
+    w_gamma_gamma->evaluate(m, theta_rot, phi_rot, result + start);
+  }
+}
+
+void AngularCorrelation::evaluate_grid(const size_t n_theta,
+                                       const double *theta,
+                                       const size_t n_phi, const double *phi,
+                                       double *result) const {
+  const vector<double> legendre_coefficients = get_legendre_coefficients();
+  const vector<double> associated_legendre_coefficients =
+      get_associated_legendre_coefficients();
+
+  vector<double> cos_theta(n_theta), a(n_theta), b(n_theta, 0.);
+  for (size_t i = 0; i < n_theta; ++i) {
+    cos_theta[i] = cos(theta[i]);
+  }
+  legendre_series::legendre(n_theta, cos_theta.data(),
+                            legendre_coefficients.size(),
+                            legendre_coefficients.data(), a.data());
+
+  if (associated_legendre_coefficients.empty()) {
+    for (size_t i = 0; i < n_theta; ++i) {
+      fill(result + i * n_phi, result + (i + 1) * n_phi, a[i]);
+    }
+    return;
+  }
+
+  legendre_series::associated_legendre_2(
+      n_theta, cos_theta.data(), associated_legendre_coefficients.size(),
+      associated_legendre_coefficients.data(), b.data());
+  vector<double> cos_2phi(n_phi);
+  for (size_t j = 0; j < n_phi; ++j) {
+    cos_2phi[j] = cos(2. * phi[j]);
+  }
+
+  for (size_t i = 0; i < n_theta; ++i) {
+    double *row = result + i * n_phi;
+    const double a_i = a[i], b_i = b[i];
+    for (size_t j = 0; j < n_phi; ++j) {
+      row[j] = a_i + b_i * cos_2phi[j];
+    }
+  }
+}
+
+void AngularCorrelation::evaluate_grid(const size_t n_theta,
+                                       const double *theta,
+                                       const size_t n_phi, const double *phi,
+                                       const array<double, 3> Phi_Theta_Psi,
+                                       double *result) const {
+  RotatedAngularCorrelation(*this, Phi_Theta_Psi)
+      .evaluate_grid(n_theta, theta, n_phi, phi, result);
+}
+
+namespace {
+
+/**
+ * \brief Calculate \f$\cos \left( 2 \varphi \right)\f$ from the x and y
+ * components of a vector.
+ */
+inline double cos_2phi_from_xy(const double x, const double y) {
+  const double r_perp_2 = x * x + y * y;
+  return r_perp_2 > 0. ? (x * x - y * y) / r_perp_2 : 1.;
+}
+
+} // namespace
+
+double AngularCorrelation::evaluate(const array<double, 3> &direction) const {
+  const double cos_2phi = cos_2phi_from_xy(direction[0], direction[1]);
+  return visit(
+      [&](const auto &w) -> double {
+        if constexpr (is_same_v<decay_t<decltype(w)>, monostate>) {
+          double result;
+          w_gamma_gamma->evaluate_cos_theta_cos_2phi(1, &direction[2],
+                                                     &cos_2phi, &result);
+          return result;
+        } else {
+          return w.evaluate_cos_theta_cos_2phi(direction[2], cos_2phi);
+        }
+      },
+      w_gamma_gamma_fixed);
+}
+
+void AngularCorrelation::evaluate(const size_t n, const double *xyz,
+                                  double *result) const {
+
+  double cos_theta[legendre_series::block_size],
+      cos_2phi[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+    const double *r = xyz + 3 * start;
+
+    for (size_t k = 0; k < m; ++k) {
+      cos_theta[k] = r[3 * k + 2];
+      cos_2phi[k] = cos_2phi_from_xy(r[3 * k], r[3 * k + 1]);
+    }
+
+    w_gamma_gamma->evaluate_cos_theta_cos_2phi(m, cos_theta, cos_2phi,
+                                               result + start);
+  }
+}
+
+void AngularCorrelation::evaluate(const size_t n, const double *xyz,
+                                  const array<double, 3> Phi_Theta_Psi,
+                                  double *result) const {
+
+  const euler_angle_transform::RotationMatrix A_inv =
+      euler_angle_transform::transpose(
+          euler_angle_transform::rotation_matrix(Phi_Theta_Psi));
+
+  double cos_theta[legendre_series::block_size],
+      cos_2phi[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+    const double *r = xyz + 3 * start;
+
+    for (size_t k = 0; k < m; ++k) {
+      const array<double, 3> r_rot = euler_angle_transform::apply(
+          A_inv, {r[3 * k], r[3 * k + 1], r[3 * k + 2]});
+      cos_theta[k] = max(-1., min(1., r_rot[2]));
+      cos_2phi[k] = cos_2phi_from_xy(r_rot[0], r_rot[1]);
+    }
+
+    w_gamma_gamma->evaluate_cos_theta_cos_2phi(m, cos_theta, cos_2phi,
+                                               result + start);
+  }
+}
+
+double AngularCorrelation::integrate_cone(const array<double, 2> theta_phi,
+                                          const double opening_angle) const {
+  double result;
+  integrate_cone(1, &theta_phi[0], &theta_phi[1], &opening_angle, &result);
+
+  return result;
+}
+
+void AngularCorrelation::integrate_cone(const size_t n, const double *theta,
+                                        const double *phi,
+                                        const double *opening_angle,
+                                        double *result) const {
+
+  vector<double> attenuation(w_gamma_gamma->get_nu_max() / 2 + 1);
+  vector<double> cos_theta;
+
+  size_t start = 0;
+  while (start < n) {
+    size_t end = start + 1;
+    while (end < n && opening_angle[end] == opening_angle[start]) {
+      ++end;
+    }
+
+    legendre_series::cone_integrals(attenuation.size(),
+                                    cos(opening_angle[start]),
+                                    attenuation.data());
+    cos_theta.resize(end - start);
+    for (size_t k = start; k < end; ++k) {
+      cos_theta[k - start] = cos(theta[k]);
+    }
+    w_gamma_gamma->evaluate_attenuated_cos_theta(
+        end - start, cos_theta.data(), phi + start, attenuation.data(),
+        result + start);
+
+    start = end;
+  }
 }
 
 void AngularCorrelation::check_cascade(
-    const State ini_sta, const vector<pair<Transition, State>> cas_ste) const {
+    const State ini_sta, const vector<pair<Transition, State>> &cas_ste) {
+
+  string message;
+  if (validate(ini_sta, cas_ste, &message) != cascade_valid) {
+    throw invalid_argument(message);
+  }
+}
+
+CascadeStatus
+AngularCorrelation::validate(const State ini_sta,
+                             const vector<pair<Transition, State>> &cas_ste,
+                             string *message) {
 
   if (cas_ste.size() < 2) {
-    throw invalid_argument(
-        "Cascade must have at least two transition - state pairs.");
+    return report(cascade_too_short, message, []() -> string {
+      return "Cascade must have at least two transition - state pairs.";
+    });
+  }
+
+  CascadeStatus status = check_angular_momenta(ini_sta, cas_ste, message);
+  if (status != cascade_valid) {
+    return status;
+  }
+
+  status = check_triangle_inequalities(ini_sta, cas_ste, message);
+  if (status != cascade_valid) {
+    return status;
+  }
+
+  return check_em_transitions(ini_sta, cas_ste, message);
+}
+
+CascadeStatus AngularCorrelation::validate(const State ini_sta,
+                                           const vector<State> &cas_sta,
+                                           string *message) {
+
+  if (cas_sta.size() < 2) {
+    return report(cascade_too_short, message, []() -> string {
+      return "Cascade must have at least two transition - state pairs.";
+    });
   }
 
-  check_angular_momenta(ini_sta, cas_ste);
+  const int even_odd = ini_sta.two_J % 2;
+  State previous_state = ini_sta;
 
-  check_triangle_inequalities(ini_sta, cas_ste);
+  for (auto state : cas_sta) {
+    if (state.two_J % 2 != even_odd) {
+      return report(cascade_mixed_spins, message, []() -> string {
+        return "Unphysical mixing of half-integer and integer spins in "
+               "cascade.";
+      });
+    }
+    if (previous_state.two_J == 0 && state.two_J == 0) {
+      return report(cascade_spin_0_to_0, message, []() -> string {
+        return "An electromagnetic transition between two spin-0 states with "
+               "the absorption/emission of a single photon is not possible.";
+      });
+    }
+    previous_state = state;
+  }
 
-  check_em_transitions(ini_sta, cas_ste);
+  return cascade_valid;
 }
 
-void AngularCorrelation::check_angular_momenta(
-    const State ini_sta, const vector<pair<Transition, State>> cas_ste) const {
+CascadeStatus AngularCorrelation::check_angular_momenta(
+    const State ini_sta, const vector<pair<Transition, State>> &cas_ste,
+    string *message) {
 
   const int even_odd = ini_sta.two_J % 2;
 
   for (size_t i = 0; i < cas_ste.size(); ++i) {
     if (cas_ste[i].second.two_J % 2 != even_odd) {
-      throw invalid_argument(
-          "Unphysical mixing of half-integer and integer spins in cascade.");
+      return report(cascade_mixed_spins, message, []() -> string {
+        return "Unphysical mixing of half-integer and integer spins in "
+               "cascade.";
+      });
     }
   }
+
+  return cascade_valid;
 }
 
-void AngularCorrelation::check_triangle_inequalities(
-    const State ini_sta, const vector<pair<Transition, State>> cas_ste) const {
+CascadeStatus AngularCorrelation::check_triangle_inequalities(
+    const State ini_sta, const vector<pair<Transition, State>> &cas_ste,
+    string *message) {
 
-  if (!fulfils_triangle_inequality<int>(ini_sta.two_J, cas_ste[0].second.two_J,
-                                        cas_ste[0].first.two_L) &&
-      !fulfils_triangle_inequality<int>(ini_sta.two_J, cas_ste[0].second.two_J,
-                                        cas_ste[0].first.two_Lp)) {
-    throw invalid_argument(
-        "Triangle inequality selection rule not fulfilled for any "
-        "multipolarity of transition #1: " +
-        cas_ste[0].first.str_rep(ini_sta, cas_ste[0].second));
-  }
-
-  for (size_t i = 1; i < cas_ste.size(); ++i) {
-    if (!fulfils_triangle_inequality<int>(cas_ste[i - 1].second.two_J,
-                                          cas_ste[i].second.two_J,
-                                          cas_ste[i].first.two_L) &&
-        !fulfils_triangle_inequality<int>(cas_ste[i - 1].second.two_J,
-                                          cas_ste[i].second.two_J,
-                                          cas_ste[i].first.two_Lp)) {
-      throw invalid_argument(
-          "Triangle inequality selection rule not fulfilled for any "
-          "multipolarity of transition #" +
-          cas_ste[i].first.str_rep(cas_ste[i - 1].second, cas_ste[i].second));
+  for (size_t i = 0; i < cas_ste.size(); ++i) {
+    const State &initial_state = i == 0 ? ini_sta : cas_ste[i - 1].second;
+    const State &final_state = cas_ste[i].second;
+    const Transition &transition = cas_ste[i].first;
+
+    if (!fulfils_triangle_inequality<int>(
+            initial_state.two_J, final_state.two_J, transition.two_L) &&
+        !fulfils_triangle_inequality<int>(
+            initial_state.two_J, final_state.two_J, transition.two_Lp)) {
+      return report(cascade_triangle_inequality, message, [&]() {
+        return "Triangle inequality selection rule not fulfilled for any "
+               "multipolarity of transition #" +
+               to_string(i + 1) + ": " +
+               transition.str_rep(initial_state, final_state);
+      });
     }
   }
+
+  return cascade_valid;
 }
 
-void AngularCorrelation::check_em_transitions(
-    const State ini_sta, const vector<pair<Transition, State>> cas_ste) const {
+CascadeStatus AngularCorrelation::check_em_transitions(
+    const State ini_sta, const vector<pair<Transition, State>> &cas_ste,
+    string *message) {
 
-  if (ini_sta.parity != parity_unknown &&
-      cas_ste[0].second.parity != parity_unknown) {
-    if (cas_ste[0].first.em_char != em_unknown) {
-      if (!valid_em_character(ini_sta.parity, cas_ste[0].second.parity,
-                              cas_ste[0].first.two_L,
-                              cas_ste[0].first.em_char)) {
-        throw invalid_argument(
-            "Incorrect electromagnetic character '" +
-            Transition::em_str_rep(cas_ste[0].first.em_char) +
-            "' for transition #1: " +
-            cas_ste[0].first.str_rep(ini_sta, cas_ste[0].second));
-      }
+  for (size_t i = 0; i < cas_ste.size(); ++i) {
+    const State &initial_state = i == 0 ? ini_sta : cas_ste[i - 1].second;
+    const State &final_state = cas_ste[i].second;
+    const Transition &transition = cas_ste[i].first;
 
-      if (cas_ste[0].first.em_charp != em_unknown) {
-        if (!valid_em_character(ini_sta.parity, cas_ste[0].second.parity,
-                                cas_ste[0].first.two_Lp,
-                                cas_ste[0].first.em_charp)) {
-          throw invalid_argument(
-              "Incorrect electromagnetic character '" +
-              Transition::em_str_rep(cas_ste[0].first.em_charp) +
-              "' for transition #1: " +
-              cas_ste[0].first.str_rep(ini_sta, cas_ste[0].second));
-        }
-      } else {
-        throw invalid_argument(
-            "Only one electromagnetic character defined for transition #1: " +
-            cas_ste[0].first.str_rep(ini_sta, cas_ste[0].second));
+    if (initial_state.parity != parity_unknown &&
+        final_state.parity != parity_unknown) {
+      // Leaving both EM characters of the first transition undefined selects
+      // the dir-dir correlation.
+      if (i == 0 && transition.em_char == em_unknown &&
+          transition.em_charp == em_unknown) {
+        continue;
       }
-    }
 
-    if (cas_ste[0].first.em_char == em_unknown &&
-        cas_ste[0].first.em_charp != em_unknown) {
-      throw invalid_argument(
-          "Only one electromagnetic character defined for transition #1: " +
-          cas_ste[0].first.str_rep(ini_sta, cas_ste[0].second));
-    }
-  } else if (cas_ste[0].first.em_char != em_unknown ||
-             cas_ste[0].first.em_charp != em_unknown) {
-    throw invalid_argument(
-        "Electromagnetic character defined, but one or both parities missing "
-        "for transition #1: " +
-        cas_ste[0].first.str_rep(ini_sta, cas_ste[0].second));
-  }
-
-  for (size_t i = 1; i < cas_ste.size(); ++i) {
-    if (cas_ste[i - 1].second.parity != parity_unknown &&
-        cas_ste[i].second.parity != parity_unknown) {
-      if (cas_ste[i].first.em_char != em_unknown) {
-        if (!valid_em_character(
-                cas_ste[i - 1].second.parity, cas_ste[i].second.parity,
-                cas_ste[i].first.two_L, cas_ste[i].first.em_char)) {
-          throw invalid_argument(
-              "Incorrect electromagnetic character '" +
-              Transition::em_str_rep(cas_ste[0].first.em_char) +
-              "' for transition #" + to_string(i + 1) + ": " +
-              cas_ste[i].first.str_rep(cas_ste[i - 1].second,
-                                       cas_ste[i].second));
-        }
+      if (transition.em_char == em_unknown ||
+          transition.em_charp == em_unknown) {
+        return report(cascade_incomplete_em_character, message, [&]() {
+          return "Only one electromagnetic character defined for "
+                 "transition #" +
+                 to_string(i + 1) + ": " +
+                 transition.str_rep(initial_state, final_state);
+        });
       }
 
-      if (cas_ste[i].first.em_charp != em_unknown) {
-        if (!valid_em_character(
-                cas_ste[i - 1].second.parity, cas_ste[i].second.parity,
-                cas_ste[i].first.two_Lp, cas_ste[i].first.em_charp)) {
-          throw invalid_argument(
-              "Incorrect electromagnetic character '" +
-              Transition::em_str_rep(cas_ste[0].first.em_charp) +
-              "' for transition #" + to_string(i + 1) + ": " +
-              cas_ste[i].first.str_rep(cas_ste[i - 1].second,
-                                       cas_ste[i].second));
-        }
-      } else {
-        throw invalid_argument(
-            "Only one electromagnetic character defined for transition #" +
-            to_string(i + 1) + ": " +
-            cas_ste[i].first.str_rep(cas_ste[i - 1].second, cas_ste[i].second));
+      if (!valid_em_character(initial_state.parity, final_state.parity,
+                              transition.two_L, transition.em_char)) {
+        return report(cascade_invalid_em_character, message, [&]() {
+          return "Incorrect electromagnetic character '" +
+                 Transition::em_str_rep(transition.em_char) +
+                 "' for transition #" + to_string(i + 1) + ": " +
+                 transition.str_rep(initial_state, final_state);
+        });
       }
 
-      if (cas_ste[i].first.em_char == em_unknown &&
-          cas_ste[i].first.em_charp != em_unknown) {
-        throw invalid_argument(
-            "Only one electromagnetic character defined for transition #" +
-            to_string(i + 1) + ": " +
-            cas_ste[i].first.str_rep(cas_ste[i - 1].second, cas_ste[i].second));
+      if (!valid_em_character(initial_state.parity, final_state.parity,
+                              transition.two_Lp, transition.em_charp)) {
+        return report(cascade_invalid_em_character, message, [&]() {
+          return "Incorrect electromagnetic character '" +
+                 Transition::em_str_rep(transition.em_charp) +
+                 "' for transition #" + to_string(i + 1) + ": " +
+                 transition.str_rep(initial_state, final_state);
+        });
       }
-    } else if (cas_ste[i].first.em_char != em_unknown ||
-               cas_ste[i].first.em_charp != em_unknown) {
-      throw invalid_argument(
-          "Electromagnetic character defined, but one or both parities missing "
-          "for transition #" +
-          to_string(i + 1) + ": " +
-          cas_ste[i].first.str_rep(cas_ste[i - 1].second, cas_ste[i].second));
+    } else if (transition.em_char != em_unknown ||
+               transition.em_charp != em_unknown) {
+      return report(cascade_missing_parity, message, [&]() {
+        return "Electromagnetic character defined, but one or both parities "
+               "missing for transition #" +
+               to_string(i + 1) + ": " +
+               transition.str_rep(initial_state, final_state);
+      });
     }
   }
+
+  return cascade_valid;
 }
 
 bool AngularCorrelation::valid_em_character(const Parity p0, const Parity p1,
                                             const int two_L,
-                                            const EMCharacter em) const {
+                                            const EMCharacter em) {
 
   if (p0 == p1) {
     if ((two_L / 2) % 2 == 0) {
@@ -295,70 +985,540 @@ bool AngularCorrelation::valid_em_character(const Parity p0, const Parity p1,
   return true;
 }
 
-extern "C" {
-double angular_correlation(const double theta, const double phi,
-                           const size_t n_cas_ste, int *two_J, short *par,
-                           short *em_char, int *two_L, short *em_charp,
-                           int *two_Lp, double *delta) {
-  State initial_state{two_J[0], (Parity)par[0]};
-  vector<pair<Transition, State>> cascade_steps;
+namespace {
+
+/*
+    Check the raw quantum numbers from the C interface before any State or
+    Transition object is constructed, since their constructors throw for
+    invalid values. The arrays for the transitions may be null pointers for
+    the constructor with transition inference.
+*/
+CascadeStatus check_quantum_numbers(const size_t n_cas_ste, const int *two_J,
+                                    const short *par, const short *em_char,
+                                    const int *two_L, const short *em_charp,
+                                    const int *two_Lp, string *message) {
+  for (size_t i = 0; i <= n_cas_ste; ++i) {
+    if (two_J[i] < 0 || par[i] < negative || par[i] > positive) {
+      return report(cascade_invalid_quantum_number, message, [&]() {
+        return "Invalid spin or parity of state #" + to_string(i + 1) + ".";
+      });
+    }
+  }
+
+  if (em_char == nullptr) {
+    return cascade_valid;
+  }
 
   for (size_t i = 0; i < n_cas_ste; ++i) {
-    cascade_steps.push_back(
-        {Transition{(EMCharacter)em_char[i], two_L[i], (EMCharacter)em_charp[i],
-                    two_Lp[i], delta[i]},
-         State{two_J[i + 1], (Parity)par[i + 1]}});
+    if (two_L[i] < 1 || two_Lp[i] < 1 || two_L[i] == two_Lp[i] ||
+        em_char[i] < electric || em_char[i] > magnetic ||
+        em_charp[i] < electric || em_charp[i] > magnetic) {
+      return report(cascade_invalid_quantum_number, message, [&]() {
+        return "Invalid multipolarities or EM characters of transition #" +
+               to_string(i + 1) + ".";
+      });
+    }
   }
 
-  return AngularCorrelation(initial_state, cascade_steps)
-      .
-      operator()(theta, phi);
+  return cascade_valid;
 }
 
-void *create_angular_correlation(const size_t n_cas_ste, int *two_J, short *par,
-                                 short *em_char, int *two_L, short *em_charp,
-                                 int *two_Lp, double *delta) {
+/*
+    Check the quantum numbers of a cascade from the C interface, and call
+    process with the initial state and the cascade states (if em_char is a
+    null pointer) or the cascade steps.
+*/
+template <typename Process>
+CascadeStatus process_cascade(const size_t n_cas_ste, const int *two_J,
+                              const short *par, const short *em_char,
+                              const int *two_L, const short *em_charp,
+                              const int *two_Lp, const double *delta,
+                              string *message, const Process &process) {
+  const CascadeStatus status = check_quantum_numbers(
+      n_cas_ste, two_J, par, em_char, two_L, em_charp, two_Lp, message);
+  if (status != cascade_valid) {
+    return status;
+  }
 
   State initial_state{two_J[0], (Parity)par[0]};
+
+  if (em_char == nullptr) {
+    vector<State> cascade_states;
+
+    for (size_t i = 0; i < n_cas_ste; ++i) {
+      cascade_states.push_back({State{two_J[i + 1], (Parity)par[i + 1]}});
+    }
+
+    return process(initial_state, cascade_states);
+  }
+
   vector<pair<Transition, State>> cascade_steps;
 
   for (size_t i = 0; i < n_cas_ste; ++i) {
     cascade_steps.push_back(
         {Transition{(EMCharacter)em_char[i], two_L[i], (EMCharacter)em_charp[i],
-                    two_Lp[i], delta[i]},
+                    two_Lp[i], delta == nullptr ? 0. : delta[i]},
          State{two_J[i + 1], (Parity)par[i + 1]}});
   }
 
-  return new AngularCorrelation(initial_state, cascade_steps);
+  return process(initial_state, cascade_steps);
 }
 
-void *
-create_angular_correlation_with_transition_inference(const size_t n_cas_ste,
-                                                     int *two_J, short *par) {
+/*
+    Validate the cascade from the C interface and, if ang_cor is not a null
+    pointer, construct the angular correlation.
+*/
+CascadeStatus create(const size_t n_cas_ste, const int *two_J,
+                     const short *par, const short *em_char, const int *two_L,
+                     const short *em_charp, const int *two_Lp,
+                     const double *delta,
+                     unique_ptr<AngularCorrelation> *ang_cor,
+                     string *message) {
+  if (ang_cor != nullptr) {
+    ang_cor->reset();
+  }
 
-  State initial_state{two_J[0], (Parity)par[0]};
-  vector<State> cascade_states;
+  return process_cascade(
+      n_cas_ste, two_J, par, em_char, two_L, em_charp, two_Lp, delta, message,
+      [&](const State &initial_state, const auto &cascade) {
+        if (ang_cor == nullptr) {
+          return AngularCorrelation::validate(initial_state, cascade, message);
+        }
+        return AngularCorrelation::try_create(initial_state, cascade, *ang_cor,
+                                              message);
+      });
+}
 
-  for (size_t i = 0; i < n_cas_ste; ++i) {
-    cascade_states.push_back({State{two_J[i + 1], (Parity)par[i + 1]}});
+/*
+    Evaluate an angular correlation for many directions with the ThreadPool.
+*/
+void evaluate_in_parallel(const AngularCorrelation &ang_cor, const size_t n,
+                          const double *theta, const double *phi,
+                          double *result) {
+  ThreadPool::parallel_for(n, [&](const size_t begin, const size_t end) {
+    ang_cor.evaluate(end - begin, theta + begin, phi + begin, result + begin);
+  });
+}
+
+/*
+    Arena of the angular correlations of the handle-based C interface. It is
+    never destroyed, so that finalizers of the Python bindings may still
+    release handles while the process exits.
+*/
+HandleTable<AngularCorrelation> &angular_correlation_handles() {
+  static HandleTable<AngularCorrelation> *table =
+      new HandleTable<AngularCorrelation>();
+  return *table;
+}
+
+} // namespace
+
+void c_interface::copy_message(const string &message,
+                               const size_t message_length,
+                               char *message_buffer) {
+  if (message_buffer == nullptr || message_length == 0) {
+    return;
+  }
+  const size_t n = min(message.size(), message_length - 1);
+  message.copy(message_buffer, n);
+  message_buffer[n] = '\0';
+}
+
+extern "C" {
+double angular_correlation(const double theta, const double phi,
+                           const size_t n_cas_ste, int *two_J, short *par,
+                           short *em_char, int *two_L, short *em_charp,
+                           int *two_Lp, double *delta,
+                           double *Phi_Theta_Psi) {
+  unique_ptr<AngularCorrelation> ang_cor;
+  if (create(n_cas_ste, two_J, par, em_char, two_L, em_charp, two_Lp, delta,
+             &ang_cor, nullptr) != cascade_valid) {
+    return numeric_limits<double>::quiet_NaN();
+  }
+
+  return RotatedAngularCorrelation(
+      *ang_cor, {Phi_Theta_Psi[0], Phi_Theta_Psi[1], Phi_Theta_Psi[2]})(theta,
+                                                                        phi);
+}
+
+int evaluate_angular_correlations(const size_t n_cascades, size_t *offsets,
+                                  int *two_J, short *par, short *em_char,
+                                  int *two_L, short *em_charp, int *two_Lp,
+                                  double *delta, const size_t n_angles,
+                                  double *theta, double *phi, double *result) {
+
+  vector<CascadeStatus> statuses(n_cascades);
+
+  const auto evaluate_cascades = [&](const size_t begin, const size_t end) {
+    unique_ptr<AngularCorrelation> ang_cor;
+    for (size_t k = begin; k < end; ++k) {
+      // The states of cascade k start at offsets[k] + k, since each cascade
+      // has one more state than transitions.
+      const size_t first_step = offsets[k];
+      const size_t first_state = offsets[k] + k;
+
+      statuses[k] =
+          create(offsets[k + 1] - offsets[k], two_J + first_state,
+                 par + first_state, em_char + first_step, two_L + first_step,
+                 em_charp + first_step, two_Lp + first_step,
+                 delta + first_step, &ang_cor, nullptr);
+
+      if (statuses[k] != cascade_valid) {
+        fill(result + k * n_angles, result + (k + 1) * n_angles,
+             numeric_limits<double>::quiet_NaN());
+        continue;
+      }
+
+      evaluate_in_parallel(*ang_cor, n_angles, theta, phi,
+                           result + k * n_angles);
+    }
+  };
+
+  // With at least one cascade per thread, the cascades are distributed among
+  // the threads, and the construction of an angular correlation is counted as
+  // 1000 evaluations. Otherwise, the evaluation of each cascade is
+  // parallelized.
+  if (n_cascades >= ThreadPool::get_n_threads()) {
+    ThreadPool::parallel_for(n_cascades, evaluate_cascades, n_angles + 1000);
+  } else {
+    evaluate_cascades(0, n_cascades);
+  }
+
+  for (auto status : statuses) {
+    if (status != cascade_valid) {
+      return status;
+    }
   }
+  return cascade_valid;
+}
+
+int validate_cascade(const size_t n_cas_ste, int *two_J, short *par,
+                     short *em_char, int *two_L, short *em_charp, int *two_Lp,
+                     const size_t message_length, char *message) {
+  string error_message;
+  const CascadeStatus status =
+      create(n_cas_ste, two_J, par, em_char, two_L, em_charp, two_Lp, nullptr,
+             nullptr, message == nullptr ? nullptr : &error_message);
+  copy_message(error_message, message_length, message);
+
+  return status;
+}
+
+void *try_create_angular_correlation(const size_t n_cas_ste, int *two_J,
+                                     short *par, short *em_char, int *two_L,
+                                     short *em_charp, int *two_Lp,
+                                     double *delta, int *status,
+                                     const size_t message_length,
+                                     char *message) {
+  unique_ptr<AngularCorrelation> ang_cor;
+  string error_message;
+  const CascadeStatus cascade_status =
+      create(n_cas_ste, two_J, par, em_char, two_L, em_charp, two_Lp, delta,
+             &ang_cor, message == nullptr ? nullptr : &error_message);
+
+  if (status != nullptr) {
+    *status = cascade_status;
+  }
+  copy_message(error_message, message_length, message);
+
+  return ang_cor.release();
+}
 
-  return new AngularCorrelation(initial_state, cascade_states);
+void *try_create_angular_correlation_with_transition_inference(
+    const size_t n_cas_ste, int *two_J, short *par, int *status,
+    const size_t message_length, char *message) {
+  return try_create_angular_correlation(n_cas_ste, two_J, par, nullptr,
+                                        nullptr, nullptr, nullptr, nullptr,
+                                        status, message_length, message);
+}
+
+void *create_angular_correlation(const size_t n_cas_ste, int *two_J, short *par,
+                                 short *em_char, int *two_L, short *em_charp,
+                                 int *two_Lp, double *delta) {
+  return try_create_angular_correlation(n_cas_ste, two_J, par, em_char, two_L,
+                                        em_charp, two_Lp, delta, nullptr, 0,
+                                        nullptr);
+}
+
+void *
+create_angular_correlation_with_transition_inference(const size_t n_cas_ste,
+                                                     int *two_J, short *par) {
+  return try_create_angular_correlation_with_transition_inference(
+      n_cas_ste, two_J, par, nullptr, 0, nullptr);
 }
 
 void evaluate_angular_correlation(AngularCorrelation *angular_correlation,
                                   const size_t n_angles, double *theta,
                                   double *phi, double *result) {
 
-  for (size_t i = 0; i < n_angles; ++i) {
-    result[i] = angular_correlation->operator()(theta[i], phi[i]);
+  evaluate_in_parallel(*angular_correlation, n_angles, theta, phi, result);
+}
+
+void evaluate_angular_correlation_rotated(
+    AngularCorrelation *angular_correlation, const size_t n_angles,
+    double *theta, double *phi, double *Phi_Theta_Psi, double *result) {
+
+  // The rotation is applied to the expansion of the angular correlation once,
+  // instead of to every direction.
+  const RotatedAngularCorrelation rotated_angular_correlation(
+      *angular_correlation,
+      {Phi_Theta_Psi[0], Phi_Theta_Psi[1], Phi_Theta_Psi[2]});
+  ThreadPool::parallel_for(n_angles, [&](const size_t begin, const size_t end) {
+    rotated_angular_correlation.evaluate(end - begin, theta + begin,
+                                         phi + begin, result + begin);
+  });
+}
+
+void evaluate_angular_correlation_grid(AngularCorrelation *angular_correlation,
+                                       const size_t n_theta, double *theta,
+                                       const size_t n_phi, double *phi,
+                                       double *Phi_Theta_Psi,
+                                       double *result) {
+
+  // The rows of the grid are distributed among the threads. Without Euler
+  // angles (Phi_Theta_Psi is a null pointer), the angular correlation is not
+  // rotated.
+  optional<RotatedAngularCorrelation> rotated_angular_correlation;
+  if (Phi_Theta_Psi != nullptr) {
+    rotated_angular_correlation.emplace(
+        *angular_correlation,
+        array<double, 3>{Phi_Theta_Psi[0], Phi_Theta_Psi[1], Phi_Theta_Psi[2]});
   }
+  ThreadPool::parallel_for(
+      n_theta,
+      [&](const size_t begin, const size_t end) {
+        if (rotated_angular_correlation) {
+          rotated_angular_correlation->evaluate_grid(
+              end - begin, theta + begin, n_phi, phi, result + begin * n_phi);
+        } else {
+          angular_correlation->evaluate_grid(end - begin, theta + begin, n_phi,
+                                             phi, result + begin * n_phi);
+        }
+      },
+      n_phi);
+}
+
+void evaluate_angular_correlation_with_deltas(
+    AngularCorrelation *angular_correlation, const size_t n_angles,
+    double *theta, double *phi, double *delta, double *result) {
+
+  angular_correlation->scan_deltas(1, delta, n_angles, theta, phi, result);
+}
+
+void evaluate_angular_correlation_delta_scan(
+    AngularCorrelation *angular_correlation, const size_t n_deltas,
+    double *delta, const size_t n_angles, double *theta, double *phi,
+    double *result) {
+
+  angular_correlation->scan_deltas(n_deltas, delta, n_angles, theta, phi,
+                                   result);
+}
+
+void analyzing_power_delta_scan(AngularCorrelation *angular_correlation,
+                                const size_t n_deltas, double *delta,
+                                const double theta, const double thetap,
+                                const double phi, const double phip,
+                                const double PQ, double *result) {
+
+  // The sign of the convention is contained in PQ.
+  angular_correlation->scan_analyzing_power(n_deltas, delta, 1, &theta,
+                                            &thetap, &phi, &phip, fabs(PQ),
+                                            PQ < 0. ? kpz_convention
+                                                    : natural_convention,
+                                            result);
+}
+
+void analyzing_power_grid(AngularCorrelation *angular_correlation,
+                          const size_t n_deltas, double *delta,
+                          const size_t n_angles, double *theta,
+                          double *thetap, double *phi, double *phip,
+                          const double PQ, const int convention,
+                          double *result) {
+
+  const AnalyzingPowerConvention conv =
+      convention < 0 ? kpz_convention : natural_convention;
+
+  // Without mixing ratios, the ones of the cascade are used.
+  if (delta == nullptr) {
+    ThreadPool::parallel_for(
+        n_angles,
+        [&](const size_t begin, const size_t end) {
+          angular_correlation->analyzing_power(
+              end - begin, theta + begin, thetap + begin, phi + begin,
+              phip + begin, PQ, conv, result + begin);
+        },
+        2);
+    return;
+  }
+
+  const size_t n_cascade_steps =
+      angular_correlation->get_cascade_steps().size();
+  ThreadPool::parallel_for(
+      n_deltas,
+      [&](const size_t begin, const size_t end) {
+        angular_correlation->scan_analyzing_power(
+            end - begin, delta + begin * n_cascade_steps, n_angles, theta,
+            thetap, phi, phip, PQ, conv, result + begin * n_angles);
+      },
+      2 * n_angles);
+}
+
+void evaluate_angular_correlation_with_gradient(
+    AngularCorrelation *angular_correlation, const size_t n_angles,
+    double *theta, double *phi, double *delta, double *result,
+    double *gradient) {
+
+  const size_t n_cascade_steps =
+      angular_correlation->get_cascade_steps().size();
+  angular_correlation->evaluate_with_gradient(
+      n_angles, theta, phi, vector<double>(delta, delta + n_cascade_steps),
+      result, gradient);
+}
+
+void integrate_angular_correlation_cone(
+    AngularCorrelation *angular_correlation, const size_t n_cones,
+    double *theta, double *phi, double *opening_angle, double *result) {
+
+  angular_correlation->integrate_cone(n_cones, theta, phi, opening_angle,
+                                      result);
 }
 
 void free_angular_correlation(AngularCorrelation *angular_correlation) {
   delete angular_correlation;
 }
 
+uint64_t try_create_angular_correlation_handle(
+    const size_t n_cas_ste, int *two_J, short *par, short *em_char, int *two_L,
+    short *em_charp, int *two_Lp, double *delta, int *status,
+    const size_t message_length, char *message) {
+  unique_ptr<AngularCorrelation> ang_cor;
+  string error_message;
+  const CascadeStatus cascade_status =
+      create(n_cas_ste, two_J, par, em_char, two_L, em_charp, two_Lp, delta,
+             &ang_cor, message == nullptr ? nullptr : &error_message);
+
+  if (status != nullptr) {
+    *status = cascade_status;
+  }
+  copy_message(error_message, message_length, message);
+
+  if (cascade_status != cascade_valid) {
+    return HandleTable<AngularCorrelation>::invalid_handle;
+  }
+  return angular_correlation_handles().insert(move(*ang_cor));
+}
+
+int create_angular_correlation_handles(const size_t n_cascades,
+                                       size_t *offsets, int *two_J, short *par,
+                                       short *em_char, int *two_L,
+                                       short *em_charp, int *two_Lp,
+                                       double *delta, uint64_t *handles) {
+  vector<CascadeStatus> statuses(n_cascades);
+  vector<optional<AngularCorrelation>> angular_correlations(n_cascades);
+  // The W_dir_dir and W_pol_dir objects of all cascades share one block of
+  // memory, which is released with the last of them.
+  const shared_ptr<BatchArena> arena = make_shared<BatchArena>(
+      n_cascades, AngularCorrelation::batch_arena_slot_size);
+
+  // Without information about the transitions (em_char is a null pointer),
+  // the transitions are inferred, and all arrays of the transitions are
+  // ignored.
+  const auto create_cascades = [&](const size_t begin, const size_t end) {
+    for (size_t k = begin; k < end; ++k) {
+      const size_t first_step = offsets[k];
+      const size_t first_state = offsets[k] + k;
+      const bool inference = em_char == nullptr;
+      const BatchArena::Allocator<char> allocator(arena, k);
+
+      statuses[k] = process_cascade(
+          offsets[k + 1] - offsets[k], two_J + first_state, par + first_state,
+          inference ? nullptr : em_char + first_step,
+          inference ? nullptr : two_L + first_step,
+          inference ? nullptr : em_charp + first_step,
+          inference ? nullptr : two_Lp + first_step,
+          (inference || delta == nullptr) ? nullptr : delta + first_step,
+          nullptr, [&](const State &initial_state, const auto &cascade) {
+            return AngularCorrelation::try_create(
+                initial_state, cascade, angular_correlations[k], allocator);
+          });
+    }
+  };
+
+  // The construction of a single angular correlation is worth a range of its
+  // own.
+  ThreadPool::parallel_for(n_cascades, create_cascades,
+                           ThreadPool::get_min_work());
+
+  angular_correlation_handles().insert(n_cascades, angular_correlations.data(),
+                                       handles);
+
+  for (auto status : statuses) {
+    if (status != cascade_valid) {
+      return status;
+    }
+  }
+  return cascade_valid;
+}
+
+void *get_angular_correlation_from_handle(const uint64_t handle) {
+  return angular_correlation_handles().get(handle);
+}
+
+int retain_angular_correlation_handle(const uint64_t handle) {
+  return angular_correlation_handles().retain(handle);
+}
+
+int release_angular_correlation_handle(const uint64_t handle) {
+  return angular_correlation_handles().release(handle);
+}
+
+size_t release_angular_correlation_handles(const size_t n, uint64_t *handles) {
+  return angular_correlation_handles().release(n, handles);
+}
+
+int set_angular_correlation_delta(AngularCorrelation *angular_correlation,
+                                  const size_t step, const double delta) {
+  try {
+    angular_correlation->set_delta(step, delta);
+  } catch (const out_of_range &e) {
+    return 0;
+  }
+  return 1;
+}
+
+size_t serialize_angular_correlation(AngularCorrelation *angular_correlation,
+                                     char *buffer, const size_t buffer_size) {
+  const vector<char> data = angular_correlation->serialize();
+  if (buffer != nullptr && buffer_size >= data.size()) {
+    memcpy(buffer, data.data(), data.size());
+  }
+  return data.size();
+}
+
+uint64_t deserialize_angular_correlation_handle(const char *data,
+                                                const size_t size) {
+  try {
+    return angular_correlation_handles().insert(
+        AngularCorrelation::deserialize(data, size));
+  } catch (const invalid_argument &e) {
+    return HandleTable<AngularCorrelation>::invalid_handle;
+  }
+}
+
+int set_angular_correlation_polarization_degree(
+    AngularCorrelation *angular_correlation, const double P) {
+  try {
+    angular_correlation->set_polarization_degree(P);
+  } catch (const invalid_argument &e) {
+    return 0;
+  }
+  return 1;
+}
+
+size_t get_n_angular_correlation_handles() {
+  return angular_correlation_handles().size();
+}
+
 void get_em_char(AngularCorrelation *angular_correlation, short *em_char) {
 
   vector<pair<Transition, State>> cascade_steps =
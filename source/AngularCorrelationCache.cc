@@ -0,0 +1,193 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cmath>
+
+using std::isfinite;
+using std::round;
+
+#include <cstring>
+
+using std::memcpy;
+
+#include <functional>
+
+using std::hash;
+
+#include <memory>
+
+using std::make_shared;
+
+#include <mutex>
+
+using std::lock_guard;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include "AngularCorrelationCache.hh"
+
+AngularCorrelationCache::AngularCorrelationCache(const size_t cap,
+                                                 const double delta_res)
+    : capacity(cap), hits(0), misses(0), evictions(0),
+      delta_resolution(delta_res) {
+  if (!(delta_resolution >= 0.)) {
+    throw invalid_argument("delta_resolution must be nonnegative.");
+  }
+}
+
+size_t AngularCorrelationCache::KeyHash::operator()(const Key &key) const {
+  size_t seed = 0;
+  for (auto k : key) {
+    seed ^= hash<uint64_t>{}(k) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  }
+  return seed;
+}
+
+uint64_t AngularCorrelationCache::delta_key(const double delta) const {
+  double value = delta;
+  if (delta_resolution > 0. && isfinite(delta)) {
+    value = round(delta / delta_resolution);
+  }
+  // Map -0 to +0.
+  if (value == 0.) {
+    value = 0.;
+  }
+
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+AngularCorrelationCache::Key AngularCorrelationCache::create_key(
+    const State ini_sta, const vector<pair<Transition, State>> &cas_ste) const {
+  Key key;
+  key.reserve(2 + 7 * cas_ste.size());
+
+  key.push_back((uint64_t)ini_sta.two_J);
+  key.push_back((uint64_t)ini_sta.parity);
+  for (auto step : cas_ste) {
+    key.push_back((uint64_t)step.first.em_char);
+    key.push_back((uint64_t)step.first.two_L);
+    key.push_back((uint64_t)step.first.em_charp);
+    key.push_back((uint64_t)step.first.two_Lp);
+    key.push_back(delta_key(step.first.delta));
+    key.push_back((uint64_t)step.second.two_J);
+    key.push_back((uint64_t)step.second.parity);
+  }
+
+  return key;
+}
+
+shared_ptr<const AngularCorrelation>
+AngularCorrelationCache::get(const State ini_sta,
+                             const vector<pair<Transition, State>> &cas_ste) {
+  const Key key = create_key(ini_sta, cas_ste);
+
+  {
+    lock_guard<mutex> lock(cache_mutex);
+    const auto entry = index.find(key);
+    if (entry != index.end()) {
+      ++hits;
+      entries.splice(entries.begin(), entries, entry->second);
+      return entry->second->second;
+    }
+    ++misses;
+  }
+
+  // The construction is the expensive part, therefore the lock is released.
+  // It throws for invalid cascades, which are not cached.
+  shared_ptr<const AngularCorrelation> ang_cor =
+      make_shared<const AngularCorrelation>(ini_sta, cas_ste);
+
+  lock_guard<mutex> lock(cache_mutex);
+  if (capacity == 0) {
+    return ang_cor;
+  }
+
+  // Another thread may have inserted the same cascade in the meantime.
+  const auto entry = index.find(key);
+  if (entry != index.end()) {
+    entries.splice(entries.begin(), entries, entry->second);
+    return entry->second->second;
+  }
+
+  entries.emplace_front(key, ang_cor);
+  index.emplace(key, entries.begin());
+  shrink();
+
+  return ang_cor;
+}
+
+void AngularCorrelationCache::shrink() {
+  while (entries.size() > capacity) {
+    index.erase(entries.back().first);
+    entries.pop_back();
+    ++evictions;
+  }
+}
+
+size_t AngularCorrelationCache::get_hits() const {
+  lock_guard<mutex> lock(cache_mutex);
+  return hits;
+}
+
+size_t AngularCorrelationCache::get_misses() const {
+  lock_guard<mutex> lock(cache_mutex);
+  return misses;
+}
+
+double AngularCorrelationCache::get_hit_rate() const {
+  lock_guard<mutex> lock(cache_mutex);
+  if (hits + misses == 0) {
+    return 0.;
+  }
+  return (double)hits / (double)(hits + misses);
+}
+
+size_t AngularCorrelationCache::get_evictions() const {
+  lock_guard<mutex> lock(cache_mutex);
+  return evictions;
+}
+
+size_t AngularCorrelationCache::size() const {
+  lock_guard<mutex> lock(cache_mutex);
+  return entries.size();
+}
+
+size_t AngularCorrelationCache::get_capacity() const {
+  lock_guard<mutex> lock(cache_mutex);
+  return capacity;
+}
+
+void AngularCorrelationCache::set_capacity(const size_t cap) {
+  lock_guard<mutex> lock(cache_mutex);
+  capacity = cap;
+  shrink();
+}
+
+void AngularCorrelationCache::clear() {
+  lock_guard<mutex> lock(cache_mutex);
+  entries.clear();
+  index.clear();
+  hits = 0;
+  misses = 0;
+  evictions = 0;
+}
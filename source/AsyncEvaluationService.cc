@@ -0,0 +1,202 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <exception>
+
+using std::current_exception;
+using std::exception_ptr;
+
+#include <iterator>
+
+using std::make_move_iterator;
+
+#include <mutex>
+
+using std::lock_guard;
+using std::unique_lock;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <unordered_map>
+
+using std::unordered_map;
+
+#include <utility>
+
+using std::move;
+
+#include "AngularCorrelation.hh"
+#include "AsyncEvaluationService.hh"
+
+AsyncEvaluationService::AsyncEvaluationService(
+    const unsigned int n_workers, const microseconds max_bat_del,
+    const size_t max_bat_siz, shared_ptr<AngularCorrelationCache> cac)
+    : max_batch_delay(max_bat_del), max_batch_size(max_bat_siz),
+      cache(move(cac)) {
+  if (max_batch_size == 0) {
+    throw invalid_argument("Maximum batch size must be positive.");
+  }
+  if (cache == nullptr) {
+    throw invalid_argument("Cache must not be a null pointer.");
+  }
+
+  const unsigned int n =
+      n_workers ? n_workers : max(1u, thread::hardware_concurrency());
+  workers.reserve(n);
+  for (unsigned int i = 0; i < n; ++i) {
+    workers.emplace_back(&AsyncEvaluationService::work, this);
+  }
+}
+
+AsyncEvaluationService::~AsyncEvaluationService() {
+  {
+    lock_guard<mutex> lock(queue_mutex);
+    stopping = true;
+  }
+  request_available.notify_all();
+  for (auto &t : workers) {
+    t.join();
+  }
+}
+
+future<vector<double>> AsyncEvaluationService::submit(
+    const State ini_sta, const vector<pair<Transition, State>> &cas_ste,
+    vector<double> theta, vector<double> phi) {
+  if (theta.size() != phi.size()) {
+    throw invalid_argument("theta and phi must have the same length.");
+  }
+
+  promise<vector<double>> result;
+  future<vector<double>> fut = result.get_future();
+  {
+    lock_guard<mutex> lock(queue_mutex);
+    pending.push_back(Request{ini_sta, cas_ste, move(theta), move(phi),
+                              move(result), steady_clock::now()});
+  }
+  request_available.notify_one();
+
+  return fut;
+}
+
+void AsyncEvaluationService::work() {
+  vector<Request> batch;
+  unique_lock<mutex> lock(queue_mutex);
+
+  while (true) {
+    request_available.wait(lock,
+                           [this] { return stopping || !pending.empty(); });
+    if (pending.empty()) {
+      return;
+    }
+
+    // Give other requests the chance to join the batch, but not longer than
+    // the maximum delay of the oldest one.
+    request_available.wait_until(
+        lock, pending.front().arrival + max_batch_delay, [this] {
+          return stopping || pending.size() >= max_batch_size;
+        });
+    // Another worker may have taken the requests in the meantime.
+    if (pending.empty()) {
+      continue;
+    }
+
+    const size_t n = min(max_batch_size, pending.size());
+    batch.assign(make_move_iterator(pending.begin()),
+                 make_move_iterator(pending.begin() + n));
+    pending.erase(pending.begin(), pending.begin() + n);
+    if (!pending.empty()) {
+      request_available.notify_one();
+    }
+
+    lock.unlock();
+    process(batch);
+    batch.clear();
+    lock.lock();
+  }
+}
+
+void AsyncEvaluationService::process(vector<Request> &batch) {
+  // Requests grouped by their angular correlation. Identical cascades share
+  // the same cached object.
+  unordered_map<const AngularCorrelation *, vector<size_t>> groups;
+  vector<shared_ptr<const AngularCorrelation>> angular_correlations(
+      batch.size());
+  vector<exception_ptr> errors(batch.size());
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    try {
+      angular_correlations[i] =
+          cache->get(batch[i].initial_state, batch[i].cascade_steps);
+      groups[angular_correlations[i].get()].push_back(i);
+    } catch (...) {
+      errors[i] = current_exception();
+    }
+  }
+
+  // The statistics are updated before any promise is fulfilled, so they are
+  // up to date for a client that has received its result.
+  n_requests += batch.size();
+  ++n_batches;
+  n_evaluations += groups.size();
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    if (errors[i]) {
+      batch[i].result.set_exception(errors[i]);
+    }
+  }
+
+  vector<double> theta, phi, result;
+  for (const auto &group : groups) {
+    const AngularCorrelation &ang_cor = *group.first;
+    const vector<size_t> &indices = group.second;
+
+    if (indices.size() == 1) {
+      Request &request = batch[indices[0]];
+      vector<double> values(request.theta.size());
+      ang_cor.evaluate(values.size(), request.theta.data(), request.phi.data(),
+                       values.data());
+      request.result.set_value(move(values));
+    } else {
+      theta.clear();
+      phi.clear();
+      for (auto i : indices) {
+        theta.insert(theta.end(), batch[i].theta.begin(), batch[i].theta.end());
+        phi.insert(phi.end(), batch[i].phi.begin(), batch[i].phi.end());
+      }
+      result.resize(theta.size());
+      ang_cor.evaluate(theta.size(), theta.data(), phi.data(), result.data());
+
+      size_t offset = 0;
+      for (auto i : indices) {
+        const size_t n = batch[i].theta.size();
+        batch[i].result.set_value(
+            vector<double>(result.begin() + offset,
+                           result.begin() + offset + n));
+        offset += n;
+      }
+    }
+  }
+}
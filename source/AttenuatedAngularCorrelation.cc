@@ -0,0 +1,113 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::min;
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <string>
+
+using std::to_string;
+
+#include <gsl/gsl_math.h>
+
+#include "AttenuatedAngularCorrelation.hh"
+#include "LegendreSeries.hh"
+
+AttenuatedAngularCorrelation::AttenuatedAngularCorrelation(
+    const AngularCorrelation &ang_cor, const vector<double> &attenuation)
+    : angular_correlation(ang_cor) {
+
+  const size_t n_orders = ang_cor.get_nu_max() / 2 + 1;
+  if (attenuation.size() < n_orders) {
+    throw invalid_argument(
+        "At least " + to_string(n_orders) +
+        " attenuation coefficients required, but only " +
+        to_string(attenuation.size()) + " given.");
+  }
+
+  this->attenuation =
+      vector<double>(attenuation.begin(), attenuation.begin() + n_orders);
+}
+
+AttenuatedAngularCorrelation::AttenuatedAngularCorrelation(
+    const AngularCorrelation &ang_cor, const vector<double> &attenuation_1,
+    const vector<double> &attenuation_2)
+    : AttenuatedAngularCorrelation(ang_cor, attenuation_1) {
+
+  if (attenuation_2.size() < attenuation.size()) {
+    throw invalid_argument(
+        "At least " + to_string(attenuation.size()) +
+        " attenuation coefficients required, but only " +
+        to_string(attenuation_2.size()) + " given.");
+  }
+
+  for (size_t i = 0; i < attenuation.size(); ++i) {
+    attenuation[i] *= attenuation_2[i];
+  }
+}
+
+double AttenuatedAngularCorrelation::operator()(const double theta,
+                                                const double phi) const {
+  double result;
+  evaluate(1, &theta, &phi, &result);
+
+  return result;
+}
+
+void AttenuatedAngularCorrelation::evaluate(const size_t n,
+                                            const double *theta,
+                                            const double *phi,
+                                            double *result) const {
+
+  double cos_theta[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+
+    for (size_t k = 0; k < m; ++k) {
+      cos_theta[k] = cos(theta[start + k]);
+    }
+
+    evaluate_cos_theta(m, cos_theta, phi + start, result + start);
+  }
+}
+
+vector<double> AttenuatedAngularCorrelation::cone_attenuation_coefficients(
+    const int nu_max, const double opening_angle) {
+
+  if (opening_angle <= 0. || opening_angle > M_PI) {
+    throw invalid_argument("Opening angle must be in the interval (0, pi].");
+  }
+
+  vector<double> attenuation(nu_max / 2 + 1);
+  legendre_series::cone_integrals(attenuation.size(), cos(opening_angle),
+                                  attenuation.data());
+  for (size_t i = attenuation.size(); i-- > 0;) {
+    attenuation[i] /= attenuation[0];
+  }
+
+  return attenuation;
+}
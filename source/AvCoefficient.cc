@@ -24,29 +24,101 @@ AvCoefficient::AvCoefficient(const int two_nu, const int two_L,
                              const int two_j)
     : two_nu(two_nu), two_L(two_L), two_Lp(two_Lp), two_jn(two_jn),
       two_j(two_j), constant_f_coefficient(two_nu, two_L, two_L, two_jn, two_j),
-      linear_f_coefficient(two_nu, two_L, two_Lp, two_jn, two_j),
-      quadratic_f_coefficient(two_nu, two_Lp, two_Lp, two_jn, two_j) {
-  constant_coefficient = constant_f_coefficient.get_value();
-  linear_coefficient = 2. * linear_f_coefficient.get_value();
-  quadratic_coefficient = quadratic_f_coefficient.get_value();
-}
+      constant_coefficient(constant_f_coefficient.get_value()),
+      mixed_terms_calculated(false), linear_f_value(0.),
+      quadratic_f_value(0.) {}
+
+AvCoefficient::AvCoefficient(const int two_nu, const int two_L,
+                             const int two_Lp, const int two_jn,
+                             const int two_j,
+                             const array<double, 3> &f_values)
+    : two_nu(two_nu), two_L(two_L), two_Lp(two_Lp), two_jn(two_jn),
+      two_j(two_j),
+      constant_f_coefficient(two_nu, two_L, two_L, two_jn, two_j, f_values[0]),
+      constant_coefficient(constant_f_coefficient.get_value()),
+      mixed_terms_calculated(true), linear_f_value(f_values[1]),
+      quadratic_f_value(f_values[2]) {}
+
+AvCoefficient::AvCoefficient(const AvCoefficient &av_coefficient)
+    : StringRepresentable(av_coefficient), two_nu(av_coefficient.two_nu),
+      two_L(av_coefficient.two_L), two_Lp(av_coefficient.two_Lp),
+      two_jn(av_coefficient.two_jn), two_j(av_coefficient.two_j),
+      constant_f_coefficient(av_coefficient.constant_f_coefficient),
+      constant_coefficient(av_coefficient.constant_coefficient),
+      mixed_terms_calculated(
+          av_coefficient.mixed_terms_calculated.load(memory_order_acquire)),
+      linear_f_value(av_coefficient.linear_f_value.load(memory_order_relaxed)),
+      quadratic_f_value(
+          av_coefficient.quadratic_f_value.load(memory_order_relaxed)) {}
 
 double AvCoefficient::operator()(const double delta) const {
 
-  return constant_coefficient + delta * linear_coefficient +
-         delta * delta * quadratic_coefficient;
+  // For a pure transition, the terms with L' are not needed.
+  if (delta == 0.) {
+    return constant_coefficient;
+  }
+
+  return constant_coefficient + delta * get_linear_coefficient() +
+         delta * delta * get_quadratic_coefficient();
 }
 
-string AvCoefficient::string_representation(
-    const unsigned int n_digits, const vector<string> variable_names) const {
+double AvCoefficient::evaluate(const int two_nu, const int two_L,
+                               const int two_Lp, const int two_jn,
+                               const int two_j, const double delta) {
+  const double constant_coefficient =
+      FCoefficient(two_nu, two_L, two_L, two_jn, two_j).get_value();
+
+  // For a pure transition, the coefficient is a single F coefficient.
+  if (delta == 0.) {
+    return constant_coefficient;
+  }
+
+  // Same order of the operations as in operator()().
+  return constant_coefficient +
+         delta *
+             (2. * FCoefficient(two_nu, two_L, two_Lp, two_jn, two_j)
+                       .get_value()) +
+         delta * delta *
+             FCoefficient(two_nu, two_Lp, two_Lp, two_jn, two_j).get_value();
+}
+
+void AvCoefficient::calculate_mixed_terms() const {
+  linear_f_value.store(
+      FCoefficient(two_nu, two_L, two_Lp, two_jn, two_j).get_value(),
+      memory_order_relaxed);
+  quadratic_f_value.store(
+      FCoefficient(two_nu, two_Lp, two_Lp, two_jn, two_j).get_value(),
+      memory_order_relaxed);
+  mixed_terms_calculated.store(true, memory_order_release);
+}
+
+void AvCoefficient::write_string_representation(
+    string &str_rep, const unsigned int n_digits,
+    const vector<string> &variable_names) const {
+  if (variable_names.size()) {
+    write_string_representation(str_rep, n_digits, variable_names[0]);
+  } else {
+    write_string_representation(str_rep, n_digits, "\\delta");
+  }
+}
 
-  string multipole_mixing_ratio_variable =
-      variable_names.size() ? variable_names[0] : "\\delta";
+void AvCoefficient::write_string_representation(
+    string &str_rep, const unsigned int n_digits,
+    const string &delta_variable) const {
+  const char *times = n_digits ? "\\times" : "";
+  const array<double, 3> f_values = get_f_values();
 
-  return constant_f_coefficient.string_representation(n_digits, {}) + "+" +
-         "2" + (n_digits ? "\\times" : "") +
-         linear_f_coefficient.string_representation(n_digits, {}) +
-         (n_digits ? "\\times" : "") + multipole_mixing_ratio_variable + "+" +
-         quadratic_f_coefficient.string_representation(n_digits, {}) +
-         (n_digits ? "\\times" : "") + multipole_mixing_ratio_variable + "^{2}";
+  constant_f_coefficient.write_string_representation(str_rep, n_digits);
+  str_rep += "+2";
+  str_rep += times;
+  FCoefficient(two_nu, two_L, two_Lp, two_jn, two_j, f_values[1])
+      .write_string_representation(str_rep, n_digits);
+  str_rep += times;
+  str_rep += delta_variable;
+  str_rep += "+";
+  FCoefficient(two_nu, two_Lp, two_Lp, two_jn, two_j, f_values[2])
+      .write_string_representation(str_rep, n_digits);
+  str_rep += times;
+  str_rep += delta_variable;
+  str_rep += "^{2}";
 }
\ No newline at end of file
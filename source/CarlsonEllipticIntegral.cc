@@ -0,0 +1,216 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+
+#include <cmath>
+
+#include <limits>
+
+using std::numeric_limits;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <gsl/gsl_math.h>
+
+#include "CarlsonEllipticIntegral.hh"
+
+namespace {
+
+/**
+ * \brief Bound \f$r\f$ for the relative error of the symmetric integrals
+ * {Eq. (2.2) in Ref. \cite Carlson1995}.
+ */
+double relative_error(const EllipticIntegralPrecision precision) {
+  return precision == double_precision ? 1e-16 : 1e-9;
+}
+
+void check_arguments(const double x, const double y, const double z) {
+  if (x < 0. || y < 0. || z < 0.) {
+    throw invalid_argument(
+        "Arguments of the Carlson integrals must not be negative.");
+  }
+}
+
+/**
+ * \brief Reduce an angle to the range \f$\left[ -\pi / 2, \pi / 2
+ * \right]\f$.
+ *
+ * \return Number \f$k\f$ of half periods that were subtracted.
+ */
+double reduce_angle(double &phi) {
+  if (fabs(phi) <= M_PI_2) {
+    return 0.;
+  }
+  const double k = round(phi / M_PI);
+  phi -= k * M_PI;
+  return k;
+}
+
+} // namespace
+
+namespace carlson_elliptic_integral {
+
+double R_F(double x, double y, double z,
+           const EllipticIntegralPrecision precision) {
+  check_arguments(x, y, z);
+  if (x + y == 0. || y + z == 0. || x + z == 0.) {
+    return numeric_limits<double>::infinity();
+  }
+
+  // Duplication algorithm of Sec. 2 in Ref. \cite Carlson1995.
+  const double x_0 = x, y_0 = y;
+  const double A_0 = (x + y + z) / 3.;
+  double A = A_0;
+  const double Q = pow(3. * relative_error(precision), -1. / 6.) *
+             max(fabs(A_0 - x), max(fabs(A_0 - y), fabs(A_0 - z)));
+  double four_to_minus_n = 1.;
+
+  while (Q * four_to_minus_n >= fabs(A)) {
+    const double sqrt_x = sqrt(x), sqrt_y = sqrt(y), sqrt_z = sqrt(z);
+    const double lambda = sqrt_x * (sqrt_y + sqrt_z) + sqrt_y * sqrt_z;
+    x = 0.25 * (x + lambda);
+    y = 0.25 * (y + lambda);
+    z = 0.25 * (z + lambda);
+    A = 0.25 * (A + lambda);
+    four_to_minus_n *= 0.25;
+  }
+
+  const double X = (A_0 - x_0) / A * four_to_minus_n,
+               Y = (A_0 - y_0) / A * four_to_minus_n;
+  const double Z = -X - Y;
+  const double E_2 = X * Y - Z * Z, E_3 = X * Y * Z;
+
+  return (1. - E_2 / 10. + E_3 / 14. + E_2 * E_2 / 24. -
+          3. * E_2 * E_3 / 44.) /
+         sqrt(A);
+}
+
+double R_D(double x, double y, double z,
+           const EllipticIntegralPrecision precision) {
+  check_arguments(x, y, z);
+  if (z == 0. || x + y == 0.) {
+    return numeric_limits<double>::infinity();
+  }
+
+  // Duplication algorithm of Sec. 2 in Ref. \cite Carlson1995.
+  const double x_0 = x, y_0 = y;
+  const double A_0 = (x + y + 3. * z) / 5.;
+  double A = A_0;
+  const double Q = pow(0.25 * relative_error(precision), -1. / 6.) *
+             max(fabs(A_0 - x), max(fabs(A_0 - y), fabs(A_0 - z)));
+  double four_to_minus_n = 1.;
+  double sum = 0.;
+
+  while (Q * four_to_minus_n >= fabs(A)) {
+    const double sqrt_x = sqrt(x), sqrt_y = sqrt(y), sqrt_z = sqrt(z);
+    const double lambda = sqrt_x * (sqrt_y + sqrt_z) + sqrt_y * sqrt_z;
+    sum += four_to_minus_n / (sqrt_z * (z + lambda));
+    x = 0.25 * (x + lambda);
+    y = 0.25 * (y + lambda);
+    z = 0.25 * (z + lambda);
+    A = 0.25 * (A + lambda);
+    four_to_minus_n *= 0.25;
+  }
+
+  const double X = (A_0 - x_0) / A * four_to_minus_n,
+               Y = (A_0 - y_0) / A * four_to_minus_n;
+  const double Z = -(X + Y) / 3.;
+  const double XY = X * Y, Z_squared = Z * Z;
+  const double E_2 = XY - 6. * Z_squared,
+               E_3 = (3. * XY - 8. * Z_squared) * Z,
+               E_4 = 3. * (XY - Z_squared) * Z_squared,
+               E_5 = XY * Z_squared * Z;
+
+  return four_to_minus_n / (A * sqrt(A)) *
+             (1. - 3. * E_2 / 14. + E_3 / 6. + 9. * E_2 * E_2 / 88. -
+              3. * E_4 / 22. - 9. * E_2 * E_3 / 52. + 3. * E_5 / 26.) +
+         3. * sum;
+}
+
+double F(double phi, const double m,
+         const EllipticIntegralPrecision precision) {
+  const double k = reduce_angle(phi);
+  if (k != 0. && m >= 1.) {
+    throw invalid_argument("F(phi | m) with |phi| > pi / 2 requires m < 1.");
+  }
+
+  const double sin_phi = sin(phi), cos_phi = cos(phi);
+  const double Delta_squared = 1. - m * sin_phi * sin_phi;
+  if (Delta_squared < 0.) {
+    throw invalid_argument("F(phi | m) requires m sin^2(phi) <= 1.");
+  }
+
+  const double F_reduced =
+      sin_phi * R_F(cos_phi * cos_phi, Delta_squared, 1., precision);
+
+  return k == 0. ? F_reduced : F_reduced + 2. * k * complete_K(m, precision);
+}
+
+double E(double phi, const double m,
+         const EllipticIntegralPrecision precision) {
+  const double k = reduce_angle(phi);
+  if (k != 0. && m > 1.) {
+    throw invalid_argument("E(phi | m) with |phi| > pi / 2 requires m <= 1.");
+  }
+
+  const double sin_phi = sin(phi), cos_phi = cos(phi);
+  const double Delta_squared = 1. - m * sin_phi * sin_phi;
+  if (Delta_squared < 0.) {
+    throw invalid_argument("E(phi | m) requires m sin^2(phi) <= 1.");
+  }
+
+  // Eq. (19.6.9) in Ref. \cite DLMF2020, where both R_F and R_D diverge.
+  double E_reduced = sin_phi;
+  if (m != 1.) {
+    const double cos_phi_squared = cos_phi * cos_phi;
+    E_reduced =
+        sin_phi * R_F(cos_phi_squared, Delta_squared, 1., precision) -
+        m / 3. * sin_phi * sin_phi * sin_phi *
+            R_D(cos_phi_squared, Delta_squared, 1., precision);
+  }
+
+  return k == 0. ? E_reduced : E_reduced + 2. * k * complete_E(m, precision);
+}
+
+double complete_K(const double m, const EllipticIntegralPrecision precision) {
+  if (m > 1.) {
+    throw invalid_argument("K(m) requires m <= 1.");
+  }
+
+  return R_F(0., 1. - m, 1., precision);
+}
+
+double complete_E(const double m, const EllipticIntegralPrecision precision) {
+  if (m > 1.) {
+    throw invalid_argument("E(m) requires m <= 1.");
+  }
+  if (m == 1.) {
+    return 1.;
+  }
+
+  return R_F(0., 1. - m, 1., precision) -
+         m / 3. * R_D(0., 1. - m, 1., precision);
+}
+
+} // namespace carlson_elliptic_integral
@@ -0,0 +1,252 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <atomic>
+
+using std::atomic;
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <thread>
+
+using std::thread;
+
+#include "CascadeHypothesisScanner.hh"
+#include "CascadePrefixBuilder.hh"
+#include "LegendreSeries.hh"
+#include "TestUtilities.hh"
+
+CascadeHypothesisScanner::CascadeHypothesisScanner(
+    const vector<vector<State>> &state_candidates, const int max_two_L)
+    : n_levels(state_candidates.size()), max_two_L(max_two_L) {
+
+  if (n_levels < 3) {
+    throw invalid_argument(
+        "Cascade must have at least two transition - state pairs.");
+  }
+
+  // Depth-first enumeration. Each level is only entered with a state that is
+  // connected to the previous one by an acceptable transition.
+  vector<size_t> index(n_levels, 0);
+  vector<State> hypothesis;
+  size_t level = 0;
+  while (true) {
+    if (index[level] == state_candidates[level].size()) {
+      if (level == 0) {
+        break;
+      }
+      index[level] = 0;
+      --level;
+      hypothesis.pop_back();
+      ++index[level];
+      continue;
+    }
+
+    const State &state = state_candidates[level][index[level]];
+    if (level > 0 &&
+        !accept_transition(hypothesis.back(), state, max_two_L)) {
+      ++index[level];
+      continue;
+    }
+
+    hypothesis.push_back(state);
+    if (level == n_levels - 1) {
+      states.insert(states.end(), hypothesis.begin(), hypothesis.end());
+      hypothesis.pop_back();
+      ++index[level];
+    } else {
+      ++level;
+    }
+  }
+}
+
+vector<State> CascadeHypothesisScanner::spin_parity_candidates(
+    const int two_J_min, const int two_J_max, const vector<Parity> &parities) {
+  vector<State> candidates;
+  for (int two_J = two_J_min; two_J <= two_J_max; two_J += 2) {
+    for (auto parity : parities) {
+      candidates.push_back(State(two_J, parity));
+    }
+  }
+  return candidates;
+}
+
+bool CascadeHypothesisScanner::accept_transition(const State &state_0,
+                                                 const State &state_1,
+                                                 const int max_two_L) {
+  if (state_0.two_J % 2 != state_1.two_J % 2) {
+    return false;
+  }
+  if (state_0.two_J == 0 && state_1.two_J == 0) {
+    return false;
+  }
+
+  const Transition transition =
+      AngularCorrelation::infer_transition({state_0, state_1});
+  if (transition.two_L > max_two_L) {
+    return false;
+  }
+
+  if (!fulfils_triangle_inequality<int>(state_0.two_J, state_1.two_J,
+                                        transition.two_L) &&
+      !fulfils_triangle_inequality<int>(state_0.two_J, state_1.two_J,
+                                        transition.two_Lp)) {
+    return false;
+  }
+
+  if (transition.em_char != em_unknown &&
+      (!AngularCorrelation::valid_em_character(state_0.parity, state_1.parity,
+                                               transition.two_L,
+                                               transition.em_char) ||
+       !AngularCorrelation::valid_em_character(state_0.parity, state_1.parity,
+                                               transition.two_Lp,
+                                               transition.em_charp))) {
+    return false;
+  }
+
+  return true;
+}
+
+AngularCorrelation
+CascadeHypothesisScanner::get_angular_correlation(const size_t k) const {
+  return AngularCorrelation(states[k * n_levels],
+                            vector<State>(states.begin() + k * n_levels + 1,
+                                          states.begin() +
+                                              (k + 1) * n_levels));
+}
+
+void CascadeHypothesisScanner::scan(const unsigned int n_threads) {
+
+  const size_t n_hypotheses = get_n_hypotheses();
+  vector<vector<double>> coefficients_k(n_hypotheses);
+  n_legendre_coefficients = vector<size_t>(n_hypotheses);
+
+  // The hypotheses are sorted like the leaves of a tree that is walked depth
+  // first, so consecutive hypotheses share their first levels. Each worker
+  // takes contiguous chunks of hypotheses and only sets the levels in which a
+  // hypothesis differs from the previous one.
+  const size_t chunk_size = 256;
+  atomic<size_t> next_chunk{0};
+  auto work = [&]() {
+    CascadePrefixBuilder builder(n_levels - 1);
+    for (size_t begin = chunk_size * next_chunk++; begin < n_hypotheses;
+         begin = chunk_size * next_chunk++) {
+      const size_t end = min(begin + chunk_size, n_hypotheses);
+      for (size_t k = begin; k < end; ++k) {
+        const State *hypothesis = states.data() + k * n_levels;
+
+        size_t level = 0;
+        if (k > begin) {
+          const State *previous = hypothesis - n_levels;
+          while (level < n_levels - 1 &&
+                 hypothesis[level].two_J == previous[level].two_J &&
+                 hypothesis[level].parity == previous[level].parity) {
+            ++level;
+          }
+        }
+        if (level == 0) {
+          builder.set_initial_state(hypothesis[0]);
+          level = 1;
+        }
+        for (; level < n_levels; ++level) {
+          builder.set_step(level - 1,
+                           AngularCorrelation::infer_transition(
+                               {hypothesis[level - 1], hypothesis[level]}),
+                           hypothesis[level]);
+        }
+
+        coefficients_k[k] = builder.get_legendre_coefficients();
+        n_legendre_coefficients[k] = coefficients_k[k].size();
+        const vector<double> &associated_legendre_coefficients =
+            builder.get_associated_legendre_coefficients();
+        coefficients_k[k].insert(coefficients_k[k].end(),
+                                 associated_legendre_coefficients.begin(),
+                                 associated_legendre_coefficients.end());
+      }
+    }
+  };
+
+  const size_t n_workers =
+      min(static_cast<size_t>(n_threads > 0
+                                  ? n_threads
+                                  : max(1u, thread::hardware_concurrency())),
+          n_hypotheses);
+  vector<thread> threads;
+  for (size_t i = 1; i < n_workers; ++i) {
+    threads.push_back(thread(work));
+  }
+  work();
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  offsets = vector<size_t>(n_hypotheses + 1, 0);
+  for (size_t k = 0; k < n_hypotheses; ++k) {
+    offsets[k + 1] = offsets[k] + coefficients_k[k].size();
+  }
+  coefficients.clear();
+  coefficients.reserve(offsets[n_hypotheses]);
+  for (auto &c : coefficients_k) {
+    coefficients.insert(coefficients.end(), c.begin(), c.end());
+  }
+}
+
+void CascadeHypothesisScanner::evaluate(const size_t k, const size_t n,
+                                        const double *theta,
+                                        const double *phi,
+                                        double *result) const {
+
+  if (offsets.empty()) {
+    throw invalid_argument("Coefficients not calculated yet, call scan().");
+  }
+
+  const double *c = coefficients.data() + offsets[k];
+  const size_t n_legendre = n_legendre_coefficients[k];
+  const size_t n_associated_legendre = offsets[k + 1] - offsets[k] - n_legendre;
+
+  double cos_theta[legendre_series::block_size],
+      sum_over_nu[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+
+    for (size_t i = 0; i < m; ++i) {
+      cos_theta[i] = cos(theta[start + i]);
+    }
+
+    legendre_series::legendre(m, cos_theta, n_legendre, c, result + start);
+    if (n_associated_legendre) {
+      legendre_series::associated_legendre_2(m, cos_theta,
+                                             n_associated_legendre,
+                                             c + n_legendre, sum_over_nu);
+      for (size_t i = 0; i < m; ++i) {
+        result[start + i] += cos(2. * phi[start + i]) * sum_over_nu[i];
+      }
+    }
+  }
+}
@@ -0,0 +1,153 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::max_element;
+
+#include <random>
+
+using std::seed_seq;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include "CascadeMixture.hh"
+#include "EulerAngleRotation.hh"
+
+CascadeMixture::CascadeMixture(const vector<AngularCorrelation> &branches,
+                               const vector<double> &wei,
+                               const vector<size_t> &obs,
+                               const unsigned int seed)
+    : observables(obs), mixture(vector<double>{1.}), upper_limit(0.),
+      branch_table(wei), random_engine(seed) {
+
+  if (branches.empty()) {
+    throw invalid_argument("At least one branch is required.");
+  }
+  if (wei.size() != branches.size()) {
+    throw invalid_argument("Numbers of branches and weights must be equal.");
+  }
+  if (observables.empty()) {
+    observables.assign(branches.size(), 0);
+  } else if (observables.size() != branches.size()) {
+    throw invalid_argument(
+        "Numbers of branches and observables must be equal.");
+  }
+
+  weights.resize(branches.size());
+  for (size_t i = 0; i < branches.size(); ++i) {
+    weights[i] = branch_table.get_probability(i);
+  }
+
+  vector<CompactAngularCorrelation> compact;
+  compact.reserve(branches.size());
+  for (size_t i = 0; i < branches.size(); ++i) {
+    compact.emplace_back(branches[i]);
+    upper_limit += weights[i] * branches[i].get_upper_limit();
+  }
+
+  mixture = collapse(compact, weights, vector<bool>(branches.size(), true));
+
+  const size_t n_observables =
+      *max_element(observables.begin(), observables.end()) + 1;
+  observable_probabilities.assign(n_observables, 0.);
+  observable_mixtures.reserve(n_observables);
+  for (size_t o = 0; o < n_observables; ++o) {
+    vector<bool> selected(branches.size());
+    for (size_t i = 0; i < branches.size(); ++i) {
+      selected[i] = observables[i] == o;
+      if (selected[i]) {
+        observable_probabilities[o] += weights[i];
+      }
+    }
+    observable_mixtures.push_back(collapse(compact, weights, selected));
+  }
+
+  samplers.reserve(branches.size());
+  for (size_t i = 0; i < branches.size(); ++i) {
+    samplers.emplace_back(branches[i], seed);
+  }
+  reseed(seed);
+}
+
+CompactAngularCorrelation
+CascadeMixture::collapse(const vector<CompactAngularCorrelation> &compact,
+                         const vector<double> &weights,
+                         const vector<bool> &selected) {
+  size_t n_legendre_coefficients = 1;
+  bool polarized = false;
+  for (size_t i = 0; i < compact.size(); ++i) {
+    if (selected[i]) {
+      n_legendre_coefficients =
+          max(n_legendre_coefficients,
+              static_cast<size_t>(compact[i].get_nu_max() / 2 + 1));
+      polarized = polarized || compact[i].is_polarized();
+    }
+  }
+
+  vector<double> legendre_coefficients(n_legendre_coefficients, 0.);
+  vector<double> associated_legendre_coefficients(
+      polarized ? n_legendre_coefficients - 1 : 0, 0.);
+  for (size_t i = 0; i < compact.size(); ++i) {
+    if (!selected[i]) {
+      continue;
+    }
+    const vector<double> c = compact[i].get_legendre_coefficients();
+    for (size_t j = 0; j < c.size(); ++j) {
+      legendre_coefficients[j] += weights[i] * c[j];
+    }
+    const vector<double> d = compact[i].get_associated_legendre_coefficients();
+    for (size_t j = 0; j < d.size(); ++j) {
+      associated_legendre_coefficients[j] += weights[i] * d[j];
+    }
+  }
+
+  return CompactAngularCorrelation(legendre_coefficients,
+                                   associated_legendre_coefficients);
+}
+
+size_t CascadeMixture::sample_branch() { return branch_table(random_engine); }
+
+pair<size_t, array<double, 2>> CascadeMixture::sample() {
+  const size_t branch = sample_branch();
+
+  return {branch, euler_angle_transform::to_spherical(
+                      samplers[branch].sample().second)};
+}
+
+void CascadeMixture::sample(const size_t n, size_t *branches, double *theta,
+                            double *phi) {
+  for (size_t i = 0; i < n; ++i) {
+    const pair<size_t, array<double, 2>> event = sample();
+    branches[i] = event.first;
+    theta[i] = event.second[0];
+    phi[i] = event.second[1];
+  }
+}
+
+void CascadeMixture::reseed(const unsigned int seed) {
+  random_engine.seed(seed);
+  for (size_t i = 0; i < samplers.size(); ++i) {
+    seed_seq seq{seed, static_cast<unsigned int>(i)};
+    samplers[i].reseed(seq);
+  }
+}
@@ -0,0 +1,164 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <string>
+
+using std::to_string;
+
+#include "AlphavCoefficient.hh"
+#include "AvCoefficient.hh"
+#include "CascadePrefixBuilder.hh"
+#include "UvCoefficient.hh"
+
+CascadePrefixBuilder::CascadePrefixBuilder(const size_t n_steps)
+    : n_steps(n_steps), n_set_steps(0), initial_state_set(false),
+      two_J_initial(0), two_J(n_steps, 0),
+      transitions(n_steps, Transition(2, 4)), two_nu_limits(n_steps, 0),
+      normalization_factors(n_steps, 1.),
+      uv_coefficient_products(n_steps) {
+  if (n_steps < 2) {
+    throw invalid_argument(
+        "Cascade must have at least two transition - state pairs.");
+  }
+}
+
+void CascadePrefixBuilder::set_initial_state(const State &initial_state) {
+  two_J_initial = initial_state.two_J;
+  initial_state_set = true;
+  n_set_steps = 0;
+}
+
+void CascadePrefixBuilder::set_step(const size_t step,
+                                    const Transition &transition,
+                                    const State &state) {
+  if (!initial_state_set) {
+    throw invalid_argument("Initial state has not been set.");
+  }
+  if (step >= n_steps) {
+    throw invalid_argument("Cascade step " + to_string(step) +
+                           " does not exist, the cascade has " +
+                           to_string(n_steps) + " steps.");
+  }
+  if (step > n_set_steps) {
+    throw invalid_argument("Cascade step " + to_string(step) +
+                           " can not be set before step " +
+                           to_string(n_set_steps) + ".");
+  }
+
+  two_J[step] = state.two_J;
+  transitions[step] = transition;
+  n_set_steps = step + 1;
+  normalization_factors[step] =
+      (step ? normalization_factors[step - 1] : 1.) /
+      (1. + transition.delta * transition.delta);
+
+  if (step == n_steps - 1) {
+    complete();
+    return;
+  }
+
+  if (step == 0) {
+    // First transition: A_nu and, for a known EM character, alpha_nu.
+    two_nu_limits[0] =
+        2 * min(state.two_J, max(transition.two_L, transition.two_Lp));
+    av_excitation.clear();
+    alphav_excitation.clear();
+    for (int two_nu = 0; two_nu <= two_nu_limits[0]; two_nu += 4) {
+      av_excitation.push_back(AvCoefficient::evaluate(
+          two_nu, transition.two_L, transition.two_Lp, two_J_initial,
+          state.two_J, transition.delta));
+      if (two_nu > 0 && transition.em_char != em_unknown) {
+        alphav_excitation.push_back(AlphavCoefficient::evaluate(
+            two_nu, transition.two_L, transition.two_Lp, two_J_initial,
+            state.two_J, transition.delta));
+      }
+    }
+    uv_coefficient_products[0].assign(av_excitation.size(), 1.);
+    return;
+  }
+
+  // Unobserved intermediate transition: multiply in U_nu.
+  two_nu_limits[step] = min(two_nu_limits[step - 1], 2 * state.two_J);
+  vector<double> &products = uv_coefficient_products[step];
+  products.clear();
+  for (int two_nu = 0; two_nu <= two_nu_limits[step]; two_nu += 4) {
+    products.push_back(uv_coefficient_products[step - 1][two_nu / 4] *
+                       UvCoefficient(two_nu, two_J[step - 1], transition.two_L,
+                                     transition.two_Lp, transition.delta,
+                                     state.two_J)
+                           .get_value());
+  }
+}
+
+const vector<double> &CascadePrefixBuilder::get_legendre_coefficients() const {
+  check_complete();
+  return legendre_coefficients;
+}
+
+const vector<double> &
+CascadePrefixBuilder::get_associated_legendre_coefficients() const {
+  check_complete();
+  return associated_legendre_coefficients;
+}
+
+void CascadePrefixBuilder::complete() {
+  const size_t last = n_steps - 1;
+  const Transition &transition = transitions[last];
+  const int two_nu_max =
+      min(two_nu_limits[last - 1],
+          2 * max(transition.two_L, transition.two_Lp));
+  const double normalization_factor = normalization_factors[last];
+  const vector<double> &uv_coef_products = uv_coefficient_products[last - 1];
+  const double polarization_sign =
+      transitions[0].em_charp == magnetic ? -1. : 1.;
+
+  legendre_coefficients.clear();
+  associated_legendre_coefficients.clear();
+  for (int two_nu = 0; two_nu <= two_nu_max; two_nu += 4) {
+    const double av_decay =
+        AvCoefficient::evaluate(two_nu, transition.two_L, transition.two_Lp,
+                                two_J[last], two_J[last - 1], transition.delta);
+    // Same order of the products as in W_dir_dir and W_pol_dir.
+    legendre_coefficients.push_back(
+        normalization_factor *
+        (av_excitation[two_nu / 4] * av_decay * uv_coef_products[two_nu / 4]));
+    if (two_nu > 0 && !alphav_excitation.empty()) {
+      associated_legendre_coefficients.push_back(
+          polarization_sign * normalization_factor *
+          (alphav_excitation[two_nu / 4 - 1] * av_decay *
+           uv_coef_products[two_nu / 4]));
+    }
+  }
+}
+
+void CascadePrefixBuilder::check_complete() const {
+  if (n_set_steps < n_steps) {
+    throw invalid_argument("Only " + to_string(n_set_steps) + " of " +
+                           to_string(n_steps) + " cascade steps are set.");
+  }
+}
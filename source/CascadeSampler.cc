@@ -17,24 +17,477 @@
     Copyright (C) 2021-2023 Udo Friman-Gayer
 */
 
+#include <algorithm>
+
+using std::copy;
+using std::fill;
+using std::min;
+
+#include <chrono>
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+#include <random>
+
+using std::seed_seq;
+
+#include <stdexcept>
+
+using std::out_of_range;
+using std::runtime_error;
+
+#include <utility>
+
+using std::pair;
+
 #include "CascadeSampler.hh"
 #include "EulerAngleRotation.hh"
 #include "ReferenceFrameSampler.hh"
 
 CascadeSampler::CascadeSampler(
     vector<shared_ptr<ReferenceFrameSampler>> cascade)
-    : angular_correlation_samplers(cascade) {}
+    : angular_correlation_samplers(cascade),
+      acceptance_samplers(cascade.size()), Phi_Theta_Psi_block(3 * block_size),
+      cumulative_rotations(block_size), weight_block(block_size),
+      rotation_block(block_size), step_seconds(cascade.size(), 0.) {}
 
 vector<array<double, 3>> CascadeSampler::operator()() {
+  check_unrestricted();
+
   vector<array<double, 3>> reference_frames(
       angular_correlation_samplers.size());
 
   reference_frames[0] = angular_correlation_samplers[0]->operator()();
+  if (collect_statistics) {
+    ++n_events_sampled;
+  }
+
+  // Keep the cumulative rotation as a matrix instead of recalculating it from
+  // the Euler angles of the previous step.
+  euler_angle_transform::RotationMatrix cumulative_rotation =
+      euler_angle_transform::rotation_matrix(reference_frames[0]);
 
   for (size_t i = 1; i < angular_correlation_samplers.size(); ++i) {
-    reference_frames[i] = euler_angle_transform::rotate(
-        reference_frames[i - 1], angular_correlation_samplers[i]->operator()());
+    cumulative_rotation = euler_angle_transform::multiply(
+        cumulative_rotation,
+        euler_angle_transform::rotation_matrix(
+            angular_correlation_samplers[i]->operator()()));
+    reference_frames[i] = euler_angle_transform::angles(cumulative_rotation);
   }
 
   return reference_frames;
 }
+
+void CascadeSampler::sample(const size_t n_events, double *Phi_Theta_Psi) {
+  sample(n_events, Phi_Theta_Psi, n_events);
+}
+
+void CascadeSampler::sample(const size_t n_events, double *Phi_Theta_Psi,
+                            const size_t leading_dimension) {
+  sample_block(n_events, Phi_Theta_Psi, leading_dimension, nullptr);
+}
+
+pair<double, vector<array<double, 3>>> CascadeSampler::sample_weighted() {
+  vector<array<double, 3>> reference_frames(
+      angular_correlation_samplers.size());
+
+  double weight = 1.;
+  euler_angle_transform::RotationMatrix cumulative_rotation =
+      euler_angle_transform::rotation_matrix({0., 0., 0.});
+  if (collect_statistics) {
+    ++n_events_sampled;
+  }
+
+  for (size_t i = 0; i < angular_correlation_samplers.size(); ++i) {
+    if (acceptance_samplers[i]) {
+      const pair<double, euler_angle_transform::RotationMatrix> w_R =
+          (*acceptance_samplers[i])(cumulative_rotation);
+      weight *= w_R.first;
+      cumulative_rotation =
+          euler_angle_transform::multiply(cumulative_rotation, w_R.second);
+      reference_frames[i] = euler_angle_transform::angles(cumulative_rotation);
+      continue;
+    }
+
+    const pair<double, array<double, 3>> w_Phi_Theta_Psi =
+        angular_correlation_samplers[i]->sample_weighted();
+    weight *= w_Phi_Theta_Psi.first;
+    if (i == 0) {
+      reference_frames[0] = w_Phi_Theta_Psi.second;
+      cumulative_rotation =
+          euler_angle_transform::rotation_matrix(reference_frames[0]);
+      continue;
+    }
+    cumulative_rotation = euler_angle_transform::multiply(
+        cumulative_rotation,
+        euler_angle_transform::rotation_matrix(w_Phi_Theta_Psi.second));
+    reference_frames[i] = euler_angle_transform::angles(cumulative_rotation);
+  }
+
+  sum_of_weights += weight;
+  sum_of_squared_weights += weight * weight;
+
+  return {weight, reference_frames};
+}
+
+void CascadeSampler::sample_weighted(const size_t n_events,
+                                     double *Phi_Theta_Psi,
+                                     const size_t leading_dimension,
+                                     double *weights) {
+  sample_block(n_events, Phi_Theta_Psi, leading_dimension, weights);
+
+  for (size_t k = 0; k < n_events; ++k) {
+    sum_of_weights += weights[k];
+    sum_of_squared_weights += weights[k] * weights[k];
+  }
+}
+
+void CascadeSampler::sample_block(const size_t n_events, double *Phi_Theta_Psi,
+                                  const size_t leading_dimension,
+                                  double *weights) {
+  double *Phi_block = Phi_Theta_Psi_block.data();
+  double *Theta_block = Phi_block + block_size;
+  double *Psi_block = Theta_block + block_size;
+
+  if (weights == nullptr) {
+    check_unrestricted();
+  }
+  if (collect_statistics) {
+    n_events_sampled += n_events;
+  }
+
+  for (size_t start = 0; start < n_events; start += block_size) {
+    const size_t m = min(block_size, n_events - start);
+
+    for (size_t i = 0; i < angular_correlation_samplers.size(); ++i) {
+      const steady_clock::time_point step_start =
+          collect_statistics ? steady_clock::now() : steady_clock::time_point();
+
+      double *Phi = Phi_Theta_Psi + 3 * i * leading_dimension + start;
+      double *Theta = Phi + leading_dimension;
+      double *Psi = Theta + leading_dimension;
+
+      if (acceptance_samplers[i]) {
+        // For the first step, the weights are initialized.
+        (*acceptance_samplers[i])(
+            m, i == 0 ? nullptr : cumulative_rotations.data(),
+            rotation_block.data(),
+            i == 0 ? weights + start : weight_block.data());
+        for (size_t k = 0; k < m; ++k) {
+          if (i == 0) {
+            cumulative_rotations[k] = rotation_block[k];
+          } else {
+            weights[start + k] *= weight_block[k];
+            cumulative_rotations[k] = euler_angle_transform::multiply(
+                cumulative_rotations[k], rotation_block[k]);
+          }
+          const array<double, 3> angles =
+              euler_angle_transform::angles(cumulative_rotations[k]);
+          Phi[k] = angles[0];
+          Theta[k] = angles[1];
+          Psi[k] = angles[2];
+        }
+        if (collect_statistics) {
+          step_seconds[i] +=
+              duration<double>(steady_clock::now() - step_start).count();
+        }
+        continue;
+      }
+
+      if (i == 0) {
+        if (weights) {
+          angular_correlation_samplers[0]->sample_weighted(m, Phi, Theta, Psi,
+                                                           weights + start);
+        } else {
+          angular_correlation_samplers[0]->operator()(m, Phi, Theta, Psi);
+        }
+        for (size_t k = 0; k < m; ++k) {
+          cumulative_rotations[k] = euler_angle_transform::rotation_matrix(
+              {Phi[k], Theta[k], Psi[k]});
+        }
+        if (collect_statistics) {
+          step_seconds[0] +=
+              duration<double>(steady_clock::now() - step_start).count();
+        }
+        continue;
+      }
+
+      if (weights) {
+        angular_correlation_samplers[i]->sample_weighted(
+            m, Phi_block, Theta_block, Psi_block, weight_block.data());
+        for (size_t k = 0; k < m; ++k) {
+          weights[start + k] *= weight_block[k];
+        }
+      } else {
+        angular_correlation_samplers[i]->operator()(m, Phi_block, Theta_block,
+                                                    Psi_block);
+      }
+      for (size_t k = 0; k < m; ++k) {
+        cumulative_rotations[k] = euler_angle_transform::multiply(
+            cumulative_rotations[k],
+            euler_angle_transform::rotation_matrix(
+                {Phi_block[k], Theta_block[k], Psi_block[k]}));
+        const array<double, 3> angles =
+            euler_angle_transform::angles(cumulative_rotations[k]);
+        Phi[k] = angles[0];
+        Theta[k] = angles[1];
+        Psi[k] = angles[2];
+      }
+      if (collect_statistics) {
+        step_seconds[i] +=
+            duration<double>(steady_clock::now() - step_start).count();
+      }
+    }
+  }
+}
+
+vector<euler_angle_transform::RotationMatrix>
+CascadeSampler::sample_rotation_matrices() {
+  check_unrestricted();
+
+  vector<euler_angle_transform::RotationMatrix> rotations(
+      angular_correlation_samplers.size());
+
+  rotations[0] =
+      angular_correlation_samplers[0]->sample_rotation_matrix().second;
+  if (collect_statistics) {
+    ++n_events_sampled;
+  }
+
+  for (size_t i = 1; i < angular_correlation_samplers.size(); ++i) {
+    rotations[i] = euler_angle_transform::multiply(
+        rotations[i - 1],
+        angular_correlation_samplers[i]->sample_rotation_matrix().second);
+  }
+
+  return rotations;
+}
+
+void CascadeSampler::sample_rotation_matrices(
+    const size_t n_events, euler_angle_transform::RotationMatrix *A,
+    const size_t leading_dimension) {
+  sample_block(n_events, A, leading_dimension, nullptr);
+}
+
+pair<double, vector<euler_angle_transform::RotationMatrix>>
+CascadeSampler::sample_weighted_rotation_matrices() {
+  vector<euler_angle_transform::RotationMatrix> rotations(
+      angular_correlation_samplers.size());
+
+  pair<double, euler_angle_transform::RotationMatrix> w_A =
+      acceptance_samplers[0]
+          ? (*acceptance_samplers[0])(
+                euler_angle_transform::rotation_matrix({0., 0., 0.}))
+          : angular_correlation_samplers[0]->sample_weighted_rotation_matrix();
+  double weight = w_A.first;
+  rotations[0] = w_A.second;
+  if (collect_statistics) {
+    ++n_events_sampled;
+  }
+
+  for (size_t i = 1; i < angular_correlation_samplers.size(); ++i) {
+    w_A = acceptance_samplers[i]
+              ? (*acceptance_samplers[i])(rotations[i - 1])
+              : angular_correlation_samplers[i]
+                    ->sample_weighted_rotation_matrix();
+    weight *= w_A.first;
+    rotations[i] =
+        euler_angle_transform::multiply(rotations[i - 1], w_A.second);
+  }
+
+  sum_of_weights += weight;
+  sum_of_squared_weights += weight * weight;
+
+  return {weight, rotations};
+}
+
+void CascadeSampler::sample_weighted_rotation_matrices(
+    const size_t n_events, euler_angle_transform::RotationMatrix *A,
+    const size_t leading_dimension, double *weights) {
+  sample_block(n_events, A, leading_dimension, weights);
+
+  for (size_t k = 0; k < n_events; ++k) {
+    sum_of_weights += weights[k];
+    sum_of_squared_weights += weights[k] * weights[k];
+  }
+}
+
+void CascadeSampler::sample_block(const size_t n_events,
+                                  euler_angle_transform::RotationMatrix *A,
+                                  const size_t leading_dimension,
+                                  double *weights) {
+  if (weights == nullptr) {
+    check_unrestricted();
+  }
+  if (collect_statistics) {
+    n_events_sampled += n_events;
+  }
+
+  for (size_t start = 0; start < n_events; start += block_size) {
+    const size_t m = min(block_size, n_events - start);
+
+    for (size_t i = 0; i < angular_correlation_samplers.size(); ++i) {
+      const steady_clock::time_point step_start =
+          collect_statistics ? steady_clock::now() : steady_clock::time_point();
+
+      euler_angle_transform::RotationMatrix *A_i =
+          A + i * leading_dimension + start;
+
+      if (acceptance_samplers[i]) {
+        if (i == 0) {
+          (*acceptance_samplers[0])(m, nullptr, A_i, weights + start);
+        } else {
+          const euler_angle_transform::RotationMatrix *A_previous =
+              A_i - leading_dimension;
+          (*acceptance_samplers[i])(m, A_previous, rotation_block.data(),
+                                    weight_block.data());
+          for (size_t k = 0; k < m; ++k) {
+            weights[start + k] *= weight_block[k];
+            A_i[k] = euler_angle_transform::multiply(A_previous[k],
+                                                     rotation_block[k]);
+          }
+        }
+      } else if (i == 0) {
+        if (weights) {
+          angular_correlation_samplers[0]->sample_weighted_rotation_matrices(
+              m, A_i, weights + start);
+        } else {
+          angular_correlation_samplers[0]->sample_rotation_matrices(m, A_i);
+        }
+      } else {
+        if (weights) {
+          angular_correlation_samplers[i]->sample_weighted_rotation_matrices(
+              m, rotation_block.data(), weight_block.data());
+          for (size_t k = 0; k < m; ++k) {
+            weights[start + k] *= weight_block[k];
+          }
+        } else {
+          angular_correlation_samplers[i]->sample_rotation_matrices(
+              m, rotation_block.data());
+        }
+        const euler_angle_transform::RotationMatrix *A_previous =
+            A_i - leading_dimension;
+        for (size_t k = 0; k < m; ++k) {
+          A_i[k] = euler_angle_transform::multiply(A_previous[k],
+                                                   rotation_block[k]);
+        }
+      }
+
+      if (collect_statistics) {
+        step_seconds[i] +=
+            duration<double>(steady_clock::now() - step_start).count();
+      }
+    }
+  }
+}
+
+void CascadeSampler::reseed(const unsigned int seed,
+                          const unsigned long long stream) {
+  for (size_t i = 0; i < angular_correlation_samplers.size(); ++i) {
+    seed_seq seq{seed, static_cast<unsigned int>(stream & 0xffffffffULL),
+                 static_cast<unsigned int>(stream >> 32),
+                 static_cast<unsigned int>(i)};
+    angular_correlation_samplers[i]->reseed(seq);
+    if (acceptance_samplers[i]) {
+      acceptance_samplers[i]->reseed(seq);
+    }
+  }
+}
+
+void CascadeSampler::restrict_to_acceptance(
+    const size_t step, shared_ptr<AcceptanceSampler> acceptance_sampler) {
+  if (step >= acceptance_samplers.size()) {
+    throw out_of_range("Step of the cascade does not exist.");
+  }
+  acceptance_samplers[step] = acceptance_sampler;
+}
+
+bool CascadeSampler::is_restricted() const {
+  for (const auto &acceptance_sampler : acceptance_samplers) {
+    if (acceptance_sampler) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void CascadeSampler::check_unrestricted() const {
+  if (is_restricted()) {
+    throw runtime_error("Cascades with a restricted acceptance can only be "
+                        "sampled in a weighted mode.");
+  }
+}
+
+void CascadeSampler::enable_statistics(const bool enable) {
+  collect_statistics = enable;
+  for (auto &sampler : angular_correlation_samplers) {
+    sampler->enable_statistics(enable);
+  }
+}
+
+void CascadeSampler::reset_statistics() {
+  n_events_sampled = 0;
+  fill(step_seconds.begin(), step_seconds.end(), 0.);
+  for (auto &sampler : angular_correlation_samplers) {
+    sampler->reset_statistics();
+  }
+}
+
+namespace {
+
+/*
+    Copy the counters of a SamplingStatistics object into arrays.
+*/
+void copy_statistics(const SamplingStatistics &statistics, size_t *counters,
+                     size_t *histogram) {
+  counters[0] = statistics.n_samples;
+  counters[1] = statistics.n_tries;
+  counters[2] = statistics.n_accepted;
+  counters[3] = statistics.n_failures;
+  if (histogram != nullptr) {
+    copy(statistics.tries_histogram.begin(), statistics.tries_histogram.end(),
+         histogram);
+  }
+}
+
+} // namespace
+
+extern "C" {
+void enable_sampler_statistics(ReferenceFrameSampler *sampler,
+                               const bool enable) {
+  sampler->enable_statistics(enable);
+}
+
+void get_sampler_statistics(ReferenceFrameSampler *sampler, size_t *counters,
+                            size_t *histogram) {
+  copy_statistics(sampler->get_statistics(), counters, histogram);
+}
+
+void reset_sampler_statistics(ReferenceFrameSampler *sampler) {
+  sampler->reset_statistics();
+}
+
+void enable_cascade_sampler_statistics(CascadeSampler *cascade_sampler,
+                                       const bool enable) {
+  cascade_sampler->enable_statistics(enable);
+}
+
+size_t get_cascade_sampler_n_events(CascadeSampler *cascade_sampler) {
+  return cascade_sampler->get_n_events();
+}
+
+void get_cascade_sampler_statistics(CascadeSampler *cascade_sampler,
+                                    const size_t step, size_t *counters,
+                                    size_t *histogram, double *seconds) {
+  copy_statistics(cascade_sampler->get_step_statistics(step), counters,
+                  histogram);
+  if (seconds != nullptr) {
+    *seconds = cascade_sampler->get_step_seconds(step);
+  }
+}
+
+void reset_cascade_sampler_statistics(CascadeSampler *cascade_sampler) {
+  cascade_sampler->reset_statistics();
+}
+}
@@ -0,0 +1,475 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::min;
+
+#include <atomic>
+
+using std::atomic;
+
+#include <cmath>
+
+#include <cstdio>
+
+using std::remove;
+using std::rename;
+
+#include <cstring>
+
+using std::memcmp;
+using std::memcpy;
+
+#include <fstream>
+
+using std::ofstream;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+using std::runtime_error;
+
+#include <string>
+
+using std::to_string;
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CInterface.hh"
+#include "CoefficientTable.hh"
+#include "LegendreSeries.hh"
+
+using c_interface::copy_message;
+
+namespace {
+
+const char magic[8] = {'A', 'L', 'P', 'A', 'C', 'A', 'C', 'T'};
+const uint32_t byte_order_mark = 0x01020304;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t n_entries;
+  uint64_t file_size;
+  uint64_t index_offset;
+  uint64_t reserved;
+};
+
+static_assert(sizeof(Header) == 48, "Unexpected size of the header.");
+static_assert(sizeof(CoefficientTable::Entry) == 24,
+              "Unexpected size of an index entry.");
+static_assert(sizeof(CoefficientTable::QuantumNumbers) == 32,
+              "Unexpected size of a quantum number record.");
+
+/*
+    Size of the data of an entry in bytes. The sums are calculated with 64 bits,
+    so that the numbers of a corrupt entry can not wrap around to a small size.
+*/
+uint64_t entry_size(const CoefficientTable::Entry &entry) {
+  return ((uint64_t)entry.n_cascade_steps + 1) *
+             sizeof(CoefficientTable::QuantumNumbers) +
+         ((uint64_t)entry.n_legendre_coefficients +
+          entry.n_associated_legendre_coefficients) *
+             sizeof(double);
+}
+
+CoefficientTable::QuantumNumbers quantum_numbers(const State &state) {
+  return {state.two_J, state.parity, em_unknown, 0, em_unknown, 0, 0.};
+}
+
+CoefficientTable::QuantumNumbers quantum_numbers(const Transition &transition,
+                                                 const State &state) {
+  return {state.two_J,         state.parity,        transition.em_char,
+          transition.two_L,    transition.em_charp, transition.two_Lp,
+          transition.delta};
+}
+
+} // namespace
+
+void CoefficientTable::write(
+    const string &file_name,
+    const vector<AngularCorrelation> &angular_correlations) {
+
+  vector<Entry> index;
+  uint64_t offset =
+      sizeof(Header) + angular_correlations.size() * sizeof(Entry);
+  for (auto &ang_cor : angular_correlations) {
+    const Entry entry{
+        offset, (uint32_t)ang_cor.get_cascade_steps().size(),
+        (uint32_t)ang_cor.get_legendre_coefficients().size(),
+        (uint32_t)ang_cor.get_associated_legendre_coefficients().size(), 0};
+    index.push_back(entry);
+    offset += entry_size(entry);
+  }
+
+  Header header{{}, format_version, byte_order_mark,
+                angular_correlations.size(), offset, sizeof(Header), 0};
+  memcpy(header.magic, magic, sizeof(magic));
+
+  // The name of the temporary file is unique for each call, even if several
+  // threads of the same process write tables at the same time.
+  static atomic<unsigned long> n_temporary_files{0};
+  const string temporary_file_name = file_name + ".tmp" +
+                                     to_string(getpid()) + "_" +
+                                     to_string(n_temporary_files++);
+
+  ofstream file(temporary_file_name, ofstream::binary | ofstream::trunc);
+  if (!file) {
+    throw runtime_error("Unable to open file '" + file_name +
+                        "' for writing.");
+  }
+  file.write((const char *)&header, sizeof(Header));
+  file.write((const char *)index.data(), index.size() * sizeof(Entry));
+
+  for (auto &ang_cor : angular_correlations) {
+    vector<QuantumNumbers> cascade{
+        quantum_numbers(ang_cor.get_initial_state())};
+    for (auto &cas_ste : ang_cor.get_cascade_steps()) {
+      cascade.push_back(quantum_numbers(cas_ste.first, cas_ste.second));
+    }
+    file.write((const char *)cascade.data(),
+               cascade.size() * sizeof(QuantumNumbers));
+
+    vector<double> coefficients = ang_cor.get_legendre_coefficients();
+    const vector<double> associated_legendre_coefficients =
+        ang_cor.get_associated_legendre_coefficients();
+    coefficients.insert(coefficients.end(),
+                        associated_legendre_coefficients.begin(),
+                        associated_legendre_coefficients.end());
+    file.write((const char *)coefficients.data(),
+               coefficients.size() * sizeof(double));
+  }
+
+  file.close();
+  if (!file) {
+    remove(temporary_file_name.c_str());
+    throw runtime_error("Unable to write file '" + file_name + "'.");
+  }
+  // Processes which have mapped a previous version of the file keep it until
+  // they unmap it.
+  if (rename(temporary_file_name.c_str(), file_name.c_str()) != 0) {
+    remove(temporary_file_name.c_str());
+    throw runtime_error("Unable to write file '" + file_name + "'.");
+  }
+}
+
+const string &CoefficientTable::create_once(
+    const string &file_name,
+    const function<vector<AngularCorrelation>()> &build) {
+  if (access(file_name.c_str(), F_OK) == 0) {
+    return file_name;
+  }
+
+  const string lock_file_name = file_name + ".lock";
+  const int lock_descriptor =
+      open(lock_file_name.c_str(), O_RDWR | O_CREAT, 0666);
+  if (lock_descriptor == -1) {
+    throw runtime_error("Unable to open lock file '" + lock_file_name + "'.");
+  }
+  if (flock(lock_descriptor, LOCK_EX) == -1) {
+    close(lock_descriptor);
+    throw runtime_error("Unable to lock file '" + lock_file_name + "'.");
+  }
+
+  // Another process may have written the table while this one was waiting
+  // for the lock.
+  try {
+    if (access(file_name.c_str(), F_OK) != 0) {
+      write(file_name, build());
+    }
+  } catch (...) {
+    close(lock_descriptor);
+    throw;
+  }
+  // Closing the file releases the lock.
+  close(lock_descriptor);
+
+  return file_name;
+}
+
+CoefficientTable::CoefficientTable(const string &file_name)
+    : data(nullptr), file_size(0), n_entries(0), entries(nullptr) {
+
+  const int file_descriptor = open(file_name.c_str(), O_RDONLY);
+  if (file_descriptor == -1) {
+    throw runtime_error("Unable to open file '" + file_name + "'.");
+  }
+
+  struct stat file_status;
+  if (fstat(file_descriptor, &file_status) == -1 ||
+      (size_t)file_status.st_size < sizeof(Header)) {
+    close(file_descriptor);
+    throw runtime_error("File '" + file_name +
+                        "' is not a table of angular correlations.");
+  }
+  file_size = file_status.st_size;
+
+  void *mapping =
+      mmap(nullptr, file_size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+  // The mapping stays valid after the file has been closed.
+  close(file_descriptor);
+  if (mapping == MAP_FAILED) {
+    throw runtime_error("Unable to map file '" + file_name + "'.");
+  }
+  data = (const char *)mapping;
+
+  const Header *header = (const Header *)data;
+  string error;
+  if (memcmp(header->magic, magic, sizeof(magic)) != 0) {
+    error = "is not a table of angular correlations";
+  } else if (header->byte_order != byte_order_mark) {
+    error = "was written on a machine with a different byte order";
+  } else if (header->version != format_version) {
+    error = "has the unsupported format version " +
+            to_string(header->version);
+  } else if (header->file_size != file_size ||
+             header->index_offset % sizeof(double) != 0 ||
+             header->index_offset > file_size ||
+             header->n_entries >
+                 (file_size - header->index_offset) / sizeof(Entry)) {
+    error = "is truncated or corrupt";
+  } else {
+    n_entries = header->n_entries;
+    entries = (const Entry *)(data + header->index_offset);
+    for (size_t i = 0; i < n_entries; ++i) {
+      if (entries[i].offset % sizeof(double) != 0 ||
+          entries[i].offset > file_size || entries[i].n_cascade_steps < 2 ||
+          entries[i].n_legendre_coefficients == 0 ||
+          (entries[i].n_associated_legendre_coefficients != 0 &&
+           entries[i].n_associated_legendre_coefficients + 1 !=
+               entries[i].n_legendre_coefficients) ||
+          entry_size(entries[i]) > file_size - entries[i].offset) {
+        error = "contains an invalid entry " + to_string(i);
+        break;
+      }
+    }
+  }
+
+  if (!error.empty()) {
+    munmap((void *)data, file_size);
+    throw runtime_error("File '" + file_name + "' " + error + ".");
+  }
+}
+
+CoefficientTable::CoefficientTable(
+    const string &file_name,
+    const function<vector<AngularCorrelation>()> &build)
+    : CoefficientTable(create_once(file_name, build)) {}
+
+CoefficientTable::~CoefficientTable() { munmap((void *)data, file_size); }
+
+const CoefficientTable::Entry &
+CoefficientTable::get_entry(const size_t index) const {
+  if (index >= n_entries) {
+    throw out_of_range("Index " + to_string(index) +
+                       " is out of range for a table with " +
+                       to_string(n_entries) + " entries.");
+  }
+  return entries[index];
+}
+
+const CoefficientTable::QuantumNumbers *
+CoefficientTable::get_quantum_numbers(const Entry &entry) const {
+  return (const QuantumNumbers *)(data + entry.offset);
+}
+
+State CoefficientTable::get_initial_state(const size_t index) const {
+  const QuantumNumbers *q = get_quantum_numbers(get_entry(index));
+  return State(q->two_J, (Parity)q->parity);
+}
+
+vector<pair<Transition, State>>
+CoefficientTable::get_cascade_steps(const size_t index) const {
+  const Entry &entry = get_entry(index);
+  const QuantumNumbers *q = get_quantum_numbers(entry);
+
+  vector<pair<Transition, State>> cascade_steps;
+  for (size_t i = 1; i <= entry.n_cascade_steps; ++i) {
+    cascade_steps.push_back(
+        {Transition((EMCharacter)q[i].em_char, q[i].two_L,
+                    (EMCharacter)q[i].em_charp, q[i].two_Lp, q[i].delta),
+         State(q[i].two_J, (Parity)q[i].parity)});
+  }
+  return cascade_steps;
+}
+
+int CoefficientTable::get_nu_max(const size_t index) const {
+  return 2 * ((int)get_entry(index).n_legendre_coefficients - 1);
+}
+
+const double *
+CoefficientTable::get_legendre_coefficients(const size_t index) const {
+  const Entry &entry = get_entry(index);
+  return (const double *)(get_quantum_numbers(entry) +
+                          entry.n_cascade_steps + 1);
+}
+
+const double *CoefficientTable::get_associated_legendre_coefficients(
+    const size_t index) const {
+  const Entry &entry = get_entry(index);
+  if (entry.n_associated_legendre_coefficients == 0) {
+    return nullptr;
+  }
+  return get_legendre_coefficients(index) +
+         entry.n_legendre_coefficients;
+}
+
+double CoefficientTable::operator()(const size_t index,
+                                    const double theta,
+                                    const double phi) const {
+  double result;
+  evaluate(index, 1, &theta, &phi, &result);
+  return result;
+}
+
+void CoefficientTable::evaluate(const size_t index, const size_t n,
+                                const double *theta, const double *phi,
+                                double *result) const {
+  const Entry &entry = get_entry(index);
+  const double *legendre_coefficients =
+      get_legendre_coefficients(index);
+  const double *associated_legendre_coefficients =
+      get_associated_legendre_coefficients(index);
+
+  double cos_theta[legendre_series::block_size];
+  double sum_over_nu[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+
+    for (size_t k = 0; k < m; ++k) {
+      cos_theta[k] = cos(theta[start + k]);
+    }
+
+    legendre_series::legendre(m, cos_theta, entry.n_legendre_coefficients,
+                              legendre_coefficients, result + start);
+
+    if (associated_legendre_coefficients == nullptr) {
+      continue;
+    }
+
+    legendre_series::associated_legendre_2(
+        m, cos_theta, entry.n_associated_legendre_coefficients,
+        associated_legendre_coefficients, sum_over_nu);
+
+    for (size_t k = 0; k < m; ++k) {
+      result[start + k] += cos(2. * phi[start + k]) * sum_over_nu[k];
+    }
+  }
+}
+
+AngularCorrelation
+CoefficientTable::get_angular_correlation(const size_t index) const {
+  return AngularCorrelation(get_initial_state(index),
+                            get_cascade_steps(index));
+}
+
+extern "C" {
+int write_coefficient_table(const char *file_name, const size_t n,
+                            AngularCorrelation **angular_correlations,
+                            const size_t message_length, char *message) {
+  vector<AngularCorrelation> ang_cors;
+  for (size_t i = 0; i < n; ++i) {
+    ang_cors.push_back(*angular_correlations[i]);
+  }
+  try {
+    CoefficientTable::write(file_name, ang_cors);
+  } catch (const runtime_error &e) {
+    copy_message(e.what(), message_length, message);
+    return 1;
+  }
+  return 0;
+}
+
+void *open_coefficient_table(const char *file_name,
+                             const size_t message_length, char *message) {
+  try {
+    return new CoefficientTable(file_name);
+  } catch (const runtime_error &e) {
+    copy_message(e.what(), message_length, message);
+    return nullptr;
+  }
+}
+
+void free_coefficient_table(CoefficientTable *coefficient_table) {
+  delete coefficient_table;
+}
+
+size_t coefficient_table_size(CoefficientTable *coefficient_table) {
+  return coefficient_table->size();
+}
+
+size_t coefficient_table_n_cascade_steps(CoefficientTable *coefficient_table,
+                                         const size_t index) {
+  try {
+    return coefficient_table->get_cascade_steps(index).size();
+  } catch (const out_of_range &e) {
+    return 0;
+  } catch (const invalid_argument &e) {
+    return 0;
+  }
+}
+
+int get_coefficient_table_cascade(CoefficientTable *coefficient_table,
+                                  const size_t index, int *two_J, short *par,
+                                  short *em_char, int *two_L, short *em_charp,
+                                  int *two_Lp, double *delta) {
+  State initial_state(0);
+  vector<pair<Transition, State>> cascade_steps;
+  try {
+    initial_state = coefficient_table->get_initial_state(index);
+    cascade_steps = coefficient_table->get_cascade_steps(index);
+  } catch (const out_of_range &e) {
+    return 0;
+  } catch (const invalid_argument &e) {
+    return 0;
+  }
+
+  two_J[0] = initial_state.two_J;
+  par[0] = initial_state.parity;
+  for (size_t i = 0; i < cascade_steps.size(); ++i) {
+    two_J[i + 1] = cascade_steps[i].second.two_J;
+    par[i + 1] = cascade_steps[i].second.parity;
+    em_char[i] = cascade_steps[i].first.em_char;
+    two_L[i] = cascade_steps[i].first.two_L;
+    em_charp[i] = cascade_steps[i].first.em_charp;
+    two_Lp[i] = cascade_steps[i].first.two_Lp;
+    delta[i] = cascade_steps[i].first.delta;
+  }
+  return 1;
+}
+
+int evaluate_coefficient_table(CoefficientTable *coefficient_table,
+                               const size_t index, const size_t n_angles,
+                               double *theta, double *phi, double *result) {
+  try {
+    coefficient_table->evaluate(index, n_angles, theta, phi, result);
+  } catch (const out_of_range &e) {
+    return 0;
+  }
+  return 1;
+}
+}
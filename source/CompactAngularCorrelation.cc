@@ -0,0 +1,147 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::min;
+
+#include <cmath>
+
+#include <memory>
+
+using std::make_shared;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::runtime_error;
+
+#include "CompactAngularCorrelation.hh"
+#include "LegendreSeries.hh"
+
+CompactAngularCorrelation::CompactAngularCorrelation(
+    const AngularCorrelation &ang_cor, const bool keep_cascade)
+    : coefficients(ang_cor.get_legendre_coefficients()),
+      n_legendre_coefficients(coefficients.size()), cascade(nullptr) {
+  const vector<double> associated_legendre_coefficients =
+      ang_cor.get_associated_legendre_coefficients();
+  coefficients.insert(coefficients.end(),
+                      associated_legendre_coefficients.begin(),
+                      associated_legendre_coefficients.end());
+  coefficients.shrink_to_fit();
+
+  if (keep_cascade) {
+    cascade = make_shared<const pair<State, vector<pair<Transition, State>>>>(
+        ang_cor.get_initial_state(), ang_cor.get_cascade_steps());
+  }
+}
+
+CompactAngularCorrelation::CompactAngularCorrelation(
+    const vector<double> &legendre_coefficients,
+    const vector<double> &associated_legendre_coefficients)
+    : coefficients(legendre_coefficients),
+      n_legendre_coefficients(legendre_coefficients.size()), cascade(nullptr) {
+  if (legendre_coefficients.empty()) {
+    throw invalid_argument(
+        "At least one coefficient of the Legendre series is required.");
+  }
+  if (!associated_legendre_coefficients.empty() &&
+      associated_legendre_coefficients.size() + 1 !=
+          legendre_coefficients.size()) {
+    throw invalid_argument("The number of coefficients of the associated "
+                           "Legendre series must be one less than the number "
+                           "of coefficients of the Legendre series.");
+  }
+  coefficients.insert(coefficients.end(),
+                      associated_legendre_coefficients.begin(),
+                      associated_legendre_coefficients.end());
+}
+
+double CompactAngularCorrelation::operator()(const double theta,
+                                             const double phi) const {
+  double result;
+  evaluate(1, &theta, &phi, &result);
+  return result;
+}
+
+void CompactAngularCorrelation::evaluate(const size_t n, const double *theta,
+                                         const double *phi,
+                                         double *result) const {
+  double cos_theta[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+
+    for (size_t k = 0; k < m; ++k) {
+      cos_theta[k] = cos(theta[start + k]);
+    }
+
+    evaluate_cos_theta(m, cos_theta, phi + start, result + start);
+  }
+}
+
+void CompactAngularCorrelation::evaluate_cos_theta(const size_t n,
+                                                   const double *cos_theta,
+                                                   const double *phi,
+                                                   double *result) const {
+  legendre_series::legendre(n, cos_theta, n_legendre_coefficients,
+                            coefficients.data(), result);
+
+  if (!is_polarized()) {
+    return;
+  }
+
+  double sum_over_nu[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+
+    legendre_series::associated_legendre_2(
+        m, cos_theta + start, n_legendre_coefficients - 1,
+        coefficients.data() + n_legendre_coefficients, sum_over_nu);
+
+    for (size_t k = 0; k < m; ++k) {
+      result[start + k] += cos(2. * phi[start + k]) * sum_over_nu[k];
+    }
+  }
+}
+
+AngularCorrelation CompactAngularCorrelation::get_angular_correlation() const {
+  if (cascade == nullptr) {
+    throw runtime_error("The cascade of the compact angular correlation was "
+                        "not kept (see keep_cascade).");
+  }
+  return AngularCorrelation(cascade->first, cascade->second);
+}
+
+size_t CompactAngularCorrelation::get_size_in_bytes() const {
+  size_t size = sizeof(*this) + coefficients.capacity() * sizeof(double);
+  if (cascade != nullptr) {
+    size += sizeof(*cascade) +
+            cascade->second.capacity() * sizeof(pair<Transition, State>);
+  }
+  return size;
+}
+
+void CompactAngularCorrelation::write_string_representation(
+    string &str_rep, const unsigned int n_digits,
+    const vector<string> &variable_names) const {
+  get_angular_correlation().get_w_gamma_gamma()->write_string_representation(
+      str_rep, n_digits, variable_names);
+}
@@ -0,0 +1,175 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cmath>
+
+using std::abs;
+
+#include <random>
+
+using std::seed_seq;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include "ComptonScatteringSampler.hh"
+
+ComptonScatteringSampler::ComptonScatteringSampler(
+    const double energy, const int seed, const double pol_deg)
+    : k(energy / electron_mass), polarization_degree(pol_deg),
+      random_engine(seed) {
+  if (!(energy > 0.)) {
+    throw invalid_argument("Energy must be positive.");
+  }
+  if (abs(polarization_degree) > 1.) {
+    throw invalid_argument(
+        "Degree of polarization must be in the range [-1, 1].");
+  }
+
+  total_integral = 2. * M_PI * integrate_cos_theta(-1., 1.)[0];
+}
+
+array<double, 6> ComptonScatteringSampler::operator()(
+    const euler_angle_transform::RotationMatrix &A) {
+  array<double, 6> result;
+  sample(1, &A, nullptr, result.data(), 1);
+
+  return result;
+}
+
+void ComptonScatteringSampler::sample(
+    const size_t n, const euler_angle_transform::RotationMatrix *A,
+    const double *energies, double *result, const size_t leading_dimension) {
+  for (size_t i = 0; i < n; ++i) {
+    const double k_photon = energies ? energies[i] / electron_mass : k;
+    const array<double, 2> cos_theta_phi = scatter(k_photon);
+    const double sin_theta = sqrt(1. - cos_theta_phi[0] * cos_theta_phi[0]);
+    const array<double, 3> direction = euler_angle_transform::apply(
+        A[i], {sin_theta * cos(cos_theta_phi[1]),
+               sin_theta * sin(cos_theta_phi[1]), cos_theta_phi[0]});
+
+    result[i] =
+        k_photon * electron_mass / (1. + k_photon * (1. - cos_theta_phi[0]));
+    result[leading_dimension + i] = cos_theta_phi[0];
+    result[2 * leading_dimension + i] = cos_theta_phi[1];
+    for (size_t j = 0; j < 3; ++j) {
+      result[(3 + j) * leading_dimension + i] = direction[j];
+    }
+  }
+}
+
+double ComptonScatteringSampler::analyzing_power(const double cos_theta) const {
+  const double epsilon = 1. / (1. + k * (1. - cos_theta));
+  const double sin2_theta = 1. - cos_theta * cos_theta;
+
+  return sin2_theta / (epsilon + 1. / epsilon - sin2_theta);
+}
+
+double ComptonScatteringSampler::integrate(const double cos_theta_min,
+                                           const double cos_theta_max,
+                                           const double phi_min,
+                                           const double phi_max) const {
+  const array<double, 2> integrals =
+      integrate_cos_theta(cos_theta_min, cos_theta_max);
+
+  return ((phi_max - phi_min) * integrals[0] -
+          0.5 * polarization_degree * integrals[1] *
+              (sin(2. * phi_max) - sin(2. * phi_min))) /
+         total_integral;
+}
+
+double ComptonScatteringSampler::expected_asymmetry(
+    const double cos_theta_min, const double cos_theta_max,
+    const double half_width) const {
+  if (!(half_width > 0.) || half_width > M_PI_2) {
+    throw invalid_argument(
+        "Half width of the azimuthal ranges must be in the range (0, pi/2].");
+  }
+  const array<double, 2> integrals =
+      integrate_cos_theta(cos_theta_min, cos_theta_max);
+
+  return polarization_degree * sin(2. * half_width) / (2. * half_width) *
+         integrals[1] / integrals[0];
+}
+
+void ComptonScatteringSampler::reseed(const unsigned int seed,
+                                      const unsigned long long stream) {
+  seed_seq seq{seed, static_cast<unsigned int>(stream & 0xffffffffULL),
+               static_cast<unsigned int>(stream >> 32)};
+  random_engine.seed(seq);
+  uniform_random.reset();
+}
+
+array<double, 2> ComptonScatteringSampler::scatter(const double k_photon) {
+  // Composition of the distributions 1/epsilon and epsilon in
+  // [epsilon_0, 1], followed by a rejection.
+  const double epsilon_0 = 1. / (1. + 2. * k_photon);
+  const double alpha_1 = -log(epsilon_0);
+  const double alpha_2 = 0.5 * (1. - epsilon_0 * epsilon_0);
+
+  double epsilon, one_minus_cos_theta, sin2_theta;
+  do {
+    if (alpha_1 >= (alpha_1 + alpha_2) * uniform_random(random_engine)) {
+      epsilon = exp(-alpha_1 * uniform_random(random_engine));
+    } else {
+      epsilon = sqrt(epsilon_0 * epsilon_0 +
+                     (1. - epsilon_0 * epsilon_0) *
+                         uniform_random(random_engine));
+    }
+    one_minus_cos_theta = (1. - epsilon) / (k_photon * epsilon);
+    sin2_theta = one_minus_cos_theta * (2. - one_minus_cos_theta);
+  } while (uniform_random(random_engine) >
+           1. - epsilon * sin2_theta / (1. + epsilon * epsilon));
+
+  const double b = polarization_degree * sin2_theta /
+                   (epsilon + 1. / epsilon - sin2_theta);
+  double phi;
+  do {
+    phi = 2. * M_PI * uniform_random(random_engine);
+  } while ((1. + abs(b)) * uniform_random(random_engine) >
+           1. - b * cos(2. * phi));
+
+  return {1. - one_minus_cos_theta, phi};
+}
+
+array<double, 2> ComptonScatteringSampler::integrate_cos_theta(
+    const double cos_theta_min, const double cos_theta_max) const {
+  if (!(-1. <= cos_theta_min && cos_theta_min <= cos_theta_max &&
+        cos_theta_max <= 1.)) {
+    throw invalid_argument(
+        "Limits of cos(theta) must be ordered and in the range [-1, 1].");
+  }
+
+  // Antiderivatives in terms of u = 1 / epsilon = 1 + k (1 - cos(theta)),
+  // with d cos(theta) = -du / k.
+  const auto antiderivatives = [this](const double cos_theta) {
+    const double u = 1. + k * (1. - cos_theta);
+    const double log_u = log1p(k * (1. - cos_theta));
+    const double epsilon_terms = -(log_u - 0.5 / (u * u)) / k;
+    const double sin2_theta_term =
+        -(-u + (2. * k + 2.) * log_u + (2. * k + 1.) / u) / (k * k * k);
+
+    return array<double, 2>{epsilon_terms - sin2_theta_term, sin2_theta_term};
+  };
+  const array<double, 2> upper = antiderivatives(cos_theta_max);
+  const array<double, 2> lower = antiderivatives(cos_theta_min);
+
+  return {upper[0] - lower[0], upper[1] - lower[1]};
+}
@@ -0,0 +1,99 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <gsl/gsl_math.h>
+
+#include "DetectorArray.hh"
+#include "EulerAngleRotation.hh"
+
+DetectorArray::DetectorArray(const vector<array<double, 2>> &theta_phi,
+                             const vector<double> &chi) {
+
+  if (chi.size() && chi.size() != theta_phi.size()) {
+    throw invalid_argument(
+        "Number of angles chi does not match the number of detectors.");
+  }
+
+  // The third column of euler_angle_transform::rotation_matrix(), i.e. the
+  // image of the z axis, is (sin(Psi) sin(Theta), -cos(Psi) sin(Theta),
+  // cos(Theta)). With Phi = -Psi, the rotation is the one by the angle Theta
+  // around an axis in the xy plane, which is the identity for a detector on
+  // the z axis.
+  for (size_t i = 0; i < theta_phi.size(); ++i) {
+    const double Psi = theta_phi[i][1] + M_PI_2;
+    Phi_Theta_Psi.push_back(
+        {(chi.size() ? chi[i] : 0.) - Psi, theta_phi[i][0], Psi});
+  }
+
+  calculate_relative_directions();
+}
+
+void DetectorArray::operator()(const vector<AngularCorrelation> &ang_cors,
+                               double *result) const {
+  for (size_t k = 0; k < ang_cors.size(); ++k) {
+    operator()(ang_cors[k], result + k * cos_theta.size());
+  }
+}
+
+AngleSet DetectorArray::angle_set(const int nu_max) const {
+  vector<double> cos_2phi(phi.size());
+  for (size_t k = 0; k < phi.size(); ++k) {
+    cos_2phi[k] = cos(2. * phi[k]);
+  }
+
+  return AngleSet(cos_theta.size(), cos_theta.data(), cos_2phi.data(),
+                  nu_max);
+}
+
+void DetectorArray::calculate_relative_directions() {
+
+  const size_t n_detectors = Phi_Theta_Psi.size();
+
+  vector<array<double, 3>> r(n_detectors);
+  vector<euler_angle_transform::RotationMatrix> A_inv(n_detectors);
+  for (size_t i = 0; i < n_detectors; ++i) {
+    const euler_angle_transform::RotationMatrix A =
+        euler_angle_transform::rotation_matrix(Phi_Theta_Psi[i]);
+    // The inverse of a rotation matrix is its transpose.
+    A_inv[i] = euler_angle_transform::transpose(A);
+    r[i] = euler_angle_transform::apply(A, {0., 0., 1.});
+  }
+
+  cos_theta.resize(n_detectors * n_detectors);
+  phi.resize(n_detectors * n_detectors);
+  for (size_t i = 0; i < n_detectors; ++i) {
+    for (size_t j = 0; j < n_detectors; ++j) {
+      const array<double, 3> r_rel =
+          euler_angle_transform::apply(A_inv[i], r[j]);
+      cos_theta[i * n_detectors + j] = max(-1., min(1., r_rel[2]));
+      phi[i * n_detectors + j] = atan2(r_rel[1], r_rel[0]);
+    }
+  }
+}
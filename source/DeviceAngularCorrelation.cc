@@ -0,0 +1,102 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+using std::runtime_error;
+
+#include <string>
+
+using std::to_string;
+
+#include "DeviceAngularCorrelation.hh"
+
+DeviceAngularCorrelation::DeviceAngularCorrelation(
+    const vector<AngularCorrelation> &angular_correlations,
+    const unsigned int max_tri)
+    : max_trials(max_tri), seed(0), stream(0), n_sampled(0) {
+
+  for (size_t i = 0; i < angular_correlations.size(); ++i) {
+    const double upper_limit = angular_correlations[i].get_upper_limit();
+    if (upper_limit < 0.) {
+      throw invalid_argument("Angular correlation " + to_string(i) +
+                             " has no upper limit.");
+    }
+
+    const vector<double> legendre_coefficients =
+        angular_correlations[i].get_legendre_coefficients();
+    const vector<double> associated_legendre_coefficients =
+        angular_correlations[i].get_associated_legendre_coefficients();
+    entries.push_back({coefficients.size(),
+                       (unsigned int)legendre_coefficients.size(),
+                       (unsigned int)associated_legendre_coefficients.size(),
+                       upper_limit});
+    coefficients.insert(coefficients.end(), legendre_coefficients.begin(),
+                        legendre_coefficients.end());
+    coefficients.insert(coefficients.end(),
+                        associated_legendre_coefficients.begin(),
+                        associated_legendre_coefficients.end());
+  }
+
+  try {
+    upload();
+  } catch (const runtime_error &e) {
+    release();
+    throw;
+  }
+}
+
+DeviceAngularCorrelation::~DeviceAngularCorrelation() { release(); }
+
+const DeviceAngularCorrelation::Entry &
+DeviceAngularCorrelation::get_entry(const size_t index) const {
+  if (index >= entries.size()) {
+    throw out_of_range("Index " + to_string(index) +
+                       " is out of range for a table with " +
+                       to_string(entries.size()) + " entries.");
+  }
+  return entries[index];
+}
+
+void DeviceAngularCorrelation::evaluate(const size_t index, const size_t n,
+                                        const double *theta, const double *phi,
+                                        double *result) {
+  const Entry &entry = get_entry(index);
+  if (n > 0) {
+    evaluate_on_backend(entry, n, theta, phi, result);
+  }
+}
+
+void DeviceAngularCorrelation::sample(const size_t index, const size_t n,
+                                      double *Phi, double *Theta, double *Psi) {
+  const Entry &entry = get_entry(index);
+  if (n > 0) {
+    sample_on_backend(entry, n, Phi, Theta, Psi);
+    n_sampled += n;
+  }
+}
+
+void DeviceAngularCorrelation::reseed(const unsigned int new_seed,
+                                      const unsigned long long new_stream) {
+  seed = new_seed;
+  stream = new_stream;
+  n_sampled = 0;
+}
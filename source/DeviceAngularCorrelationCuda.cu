@@ -0,0 +1,188 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+// CUDA backend of DeviceAngularCorrelation, used if alpaca is configured with
+// ALPACA_ENABLE_CUDA.
+
+#include <algorithm>
+
+using std::min;
+
+#include <stdexcept>
+
+using std::runtime_error;
+
+#include <string>
+
+using std::string;
+
+#include <cuda_runtime.h>
+
+#include "DeviceAngularCorrelation.hh"
+#include "DeviceKernels.hh"
+
+namespace {
+
+/*
+    Number of threads per block of a kernel launch.
+*/
+constexpr unsigned int threads_per_block = 256;
+
+/*
+    Maximum number of arguments or events per transfer, which limits the size
+    of the device buffer to 3 * 8 * 2^24 bytes = 384 MiB.
+*/
+constexpr size_t max_batch_size = size_t(1) << 24;
+
+void check(const cudaError_t error, const string &action) {
+  if (error != cudaSuccess) {
+    throw runtime_error("Unable to " + action + ": " +
+                        cudaGetErrorString(error));
+  }
+}
+
+/*
+    Make sure that a device buffer has at least a given size.
+*/
+double *reserve(void *&buffer, size_t &buffer_size, const size_t size) {
+  if (buffer_size < size) {
+    if (buffer != nullptr) {
+      cudaFree(buffer);
+      buffer = nullptr;
+      buffer_size = 0;
+    }
+    check(cudaMalloc(&buffer, size), "allocate device memory");
+    buffer_size = size;
+  }
+  return static_cast<double *>(buffer);
+}
+
+unsigned int n_blocks(const size_t n) {
+  return (unsigned int)((n + threads_per_block - 1) / threads_per_block);
+}
+
+__global__ void evaluate_kernel(const unsigned int n_c, const double *c,
+                                const unsigned int n_d, const double *d,
+                                const size_t n, const double *theta,
+                                const double *phi, double *result) {
+  const size_t k = blockIdx.x * (size_t)blockDim.x + threadIdx.x;
+  if (k < n) {
+    result[k] = device_kernels::evaluate(n_c, c, n_d, d, cos(theta[k]),
+                                         cos(2. * phi[k]));
+  }
+}
+
+__global__ void sample_kernel(const unsigned int n_c, const double *c,
+                              const unsigned int n_d, const double *d,
+                              const double upper_limit,
+                              const unsigned int max_trials,
+                              const uint64_t seed, const uint64_t stream,
+                              const uint64_t first_event, const size_t n,
+                              double *Phi, double *Theta, double *Psi) {
+  const size_t k = blockIdx.x * (size_t)blockDim.x + threadIdx.x;
+  if (k < n) {
+    device_kernels::SplitMix64 random_engine(seed, stream, first_event + k);
+    device_kernels::sample(n_c, c, n_d, d, upper_limit, max_trials,
+                           random_engine, Phi[k], Theta[k], Psi[k]);
+  }
+}
+
+} // namespace
+
+const char *DeviceAngularCorrelation::get_backend() { return "CUDA"; }
+
+void DeviceAngularCorrelation::upload() {
+  if (coefficients.empty()) {
+    return;
+  }
+  const size_t size = coefficients.size() * sizeof(double);
+  check(cudaMalloc(&device_coefficients, size), "allocate device memory");
+  check(cudaMemcpy(device_coefficients, coefficients.data(), size,
+                   cudaMemcpyHostToDevice),
+        "copy coefficients to the device");
+}
+
+void DeviceAngularCorrelation::release() {
+  cudaFree(device_coefficients);
+  cudaFree(device_buffer);
+  device_coefficients = nullptr;
+  device_buffer = nullptr;
+  device_buffer_size = 0;
+}
+
+void DeviceAngularCorrelation::evaluate_on_backend(const Entry &entry,
+                                                   const size_t n,
+                                                   const double *theta,
+                                                   const double *phi,
+                                                   double *result) {
+  const double *c = static_cast<const double *>(device_coefficients) +
+                    entry.offset;
+  const size_t batch_size = min(n, max_batch_size);
+  double *buffer = reserve(device_buffer, device_buffer_size,
+                           3 * batch_size * sizeof(double));
+  double *device_theta = buffer, *device_phi = buffer + batch_size,
+         *device_result = buffer + 2 * batch_size;
+
+  for (size_t start = 0; start < n; start += batch_size) {
+    const size_t m = min(batch_size, n - start);
+    check(cudaMemcpy(device_theta, theta + start, m * sizeof(double),
+                     cudaMemcpyHostToDevice),
+          "copy arguments to the device");
+    check(cudaMemcpy(device_phi, phi + start, m * sizeof(double),
+                     cudaMemcpyHostToDevice),
+          "copy arguments to the device");
+    evaluate_kernel<<<n_blocks(m), threads_per_block>>>(
+        entry.n_c, c, entry.n_d, c + entry.n_c, m, device_theta, device_phi,
+        device_result);
+    check(cudaGetLastError(), "launch kernel");
+    check(cudaMemcpy(result + start, device_result, m * sizeof(double),
+                     cudaMemcpyDeviceToHost),
+          "copy results from the device");
+  }
+}
+
+void DeviceAngularCorrelation::sample_on_backend(const Entry &entry,
+                                                 const size_t n, double *Phi,
+                                                 double *Theta, double *Psi) {
+  const double *c = static_cast<const double *>(device_coefficients) +
+                    entry.offset;
+  const size_t batch_size = min(n, max_batch_size);
+  double *buffer = reserve(device_buffer, device_buffer_size,
+                           3 * batch_size * sizeof(double));
+  double *device_Phi = buffer, *device_Theta = buffer + batch_size,
+         *device_Psi = buffer + 2 * batch_size;
+
+  for (size_t start = 0; start < n; start += batch_size) {
+    const size_t m = min(batch_size, n - start);
+    sample_kernel<<<n_blocks(m), threads_per_block>>>(
+        entry.n_c, c, entry.n_d, c + entry.n_c, entry.upper_limit, max_trials,
+        seed, stream, n_sampled + start, m, device_Phi, device_Theta,
+        device_Psi);
+    check(cudaGetLastError(), "launch kernel");
+    check(cudaMemcpy(Phi + start, device_Phi, m * sizeof(double),
+                     cudaMemcpyDeviceToHost),
+          "copy results from the device");
+    check(cudaMemcpy(Theta + start, device_Theta, m * sizeof(double),
+                     cudaMemcpyDeviceToHost),
+          "copy results from the device");
+    check(cudaMemcpy(Psi + start, device_Psi, m * sizeof(double),
+                     cudaMemcpyDeviceToHost),
+          "copy results from the device");
+  }
+}
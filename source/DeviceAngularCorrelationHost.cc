@@ -0,0 +1,57 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+// Host backend of DeviceAngularCorrelation, used if alpaca is configured
+// without ALPACA_ENABLE_CUDA.
+
+#include <cmath>
+
+#include "DeviceAngularCorrelation.hh"
+#include "DeviceKernels.hh"
+
+const char *DeviceAngularCorrelation::get_backend() { return "host"; }
+
+void DeviceAngularCorrelation::upload() {}
+
+void DeviceAngularCorrelation::release() {}
+
+void DeviceAngularCorrelation::evaluate_on_backend(const Entry &entry,
+                                                   const size_t n,
+                                                   const double *theta,
+                                                   const double *phi,
+                                                   double *result) {
+  const double *c = coefficients.data() + entry.offset;
+  for (size_t k = 0; k < n; ++k) {
+    result[k] = device_kernels::evaluate(entry.n_c, c, entry.n_d,
+                                         c + entry.n_c, cos(theta[k]),
+                                         cos(2. * phi[k]));
+  }
+}
+
+void DeviceAngularCorrelation::sample_on_backend(const Entry &entry,
+                                                 const size_t n, double *Phi,
+                                                 double *Theta, double *Psi) {
+  const double *c = coefficients.data() + entry.offset;
+  for (size_t k = 0; k < n; ++k) {
+    device_kernels::SplitMix64 random_engine(seed, stream, n_sampled + k);
+    device_kernels::sample(entry.n_c, c, entry.n_d, c + entry.n_c,
+                           entry.upper_limit, max_trials, random_engine,
+                           Phi[k], Theta[k], Psi[k]);
+  }
+}
@@ -0,0 +1,98 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <gsl/gsl_math.h>
+
+#include "DirDirInverseTransformSampler.hh"
+#include "EulerAngleRotation.hh"
+#include "W_dir_dir.hh"
+
+DirDirInverseTransformSampler::DirDirInverseTransformSampler(
+    const AngularCorrelation &w, const int seed)
+    : DirDirInverseTransformSampler(
+          W_dir_dir(w.get_initial_state(), w.get_cascade_steps()), seed) {
+
+  if (w.get_cascade_steps()[0].first.em_char != em_unknown) {
+    throw invalid_argument("Inverse-transform sampling is only implemented "
+                           "for direction-direction correlations.");
+  }
+}
+
+DirDirInverseTransformSampler::DirDirInverseTransformSampler(
+    const W_dir_dir &w_dir_dir, const int seed) {
+
+  const vector<double> expansion_coefficients =
+      w_dir_dir.get_expansion_coefficients();
+  for (int i = 0; i <= w_dir_dir.get_nu_max() / 2; ++i) {
+    coefficients.push_back(expansion_coefficients[i] /
+                           expansion_coefficients[0]);
+  }
+
+  random_engine = mt19937(seed);
+}
+
+pair<unsigned int, array<double, 3>> DirDirInverseTransformSampler::sample() {
+  const double theta = acos(inverse_cdf(uniform_random(random_engine)));
+  const double phi = 2. * M_PI * uniform_random(random_engine);
+
+  record(1, true);
+  return {1, euler_angle_transform::from_spherical(
+                 {theta, phi}, 2. * M_PI * uniform_random(random_engine))};
+}
+
+void DirDirInverseTransformSampler::reseed(seed_seq &seq) {
+  random_engine.seed(seq);
+  uniform_random.reset();
+}
+
+pair<double, double>
+DirDirInverseTransformSampler::cdf_and_pdf(const double x) const {
+
+  // Legendre polynomials P_{l-1}, P_l, and P_{l+1} for the current l, starting
+  // with l = 0.
+  double p_lm1 = 0., p_l = 1., p_lp1 = x;
+  double cdf = x + 1., pdf = 1.;
+
+  for (size_t l = 1; l < 2 * coefficients.size() - 1; ++l) {
+    p_lm1 = p_l;
+    p_l = p_lp1;
+    p_lp1 = ((2. * l + 1.) * x * p_l - l * p_lm1) / (l + 1.);
+    if (l % 2 == 0) {
+      cdf += coefficients[l / 2] * (p_lp1 - p_lm1) / (2. * l + 1.);
+      pdf += coefficients[l / 2] * p_l;
+    }
+  }
+
+  return {0.5 * cdf, 0.5 * pdf};
+}
+
+double DirDirInverseTransformSampler::cdf(const double x) const {
+  return cdf_and_pdf(x).first;
+}
+
+double DirDirInverseTransformSampler::inverse_cdf(const double u) const {
+  // The start value is the exact solution for an isotropic distribution.
+  return solve_monotonic([this](const double x) { return cdf_and_pdf(x); }, u,
+                         -1., 1., 2. * u - 1.);
+}
@@ -17,9 +17,8 @@
     Copyright (C) 2021-2023 Udo Friman-Gayer
 */
 
-#include <gsl/gsl_sf.h>
-
 #include "EvCoefficient.hh"
+#include "Factorial.hh"
 
 EvCoefficient::EvCoefficient(const int two_nu, const EMCharacter em,
                              const int two_L, const EMCharacter emp,
@@ -30,9 +29,7 @@ EvCoefficient::EvCoefficient(const int two_nu, const EMCharacter em,
       sign_sigma_Lp_n((emp == magnetic) ? -1 : 1),
       constant_f_coefficient(two_nu, two_L, two_L, two_jn, two_j),
       linear_f_coefficient(two_nu, two_L, two_Lp, two_jn, two_j),
-      quadratic_f_coefficient(two_nu, two_Lp, two_Lp, two_jn, two_j) {}
-
-double EvCoefficient::operator()(const double delta) const {
+      quadratic_f_coefficient(two_nu, two_Lp, two_Lp, two_jn, two_j) {
 
   const int nu = two_nu / 2;
   const double nu_times_nu_plus_one = nu * (nu + 1);
@@ -40,15 +37,24 @@ double EvCoefficient::operator()(const double delta) const {
   const double two_L_times_L_plus_one = 2 * L * (L + 1);
   const int Lp = two_Lp / 2;
   const double two_Lp_times_Lp_plus_one = 2 * Lp * (Lp + 1);
+  const double factorial_ratio = factorial::ratio(nu - 2, nu + 2);
+
+  constant_coefficient = sign_sigma_L_n * constant_f_coefficient.get_value() *
+                         (nu_times_nu_plus_one * two_L_times_L_plus_one) /
+                         (nu_times_nu_plus_one - two_L_times_L_plus_one) *
+                         factorial_ratio;
+  linear_coefficient = 2. * sign_sigma_Lp_n *
+                       linear_f_coefficient.get_value() * (Lp - L) *
+                       (Lp + L + 1) * factorial_ratio;
+  quadratic_coefficient = sign_sigma_Lp_n *
+                          quadratic_f_coefficient.get_value() *
+                          (nu_times_nu_plus_one * two_Lp_times_Lp_plus_one) /
+                          (nu_times_nu_plus_one - two_Lp_times_Lp_plus_one) *
+                          factorial_ratio;
+}
+
+double EvCoefficient::operator()(const double delta) const {
 
-  return (sign_sigma_L_n * constant_f_coefficient.get_value() *
-              (nu_times_nu_plus_one * two_L_times_L_plus_one) /
-              (nu_times_nu_plus_one - two_L_times_L_plus_one) +
-          2. * delta * sign_sigma_Lp_n * linear_f_coefficient.get_value() *
-              (Lp - L) * (Lp + L + 1) +
-          delta * delta * sign_sigma_Lp_n *
-              quadratic_f_coefficient.get_value() *
-              (nu_times_nu_plus_one * two_Lp_times_Lp_plus_one) /
-              (nu_times_nu_plus_one - two_Lp_times_Lp_plus_one)) *
-         gsl_sf_fact(nu - 2) / gsl_sf_fact(nu + 2);
-}
\ No newline at end of file
+  return constant_coefficient + delta * linear_coefficient +
+         delta * delta * quadratic_coefficient;
+}
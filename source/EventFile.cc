@@ -0,0 +1,298 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::copy;
+
+#include <cstring>
+
+using std::memcmp;
+using std::memcpy;
+
+#include <stdexcept>
+
+using std::out_of_range;
+using std::runtime_error;
+
+#include <string>
+
+using std::to_string;
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "EventFile.hh"
+
+using event_file::Header;
+
+namespace {
+
+const char magic[8] = {'A', 'L', 'P', 'A', 'C', 'A', 'E', 'V'};
+const uint32_t byte_order_mark = 0x01020304;
+
+static_assert(sizeof(Header) == 64, "Unexpected size of the header.");
+
+} // namespace
+
+EventFileWriter::EventFileWriter(const string &file_name, const size_t n_steps,
+                                 const size_t n_components, const bool weighted,
+                                 const size_t chunk_size)
+    : file_name(file_name),
+      n_columns(n_steps * n_components + (weighted ? 1 : 0)),
+      chunk_size(chunk_size), weighted(weighted), n_buffered(0), n_events(0),
+      closed(false) {
+  if (n_steps == 0 || n_components == 0) {
+    throw invalid_argument(
+        "Number of steps and components must be larger than zero.");
+  }
+  if (chunk_size == 0) {
+    throw invalid_argument("Chunk size must be larger than zero.");
+  }
+
+  header = Header{{},
+                  event_file::format_version,
+                  byte_order_mark,
+                  (uint32_t)n_steps,
+                  (uint32_t)n_components,
+                  weighted ? 1u : 0u,
+                  0,
+                  chunk_size,
+                  0,
+                  sizeof(Header),
+                  sizeof(Header)};
+  memcpy(header.magic, magic, sizeof(magic));
+
+  file.open(file_name, ofstream::binary | ofstream::trunc);
+  if (!file) {
+    throw runtime_error("Unable to open file '" + file_name +
+                        "' for writing.");
+  }
+  // Placeholder, completed by close().
+  file.write((const char *)&header, sizeof(Header));
+
+  buffer.resize(n_columns * chunk_size);
+}
+
+EventFileWriter::~EventFileWriter() {
+  try {
+    close();
+  } catch (const runtime_error &) {
+  }
+}
+
+void EventFileWriter::write(const size_t n, const double *values,
+                            const size_t leading_dimension,
+                            const double *weights) {
+  if (weighted != (weights != nullptr)) {
+    throw invalid_argument(weighted ? "Weights are required for this file."
+                                    : "File has no column for weights.");
+  }
+
+  const size_t n_value_columns = n_columns - (weighted ? 1 : 0);
+  size_t done = 0;
+  fill(n, [&](const size_t m, double *chunk_values, double *chunk_weights) {
+    for (size_t c = 0; c < n_value_columns; ++c) {
+      copy(values + c * leading_dimension + done,
+           values + c * leading_dimension + done + m,
+           chunk_values + c * chunk_size);
+    }
+    if (weighted) {
+      copy(weights + done, weights + done + m, chunk_weights);
+    }
+    done += m;
+  });
+}
+
+void EventFileWriter::close() {
+  if (closed) {
+    return;
+  }
+  closed = true;
+
+  flush();
+  const uint64_t n_chunks = (n_events + chunk_size - 1) / chunk_size;
+  header.n_events = n_events;
+  header.file_size =
+      sizeof(Header) + n_chunks * n_columns * chunk_size * sizeof(double);
+  file.seekp(0);
+  file.write((const char *)&header, sizeof(Header));
+
+  file.close();
+  if (!file) {
+    throw runtime_error("Unable to write file '" + file_name + "'.");
+  }
+}
+
+void EventFileWriter::check_open() const {
+  if (closed) {
+    throw runtime_error("File '" + file_name + "' has already been closed.");
+  }
+}
+
+void EventFileWriter::check_sampler(const size_t sampler_n_steps,
+                                    const size_t sampler_n_components,
+                                    const bool sampler_weighted) const {
+  if (sampler_weighted != weighted) {
+    throw invalid_argument(weighted ? "Weights are required for this file."
+                                    : "File has no column for weights.");
+  }
+  if (sampler_n_steps != header.n_steps ||
+      sampler_n_components != header.n_components) {
+    throw invalid_argument(
+        "Shape of the events of the sampler does not match the file.");
+  }
+}
+
+void EventFileWriter::flush() {
+  if (n_buffered == 0) {
+    return;
+  }
+  if (n_buffered < chunk_size) {
+    for (size_t c = 0; c < n_columns; ++c) {
+      std::fill(buffer.begin() + c * chunk_size + n_buffered,
+                buffer.begin() + (c + 1) * chunk_size, 0.);
+    }
+  }
+  file.write((const char *)buffer.data(), buffer.size() * sizeof(double));
+  if (!file) {
+    throw runtime_error("Unable to write file '" + file_name + "'.");
+  }
+  n_buffered = 0;
+}
+
+EventFileReader::EventFileReader(const string &file_name)
+    : data(nullptr), file_size(0), header(nullptr), n_columns(0), n_chunks(0),
+      chunks(nullptr) {
+
+  const int file_descriptor = open(file_name.c_str(), O_RDONLY);
+  if (file_descriptor == -1) {
+    throw runtime_error("Unable to open file '" + file_name + "'.");
+  }
+
+  struct stat file_status;
+  if (fstat(file_descriptor, &file_status) == -1 ||
+      (size_t)file_status.st_size < sizeof(Header)) {
+    close(file_descriptor);
+    throw runtime_error("File '" + file_name + "' is not an event file.");
+  }
+  file_size = file_status.st_size;
+
+  void *mapping =
+      mmap(nullptr, file_size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+  // The mapping stays valid after the file has been closed.
+  close(file_descriptor);
+  if (mapping == MAP_FAILED) {
+    throw runtime_error("Unable to map file '" + file_name + "'.");
+  }
+  data = (const char *)mapping;
+  header = (const Header *)data;
+
+  string error;
+  if (memcmp(header->magic, magic, sizeof(magic)) != 0) {
+    error = "is not an event file";
+  } else if (header->byte_order != byte_order_mark) {
+    error = "was written on a machine with a different byte order";
+  } else if (header->version != event_file::format_version) {
+    error = "has the unsupported format version " +
+            to_string(header->version);
+  } else if (header->file_size != file_size ||
+             header->data_offset % sizeof(double) != 0 ||
+             header->data_offset < sizeof(Header) ||
+             header->data_offset > file_size || header->n_steps == 0 ||
+             header->n_components == 0 || header->weighted > 1 ||
+             header->chunk_size == 0) {
+    error = "is truncated or corrupt";
+  } else {
+    n_columns = (size_t)header->n_steps * header->n_components +
+                header->weighted;
+    const size_t n_values =
+        (file_size - header->data_offset) / sizeof(double);
+    n_chunks = header->n_events / header->chunk_size +
+               (header->n_events % header->chunk_size != 0 ? 1 : 0);
+    if (header->n_events == 0
+            ? n_values != 0
+            : header->chunk_size > n_values / n_columns ||
+                  n_chunks != n_values / (n_columns * header->chunk_size) ||
+                  n_values % (n_columns * header->chunk_size) != 0) {
+      error = "is truncated or corrupt";
+    }
+    chunks = (const double *)(data + header->data_offset);
+  }
+
+  if (!error.empty()) {
+    munmap((void *)data, file_size);
+    throw runtime_error("File '" + file_name + "' " + error + ".");
+  }
+}
+
+EventFileReader::~EventFileReader() { munmap((void *)data, file_size); }
+
+size_t EventFileReader::get_chunk_length(const size_t chunk) const {
+  if (chunk >= n_chunks) {
+    throw out_of_range("Chunk " + to_string(chunk) +
+                       " is out of range for a file with " +
+                       to_string(n_chunks) + " chunks.");
+  }
+  return min(get_chunk_size(), get_n_events() - chunk * get_chunk_size());
+}
+
+const double *EventFileReader::get_column(const size_t chunk,
+                                          const size_t column) const {
+  get_chunk_length(chunk);
+  if (column >= n_columns) {
+    throw out_of_range("Column " + to_string(column) +
+                       " is out of range for a file with " +
+                       to_string(n_columns) + " columns.");
+  }
+  return chunks + (chunk * n_columns + column) * get_chunk_size();
+}
+
+void EventFileReader::read(const size_t first, const size_t n,
+                           double *values, const size_t leading_dimension,
+                           double *weights) const {
+  if (first > get_n_events() || n > get_n_events() - first) {
+    throw out_of_range("Events are out of range for a file with " +
+                       to_string(get_n_events()) + " events.");
+  }
+  if (weights != nullptr && !is_weighted()) {
+    throw invalid_argument("File has no column for weights.");
+  }
+
+  const size_t chunk_size = get_chunk_size();
+  const size_t n_value_columns = n_columns - header->weighted;
+  size_t done = 0;
+  while (done < n) {
+    const size_t chunk = (first + done) / chunk_size;
+    const size_t offset = (first + done) % chunk_size;
+    const size_t m = min(n - done, chunk_size - offset);
+
+    for (size_t c = 0; c < n_value_columns; ++c) {
+      const double *column = get_column(chunk, c) + offset;
+      copy(column, column + m, values + c * leading_dimension + done);
+    }
+    if (weights != nullptr) {
+      const double *column = get_column(chunk, n_columns - 1) + offset;
+      copy(column, column + m, weights + done);
+    }
+    done += m;
+  }
+}
@@ -0,0 +1,210 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <array>
+
+using std::array;
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+
+#include "EventReweighter.hh"
+
+EventReweighter::EventReweighter(
+    const vector<AngularCorrelation> &ref,
+    const vector<vector<AngularCorrelation>> &hyp, const size_t first)
+    : reference(ref), hypotheses(hyp), first_step(first),
+      statistics(hyp.size()) {
+  if (reference.empty()) {
+    throw invalid_argument("At least one step must be reweighted.");
+  }
+  if (hypotheses.empty()) {
+    throw invalid_argument("At least one hypothesis is required.");
+  }
+
+  for (const AngularCorrelation &w : reference) {
+    reference_normalization.push_back(w.get_legendre_coefficients()[0]);
+    if (reference_normalization.back() <= 0.) {
+      throw invalid_argument(
+          "Mean value of an angular correlation must be positive.");
+    }
+  }
+  for (const vector<AngularCorrelation> &hypothesis : hypotheses) {
+    if (hypothesis.size() != reference.size()) {
+      throw invalid_argument("Each hypothesis must have the same number of "
+                             "steps as the reference.");
+    }
+    normalization.emplace_back();
+    for (const AngularCorrelation &w : hypothesis) {
+      normalization.back().push_back(w.get_legendre_coefficients()[0]);
+      if (normalization.back().back() <= 0.) {
+        throw invalid_argument(
+            "Mean value of an angular correlation must be positive.");
+      }
+    }
+  }
+
+  const size_t n_steps = reference.size();
+  rotation_block.resize((n_steps + 1) * block_size);
+  cos_theta_block.resize(n_steps * block_size);
+  phi_block.resize(n_steps * block_size);
+  w_block.resize(block_size);
+  w_reference_block.resize(block_size);
+}
+
+void EventReweighter::operator()(const size_t n_events,
+                                 const double *Phi_Theta_Psi,
+                                 const size_t leading_dimension,
+                                 double *weights) {
+  const size_t n_steps = reference.size();
+
+  for (size_t start = 0; start < n_events; start += block_size) {
+    const size_t m = min(block_size, n_events - start);
+
+    for (size_t s = 0; s <= n_steps; ++s) {
+      if (s == 0 && first_step == 0) {
+        for (size_t k = 0; k < m; ++k) {
+          rotation_block[k] = euler_angle_transform::rotation_matrix(
+              {0., 0., 0.});
+        }
+        continue;
+      }
+      const double *Phi =
+          Phi_Theta_Psi + 3 * (first_step + s - 1) * leading_dimension + start;
+      const double *Theta = Phi + leading_dimension;
+      const double *Psi = Theta + leading_dimension;
+      for (size_t k = 0; k < m; ++k) {
+        rotation_block[s * block_size + k] =
+            euler_angle_transform::rotation_matrix({Phi[k], Theta[k], Psi[k]});
+      }
+    }
+
+    reweight_block(m, n_events, start, weights);
+  }
+}
+
+void EventReweighter::operator()(const size_t n_events,
+                                 const euler_angle_transform::RotationMatrix *A,
+                                 const size_t leading_dimension,
+                                 double *weights) {
+  const size_t n_steps = reference.size();
+
+  for (size_t start = 0; start < n_events; start += block_size) {
+    const size_t m = min(block_size, n_events - start);
+
+    for (size_t s = 0; s <= n_steps; ++s) {
+      for (size_t k = 0; k < m; ++k) {
+        rotation_block[s * block_size + k] =
+            (s == 0 && first_step == 0)
+                ? euler_angle_transform::rotation_matrix({0., 0., 0.})
+                : A[(first_step + s - 1) * leading_dimension + start + k];
+      }
+    }
+
+    reweight_block(m, n_events, start, weights);
+  }
+}
+
+const ReweightingStatistics &
+EventReweighter::get_statistics(const size_t h) const {
+  if (h >= statistics.size()) {
+    throw out_of_range("Index of the hypothesis is out of range.");
+  }
+  return statistics[h];
+}
+
+void EventReweighter::reset_statistics() {
+  for (ReweightingStatistics &s : statistics) {
+    s = ReweightingStatistics();
+  }
+}
+
+vector<size_t> EventReweighter::get_poorly_covered_hypotheses(
+    const double minimum_coverage) const {
+  vector<size_t> poorly_covered;
+  for (size_t h = 0; h < statistics.size(); ++h) {
+    if (statistics[h].get_coverage() < minimum_coverage) {
+      poorly_covered.push_back(h);
+    }
+  }
+  return poorly_covered;
+}
+
+void EventReweighter::reweight_block(const size_t m, const size_t n_events,
+                                     const size_t start, double *weights) {
+  const size_t n_steps = reference.size();
+
+  // Direction of emission of each step in the reference frame of the
+  // previous step, A_{i-1}^T A_i (0, 0, 1)^T.
+  for (size_t i = 0; i < n_steps; ++i) {
+    for (size_t k = 0; k < m; ++k) {
+      const array<double, 3> d = euler_angle_transform::apply(
+          euler_angle_transform::transpose(rotation_block[i * block_size + k]),
+          euler_angle_transform::direction(
+              rotation_block[(i + 1) * block_size + k]));
+      cos_theta_block[i * block_size + k] = max(-1., min(1., d[2]));
+      phi_block[i * block_size + k] = atan2(d[1], d[0]);
+    }
+  }
+
+  for (size_t k = 0; k < m; ++k) {
+    w_reference_block[k] = 1.;
+  }
+  for (size_t i = 0; i < n_steps; ++i) {
+    reference[i].evaluate_cos_theta(m, cos_theta_block.data() + i * block_size,
+                                    phi_block.data() + i * block_size,
+                                    w_block.data());
+    for (size_t k = 0; k < m; ++k) {
+      w_reference_block[k] *= w_block[k] / reference_normalization[i];
+    }
+  }
+
+  for (size_t h = 0; h < hypotheses.size(); ++h) {
+    double *w_h = weights + h * n_events + start;
+    for (size_t k = 0; k < m; ++k) {
+      w_h[k] = 1.;
+    }
+    for (size_t i = 0; i < n_steps; ++i) {
+      hypotheses[h][i].evaluate_cos_theta(
+          m, cos_theta_block.data() + i * block_size,
+          phi_block.data() + i * block_size, w_block.data());
+      for (size_t k = 0; k < m; ++k) {
+        w_h[k] *= w_block[k] / normalization[h][i];
+      }
+    }
+
+    ReweightingStatistics &s = statistics[h];
+    s.n_events += m;
+    for (size_t k = 0; k < m; ++k) {
+      w_h[k] = w_reference_block[k] > 0. ? w_h[k] / w_reference_block[k] : 0.;
+      s.sum_of_weights += w_h[k];
+      s.sum_of_squared_weights += w_h[k] * w_h[k];
+      s.maximum_weight = max(s.maximum_weight, w_h[k]);
+    }
+  }
+}
@@ -23,37 +23,38 @@
 
 using std::to_string;
 
-#include <gsl/gsl_sf.h>
-
 #include "FCoefficient.hh"
+#include "Profiler.hh"
 #include "TestUtilities.hh"
+#include "WignerSymbolCache.hh"
 
 FCoefficient::FCoefficient(const int two_nu, const int two_L, const int two_Lp,
                            const int two_j1, const int two_j)
     : two_nu(two_nu), two_L(two_L), two_Lp(two_Lp), two_j1(two_j1),
       two_j(two_j), value(0.) {
+  ALPACA_PROFILE_SCOPE("FCoefficient::FCoefficient");
 
-  double wigner3j{gsl_sf_coupling_3j(two_L, two_Lp, two_nu, 2, -2, 0)};
+  // Shortcut to avoid any calculation of Wigner symbols.
+  if (!is_nonzero(two_nu, two_L, two_Lp, two_j1, two_j)) {
+    return;
+  }
 
-  double wigner6j;
+  // The order of the columns of the Wigner symbols is chosen such that nu is
+  // the first argument (see WignerSymbolCache).
+  const double wigner3j{
+      WignerSymbolCache::coupling_3j(two_nu, two_L, two_Lp, 0, 2, -2)};
 
-  // Shortcut to avoid further calculations.
+  // Another shortcut
   if (wigner3j == 0.) {
-    value = 0.;
-  } else {
-
-    wigner6j = gsl_sf_coupling_6j(two_j, two_j, two_nu, two_Lp, two_L, two_j1);
+    return;
+  }
 
-    // Another shortcut
-    if (wigner6j == 0.) {
-      value = 0.;
-    } else {
+  const double wigner6j{WignerSymbolCache::coupling_6j(
+      two_nu, two_j, two_j, two_j1, two_Lp, two_L)};
 
-      value = pow(-1, (two_j1 + two_j) / 2 - 1) *
-              sqrt((two_L + 1) * (two_Lp + 1) * (two_j + 1) * (two_nu + 1)) *
-              wigner3j * wigner6j;
-    }
-  }
+  value = pow(-1, (two_j1 + two_j) / 2 - 1) *
+          sqrt((two_L + 1) * (two_Lp + 1) * (two_j + 1) * (two_nu + 1)) *
+          wigner3j * wigner6j;
 }
 
 bool FCoefficient::is_nonzero(const int two_nu, const int two_L,
@@ -102,20 +103,29 @@ bool FCoefficient::racah_is_nonzero(const int two_j1, const int two_j2,
   return true;
 }
 
-string FCoefficient::string_representation(
-    const unsigned int n_digits,
-    [[maybe_unused]] vector<string> variable_names) const {
+void FCoefficient::write_string_representation(
+    string &str_rep, const unsigned int n_digits,
+    [[maybe_unused]] const vector<string> &variable_names) const {
   if (n_digits) {
-    return float_string_representation(n_digits, value);
+    write_float_string_representation(str_rep, n_digits, value);
+    return;
   }
-  string str_rep = "F_{" + to_string(two_nu / 2) + "}\\left(" +
-                   to_string(two_L / 2) + "," + to_string(two_Lp / 2) + ",";
+  str_rep += "F_{";
+  str_rep += to_string(two_nu / 2);
+  str_rep += "}\\left(";
+  str_rep += to_string(two_L / 2);
+  str_rep += ",";
+  str_rep += to_string(two_Lp / 2);
+  str_rep += ",";
   if (two_j1 % 2) {
-    str_rep += to_string(two_j1) + "/2," + to_string(two_j) + "/2";
+    str_rep += to_string(two_j1);
+    str_rep += "/2,";
+    str_rep += to_string(two_j);
+    str_rep += "/2";
   } else {
-    str_rep += to_string(two_j1 / 2) + "," + to_string(two_j / 2);
+    str_rep += to_string(two_j1 / 2);
+    str_rep += ",";
+    str_rep += to_string(two_j / 2);
   }
   str_rep += "\\right)";
-
-  return str_rep;
 }
\ No newline at end of file
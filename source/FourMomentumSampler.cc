@@ -0,0 +1,182 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::min;
+
+#include <cmath>
+
+#include <random>
+
+using std::seed_seq;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <utility>
+
+using std::move;
+
+#include "FourMomentumSampler.hh"
+
+FourMomentumSampler::FourMomentumSampler(CascadeSampler cas_sam,
+                                         const vector<double> &energies,
+                                         const double mass,
+                                         const array<double, 3> bet,
+                                         const double temperature,
+                                         const int seed)
+    : cascade_sampler(move(cas_sam)), beta(bet), random_engine(seed) {
+
+  const size_t n_steps = cascade_sampler.get_n_steps();
+
+  if (energies.size() != n_steps + 1) {
+    throw invalid_argument("Number of energies must be the number of steps of "
+                           "the cascade plus one.");
+  }
+  if (mass <= 0.) {
+    throw invalid_argument("Mass must be positive.");
+  }
+  if (temperature < 0.) {
+    throw invalid_argument("Temperature must not be negative.");
+  }
+  if (beta[0] * beta[0] + beta[1] * beta[1] + beta[2] * beta[2] >= 1.) {
+    throw invalid_argument("Velocity must be smaller than the speed of light.");
+  }
+  if (energies[1] == energies[0]) {
+    throw invalid_argument("Energies of the first step must be different.");
+  }
+  for (size_t i = 1; i < n_steps; ++i) {
+    if (energies[i + 1] >= energies[i]) {
+      throw invalid_argument(
+          "Only the first step of the cascade may excite the nucleus.");
+    }
+  }
+
+  masses.resize(energies.size());
+  for (size_t i = 0; i < energies.size(); ++i) {
+    masses[i] = mass + energies[i];
+  }
+  thermal_beta = sqrt(temperature / mass);
+
+  rotation_block.resize(n_steps * CascadeSampler::block_size);
+}
+
+vector<array<double, 4>> FourMomentumSampler::operator()() {
+  const size_t n_steps = cascade_sampler.get_n_steps();
+
+  const vector<euler_angle_transform::RotationMatrix> A =
+      cascade_sampler.sample_rotation_matrices();
+  vector<double> p(4 * n_steps);
+  kinematics(A.data(), 1, p.data(), 1);
+
+  vector<array<double, 4>> four_momenta(n_steps);
+  for (size_t i = 0; i < n_steps; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      four_momenta[i][j] = p[4 * i + j];
+    }
+  }
+
+  return four_momenta;
+}
+
+void FourMomentumSampler::sample(const size_t n_events, double *p,
+                                 const size_t leading_dimension) {
+  const size_t block_size = CascadeSampler::block_size;
+
+  for (size_t start = 0; start < n_events; start += block_size) {
+    const size_t m = min(block_size, n_events - start);
+
+    cascade_sampler.sample_rotation_matrices(m, rotation_block.data(),
+                                             block_size);
+    for (size_t k = 0; k < m; ++k) {
+      kinematics(rotation_block.data() + k, block_size, p + start + k,
+                 leading_dimension);
+    }
+  }
+}
+
+void FourMomentumSampler::reseed(const unsigned int seed,
+                                 const unsigned long long stream) {
+  cascade_sampler.reseed(seed, stream);
+
+  seed_seq seq{seed, static_cast<unsigned int>(stream & 0xffffffffULL),
+               static_cast<unsigned int>(stream >> 32),
+               static_cast<unsigned int>(cascade_sampler.get_n_steps())};
+  random_engine.seed(seq);
+  normal.reset();
+}
+
+void FourMomentumSampler::kinematics(
+    const euler_angle_transform::RotationMatrix *A, const size_t stride,
+    double *p, const size_t leading_dimension) {
+
+  // Four momentum of the nucleus before the first step.
+  array<double, 3> b = beta;
+  if (thermal_beta > 0.) {
+    for (size_t j = 0; j < 3; ++j) {
+      b[j] += thermal_beta * normal(random_engine);
+    }
+  }
+  const double gamma =
+      1. / sqrt(1. - (b[0] * b[0] + b[1] * b[1] + b[2] * b[2]));
+  double energy = gamma * masses[0];
+  array<double, 3> momentum{energy * b[0], energy * b[1], energy * b[2]};
+
+  for (size_t i = 0; i + 1 < masses.size(); ++i) {
+    const array<double, 3> n = euler_angle_transform::direction(A[i * stride]);
+    const double m_i = masses[i], m_j = masses[i + 1];
+
+    double e_gamma;
+    array<double, 3> p_gamma;
+    if (m_j > m_i) {
+      // Capture: resonance condition (p + p_gamma)^2 = m_j^2.
+      e_gamma = (m_j * m_j - m_i * m_i) /
+                (2. * (energy - (momentum[0] * n[0] + momentum[1] * n[1] +
+                                 momentum[2] * n[2])));
+      for (size_t j = 0; j < 3; ++j) {
+        p_gamma[j] = e_gamma * n[j];
+        momentum[j] += p_gamma[j];
+      }
+      energy += e_gamma;
+    } else {
+      // Emission at rest, followed by a boost with the four velocity u of the
+      // nucleus.
+      const double e_gamma_rest = (m_i * m_i - m_j * m_j) / (2. * m_i);
+      const double u_0 = energy / m_i;
+      const array<double, 3> u{momentum[0] / m_i, momentum[1] / m_i,
+                               momentum[2] / m_i};
+      const double u_p_gamma_rest =
+          e_gamma_rest * (u[0] * n[0] + u[1] * n[1] + u[2] * n[2]);
+      e_gamma = u_0 * e_gamma_rest + u_p_gamma_rest;
+      const double boost = u_p_gamma_rest / (1. + u_0) + e_gamma_rest;
+      for (size_t j = 0; j < 3; ++j) {
+        p_gamma[j] = e_gamma_rest * n[j] + boost * u[j];
+        momentum[j] -= p_gamma[j];
+      }
+      energy -= e_gamma;
+    }
+
+    p[4 * i * leading_dimension] = e_gamma;
+    for (size_t j = 0; j < 3; ++j) {
+      p[(4 * i + j + 1) * leading_dimension] = p_gamma[j];
+    }
+  }
+}
@@ -0,0 +1,396 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+
+#include "HealpixMap.hh"
+#include "ThreadPool.hh"
+
+namespace {
+
+/**
+ * \brief Position of a pixel in the ring scheme.
+ */
+struct RingPosition {
+  long long ring;   /**< Index of the ring, starting at 1 in the north. */
+  long long n_ring; /**< Pixels per ring divided by 4. */
+  long long jp;     /**< Index of the pixel in the ring, starting at 1. */
+  long long shift;  /**< 1 if the ring is shifted by half a pixel, else 0. */
+  double z;         /**< Cosine of the polar angle of the center. */
+};
+
+/*
+    Position of a pixel in the nested ordering in the ring scheme, see the
+    functions pix2loc and nest2ring of the HEALPix C++ library [Gorski2005].
+*/
+RingPosition ring_position(const size_t nside, const size_t nested) {
+  static const long long jrll[12]{2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4};
+  static const long long jpll[12]{1, 3, 5, 7, 0, 2, 4, 6, 1, 3, 5, 7};
+
+  const long long n_side = static_cast<long long>(nside);
+  const size_t n_face = nside * nside;
+  const size_t face = nested / n_face;
+  const size_t interleaved = nested % n_face;
+
+  // The bits of the coordinates inside the base pixel alternate.
+  long long ix = 0, iy = 0;
+  for (size_t bit = 0; (n_face >> (2 * bit)) > 1; ++bit) {
+    ix |= static_cast<long long>((interleaved >> (2 * bit)) & 1) << bit;
+    iy |= static_cast<long long>((interleaved >> (2 * bit + 1)) & 1) << bit;
+  }
+
+  const double n_pixels = 12. * static_cast<double>(n_face);
+  RingPosition position;
+  position.ring = jrll[face] * n_side - ix - iy - 1;
+  if (position.ring < n_side) {
+    position.n_ring = position.ring;
+    position.z = 1. - 4. * static_cast<double>(position.n_ring) *
+                          static_cast<double>(position.n_ring) / n_pixels;
+    position.shift = 0;
+  } else if (position.ring > 3 * n_side) {
+    position.n_ring = 4 * n_side - position.ring;
+    position.z = 4. * static_cast<double>(position.n_ring) *
+                     static_cast<double>(position.n_ring) / n_pixels -
+                 1.;
+    position.shift = 0;
+  } else {
+    position.n_ring = n_side;
+    position.z = 2. * static_cast<double>(2 * n_side - position.ring) /
+                 (3. * static_cast<double>(n_side));
+    position.shift = (position.ring - n_side) & 1;
+  }
+
+  position.jp =
+      (jpll[face] * position.n_ring + ix - iy + 1 + position.shift) / 2;
+  if (position.jp > 4 * n_side) {
+    position.jp -= 4 * n_side;
+  } else if (position.jp < 1) {
+    position.jp += 4 * n_side;
+  }
+
+  return position;
+}
+
+/*
+    Index of the ring, starting at 1 at the pole, of the pixel with the index
+    i in a polar cap, counted from the pole. The ring r starts at the index
+    2 r (r - 1).
+*/
+size_t polar_ring(const size_t i) {
+  size_t ring = static_cast<size_t>(0.5 * (1. + sqrt(1. + 2. * i)));
+  while (2 * ring * (ring - 1) > i) {
+    --ring;
+  }
+  while (2 * ring * (ring + 1) <= i) {
+    ++ring;
+  }
+  return ring;
+}
+
+} // namespace
+
+HealpixMap::HealpixMap(const size_t nsid, const HealpixOrdering ord,
+                       const int l_m, const unsigned int n_sub)
+    : nside(nsid), ordering(ord), l_max(l_m - l_m % 2),
+      n_subdivisions(n_sub) {
+  if (nside == 0 || (nside & (nside - 1)) != 0 || nside > (1ULL << 28)) {
+    throw invalid_argument("nside must be a power of 2.");
+  }
+  if (l_max < 0) {
+    throw invalid_argument("l_max must not be negative.");
+  }
+  if (n_subdivisions > 10 || (nside << n_subdivisions) > (1ULL << 28)) {
+    throw invalid_argument("Too many subdivisions.");
+  }
+
+  n_pixels = 12 * nside * nside;
+  n_harmonics = harmonic_index(l_max + 2, -(l_max + 2));
+  integrals.resize(n_pixels * n_harmonics);
+
+  const size_t nside_sub = nside << n_subdivisions;
+  const size_t n_sub_pixels = size_t{1} << (2 * n_subdivisions);
+  const double weight = 4. * M_PI / static_cast<double>(n_pixels) /
+                        static_cast<double>(n_sub_pixels);
+
+  // The loop runs over the pixels in the nested ordering, because their
+  // sub-pixels have consecutive indices.
+  ThreadPool::parallel_for(
+      n_pixels,
+      [&](const size_t begin, const size_t end) {
+        vector<double> harmonics(n_harmonics);
+        for (size_t nested = begin; nested < end; ++nested) {
+          double *integral =
+              integrals.data() +
+              n_harmonics *
+                  (ordering == nested_ordering ? nested
+                                               : nested_to_ring(nside, nested));
+          for (size_t sub = nested * n_sub_pixels;
+               sub < (nested + 1) * n_sub_pixels; ++sub) {
+            const array<double, 2> z_phi = nested_center(nside_sub, sub);
+            even_spherical_harmonics(l_max, z_phi[0], z_phi[1],
+                                     harmonics.data());
+            for (size_t i = 0; i < n_harmonics; ++i) {
+              integral[i] += harmonics[i];
+            }
+          }
+          for (size_t i = 0; i < n_harmonics; ++i) {
+            integral[i] *= weight;
+          }
+        }
+      },
+      n_sub_pixels * n_harmonics);
+
+  // Over the whole sphere, the integrals of the spherical harmonics with l > 0
+  // vanish. The quadrature errors of the pixels do not cancel exactly, so a
+  // constant is subtracted from each integral to restore the normalization of
+  // the maps.
+  vector<double> mean(n_harmonics, 0.);
+  for (size_t p = 0; p < n_pixels; ++p) {
+    for (size_t i = 1; i < n_harmonics; ++i) {
+      mean[i] += integrals[p * n_harmonics + i];
+    }
+  }
+  for (size_t p = 0; p < n_pixels; ++p) {
+    for (size_t i = 1; i < n_harmonics; ++i) {
+      integrals[p * n_harmonics + i] -= mean[i] / n_pixels;
+    }
+  }
+}
+
+vector<double>
+HealpixMap::expected_fractions(const AngularCorrelation &ang_cor,
+                               const array<double, 3> Phi_Theta_Psi) const {
+  return expected_fractions(RotatedAngularCorrelation(ang_cor, Phi_Theta_Psi));
+}
+
+vector<double> HealpixMap::expected_fractions(
+    const RotatedAngularCorrelation &rot_ang_cor) const {
+  const int nu_max = rot_ang_cor.get_nu_max();
+  if (nu_max > l_max) {
+    throw invalid_argument("Maximum order of the angular correlation is "
+                           "larger than l_max of the map.");
+  }
+
+  const double a_00 = rot_ang_cor.get_coefficient(0, 0);
+  if (!(a_00 > 0.)) {
+    throw invalid_argument(
+        "Integral of the angular correlation must be positive.");
+  }
+
+  const size_t n_used = harmonic_index(nu_max + 2, -(nu_max + 2));
+  vector<double> coefficients(n_used);
+  for (int l = 0; l <= nu_max; l += 2) {
+    for (int m = -l; m <= l; ++m) {
+      coefficients[harmonic_index(l, m)] =
+          rot_ang_cor.get_coefficient(l, m) / (4. * M_PI * a_00);
+    }
+  }
+
+  vector<double> fractions(n_pixels);
+  ThreadPool::parallel_for(
+      n_pixels,
+      [&](const size_t begin, const size_t end) {
+        for (size_t p = begin; p < end; ++p) {
+          const double *integral = integrals.data() + p * n_harmonics;
+          double fraction = 0.;
+          for (size_t i = 0; i < n_used; ++i) {
+            fraction += coefficients[i] * integral[i];
+          }
+          fractions[p] = fraction;
+        }
+      },
+      n_used);
+
+  return fractions;
+}
+
+size_t HealpixMap::pixel(const double theta, const double phi) const {
+  const size_t nested = nested_pixel(nside, cos(theta), phi);
+  return ordering == nested_ordering ? nested : nested_to_ring(nside, nested);
+}
+
+array<double, 2> HealpixMap::pixel_center(const size_t pixel) const {
+  if (pixel >= n_pixels) {
+    throw out_of_range("Pixel index out of range.");
+  }
+
+  if (ordering == nested_ordering) {
+    const array<double, 2> z_phi = nested_center(nside, pixel);
+    return {acos(z_phi[0]), z_phi[1]};
+  }
+
+  // Invert the ring ordering with the pixel in the nested ordering that
+  // contains the center.
+  const size_t n_cap = 2 * nside * (nside - 1);
+  double z, phi;
+  if (pixel < n_cap) {
+    const size_t ring = polar_ring(pixel);
+    const size_t jp = pixel + 1 - 2 * ring * (ring - 1);
+    z = 1. - 4. * static_cast<double>(ring * ring) / n_pixels;
+    phi = (jp - 0.5) * M_PI_2 / ring;
+  } else if (pixel < n_pixels - n_cap) {
+    const size_t i = pixel - n_cap;
+    const size_t ring = i / (4 * nside) + nside;
+    const size_t jp = i % (4 * nside) + 1;
+    const double shift = ((ring - nside) & 1) ? 1. : 0.5;
+    z = 2. * (2. * nside - static_cast<double>(ring)) / (3. * nside);
+    phi = (jp - shift) * M_PI_2 / nside;
+  } else {
+    const size_t i = n_pixels - 1 - pixel;
+    const size_t ring = polar_ring(i);
+    const size_t jp = 4 * ring - (i + 1 - 2 * ring * (ring - 1)) + 1;
+    z = 4. * static_cast<double>(ring * ring) / n_pixels - 1.;
+    phi = (jp - 0.5) * M_PI_2 / ring;
+  }
+
+  return {acos(z), phi};
+}
+
+double HealpixMap::get_integral(const size_t pixel, const int l,
+                                const int m) const {
+  if (pixel >= n_pixels || l < 0 || l > l_max || l % 2 != 0 || m < -l ||
+      m > l) {
+    throw out_of_range("Pixel or spherical harmonic out of range.");
+  }
+  return integrals[pixel * n_harmonics + harmonic_index(l, m)];
+}
+
+array<double, 2> HealpixMap::nested_center(const size_t nside,
+                                           const size_t nested) {
+  const RingPosition position = ring_position(nside, nested);
+  return {position.z, (static_cast<double>(position.jp) -
+                       0.5 * static_cast<double>(position.shift + 1)) *
+                          M_PI_2 / static_cast<double>(position.n_ring)};
+}
+
+size_t HealpixMap::nested_to_ring(const size_t nside, const size_t nested) {
+  const RingPosition position = ring_position(nside, nested);
+  const long long n_side = static_cast<long long>(nside);
+
+  long long n_before;
+  if (position.ring < n_side) {
+    n_before = 2 * position.n_ring * (position.n_ring - 1);
+  } else if (position.ring > 3 * n_side) {
+    n_before = 12 * n_side * n_side - 2 * (position.n_ring + 1) *
+                                          position.n_ring;
+  } else {
+    n_before = 2 * n_side * (n_side - 1) + (position.ring - n_side) * 4 *
+                                               n_side;
+  }
+
+  return static_cast<size_t>(n_before + position.jp - 1);
+}
+
+size_t HealpixMap::nested_pixel(const size_t nside, const double cos_theta,
+                                const double phi) {
+  const long long n_side = static_cast<long long>(nside);
+  const double z = min(1., max(-1., cos_theta));
+  const double z_abs = fabs(z);
+  // Azimuthal angle in units of pi/2 in the interval [0, 4).
+  double tt = fmod(phi, 2. * M_PI);
+  if (tt < 0.) {
+    tt += 2. * M_PI;
+  }
+  tt = min(tt / M_PI_2, nextafter(4., 0.));
+
+  long long face, ix, iy;
+  if (z_abs <= 2. / 3.) {
+    // Equatorial region
+    const double temp_1 = n_side * (0.5 + tt);
+    const double temp_2 = n_side * z * 0.75;
+    const long long jp = static_cast<long long>(temp_1 - temp_2);
+    const long long jm = static_cast<long long>(temp_1 + temp_2);
+    const long long ifp = jp / n_side;
+    const long long ifm = jm / n_side;
+    face = ifp == ifm ? (ifp | 4) : (ifp < ifm ? ifp : ifm + 8);
+    ix = jm & (n_side - 1);
+    iy = n_side - (jp & (n_side - 1)) - 1;
+  } else {
+    // Polar caps
+    const long long ntt = min(3LL, static_cast<long long>(tt));
+    const double tp = tt - static_cast<double>(ntt);
+    const double tmp = n_side * sqrt(3. * (1. - z_abs));
+    const long long jp = min(n_side - 1, static_cast<long long>(tp * tmp));
+    const long long jm =
+        min(n_side - 1, static_cast<long long>((1. - tp) * tmp));
+    if (z >= 0.) {
+      face = ntt;
+      ix = n_side - jm - 1;
+      iy = n_side - jp - 1;
+    } else {
+      face = ntt + 8;
+      ix = jp;
+      iy = jm;
+    }
+  }
+
+  size_t interleaved = 0;
+  for (size_t bit = 0; (n_side >> bit) > 1; ++bit) {
+    interleaved |= static_cast<size_t>((ix >> bit) & 1) << (2 * bit);
+    interleaved |= static_cast<size_t>((iy >> bit) & 1) << (2 * bit + 1);
+  }
+
+  return static_cast<size_t>(face) * nside * nside + interleaved;
+}
+
+void HealpixMap::even_spherical_harmonics(const int l_max,
+                                          const double cos_theta,
+                                          const double phi, double *result) {
+  const double sin_theta = sqrt(fmax(0., 1. - cos_theta * cos_theta));
+
+  // Normalized associated Legendre functions N_l^m |P_l^m| without the
+  // Condon-Shortley phase, calculated with the recurrence in l for fixed m.
+  double q_mm = 1.;
+  for (int m = 0; m <= l_max; ++m) {
+    if (m > 0) {
+      q_mm *= sin_theta * sqrt((2. * m - 1.) / (2. * m));
+    }
+    const double cos_m_phi = m == 0 ? 1. : M_SQRT2 * cos(m * phi);
+    const double sin_m_phi = M_SQRT2 * sin(m * phi);
+
+    double q_l_minus_2 = 0., q_l_minus_1 = 0., q_l = q_mm;
+    for (int l = m; l <= l_max; ++l) {
+      if (l == m + 1) {
+        q_l = cos_theta * sqrt(2. * m + 1.) * q_mm;
+      } else if (l > m + 1) {
+        q_l = ((2. * l - 1.) * cos_theta * q_l_minus_1 -
+               sqrt((l + m - 1.) * (l - m - 1.)) * q_l_minus_2) /
+              sqrt((l - m) * static_cast<double>(l + m));
+      }
+      if (l % 2 == 0) {
+        result[harmonic_index(l, m)] = q_l * cos_m_phi;
+        if (m > 0) {
+          result[harmonic_index(l, -m)] = q_l * sin_m_phi;
+        }
+      }
+      q_l_minus_2 = q_l_minus_1;
+      q_l_minus_1 = q_l;
+    }
+  }
+}
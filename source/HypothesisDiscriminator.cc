@@ -0,0 +1,208 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+
+#include <utility>
+
+using std::pair;
+
+#include <gsl/gsl_math.h>
+
+#include "HypothesisDiscriminator.hh"
+
+namespace {
+
+/**
+ * \brief Expected \f$\chi^2\f$ per unit count for two values of the angular
+ * correlation.
+ */
+double chi_squared_per_count(const double w_a, const double w_b) {
+  const double sum = w_a + w_b;
+  if (sum == 0.) {
+    return 0.;
+  }
+  const double difference = w_a - w_b;
+  return 2. * difference * difference / sum;
+}
+
+void check_indices(const size_t a, const size_t b, const size_t n_hypotheses) {
+  if (a >= n_hypotheses || b >= n_hypotheses) {
+    throw out_of_range("Index of hypothesis out of range.");
+  }
+}
+
+} // namespace
+
+HypothesisDiscriminator::HypothesisDiscriminator(
+    const vector<AngularCorrelation> &hyp)
+    : hypotheses(hyp) {
+  if (hypotheses.size() < 2) {
+    throw invalid_argument("At least two hypotheses are required.");
+  }
+
+  for (const auto &hypothesis : hypotheses) {
+    vector<double> hypothesis_deltas;
+    for (const pair<Transition, State> &cas_ste :
+         hypothesis.get_cascade_steps()) {
+      hypothesis_deltas.push_back(cas_ste.first.delta);
+    }
+    deltas.push_back(hypothesis_deltas);
+  }
+}
+
+void HypothesisDiscriminator::evaluate(const size_t n, const double *theta,
+                                       const double *phi, double *ratio,
+                                       double *asymmetry_difference,
+                                       double *chi_squared) const {
+  const size_t n_hypotheses = hypotheses.size();
+
+  vector<double> w(n_hypotheses * n);
+  for (size_t a = 0; a < n_hypotheses; ++a) {
+    hypotheses[a].evaluate(n, theta, phi, w.data() + a * n);
+  }
+
+  vector<double> asymmetry;
+  if (asymmetry_difference != nullptr) {
+    vector<double> phi_perpendicular(n);
+    for (size_t k = 0; k < n; ++k) {
+      phi_perpendicular[k] = phi[k] + M_PI_2;
+    }
+    asymmetry.resize(n_hypotheses * n);
+    for (size_t a = 0; a < n_hypotheses; ++a) {
+      double *w_perpendicular = asymmetry.data() + a * n;
+      hypotheses[a].evaluate(n, theta, phi_perpendicular.data(),
+                             w_perpendicular);
+      for (size_t k = 0; k < n; ++k) {
+        const double w_parallel = w[a * n + k];
+        w_perpendicular[k] = (w_parallel - w_perpendicular[k]) /
+                             (w_parallel + w_perpendicular[k]);
+      }
+    }
+  }
+
+  for (size_t a = 0; a < n_hypotheses; ++a) {
+    for (size_t b = 0; b < n_hypotheses; ++b) {
+      const size_t offset = (a * n_hypotheses + b) * n;
+      const double *w_a = w.data() + a * n;
+      const double *w_b = w.data() + b * n;
+      if (ratio != nullptr) {
+        for (size_t k = 0; k < n; ++k) {
+          ratio[offset + k] = w_a[k] / w_b[k];
+        }
+      }
+      if (asymmetry_difference != nullptr) {
+        for (size_t k = 0; k < n; ++k) {
+          asymmetry_difference[offset + k] =
+              asymmetry[a * n + k] - asymmetry[b * n + k];
+        }
+      }
+      if (chi_squared != nullptr) {
+        for (size_t k = 0; k < n; ++k) {
+          chi_squared[offset + k] = chi_squared_per_count(w_a[k], w_b[k]);
+        }
+      }
+    }
+  }
+}
+
+array<double, 3> HypothesisDiscriminator::chi_squared_with_gradient(
+    const size_t a, const size_t b, const double theta,
+    const double phi) const {
+  check_indices(a, b, hypotheses.size());
+
+  const vector<double> w_a =
+      hypotheses[a].evaluate_with_gradient(theta, phi, deltas[a]);
+  const vector<double> w_b =
+      hypotheses[b].evaluate_with_gradient(theta, phi, deltas[b]);
+
+  const double sum = w_a[0] + w_b[0];
+  if (sum == 0.) {
+    return {0., 0., 0.};
+  }
+  const double difference = w_a[0] - w_b[0];
+
+  // chi^2 = 2 D^2 / S with D = W_a - W_b and S = W_a + W_b, therefore
+  // d chi^2 = (4 D S dD - 2 D^2 dS) / S^2.
+  array<double, 3> result{2. * difference * difference / sum, 0., 0.};
+  for (size_t i = 1; i < 3; ++i) {
+    result[i] = (4. * difference * sum * (w_a[i] - w_b[i]) -
+                 2. * difference * difference * (w_a[i] + w_b[i])) /
+                (sum * sum);
+  }
+
+  return result;
+}
+
+array<double, 3>
+HypothesisDiscriminator::refine(const size_t a, const size_t b,
+                                const double theta, const double phi,
+                                const unsigned int max_iterations,
+                                const double tolerance,
+                                const double initial_step) const {
+  check_indices(a, b, hypotheses.size());
+  if (!(tolerance > 0.) || !(initial_step > 0.)) {
+    throw invalid_argument(
+        "Tolerance and initial step length must be positive.");
+  }
+
+  double theta_opt = min(max(theta, 0.), M_PI), phi_opt = phi;
+  array<double, 3> chi2 =
+      chi_squared_with_gradient(a, b, theta_opt, phi_opt);
+  double step = initial_step;
+
+  for (unsigned int i = 0; i < max_iterations && step >= tolerance; ++i) {
+    const double norm = hypot(chi2[1], chi2[2]);
+    if (norm == 0.) {
+      break;
+    }
+
+    const double theta_new =
+        min(max(theta_opt + step * chi2[1] / norm, 0.), M_PI);
+    const double phi_new = phi_opt + step * chi2[2] / norm;
+    const array<double, 3> chi2_new =
+        chi_squared_with_gradient(a, b, theta_new, phi_new);
+
+    if (chi2_new[0] > chi2[0]) {
+      theta_opt = theta_new;
+      phi_opt = phi_new;
+      chi2 = chi2_new;
+      step *= 2.;
+    } else {
+      step *= 0.5;
+    }
+  }
+
+  phi_opt = fmod(phi_opt, 2. * M_PI);
+  if (phi_opt < 0.) {
+    phi_opt += 2. * M_PI;
+  }
+
+  return {theta_opt, phi_opt, chi2[0]};
+}
@@ -0,0 +1,138 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::copy;
+using std::fill;
+using std::min;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <string>
+
+using std::to_string;
+
+#include <gsl/gsl_cblas.h>
+
+#include "HypothesisMatrixEvaluator.hh"
+
+HypothesisMatrixEvaluator::HypothesisMatrixEvaluator(
+    const AngleSet &angle_set)
+    : n_directions(angle_set.get_n_directions()),
+      nu_max(angle_set.get_nu_max()), n_legendre(nu_max / 2 + 1) {
+  // The rows of the AngleSet are padded, the ones of the basis matrix are not.
+  const size_t n_basis = angle_set.get_n_rows();
+  const size_t leading_dimension = angle_set.get_leading_dimension();
+  basis.resize(n_basis * n_directions);
+  for (size_t i = 0; i < n_basis; ++i) {
+    const double *row = angle_set.get_basis() + i * leading_dimension;
+    copy(row, row + n_directions, basis.data() + i * n_directions);
+  }
+}
+
+void HypothesisMatrixEvaluator::evaluate(
+    const CascadeHypothesisScanner &scanner, double *result) const {
+  multiply(scanner, nullptr, nullptr, nullptr, nullptr, result);
+}
+
+void HypothesisMatrixEvaluator::chi_squared(
+    const CascadeHypothesisScanner &scanner, const double *rates,
+    const double *uncertainties, double *chi2, double *scale,
+    double *result) const {
+  vector<double> weights(n_directions);
+  for (size_t m = 0; m < n_directions; ++m) {
+    if (!(uncertainties[m] > 0.)) {
+      throw invalid_argument("Uncertainties must be positive.");
+    }
+    weights[m] = 1. / (uncertainties[m] * uncertainties[m]);
+  }
+
+  multiply(scanner, rates, weights.data(), chi2, scale, result);
+}
+
+void HypothesisMatrixEvaluator::multiply(
+    const CascadeHypothesisScanner &scanner, const double *rates,
+    const double *weights, double *chi2, double *scale,
+    double *result) const {
+  const vector<size_t> &offsets = scanner.get_offsets();
+  if (offsets.empty()) {
+    throw invalid_argument("Coefficients not calculated yet, call scan().");
+  }
+  const vector<double> &coefficients = scanner.get_coefficients();
+  const vector<size_t> &n_legendre_coefficients =
+      scanner.get_n_legendre_coefficients();
+  const size_t n_hypotheses = scanner.get_n_hypotheses();
+  for (size_t k = 0; k < n_hypotheses; ++k) {
+    if (n_legendre_coefficients[k] > n_legendre) {
+      throw invalid_argument("Order of hypothesis " + to_string(k) +
+                             " exceeds nu_max.");
+    }
+  }
+
+  const size_t n_basis = 2 * n_legendre - 1;
+  vector<double> c(block_size * n_basis);
+  vector<double> w(result == nullptr ? block_size * n_directions : 0);
+
+  for (size_t start = 0; start < n_hypotheses; start += block_size) {
+    const size_t n = min(block_size, n_hypotheses - start);
+
+    // Rows of C with zeros for the missing orders.
+    fill(c.begin(), c.end(), 0.);
+    for (size_t k = 0; k < n; ++k) {
+      const double *c_k = coefficients.data() + offsets[start + k];
+      const size_t n_c = n_legendre_coefficients[start + k];
+      const size_t n_d = offsets[start + k + 1] - offsets[start + k] - n_c;
+      copy(c_k, c_k + n_c, c.data() + k * n_basis);
+      copy(c_k + n_c, c_k + n_c + n_d, c.data() + k * n_basis + n_legendre);
+    }
+
+    double *w_block =
+        result == nullptr ? w.data() : result + start * n_directions;
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, (int)n,
+                (int)n_directions, (int)n_basis, 1., c.data(), (int)n_basis,
+                basis.data(), (int)n_directions, 0., w_block,
+                (int)n_directions);
+
+    if (weights == nullptr) {
+      continue;
+    }
+    for (size_t k = 0; k < n; ++k) {
+      const double *w_k = w_block + k * n_directions;
+      double yw = 0., ww = 0.;
+      for (size_t m = 0; m < n_directions; ++m) {
+        yw += weights[m] * rates[m] * w_k[m];
+        ww += weights[m] * w_k[m] * w_k[m];
+      }
+      const double a = ww > 0. ? yw / ww : 0.;
+
+      double chi2_k = 0.;
+      for (size_t m = 0; m < n_directions; ++m) {
+        const double residual = rates[m] - a * w_k[m];
+        chi2_k += weights[m] * residual * residual;
+      }
+      chi2[start + k] = chi2_k;
+      if (scale != nullptr) {
+        scale[start + k] = a;
+      }
+    }
+  }
+}
@@ -27,14 +27,17 @@ using std::invalid_argument;
 
 using std::to_string;
 
-#include <gsl/gsl_sf.h>
-
+#include "FCoefficient.hh"
+#include "Factorial.hh"
 #include "KappaCoefficient.hh"
+#include "Profiler.hh"
 #include "TestUtilities.hh"
+#include "WignerSymbolCache.hh"
 
 KappaCoefficient::KappaCoefficient(const int two_nu, const int two_L,
                                    const int two_Lp)
     : two_nu(two_nu), two_L(two_L), two_Lp(two_Lp), value(0.) {
+  ALPACA_PROFILE_SCOPE("KappaCoefficient::KappaCoefficient");
 
   const int nu = two_nu / 2;
   if (nu < 2) {
@@ -44,6 +47,8 @@ KappaCoefficient::KappaCoefficient(const int two_nu, const int two_L,
   // Avoid division by zero.
   if (!fulfils_triangle_inequality<int>(two_L, two_Lp, two_nu)) {
     value = 0.;
+  } else if (!FCoefficient::cg_is_nonzero(two_L, two_Lp, two_nu, 2, 2, 4)) {
+    value = 0.;
   } else {
 
     /*
@@ -62,18 +67,24 @@ KappaCoefficient::KappaCoefficient(const int two_nu, const int two_L,
        can be used. Note, however, that \f$M\f$ changes its sign when going from
        the CG coefficient to the Wigner-3j symbol.
     */
-    value = -sqrt((double)gsl_sf_fact(nu - 2) / (double)gsl_sf_fact(nu + 2)) *
-            gsl_sf_coupling_3j(two_L, two_Lp, two_nu, 2, 2, -4) /
-            gsl_sf_coupling_3j(two_L, two_Lp, two_nu, 2, -2, 0);
+    value = -sqrt(factorial::ratio(nu - 2, nu + 2)) *
+            WignerSymbolCache::coupling_3j(two_nu, two_L, two_Lp, -4, 2, 2) /
+            WignerSymbolCache::coupling_3j(two_nu, two_L, two_Lp, 0, 2, -2);
   }
 }
 
-string KappaCoefficient::string_representation(
-    const unsigned int n_digits,
-    [[maybe_unused]] vector<string> variable_names) const {
+void KappaCoefficient::write_string_representation(
+    string &str_rep, const unsigned int n_digits,
+    [[maybe_unused]] const vector<string> &variable_names) const {
   if (n_digits) {
-    return float_string_representation(n_digits, value);
+    write_float_string_representation(str_rep, n_digits, value);
+    return;
   }
-  return "\\kappa_{" + to_string(two_nu / 2) + "}" + "\\left(" +
-         to_string(two_L / 2) + "," + to_string(two_Lp / 2) + "\\right)";
+  str_rep += "\\kappa_{";
+  str_rep += to_string(two_nu / 2);
+  str_rep += "}\\left(";
+  str_rep += to_string(two_L / 2);
+  str_rep += ",";
+  str_rep += to_string(two_Lp / 2);
+  str_rep += "\\right)";
 }
\ No newline at end of file
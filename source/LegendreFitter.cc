@@ -0,0 +1,430 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+
+#include <cmath>
+
+#include <limits>
+
+using std::numeric_limits;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::runtime_error;
+
+#include <gsl/gsl_math.h>
+
+#include "LegendreFitter.hh"
+
+namespace {
+
+/**
+ * \brief Cholesky decomposition of a symmetric positive definite matrix in
+ * place.
+ *
+ * \return False if the matrix is not positive definite within the relative
+ * precision 1e-12 of its diagonal.
+ */
+bool cholesky(const size_t n, double *A) {
+  double scale = 0.;
+  for (size_t i = 0; i < n; ++i) {
+    scale = max(scale, fabs(A[i * n + i]));
+  }
+  for (size_t j = 0; j < n; ++j) {
+    double d = A[j * n + j];
+    for (size_t k = 0; k < j; ++k) {
+      d -= A[j * n + k] * A[j * n + k];
+    }
+    if (!(d > 1e-12 * scale)) {
+      return false;
+    }
+    A[j * n + j] = sqrt(d);
+    for (size_t i = j + 1; i < n; ++i) {
+      double s = A[i * n + j];
+      for (size_t k = 0; k < j; ++k) {
+        s -= A[i * n + k] * A[j * n + k];
+      }
+      A[i * n + j] = s / A[j * n + j];
+    }
+  }
+  return true;
+}
+
+/**
+ * \brief Solve \f$L L^T x = b\f$ in place for the Cholesky factor \f$L\f$.
+ */
+void cholesky_solve(const size_t n, const double *L, double *b) {
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t k = 0; k < i; ++k) {
+      b[i] -= L[i * n + k] * b[k];
+    }
+    b[i] /= L[i * n + i];
+  }
+  for (size_t i = n; i > 0; --i) {
+    for (size_t k = i; k < n; ++k) {
+      b[i - 1] -= L[k * n + i - 1] * b[k];
+    }
+    b[i - 1] /= L[(i - 1) * n + i - 1];
+  }
+}
+
+/**
+ * \brief Inverse of a matrix from its Cholesky factor.
+ */
+vector<double> cholesky_invert(const size_t n, const double *L) {
+  vector<double> inverse(n * n, 0.), column(n);
+  for (size_t j = 0; j < n; ++j) {
+    for (size_t i = 0; i < n; ++i) {
+      column[i] = i == j ? 1. : 0.;
+    }
+    cholesky_solve(n, L, column.data());
+    for (size_t i = 0; i < n; ++i) {
+      inverse[i * n + j] = column[i];
+    }
+  }
+  return inverse;
+}
+
+} // namespace
+
+LegendreFitter::LegendreFitter(const int nu_max, const bool polarized)
+    : nu_max(nu_max), polarized(polarized) {
+  if (nu_max < 0 || nu_max % 2 != 0) {
+    throw invalid_argument("Maximum order must be a non-negative even number.");
+  }
+  n_coefficients = nu_max / 2 + 1 + (polarized ? nu_max / 2 : 0);
+  reset();
+}
+
+void LegendreFitter::reset() {
+  mode = Mode::empty;
+  n_entries = 0;
+  sum_gg.assign(n_coefficients * n_coefficients, 0.);
+  sum_g.assign(n_coefficients, 0.);
+  sum_w = 0.;
+  sum_w2 = 0.;
+  sum_wyy = 0.;
+}
+
+void LegendreFitter::basis_functions(const double theta, const double phi,
+                                     double *g) const {
+  const size_t n_legendre = nu_max / 2 + 1;
+  const double x = cos(theta);
+
+  // P_l(x) for l = 0, 1, ..., nu_max.
+  double p_l_minus_1 = 1., p_l = x;
+  g[0] = 1.;
+  for (int l = 2; l <= nu_max; ++l) {
+    const double p_l_plus_1 = ((2 * l - 1) * x * p_l - (l - 1) * p_l_minus_1) / l;
+    p_l_minus_1 = p_l;
+    p_l = p_l_plus_1;
+    if (l % 2 == 0) {
+      g[l / 2] = p_l;
+    }
+  }
+
+  if (!polarized) {
+    return;
+  }
+
+  // P_l^2(x) for l = 2, 3, ..., nu_max.
+  const double cos_2phi = cos(2. * phi);
+  p_l_minus_1 = 0.;
+  p_l = 3. * (1. - x * x);
+  for (int l = 2; l <= nu_max; ++l) {
+    if (l > 2) {
+      const double p_l_plus_1 =
+          ((2 * l - 1) * x * p_l - (l + 1) * p_l_minus_1) / (l - 2);
+      p_l_minus_1 = p_l;
+      p_l = p_l_plus_1;
+    }
+    if (l % 2 == 0) {
+      g[n_legendre + l / 2 - 1] = cos_2phi * p_l;
+    }
+  }
+}
+
+void LegendreFitter::accumulate(const double *g, const double weight,
+                                const double y) {
+  for (size_t i = 0; i < n_coefficients; ++i) {
+    const double weight_g_i = weight * g[i];
+    for (size_t j = i; j < n_coefficients; ++j) {
+      sum_gg[i * n_coefficients + j] += weight_g_i * g[j];
+    }
+    sum_g[i] += weight_g_i * y;
+  }
+  sum_w += weight;
+  sum_wyy += weight * y * y;
+  ++n_entries;
+}
+
+void LegendreFitter::add_event(const double theta, const double phi,
+                               const double weight) {
+  add_events(1, &theta, &phi, &weight);
+}
+
+void LegendreFitter::add_events(const size_t n, const double *theta,
+                                const double *phi, const double *weight) {
+  if (mode == Mode::counts) {
+    throw runtime_error("Events cannot be added to a fit of counts.");
+  }
+  if (n > 0) {
+    mode = Mode::events;
+  }
+
+  vector<double> g(n_coefficients);
+  for (size_t k = 0; k < n; ++k) {
+    const double w = weight == nullptr ? 1. : weight[k];
+    basis_functions(theta[k], phi[k], g.data());
+    accumulate(g.data(), w, 1.);
+    sum_w2 += w * w;
+  }
+}
+
+void LegendreFitter::add_counts(const double theta, const double phi,
+                                const double counts, const double efficiency,
+                                const vector<double> &attenuation) {
+  if (mode == Mode::events) {
+    throw runtime_error("Counts cannot be added to a fit of events.");
+  }
+  const size_t n_legendre = nu_max / 2 + 1;
+  if (!attenuation.empty() && attenuation.size() != n_legendre) {
+    throw invalid_argument("Number of attenuation coefficients must be half "
+                           "the maximum order plus one.");
+  }
+  mode = Mode::counts;
+
+  vector<double> g(n_coefficients);
+  basis_functions(theta, phi, g.data());
+  for (size_t i = 0; i < n_coefficients; ++i) {
+    g[i] *= efficiency;
+    if (!attenuation.empty()) {
+      // The coefficient d_i belongs to the order 2i + 2.
+      g[i] *= attenuation[i < n_legendre ? i : i - n_legendre + 1];
+    }
+  }
+  accumulate(g.data(), 1. / max(counts, 1.), counts);
+}
+
+LegendreFitResult LegendreFitter::fit() const {
+  if (mode == Mode::empty) {
+    throw runtime_error("No data have been added to the fit.");
+  }
+
+  const size_t n = n_coefficients;
+  LegendreFitResult result{vector<double>(n), vector<double>(n * n, 0.), 0.,
+                           0., 0};
+
+  if (mode == Mode::events) {
+    const size_t n_legendre = nu_max / 2 + 1;
+    // Inverse norms of the basis functions relative to the first one.
+    vector<double> lambda(n);
+    for (size_t i = 0; i < n_legendre; ++i) {
+      lambda[i] = 4. * i + 1.;
+    }
+    for (size_t i = n_legendre; i < n; ++i) {
+      const double l = 2. * (i - n_legendre) + 2.;
+      lambda[i] =
+          (2. * l + 1.) * 2. / ((l + 2.) * (l + 1.) * l * (l - 1.));
+    }
+
+    const double n_effective = sum_w * sum_w / sum_w2;
+    for (size_t i = 0; i < n; ++i) {
+      result.coefficients[i] = lambda[i] * sum_g[i] / sum_w;
+    }
+    for (size_t i = 1; i < n; ++i) {
+      for (size_t j = i; j < n; ++j) {
+        const double covariance =
+            lambda[i] * lambda[j] *
+            (sum_gg[i * n + j] / sum_w -
+             sum_g[i] / sum_w * sum_g[j] / sum_w) /
+            n_effective;
+        result.covariance[i * n + j] = covariance;
+        result.covariance[j * n + i] = covariance;
+      }
+    }
+    result.coefficients[0] = 1.;
+    result.amplitude = sum_w;
+    return result;
+  }
+
+  vector<double> L(n * n);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = i; j < n; ++j) {
+      L[i * n + j] = sum_gg[i * n + j];
+      L[j * n + i] = sum_gg[i * n + j];
+    }
+  }
+  if (!cholesky(n, L.data())) {
+    throw runtime_error("The counts do not determine all coefficients.");
+  }
+  vector<double> p(sum_g);
+  cholesky_solve(n, L.data(), p.data());
+  if (!(p[0] > 0.)) {
+    throw runtime_error("The fitted amplitude is not positive.");
+  }
+  const vector<double> covariance_p = cholesky_invert(n, L.data());
+
+  double chi2 = sum_wyy;
+  for (size_t i = 0; i < n; ++i) {
+    chi2 -= sum_g[i] * p[i];
+  }
+  result.chi2 = max(chi2, 0.);
+  result.n_degrees_of_freedom = n_entries > n ? n_entries - n : 0;
+  result.amplitude = p[0];
+
+  // Normalization a_i = p_i / p_0 with the Jacobian J_ii = 1 / p_0 and
+  // J_i0 = -p_i / p_0^2 for i > 0.
+  result.coefficients[0] = 1.;
+  for (size_t i = 1; i < n; ++i) {
+    result.coefficients[i] = p[i] / p[0];
+  }
+  for (size_t i = 1; i < n; ++i) {
+    for (size_t j = 1; j < n; ++j) {
+      result.covariance[i * n + j] =
+          (covariance_p[i * n + j] -
+           result.coefficients[i] * covariance_p[j] -
+           result.coefficients[j] * covariance_p[i] +
+           result.coefficients[i] * result.coefficients[j] *
+               covariance_p[0]) /
+          (p[0] * p[0]);
+    }
+  }
+
+  return result;
+}
+
+MixingRatioFitResult
+LegendreFitter::fit_mixing_ratio(const MixingRatioInverter &inverter,
+                                 const size_t n_grid) const {
+  const LegendreFitResult fit_result = fit();
+
+  // Inverse of the covariance matrix without c_0.
+  const size_t n = n_coefficients - 1;
+  vector<double> L(n * n);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      L[i * n + j] = fit_result.covariance[(i + 1) * n_coefficients + j + 1];
+    }
+  }
+  if (n > 0 && !cholesky(n, L.data())) {
+    throw runtime_error("The data do not determine all coefficients.");
+  }
+  const vector<double> inverse_covariance = cholesky_invert(n, L.data());
+
+  // Polynomials of the model, in the order of the fitted coefficients. Orders
+  // which do not exist in the model remain empty, i.e. zero.
+  const vector<vector<double>> model = inverter.coefficient_polynomials();
+  const size_t n_legendre = nu_max / 2 + 1;
+  const size_t n_legendre_model =
+      inverter.get_angular_correlation().get_legendre_coefficients().size();
+  vector<vector<double>> polynomials(n_coefficients);
+  size_t n_powers = 0;
+  for (size_t i = 0; i < n_coefficients; ++i) {
+    const size_t i_model = i < n_legendre ? i : n_legendre_model + i - n_legendre;
+    if ((i < n_legendre && i < n_legendre_model) ||
+        (i >= n_legendre && i - n_legendre < model.size() - n_legendre_model)) {
+      polynomials[i] = model[i_model];
+      n_powers = max(n_powers, polynomials[i].size());
+    }
+  }
+
+  // The ratio of two polynomials p_i(x) / p_0(x) of degree n_powers - 1 or
+  // less is evaluated in the homogeneous form
+  // sum_k p_ik sin^k(t) cos^(n_powers - 1 - k)(t) with x = tan(t), which is
+  // also valid at t = +- pi / 2.
+  vector<double> coefficients(n_coefficients), power_sin(n_powers),
+      power_cos(n_powers);
+  auto chi2 = [&](const double t) {
+    for (size_t k = 0; k < n_powers; ++k) {
+      power_sin[k] = k == 0 ? 1. : power_sin[k - 1] * sin(t);
+      power_cos[k] = k == 0 ? 1. : power_cos[k - 1] * cos(t);
+    }
+    for (size_t i = 0; i < n_coefficients; ++i) {
+      coefficients[i] = 0.;
+      for (size_t k = 0; k < polynomials[i].size(); ++k) {
+        coefficients[i] +=
+            polynomials[i][k] * power_sin[k] * power_cos[n_powers - 1 - k];
+      }
+    }
+    for (size_t i = n_coefficients; i > 0; --i) {
+      coefficients[i - 1] /= coefficients[0];
+    }
+    double result = 0.;
+    for (size_t i = 0; i < n; ++i) {
+      const double residual_i =
+          fit_result.coefficients[i + 1] - coefficients[i + 1];
+      for (size_t j = 0; j < n; ++j) {
+        result += residual_i * inverse_covariance[i * n + j] *
+                  (fit_result.coefficients[j + 1] - coefficients[j + 1]);
+      }
+    }
+    return result;
+  };
+
+  const size_t n_points = max(n_grid, (size_t)3);
+  const double step = M_PI / (n_points - 1);
+  size_t best = 0;
+  double best_chi2 = numeric_limits<double>::infinity();
+  for (size_t k = 0; k < n_points; ++k) {
+    const double chi2_k = chi2(-M_PI_2 + k * step);
+    if (chi2_k < best_chi2) {
+      best_chi2 = chi2_k;
+      best = k;
+    }
+  }
+
+  // Golden-section search between the neighbors of the best grid point.
+  const double inverse_golden_ratio = 0.5 * (sqrt(5.) - 1.);
+  double a = -M_PI_2 + (best > 0 ? best - 1 : 0) * step,
+         b = -M_PI_2 + (best + 1 < n_points ? best + 1 : best) * step;
+  double c = b - inverse_golden_ratio * (b - a),
+         d = a + inverse_golden_ratio * (b - a);
+  double chi2_c = chi2(c), chi2_d = chi2(d);
+  for (size_t iteration = 0; iteration < 100 && b - a > 1e-14; ++iteration) {
+    if (chi2_c < chi2_d) {
+      b = d;
+      d = c;
+      chi2_d = chi2_c;
+      c = b - inverse_golden_ratio * (b - a);
+      chi2_c = chi2(c);
+    } else {
+      a = c;
+      c = d;
+      chi2_c = chi2_d;
+      d = a + inverse_golden_ratio * (b - a);
+      chi2_d = chi2(d);
+    }
+  }
+  double t = 0.5 * (a + b);
+  double chi2_t = chi2(t);
+  if (best_chi2 < chi2_t) {
+    t = -M_PI_2 + best * step;
+    chi2_t = chi2(t);
+  }
+
+  return {t <= -M_PI_2  ? -numeric_limits<double>::infinity()
+          : t >= M_PI_2 ? numeric_limits<double>::infinity()
+                        : tan(t),
+          chi2_t, coefficients};
+}
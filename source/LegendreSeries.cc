@@ -0,0 +1,373 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::fill;
+using std::max;
+using std::min;
+
+#include <cmath>
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_poly.h>
+
+#include "LegendreSeries.hh"
+#include "Profiler.hh"
+
+namespace legendre_series {
+
+namespace {
+
+/**
+ * \brief Implementation of legendre() for double and float.
+ */
+template <typename Real>
+void legendre_impl(const size_t n, const Real *x, const size_t n_coefficients,
+                   const Real *coefficients, Real *result) {
+  const size_t l_max = n_coefficients ? 2 * (n_coefficients - 1) : 0;
+
+  Real p_lm2[block_size], p_lm1[block_size], p_l[block_size];
+
+  for (size_t start = 0; start < n; start += block_size) {
+    const size_t m = min(block_size, n - start);
+    const Real *x_block = x + start;
+    Real *result_block = result + start;
+
+    for (size_t k = 0; k < m; ++k) {
+      p_lm1[k] = Real(1);
+      p_l[k] = x_block[k];
+      result_block[k] = n_coefficients ? coefficients[0] : Real(0);
+    }
+
+    for (size_t l = 2; l <= l_max; ++l) {
+      const Real a = static_cast<Real>((2. * l - 1.) / l);
+      const Real b = static_cast<Real>((l - 1.) / l);
+      for (size_t k = 0; k < m; ++k) {
+        p_lm2[k] = p_lm1[k];
+        p_lm1[k] = p_l[k];
+        p_l[k] = a * x_block[k] * p_lm1[k] - b * p_lm2[k];
+      }
+      if (l % 2 == 0) {
+        const Real c = coefficients[l / 2];
+        for (size_t k = 0; k < m; ++k) {
+          result_block[k] += c * p_l[k];
+        }
+      }
+    }
+  }
+}
+
+/**
+ * \brief Implementation of associated_legendre_2() for double and float.
+ */
+template <typename Real>
+void associated_legendre_2_impl(const size_t n, const Real *x,
+                                const size_t n_coefficients,
+                                const Real *coefficients, Real *result) {
+  const size_t l_max = 2 * n_coefficients;
+
+  Real p_lm2[block_size], p_lm1[block_size], p_l[block_size];
+
+  for (size_t start = 0; start < n; start += block_size) {
+    const size_t m = min(block_size, n - start);
+    const Real *x_block = x + start;
+    Real *result_block = result + start;
+
+    for (size_t k = 0; k < m; ++k) {
+      p_lm1[k] = Real(0);
+      p_l[k] = Real(3) * (Real(1) - x_block[k] * x_block[k]);
+      result_block[k] = n_coefficients ? coefficients[0] * p_l[k] : Real(0);
+    }
+
+    for (size_t l = 3; l <= l_max; ++l) {
+      const Real a = static_cast<Real>((2. * l - 1.) / (l - 2.));
+      const Real b = static_cast<Real>((l + 1.) / (l - 2.));
+      for (size_t k = 0; k < m; ++k) {
+        p_lm2[k] = p_lm1[k];
+        p_lm1[k] = p_l[k];
+        p_l[k] = a * x_block[k] * p_lm1[k] - b * p_lm2[k];
+      }
+      if (l % 2 == 0) {
+        const Real c = coefficients[l / 2 - 1];
+        for (size_t k = 0; k < m; ++k) {
+          result_block[k] += c * p_l[k];
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+void legendre(const size_t n, const double *x, const size_t n_coefficients,
+              const double *coefficients, double *result) {
+  ALPACA_PROFILE_SCOPE("legendre_series::legendre");
+  legendre_impl(n, x, n_coefficients, coefficients, result);
+}
+
+void legendre(const size_t n, const float *x, const size_t n_coefficients,
+              const float *coefficients, float *result) {
+  ALPACA_PROFILE_SCOPE("legendre_series::legendre<float>");
+  legendre_impl(n, x, n_coefficients, coefficients, result);
+}
+
+void associated_legendre_2(const size_t n, const double *x,
+                           const size_t n_coefficients,
+                           const double *coefficients, double *result) {
+  ALPACA_PROFILE_SCOPE("legendre_series::associated_legendre_2");
+  associated_legendre_2_impl(n, x, n_coefficients, coefficients, result);
+}
+
+void associated_legendre_2(const size_t n, const float *x,
+                           const size_t n_coefficients,
+                           const float *coefficients, float *result) {
+  ALPACA_PROFILE_SCOPE("legendre_series::associated_legendre_2<float>");
+  associated_legendre_2_impl(n, x, n_coefficients, coefficients, result);
+}
+
+void legendre_derivative(const size_t n, const double *x,
+                         const size_t n_coefficients,
+                         const double *coefficients, double *result) {
+
+  const size_t l_max = n_coefficients ? 2 * (n_coefficients - 1) : 0;
+
+  double p_lm2[block_size], p_lm1[block_size], p_l[block_size];
+  double d_lm2[block_size], d_lm1[block_size], d_l[block_size];
+
+  for (size_t start = 0; start < n; start += block_size) {
+    const size_t m = min(block_size, n - start);
+    const double *x_block = x + start;
+    double *result_block = result + start;
+
+    for (size_t k = 0; k < m; ++k) {
+      p_lm1[k] = 1.;
+      p_l[k] = x_block[k];
+      d_lm1[k] = 0.;
+      d_l[k] = 1.;
+      result_block[k] = 0.;
+    }
+
+    for (size_t l = 2; l <= l_max; ++l) {
+      const double a = (2. * l - 1.) / l;
+      const double b = (l - 1.) / l;
+      for (size_t k = 0; k < m; ++k) {
+        p_lm2[k] = p_lm1[k];
+        p_lm1[k] = p_l[k];
+        d_lm2[k] = d_lm1[k];
+        d_lm1[k] = d_l[k];
+        p_l[k] = a * x_block[k] * p_lm1[k] - b * p_lm2[k];
+        d_l[k] = a * (p_lm1[k] + x_block[k] * d_lm1[k]) - b * d_lm2[k];
+      }
+      if (l % 2 == 0) {
+        const double c = coefficients[l / 2];
+        for (size_t k = 0; k < m; ++k) {
+          result_block[k] += c * d_l[k];
+        }
+      }
+    }
+  }
+}
+
+void associated_legendre_2_derivative(const size_t n, const double *x,
+                                      const size_t n_coefficients,
+                                      const double *coefficients,
+                                      double *result) {
+
+  const size_t l_max = 2 * n_coefficients;
+
+  double p_lm2[block_size], p_lm1[block_size], p_l[block_size];
+  double d_lm2[block_size], d_lm1[block_size], d_l[block_size];
+
+  for (size_t start = 0; start < n; start += block_size) {
+    const size_t m = min(block_size, n - start);
+    const double *x_block = x + start;
+    double *result_block = result + start;
+
+    for (size_t k = 0; k < m; ++k) {
+      p_lm1[k] = 0.;
+      p_l[k] = 3. * (1. - x_block[k] * x_block[k]);
+      d_lm1[k] = 0.;
+      d_l[k] = -6. * x_block[k];
+      result_block[k] = n_coefficients ? coefficients[0] * d_l[k] : 0.;
+    }
+
+    for (size_t l = 3; l <= l_max; ++l) {
+      const double a = (2. * l - 1.) / (l - 2.);
+      const double b = (l + 1.) / (l - 2.);
+      for (size_t k = 0; k < m; ++k) {
+        p_lm2[k] = p_lm1[k];
+        p_lm1[k] = p_l[k];
+        d_lm2[k] = d_lm1[k];
+        d_lm1[k] = d_l[k];
+        p_l[k] = a * x_block[k] * p_lm1[k] - b * p_lm2[k];
+        d_l[k] = a * (p_lm1[k] + x_block[k] * d_lm1[k]) - b * d_lm2[k];
+      }
+      if (l % 2 == 0) {
+        const double c = coefficients[l / 2 - 1];
+        for (size_t k = 0; k < m; ++k) {
+          result_block[k] += c * d_l[k];
+        }
+      }
+    }
+  }
+}
+
+vector<double> power_series(const size_t n_coefficients,
+                            const double *coefficients,
+                            const size_t n_coefficients_2,
+                            const double *coefficients_2, const double sigma) {
+
+  const size_t l_max =
+      max(n_coefficients ? 2 * (n_coefficients - 1) : 0, 2 * n_coefficients_2);
+  vector<double> result(l_max + 1, 0.);
+
+  vector<double> p_lm2(l_max + 1, 0.), p_lm1(l_max + 1, 0.), p_l(l_max + 1, 0.);
+
+  // Legendre polynomials, starting with P_0 = 1.
+  if (n_coefficients) {
+    p_l[0] = 1.;
+    for (size_t l = 0; l <= 2 * (n_coefficients - 1); ++l) {
+      if (l >= 1) {
+        p_lm2 = p_lm1;
+        p_lm1 = p_l;
+        for (size_t k = 0; k <= l_max; ++k) {
+          p_l[k] = (k ? (2. * l - 1.) * p_lm1[k - 1] : 0.);
+          p_l[k] = (p_l[k] - (l - 1.) * p_lm2[k]) / l;
+        }
+      }
+      if (l % 2 == 0) {
+        for (size_t k = 0; k <= l_max; ++k) {
+          result[k] += coefficients[l / 2] * p_l[k];
+        }
+      }
+    }
+  }
+
+  // Associated Legendre polynomials, starting with P_1^2 = 0 and
+  // P_2^2 = 3 (1 - x^2).
+  if (n_coefficients_2) {
+    fill(p_lm1.begin(), p_lm1.end(), 0.);
+    fill(p_l.begin(), p_l.end(), 0.);
+    p_l[0] = 3.;
+    p_l[2] = -3.;
+    for (size_t l = 2; l <= 2 * n_coefficients_2; ++l) {
+      if (l >= 3) {
+        p_lm2 = p_lm1;
+        p_lm1 = p_l;
+        for (size_t k = 0; k <= l_max; ++k) {
+          p_l[k] = (k ? (2. * l - 1.) * p_lm1[k - 1] : 0.);
+          p_l[k] = (p_l[k] - (l + 1.) * p_lm2[k]) / (l - 2.);
+        }
+      }
+      if (l % 2 == 0) {
+        for (size_t k = 0; k <= l_max; ++k) {
+          result[k] += sigma * coefficients_2[l / 2 - 1] * p_l[k];
+        }
+      }
+    }
+  }
+
+  return result;
+}
+
+double maximum(const size_t n_coefficients, const double *coefficients,
+               const size_t n_coefficients_2, const double *coefficients_2) {
+  ALPACA_PROFILE_SCOPE("legendre_series::maximum");
+
+  vector<double> candidates{-1., 1.};
+
+  for (double sigma : {1., -1.}) {
+    const vector<double> polynomial = power_series(
+        n_coefficients, coefficients, n_coefficients_2, coefficients_2, sigma);
+
+    vector<double> derivative(polynomial.size() - 1);
+    double derivative_scale = 0.;
+    for (size_t k = 1; k < polynomial.size(); ++k) {
+      derivative[k - 1] = k * polynomial[k];
+      derivative_scale = max(derivative_scale, fabs(derivative[k - 1]));
+    }
+    // Remove leading coefficients which vanish up to rounding errors, because
+    // gsl_poly_complex_solve() requires a nonzero leading coefficient.
+    while (!derivative.empty() &&
+           fabs(derivative.back()) <= 1e-12 * derivative_scale) {
+      derivative.pop_back();
+    }
+
+    if (derivative.size() >= 2) {
+      vector<double> roots(2 * (derivative.size() - 1));
+      gsl_poly_complex_workspace *workspace =
+          gsl_poly_complex_workspace_alloc(derivative.size());
+      gsl_poly_complex_solve(derivative.data(), derivative.size(), workspace,
+                             roots.data());
+      gsl_poly_complex_workspace_free(workspace);
+
+      for (size_t i = 0; i < roots.size(); i += 2) {
+        candidates.push_back(max(-1., min(1., roots[i])));
+      }
+    }
+
+    if (!n_coefficients_2) {
+      break;
+    }
+  }
+
+  vector<double> s(candidates.size()), s_2(candidates.size(), 0.);
+  legendre(candidates.size(), candidates.data(), n_coefficients, coefficients,
+           s.data());
+  associated_legendre_2(candidates.size(), candidates.data(), n_coefficients_2,
+                        coefficients_2, s_2.data());
+
+  double result = 0.;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    result = max(result, fabs(s[i]) + fabs(s_2[i]));
+  }
+
+  return result;
+}
+
+void cone_integrals(const size_t n_orders, const double cos_alpha,
+                    double *result) {
+
+  if (n_orders == 0) {
+    return;
+  }
+
+  result[0] = 2. * M_PI * (1. - cos_alpha);
+
+  // P_{l-2} and P_{l-1}
+  double p_lm2 = 1., p_lm1 = cos_alpha;
+  for (size_t i = 1; i < n_orders; ++i) {
+    const double p_2i_m1 = p_lm1;
+    // Advance the recurrence from P_{2i-1} to P_{2i+1}.
+    for (size_t l = 2 * i; l <= 2 * i + 1; ++l) {
+      const double p_l =
+          ((2. * l - 1.) * cos_alpha * p_lm1 - (l - 1.) * p_lm2) / l;
+      p_lm2 = p_lm1;
+      p_lm1 = p_l;
+    }
+    result[i] = 2. * M_PI * (p_2i_m1 - p_lm1) / (4. * i + 1.);
+  }
+}
+
+} // namespace legendre_series
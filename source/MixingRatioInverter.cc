@@ -0,0 +1,399 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::sort;
+using std::unique;
+
+#include <cmath>
+
+#include <limits>
+
+using std::numeric_limits;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <string>
+
+using std::to_string;
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_poly.h>
+
+#include "MixingRatioInverter.hh"
+
+namespace {
+
+/*
+    Power-series coefficients of a linear combination of two polynomials.
+*/
+vector<double> linear_combination(const double alpha, const vector<double> &p,
+                                  const double beta, const vector<double> &q) {
+  vector<double> result(max(p.size(), q.size()), 0.);
+  for (size_t k = 0; k < p.size(); ++k) {
+    result[k] += alpha * p[k];
+  }
+  for (size_t k = 0; k < q.size(); ++k) {
+    result[k] += beta * q[k];
+  }
+  return result;
+}
+
+double horner(const vector<double> &p, const double x) {
+  double result = 0.;
+  for (size_t k = p.size(); k > 0; --k) {
+    result = result * x + p[k - 1];
+  }
+  return result;
+}
+
+/*
+    Append the arctangents of the real parts of all roots of a polynomial.
+    As in legendre_series::maximum(), the real parts of all complex roots are
+    used, which makes the result insensitive to the numerical error of the
+    imaginary parts of multiple roots. Spurious candidates do no harm, since
+    every candidate is tested afterwards.
+*/
+void append_arctan_roots(vector<double> p, vector<double> &arctan_roots) {
+  double scale = 0.;
+  for (auto c : p) {
+    scale = max(scale, fabs(c));
+  }
+  // Remove leading coefficients which vanish up to rounding errors, because
+  // gsl_poly_complex_solve() requires a nonzero leading coefficient.
+  while (!p.empty() && fabs(p.back()) <= 1e-12 * scale) {
+    p.pop_back();
+  }
+
+  if (p.size() >= 2) {
+    vector<double> roots(2 * (p.size() - 1));
+    gsl_poly_complex_workspace *workspace =
+        gsl_poly_complex_workspace_alloc(p.size());
+    gsl_poly_complex_solve(p.data(), p.size(), workspace, roots.data());
+    gsl_poly_complex_workspace_free(workspace);
+
+    for (size_t i = 0; i < roots.size(); i += 2) {
+      arctan_roots.push_back(atan(roots[i]));
+    }
+  }
+}
+
+} // namespace
+
+MixingRatioInverter::MixingRatioInverter(const AngularCorrelation &ang_cor,
+                                         const vector<double> &slope,
+                                         const vector<double> &offset)
+    : angular_correlation(ang_cor), slope(slope), offset(offset) {
+
+  const size_t n_cascade_steps = ang_cor.get_cascade_steps().size();
+  if (slope.size() != n_cascade_steps) {
+    throw invalid_argument("Number of slopes (" + to_string(slope.size()) +
+                           ") does not match the number of cascade steps (" +
+                           to_string(n_cascade_steps) + ").");
+  }
+  if (offset.empty()) {
+    this->offset = vector<double>(n_cascade_steps, 0.);
+  } else if (offset.size() != n_cascade_steps) {
+    throw invalid_argument("Number of offsets (" + to_string(offset.size()) +
+                           ") does not match the number of cascade steps (" +
+                           to_string(n_cascade_steps) + ").");
+  }
+
+  n_variable_deltas = 0;
+  for (auto a : slope) {
+    if (a != 0.) {
+      ++n_variable_deltas;
+    }
+  }
+}
+
+vector<double> MixingRatioInverter::get_deltas(const double x) const {
+  vector<double> deltas(slope.size());
+  for (size_t j = 0; j < slope.size(); ++j) {
+    deltas[j] = slope[j] * x + offset[j];
+  }
+  return deltas;
+}
+
+vector<double> MixingRatioInverter::nodes() const {
+  // Chebyshev nodes keep the interpolation well conditioned.
+  const size_t n_nodes = 2 * n_variable_deltas + 1;
+  vector<double> x(n_nodes);
+  for (size_t k = 0; k < n_nodes; ++k) {
+    x[k] = cos(M_PI * (k + 0.5) / n_nodes);
+  }
+  return x;
+}
+
+vector<double> MixingRatioInverter::interpolate(const vector<double> &x,
+                                                const vector<double> &y) {
+  const size_t n = x.size();
+
+  // Coefficients of the Newton form from divided differences.
+  vector<double> newton(y);
+  for (size_t j = 1; j < n; ++j) {
+    for (size_t i = n - 1; i >= j; --i) {
+      newton[i] = (newton[i] - newton[i - 1]) / (x[i] - x[i - j]);
+    }
+  }
+
+  // Conversion to a power series with a Horner-like scheme.
+  vector<double> power_series(n, 0.);
+  power_series[0] = newton[n - 1];
+  for (size_t k = n - 1; k > 0; --k) {
+    for (size_t i = n - k; i > 0; --i) {
+      power_series[i] = power_series[i - 1] - x[k - 1] * power_series[i];
+    }
+    power_series[0] = newton[k - 1] - x[k - 1] * power_series[0];
+  }
+
+  return power_series;
+}
+
+vector<vector<double>>
+MixingRatioInverter::polynomials(const vector<double> &theta,
+                                 const vector<double> &phi) const {
+  const vector<double> x = nodes();
+  const size_t n_directions = theta.size();
+
+  vector<double> deltas, normalization(x.size());
+  for (size_t k = 0; k < x.size(); ++k) {
+    const vector<double> deltas_k = get_deltas(x[k]);
+    deltas.insert(deltas.end(), deltas_k.begin(), deltas_k.end());
+    normalization[k] = 1.;
+    for (auto delta : deltas_k) {
+      normalization[k] *= 1. + delta * delta;
+    }
+  }
+
+  vector<double> w(x.size() * n_directions);
+  angular_correlation.scan_deltas(x.size(), deltas.data(), n_directions,
+                                  theta.data(), phi.data(), w.data());
+
+  vector<vector<double>> result(n_directions);
+  vector<double> w_tilde(x.size());
+  for (size_t i = 0; i < n_directions; ++i) {
+    for (size_t k = 0; k < x.size(); ++k) {
+      w_tilde[k] = w[k * n_directions + i] * normalization[k];
+    }
+    result[i] = interpolate(x, w_tilde);
+  }
+
+  return result;
+}
+
+vector<double> MixingRatioInverter::polynomial(const double theta,
+                                               const double phi) const {
+  return polynomials({theta}, {phi})[0];
+}
+
+vector<vector<double>> MixingRatioInverter::coefficient_polynomials() const {
+  const vector<double> x = nodes();
+  const State initial_state = angular_correlation.get_initial_state();
+
+  vector<vector<double>> coefficients(x.size());
+  for (size_t k = 0; k < x.size(); ++k) {
+    const vector<double> deltas_k = get_deltas(x[k]);
+    vector<pair<Transition, State>> cascade_steps =
+        angular_correlation.get_cascade_steps();
+    double normalization = 1.;
+    for (size_t j = 0; j < cascade_steps.size(); ++j) {
+      cascade_steps[j].first.delta = deltas_k[j];
+      normalization *= 1. + deltas_k[j] * deltas_k[j];
+    }
+    const AngularCorrelation ang_cor(initial_state, cascade_steps);
+    coefficients[k] = ang_cor.get_legendre_coefficients();
+    const vector<double> associated_legendre_coefficients =
+        ang_cor.get_associated_legendre_coefficients();
+    coefficients[k].insert(coefficients[k].end(),
+                           associated_legendre_coefficients.begin(),
+                           associated_legendre_coefficients.end());
+    for (auto &c : coefficients[k]) {
+      c *= normalization;
+    }
+  }
+
+  vector<vector<double>> result(coefficients[0].size());
+  vector<double> c_tilde(x.size());
+  for (size_t i = 0; i < result.size(); ++i) {
+    for (size_t k = 0; k < x.size(); ++k) {
+      c_tilde[k] = i < coefficients[k].size() ? coefficients[k][i] : 0.;
+    }
+    result[i] = interpolate(x, c_tilde);
+  }
+  return result;
+}
+
+vector<double> MixingRatioInverter::normalization_polynomial() const {
+  vector<double> result{1.};
+  for (size_t j = 0; j < slope.size(); ++j) {
+    // 1 + (a x + b)^2 = (1 + b^2) + 2 a b x + a^2 x^2
+    const double factor[3]{1. + offset[j] * offset[j],
+                           2. * slope[j] * offset[j], slope[j] * slope[j]};
+    const size_t degree = slope[j] != 0. ? 2 : 0;
+    vector<double> product(result.size() + degree, 0.);
+    for (size_t i = 0; i < result.size(); ++i) {
+      for (size_t k = 0; k <= degree; ++k) {
+        product[i + k] += result[i] * factor[k];
+      }
+    }
+    result = product;
+  }
+  return result;
+}
+
+vector<array<double, 2>> MixingRatioInverter::invert_angular_correlation(
+    const double theta, const double phi, const double value,
+    const double uncertainty, const bool return_arctan) const {
+
+  if (uncertainty < 0.) {
+    throw invalid_argument("Uncertainty must not be negative.");
+  }
+
+  return invert_rational_function(polynomial(theta, phi),
+                                  normalization_polynomial(),
+                                  value - uncertainty, value + uncertainty,
+                                  return_arctan);
+}
+
+vector<array<double, 2>> MixingRatioInverter::invert_analyzing_power(
+    const double theta, const double thetap, const double phi,
+    const double phip, const double PQ, const double value,
+    const double uncertainty, const bool return_arctan) const {
+
+  if (uncertainty < 0.) {
+    throw invalid_argument("Uncertainty must not be negative.");
+  }
+
+  const vector<vector<double>> w_tilde =
+      polynomials({theta, thetap}, {phi, phip});
+
+  return invert_rational_function(
+      linear_combination(PQ, w_tilde[0], -PQ, w_tilde[1]),
+      linear_combination(1., w_tilde[0], 1., w_tilde[1]), value - uncertainty,
+      value + uncertainty, return_arctan);
+}
+
+vector<array<double, 2>> MixingRatioInverter::invert_rational_function(
+    const vector<double> &numerator, const vector<double> &denominator,
+    const double lower, const double upper, const bool return_arctan) {
+
+  if (upper < lower) {
+    return {};
+  }
+
+  // Limits of all ranges in which the ratio is either completely inside or
+  // completely outside of [lower, upper].
+  vector<double> limits{-M_PI_2, M_PI_2};
+  append_arctan_roots(linear_combination(1., numerator, -lower, denominator),
+                      limits);
+  append_arctan_roots(linear_combination(-1., numerator, upper, denominator),
+                      limits);
+  sort(limits.begin(), limits.end());
+  limits.erase(unique(limits.begin(), limits.end()), limits.end());
+
+  const size_t n_ranges = limits.size() - 1;
+  vector<bool> range_inside(n_ranges);
+  for (size_t i = 0; i < n_ranges; ++i) {
+    const double x = tan(0.5 * (limits[i] + limits[i + 1]));
+    const double ratio = horner(numerator, x) / horner(denominator, x);
+    range_inside[i] = ratio >= lower && ratio <= upper;
+  }
+
+  // A limit is part of the solution set if one of the neighboring ranges is.
+  // Otherwise, it may still be an isolated solution, for example if the range
+  // [lower, upper] has zero width, or if the ratio only touches one of its
+  // limits. The limits x -> +- infinity are evaluated using the leading
+  // coefficients.
+  const double tolerance = 1e-9 * max(1., max(fabs(lower), fabs(upper)));
+  vector<bool> limit_inside(limits.size());
+  for (size_t i = 0; i < limits.size(); ++i) {
+    if ((i > 0 && range_inside[i - 1]) || (i < n_ranges && range_inside[i])) {
+      limit_inside[i] = true;
+      continue;
+    }
+    double ratio;
+    if (i == 0 || i == n_ranges) {
+      const size_t degree = max(numerator.size(), denominator.size()) - 1;
+      ratio = (numerator.size() > degree ? numerator[degree] : 0.) /
+              (denominator.size() > degree ? denominator[degree] : 0.);
+    } else {
+      const double x = tan(limits[i]);
+      ratio = horner(numerator, x) / horner(denominator, x);
+    }
+    limit_inside[i] =
+        ratio >= lower - tolerance && ratio <= upper + tolerance;
+  }
+
+  vector<array<double, 2>> intervals;
+  for (size_t i = 0; i < limits.size(); ++i) {
+    if (!limit_inside[i]) {
+      continue;
+    }
+    const double interval_start = limits[i];
+    while (i < n_ranges && range_inside[i]) {
+      ++i;
+    }
+    intervals.push_back({interval_start, limits[i]});
+  }
+
+  if (!return_arctan) {
+    for (auto &interval : intervals) {
+      for (auto &limit : interval) {
+        limit = limit == -M_PI_2   ? -numeric_limits<double>::infinity()
+                : limit == M_PI_2 ? numeric_limits<double>::infinity()
+                                  : tan(limit);
+      }
+    }
+  }
+
+  return intervals;
+}
+
+extern "C" {
+size_t invert_analyzing_power(AngularCorrelation *angular_correlation,
+                              double *slope, double *offset,
+                              const double theta, const double thetap,
+                              const double phi, const double phip,
+                              const double PQ, const double value,
+                              const double uncertainty,
+                              const bool return_arctan,
+                              const size_t max_intervals, double *intervals) {
+
+  const size_t n_cascade_steps =
+      angular_correlation->get_cascade_steps().size();
+  const vector<array<double, 2>> result =
+      MixingRatioInverter(*angular_correlation,
+                          vector<double>(slope, slope + n_cascade_steps),
+                          vector<double>(offset, offset + n_cascade_steps))
+          .invert_analyzing_power(theta, thetap, phi, phip, PQ, value,
+                                  uncertainty, return_arctan);
+
+  for (size_t i = 0; i < result.size() && i < max_intervals; ++i) {
+    intervals[2 * i] = result[i][0];
+    intervals[2 * i + 1] = result[i][1];
+  }
+
+  return result.size();
+}
+}
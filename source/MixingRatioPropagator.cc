@@ -0,0 +1,274 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::sort;
+
+#include <cmath>
+
+#include <random>
+
+using std::normal_distribution;
+using std::uniform_real_distribution;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <utility>
+
+using std::move;
+
+#include "MixingRatioPropagator.hh"
+
+MixingRatioPropagator::MixingRatioPropagator(
+    const vector<AngularCorrelation> &hyp,
+    const vector<vector<MixingRatioDistribution>> &dis,
+    const vector<double> &pro, const uint64_t seed)
+    : hypotheses(hyp), distributions(dis), random_engine(seed) {
+
+  if (hypotheses.empty()) {
+    throw invalid_argument("At least one hypothesis is required.");
+  }
+  if (distributions.size() != hypotheses.size() ||
+      pro.size() != hypotheses.size()) {
+    throw invalid_argument("Numbers of hypotheses, distributions, and "
+                           "probabilities must be equal.");
+  }
+
+  for (size_t i = 0; i < hypotheses.size(); ++i) {
+    if (distributions[i].size() !=
+        hypotheses[i].get_cascade_steps().size()) {
+      throw invalid_argument("Number of distributions must be equal to the "
+                             "number of cascade steps.");
+    }
+    for (size_t j = 0; j < distributions[i].size(); ++j) {
+      if (distributions[i][j].sigma < 0.) {
+        throw invalid_argument("Standard deviation must not be negative.");
+      }
+      if (distributions[i][j].type == proportional_delta &&
+          distributions[i][j].step >= j) {
+        throw invalid_argument(
+            "Mixing ratio can only be proportional to a previous one.");
+      }
+    }
+  }
+
+  double sum = 0.;
+  for (auto p : pro) {
+    if (p < 0.) {
+      throw invalid_argument("Probabilities must not be negative.");
+    }
+    sum += p;
+  }
+  if (sum <= 0.) {
+    throw invalid_argument("Sum of the probabilities must be positive.");
+  }
+  probabilities.resize(pro.size());
+  double cumulative = 0.;
+  for (size_t i = 0; i < pro.size(); ++i) {
+    cumulative += pro[i] / sum;
+    probabilities[i] = cumulative;
+  }
+}
+
+vector<double> MixingRatioPropagator::draw_deltas(const size_t hypothesis,
+                                                  const size_t n) {
+  const vector<MixingRatioDistribution> &dis = distributions.at(hypothesis);
+  const size_t n_steps = dis.size();
+
+  normal_distribution<double> normal;
+  vector<double> deltas(n * n_steps);
+  for (size_t k = 0; k < n; ++k) {
+    double *deltas_k = deltas.data() + k * n_steps;
+    for (size_t j = 0; j < n_steps; ++j) {
+      switch (dis[j].type) {
+      case gaussian_delta:
+        deltas_k[j] = dis[j].value + dis[j].sigma * normal(random_engine);
+        break;
+      case gaussian_arctan_delta:
+        // The tangent has a period of pi, so arguments outside of
+        // [-pi/2, pi/2] wrap around.
+        deltas_k[j] =
+            tan(atan(dis[j].value) + dis[j].sigma * normal(random_engine));
+        break;
+      case proportional_delta:
+        deltas_k[j] = dis[j].value * deltas_k[dis[j].step];
+        break;
+      default:
+        deltas_k[j] = dis[j].value;
+      }
+    }
+  }
+
+  return deltas;
+}
+
+PropagationResult MixingRatioPropagator::angular_correlation(
+    const size_t n_draws, const vector<double> &theta,
+    const vector<double> &phi, const vector<double> &quantile_probabilities) {
+
+  if (theta.size() != phi.size()) {
+    throw invalid_argument("Numbers of polar and azimuthal angles must be "
+                           "equal.");
+  }
+
+  return statistics(n_draws, theta.size(), scan(n_draws, theta, phi),
+                    quantile_probabilities);
+}
+
+PropagationResult MixingRatioPropagator::analyzing_power(
+    const size_t n_draws, const vector<double> &theta,
+    const vector<double> &thetap, const vector<double> &phi,
+    const vector<double> &phip, const double PQ,
+    const vector<double> &quantile_probabilities) {
+
+  const size_t n_pairs = theta.size();
+  if (thetap.size() != n_pairs || phi.size() != n_pairs ||
+      phip.size() != n_pairs) {
+    throw invalid_argument("Numbers of angles must be equal.");
+  }
+
+  // Both directions of all pairs are evaluated in a single scan.
+  vector<double> theta_both(theta), phi_both(phi);
+  theta_both.insert(theta_both.end(), thetap.begin(), thetap.end());
+  phi_both.insert(phi_both.end(), phip.begin(), phip.end());
+  const vector<double> w = scan(n_draws, theta_both, phi_both);
+
+  vector<double> samples(n_draws * n_pairs);
+  for (size_t k = 0; k < n_draws; ++k) {
+    const double *w_k = w.data() + 2 * n_pairs * k;
+    double *a_k = samples.data() + n_pairs * k;
+    for (size_t i = 0; i < n_pairs; ++i) {
+      a_k[i] = PQ * (w_k[i] - w_k[n_pairs + i]) / (w_k[i] + w_k[n_pairs + i]);
+    }
+  }
+
+  return statistics(n_draws, n_pairs, move(samples), quantile_probabilities);
+}
+
+vector<double> MixingRatioPropagator::scan(const size_t n_draws,
+                                           const vector<double> &theta,
+                                           const vector<double> &phi) {
+  if (n_draws < 2) {
+    throw invalid_argument("At least two draws are required.");
+  }
+
+  // Number of draws for each hypothesis.
+  vector<size_t> n_hypothesis(hypotheses.size(), 0);
+  uniform_real_distribution<double> uniform;
+  for (size_t k = 0; k < n_draws; ++k) {
+    const double u = uniform(random_engine);
+    size_t i = 0;
+    while (i + 1 < probabilities.size() && u >= probabilities[i]) {
+      ++i;
+    }
+    ++n_hypothesis[i];
+  }
+
+  const size_t n_angles = theta.size();
+  vector<double> w(n_draws * n_angles);
+  double *w_i = w.data();
+  for (size_t i = 0; i < hypotheses.size(); ++i) {
+    if (n_hypothesis[i] == 0) {
+      continue;
+    }
+    const vector<double> deltas = draw_deltas(i, n_hypothesis[i]);
+    hypotheses[i].scan_deltas(n_hypothesis[i], deltas.data(), n_angles,
+                              theta.data(), phi.data(), w_i);
+    w_i += n_hypothesis[i] * n_angles;
+  }
+
+  return w;
+}
+
+PropagationResult
+MixingRatioPropagator::statistics(const size_t n_draws,
+                                  const size_t n_observables,
+                                  vector<double> samples,
+                                  const vector<double> &probabilities) {
+  for (auto p : probabilities) {
+    if (p < 0. || p > 1.) {
+      throw invalid_argument("Probabilities must be in the interval [0, 1].");
+    }
+  }
+
+  PropagationResult result;
+  result.n_draws = n_draws;
+  result.n_observables = n_observables;
+  result.probabilities = probabilities;
+
+  // The sums run over the draws in the outer loop, so that the inner loops
+  // over the observables are contiguous.
+  result.mean.assign(n_observables, 0.);
+  for (size_t k = 0; k < n_draws; ++k) {
+    const double *x_k = samples.data() + k * n_observables;
+    for (size_t i = 0; i < n_observables; ++i) {
+      result.mean[i] += x_k[i];
+    }
+  }
+  for (size_t i = 0; i < n_observables; ++i) {
+    result.mean[i] /= n_draws;
+  }
+
+  // Two-pass algorithm with centered values to avoid cancellation.
+  result.covariance.assign(n_observables * n_observables, 0.);
+  vector<double> centered(n_observables);
+  for (size_t k = 0; k < n_draws; ++k) {
+    const double *x_k = samples.data() + k * n_observables;
+    for (size_t i = 0; i < n_observables; ++i) {
+      centered[i] = x_k[i] - result.mean[i];
+    }
+    for (size_t i = 0; i < n_observables; ++i) {
+      double *cov_i = result.covariance.data() + i * n_observables;
+      for (size_t j = 0; j <= i; ++j) {
+        cov_i[j] += centered[i] * centered[j];
+      }
+    }
+  }
+  for (size_t i = 0; i < n_observables; ++i) {
+    for (size_t j = 0; j <= i; ++j) {
+      result.covariance[i * n_observables + j] /= (n_draws - 1);
+      result.covariance[j * n_observables + i] =
+          result.covariance[i * n_observables + j];
+    }
+  }
+
+  // Quantiles, interpolated linearly between the order statistics.
+  result.quantiles.resize(probabilities.size() * n_observables);
+  vector<double> column(n_draws);
+  for (size_t i = 0; i < n_observables; ++i) {
+    for (size_t k = 0; k < n_draws; ++k) {
+      column[k] = samples[k * n_observables + i];
+    }
+    sort(column.begin(), column.end());
+    for (size_t q = 0; q < probabilities.size(); ++q) {
+      const double h = probabilities[q] * (n_draws - 1);
+      const size_t lower = static_cast<size_t>(floor(h));
+      const size_t upper = lower + 1 < n_draws ? lower + 1 : lower;
+      result.quantiles[q * n_observables + i] =
+          column[lower] + (h - lower) * (column[upper] - column[lower]);
+    }
+  }
+
+  result.samples = move(samples);
+
+  return result;
+}
@@ -0,0 +1,85 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <atomic>
+
+using std::atomic;
+
+#include <functional>
+
+using std::ref;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <thread>
+
+using std::thread;
+
+#include "ParallelCascadeSampler.hh"
+
+ParallelCascadeSampler::ParallelCascadeSampler(
+    function<CascadeSampler()> create_cascade_sampler,
+    const unsigned int master_seed, const unsigned int n_threads,
+    const size_t chunk_size)
+    : master_seed(master_seed), chunk_size(chunk_size) {
+  if (chunk_size == 0) {
+    throw invalid_argument("Chunk size must be larger than zero.");
+  }
+
+  const unsigned int n_thr =
+      n_threads > 0 ? n_threads : max(1u, thread::hardware_concurrency());
+  for (unsigned int i = 0; i < n_thr; ++i) {
+    cascade_samplers.push_back(create_cascade_sampler());
+  }
+}
+
+void ParallelCascadeSampler::sample(const size_t n_events,
+                                    double *Phi_Theta_Psi) {
+  const size_t n_chunks = (n_events + chunk_size - 1) / chunk_size;
+  atomic<size_t> next_chunk{0};
+
+  auto work = [&](CascadeSampler &cascade_sampler) {
+    for (size_t c = next_chunk++; c < n_chunks; c = next_chunk++) {
+      const size_t start = c * chunk_size;
+      cascade_sampler.reseed(master_seed, n_chunks_sampled + c);
+      cascade_sampler.sample(min(chunk_size, n_events - start),
+                             Phi_Theta_Psi + start, n_events);
+    }
+  };
+
+  const size_t n_workers = min(cascade_samplers.size(), n_chunks);
+  vector<thread> threads;
+  for (size_t i = 1; i < n_workers; ++i) {
+    threads.push_back(thread(work, ref(cascade_samplers[i])));
+  }
+  if (n_workers > 0) {
+    work(cascade_samplers[0]);
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  n_chunks_sampled += n_chunks;
+}
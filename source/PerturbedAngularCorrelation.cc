@@ -0,0 +1,237 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cmath>
+
+#include <map>
+
+using std::map;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include "PerturbedAngularCorrelation.hh"
+#include "ThreadPool.hh"
+#include "WignerSymbolCache.hh"
+
+double PerturbationFactor::operator()(const size_t i, const double t) const {
+  double result = 1.;
+  if (i < amplitudes.size()) {
+    result = 0.;
+    for (size_t n = 0; n < amplitudes[i].size(); ++n) {
+      result += amplitudes[i][n] * cos(frequencies[i][n] * t);
+    }
+  }
+  if (i < relaxation_rates.size()) {
+    result *= exp(-relaxation_rates[i] * t);
+  }
+  return result;
+}
+
+PerturbationFactor PerturbationFactor::static_quadrupole(const int two_I,
+                                                         const double omega_Q,
+                                                         const int nu_max) {
+  if (two_I < 0 || nu_max < 0) {
+    throw invalid_argument("Spin and maximum order must not be negative.");
+  }
+
+  PerturbationFactor factor;
+  factor.amplitudes.resize(nu_max / 2 + 1);
+  factor.frequencies.resize(nu_max / 2 + 1);
+
+  for (int i = 0; 2 * i <= nu_max; ++i) {
+    const int two_k = 4 * i;
+    if (two_k > 2 * two_I) {
+      continue;
+    }
+
+    // Amplitudes ordered by the frequency in units of 3 omega_Q / 4, i.e.
+    // |4m^2 - 4m'^2| = |two_m^2 - two_mp^2|.
+    map<int, double> terms;
+    for (int two_m = -two_I; two_m <= two_I; two_m += 2) {
+      for (int two_mp = -two_I; two_mp <= two_I; two_mp += 2) {
+        if (abs(two_m - two_mp) > two_k) {
+          continue;
+        }
+        const double symbol = WignerSymbolCache::coupling_3j(
+            two_I, two_I, two_k, two_mp, -two_m, two_m - two_mp);
+        terms[abs(two_m * two_m - two_mp * two_mp)] += symbol * symbol;
+      }
+    }
+
+    for (const auto &term : terms) {
+      factor.amplitudes[i].push_back(term.second);
+      factor.frequencies[i].push_back(0.75 * omega_Q * term.first);
+    }
+  }
+
+  return factor;
+}
+
+PerturbationFactor PerturbationFactor::relaxation(const vector<double> &rates) {
+  for (const double rate : rates) {
+    if (rate < 0.) {
+      throw invalid_argument("Relaxation rates must not be negative.");
+    }
+  }
+
+  PerturbationFactor factor;
+  factor.relaxation_rates = rates;
+  return factor;
+}
+
+PerturbedAngularCorrelation::PerturbedAngularCorrelation(
+    const vector<double> &leg_coe, const vector<PerturbationFactor> &fac,
+    const double lar_fre)
+    : legendre_coefficients(leg_coe), factors(fac),
+      larmor_frequency(lar_fre) {
+  if (legendre_coefficients.empty()) {
+    throw invalid_argument("At least one expansion coefficient is required.");
+  }
+  fourier = fourier_coefficients(get_nu_max());
+}
+
+PerturbedAngularCorrelation::PerturbedAngularCorrelation(
+    const AngularCorrelation &ang_cor, const vector<PerturbationFactor> &fac,
+    const double lar_fre)
+    : PerturbedAngularCorrelation(ang_cor.get_legendre_coefficients(), fac,
+                                  lar_fre) {
+  for (const double d : ang_cor.get_associated_legendre_coefficients()) {
+    if (d != 0.) {
+      throw invalid_argument(
+          "Only direction-direction correlations can be perturbed.");
+    }
+  }
+}
+
+double PerturbedAngularCorrelation::operator()(const double theta,
+                                               const double t) const {
+  double result;
+  evaluate(1, &t, 1, &theta, &result);
+  return result;
+}
+
+void PerturbedAngularCorrelation::evaluate(const size_t n_times,
+                                           const double *t,
+                                           const size_t n_angles,
+                                           const double *theta,
+                                           double *result) const {
+  const size_t n_terms = legendre_coefficients.size();
+  const bool precession = larmor_frequency != 0.;
+
+  // Functions of the angle, cos(2j theta) and, with a precession,
+  // sin(2j theta), with the index of the angle running fastest.
+  vector<double> cos_2j_theta(n_terms * n_angles);
+  vector<double> sin_2j_theta(precession ? n_terms * n_angles : 0);
+  for (size_t j = 0; j < n_terms; ++j) {
+    for (size_t k = 0; k < n_angles; ++k) {
+      cos_2j_theta[j * n_angles + k] = cos(2. * j * theta[k]);
+      if (precession) {
+        sin_2j_theta[j * n_angles + k] = sin(2. * j * theta[k]);
+      }
+    }
+  }
+
+  ThreadPool::parallel_for(
+      n_times,
+      [&](const size_t begin, const size_t end) {
+        vector<double> G(n_terms), f(n_terms);
+        for (size_t l = begin; l < end; ++l) {
+          perturbation_coefficients(t[l], G.data());
+          time_functions(G.data(), f.data());
+          double *row = result + l * n_angles;
+          for (size_t k = 0; k < n_angles; ++k) {
+            row[k] = f[0];
+          }
+
+          // cos(2j omega_L t) and sin(2j omega_L t) by repeated rotations.
+          const double cos_2 = cos(2. * larmor_frequency * t[l]);
+          const double sin_2 = sin(2. * larmor_frequency * t[l]);
+          double cos_2j = 1., sin_2j = 0.;
+          for (size_t j = 1; j < n_terms; ++j) {
+            const double *cos_j = cos_2j_theta.data() + j * n_angles;
+            if (precession) {
+              const double cos_2j_minus_2 = cos_2j;
+              cos_2j = cos_2j_minus_2 * cos_2 - sin_2j * sin_2;
+              sin_2j = sin_2j * cos_2 + cos_2j_minus_2 * sin_2;
+              const double *sin_j = sin_2j_theta.data() + j * n_angles;
+              const double f_cos = f[j] * cos_2j, f_sin = f[j] * sin_2j;
+              for (size_t k = 0; k < n_angles; ++k) {
+                row[k] += f_cos * cos_j[k] + f_sin * sin_j[k];
+              }
+            } else {
+              for (size_t k = 0; k < n_angles; ++k) {
+                row[k] += f[j] * cos_j[k];
+              }
+            }
+          }
+        }
+      },
+      n_terms * (n_angles + factors.size()));
+}
+
+vector<double>
+PerturbedAngularCorrelation::get_perturbation_coefficients(
+    const double t) const {
+  vector<double> G(legendre_coefficients.size());
+  perturbation_coefficients(t, G.data());
+  return G;
+}
+
+vector<vector<double>>
+PerturbedAngularCorrelation::fourier_coefficients(const int nu_max) {
+  const size_t n_terms = static_cast<size_t>(nu_max / 2 + 1);
+
+  // u_k = (2k choose k) / 4^k
+  vector<double> u(2 * n_terms - 1, 1.);
+  for (size_t k = 1; k < u.size(); ++k) {
+    u[k] = u[k - 1] * (2. * k - 1.) / (2. * k);
+  }
+
+  vector<vector<double>> F(n_terms);
+  for (size_t i = 0; i < n_terms; ++i) {
+    F[i].resize(i + 1);
+    for (size_t j = 0; j <= i; ++j) {
+      F[i][j] = (j == 0 ? 1. : 2.) * u[i - j] * u[i + j];
+    }
+  }
+  return F;
+}
+
+void PerturbedAngularCorrelation::perturbation_coefficients(
+    const double t, double *G) const {
+  for (size_t i = 0; i < legendre_coefficients.size(); ++i) {
+    G[i] = 1.;
+    for (const PerturbationFactor &factor : factors) {
+      G[i] *= factor(i, t);
+    }
+  }
+}
+
+void PerturbedAngularCorrelation::time_functions(const double *G,
+                                                 double *f) const {
+  const size_t n_terms = legendre_coefficients.size();
+  for (size_t j = 0; j < n_terms; ++j) {
+    f[j] = 0.;
+    for (size_t i = j; i < n_terms; ++i) {
+      f[j] += legendre_coefficients[i] * G[i] * fourier[i][j];
+    }
+  }
+}
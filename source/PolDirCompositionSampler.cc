@@ -0,0 +1,95 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <gsl/gsl_math.h>
+
+#include "EulerAngleRotation.hh"
+#include "LegendreSeries.hh"
+#include "PolDirCompositionSampler.hh"
+
+PolDirCompositionSampler::PolDirCompositionSampler(const AngularCorrelation &w,
+                                                   const int seed)
+    : DirDirInverseTransformSampler(
+          W_dir_dir(w.get_initial_state(), w.get_cascade_steps()), seed) {
+
+  const vector<pair<Transition, State>> cascade_steps = w.get_cascade_steps();
+  if (cascade_steps[0].first.em_char == em_unknown) {
+    throw invalid_argument("Composition sampling is only implemented for "
+                           "polarization-direction correlations.");
+  }
+
+  const W_pol_dir w_pol_dir(w.get_initial_state(), cascade_steps);
+  const double c_0 = w_pol_dir.get_w_dir_dir().get_expansion_coefficients()[0];
+  const vector<double> expansion_coefficients =
+      w_pol_dir.get_expansion_coefficients();
+  for (auto coefficient : expansion_coefficients) {
+    coefficients_2.push_back(coefficient / c_0);
+  }
+
+  polarization_factor =
+      (cascade_steps[0].first.em_charp == magnetic ? -1. : 1.) *
+      w.get_polarization_degree();
+}
+
+pair<unsigned int, array<double, 3>> PolDirCompositionSampler::sample() {
+  const double x = inverse_cdf(uniform_random(random_engine));
+  const double phi = inverse_conditional_cdf(x, uniform_random(random_engine));
+
+  record(1, true);
+  return {1, euler_angle_transform::from_spherical(
+                 {acos(x), phi}, 2. * M_PI * uniform_random(random_engine))};
+}
+
+double PolDirCompositionSampler::anisotropy(const double x) const {
+  double a, b;
+  legendre_series::legendre(1, &x, coefficients.size(), coefficients.data(),
+                            &a);
+  legendre_series::associated_legendre_2(1, &x, coefficients_2.size(),
+                                         coefficients_2.data(), &b);
+
+  if (a <= 0.) {
+    return 0.;
+  }
+
+  return max(-1., min(1., polarization_factor * b / a));
+}
+
+double PolDirCompositionSampler::inverse_conditional_cdf(const double x,
+                                                         const double v) const {
+  const double r = anisotropy(x);
+
+  // The start value is the exact solution for r = 0.
+  return solve_monotonic(
+      [r](const double phi) {
+        return pair<double, double>{
+            0.5 * M_1_PI * (phi + 0.5 * r * sin(2. * phi)),
+            0.5 * M_1_PI * (1. + r * cos(2. * phi))};
+      },
+      v, 0., 2. * M_PI, 2. * M_PI * v);
+}
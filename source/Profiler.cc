@@ -0,0 +1,134 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cstdlib>
+
+using std::atexit;
+using std::getenv;
+
+#include <fstream>
+
+using std::ofstream;
+
+#include <iomanip>
+
+using std::left;
+using std::setw;
+
+#include <map>
+
+using std::map;
+
+#include <memory>
+
+using std::make_unique;
+using std::unique_ptr;
+
+#include <mutex>
+
+using std::lock_guard;
+using std::mutex;
+
+#include "Profiler.hh"
+
+namespace {
+
+struct Registry {
+  mutex registry_mutex;
+  map<string, unique_ptr<profiler::Counter>> counters;
+};
+
+void write_report_at_exit();
+
+/*
+    The registry is never destroyed, so that profiled code can still be called
+    during the destruction of static objects.
+*/
+Registry &registry() {
+  static Registry *reg = []() {
+    atexit(write_report_at_exit);
+    return new Registry();
+  }();
+  return *reg;
+}
+
+void write_report_at_exit() {
+  const char *file_name = getenv("ALPACA_PROFILE_REPORT");
+  if (file_name == nullptr || string(file_name).empty()) {
+    return;
+  }
+  const string name(file_name);
+  ofstream file(name);
+  if (name.size() >= 5 && name.compare(name.size() - 5, 5, ".json") == 0) {
+    profiler::report_json(file);
+  } else {
+    profiler::report_text(file);
+  }
+}
+
+} // namespace
+
+namespace profiler {
+
+Counter &counter(const string &name) {
+  Registry &reg = registry();
+  lock_guard<mutex> lock(reg.registry_mutex);
+  unique_ptr<Counter> &c = reg.counters[name];
+  if (c == nullptr) {
+    c = make_unique<Counter>();
+  }
+  return *c;
+}
+
+void reset() {
+  Registry &reg = registry();
+  lock_guard<mutex> lock(reg.registry_mutex);
+  for (auto &c : reg.counters) {
+    c.second->calls = 0;
+    c.second->nanoseconds = 0;
+  }
+}
+
+void report_text(ostream &stream) {
+  Registry &reg = registry();
+  lock_guard<mutex> lock(reg.registry_mutex);
+  stream << left << setw(48) << "# name" << setw(14) << "calls" << setw(14)
+         << "seconds"
+         << "microseconds/call\n";
+  for (auto &c : reg.counters) {
+    const uint64_t calls = c.second->calls;
+    const double seconds = 1e-9 * c.second->nanoseconds;
+    stream << setw(48) << c.first << setw(14) << calls << setw(14) << seconds
+           << (calls ? 1e6 * seconds / calls : 0.) << "\n";
+  }
+}
+
+void report_json(ostream &stream) {
+  Registry &reg = registry();
+  lock_guard<mutex> lock(reg.registry_mutex);
+  stream << "{";
+  for (auto c = reg.counters.begin(); c != reg.counters.end(); ++c) {
+    stream << (c == reg.counters.begin() ? "\n" : ",\n") << "  \"" << c->first
+           << "\": {\"calls\": " << c->second->calls
+           << ", \"seconds\": " << 1e-9 * c->second->nanoseconds << "}";
+  }
+  stream << "\n}\n";
+}
+
+} // namespace profiler
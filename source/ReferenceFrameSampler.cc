@@ -35,6 +35,66 @@ using std::vector;
 
 array<double, 3> ReferenceFrameSampler::operator()() { return sample().second; }
 
+void ReferenceFrameSampler::operator()(const size_t n, double *Phi,
+                                       double *Theta, double *Psi) {
+  for (size_t i = 0; i < n; ++i) {
+    const array<double, 3> Phi_Theta_Psi = sample().second;
+    Phi[i] = Phi_Theta_Psi[0];
+    Theta[i] = Phi_Theta_Psi[1];
+    Psi[i] = Phi_Theta_Psi[2];
+  }
+}
+
+pair<double, array<double, 3>> ReferenceFrameSampler::sample_weighted() {
+  return {1., operator()()};
+}
+
+void ReferenceFrameSampler::sample_weighted(const size_t n, double *Phi,
+                                            double *Theta, double *Psi,
+                                            double *weights) {
+  for (size_t i = 0; i < n; ++i) {
+    const pair<double, array<double, 3>> w_Phi_Theta_Psi = sample_weighted();
+    Phi[i] = w_Phi_Theta_Psi.second[0];
+    Theta[i] = w_Phi_Theta_Psi.second[1];
+    Psi[i] = w_Phi_Theta_Psi.second[2];
+    weights[i] = w_Phi_Theta_Psi.first;
+  }
+}
+
+pair<unsigned int, euler_angle_transform::RotationMatrix>
+ReferenceFrameSampler::sample_rotation_matrix() {
+  const pair<unsigned int, array<double, 3>> N_Phi_Theta_Psi = sample();
+  return {N_Phi_Theta_Psi.first,
+          euler_angle_transform::rotation_matrix(N_Phi_Theta_Psi.second)};
+}
+
+void ReferenceFrameSampler::sample_rotation_matrices(
+    const size_t n, euler_angle_transform::RotationMatrix *A) {
+  for (size_t i = 0; i < n; ++i) {
+    A[i] = sample_rotation_matrix().second;
+  }
+}
+
+pair<double, euler_angle_transform::RotationMatrix>
+ReferenceFrameSampler::sample_weighted_rotation_matrix() {
+  const pair<double, array<double, 3>> w_Phi_Theta_Psi = sample_weighted();
+  return {w_Phi_Theta_Psi.first,
+          euler_angle_transform::rotation_matrix(w_Phi_Theta_Psi.second)};
+}
+
+void ReferenceFrameSampler::sample_weighted_rotation_matrices(
+    const size_t n, euler_angle_transform::RotationMatrix *A,
+    double *weights) {
+  for (size_t i = 0; i < n; ++i) {
+    const pair<double, euler_angle_transform::RotationMatrix> w_A =
+        sample_weighted_rotation_matrix();
+    A[i] = w_A.second;
+    weights[i] = w_A.first;
+  }
+}
+
+void ReferenceFrameSampler::reseed([[maybe_unused]] seed_seq &seq) {}
+
 double ReferenceFrameSampler::estimate_efficiency(const unsigned int n_tries) {
   vector<unsigned int> required_tries(n_tries);
 
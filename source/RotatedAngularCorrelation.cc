@@ -0,0 +1,403 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::min;
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include "LegendreSeries.hh"
+#include "RotatedAngularCorrelation.hh"
+
+RotatedAngularCorrelation::RotatedAngularCorrelation(
+    const vector<double> &legendre_coefficients,
+    const vector<double> &associated_legendre_coefficients,
+    const array<double, 3> Phi_Theta_Psi)
+    : nu_max(2 * ((int)legendre_coefficients.size() - 1)),
+      Phi_Theta_Psi(Phi_Theta_Psi) {
+  if (legendre_coefficients.empty()) {
+    throw invalid_argument(
+        "At least one coefficient of the Legendre series is required.");
+  }
+  if (!associated_legendre_coefficients.empty() &&
+      associated_legendre_coefficients.size() + 1 !=
+          legendre_coefficients.size()) {
+    throw invalid_argument("The number of coefficients of the associated "
+                           "Legendre series must be one less than the number "
+                           "of coefficients of the Legendre series.");
+  }
+
+  const vector<vector<double>> D = wigner_D_matrices(
+      nu_max, euler_angle_transform::rotation_matrix(Phi_Theta_Psi));
+
+  coefficients.resize((nu_max + 1) * (nu_max + 1), 0.);
+  for (int l = 0; l <= nu_max; l += 2) {
+    // Coefficients in the coordinate system of the angular correlation.
+    vector<double> a(2 * l + 1, 0.);
+    a[l] = legendre_coefficients[l / 2];
+    if (l > 0 && !associated_legendre_coefficients.empty()) {
+      // 1/N_l^2 = sqrt[(l + 2)! / (l - 2)!]
+      a[l + 2] = associated_legendre_coefficients[l / 2 - 1] *
+                 sqrt((l + 2.) * (l + 1.) * l * (l - 1.) / 2.);
+    }
+    for (int m = -l; m <= l; ++m) {
+      double a_prime = 0.;
+      for (int n = -l; n <= l; ++n) {
+        a_prime += D[l][(m + l) * (2 * l + 1) + n + l] * a[n + l];
+      }
+      coefficients[l * l + l + m] = a_prime;
+    }
+  }
+
+  cos_coefficients.reserve((nu_max + 1) * (nu_max + 2) / 2);
+  sin_coefficients.reserve((nu_max + 1) * (nu_max + 2) / 2);
+  for (int m = 0; m <= nu_max; ++m) {
+    for (int l = m; l <= nu_max; ++l) {
+      // sqrt(2) N_l^m without the sign, which is absorbed into the polynomial.
+      double normalization = m == 0 ? 1. : sqrt(2.);
+      for (int k = l - m + 1; k <= l + m; ++k) {
+        normalization /= sqrt((double)k);
+      }
+      cos_coefficients.push_back(normalization *
+                                 coefficients[l * l + l + m]);
+      sin_coefficients.push_back(m == 0 ? 0.
+                                        : normalization *
+                                              coefficients[l * l + l - m]);
+    }
+  }
+}
+
+double RotatedAngularCorrelation::operator()(const double theta,
+                                             const double phi) const {
+  double result;
+  evaluate(1, &theta, &phi, &result);
+  return result;
+}
+
+void RotatedAngularCorrelation::evaluate(const size_t n, const double *theta,
+                                         const double *phi,
+                                         double *result) const {
+  double x[legendre_series::block_size], y[legendre_series::block_size],
+      z[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+
+    for (size_t k = 0; k < m; ++k) {
+      const double sin_theta = sin(theta[start + k]);
+      x[k] = sin_theta * cos(phi[start + k]);
+      y[k] = sin_theta * sin(phi[start + k]);
+      z[k] = cos(theta[start + k]);
+    }
+
+    evaluate_block(m, x, y, z, result + start);
+  }
+}
+
+double
+RotatedAngularCorrelation::evaluate(const array<double, 3> &direction) const {
+  double result;
+  evaluate_block(1, &direction[0], &direction[1], &direction[2], &result);
+  return result;
+}
+
+void RotatedAngularCorrelation::evaluate(const size_t n, const double *xyz,
+                                         double *result) const {
+  double x[legendre_series::block_size], y[legendre_series::block_size],
+      z[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+    const double *r = xyz + 3 * start;
+
+    for (size_t k = 0; k < m; ++k) {
+      x[k] = r[3 * k];
+      y[k] = r[3 * k + 1];
+      z[k] = r[3 * k + 2];
+    }
+
+    evaluate_block(m, x, y, z, result + start);
+  }
+}
+
+void RotatedAngularCorrelation::evaluate_grid(const size_t n_theta,
+                                              const double *theta,
+                                              const size_t n_phi,
+                                              const double *phi,
+                                              double *result) const {
+  const size_t n_m = nu_max + 1;
+
+  // C_m(theta_i) and S_m(theta_i) at the index i * n_m + m. The recurrence is
+  // the same as in evaluate_block(), with sin^m(theta) instead of the real
+  // and imaginary part of (x + iy)^m.
+  vector<double> c_theta(n_theta * n_m), s_theta(n_theta * n_m);
+  for (size_t i = 0; i < n_theta; ++i) {
+    const double z = cos(theta[i]), sin_theta = sin(theta[i]);
+    double double_factorial = 1., sin_m = 1.;
+    size_t index = 0;
+
+    for (int m = 0; m <= nu_max; ++m) {
+      if (m > 0) {
+        double_factorial *= 2 * m - 1;
+        sin_m *= sin_theta;
+      }
+
+      double p_l_minus_1 = 0., p_l = double_factorial, c = 0., s = 0.;
+      for (int l = m; l <= nu_max; ++l, ++index) {
+        if (l > m) {
+          const double p_l_plus_1 =
+              ((2. * l - 1.) * z * p_l - (l + m - 1.) * p_l_minus_1) / (l - m);
+          p_l_minus_1 = p_l;
+          p_l = p_l_plus_1;
+        }
+        if (l % 2 == 0) {
+          c += cos_coefficients[index] * p_l;
+          s += sin_coefficients[index] * p_l;
+        }
+      }
+      c_theta[i * n_m + m] = sin_m * c;
+      s_theta[i * n_m + m] = sin_m * s;
+    }
+  }
+
+  // cos(m phi_j) and sin(m phi_j) at the index m * n_phi + j, from the powers
+  // of exp(i phi_j).
+  vector<double> cos_phi(n_m * n_phi), sin_phi(n_m * n_phi);
+  for (size_t j = 0; j < n_phi; ++j) {
+    cos_phi[j] = 1.;
+    sin_phi[j] = 0.;
+  }
+  if (nu_max > 0) {
+    for (size_t j = 0; j < n_phi; ++j) {
+      cos_phi[n_phi + j] = cos(phi[j]);
+      sin_phi[n_phi + j] = sin(phi[j]);
+    }
+  }
+  for (size_t m = 2; m < n_m; ++m) {
+    const double *c_1 = cos_phi.data() + n_phi, *s_1 = sin_phi.data() + n_phi;
+    const double *c_m_minus_1 = cos_phi.data() + (m - 1) * n_phi,
+                 *s_m_minus_1 = sin_phi.data() + (m - 1) * n_phi;
+    double *c_m = cos_phi.data() + m * n_phi, *s_m = sin_phi.data() + m * n_phi;
+    for (size_t j = 0; j < n_phi; ++j) {
+      c_m[j] = c_m_minus_1[j] * c_1[j] - s_m_minus_1[j] * s_1[j];
+      s_m[j] = s_m_minus_1[j] * c_1[j] + c_m_minus_1[j] * s_1[j];
+    }
+  }
+
+  for (size_t i = 0; i < n_theta; ++i) {
+    double *row = result + i * n_phi;
+    const double c_0 = c_theta[i * n_m];
+    for (size_t j = 0; j < n_phi; ++j) {
+      row[j] = c_0;
+    }
+    for (size_t m = 1; m < n_m; ++m) {
+      const double c = c_theta[i * n_m + m], s = s_theta[i * n_m + m];
+      const double *c_m = cos_phi.data() + m * n_phi,
+                   *s_m = sin_phi.data() + m * n_phi;
+      for (size_t j = 0; j < n_phi; ++j) {
+        row[j] += c * c_m[j] + s * s_m[j];
+      }
+    }
+  }
+}
+
+void RotatedAngularCorrelation::evaluate_block(const size_t n, const double *x,
+                                               const double *y,
+                                               const double *z,
+                                               double *result) const {
+  constexpr size_t block_size = legendre_series::block_size;
+
+  // Real and imaginary part of (x + iy)^m.
+  double re[block_size], im[block_size];
+  // P_l^m(z) / sin^m(theta) without the Condon-Shortley phase for the current
+  // and the previous l.
+  double p_l[block_size], p_l_minus_1[block_size];
+
+  for (size_t k = 0; k < n; ++k) {
+    result[k] = 0.;
+    re[k] = 1.;
+    im[k] = 0.;
+  }
+
+  // (2m - 1)!!, which is P_m^m(z) / sin^m(theta).
+  double double_factorial = 1.;
+  size_t index = 0;
+
+  for (int m = 0; m <= nu_max; ++m) {
+    if (m > 0) {
+      double_factorial *= 2 * m - 1;
+      for (size_t k = 0; k < n; ++k) {
+        const double re_k = re[k];
+        re[k] = re_k * x[k] - im[k] * y[k];
+        im[k] = re_k * y[k] + im[k] * x[k];
+      }
+    }
+
+    for (size_t k = 0; k < n; ++k) {
+      p_l_minus_1[k] = 0.;
+      p_l[k] = double_factorial;
+    }
+
+    for (int l = m; l <= nu_max; ++l, ++index) {
+      if (l > m) {
+        const double a = (2. * l - 1.) / (l - m), b = (l + m - 1.) / (l - m);
+        for (size_t k = 0; k < n; ++k) {
+          const double p_l_plus_1 = a * z[k] * p_l[k] - b * p_l_minus_1[k];
+          p_l_minus_1[k] = p_l[k];
+          p_l[k] = p_l_plus_1;
+        }
+      }
+      // Only terms of even order are nonzero.
+      if (l % 2 == 0) {
+        const double c = cos_coefficients[index], s = sin_coefficients[index];
+        for (size_t k = 0; k < n; ++k) {
+          result[k] += p_l[k] * (c * re[k] + s * im[k]);
+        }
+      }
+    }
+  }
+}
+
+double RotatedAngularCorrelation::get_coefficient(const int l,
+                                                  const int m) const {
+  if (l < 0 || m < -l || m > l) {
+    throw invalid_argument("Invalid indices of a spherical harmonic.");
+  }
+  return l > nu_max ? 0. : coefficients[l * l + l + m];
+}
+
+namespace {
+
+/**
+ * \brief Recursion of Ivanic and Ruedenberg for the Wigner D-matrices of real
+ * spherical harmonics.
+ *
+ * Uses the matrix \f$D^1\f$ and the matrix \f$D^{l-1}\f$ of the previous
+ * order to calculate \f$D^l\f$ [Eqs. (8.1) - (8.5) and Table 2 in
+ * \cite IvanicRuedenberg1996, with the corrections of the erratum].
+ */
+class IvanicRuedenbergRecursion {
+public:
+  IvanicRuedenbergRecursion(const vector<double> &D_1,
+                            const vector<double> &D_l_minus_1, const int l)
+      : D_1(D_1), D_l_minus_1(D_l_minus_1), l(l) {}
+
+  double operator()(const int m, const int n) const {
+    const double delta_m0 = m == 0 ? 1. : 0.;
+    const double denominator =
+        abs(n) == l ? 2. * l * (2. * l - 1.) : (l + n) * (l - n);
+    const int abs_m = abs(m);
+
+    double result = 0.;
+
+    // The coefficient u vanishes for |m| = l, w for m = 0 and |m| >= l - 1.
+    if (abs_m < l) {
+      result += sqrt((l + m) * (l - m) / denominator) * P(0, m, n);
+    }
+
+    const double v = 0.5 *
+                     sqrt((1. + delta_m0) * (l + abs_m - 1.) * (l + abs_m) /
+                          denominator) *
+                     (1. - 2. * delta_m0);
+    if (m == 0) {
+      result += v * (P(1, 1, n) + P(-1, -1, n));
+    } else if (m > 0) {
+      const double delta_m1 = m == 1 ? 1. : 0.;
+      result += v * (P(1, m - 1, n) * sqrt(1. + delta_m1) -
+                     P(-1, -m + 1, n) * (1. - delta_m1));
+    } else {
+      const double delta_m1 = m == -1 ? 1. : 0.;
+      result += v * (P(1, m + 1, n) * (1. - delta_m1) +
+                     P(-1, -m - 1, n) * sqrt(1. + delta_m1));
+    }
+
+    if (m != 0 && abs_m < l - 1) {
+      const double w =
+          -0.5 * sqrt((l - abs_m - 1.) * (l - abs_m) / denominator);
+      if (m > 0) {
+        result += w * (P(1, m + 1, n) + P(-1, -m - 1, n));
+      } else {
+        result += w * (P(1, m - 1, n) - P(-1, -m + 1, n));
+      }
+    }
+
+    return result;
+  }
+
+protected:
+  double R(const int i, const int j) const {
+    return D_1[(i + 1) * 3 + j + 1];
+  }
+
+  double M(const int a, const int b) const {
+    return D_l_minus_1[(a + l - 1) * (2 * l - 1) + b + l - 1];
+  }
+
+  double P(const int i, const int a, const int b) const {
+    if (b == l) {
+      return R(i, 1) * M(a, l - 1) - R(i, -1) * M(a, -l + 1);
+    }
+    if (b == -l) {
+      return R(i, 1) * M(a, -l + 1) + R(i, -1) * M(a, l - 1);
+    }
+    return R(i, 0) * M(a, b);
+  }
+
+  const vector<double> &D_1;
+  const vector<double> &D_l_minus_1;
+  const int l;
+};
+
+} // namespace
+
+vector<vector<double>> RotatedAngularCorrelation::wigner_D_matrices(
+    const int l_max, const euler_angle_transform::RotationMatrix &A) {
+  vector<vector<double>> D(l_max + 1);
+  D[0] = {1.};
+  if (l_max == 0) {
+    return D;
+  }
+
+  // The real spherical harmonics of order 1 are proportional to y, z, and x
+  // for m = -1, 0, and 1.
+  constexpr array<size_t, 3> coordinate{1, 2, 0};
+  D[1].resize(9);
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      D[1][i * 3 + j] = A[coordinate[i]][coordinate[j]];
+    }
+  }
+
+  for (int l = 2; l <= l_max; ++l) {
+    const IvanicRuedenbergRecursion recursion(D[1], D[l - 1], l);
+    D[l].resize((2 * l + 1) * (2 * l + 1));
+    for (int m = -l; m <= l; ++m) {
+      for (int n = -l; n <= l; ++n) {
+        D[l][(m + l) * (2 * l + 1) + n + l] = recursion(m, n);
+      }
+    }
+  }
+
+  return D;
+}
@@ -0,0 +1,97 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+
+#include <gsl/gsl_math.h>
+
+#include "SphereAliasSampler.hh"
+
+SphereAliasSampler::SphereAliasSampler(
+    function<double(const double, const double)> dis, const size_t n_cos_the,
+    const size_t n_ph, const int seed)
+    : n_cos_theta(n_cos_the), n_phi(n_ph),
+      cells(tabulate(dis, n_cos_the, n_ph)), random_engine(seed) {}
+
+vector<double> SphereAliasSampler::tabulate(
+    const function<double(const double, const double)> &dis,
+    const size_t n_cos_theta, const size_t n_phi) {
+  if (n_cos_theta == 0 || n_phi == 0) {
+    throw invalid_argument("Numbers of cells must be positive.");
+  }
+
+  vector<double> weights(n_cos_theta * n_phi);
+  for (size_t i = 0; i < n_cos_theta; ++i) {
+    const double theta = acos(-1. + (2. * i + 1.) / n_cos_theta);
+    for (size_t j = 0; j < n_phi; ++j) {
+      weights[i * n_phi + j] = dis(theta, M_PI * (2. * j + 1.) / n_phi);
+    }
+  }
+
+  return weights;
+}
+
+array<double, 3> SphereAliasSampler::sample_cos_theta_phi_Phi() {
+  const size_t cell = cells(uniform_random(random_engine));
+  const size_t i = cell / n_phi, j = cell % n_phi;
+
+  const double cos_theta =
+      -1. + 2. * (i + uniform_random(random_engine)) / n_cos_theta;
+  const double phi = 2. * M_PI * (j + uniform_random(random_engine)) / n_phi;
+
+  return {cos_theta < -1. ? -1. : (cos_theta > 1. ? 1. : cos_theta), phi,
+          2. * M_PI * uniform_random(random_engine)};
+}
+
+pair<unsigned int, array<double, 3>> SphereAliasSampler::sample() {
+  const array<double, 3> cos_theta_phi_Phi = sample_cos_theta_phi_Phi();
+
+  record(1, true);
+  return {1, euler_angle_transform::from_spherical(
+                 {acos(cos_theta_phi_Phi[0]), cos_theta_phi_Phi[1]},
+                 cos_theta_phi_Phi[2])};
+}
+
+pair<unsigned int, euler_angle_transform::RotationMatrix>
+SphereAliasSampler::sample_rotation_matrix() {
+  const array<double, 3> cos_theta_phi_Phi = sample_cos_theta_phi_Phi();
+
+  record(1, true);
+  return {1, euler_angle_transform::rotation_matrix_from_spherical(
+                 cos_theta_phi_Phi[0], cos_theta_phi_Phi[1],
+                 cos_theta_phi_Phi[2])};
+}
+
+void SphereAliasSampler::reseed(seed_seq &seq) {
+  random_engine.seed(seq);
+  uniform_random.reset();
+}
+
+double SphereAliasSampler::get_cell_probability(const size_t i,
+                                                const size_t j) const {
+  if (i >= n_cos_theta || j >= n_phi) {
+    throw out_of_range("Cell does not exist.");
+  }
+  return cells.get_probability(i * n_phi + j);
+}
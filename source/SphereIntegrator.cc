@@ -17,30 +17,201 @@
     Copyright (C) 2021-2023 Udo Friman-Gayer
 */
 
-#include <array>
+#include <cmath>
+#include <random>
+#include <stdexcept>
 #include <vector>
 
 #include <gsl/gsl_math.h>
 
+#include "QuasiRandomSequence.hh"
 #include "SphereIntegrator.hh"
 
-using std::array;
+using std::invalid_argument;
+using std::seed_seq;
 using std::vector;
 
-double SphereIntegrator::operator()(double f(double theta, double phi),
-                                    const unsigned int n,
-                                    bool is_in_omega(double theta,
-                                                     double phi)) {
+double SphereIntegrator::operator()(
+    function<double(const double, const double)> f, const unsigned int n,
+    function<bool(const double, const double)> is_in_omega) {
 
-  array<vector<double>, 2> theta_phi = sph_poi_samp.sample(n);
+  const SpherePointCache::PointSetView points = SpherePointCache::get_view(n);
 
   double integral = 0.;
 
   for (size_t i = 0; i < (size_t)n; ++i) {
-    if (is_in_omega(theta_phi[0][i], theta_phi[1][i])) {
-      integral += f(theta_phi[0][i], theta_phi[1][i]);
+    if (is_in_omega(points.theta[i], points.phi[i])) {
+      integral += f(points.theta[i], points.phi[i]);
     }
   }
 
   return 4. * M_PI / (double)n * integral;
-}
\ No newline at end of file
+}
+
+vector<double> SphereIntegrator::operator()(
+    const vector<function<double(const double, const double)>> &f,
+    const unsigned int n,
+    function<bool(const double, const double)> is_in_omega) {
+
+  const SpherePointCache::PointSetView points = SpherePointCache::get_view(n);
+
+  vector<double> integrals(f.size(), 0.);
+
+  for (size_t i = 0; i < (size_t)n; ++i) {
+    if (is_in_omega(points.theta[i], points.phi[i])) {
+      for (size_t j = 0; j < f.size(); ++j) {
+        integrals[j] += f[j](points.theta[i], points.phi[i]);
+      }
+    }
+  }
+
+  for (auto &integral : integrals) {
+    integral *= 4. * M_PI / (double)n;
+  }
+
+  return integrals;
+}
+
+double SphereIntegrator::operator()(
+    function<double(const double, const double)> f, const unsigned int n,
+    const SphereRegion &region) {
+  return operator()(vector<function<double(const double, const double)>>{f},
+                    n, region)[0];
+}
+
+vector<double> SphereIntegrator::operator()(
+    const vector<function<double(const double, const double)>> &f,
+    const unsigned int n, const SphereRegion &region) {
+
+  vector<double> theta, phi, weight;
+  region.sample(n, theta, phi, weight);
+
+  vector<double> integrals(f.size(), 0.);
+
+  for (size_t i = 0; i < theta.size(); ++i) {
+    for (size_t j = 0; j < f.size(); ++j) {
+      integrals[j] += weight[i] * f[j](theta[i], phi[i]);
+    }
+  }
+
+  return integrals;
+}
+
+vector<double> SphereIntegrator::integrate_batch(
+    const vector<BatchIntegrand> &f, const unsigned int n,
+    function<bool(const double, const double)> is_in_omega) {
+
+  const SpherePointCache::PointSetView points = SpherePointCache::get_view(n);
+
+  vector<double> theta_in_omega, phi_in_omega;
+  theta_in_omega.reserve(n);
+  phi_in_omega.reserve(n);
+  for (size_t i = 0; i < (size_t)n; ++i) {
+    if (is_in_omega(points.theta[i], points.phi[i])) {
+      theta_in_omega.push_back(points.theta[i]);
+      phi_in_omega.push_back(points.phi[i]);
+    }
+  }
+
+  vector<double> values(theta_in_omega.size());
+  vector<double> integrals(f.size(), 0.);
+
+  for (size_t j = 0; j < f.size(); ++j) {
+    f[j](values.size(), theta_in_omega.data(), phi_in_omega.data(),
+         values.data());
+    for (auto v : values) {
+      integrals[j] += v;
+    }
+    integrals[j] *= 4. * M_PI / (double)n;
+  }
+
+  return integrals;
+}
+
+vector<double>
+SphereIntegrator::integrate_batch(const vector<BatchIntegrand> &f,
+                                  const unsigned int n,
+                                  const SphereRegion &region) {
+
+  vector<double> theta, phi, weight;
+  region.sample(n, theta, phi, weight);
+
+  vector<double> values(theta.size());
+  vector<double> integrals(f.size(), 0.);
+
+  for (size_t j = 0; j < f.size(); ++j) {
+    f[j](values.size(), theta.data(), phi.data(), values.data());
+    for (size_t i = 0; i < values.size(); ++i) {
+      integrals[j] += weight[i] * values[i];
+    }
+  }
+
+  return integrals;
+}
+
+vector<IntegralEstimate> SphereIntegrator::integrate_qmc(
+    const vector<BatchIntegrand> &f, const unsigned int n,
+    function<bool(const double, const double)> is_in_omega,
+    const unsigned int n_replicates, const uint64_t seed) {
+
+  if (n_replicates < 2) {
+    throw invalid_argument("At least two replicates are required.");
+  }
+
+  ScrambledSobolSequence sequence(2);
+  vector<double> u(2 * (size_t)n);
+  vector<double> theta_in_omega, phi_in_omega;
+  theta_in_omega.reserve(n);
+  phi_in_omega.reserve(n);
+  vector<double> values;
+
+  // Estimates of all integrals for each replicate.
+  vector<double> replicates(n_replicates * f.size());
+
+  for (unsigned int r = 0; r < n_replicates; ++r) {
+    seed_seq seq{static_cast<unsigned int>(seed & 0xffffffffULL),
+                 static_cast<unsigned int>(seed >> 32), r};
+    sequence.seed(seq);
+    sequence.generate(n, u.data());
+
+    theta_in_omega.clear();
+    phi_in_omega.clear();
+    for (size_t i = 0; i < (size_t)n; ++i) {
+      const double theta = acos(2. * u[2 * i] - 1.);
+      const double phi = 2. * M_PI * u[2 * i + 1];
+      if (is_in_omega(theta, phi)) {
+        theta_in_omega.push_back(theta);
+        phi_in_omega.push_back(phi);
+      }
+    }
+
+    values.resize(theta_in_omega.size());
+    for (size_t j = 0; j < f.size(); ++j) {
+      f[j](values.size(), theta_in_omega.data(), phi_in_omega.data(),
+           values.data());
+      double integral = 0.;
+      for (auto v : values) {
+        integral += v;
+      }
+      replicates[r * f.size() + j] = 4. * M_PI / (double)n * integral;
+    }
+  }
+
+  vector<IntegralEstimate> estimates(f.size());
+  for (size_t j = 0; j < f.size(); ++j) {
+    double mean = 0.;
+    for (unsigned int r = 0; r < n_replicates; ++r) {
+      mean += replicates[r * f.size() + j];
+    }
+    mean /= n_replicates;
+    double variance = 0.;
+    for (unsigned int r = 0; r < n_replicates; ++r) {
+      const double residual = replicates[r * f.size() + j] - mean;
+      variance += residual * residual;
+    }
+    variance /= n_replicates - 1;
+    estimates[j] = {mean, sqrt(variance / n_replicates)};
+  }
+
+  return estimates;
+}
@@ -0,0 +1,385 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::copy;
+using std::equal;
+
+#include <atomic>
+
+using std::atomic;
+
+#include <cstdint>
+
+using std::uint32_t;
+using std::uint64_t;
+
+#include <cstdio>
+
+using std::remove;
+using std::rename;
+
+#include <fstream>
+
+using std::ofstream;
+
+#include <map>
+
+using std::map;
+
+#include <memory>
+
+using std::make_shared;
+
+#include <mutex>
+
+using std::lock_guard;
+using std::mutex;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <string>
+
+using std::to_string;
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SpherePointCache.hh"
+#include "SpherePointSampler.hh"
+
+namespace {
+
+typedef shared_ptr<const array<vector<double>, 2>> PointSet;
+
+// Identifies files written by SpherePointCache::save().
+const char file_signature[8] = {'a', 'l', 'p', 'a', 'c', 'a', 'S', 'P'};
+const uint32_t file_version = 2;
+
+/*
+    The angles of a point set follow a record header and are aligned to 8
+    bytes, so that a mapped file can be read in place.
+*/
+struct FileHeader {
+  char signature[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t n_point_sets;
+};
+
+struct RecordHeader {
+  uint32_t n;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 24, "Unexpected size of the header.");
+static_assert(sizeof(RecordHeader) == 8,
+              "Unexpected size of a record header.");
+
+/*
+    File written by SpherePointCache::save() that is mapped into memory. The
+    mapping is released with the object.
+*/
+struct MappedPointSets {
+  MappedPointSets(const char *data, const size_t size)
+      : data(data), size(size) {}
+  ~MappedPointSets() { munmap((void *)data, size); }
+
+  MappedPointSets(const MappedPointSets &) = delete;
+  MappedPointSets &operator=(const MappedPointSets &) = delete;
+
+  const char *data;
+  size_t size;
+  // Polar angles of each point set. The azimuthal angles follow them.
+  map<unsigned int, const double *> theta;
+};
+
+/*
+    Map a file and check the bounds of all point sets before any angles are
+    read.
+*/
+shared_ptr<const MappedPointSets> map_point_sets(const string &file_name) {
+  const int file_descriptor = open(file_name.c_str(), O_RDONLY);
+  if (file_descriptor == -1) {
+    throw invalid_argument("Unable to open file '" + file_name +
+                           "' for reading.");
+  }
+
+  struct stat file_status;
+  if (fstat(file_descriptor, &file_status) == -1 ||
+      (size_t)file_status.st_size < sizeof(FileHeader)) {
+    close(file_descriptor);
+    throw invalid_argument("File '" + file_name +
+                           "' does not contain a valid point-set cache.");
+  }
+  const size_t size = file_status.st_size;
+
+  void *mapping =
+      mmap(nullptr, size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+  // The mapping stays valid after the file has been closed.
+  close(file_descriptor);
+  if (mapping == MAP_FAILED) {
+    throw invalid_argument("Unable to map file '" + file_name + "'.");
+  }
+  const shared_ptr<MappedPointSets> mapped =
+      make_shared<MappedPointSets>((const char *)mapping, size);
+
+  const FileHeader *header = (const FileHeader *)mapped->data;
+  if (!equal(header->signature,
+             header->signature + sizeof(header->signature),
+             file_signature) ||
+      header->version != file_version) {
+    throw invalid_argument("File '" + file_name +
+                           "' does not contain a valid point-set cache.");
+  }
+
+  uint64_t offset = sizeof(FileHeader);
+  for (uint64_t i = 0; i < header->n_point_sets; ++i) {
+    if (size - offset < sizeof(RecordHeader)) {
+      throw invalid_argument("File '" + file_name + "' is truncated.");
+    }
+    const uint32_t n = ((const RecordHeader *)(mapped->data + offset))->n;
+    offset += sizeof(RecordHeader);
+    if ((size - offset) / (2 * sizeof(double)) < n) {
+      throw invalid_argument("File '" + file_name + "' is truncated.");
+    }
+    mapped->theta.emplace(n, (const double *)(mapped->data + offset));
+    offset += 2 * (uint64_t)n * sizeof(double);
+  }
+
+  return mapped;
+}
+
+/*
+    Function-local statics avoid problems with the initialization order of
+    static objects in different translation units.
+*/
+struct PointSetTable {
+  mutex table_mutex;
+  map<unsigned int, PointSet> table;
+  shared_ptr<const MappedPointSets> mapped;
+  size_t hits = 0;
+  size_t misses = 0;
+};
+
+PointSetTable &point_sets() {
+  static PointSetTable point_set_table;
+  return point_set_table;
+}
+
+} // namespace
+
+PointSet SpherePointCache::get(const unsigned int n) {
+  PointSetTable &tab = point_sets();
+  {
+    lock_guard<mutex> lock(tab.table_mutex);
+    const auto entry = tab.table.find(n);
+    if (entry != tab.table.end()) {
+      ++tab.hits;
+      return entry->second;
+    }
+    // A point set in the attached file is copied instead of calculated.
+    if (tab.mapped) {
+      const auto mapped_entry = tab.mapped->theta.find(n);
+      if (mapped_entry != tab.mapped->theta.end()) {
+        ++tab.hits;
+        const double *theta = mapped_entry->second;
+        return tab.table
+            .emplace(n, make_shared<const array<vector<double>, 2>>(
+                            array<vector<double>, 2>{
+                                vector<double>(theta, theta + n),
+                                vector<double>(theta + n, theta + 2 * n)}))
+            .first->second;
+      }
+    }
+    ++tab.misses;
+  }
+
+  // The calculation does not modify shared data, so the lock can be released.
+  PointSet point_set = make_shared<const array<vector<double>, 2>>(
+      SpherePointSampler().sample(n));
+
+  lock_guard<mutex> lock(tab.table_mutex);
+  // If another thread has calculated the same point set in the meantime, its
+  // result is kept.
+  return tab.table.emplace(n, point_set).first->second;
+}
+
+SpherePointCache::PointSetView
+SpherePointCache::get_view(const unsigned int n) {
+  PointSetTable &tab = point_sets();
+  {
+    lock_guard<mutex> lock(tab.table_mutex);
+    if (tab.mapped) {
+      const auto entry = tab.mapped->theta.find(n);
+      if (entry != tab.mapped->theta.end()) {
+        ++tab.hits;
+        return {entry->second, entry->second + n, n, tab.mapped};
+      }
+    }
+  }
+
+  const PointSet point_set = get(n);
+  return {(*point_set)[0].data(), (*point_set)[1].data(), n, point_set};
+}
+
+size_t SpherePointCache::get_hits() {
+  lock_guard<mutex> lock(point_sets().table_mutex);
+  return point_sets().hits;
+}
+
+size_t SpherePointCache::get_misses() {
+  lock_guard<mutex> lock(point_sets().table_mutex);
+  return point_sets().misses;
+}
+
+size_t SpherePointCache::size() {
+  lock_guard<mutex> lock(point_sets().table_mutex);
+  return point_sets().table.size();
+}
+
+void SpherePointCache::clear() {
+  lock_guard<mutex> lock(point_sets().table_mutex);
+  point_sets().table.clear();
+  point_sets().mapped.reset();
+  point_sets().hits = 0;
+  point_sets().misses = 0;
+}
+
+void SpherePointCache::save(const string &file_name) {
+  // The name of the temporary file is unique for each call, even if several
+  // threads of the same process save the cache at the same time.
+  static atomic<unsigned long> n_temporary_files{0};
+  const string temporary_file_name = file_name + ".tmp" +
+                                     to_string(getpid()) + "_" +
+                                     to_string(n_temporary_files++);
+
+  ofstream file(temporary_file_name, std::ios::binary);
+  if (!file) {
+    throw invalid_argument("Unable to open file '" + file_name +
+                           "' for writing.");
+  }
+
+  {
+    lock_guard<mutex> lock(point_sets().table_mutex);
+    FileHeader header{{}, file_version, 0, point_sets().table.size()};
+    copy(file_signature, file_signature + sizeof(file_signature),
+              header.signature);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    for (const auto &entry : point_sets().table) {
+      const RecordHeader record{entry.first, 0};
+      file.write(reinterpret_cast<const char *>(&record), sizeof(record));
+      for (const auto &angles : *entry.second) {
+        file.write(reinterpret_cast<const char *>(angles.data()),
+                   record.n * sizeof(double));
+      }
+    }
+  }
+
+  file.close();
+  if (!file) {
+    remove(temporary_file_name.c_str());
+    throw invalid_argument("Error while writing file '" + file_name + "'.");
+  }
+  // Processes which have attached a previous version of the file keep it
+  // until they detach it.
+  if (rename(temporary_file_name.c_str(), file_name.c_str()) != 0) {
+    remove(temporary_file_name.c_str());
+    throw invalid_argument("Error while writing file '" + file_name + "'.");
+  }
+}
+
+void SpherePointCache::load(const string &file_name) {
+  // The entire file is checked before the cache is modified, so that an
+  // invalid file leaves the cache unchanged.
+  const shared_ptr<const MappedPointSets> mapped = map_point_sets(file_name);
+
+  map<unsigned int, PointSet> loaded;
+  for (const auto &entry : mapped->theta) {
+    const unsigned int n = entry.first;
+    const double *theta = entry.second;
+    loaded.emplace(n, make_shared<const array<vector<double>, 2>>(
+                          array<vector<double>, 2>{
+                              vector<double>(theta, theta + n),
+                              vector<double>(theta + n, theta + 2 * n)}));
+  }
+
+  lock_guard<mutex> lock(point_sets().table_mutex);
+  point_sets().table.insert(loaded.begin(), loaded.end());
+}
+
+void SpherePointCache::attach(const string &file_name) {
+  const shared_ptr<const MappedPointSets> mapped = map_point_sets(file_name);
+
+  lock_guard<mutex> lock(point_sets().table_mutex);
+  point_sets().mapped = mapped;
+}
+
+void SpherePointCache::attach(const string &file_name,
+                              const vector<unsigned int> &n) {
+  if (access(file_name.c_str(), F_OK) != 0) {
+    const string lock_file_name = file_name + ".lock";
+    const int lock_descriptor =
+        open(lock_file_name.c_str(), O_RDWR | O_CREAT, 0666);
+    if (lock_descriptor == -1) {
+      throw invalid_argument("Unable to open lock file '" + lock_file_name +
+                             "'.");
+    }
+    if (flock(lock_descriptor, LOCK_EX) == -1) {
+      close(lock_descriptor);
+      throw invalid_argument("Unable to lock file '" + lock_file_name +
+                             "'.");
+    }
+
+    // Another process may have written the file while this one was waiting
+    // for the lock.
+    try {
+      if (access(file_name.c_str(), F_OK) != 0) {
+        for (const auto n_points : n) {
+          get(n_points);
+        }
+        save(file_name);
+      }
+    } catch (...) {
+      close(lock_descriptor);
+      throw;
+    }
+    // Closing the file releases the lock.
+    close(lock_descriptor);
+  }
+
+  attach(file_name);
+}
+
+void SpherePointCache::detach() {
+  lock_guard<mutex> lock(point_sets().table_mutex);
+  point_sets().mapped.reset();
+}
+
+size_t SpherePointCache::get_n_attached() {
+  lock_guard<mutex> lock(point_sets().table_mutex);
+  return point_sets().mapped ? point_sets().mapped->theta.size() : 0;
+}
@@ -17,29 +17,86 @@
     Copyright (C) 2021-2023 Udo Friman-Gayer
 */
 
+#include <algorithm>
 #include <cmath>
+#include <exception>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 
-#include <gsl/gsl_sf_ellint.h>
-#include <gsl/gsl_sf_elljac.h>
+#include <gsl/gsl_math.h>
 
 #include "SpherePointSampler.hh"
 
+using std::current_exception;
+using std::exception_ptr;
 using std::invalid_argument;
+using std::max;
+using std::min;
+using std::rethrow_exception;
 using std::runtime_error;
 using std::stringstream;
+using std::thread;
 
 array<vector<double>, 2>
-SpherePointSampler::sample(const unsigned int n) const {
+SpherePointSampler::sample(const unsigned int n,
+                           const unsigned int n_threads) const {
   array<vector<double>, 2> theta_phi = {vector<double>(n, 0.),
                                         vector<double>(n, 0.)};
 
   const double c = find_c(n);
+  const double complete_elliptic_integral_2nd =
+      elliptic_integral_2nd_kind_arbitrary_m(M_PI_2, -c * c);
+  const double epsilon_segment =
+      default_epsilon_Theta_j * 2. * complete_elliptic_integral_2nd / n;
+
+  // Each thread processes a contiguous range of segments, so that the
+  // solutions can be warm-started from the previous segment.
+  const unsigned int n_thr = min(
+      n, n_threads > 0 ? n_threads : max(1u, thread::hardware_concurrency()));
+  vector<exception_ptr> errors(n_thr);
+
+  auto work = [&](const unsigned int t) {
+    try {
+      const unsigned int j_first = 1 + (unsigned long long)n * t / n_thr;
+      const unsigned int j_last = (unsigned long long)n * (t + 1) / n_thr;
+
+      double Theta_j = acos(1. - (2. * j_first - 1.) / (double)n);
+      for (unsigned int j = j_first; j <= j_last; ++j) {
+        if (j > j_first) {
+          // Since the segment lengths of the mid points of neighboring
+          // segments differ by 2 pi / c, a single Newton step from the
+          // previous solution is a very good initial guess.
+          const double sine_Theta_j = sin(Theta_j);
+          Theta_j =
+              min(M_PI, Theta_j + 2. * M_PI /
+                                      (c * sqrt(1. + c * c * sine_Theta_j *
+                                                         sine_Theta_j)));
+        }
+        Theta_j = solve_Theta_j(j, c, Theta_j, epsilon_segment,
+                                complete_elliptic_integral_2nd,
+                                default_max_n_iterations_Theta_j);
+        theta_phi[0][j - 1] = Theta_j;
+        theta_phi[1][j - 1] = c * Theta_j;
+      }
+    } catch (...) {
+      errors[t] = current_exception();
+    }
+  };
 
-  for (size_t j = 1; j <= n; ++j) {
-    theta_phi[0][j] = find_Theta_j(j, n, c);
-    theta_phi[1][j] = c * theta_phi[0][j];
+  vector<thread> threads;
+  for (unsigned int t = 1; t < n_thr; ++t) {
+    threads.push_back(thread(work, t));
+  }
+  work(0);
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  for (auto &error : errors) {
+    if (error) {
+      rethrow_exception(error);
+    }
   }
 
   return theta_phi;
@@ -68,78 +125,11 @@ SpherePointSampler::sample_cartesian(const unsigned int n,
 
 double SpherePointSampler::elliptic_integral_2nd_kind_arbitrary_m(
     const double phi, const double m) const {
-
-  const double abs_m = fabs(m);
-
-  // Use Eq. (19.6.9) in Ref. \cite DLMF2020.
-  // The GSL implementation cannot handle this case.
-  if (m == 1.) {
-    return sin(phi);
-  }
-
-  const double abs_k = sqrt(abs_m);
-
-  // Direct call of the GSL library function possible.
-  if (m >= 0. && abs_m < 1.) {
-    return gsl_sf_ellint_E(phi, abs_k, GSL_PREC_DOUBLE);
-  }
-
-  // Use Eq. (19.7.5) in Ref. \cite DLMF2020.
-  const double abs_k_squared = abs_k * abs_k;
-  const double kappa_prime = 1. / sqrt(1. + abs_k_squared);
-  const double kappa = abs_k * kappa_prime;
-  const double kappa_squared = kappa * kappa;
-  // phi == pi/2 corresponds to the complete elliptic integral
-  // This is both a shortcut and an insurance against numerical instabilities.
   if (phi == M_PI_2) {
-    return gsl_sf_ellint_Ecomp(kappa, GSL_PREC_DOUBLE) / kappa_prime;
+    return carlson_elliptic_integral::complete_E(m, precision);
   }
 
-  const double theta = asin(
-      sin(phi) / (kappa_prime * sqrt(1. + abs_k * abs_k * pow(sin(phi), 2))));
-
-  return 1. / kappa_prime *
-         (elliptic_integral_2nd_kind_arbitrary_m(theta, kappa_squared) -
-          kappa_squared * sin(theta) * cos(theta) /
-              sqrt(1. - kappa_squared * pow(sin(theta), 2)));
-
-  // Alternative implementation of the cases \f$m < 0\f$ and \f$ |m| > 1 \f$
-  // based on Eqs. (17.4.16) and (17.4.18) in \cite AbramowitzStegun1974, which
-  // did not give the correct results. Possibly something went wrong in the
-  // transformation between \f$\varphi\f$ and \f$u\f$.
-  //
-  // const double u = elliptic_integral_1st_kind_arbitrary_m(phi, m);
-  //
-  // if(m < 0.){
-  //     const double sqrt_1_plus_abs_m = sqrt(1. + abs_m);
-  //     const double abs_m_over_1_plus_abs_m = abs_m/(1. + abs_m);
-
-  //     double sn_u_times_sqrt_1_plus_abs_m,
-  //     cn_u_times_sqrt_1_plus_abs_m, dn_u_times_sqrt_1_plus_abs_m;
-
-  //     gsl_sf_elljac_e(u*sqrt_1_plus_abs_m, abs_m_over_1_plus_abs_m,
-  //     &sn_u_times_sqrt_1_plus_abs_m, &cn_u_times_sqrt_1_plus_abs_m,
-  //     &dn_u_times_sqrt_1_plus_abs_m);
-
-  //     return sqrt_1_plus_abs_m*(
-  //         elliptic_integral_2nd_kind_arbitrary_m(
-  //             asin(sn_u_times_sqrt_1_plus_abs_m),
-  //             abs_m_over_1_plus_abs_m)
-  //         -abs_m/sqrt_1_plus_abs_m*sn_u_times_sqrt_1_plus_abs_m*cn_u_times_sqrt_1_plus_abs_m/dn_u_times_sqrt_1_plus_abs_m
-  //     );
-  // }
-
-  // const double inverse_abs_m = 1./abs_m;
-
-  // double sn_u_times_sqrt_abs_m, cn_u_times_sqrt_abs_m, dn_u_times_sqrt_abs_m;
-
-  // gsl_sf_elljac_e(u*sqrt_abs_m, inverse_abs_m, &sn_u_times_sqrt_abs_m,
-  // &cn_u_times_sqrt_abs_m, &dn_u_times_sqrt_abs_m);
-
-  // return sqrt_abs_m*elliptic_integral_2nd_kind_arbitrary_m(
-  //     asin(sn_u_times_sqrt_abs_m),
-  //     inverse_abs_m)
-  // -(abs_m-1.)*u;
+  return carlson_elliptic_integral::E(phi, m, precision);
 }
 
 double SpherePointSampler::segment_length(const double Theta,
@@ -148,11 +138,19 @@ double SpherePointSampler::segment_length(const double Theta,
     return elliptic_integral_2nd_kind_arbitrary_m(Theta, -c * c);
   }
 
-  const double negative_c_squared = -c * c;
-  return 2. * elliptic_integral_2nd_kind_arbitrary_m(M_PI_2,
-                                                     negative_c_squared) -
-         elliptic_integral_2nd_kind_arbitrary_m(M_PI - Theta,
-                                                negative_c_squared);
+  return segment_length(
+      Theta, c, elliptic_integral_2nd_kind_arbitrary_m(M_PI_2, -c * c));
+}
+
+double SpherePointSampler::segment_length(
+    const double Theta, const double c,
+    const double complete_elliptic_integral_2nd) const {
+  if (Theta >= 0 && Theta <= M_PI_2) {
+    return elliptic_integral_2nd_kind_arbitrary_m(Theta, -c * c);
+  }
+
+  return 2. * complete_elliptic_integral_2nd -
+         elliptic_integral_2nd_kind_arbitrary_m(M_PI - Theta, -c * c);
 }
 
 double SpherePointSampler::segment_length_linear_interpolation(
@@ -248,17 +246,31 @@ SpherePointSampler::find_Theta_j(const unsigned int j, const unsigned int n,
   }
 
   // Initial guess from Ref. \cite Koay2011
+  const double complete_elliptic_integral_2nd =
+      elliptic_integral_2nd_kind_arbitrary_m(M_PI_2, -c * c);
+
+  return solve_Theta_j(j, c, acos(1. - (2. * j - 1.) / (double)n),
+                       epsilon * 2. * complete_elliptic_integral_2nd /
+                           (double)n,
+                       complete_elliptic_integral_2nd, max_n_iterations);
+}
+
+double SpherePointSampler::solve_Theta_j(
+    const unsigned int j, const double c, const double Theta_j_0,
+    const double epsilon_segment, const double complete_elliptic_integral_2nd,
+    const unsigned int max_n_iterations) const {
+
   // Note that j is fixed here, and the iteration index is denoted as l
-  const double Theta_j_0 = acos(1. - (2. * j - 1.) / (double)n);
   double Theta_j_l = Theta_j_0;
-  const double epsilon_segment = epsilon * segment_length(M_PI, c) / (double)n;
 
   double Theta_j_l_plus_one = 0.;
 
   for (unsigned int i = 0; i < max_n_iterations; ++i) {
     Theta_j_l_plus_one =
-        Theta_j_l + ((2. * j - 1.) * M_PI - c * segment_length(Theta_j_l, c)) /
-                        (c * sqrt(1. + c * c * pow(sin(Theta_j_l), 2)));
+        Theta_j_l +
+        ((2. * j - 1.) * M_PI -
+         c * segment_length(Theta_j_l, c, complete_elliptic_integral_2nd)) /
+            (c * sqrt(1. + c * c * pow(sin(Theta_j_l), 2)));
 
     if (fabs(Theta_j_l_plus_one - Theta_j_l) < epsilon_segment) {
       return Theta_j_l_plus_one;
@@ -277,28 +289,9 @@ SpherePointSampler::find_Theta_j(const unsigned int j, const unsigned int n,
 
 double SpherePointSampler::elliptic_integral_1st_kind_arbitrary_m(
     const double phi, const double m) const {
-
-  const double abs_m = fabs(m);
-  const double abs_k = sqrt(abs_m);
-
-  if (m >= 0. && abs_m < 1.) {
-    return gsl_sf_ellint_F(phi, abs_k, GSL_PREC_DOUBLE);
-  }
-
-  // Use Eq. (19.7.5) in Ref. \cite DLMF2020.
-  const double abs_k_squared = abs_k * abs_k;
-  const double kappa_prime = 1. / sqrt(1. + abs_k_squared);
-  const double kappa = abs_k * kappa_prime;
-
-  // phi == pi/2 corresponds to the complete elliptic integral
-  // This is both a shortcut and an insurance against numerical instabilities.
   if (phi == M_PI_2) {
-    return kappa_prime * gsl_sf_ellint_Kcomp(kappa, GSL_PREC_DOUBLE);
+    return carlson_elliptic_integral::complete_K(m, precision);
   }
 
-  const double theta = asin(
-      sin(phi) / (kappa_prime * sqrt(1. + abs_k_squared * pow(sin(phi), 2))));
-
-  return kappa_prime *
-         elliptic_integral_1st_kind_arbitrary_m(theta, kappa * kappa);
+  return carlson_elliptic_integral::F(phi, m, precision);
 }
@@ -0,0 +1,238 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::min;
+
+#include <array>
+
+using std::array;
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <string>
+
+using std::to_string;
+
+#include <utility>
+
+using std::pair;
+
+#include <gsl/gsl_math.h>
+
+#include "SphereQuadrature.hh"
+
+namespace {
+
+/*
+    Parameters of a Lebedev rule, given as the weights (normalized to 1) of the
+    orbits of the octahedral group that contain the points
+    a1: (1, 0, 0), a2: (0, 1, 1)/sqrt(2), a3: (1, 1, 1)/sqrt(3),
+    bk: (l, l, m) with m = sqrt(1 - 2 l^2), and
+    ck: (p, q, 0) with q = sqrt(1 - p^2).
+    A weight of zero indicates that an orbit is not part of the rule.
+*/
+struct LebedevRule {
+  unsigned int degree;
+  double a1, a2, a3;
+  vector<pair<double, double>> b; // (l, weight)
+  vector<pair<double, double>> c; // (p, weight)
+};
+
+const vector<LebedevRule> &lebedev_rules() {
+  static const vector<LebedevRule> rules{
+      {3, 1. / 6., 0., 0., {}, {}},
+      {5, 1. / 15., 0., 3. / 40., {}, {}},
+      {7, 1. / 21., 4. / 105., 9. / 280., {}, {}},
+      {9, 1. / 105., 0., 9. / 280., {}, {{0.4597008433809831, 1. / 35.}}},
+      {11,
+       4. / 315.,
+       64. / 2835.,
+       27. / 1280.,
+       {{0.3015113445777636, 14641. / 725760.}},
+       {}},
+      {13,
+       0.5130671797338464e-3,
+       0.1660406956574204e-1,
+       -0.2958603896103896e-1,
+       {{0.4803844614152614, 0.2657620708215946e-1}},
+       {{0.3207726489807764, 0.1652217099371571e-1}}},
+      {15,
+       0.1154401154401154e-1,
+       0.,
+       0.1194390908585628e-1,
+       {{0.3696028464541502, 0.1111055571060340e-1},
+        {0.6943540066026664, 0.1187650129453714e-1}},
+       {{0.3742430390903412, 0.1181230374690448e-1}}},
+  };
+  return rules;
+}
+
+/*
+    Legendre polynomial P_n(x) and its derivative, using the three-term
+    recurrence relation.
+*/
+pair<double, double> legendre_and_derivative(const unsigned int n,
+                                             const double x) {
+  double p_0 = 1., p_1 = x;
+  for (unsigned int l = 2; l <= n; ++l) {
+    const double p_2 = ((2. * l - 1.) * x * p_1 - (l - 1.) * p_0) / l;
+    p_0 = p_1;
+    p_1 = p_2;
+  }
+  return {p_1, n * (x * p_1 - p_0) / (x * x - 1.)};
+}
+
+/*
+    Nodes and weights of an n-point Gauss-Legendre rule on [-1, 1].
+    The nodes are found with Newton's method, starting from the approximation
+    cos(pi (i + 3/4) / (n + 1/2)).
+*/
+pair<vector<double>, vector<double>> gauss_legendre(const unsigned int n) {
+  vector<double> x(n), w(n);
+
+  for (unsigned int i = 0; i < n; ++i) {
+    double x_i = cos(M_PI * (i + 0.75) / (n + 0.5));
+    for (unsigned int iteration = 0; iteration < 100; ++iteration) {
+      const pair<double, double> p_dp = legendre_and_derivative(n, x_i);
+      const double dx = p_dp.first / p_dp.second;
+      x_i -= dx;
+      if (fabs(dx) < 1e-15) {
+        break;
+      }
+    }
+    const double dp = legendre_and_derivative(n, x_i).second;
+
+    x[i] = x_i;
+    w[i] = 2. / ((1. - x_i * x_i) * dp * dp);
+  }
+
+  return {x, w};
+}
+
+} // namespace
+
+SphereQuadrature::SphereQuadrature(const unsigned int degree,
+                                   const QuadratureRule rule) {
+  if (rule == lebedev) {
+    create_lebedev(degree);
+  } else {
+    create_gauss_legendre_trapezoid(degree);
+  }
+}
+
+void SphereQuadrature::create_lebedev(const unsigned int min_degree) {
+  for (const auto &rule : lebedev_rules()) {
+    if (rule.degree < min_degree) {
+      continue;
+    }
+
+    degree = rule.degree;
+
+    // Adds all points of an orbit, which are the permutations of (u, v, w)
+    // with all possible signs. Duplicate points are skipped.
+    auto add_orbit = [&](const array<double, 3> u_v_w, const double weight) {
+      const array<array<int, 3>, 6> permutations{{{0, 1, 2},
+                                                  {0, 2, 1},
+                                                  {1, 0, 2},
+                                                  {1, 2, 0},
+                                                  {2, 0, 1},
+                                                  {2, 1, 0}}};
+      vector<array<double, 3>> orbit;
+      for (const auto &p : permutations) {
+        for (int signs = 0; signs < 8; ++signs) {
+          const array<double, 3> x_y_z{
+              (signs & 1 ? -1. : 1.) * u_v_w[p[0]],
+              (signs & 2 ? -1. : 1.) * u_v_w[p[1]],
+              (signs & 4 ? -1. : 1.) * u_v_w[p[2]]};
+          bool is_duplicate = false;
+          for (const auto &point : orbit) {
+            if (fabs(point[0] - x_y_z[0]) + fabs(point[1] - x_y_z[1]) +
+                    fabs(point[2] - x_y_z[2]) <
+                1e-12) {
+              is_duplicate = true;
+              break;
+            }
+          }
+          if (!is_duplicate) {
+            orbit.push_back(x_y_z);
+            add_point(x_y_z[0], x_y_z[1], x_y_z[2], 4. * M_PI * weight);
+          }
+        }
+      }
+    };
+
+    if (rule.a1 != 0.) {
+      add_orbit({1., 0., 0.}, rule.a1);
+    }
+    if (rule.a2 != 0.) {
+      add_orbit({0., M_SQRT1_2, M_SQRT1_2}, rule.a2);
+    }
+    if (rule.a3 != 0.) {
+      const double a = 1. / sqrt(3.);
+      add_orbit({a, a, a}, rule.a3);
+    }
+    for (const auto &b : rule.b) {
+      add_orbit({b.first, b.first, sqrt(1. - 2. * b.first * b.first)},
+                b.second);
+    }
+    for (const auto &c : rule.c) {
+      add_orbit({c.first, sqrt(1. - c.first * c.first), 0.}, c.second);
+    }
+
+    return;
+  }
+
+  throw invalid_argument("No Lebedev rule of degree " + to_string(min_degree) +
+                         " or higher is implemented. The maximum degree is " +
+                         to_string(max_lebedev_degree) + ".");
+}
+
+void SphereQuadrature::create_gauss_legendre_trapezoid(
+    const unsigned int min_degree) {
+  // An n-point Gauss-Legendre rule is exact for polynomials of degree 2n - 1,
+  // and an m-point trapezoidal rule for trigonometric polynomials of degree
+  // m - 1.
+  const unsigned int n_theta = min_degree / 2 + 1;
+  const unsigned int n_phi = min_degree + 1;
+  degree = min(2 * n_theta - 1, n_phi - 1);
+
+  const pair<vector<double>, vector<double>> x_w = gauss_legendre(n_theta);
+
+  for (unsigned int i = 0; i < n_theta; ++i) {
+    for (unsigned int j = 0; j < n_phi; ++j) {
+      theta.push_back(acos(x_w.first[i]));
+      phi.push_back(2. * M_PI * j / n_phi);
+      weights.push_back(x_w.second[i] * 2. * M_PI / n_phi);
+    }
+  }
+}
+
+void SphereQuadrature::add_point(const double x, const double y,
+                                 const double z, const double weight) {
+  theta.push_back(acos(z));
+  const double phi_i = atan2(y, x);
+  phi.push_back(phi_i < 0. ? phi_i + 2. * M_PI : phi_i);
+  weights.push_back(weight);
+}
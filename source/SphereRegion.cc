@@ -0,0 +1,170 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <gsl/gsl_math.h>
+
+#include "SphereRegion.hh"
+
+SphereRegion::SphereRegion(const array<double, 2> theta_phi,
+                           const double opening_angle) {
+  if (!(opening_angle > 0.) || !(opening_angle <= M_PI)) {
+    throw invalid_argument("Opening angle must be in the range (0, pi].");
+  }
+
+  parts.push_back({cos(opening_angle), 1., 0., 2. * M_PI, true,
+                   cos(theta_phi[0]), sin(theta_phi[0]), cos(theta_phi[1]),
+                   sin(theta_phi[1])});
+}
+
+SphereRegion::SphereRegion(const array<double, 2> theta_range,
+                           const array<double, 2> phi_range) {
+  if (!(theta_range[0] >= 0.) || !(theta_range[0] < theta_range[1]) ||
+      !(theta_range[1] <= M_PI)) {
+    throw invalid_argument(
+        "Range of theta must be an interval in [0, pi] with a positive "
+        "length.");
+  }
+  if (!(phi_range[0] < phi_range[1]) ||
+      !(phi_range[1] - phi_range[0] <= 2. * M_PI)) {
+    throw invalid_argument(
+        "Range of phi must have a positive length of at most 2 pi.");
+  }
+
+  parts.push_back({cos(theta_range[1]), cos(theta_range[0]), phi_range[0],
+                   phi_range[1], false, 1., 0., 1., 0.});
+}
+
+SphereRegion::SphereRegion(const vector<SphereRegion> &regions) {
+  if (regions.empty()) {
+    throw invalid_argument("At least one region is required.");
+  }
+
+  for (const auto &region : regions) {
+    parts.insert(parts.end(), region.parts.begin(), region.parts.end());
+  }
+}
+
+bool SphereRegion::contains(const double theta, const double phi) const {
+  for (const auto &part : parts) {
+    if (part_contains(part, theta, phi)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+double SphereRegion::get_solid_angle_of_parts() const {
+  double solid_angle = 0.;
+  for (const auto &part : parts) {
+    solid_angle += (part.z_max - part.z_min) * (part.phi_max - part.phi_min);
+  }
+  return solid_angle;
+}
+
+void SphereRegion::sample(const unsigned int n, vector<double> &theta,
+                          vector<double> &phi, vector<double> &weight) const {
+  const double golden_ratio_conjugate = 0.5 * (sqrt(5.) - 1.);
+  const double solid_angle_of_parts = get_solid_angle_of_parts();
+
+  theta.clear();
+  phi.clear();
+  weight.clear();
+
+  for (size_t j = 0; j < parts.size(); ++j) {
+    const Part &part = parts[j];
+    const double delta_z = part.z_max - part.z_min;
+    const double delta_phi = part.phi_max - part.phi_min;
+    const size_t n_j = max(
+        static_cast<size_t>(1),
+        static_cast<size_t>(lround(n * delta_z * delta_phi /
+                                   solid_angle_of_parts)));
+    const double weight_j = delta_z * delta_phi / n_j;
+
+    for (size_t i = 0; i < n_j; ++i) {
+      const double z = part.z_max - (i + 0.5) / n_j * delta_z;
+      const double phi_local =
+          part.phi_min +
+          fmod(i * golden_ratio_conjugate, 1.) * delta_phi;
+
+      double theta_i = acos(z), phi_i = phi_local;
+      if (part.rotated) {
+        // Rotation by theta_0 around the y axis, followed by a rotation by
+        // phi_0 around the z axis.
+        const double sin_theta = sqrt(max(0., 1. - z * z));
+        const double x_local = sin_theta * cos(phi_local),
+                     y_local = sin_theta * sin(phi_local);
+        const double x_1 = part.cos_theta_0 * x_local + part.sin_theta_0 * z;
+        const double z_1 = -part.sin_theta_0 * x_local + part.cos_theta_0 * z;
+        theta_i = acos(min(max(z_1, -1.), 1.));
+        phi_i = atan2(part.sin_phi_0 * x_1 + part.cos_phi_0 * y_local,
+                      part.cos_phi_0 * x_1 - part.sin_phi_0 * y_local);
+      }
+      phi_i = fmod(phi_i, 2. * M_PI);
+      if (phi_i < 0.) {
+        phi_i += 2. * M_PI;
+      }
+
+      bool in_previous_part = false;
+      for (size_t k = 0; k < j && !in_previous_part; ++k) {
+        in_previous_part = part_contains(parts[k], theta_i, phi_i);
+      }
+      if (!in_previous_part) {
+        theta.push_back(theta_i);
+        phi.push_back(phi_i);
+        weight.push_back(weight_j);
+      }
+    }
+  }
+}
+
+bool SphereRegion::part_contains(const Part &part, const double theta,
+                                 const double phi) {
+  double z = cos(theta), phi_local = phi;
+  if (part.rotated) {
+    // Inverse of the rotation in sample().
+    const double sin_theta = sin(theta);
+    const double x = sin_theta * cos(phi), y = sin_theta * sin(phi);
+    const double x_1 = part.cos_phi_0 * x + part.sin_phi_0 * y;
+    const double y_1 = -part.sin_phi_0 * x + part.cos_phi_0 * y;
+    const double x_local = part.cos_theta_0 * x_1 - part.sin_theta_0 * z;
+    z = part.sin_theta_0 * x_1 + part.cos_theta_0 * z;
+    phi_local = atan2(y_1, x_local);
+  }
+
+  if (z < part.z_min || z > part.z_max) {
+    return false;
+  }
+
+  double phi_offset = fmod(phi_local - part.phi_min, 2. * M_PI);
+  if (phi_offset < 0.) {
+    phi_offset += 2. * M_PI;
+  }
+  return phi_offset <= part.phi_max - part.phi_min;
+}
@@ -17,57 +17,9 @@
     Copyright (C) 2021-2023 Udo Friman-Gayer
 */
 
-#include <array>
-
-using std::array;
-
-#include <numeric>
-#include <utility>
-
-#include <gsl/gsl_math.h>
-
-#include "EulerAngleRotation.hh"
 #include "SphereRejectionSampler.hh"
 
 SphereRejectionSampler::SphereRejectionSampler(
     function<double(const double, const double)> dis, const double dis_max,
     const int seed, const unsigned int max_tri)
-    : distribution(dis), distribution_maximum(dis_max), max_tries(max_tri) {
-  random_engine = mt19937(seed);
-}
-
-pair<unsigned int, array<double, 3>> SphereRejectionSampler::sample() {
-
-  array<double, 2> theta_phi;
-  double dis_val;
-
-  for (unsigned int i = 0; i < max_tries; ++i) {
-
-    theta_phi = sample_theta_phi();
-    dis_val = uniform_random(random_engine) * distribution_maximum;
-
-    if (dis_val <= distribution(theta_phi[0], theta_phi[1])) {
-      return {i + 1, euler_angle_transform::from_spherical(
-                         // 1) Random point on unit sphere surface
-                         theta_phi,
-                         // 2) Random rotation by first Euler angle
-                         // corresponding to a lack of knowledge about the
-                         // orientation of the third coordinate-system axis.
-                         2. * uniform_random(random_engine) * M_PI)};
-    }
-  }
-
-  return {max_tries, {0., 0., 0.}};
-}
-
-double SphereRejectionSampler::sample_theta() {
-  return acos(2. * uniform_random(random_engine) - 1.);
-}
-
-double SphereRejectionSampler::sample_phi() {
-  return 2. * M_PI * uniform_random(random_engine);
-}
-
-array<double, 2> SphereRejectionSampler::sample_theta_phi() {
-  return {sample_theta(), sample_phi()};
-}
\ No newline at end of file
+    : TypedSphereRejectionSampler(dis, dis_max, seed, max_tri) {}
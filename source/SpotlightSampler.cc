@@ -36,10 +36,19 @@ SpotlightSampler::SpotlightSampler(const array<double, 2> theta_phi,
                                    const double opening_angle, const int seed)
     : theta_phi(theta_phi), opening_angle(opening_angle), seed(seed) {
   u_min = 0.5 * (1. + cos(opening_angle));
+  fixed_rotation = euler_angle_transform::rotation_matrix(
+      euler_angle_transform::from_spherical(theta_phi));
   random_engine = mt19937(seed);
 }
 
+void SpotlightSampler::reseed(seed_seq &seq) {
+  random_engine.seed(seq);
+  uniform_random.reset();
+}
+
 pair<unsigned int, array<double, 3>> SpotlightSampler::sample() {
+  record(1, true);
+
   if (opening_angle == 0.0) {
     return {1, euler_angle_transform::from_spherical(theta_phi)};
   }
@@ -50,3 +59,19 @@ pair<unsigned int, array<double, 3>> SpotlightSampler::sample() {
 
   return {1, euler_angle_transform::from_spherical({theta, phi}, 0.)};
 }
+
+pair<unsigned int, euler_angle_transform::RotationMatrix>
+SpotlightSampler::sample_rotation_matrix() {
+  record(1, true);
+
+  if (opening_angle == 0.0) {
+    return {1, fixed_rotation};
+  }
+
+  const double cos_theta =
+      2.0 * (u_min + (1.0 - u_min) * uniform_random(random_engine)) - 1.0;
+  const double phi = 2.0 * M_PI * uniform_random(random_engine);
+
+  return {1, euler_angle_transform::rotation_matrix_from_spherical(cos_theta,
+                                                                   phi)};
+}
@@ -0,0 +1,237 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <cmath>
+
+#include <memory>
+
+using std::make_shared;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <utility>
+
+using std::move;
+
+#include "EulerAngleRotation.hh"
+#include "LegendreSeries.hh"
+#include "TabulatedAngularCorrelation.hh"
+
+namespace {
+
+/**
+ * \brief Value of the k-th derivative of the Legendre polynomial of order l at
+ * x = 1.
+ *
+ * \f[
+ *      P_l^{(k)} \left( 1 \right) = \frac{\left( l + k \right)!}{2^k k!
+ * \left( l - k \right)!} \f]
+ */
+double legendre_derivative_at_one(const int l, const int k) {
+  if (k > l) {
+    return 0.;
+  }
+
+  double result = 1.;
+  for (int j = l - k + 1; j <= l + k; ++j) {
+    result *= j;
+  }
+  for (int j = 1; j <= k; ++j) {
+    result /= 2. * j;
+  }
+
+  return result;
+}
+
+} // namespace
+
+TabulatedAngularCorrelation::TabulatedAngularCorrelation(
+    const AngularCorrelation &ang_cor, const double max_error)
+    : TabulatedAngularCorrelation(
+          ang_cor.get_legendre_coefficients(),
+          ang_cor.get_associated_legendre_coefficients(), max_error) {}
+
+TabulatedAngularCorrelation::TabulatedAngularCorrelation(
+    const vector<double> &c, const vector<double> &d, const double max_error)
+    : nu_max(2 * ((int)c.size() - 1)), polarized(!d.empty()) {
+
+  if (c.empty()) {
+    throw invalid_argument("At least one Legendre coefficient required.");
+  }
+  if (polarized && d.size() + 1 != c.size()) {
+    throw invalid_argument("Number of associated Legendre coefficients must "
+                           "be one less than the number of Legendre "
+                           "coefficients.");
+  }
+  if (max_error <= 0.) {
+    throw invalid_argument("Maximum error must be positive.");
+  }
+
+  // h^4 M_4 / 384 <= max_error, with h = 2 / n.
+  const double m_4 = fourth_derivative_limit(c, d);
+  const double n_min = 2. * pow(m_4 / (384. * max_error), 0.25);
+  if (n_min > max_n_intervals) {
+    throw invalid_argument(
+        "Maximum error too small, the table would be too large.");
+  }
+  n_intervals = max(static_cast<size_t>(1), static_cast<size_t>(ceil(n_min)));
+
+  const double h = 2. / n_intervals;
+  inverse_width = 1. / h;
+  error_bound = h * h * h * h * m_4 / 384.;
+  upper_limit =
+      legendre_series::maximum(c.size(), c.data(), d.size(), d.data()) +
+      error_bound;
+
+  // Values and derivatives at the n + 1 nodes.
+  const size_t n_nodes = n_intervals + 1;
+  vector<double> x(n_nodes);
+  for (size_t k = 0; k < n_nodes; ++k) {
+    x[k] = -1. + k * h;
+  }
+  x[n_intervals] = 1.;
+
+  vector<double> a(n_nodes), a_prime(n_nodes), b(n_nodes, 0.),
+      b_prime(n_nodes, 0.);
+  legendre_series::legendre(n_nodes, x.data(), c.size(), c.data(), a.data());
+  legendre_series::legendre_derivative(n_nodes, x.data(), c.size(), c.data(),
+                                       a_prime.data());
+  if (polarized) {
+    legendre_series::associated_legendre_2(n_nodes, x.data(), d.size(),
+                                           d.data(), b.data());
+    legendre_series::associated_legendre_2_derivative(
+        n_nodes, x.data(), d.size(), d.data(), b_prime.data());
+  }
+
+  // Cubic Hermite polynomials
+  // p(t) = f_0 + t h f_0' + t^2 [3 (f_1 - f_0) - 2 h f_0' - h f_1']
+  //        + t^3 [2 (f_0 - f_1) + h f_0' + h f_1']
+  // on each interval, where t is the relative position inside the interval.
+  stride = polarized ? 8 : 4;
+  vector<double> coefficients(n_intervals * stride);
+  for (size_t k = 0; k < n_intervals; ++k) {
+    double *p = coefficients.data() + k * stride;
+    for (size_t j = 0; j < stride / 4; ++j) {
+      const vector<double> &f = j == 0 ? a : b;
+      const vector<double> &f_prime = j == 0 ? a_prime : b_prime;
+      const double f_0 = f[k], f_1 = f[k + 1];
+      const double hf_0 = h * f_prime[k], hf_1 = h * f_prime[k + 1];
+      p[4 * j] = f_0;
+      p[4 * j + 1] = hf_0;
+      p[4 * j + 2] = 3. * (f_1 - f_0) - 2. * hf_0 - hf_1;
+      p[4 * j + 3] = 2. * (f_0 - f_1) + hf_0 + hf_1;
+    }
+  }
+
+  table = make_shared<const vector<double>>(move(coefficients));
+}
+
+double TabulatedAngularCorrelation::fourth_derivative_limit(
+    const vector<double> &legendre_coefficients,
+    const vector<double> &associated_legendre_coefficients) {
+
+  double m_4 = 0.;
+  for (size_t i = 0; i < legendre_coefficients.size(); ++i) {
+    m_4 += fabs(legendre_coefficients[i]) *
+           legendre_derivative_at_one(2 * (int)i, 4);
+  }
+  // Fourth derivative of (1 - x^2) P_l''(x):
+  // (1 - x^2) P_l^(6) - 8 x P_l^(5) - 12 P_l^(4)
+  for (size_t i = 0; i < associated_legendre_coefficients.size(); ++i) {
+    const int l = 2 * (int)i + 2;
+    m_4 += fabs(associated_legendre_coefficients[i]) *
+           (legendre_derivative_at_one(l, 6) +
+            8. * legendre_derivative_at_one(l, 5) +
+            12. * legendre_derivative_at_one(l, 4));
+  }
+
+  return m_4;
+}
+
+double TabulatedAngularCorrelation::interpolate(const double cos_theta,
+                                                const double cos_2phi) const {
+  const double u = max(0., min((cos_theta + 1.) * inverse_width,
+                               static_cast<double>(n_intervals)));
+  const size_t k = min(static_cast<size_t>(u), n_intervals - 1);
+  const double t = u - k;
+  const double *p = table->data() + k * stride;
+
+  double result = p[0] + t * (p[1] + t * (p[2] + t * p[3]));
+  if (polarized) {
+    result += cos_2phi * (p[4] + t * (p[5] + t * (p[6] + t * p[7])));
+  }
+
+  return result;
+}
+
+double TabulatedAngularCorrelation::operator()(const double theta,
+                                               const double phi) const {
+  return interpolate(cos(theta), cos(2. * phi));
+}
+
+void TabulatedAngularCorrelation::evaluate(const size_t n, const double *theta,
+                                           const double *phi,
+                                           double *result) const {
+  for (size_t k = 0; k < n; ++k) {
+    result[k] =
+        interpolate(cos(theta[k]), polarized ? cos(2. * phi[k]) : 0.);
+  }
+}
+
+void TabulatedAngularCorrelation::evaluate_cos_theta(const size_t n,
+                                                     const double *cos_theta,
+                                                     const double *phi,
+                                                     double *result) const {
+  for (size_t k = 0; k < n; ++k) {
+    result[k] = interpolate(cos_theta[k], polarized ? cos(2. * phi[k]) : 0.);
+  }
+}
+
+void TabulatedAngularCorrelation::evaluate(const size_t n, const double *theta,
+                                           const double *phi,
+                                           const array<double, 3> Phi_Theta_Psi,
+                                           double *result) const {
+
+  // The inverse of a rotation matrix is its transpose.
+  const euler_angle_transform::RotationMatrix A_inv =
+      euler_angle_transform::transpose(
+          euler_angle_transform::rotation_matrix(Phi_Theta_Psi));
+
+  for (size_t k = 0; k < n; ++k) {
+    const double sin_theta = sin(theta[k]);
+    const array<double, 3> r_rot = euler_angle_transform::apply(
+        A_inv,
+        {sin_theta * cos(phi[k]), sin_theta * sin(phi[k]), cos(theta[k])});
+
+    // For a direction along the z axis, phi = atan2(0, 0) = 0.
+    const double r_perp_2 = r_rot[0] * r_rot[0] + r_rot[1] * r_rot[1];
+    const double cos_2phi =
+        r_perp_2 > 0.
+            ? (r_rot[0] * r_rot[0] - r_rot[1] * r_rot[1]) / r_perp_2
+            : 1.;
+    result[k] = interpolate(r_rot[2], cos_2phi);
+  }
+}
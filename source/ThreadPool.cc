@@ -0,0 +1,275 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <atomic>
+
+using std::atomic;
+
+#include <condition_variable>
+
+using std::condition_variable;
+
+#include <cstdlib>
+
+using std::getenv;
+using std::strtoul;
+
+#include <deque>
+
+using std::deque;
+
+#include <exception>
+
+using std::current_exception;
+using std::exception_ptr;
+using std::rethrow_exception;
+
+#include <mutex>
+
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <thread>
+
+using std::thread;
+
+#include <utility>
+
+using std::move;
+
+#include <vector>
+
+using std::vector;
+
+#include "ThreadPool.hh"
+
+namespace {
+
+unsigned int hardware_threads() {
+  return max(1u, thread::hardware_concurrency());
+}
+
+unsigned int initial_n_threads() {
+  const char *n_threads = getenv("ALPACA_NUM_THREADS");
+  if (n_threads != nullptr) {
+    const unsigned long n = strtoul(n_threads, nullptr, 10);
+    if (n > 0) {
+      return (unsigned int)n;
+    }
+  }
+  return hardware_threads();
+}
+
+/*
+    Ranges of one call of parallel_for(), which wait for their completion.
+*/
+struct Group {
+  atomic<size_t> remaining;
+  mutex group_mutex;
+  condition_variable finished;
+  exception_ptr error;
+};
+
+/*
+    Set while a thread executes a range, so that nested calls of
+    parallel_for() are serial.
+*/
+thread_local bool inside_range = false;
+
+class Pool {
+public:
+  Pool()
+      : n_threads(initial_n_threads()),
+        min_work(ThreadPool::default_min_work) {}
+
+  ~Pool() {
+    {
+      lock_guard<mutex> lock(queue_mutex);
+      stopping = true;
+    }
+    work_available.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  /*
+      Start workers until there are n_workers.
+  */
+  void start_workers(const size_t n_workers) {
+    lock_guard<mutex> lock(queue_mutex);
+    while (workers.size() < n_workers) {
+      workers.push_back(thread(&Pool::work, this));
+    }
+  }
+
+  void push(const vector<function<void()>> &new_tasks) {
+    {
+      lock_guard<mutex> lock(queue_mutex);
+      tasks.insert(tasks.end(), new_tasks.begin(), new_tasks.end());
+    }
+    work_available.notify_all();
+  }
+
+  /*
+      Execute a queued task in the calling thread, if there is one.
+  */
+  bool try_run_task() {
+    function<void()> task;
+    {
+      lock_guard<mutex> lock(queue_mutex);
+      if (tasks.empty()) {
+        return false;
+      }
+      task = move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+    return true;
+  }
+
+  atomic<unsigned int> n_threads;
+  atomic<size_t> min_work;
+
+protected:
+  void work() {
+    while (true) {
+      function<void()> task;
+      {
+        unique_lock<mutex> lock(queue_mutex);
+        work_available.wait(lock,
+                            [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) {
+          return;
+        }
+        task = move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  mutex queue_mutex;
+  condition_variable work_available;
+  deque<function<void()>> tasks;
+  vector<thread> workers;
+  bool stopping = false;
+};
+
+Pool &pool() {
+  static Pool instance;
+  return instance;
+}
+
+/*
+    Execute a range and notify its group when all ranges have finished.
+*/
+void run_range(Group &group, const function<void(size_t, size_t)> &f,
+               const size_t begin, const size_t end) {
+  inside_range = true;
+  try {
+    f(begin, end);
+  } catch (...) {
+    lock_guard<mutex> lock(group.group_mutex);
+    if (!group.error) {
+      group.error = current_exception();
+    }
+  }
+  inside_range = false;
+
+  // The decrement happens under the lock, because the group is destroyed as
+  // soon as the waiting thread sees that all ranges have finished.
+  lock_guard<mutex> lock(group.group_mutex);
+  if (--group.remaining == 0) {
+    group.finished.notify_all();
+  }
+}
+
+} // namespace
+
+void ThreadPool::parallel_for(const size_t n,
+                              const function<void(size_t, size_t)> &f,
+                              const size_t work_per_index) {
+  if (n == 0) {
+    return;
+  }
+
+  Pool &p = pool();
+  const size_t work = n * max(work_per_index, (size_t)1);
+  const size_t n_ranges =
+      min({(size_t)p.n_threads.load(), n, max(work / p.min_work, (size_t)1)});
+  if (n_ranges <= 1 || inside_range) {
+    f(0, n);
+    return;
+  }
+
+  p.start_workers(n_ranges - 1);
+
+  Group group;
+  group.remaining = n_ranges;
+  vector<function<void()>> tasks;
+  for (size_t r = 1; r < n_ranges; ++r) {
+    const size_t begin = r * n / n_ranges, end = (r + 1) * n / n_ranges;
+    tasks.push_back(
+        [&group, &f, begin, end]() { run_range(group, f, begin, end); });
+  }
+  p.push(tasks);
+
+  run_range(group, f, 0, n / n_ranges);
+
+  // Help with queued tasks, which may also belong to other calls, until the
+  // ranges of this call have been taken.
+  while (group.remaining.load() > 0 && p.try_run_task()) {
+  }
+
+  {
+    unique_lock<mutex> lock(group.group_mutex);
+    group.finished.wait(lock, [&group] { return group.remaining.load() == 0; });
+  }
+
+  if (group.error) {
+    rethrow_exception(group.error);
+  }
+}
+
+unsigned int ThreadPool::get_n_threads() { return pool().n_threads; }
+
+void ThreadPool::set_n_threads(const unsigned int n_threads) {
+  pool().n_threads = n_threads > 0 ? n_threads : hardware_threads();
+}
+
+size_t ThreadPool::get_min_work() { return pool().min_work; }
+
+void ThreadPool::set_min_work(const size_t min_work) {
+  pool().min_work = max(min_work, (size_t)1);
+}
+
+extern "C" {
+unsigned int get_n_threads() { return ThreadPool::get_n_threads(); }
+
+void set_n_threads(const unsigned int n_threads) {
+  ThreadPool::set_n_threads(n_threads);
+}
+}
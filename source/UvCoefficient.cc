@@ -23,17 +23,20 @@
 
 using std::to_string;
 
-#include <gsl/gsl_sf.h>
-
+#include "FCoefficient.hh"
+#include "Profiler.hh"
 #include "UvCoefficient.hh"
+#include "WignerSymbolCache.hh"
 
 UvCoefficient::UvCoefficient(const unsigned int two_nu, const int two_j,
                              const int two_L, const int two_jp)
     : two_nu(two_nu), two_j(two_j), two_L(two_L), two_Lp(two_L + 2), delta(0.),
       two_jp(two_jp) {
+  ALPACA_PROFILE_SCOPE("UvCoefficient::UvCoefficient");
 
   value_L = phase_norm_6j_symbol(two_nu, two_j, two_L, two_jp);
   value_Lp = 0.;
+  coefficient_Lp = 0.;
   value = value_L;
 }
 
@@ -42,15 +45,31 @@ UvCoefficient::UvCoefficient(const unsigned int two_nu, const int two_j,
                              const double delta, const int two_jp)
     : two_nu(two_nu), two_j(two_j), two_L(two_L), two_Lp(two_Lp), delta(delta),
       two_jp(two_jp) {
+  ALPACA_PROFILE_SCOPE("UvCoefficient::UvCoefficient");
 
   value_L = phase_norm_6j_symbol(two_nu, two_j, two_L, two_jp);
 
-  if (delta != 0.) {
-    value_Lp =
-        delta * delta * phase_norm_6j_symbol(two_nu, two_j, two_Lp, two_jp);
-  } else {
-    value_Lp = 0.;
-  }
+  coefficient_Lp = phase_norm_6j_symbol(two_nu, two_j, two_Lp, two_jp);
+  value_Lp = delta != 0. ? delta * delta * coefficient_Lp : 0.;
+
+  value = value_L + value_Lp;
+}
+
+UvCoefficient::UvCoefficient(const unsigned int two_nu, const int two_j,
+                             const int two_L, const int two_Lp,
+                             const double delta, const int two_jp,
+                             const double value_L,
+                             const double coefficient_Lp)
+    : two_nu(two_nu), two_j(two_j), two_L(two_L), two_Lp(two_Lp), delta(delta),
+      two_jp(two_jp), value_L(value_L), coefficient_Lp(coefficient_Lp) {
+  value_Lp = delta != 0. ? delta * delta * coefficient_Lp : 0.;
+
+  value = value_L + value_Lp;
+}
+
+void UvCoefficient::set_delta(const double delta) {
+  this->delta = delta;
+  value_Lp = delta != 0. ? delta * delta * coefficient_Lp : 0.;
 
   value = value_L + value_Lp;
 }
@@ -73,27 +92,54 @@ double UvCoefficient::phase_norm_6j_symbol(const int two_nu, const int two_j,
   //     two_jp, two_jp, two_L);
 
   // Definition of Biedenharn \cite AjzenbergSelove1960 (Sec. 1.a.1.iii)
+  if (!FCoefficient::racah_is_nonzero(two_j, two_nu, two_j, two_jp, two_L,
+                                      two_jp)) {
+    return 0.;
+  }
+
   const int phase_factor = (((two_j + two_jp + two_L) / 2) % 2) == 0 ? 1 : -1;
 
+  // Columns of the 6j symbol permuted such that nu is the first argument (see
+  // WignerSymbolCache).
   return phase_factor * sqrt((two_jp + 1) * (two_j + 1)) *
-         gsl_sf_coupling_6j(two_j, two_nu, two_j, two_jp, two_L, two_jp);
+         WignerSymbolCache::coupling_6j(two_nu, two_j, two_j, two_L, two_jp,
+                                        two_jp);
 }
 
-string
-UvCoefficient::string_representation(const unsigned int n_digits,
-                                     vector<string> variable_names) const {
-
-  string delta_variable = variable_names.size() ? variable_names[0] : "\\delta";
+void UvCoefficient::write_string_representation(
+    string &str_rep, const unsigned int n_digits,
+    const vector<string> &variable_names) const {
+  if (variable_names.size()) {
+    write_string_representation(str_rep, n_digits, variable_names[0]);
+  } else {
+    write_string_representation(str_rep, n_digits, "\\delta");
+  }
+}
 
+void UvCoefficient::write_string_representation(
+    string &str_rep, const unsigned int n_digits,
+    const string &delta_variable) const {
   if (n_digits) {
-    return float_string_representation(n_digits, value_L) + "+" +
-           float_string_representation(n_digits, value_Lp) + "\\times" +
-           delta_variable + "^{2}";
+    write_float_string_representation(str_rep, n_digits, value_L);
+    str_rep += "+";
+    write_float_string_representation(str_rep, n_digits, value_Lp);
+    str_rep += "\\times";
+  } else {
+    const auto write_symbol = [&](const int two_L_or_Lp) {
+      str_rep += "U_{";
+      str_rep += to_string(two_nu / 2);
+      str_rep += "}\\left(";
+      str_rep += to_string(two_j / 2);
+      str_rep += ",";
+      str_rep += to_string(two_L_or_Lp / 2);
+      str_rep += ",";
+      str_rep += to_string(two_jp / 2);
+      str_rep += "\\right)";
+    };
+    write_symbol(two_L);
+    str_rep += "+";
+    write_symbol(two_Lp);
   }
-
-  return "U_{" + to_string(two_nu / 2) + "}\\left(" + to_string(two_j / 2) +
-         "," + to_string(two_L / 2) + "," + to_string(two_jp / 2) + "\\right)" +
-         "+" + "U_{" + to_string(two_nu / 2) + "}\\left(" +
-         to_string(two_j / 2) + "," + to_string(two_Lp / 2) + "," +
-         to_string(two_jp / 2) + "\\right)" + delta_variable + "^{2}";
+  str_rep += delta_variable;
+  str_rep += "^{2}";
 }
@@ -25,6 +25,7 @@
 
 #include <gsl/gsl_sf.h>
 
+#include "LegendreSeries.hh"
 #include "W_dir_dir.hh"
 
 using std::max;
@@ -37,6 +38,86 @@ W_dir_dir::W_dir_dir(const State &ini_sta,
   nu_max = two_nu_max / 2;
   normalization_factor = calculate_normalization_factor();
   expansion_coefficients = calculate_expansion_coefficients();
+
+  const vector<double> legendre_coefficients = get_legendre_coefficients();
+  legendre_coefficients_float.assign(legendre_coefficients.begin(),
+                                     legendre_coefficients.end());
+}
+
+W_dir_dir::W_dir_dir(const State &ini_sta,
+                     const vector<pair<Transition, State>> cas_ste,
+                     const vector<double> &coefficient_values)
+    : W_gamma_gamma(ini_sta, cas_ste) {
+  two_nu_max = calculate_two_nu_max();
+  nu_max = two_nu_max / 2;
+  normalization_factor = calculate_normalization_factor();
+
+  const size_t n_nu = two_nu_max / 4 + 1;
+  const size_t n_uv = n_cascade_steps > 2 ? n_cascade_steps - 2 : 0;
+  if (coefficient_values.size() != n_nu * (6 + 2 * n_uv)) {
+    throw invalid_argument("Number of coefficient values (" +
+                           to_string(coefficient_values.size()) +
+                           ") does not match the cascade (" +
+                           to_string(n_nu * (6 + 2 * n_uv)) + ").");
+  }
+
+  const double *values = coefficient_values.data();
+  for (int two_nu = 0; two_nu <= two_nu_max; two_nu += 4, values += 6) {
+    av_coefficients_excitation.push_back(AvCoefficient(
+        two_nu, cascade_steps[0].first.two_L, cascade_steps[0].first.two_Lp,
+        initial_state.two_J, cascade_steps[0].second.two_J,
+        {values[0], values[1], values[2]}));
+    av_coefficients_decay.push_back(
+        AvCoefficient(two_nu, cascade_steps[n_cascade_steps - 1].first.two_L,
+                      cascade_steps[n_cascade_steps - 1].first.two_Lp,
+                      cascade_steps[n_cascade_steps - 1].second.two_J,
+                      cascade_steps[n_cascade_steps - 2].second.two_J,
+                      {values[3], values[4], values[5]}));
+  }
+
+  if (n_cascade_steps > 2) {
+    for (int two_nu = 0; two_nu <= two_nu_max; two_nu += 4) {
+      uv_coefficients.push_back(vector<UvCoefficient>());
+      double uv_coef_product = 1.;
+      for (size_t i = 1; i < n_cascade_steps - 1; ++i, values += 2) {
+        uv_coefficients[two_nu / 4].push_back(UvCoefficient(
+            two_nu, cascade_steps[i - 1].second.two_J,
+            cascade_steps[i].first.two_L, cascade_steps[i].first.two_Lp,
+            cascade_steps[i].first.delta, cascade_steps[i].second.two_J,
+            values[0], values[1]));
+        uv_coef_product =
+            uv_coef_product * uv_coefficients[two_nu / 4][i - 1].get_value();
+      }
+      uv_coefficient_products.push_back(uv_coef_product);
+    }
+  }
+
+  expansion_coefficients.resize(n_nu);
+  legendre_coefficients_float.resize(n_nu);
+  update_expansion_coefficients();
+}
+
+vector<double> W_dir_dir::get_coefficient_values() const {
+  vector<double> values;
+
+  for (size_t i = 0; i < av_coefficients_excitation.size(); ++i) {
+    const array<double, 3> f_values_excitation =
+        av_coefficients_excitation[i].get_f_values();
+    const array<double, 3> f_values_decay =
+        av_coefficients_decay[i].get_f_values();
+    values.insert(values.end(), f_values_excitation.begin(),
+                  f_values_excitation.end());
+    values.insert(values.end(), f_values_decay.begin(), f_values_decay.end());
+  }
+
+  for (const auto &uv_coefficients_nu : uv_coefficients) {
+    for (const auto &uv_coefficient : uv_coefficients_nu) {
+      values.push_back(uv_coefficient.get_value_L());
+      values.push_back(uv_coefficient.get_coefficient_Lp());
+    }
+  }
+
+  return values;
 }
 
 double W_dir_dir::operator()(const double theta) const {
@@ -51,6 +132,166 @@ double W_dir_dir::operator()(const double theta) const {
   return sum_over_nu * normalization_factor;
 }
 
+double W_dir_dir::operator()(const double theta,
+                             const vector<double> &deltas) const {
+
+  check_deltas(deltas);
+
+  const vector<double> exp_coef = calculate_expansion_coefficients(deltas);
+
+  double sum_over_nu{0.};
+
+  for (int i = 0; i <= nu_max / 2; ++i) {
+    sum_over_nu += exp_coef[i] * gsl_sf_legendre_Pl(2 * i, cos(theta));
+  }
+
+  return sum_over_nu * calculate_normalization_factor(deltas);
+}
+
+void W_dir_dir::evaluate(const size_t n, const double *theta,
+                         [[maybe_unused]] const double *phi,
+                         double *result) const {
+
+  double cos_theta[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+
+    for (size_t k = 0; k < m; ++k) {
+      cos_theta[k] = cos(theta[start + k]);
+    }
+
+    evaluate_cos_theta(m, cos_theta, phi ? phi + start : nullptr,
+                       result + start);
+  }
+}
+
+void W_dir_dir::evaluate_cos_theta(const size_t n, const double *cos_theta,
+                                   [[maybe_unused]] const double *phi,
+                                   double *result) const {
+
+  legendre_series::legendre(n, cos_theta, nu_max / 2 + 1,
+                            expansion_coefficients.data(), result);
+
+  for (size_t k = 0; k < n; ++k) {
+    result[k] *= normalization_factor;
+  }
+}
+
+void W_dir_dir::evaluate_cos_theta(const size_t n, const float *cos_theta,
+                                   [[maybe_unused]] const float *phi,
+                                   float *result) const {
+
+  legendre_series::legendre(n, cos_theta, legendre_coefficients_float.size(),
+                            legendre_coefficients_float.data(), result);
+}
+
+void W_dir_dir::evaluate_cos_theta(const size_t n, const double *cos_theta,
+                                   [[maybe_unused]] const double *phi,
+                                   const vector<double> &deltas,
+                                   double *result) const {
+
+  check_deltas(deltas);
+
+  const vector<double> exp_coef = calculate_expansion_coefficients(deltas);
+  const double norm = calculate_normalization_factor(deltas);
+
+  legendre_series::legendre(n, cos_theta, nu_max / 2 + 1, exp_coef.data(),
+                            result);
+
+  for (size_t k = 0; k < n; ++k) {
+    result[k] *= norm;
+  }
+}
+
+void W_dir_dir::evaluate_attenuated_cos_theta(
+    const size_t n, const double *cos_theta, [[maybe_unused]] const double *phi,
+    const double *attenuation, double *result) const {
+
+  vector<double> exp_coef(nu_max / 2 + 1);
+  for (size_t i = 0; i < exp_coef.size(); ++i) {
+    exp_coef[i] = attenuation[i] * expansion_coefficients[i] *
+                  normalization_factor;
+  }
+
+  legendre_series::legendre(n, cos_theta, exp_coef.size(), exp_coef.data(),
+                            result);
+}
+
+void W_dir_dir::evaluate_with_gradient(const size_t n, const double *theta,
+                                       [[maybe_unused]] const double *phi,
+                                       const vector<double> &deltas,
+                                       double *result, double *gradient) const {
+
+  check_deltas(deltas);
+
+  const size_t n_coefficients = nu_max / 2 + 1;
+  const size_t row_length = n_cascade_steps + 2;
+  const vector<double> exp_coef = calculate_expansion_coefficients(deltas);
+  const vector<vector<double>> exp_coef_derivatives =
+      calculate_expansion_coefficient_derivatives(deltas);
+  const double norm = calculate_normalization_factor(deltas);
+
+  double cos_theta[legendre_series::block_size],
+      derivative[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+    double *result_block = result + start;
+    double *gradient_block = gradient + start * row_length;
+
+    for (size_t k = 0; k < m; ++k) {
+      cos_theta[k] = cos(theta[start + k]);
+    }
+
+    legendre_series::legendre(m, cos_theta, n_coefficients, exp_coef.data(),
+                              result_block);
+    legendre_series::legendre_derivative(m, cos_theta, n_coefficients,
+                                         exp_coef.data(), derivative);
+    for (size_t k = 0; k < m; ++k) {
+      gradient_block[k * row_length] =
+          -sin(theta[start + k]) * derivative[k] * norm;
+      gradient_block[k * row_length + 1] = 0.;
+    }
+
+    // Product rule for the normalization factor:
+    // d/d delta_j [N S] = N (dS/d delta_j - 2 delta_j / (1 + delta_j^2) S)
+    for (size_t j = 0; j < n_cascade_steps; ++j) {
+      const double d_log_norm = -2. * deltas[j] / (1. + deltas[j] * deltas[j]);
+      legendre_series::legendre(m, cos_theta, n_coefficients,
+                                exp_coef_derivatives[j].data(), derivative);
+      for (size_t k = 0; k < m; ++k) {
+        gradient_block[k * row_length + 2 + j] =
+            norm * (derivative[k] + d_log_norm * result_block[k]);
+      }
+    }
+
+    for (size_t k = 0; k < m; ++k) {
+      result_block[k] *= norm;
+    }
+  }
+}
+
+void W_dir_dir::set_delta(const size_t step, const double delta) {
+
+  set_cascade_step_delta(step, delta);
+
+  if (step > 0 && step < n_cascade_steps - 1) {
+    for (size_t i = 0; i < uv_coefficients.size(); ++i) {
+      uv_coefficients[i][step - 1].set_delta(delta);
+
+      double uv_coef_product = 1.;
+      for (size_t j = 0; j < uv_coefficients[i].size(); ++j) {
+        uv_coef_product = uv_coef_product * uv_coefficients[i][j].get_value();
+      }
+      uv_coefficient_products[i] = uv_coef_product;
+    }
+  }
+
+  normalization_factor = calculate_normalization_factor();
+  update_expansion_coefficients();
+}
+
 double W_dir_dir::get_upper_limit() const {
 
   double upper_limit = 0.;
@@ -62,6 +303,26 @@ double W_dir_dir::get_upper_limit() const {
   return normalization_factor * upper_limit;
 }
 
+double W_dir_dir::get_maximum() const {
+  return fabs(normalization_factor) *
+         legendre_series::maximum(nu_max / 2 + 1, expansion_coefficients.data(),
+                                  0, nullptr);
+}
+
+vector<double> W_dir_dir::get_legendre_coefficients() const {
+
+  vector<double> coefficients(nu_max / 2 + 1);
+  for (size_t i = 0; i < coefficients.size(); ++i) {
+    coefficients[i] = normalization_factor * expansion_coefficients[i];
+  }
+
+  return coefficients;
+}
+
+vector<double> W_dir_dir::get_associated_legendre_coefficients() const {
+  return {};
+}
+
 int W_dir_dir::calculate_two_nu_max() const {
 
   int two_nu_max_Av = calculate_two_nu_max_Av();
@@ -112,19 +373,49 @@ vector<double> W_dir_dir::calculate_expansion_coefficients() {
   return exp_coef_Av;
 }
 
+void W_dir_dir::update_expansion_coefficients() {
+
+  const double delta_excitation = cascade_steps[0].first.delta;
+  const double delta_decay = cascade_steps[n_cascade_steps - 1].first.delta;
+
+  for (size_t i = 0; i < expansion_coefficients.size(); ++i) {
+    expansion_coefficients[i] =
+        av_coefficients_excitation[i](delta_excitation) *
+        av_coefficients_decay[i](delta_decay);
+    if (n_cascade_steps > 2) {
+      expansion_coefficients[i] *= uv_coefficient_products[i];
+    }
+    legendre_coefficients_float[i] =
+        static_cast<float>(normalization_factor * expansion_coefficients[i]);
+  }
+}
+
 vector<double> W_dir_dir::calculate_expansion_coefficients_Av() {
 
   vector<double> exp_coef;
 
+  // For an elastic two-step cascade with the same multipolarities in both
+  // transitions, the A_nu coefficients of the decay have the same arguments as
+  // the ones of the excitation, and their F coefficients are not calculated
+  // again.
+  const bool symmetric =
+      n_cascade_steps == 2 &&
+      cascade_steps[0].first.two_L == cascade_steps[1].first.two_L &&
+      cascade_steps[0].first.two_Lp == cascade_steps[1].first.two_Lp &&
+      initial_state.two_J == cascade_steps[1].second.two_J;
+
   for (int two_nu = 0; two_nu <= two_nu_max; two_nu += 4) {
     av_coefficients_excitation.push_back(AvCoefficient(
         two_nu, cascade_steps[0].first.two_L, cascade_steps[0].first.two_Lp,
         initial_state.two_J, cascade_steps[0].second.two_J));
     av_coefficients_decay.push_back(
-        AvCoefficient(two_nu, cascade_steps[n_cascade_steps - 1].first.two_L,
-                      cascade_steps[n_cascade_steps - 1].first.two_Lp,
-                      cascade_steps[n_cascade_steps - 1].second.two_J,
-                      cascade_steps[n_cascade_steps - 2].second.two_J));
+        symmetric
+            ? av_coefficients_excitation.back()
+            : AvCoefficient(two_nu,
+                            cascade_steps[n_cascade_steps - 1].first.two_L,
+                            cascade_steps[n_cascade_steps - 1].first.two_Lp,
+                            cascade_steps[n_cascade_steps - 1].second.two_J,
+                            cascade_steps[n_cascade_steps - 2].second.two_J));
     exp_coef.push_back(
         av_coefficients_excitation[two_nu / 4](cascade_steps[0].first.delta) *
         av_coefficients_decay[two_nu / 4](
@@ -158,6 +449,107 @@ vector<double> W_dir_dir::calculate_expansion_coefficients_Uv() {
   return exp_coef;
 }
 
+vector<double>
+W_dir_dir::calculate_expansion_coefficients(const vector<double> &deltas) const {
+
+  vector<double> exp_coef(av_coefficients_excitation.size(), 0.);
+
+  for (size_t i = 0; i < exp_coef.size(); ++i) {
+    exp_coef[i] = av_coefficients_excitation[i](deltas[0]) *
+                  av_coefficients_decay[i](deltas[n_cascade_steps - 1]);
+  }
+
+  if (n_cascade_steps > 2) {
+    const vector<double> uv_coef_products =
+        calculate_Uv_coefficient_products(deltas);
+
+    for (size_t i = 0; i < exp_coef.size(); ++i) {
+      exp_coef[i] *= uv_coef_products[i];
+    }
+  }
+
+  return exp_coef;
+}
+
+vector<double> W_dir_dir::calculate_Uv_coefficient_products(
+    const vector<double> &deltas) const {
+
+  vector<double> uv_coef_products(uv_coefficients.size(), 1.);
+
+  for (size_t i = 0; i < uv_coefficients.size(); ++i) {
+    for (size_t j = 0; j < uv_coefficients[i].size(); ++j) {
+      uv_coef_products[i] *= uv_coefficients[i][j](deltas[j + 1]);
+    }
+  }
+
+  return uv_coef_products;
+}
+
+vector<vector<double>> W_dir_dir::calculate_expansion_coefficient_derivatives(
+    const vector<double> &deltas) const {
+
+  const size_t n_coefficients = av_coefficients_excitation.size();
+  vector<vector<double>> derivatives(n_cascade_steps,
+                                     vector<double>(n_coefficients, 0.));
+
+  const vector<double> uv_coef_products =
+      n_cascade_steps > 2 ? calculate_Uv_coefficient_products(deltas)
+                          : vector<double>(n_coefficients, 1.);
+  const vector<vector<double>> uv_coef_product_derivatives =
+      calculate_Uv_coefficient_product_derivatives(deltas);
+
+  for (size_t i = 0; i < n_coefficients; ++i) {
+    const double av_excitation = av_coefficients_excitation[i](deltas[0]);
+    const double av_decay =
+        av_coefficients_decay[i](deltas[n_cascade_steps - 1]);
+
+    derivatives[0][i] = av_coefficients_excitation[i].derivative(deltas[0]) *
+                        av_decay * uv_coef_products[i];
+    derivatives[n_cascade_steps - 1][i] =
+        av_excitation *
+        av_coefficients_decay[i].derivative(deltas[n_cascade_steps - 1]) *
+        uv_coef_products[i];
+    for (size_t j = 1; j < n_cascade_steps - 1; ++j) {
+      derivatives[j][i] =
+          av_excitation * av_decay * uv_coef_product_derivatives[j][i];
+    }
+  }
+
+  return derivatives;
+}
+
+vector<vector<double>> W_dir_dir::calculate_Uv_coefficient_product_derivatives(
+    const vector<double> &deltas) const {
+
+  vector<vector<double>> derivatives(
+      n_cascade_steps, vector<double>(uv_coefficients.size(), 0.));
+
+  for (size_t i = 0; i < uv_coefficients.size(); ++i) {
+    for (size_t j = 0; j < uv_coefficients[i].size(); ++j) {
+      double derivative = uv_coefficients[i][j].derivative(deltas[j + 1]);
+      for (size_t l = 0; l < uv_coefficients[i].size(); ++l) {
+        if (l != j) {
+          derivative *= uv_coefficients[i][l](deltas[l + 1]);
+        }
+      }
+      derivatives[j + 1][i] = derivative;
+    }
+  }
+
+  return derivatives;
+}
+
+double W_dir_dir::calculate_normalization_factor(const vector<double> &deltas) {
+
+  double norm_fac = 1.;
+
+  for (auto delta : deltas) {
+    norm_fac = norm_fac / (1. + delta * delta);
+  }
+
+  return norm_fac;
+}
+
 double W_dir_dir::calculate_normalization_factor() const {
 
   double norm_fac = 1.;
@@ -169,13 +561,12 @@ double W_dir_dir::calculate_normalization_factor() const {
   return norm_fac;
 }
 
-string W_dir_dir::string_representation(const unsigned int n_digits,
-                                        vector<string> variable_names) const {
+void W_dir_dir::write_string_representation(
+    string &str_rep, const unsigned int n_digits,
+    const vector<string> &variable_names) const {
 
   const string polar_angle_variable =
       variable_names.size() ? variable_names[0] : "\\theta";
-  const string azimuthal_angle_variable =
-      variable_names.size() ? variable_names[1] : "\\varphi";
   vector<string> delta_variables;
   for (size_t i = 0; i < n_cascade_steps; ++i) {
     if (variable_names.size()) {
@@ -185,34 +576,32 @@ string W_dir_dir::string_representation(const unsigned int n_digits,
     }
   }
 
-  string str_rep;
-
   for (int i = 0; i <= nu_max / 2; ++i) {
     if (i > 0) {
       str_rep += "+";
     }
-    str_rep += "\\left[" +
-               av_coefficients_excitation[i].string_representation(
-                   n_digits, {delta_variables[0]}) +
-               "\\right]\\\\";
+    str_rep += "\\left[";
+    av_coefficients_excitation[i].write_string_representation(
+        str_rep, n_digits, delta_variables[0]);
+    str_rep += "\\right]\\\\";
     if (n_cascade_steps > 2) {
       for (size_t j = 0; j < uv_coefficients[i].size(); ++j) {
-        str_rep += "\\times\\left[" +
-                   uv_coefficients[i][j].string_representation(
-                       n_digits, {delta_variables[1 + j]}) +
-                   "\\right]\\\\";
+        str_rep += "\\times\\left[";
+        uv_coefficients[i][j].write_string_representation(
+            str_rep, n_digits, delta_variables[1 + j]);
+        str_rep += "\\right]\\\\";
       }
     }
-    str_rep += "\\times\\left[" +
-               av_coefficients_decay[i].string_representation(
-                   n_digits, {delta_variables[delta_variables.size() - 1]}) +
-               "\\right]\\\\" + "\\times P_{" + to_string(2 * i) +
-               "}\\left[\\cos\\left(" + polar_angle_variable +
-               "\\right)\\right]";
+    str_rep += "\\times\\left[";
+    av_coefficients_decay[i].write_string_representation(
+        str_rep, n_digits, delta_variables[delta_variables.size() - 1]);
+    str_rep += "\\right]\\\\\\times P_{";
+    str_rep += to_string(2 * i);
+    str_rep += "}\\left[\\cos\\left(";
+    str_rep += polar_angle_variable;
+    str_rep += "\\right)\\right]";
     if (i != nu_max / 2) {
       str_rep += "\\\\";
     }
   }
-
-  return str_rep;
 }
\ No newline at end of file
@@ -19,21 +19,99 @@
 
 #include <cmath>
 
+using std::cos;
+
+#include <memory>
+
+using std::make_shared;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <utility>
+
+using std::move;
+
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_sf.h>
 
+#include "Factorial.hh"
+#include "LegendreSeries.hh"
+#include "Profiler.hh"
 #include "W_pol_dir.hh"
 
 using std::min;
 
 W_pol_dir::W_pol_dir(const State &ini_sta,
                      const vector<pair<Transition, State>> cas_ste)
-    : W_gamma_gamma(ini_sta, cas_ste), w_dir_dir(W_dir_dir(ini_sta, cas_ste)) {
+    : W_pol_dir(ini_sta, cas_ste, make_shared<W_dir_dir>(ini_sta, cas_ste)) {}
 
-  two_nu_max = w_dir_dir.get_two_nu_max();
+W_pol_dir::W_pol_dir(const State &ini_sta,
+                     const vector<pair<Transition, State>> cas_ste,
+                     shared_ptr<W_dir_dir> w_dir)
+    : W_gamma_gamma(ini_sta, cas_ste), w_dir_dir(move(w_dir)) {
+
+  two_nu_max = w_dir_dir->get_two_nu_max();
   nu_max = two_nu_max / 2;
   expansion_coefficients = calculate_expansion_coefficients();
-  normalization_factor = w_dir_dir.get_normalization_factor();
+  normalization_factor = w_dir_dir->get_normalization_factor();
+
+  initialize_coefficients_float();
+}
+
+W_pol_dir::W_pol_dir(const State &ini_sta,
+                     const vector<pair<Transition, State>> cas_ste,
+                     const vector<double> &dir_dir_coefficient_values,
+                     const vector<double> &coefficient_values)
+    : W_gamma_gamma(ini_sta, cas_ste),
+      w_dir_dir(make_shared<W_dir_dir>(ini_sta, cas_ste,
+                                       dir_dir_coefficient_values)) {
+
+  two_nu_max = w_dir_dir->get_two_nu_max();
+  nu_max = two_nu_max / 2;
+  if (coefficient_values.size() != 6 * static_cast<size_t>(two_nu_max / 4)) {
+    throw invalid_argument("Number of coefficient values (" +
+                           to_string(coefficient_values.size()) +
+                           ") does not match the cascade (" +
+                           to_string(6 * (two_nu_max / 4)) + ").");
+  }
+
+  const vector<double> &uv_coef_products =
+      w_dir_dir->get_Uv_coefficient_products();
+  const double *values = coefficient_values.data();
+  for (int two_nu = 4; two_nu <= two_nu_max; two_nu += 4, values += 6) {
+    alphav_coefficients.push_back(AlphavCoefficient(
+        two_nu, cascade_steps[0].first.two_L, cascade_steps[0].first.two_Lp,
+        initial_state.two_J, cascade_steps[0].second.two_J,
+        {values[0], values[1], values[2]}, {values[3], values[4], values[5]}));
+    av_coefficients.push_back(
+        w_dir_dir->get_Av_coefficients_decay()[two_nu / 4]);
+    expansion_coefficients.push_back(
+        alphav_coefficients[two_nu / 4 - 1](cascade_steps[0].first.delta) *
+        av_coefficients[two_nu / 4 - 1](
+            cascade_steps[n_cascade_steps - 1].first.delta));
+    if (n_cascade_steps > 2) {
+      expansion_coefficients.back() *= uv_coef_products[two_nu / 4];
+    }
+  }
+  normalization_factor = w_dir_dir->get_normalization_factor();
+
+  initialize_coefficients_float();
+}
+
+vector<double> W_pol_dir::get_coefficient_values() const {
+  vector<double> values;
+
+  for (const auto &alphav_coefficient : alphav_coefficients) {
+    const array<double, 3> f_values = alphav_coefficient.get_f_values();
+    const array<double, 3> kappa_values =
+        alphav_coefficient.get_kappa_values();
+    values.insert(values.end(), f_values.begin(), f_values.end());
+    values.insert(values.end(), kappa_values.begin(), kappa_values.end());
+  }
+
+  return values;
 }
 
 double W_pol_dir::operator()(const double theta, const double phi) const {
@@ -45,29 +123,337 @@ double W_pol_dir::operator()(const double theta, const double phi) const {
                    gsl_sf_legendre_Plm(2 * i, 2, cos(theta));
   }
 
-  int polarization_sign = 1;
-  if (cascade_steps[0].first.em_charp == magnetic) {
-    polarization_sign = -1;
+  return (*w_dir_dir)(theta) + get_polarization_factor() * cos(2. * phi) *
+                                   sum_over_nu *
+                                   w_dir_dir->get_normalization_factor();
+}
+
+double W_pol_dir::operator()(const double theta, const double phi,
+                             const vector<double> &deltas) const {
+
+  check_deltas(deltas);
+
+  const vector<double> exp_coef = calculate_expansion_coefficients(deltas);
+
+  double sum_over_nu{0.};
+
+  for (int i = 1; i <= nu_max / 2; ++i) {
+    sum_over_nu += exp_coef[i - 1] * gsl_sf_legendre_Plm(2 * i, 2, cos(theta));
   }
 
-  return w_dir_dir(theta) + polarization_sign * cos(2. * phi) * sum_over_nu *
-                                w_dir_dir.get_normalization_factor();
+  return (*w_dir_dir)(theta, deltas) +
+         get_polarization_factor() * cos(2. * phi) * sum_over_nu *
+             W_dir_dir::calculate_normalization_factor(deltas);
+}
+
+void W_pol_dir::evaluate(const size_t n, const double *theta,
+                         const double *phi, double *result) const {
+
+  double cos_theta[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+
+    for (size_t k = 0; k < m; ++k) {
+      cos_theta[k] = cos(theta[start + k]);
+    }
+
+    evaluate_cos_theta(m, cos_theta, phi + start, result + start);
+  }
+}
+
+void W_pol_dir::evaluate_cos_theta(const size_t n, const double *cos_theta,
+                                   const double *phi, double *result) const {
+  evaluate_series_cos_theta(n, cos_theta, phi,
+                            w_dir_dir->get_expansion_coefficients(),
+                            expansion_coefficients, normalization_factor,
+                            result);
+}
+
+void W_pol_dir::evaluate_cos_theta_cos_2phi(const size_t n,
+                                            const double *cos_theta,
+                                            const double *cos_2phi,
+                                            double *result) const {
+
+  const double polarization_factor = get_polarization_factor();
+  const vector<double> &exp_coef_dir_dir =
+      w_dir_dir->get_expansion_coefficients();
+
+  double sum_over_nu[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+
+    legendre_series::legendre(m, cos_theta + start, nu_max / 2 + 1,
+                              exp_coef_dir_dir.data(), result + start);
+    legendre_series::associated_legendre_2(
+        m, cos_theta + start, nu_max / 2, expansion_coefficients.data(),
+        sum_over_nu);
+
+    for (size_t k = 0; k < m; ++k) {
+      result[start + k] =
+          (result[start + k] +
+           polarization_factor * cos_2phi[start + k] * sum_over_nu[k]) *
+          normalization_factor;
+    }
+  }
+}
+
+void W_pol_dir::evaluate_cos_theta(const size_t n, const float *cos_theta,
+                                   const float *phi, float *result) const {
+
+  float sum_over_nu[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+
+    legendre_series::legendre(m, cos_theta + start,
+                              legendre_coefficients_float.size(),
+                              legendre_coefficients_float.data(),
+                              result + start);
+    legendre_series::associated_legendre_2(
+        m, cos_theta + start, associated_legendre_coefficients_float.size(),
+        associated_legendre_coefficients_float.data(), sum_over_nu);
+
+    for (size_t k = 0; k < m; ++k) {
+      result[start + k] += cos(2.f * phi[start + k]) * sum_over_nu[k];
+    }
+  }
+}
+
+void W_pol_dir::evaluate_cos_theta(const size_t n, const double *cos_theta,
+                                   const double *phi,
+                                   const vector<double> &deltas,
+                                   double *result) const {
+
+  check_deltas(deltas);
+
+  evaluate_series_cos_theta(
+      n, cos_theta, phi, w_dir_dir->calculate_expansion_coefficients(deltas),
+      calculate_expansion_coefficients(deltas),
+      W_dir_dir::calculate_normalization_factor(deltas), result);
+}
+
+void W_pol_dir::evaluate_series_cos_theta(
+    const size_t n, const double *cos_theta, const double *phi,
+    const vector<double> &exp_coef_dir_dir, const vector<double> &exp_coef,
+    const double norm, double *result) const {
+
+  const double polarization_factor = get_polarization_factor();
+
+  double sum_over_nu[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+
+    legendre_series::legendre(m, cos_theta + start, nu_max / 2 + 1,
+                              exp_coef_dir_dir.data(), result + start);
+    legendre_series::associated_legendre_2(m, cos_theta + start, nu_max / 2,
+                                           exp_coef.data(), sum_over_nu);
+
+    for (size_t k = 0; k < m; ++k) {
+      result[start + k] =
+          (result[start + k] + polarization_factor * cos(2. * phi[start + k]) *
+                                   sum_over_nu[k]) *
+          norm;
+    }
+  }
+}
+
+void W_pol_dir::evaluate_attenuated_cos_theta(const size_t n,
+                                              const double *cos_theta,
+                                              const double *phi,
+                                              const double *attenuation,
+                                              double *result) const {
+
+  w_dir_dir->evaluate_attenuated_cos_theta(n, cos_theta, phi, attenuation,
+                                          result);
+
+  const double polarization_factor = get_polarization_factor();
+  vector<double> exp_coef(nu_max / 2);
+  for (size_t i = 0; i < exp_coef.size(); ++i) {
+    exp_coef[i] = polarization_factor * attenuation[i + 1] *
+                  expansion_coefficients[i] * normalization_factor;
+  }
+
+  double sum_over_nu[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+
+    legendre_series::associated_legendre_2(m, cos_theta + start,
+                                           exp_coef.size(), exp_coef.data(),
+                                           sum_over_nu);
+
+    for (size_t k = 0; k < m; ++k) {
+      result[start + k] += cos(2. * phi[start + k]) * sum_over_nu[k];
+    }
+  }
+}
+
+void W_pol_dir::evaluate_with_gradient(const size_t n, const double *theta,
+                                       const double *phi,
+                                       const vector<double> &deltas,
+                                       double *result, double *gradient) const {
+
+  w_dir_dir->evaluate_with_gradient(n, theta, phi, deltas, result, gradient);
+
+  const size_t n_coefficients = nu_max / 2;
+  const size_t row_length = n_cascade_steps + 2;
+  const double polarization_factor = get_polarization_factor();
+  const vector<double> exp_coef = calculate_expansion_coefficients(deltas);
+  const vector<vector<double>> exp_coef_derivatives =
+      calculate_expansion_coefficient_derivatives(deltas);
+  const double norm = W_dir_dir::calculate_normalization_factor(deltas);
+
+  double cos_theta[legendre_series::block_size],
+      sum_over_nu[legendre_series::block_size],
+      derivative[legendre_series::block_size],
+      angular_factor[legendre_series::block_size];
+
+  for (size_t start = 0; start < n; start += legendre_series::block_size) {
+    const size_t m = min(legendre_series::block_size, n - start);
+    double *gradient_block = gradient + start * row_length;
+
+    for (size_t k = 0; k < m; ++k) {
+      cos_theta[k] = cos(theta[start + k]);
+      angular_factor[k] = polarization_factor * norm * cos(2. * phi[start + k]);
+    }
+
+    legendre_series::associated_legendre_2(m, cos_theta, n_coefficients,
+                                           exp_coef.data(), sum_over_nu);
+    legendre_series::associated_legendre_2_derivative(
+        m, cos_theta, n_coefficients, exp_coef.data(), derivative);
+    for (size_t k = 0; k < m; ++k) {
+      result[start + k] += angular_factor[k] * sum_over_nu[k];
+      gradient_block[k * row_length] +=
+          -sin(theta[start + k]) * angular_factor[k] * derivative[k];
+      gradient_block[k * row_length + 1] = -2. * polarization_factor * norm *
+                                           sin(2. * phi[start + k]) *
+                                           sum_over_nu[k];
+    }
+
+    for (size_t j = 0; j < n_cascade_steps; ++j) {
+      const double d_log_norm = -2. * deltas[j] / (1. + deltas[j] * deltas[j]);
+      legendre_series::associated_legendre_2(m, cos_theta, n_coefficients,
+                                             exp_coef_derivatives[j].data(),
+                                             derivative);
+      for (size_t k = 0; k < m; ++k) {
+        gradient_block[k * row_length + 2 + j] +=
+            angular_factor[k] *
+            (derivative[k] + d_log_norm * sum_over_nu[k]);
+      }
+    }
+  }
 }
 
 double W_pol_dir::get_upper_limit() const {
+  ALPACA_PROFILE_SCOPE("W_pol_dir::get_upper_limit");
 
   double upper_limit = 0.;
 
-  double associated_Legendre_upper_limit_factor = 4. * pow(M_1_PI, 0.75);
+  // 4 pi^(-3/4)
+  constexpr double associated_Legendre_upper_limit_factor =
+      4. * 0.42377720812375763;
 
   for (int i = 1; i <= nu_max / 2; ++i) {
     upper_limit += fabs(expansion_coefficients[i - 1]) *
                    associated_Legendre_upper_limit_factor *
-                   sqrt(gsl_sf_fact(2 * i + 2) / gsl_sf_fact(2 * i - 2));
+                   sqrt(factorial::ratio(2 * i + 2, 2 * i - 2));
+  }
+
+  return w_dir_dir->get_upper_limit() +
+         fabs(polarization_degree) * upper_limit *
+             w_dir_dir->get_normalization_factor();
+}
+
+double W_pol_dir::get_maximum() const {
+  vector<double> exp_coef(expansion_coefficients);
+  for (auto &c : exp_coef) {
+    c *= polarization_degree;
+  }
+
+  return fabs(normalization_factor) *
+         legendre_series::maximum(
+             nu_max / 2 + 1, w_dir_dir->get_expansion_coefficients().data(),
+             nu_max / 2, exp_coef.data());
+}
+
+void W_pol_dir::set_delta(const size_t step, const double delta) {
+
+  if (w_dir_dir.use_count() > 1) {
+    w_dir_dir = make_shared<W_dir_dir>(*w_dir_dir);
+  }
+  w_dir_dir->set_delta(step, delta);
+  set_cascade_step_delta(step, delta);
+  normalization_factor = w_dir_dir->get_normalization_factor();
+
+  const double delta_excitation = cascade_steps[0].first.delta;
+  const double delta_decay = cascade_steps[n_cascade_steps - 1].first.delta;
+  const vector<double> &uv_coef_products =
+      w_dir_dir->get_Uv_coefficient_products();
+  const double polarization_factor = get_polarization_factor();
+
+  for (size_t i = 0; i < alphav_coefficients.size(); ++i) {
+    expansion_coefficients[i] = alphav_coefficients[i](delta_excitation) *
+                                av_coefficients[i](delta_decay);
+    if (n_cascade_steps > 2) {
+      expansion_coefficients[i] *= uv_coef_products[i + 1];
+    }
+    associated_legendre_coefficients_float[i] = static_cast<float>(
+        polarization_factor * normalization_factor * expansion_coefficients[i]);
+  }
+
+  const vector<double> &dir_dir_expansion_coefficients =
+      w_dir_dir->get_expansion_coefficients();
+  for (size_t i = 0; i < legendre_coefficients_float.size(); ++i) {
+    legendre_coefficients_float[i] = static_cast<float>(
+        normalization_factor * dir_dir_expansion_coefficients[i]);
+  }
+}
+
+void W_pol_dir::set_polarization_degree(const double P) {
+
+  if (!(fabs(P) <= 1.)) {
+    throw invalid_argument(
+        "The degree of polarization must be in the range [-1, 1].");
   }
+  polarization_degree = P;
+
+  initialize_coefficients_float();
+}
+
+double W_pol_dir::get_polarization_factor() const {
+  return (cascade_steps[0].first.em_charp == magnetic ? -1. : 1.) *
+         polarization_degree;
+}
+
+void W_pol_dir::initialize_coefficients_float() {
+  const vector<double> legendre_coefficients = get_legendre_coefficients();
+  legendre_coefficients_float.assign(legendre_coefficients.begin(),
+                                     legendre_coefficients.end());
+  const vector<double> associated_legendre_coefficients =
+      get_associated_legendre_coefficients();
+  associated_legendre_coefficients_float.assign(
+      associated_legendre_coefficients.begin(),
+      associated_legendre_coefficients.end());
+}
 
-  return w_dir_dir.get_upper_limit() +
-         upper_limit * w_dir_dir.get_normalization_factor();
+vector<double> W_pol_dir::get_legendre_coefficients() const {
+  return w_dir_dir->get_legendre_coefficients();
+}
+
+vector<double> W_pol_dir::get_associated_legendre_coefficients() const {
+
+  const double polarization_factor = get_polarization_factor();
+
+  vector<double> coefficients(nu_max / 2);
+  for (size_t i = 0; i < coefficients.size(); ++i) {
+    coefficients[i] =
+        polarization_factor * normalization_factor * expansion_coefficients[i];
+  }
+
+  return coefficients;
 }
 
 vector<double> W_pol_dir::calculate_expansion_coefficients() {
@@ -76,8 +462,8 @@ vector<double> W_pol_dir::calculate_expansion_coefficients() {
       calculate_expansion_coefficients_alphav_Av();
 
   if (n_cascade_steps > 2) {
-    vector<double> exp_coef_Uv = w_dir_dir.get_Uv_coefficient_products();
-    vector<double> exp_coef(exp_coef_Uv.size(), 0.);
+    vector<double> exp_coef_Uv = w_dir_dir->get_Uv_coefficient_products();
+    vector<double> exp_coef(exp_coef_Uv.size() - 1, 0.);
 
     for (size_t i = 1; i < exp_coef_Uv.size(); ++i) {
       exp_coef[i - 1] = exp_coef_alphav_Av[i - 1] * exp_coef_Uv[i];
@@ -94,14 +480,17 @@ vector<double> W_pol_dir::calculate_expansion_coefficients_alphav_Av() {
   vector<double> exp_coef;
 
   for (int two_nu = 4; two_nu <= two_nu_max; two_nu += 4) {
+    // The F coefficient with L of the first transition was already calculated
+    // for the A_nu coefficients of the dir-dir correlation.
     alphav_coefficients.push_back(AlphavCoefficient(
         two_nu, cascade_steps[0].first.two_L, cascade_steps[0].first.two_Lp,
-        initial_state.two_J, cascade_steps[0].second.two_J));
+        initial_state.two_J, cascade_steps[0].second.two_J,
+        w_dir_dir->get_Av_coefficients_excitation()[two_nu / 4]
+            .get_constant_f_value()));
+    // The A_nu coefficients of the last transition are the same as for the
+    // dir-dir correlation.
     av_coefficients.push_back(
-        AvCoefficient(two_nu, cascade_steps[n_cascade_steps - 1].first.two_L,
-                      cascade_steps[n_cascade_steps - 1].first.two_Lp,
-                      cascade_steps[n_cascade_steps - 1].second.two_J,
-                      cascade_steps[n_cascade_steps - 2].second.two_J));
+        w_dir_dir->get_Av_coefficients_decay()[two_nu / 4]);
     exp_coef.push_back(
         alphav_coefficients[two_nu / 4 - 1](cascade_steps[0].first.delta) *
         av_coefficients[two_nu / 4 - 1](
@@ -111,8 +500,63 @@ vector<double> W_pol_dir::calculate_expansion_coefficients_alphav_Av() {
   return exp_coef;
 }
 
-string W_pol_dir::string_representation(const unsigned int n_digits,
-                                        vector<string> variable_names) const {
+vector<double>
+W_pol_dir::calculate_expansion_coefficients(const vector<double> &deltas) const {
+
+  vector<double> exp_coef(alphav_coefficients.size(), 0.);
+
+  for (size_t i = 0; i < exp_coef.size(); ++i) {
+    exp_coef[i] = alphav_coefficients[i](deltas[0]) *
+                  av_coefficients[i](deltas[n_cascade_steps - 1]);
+  }
+
+  if (n_cascade_steps > 2) {
+    const vector<double> uv_coef_products =
+        w_dir_dir->calculate_Uv_coefficient_products(deltas);
+
+    for (size_t i = 0; i < exp_coef.size(); ++i) {
+      exp_coef[i] *= uv_coef_products[i + 1];
+    }
+  }
+
+  return exp_coef;
+}
+
+vector<vector<double>> W_pol_dir::calculate_expansion_coefficient_derivatives(
+    const vector<double> &deltas) const {
+
+  const size_t n_coefficients = alphav_coefficients.size();
+  vector<vector<double>> derivatives(n_cascade_steps,
+                                     vector<double>(n_coefficients, 0.));
+
+  vector<double> uv_coef_products(n_coefficients + 1, 1.);
+  if (n_cascade_steps > 2) {
+    uv_coef_products = w_dir_dir->calculate_Uv_coefficient_products(deltas);
+  }
+  const vector<vector<double>> uv_coef_product_derivatives =
+      w_dir_dir->calculate_Uv_coefficient_product_derivatives(deltas);
+
+  for (size_t i = 0; i < n_coefficients; ++i) {
+    const double alphav = alphav_coefficients[i](deltas[0]);
+    const double av = av_coefficients[i](deltas[n_cascade_steps - 1]);
+
+    derivatives[0][i] = alphav_coefficients[i].derivative(deltas[0]) * av *
+                        uv_coef_products[i + 1];
+    derivatives[n_cascade_steps - 1][i] =
+        alphav * av_coefficients[i].derivative(deltas[n_cascade_steps - 1]) *
+        uv_coef_products[i + 1];
+    for (size_t j = 1; j < n_cascade_steps - 1; ++j) {
+      derivatives[j][i] =
+          alphav * av * uv_coef_product_derivatives[j][i + 1];
+    }
+  }
+
+  return derivatives;
+}
+
+void W_pol_dir::write_string_representation(
+    string &str_rep, const unsigned int n_digits,
+    const vector<string> &variable_names) const {
 
   const string polar_angle_variable =
       variable_names.size() ? variable_names[0] : "\\theta";
@@ -127,43 +571,51 @@ string W_pol_dir::string_representation(const unsigned int n_digits,
     }
   }
 
-  const vector<vector<UvCoefficient>> uv_coefficients =
-      w_dir_dir.get_Uv_coefficients();
-
-  string str_rep =
-      w_dir_dir.string_representation(n_digits, variable_names) + "\\\\";
-  str_rep += cascade_steps[0].first.em_charp == magnetic ? "+" : "-";
-  str_rep += "\\cos\\left(2" + azimuthal_angle_variable +
-             "\\right)\\left\\{\\right.\\\\";
+  const vector<vector<UvCoefficient>> &uv_coefficients =
+      w_dir_dir->get_Uv_coefficients();
+
+  w_dir_dir->write_string_representation(str_rep, n_digits, variable_names);
+  str_rep += "\\\\";
+  str_rep += (cascade_steps[0].first.em_charp == magnetic) !=
+                     (polarization_degree < 0.)
+                 ? "+"
+                 : "-";
+  if (fabs(polarization_degree) != 1.) {
+    write_float_string_representation(str_rep, n_digits,
+                                      fabs(polarization_degree));
+  }
+  str_rep += "\\cos\\left(2";
+  str_rep += azimuthal_angle_variable;
+  str_rep += "\\right)\\left\\{\\right.\\\\";
 
   for (int i = 1; i <= nu_max / 2; ++i) {
     if (i > 1) {
       str_rep += "+";
     }
 
-    str_rep += "\\left[" +
-               alphav_coefficients[i - 1].string_representation(
-                   n_digits, {delta_variables[0]}) +
-               "\\right]\\\\";
+    str_rep += "\\left[";
+    alphav_coefficients[i - 1].write_string_representation(
+        str_rep, n_digits, delta_variables[0]);
+    str_rep += "\\right]\\\\";
     if (n_cascade_steps > 2) {
       for (size_t j = 0; j < uv_coefficients[i].size(); ++j) {
-        str_rep += "\\times\\left[" +
-                   uv_coefficients[i][j].string_representation(
-                       n_digits, {delta_variables[1 + j]}) +
-                   "\\right]\\\\";
+        str_rep += "\\times\\left[";
+        uv_coefficients[i][j].write_string_representation(
+            str_rep, n_digits, delta_variables[1 + j]);
+        str_rep += "\\right]\\\\";
       }
     }
-    str_rep += "\\times\\left[" +
-               av_coefficients[i - 1].string_representation(
-                   n_digits, {delta_variables[delta_variables.size() - 1]}) +
-               "\\right]\\\\\\times P_{" + to_string(2 * i) +
-               "}^{\\left|2\\right|}\\left[\\cos\\left(" +
-               polar_angle_variable + "\\right)\\right]";
+    str_rep += "\\times\\left[";
+    av_coefficients[i - 1].write_string_representation(
+        str_rep, n_digits, delta_variables[delta_variables.size() - 1]);
+    str_rep += "\\right]\\\\\\times P_{";
+    str_rep += to_string(2 * i);
+    str_rep += "}^{\\left|2\\right|}\\left[\\cos\\left(";
+    str_rep += polar_angle_variable;
+    str_rep += "\\right)\\right]";
     if (i != nu_max / 2) {
       str_rep += "\\\\";
     }
   }
   str_rep += "\\left.\\right\\}";
-
-  return str_rep;
 }
\ No newline at end of file
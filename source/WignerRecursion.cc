@@ -0,0 +1,260 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <cmath>
+
+using std::abs;
+using std::sqrt;
+
+#include <cstdlib>
+
+#include "WignerRecursion.hh"
+
+double WignerSymbolSequence::operator()(const int two_j1) const {
+  if (two_j1 < two_j1_min || two_j1 > two_j1_max ||
+      (two_j1 - two_j1_min) % 2) {
+    return 0.;
+  }
+  return values[(two_j1 - two_j1_min) / 2];
+}
+
+namespace {
+
+// Threshold for a rescaling of the recursion to avoid an overflow in the
+// classically forbidden regions.
+constexpr double large = 1e100;
+
+void rescale(vector<double> &f, const size_t begin, const size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    f[i] /= large;
+  }
+}
+
+/*
+    Solve the recurrence relation
+
+        X(j) f(j+1) + Y(j) f(j) + Z(j) f(j-1) = 0
+
+    for j = j_min, ..., j_max, where Z(j_min) = 0 and X(j_max) = 0.
+    If X(j_min) vanishes as well, which happens for j_min = 0, the ratio
+    f(j_min + 1) / f(j_min) must be given as ratio_0.
+    The result is not normalized.
+*/
+template <typename X, typename Y, typename Z>
+vector<double> solve_recurrence(const double j_min, const size_t n, X x, Y y,
+                                Z z, const double ratio_0) {
+  vector<double> f(n, 0.);
+  f[0] = 1.;
+  if (n == 1) {
+    return f;
+  }
+
+  // Forward recursion, as long as the magnitude grows.
+  const double x_0 = x(j_min);
+  f[1] = x_0 != 0. ? -y(j_min) / x_0 : ratio_0;
+  size_t i_forward = 1;
+  while (i_forward + 1 < n && abs(f[i_forward]) >= abs(f[i_forward - 1])) {
+    const double j = j_min + i_forward;
+    f[i_forward + 1] =
+        -(y(j) * f[i_forward] + z(j) * f[i_forward - 1]) / x(j);
+    ++i_forward;
+    if (abs(f[i_forward]) > large) {
+      rescale(f, 0, i_forward + 1);
+    }
+  }
+
+  // Backward recursion, as long as the magnitude grows.
+  // Uses a separate array, since both parts overlap in general.
+  vector<double> g(n, 0.);
+  const double j_max = j_min + (n - 1);
+  g[n - 1] = 1.;
+  g[n - 2] = -y(j_max) / z(j_max);
+  size_t i_backward = n - 2;
+  while (i_backward > 0 && abs(g[i_backward]) >= abs(g[i_backward + 1])) {
+    const double j = j_min + i_backward;
+    g[i_backward - 1] =
+        -(y(j) * g[i_backward] + x(j) * g[i_backward + 1]) / z(j);
+    --i_backward;
+    if (abs(g[i_backward]) > large) {
+      rescale(g, i_backward, n);
+    }
+  }
+
+  // In the classically allowed region, the recursion is stable in both
+  // directions. Continue the forward recursion until both parts overlap by
+  // at least two values.
+  const size_t i_end = min(n - 1, max(i_forward, i_backward + 1));
+  for (size_t i = i_forward; i < i_end; ++i) {
+    const double j = j_min + i;
+    f[i + 1] = -(y(j) * f[i] + z(j) * f[i - 1]) / x(j);
+  }
+
+  // Least-squares fit of the scaling factor in the overlap region, which is
+  // insensitive to accidental zeros of the symbols.
+  double sum_fg = 0., sum_gg = 0.;
+  for (size_t i = i_backward; i <= i_end; ++i) {
+    sum_fg += f[i] * g[i];
+    sum_gg += g[i] * g[i];
+  }
+  const double lambda = sum_fg / sum_gg;
+  for (size_t i = i_backward; i < n; ++i) {
+    f[i] = lambda * g[i];
+  }
+
+  return f;
+}
+
+/*
+    Normalize a sequence with the orthogonality relation
+
+        sum_j (2j + 1) f(j)^2 = 1 / weight
+
+    and set the sign of the last element.
+*/
+void normalize(const double j_min, vector<double> &f, const double weight,
+               const bool last_is_positive) {
+  double sum = 0.;
+  for (size_t i = 0; i < f.size(); ++i) {
+    sum += (2. * (j_min + i) + 1.) * f[i] * f[i];
+  }
+  double norm = 1. / sqrt(weight * sum);
+  if ((f.back() > 0.) != last_is_positive) {
+    norm = -norm;
+  }
+  for (auto &value : f) {
+    value *= norm;
+  }
+}
+
+bool is_even(const int two_j) { return two_j % 4 == 0; }
+
+WignerSymbolSequence empty_sequence() { return {0, -2, {}}; }
+
+} // namespace
+
+namespace wigner_recursion {
+
+WignerSymbolSequence coupling_3j_sequence(const int two_j2, const int two_j3,
+                                          const int two_m2, const int two_m3) {
+  const int two_m1 = -two_m2 - two_m3;
+  if (two_j2 < 0 || two_j3 < 0 || abs(two_m2) > two_j2 ||
+      abs(two_m3) > two_j3 || (two_j2 + two_m2) % 2 ||
+      (two_j3 + two_m3) % 2) {
+    return empty_sequence();
+  }
+
+  WignerSymbolSequence sequence;
+  sequence.two_j1_min = max(abs(two_j2 - two_j3), abs(two_m1));
+  sequence.two_j1_max = two_j2 + two_j3;
+  // Both limits have the parity of two_j2 + two_j3.
+  if (sequence.two_j1_min > sequence.two_j1_max) {
+    return empty_sequence();
+  }
+
+  const double j2 = 0.5 * two_j2, j3 = 0.5 * two_j3, m1 = 0.5 * two_m1,
+               m2 = 0.5 * two_m2, m3 = 0.5 * two_m3;
+  const double j_min = 0.5 * sequence.two_j1_min;
+  const size_t n = (sequence.two_j1_max - sequence.two_j1_min) / 2 + 1;
+
+  const auto a = [&](const double j1) {
+    return sqrt((j1 * j1 - (j2 - j3) * (j2 - j3)) *
+                ((j2 + j3 + 1.) * (j2 + j3 + 1.) - j1 * j1) *
+                (j1 * j1 - m1 * m1));
+  };
+  const auto x = [&](const double j1) { return j1 * a(j1 + 1.); };
+  const auto y = [&](const double j1) {
+    return -(2. * j1 + 1.) * (j2 * (j2 + 1.) * m1 - j3 * (j3 + 1.) * m1 -
+                              j1 * (j1 + 1.) * (m3 - m2));
+  };
+  const auto z = [&](const double j1) { return (j1 + 1.) * a(j1); };
+
+  // For j1_min = 0 (i.e. j2 = j3 and m1 = 0), use the ratio of the closed
+  // expressions for j1 = 0 and j1 = 1.
+  const double ratio_0 = j2 > 0. ? m2 / sqrt(j2 * (j2 + 1.)) : 0.;
+
+  sequence.values = solve_recurrence(j_min, n, x, y, z, ratio_0);
+  normalize(j_min, sequence.values, 1.,
+            is_even(two_j2 - two_j3 - two_m1));
+
+  return sequence;
+}
+
+WignerSymbolSequence coupling_6j_sequence(const int two_j2, const int two_j3,
+                                          const int two_l1, const int two_l2,
+                                          const int two_l3) {
+  // Triangle conditions that do not involve j1.
+  const auto triangle = [](const int two_a, const int two_b, const int two_c) {
+    return two_a >= 0 && two_b >= 0 && two_c >= 0 &&
+           (two_a + two_b + two_c) % 2 == 0 && two_c >= abs(two_a - two_b) &&
+           two_c <= two_a + two_b;
+  };
+  if (!triangle(two_l1, two_j2, two_l3) || !triangle(two_l1, two_l2, two_j3) ||
+      (two_j2 + two_j3 + two_l2 + two_l3) % 2) {
+    return empty_sequence();
+  }
+
+  WignerSymbolSequence sequence;
+  sequence.two_j1_min = max(abs(two_j2 - two_j3), abs(two_l2 - two_l3));
+  sequence.two_j1_max = min(two_j2 + two_j3, two_l2 + two_l3);
+  if (sequence.two_j1_min > sequence.two_j1_max) {
+    return empty_sequence();
+  }
+
+  const double j2 = 0.5 * two_j2, j3 = 0.5 * two_j3, l1 = 0.5 * two_l1,
+               l2 = 0.5 * two_l2, l3 = 0.5 * two_l3;
+  const double j_min = 0.5 * sequence.two_j1_min;
+  const size_t n = (sequence.two_j1_max - sequence.two_j1_min) / 2 + 1;
+
+  const auto e = [&](const double j1) {
+    return sqrt((j1 * j1 - (j2 - j3) * (j2 - j3)) *
+                ((j2 + j3 + 1.) * (j2 + j3 + 1.) - j1 * j1) *
+                (j1 * j1 - (l2 - l3) * (l2 - l3)) *
+                ((l2 + l3 + 1.) * (l2 + l3 + 1.) - j1 * j1));
+  };
+  const auto x = [&](const double j1) { return j1 * e(j1 + 1.); };
+  const auto y = [&](const double j1) {
+    const double jj1 = j1 * (j1 + 1.), jj2 = j2 * (j2 + 1.),
+                 jj3 = j3 * (j3 + 1.), ll1 = l1 * (l1 + 1.),
+                 ll2 = l2 * (l2 + 1.), ll3 = l3 * (l3 + 1.);
+    return (2. * j1 + 1.) * (jj1 * (-jj1 + jj2 + jj3 - 2. * ll1) +
+                             ll2 * (jj1 + jj2 - jj3) + ll3 * (jj1 - jj2 + jj3));
+  };
+  const auto z = [&](const double j1) { return (j1 + 1.) * e(j1); };
+
+  // For j1_min = 0 (i.e. j2 = j3 and l2 = l3), use the ratio of the closed
+  // expressions for j1 = 0 and j1 = 1.
+  const double ratio_0 =
+      j2 > 0. && l2 > 0.
+          ? -(l2 * (l2 + 1.) + j2 * (j2 + 1.) - l1 * (l1 + 1.)) /
+                (2. * sqrt(l2 * (l2 + 1.) * j2 * (j2 + 1.)))
+          : 0.;
+
+  sequence.values = solve_recurrence(j_min, n, x, y, z, ratio_0);
+  normalize(j_min, sequence.values, two_l1 + 1.,
+            is_even(two_j2 + two_j3 + two_l2 + two_l3));
+
+  return sequence;
+}
+
+} // namespace wigner_recursion
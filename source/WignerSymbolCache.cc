@@ -0,0 +1,209 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <functional>
+
+using std::hash;
+
+#include <mutex>
+
+using std::lock_guard;
+using std::mutex;
+
+#include <unordered_map>
+
+using std::unordered_map;
+
+#include <gsl/gsl_sf.h>
+
+#include "Profiler.hh"
+#include "WignerRecursion.hh"
+#include "WignerSymbolCache.hh"
+
+namespace {
+
+typedef array<int, 6> WignerSymbolKey;
+
+struct WignerSymbolKeyHash {
+  size_t operator()(const WignerSymbolKey &key) const {
+    size_t seed = 0;
+    for (auto k : key) {
+      seed ^= hash<int>{}(k) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+  }
+};
+
+typedef unordered_map<WignerSymbolKey, double, WignerSymbolKeyHash>
+    WignerSymbolTable;
+
+/*
+    Function-local statics avoid problems with the initialization order of
+    static objects in different translation units, since coefficients may be
+    constructed during static initialization of user code.
+*/
+struct WignerSymbolTables {
+  mutex table_mutex;
+  WignerSymbolTable table_3j;
+  WignerSymbolTable table_6j;
+  size_t max_size = 1 << 20;
+  WignerSymbolBackend backend = recursion_backend;
+  size_t hits = 0;
+  size_t misses = 0;
+};
+
+WignerSymbolTables &tables() {
+  static WignerSymbolTables wigner_symbol_tables;
+  return wigner_symbol_tables;
+}
+
+/*
+    calculate() returns the value of a single symbol, calculate_sequence() a
+    WignerSymbolSequence in the first argument.
+*/
+template <typename F, typename S>
+double look_up(WignerSymbolTable WignerSymbolTables::*table,
+               const WignerSymbolKey &key, F calculate, S calculate_sequence) {
+  WignerSymbolTables &tab = tables();
+  WignerSymbolBackend backend;
+  {
+    lock_guard<mutex> lock(tab.table_mutex);
+    const auto entry = (tab.*table).find(key);
+    if (entry != (tab.*table).end()) {
+      ++tab.hits;
+      return entry->second;
+    }
+    ++tab.misses;
+    backend = tab.backend;
+  }
+
+  // The calculation is reentrant, so the lock can be released.
+  if (backend == gsl_backend) {
+    const double value = calculate();
+
+    lock_guard<mutex> lock(tab.table_mutex);
+    if ((tab.*table).size() < tab.max_size) {
+      (tab.*table).emplace(key, value);
+    }
+
+    return value;
+  }
+
+  const WignerSymbolSequence sequence = calculate_sequence();
+
+  lock_guard<mutex> lock(tab.table_mutex);
+  WignerSymbolKey sequence_key = key;
+  for (size_t i = 0;
+       i < sequence.values.size() && (tab.*table).size() < tab.max_size;
+       ++i) {
+    sequence_key[0] = sequence.two_j1_min + 2 * static_cast<int>(i);
+    (tab.*table).emplace(sequence_key, sequence.values[i]);
+  }
+
+  return sequence(key[0]);
+}
+
+} // namespace
+
+double WignerSymbolCache::coupling_3j(const int two_ja, const int two_jb,
+                                      const int two_jc, const int two_ma,
+                                      const int two_mb, const int two_mc) {
+  return look_up(&WignerSymbolTables::table_3j,
+                 {two_ja, two_jb, two_jc, two_ma, two_mb, two_mc}, [&]() {
+                   ALPACA_PROFILE_SCOPE("gsl_sf_coupling_3j");
+                   return gsl_sf_coupling_3j(two_ja, two_jb, two_jc, two_ma,
+                                             two_mb, two_mc);
+                 },
+                 [&]() {
+                   ALPACA_PROFILE_SCOPE("wigner_recursion::coupling_3j");
+                   if (two_ma + two_mb + two_mc != 0) {
+                     return WignerSymbolSequence{0, -2, {}};
+                   }
+                   return wigner_recursion::coupling_3j_sequence(
+                       two_jb, two_jc, two_mb, two_mc);
+                 });
+}
+
+double WignerSymbolCache::coupling_6j(const int two_ja, const int two_jb,
+                                      const int two_jc, const int two_jd,
+                                      const int two_je, const int two_jf) {
+  return look_up(&WignerSymbolTables::table_6j,
+                 {two_ja, two_jb, two_jc, two_jd, two_je, two_jf}, [&]() {
+                   ALPACA_PROFILE_SCOPE("gsl_sf_coupling_6j");
+                   return gsl_sf_coupling_6j(two_ja, two_jb, two_jc, two_jd,
+                                             two_je, two_jf);
+                 },
+                 [&]() {
+                   ALPACA_PROFILE_SCOPE("wigner_recursion::coupling_6j");
+                   return wigner_recursion::coupling_6j_sequence(
+                       two_jb, two_jc, two_jd, two_je, two_jf);
+                 });
+}
+
+size_t WignerSymbolCache::get_hits() {
+  lock_guard<mutex> lock(tables().table_mutex);
+  return tables().hits;
+}
+
+size_t WignerSymbolCache::get_misses() {
+  lock_guard<mutex> lock(tables().table_mutex);
+  return tables().misses;
+}
+
+size_t WignerSymbolCache::size() {
+  lock_guard<mutex> lock(tables().table_mutex);
+  return tables().table_3j.size() + tables().table_6j.size();
+}
+
+size_t WignerSymbolCache::get_max_size() {
+  lock_guard<mutex> lock(tables().table_mutex);
+  return tables().max_size;
+}
+
+void WignerSymbolCache::set_max_size(const size_t max_size) {
+  lock_guard<mutex> lock(tables().table_mutex);
+  tables().max_size = max_size;
+  if (tables().table_3j.size() > max_size ||
+      tables().table_6j.size() > max_size) {
+    tables().table_3j.clear();
+    tables().table_6j.clear();
+  }
+}
+
+WignerSymbolBackend WignerSymbolCache::get_backend() {
+  lock_guard<mutex> lock(tables().table_mutex);
+  return tables().backend;
+}
+
+void WignerSymbolCache::set_backend(const WignerSymbolBackend backend) {
+  lock_guard<mutex> lock(tables().table_mutex);
+  tables().backend = backend;
+}
+
+void WignerSymbolCache::clear() {
+  lock_guard<mutex> lock(tables().table_mutex);
+  tables().table_3j.clear();
+  tables().table_6j.clear();
+  tables().hits = 0;
+  tables().misses = 0;
+}
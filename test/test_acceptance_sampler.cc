@@ -0,0 +1,341 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <memory>
+
+using std::make_shared;
+using std::shared_ptr;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+using std::runtime_error;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AcceptanceSampler.hh"
+#include "AngCorrRejectionSampler.hh"
+#include "AngularCorrelation.hh"
+#include "CascadeSampler.hh"
+#include "DirDirInverseTransformSampler.hh"
+#include "EulerAngleRotation.hh"
+#include "SpotlightSampler.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+const vector<array<double, 2>> theta_phi{
+    {0.5 * M_PI, 0.}, {0.5 * M_PI, 0.5 * M_PI}, {0.4, 2.}};
+const vector<double> opening_angles{0.3, 0.4, 0.2};
+
+/**
+ * Unit vector in the direction of the polar angle theta and the azimuthal
+ * angle phi.
+ */
+array<double, 3> unit_vector(const array<double, 2> theta_phi) {
+  return {sin(theta_phi[0]) * cos(theta_phi[1]),
+          sin(theta_phi[0]) * sin(theta_phi[1]), cos(theta_phi[0])};
+}
+
+/**
+ * Index of the cone that contains a direction, or the number of cones if
+ * the direction is outside the acceptance.
+ */
+size_t find_cone(const array<double, 3> &direction) {
+  for (size_t c = 0; c < theta_phi.size(); ++c) {
+    const array<double, 3> axis = unit_vector(theta_phi[c]);
+    const double cos_angle = axis[0] * direction[0] + axis[1] * direction[1] +
+                             axis[2] * direction[2];
+    if (acos(max(-1., min(1., cos_angle))) <= opening_angles[c] + 1e-12) {
+      return c;
+    }
+  }
+  return theta_phi.size();
+}
+
+/**
+ * Integral of an angular correlation over a cone in the laboratory frame,
+ * if the reference frame of the correlation is given by the rotation A.
+ */
+double integrate_cone(const AngularCorrelation &ang_cor,
+                      const euler_angle_transform::RotationMatrix &A,
+                      const array<double, 2> theta_phi,
+                      const double opening_angle) {
+  const array<double, 3> local_axis = euler_angle_transform::apply(
+      euler_angle_transform::transpose(A), unit_vector(theta_phi));
+  return ang_cor.integrate_cone(
+      {acos(max(-1., min(1., local_axis[2]))),
+       atan2(local_axis[1], local_axis[0])},
+      opening_angle);
+}
+
+int main() {
+  // A dir-dir correlation for the first step, and a pol-dir correlation,
+  // which depends on the azimuthal angle, for the second step.
+  const AngularCorrelation dir_dir(
+      State(0, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.), State(2, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, 0.),
+        State(0, parity_unknown)}});
+  const AngularCorrelation pol_dir(
+      State(0, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.), State(2, positive)},
+       {Transition(magnetic, 2, electric, 4, 0.), State(0, positive)}});
+  const double total_integral =
+      4. * M_PI * pol_dir.get_legendre_coefficients()[0];
+
+  // The weight is the sum of the integrals over the cones in the frame of
+  // the previous step, divided by the integral over the full sphere.
+  AcceptanceSampler acceptance_sampler(pol_dir, theta_phi, opening_angles, 0);
+  assert(acceptance_sampler.get_n_cones() == 3);
+  const euler_angle_transform::RotationMatrix identity =
+      euler_angle_transform::rotation_matrix({0., 0., 0.});
+  const euler_angle_transform::RotationMatrix A_previous =
+      euler_angle_transform::rotation_matrix({0.3, 1.2, -0.7});
+  vector<double> integrals(3);
+  double sum = 0., sum_identity = 0.;
+  for (size_t c = 0; c < 3; ++c) {
+    integrals[c] =
+        integrate_cone(pol_dir, A_previous, theta_phi[c], opening_angles[c]);
+    sum += integrals[c];
+    sum_identity += pol_dir.integrate_cone(theta_phi[c], opening_angles[c]);
+  }
+  test_numerical_equality<double>(
+      acceptance_sampler.get_acceptance_probability(identity),
+      sum_identity / total_integral, 1e-12);
+  test_numerical_equality<double>(
+      acceptance_sampler.get_acceptance_probability(A_previous),
+      sum / total_integral, 1e-12);
+
+  // All sampled directions are inside the acceptance. The fraction of the
+  // directions in each cone, and in a smaller cone inside the first one
+  // which is not centered on its axis, are the ratios of the integrals.
+  const size_t n = 100000;
+  const array<double, 2> theta_phi_inner{0.5 * M_PI + 0.15, 0.};
+  const double opening_angle_inner = 0.1;
+  const array<double, 3> axis_inner = unit_vector(theta_phi_inner);
+  vector<double> fractions(3, 0.);
+  double fraction_inner = 0.;
+  for (size_t k = 0; k < n; ++k) {
+    const pair<double, euler_angle_transform::RotationMatrix> w_R =
+        acceptance_sampler(A_previous);
+    test_numerical_equality<double>(w_R.first, sum / total_integral, 1e-12);
+    const array<double, 3> direction = euler_angle_transform::direction(
+        euler_angle_transform::multiply(A_previous, w_R.second));
+    const size_t c = find_cone(direction);
+    assert(c < 3);
+    fractions[c] += 1. / n;
+    if (acos(max(-1., min(1., axis_inner[0] * direction[0] +
+                                  axis_inner[1] * direction[1] +
+                                  axis_inner[2] * direction[2]))) <=
+        opening_angle_inner) {
+      fraction_inner += 1. / n;
+    }
+  }
+  for (size_t c = 0; c < 3; ++c) {
+    test_numerical_equality<double>(fractions[c], integrals[c] / sum, 5e-3);
+  }
+  const double expected_inner =
+      integrate_cone(pol_dir, A_previous, theta_phi_inner,
+                     opening_angle_inner) /
+      sum;
+  test_numerical_equality<double>(fraction_inner, expected_inner,
+                                  5. * sqrt(expected_inner / n));
+
+  // In a cascade, the mean weight of the restricted cascades is the fraction
+  // of the unrestricted cascades whose second photon is inside the
+  // acceptance.
+  // The first step is sampled by inverse transform sampling, whose weights
+  // are 1, so that the weight of a cascade is the one of the second step.
+  const auto create_cascade_sampler = [&](const int seed) {
+    return CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+        make_shared<DirDirInverseTransformSampler>(dir_dir, seed),
+        make_shared<AngCorrRejectionSampler>(pol_dir, seed + 1)});
+  };
+  CascadeSampler unrestricted = create_cascade_sampler(2);
+  vector<euler_angle_transform::RotationMatrix> A(2 * n);
+  unrestricted.sample_rotation_matrices(n, A.data(), n);
+  double hit_fraction = 0.;
+  for (size_t k = 0; k < n; ++k) {
+    if (find_cone(euler_angle_transform::direction(A[n + k])) < 3) {
+      hit_fraction += 1. / n;
+    }
+  }
+
+  CascadeSampler restricted = create_cascade_sampler(4);
+  assert(!restricted.is_restricted());
+  restricted.restrict_to_acceptance(
+      1, make_shared<AcceptanceSampler>(pol_dir, theta_phi, opening_angles, 6));
+  assert(restricted.is_restricted());
+  vector<double> weights(n);
+  restricted.sample_weighted_rotation_matrices(n, A.data(), n, weights.data());
+  double mean_weight = 0.;
+  for (size_t k = 0; k < n; ++k) {
+    assert(find_cone(euler_angle_transform::direction(A[n + k])) < 3);
+    test_numerical_equality<double>(
+        weights[k],
+        AcceptanceSampler(pol_dir, theta_phi, opening_angles, 0)
+                .get_acceptance_probability(A[k]),
+        1e-12);
+    mean_weight += weights[k] / n;
+  }
+  test_numerical_equality<double>(mean_weight, hit_fraction,
+                                  5. * sqrt(hit_fraction / n));
+  test_numerical_equality<double>(restricted.get_sum_of_weights(),
+                                  mean_weight * n, 1e-6);
+
+  // The single and block modes, with Euler angles or rotation matrices, give
+  // the same cascades after reseeding.
+  const size_t n_compare = 2 * CascadeSampler::block_size + 3;
+  vector<double> Phi_Theta_Psi(6 * n_compare), weights_euler(n_compare);
+  restricted.reseed(7);
+  restricted.sample_weighted_rotation_matrices(n_compare, A.data(), n_compare,
+                                               weights.data());
+  restricted.reseed(7);
+  restricted.sample_weighted(n_compare, Phi_Theta_Psi.data(), n_compare,
+                             weights_euler.data());
+  restricted.reseed(7);
+  for (size_t k = 0; k < n_compare; ++k) {
+    const pair<double, vector<euler_angle_transform::RotationMatrix>> w_A =
+        restricted.sample_weighted_rotation_matrices();
+    assert(w_A.first == weights[k]);
+    test_numerical_equality<double>(weights_euler[k], weights[k], 1e-12);
+    for (size_t i = 0; i < 2; ++i) {
+      const euler_angle_transform::RotationMatrix A_euler =
+          euler_angle_transform::rotation_matrix(
+              {Phi_Theta_Psi[3 * i * n_compare + k],
+               Phi_Theta_Psi[(3 * i + 1) * n_compare + k],
+               Phi_Theta_Psi[(3 * i + 2) * n_compare + k]});
+      test_numerical_equality<double, 3>(w_A.second[i], A[i * n_compare + k],
+                                         1e-12);
+      test_numerical_equality<double, 3>(A_euler, A[i * n_compare + k],
+                                         1e-10);
+    }
+  }
+  restricted.reseed(7);
+  const pair<double, vector<array<double, 3>>> w_Phi_Theta_Psi =
+      restricted.sample_weighted();
+  test_numerical_equality<double>(w_Phi_Theta_Psi.first, weights[0], 1e-12);
+  for (size_t i = 0; i < 2; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      test_numerical_equality<double>(w_Phi_Theta_Psi.second[i][j],
+                                      Phi_Theta_Psi[(3 * i + j) * n_compare],
+                                      1e-12);
+    }
+  }
+
+  // If the first step is restricted, the frame of the previous step is the
+  // laboratory frame, and all weights are equal.
+  CascadeSampler restricted_first(vector<shared_ptr<ReferenceFrameSampler>>{
+      make_shared<SpotlightSampler>(array<double, 2>{0., 0.}, 0)});
+  restricted_first.restrict_to_acceptance(
+      0, make_shared<AcceptanceSampler>(pol_dir, theta_phi, opening_angles, 8));
+  restricted_first.sample_weighted(n_compare, Phi_Theta_Psi.data(), n_compare,
+                                   weights.data());
+  for (size_t k = 0; k < n_compare; ++k) {
+    test_numerical_equality<double>(weights[k], sum_identity / total_integral,
+                                    1e-12);
+    assert(find_cone(euler_angle_transform::direction(
+               euler_angle_transform::rotation_matrix(
+                   {Phi_Theta_Psi[k], Phi_Theta_Psi[n_compare + k],
+                    Phi_Theta_Psi[2 * n_compare + k]}))) < 3);
+  }
+
+  // Removing the restriction.
+  restricted_first.restrict_to_acceptance(0, nullptr);
+  assert(!restricted_first.is_restricted());
+  restricted_first();
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    restricted();
+  } catch (const runtime_error &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    restricted.sample_rotation_matrices(1, A.data(), 1);
+  } catch (const runtime_error &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    restricted.restrict_to_acceptance(2, nullptr);
+  } catch (const out_of_range &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AcceptanceSampler(pol_dir, {}, {}, 0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AcceptanceSampler(pol_dir, theta_phi, {0.3, 0.4}, 0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AcceptanceSampler(pol_dir, {{0., 0.}}, {0.}, 0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  // The angle between the axes is 0.5, the sum of the opening angles 0.6.
+  error_thrown = false;
+  try {
+    AcceptanceSampler(pol_dir, {{0., 0.}, {0.5, 1.}}, {0.3, 0.3}, 0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -0,0 +1,156 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <cmath>
+
+#include <random>
+
+using std::mt19937;
+using std::uniform_real_distribution;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include "AdaptiveEnvelope.hh"
+#include "AngularCorrelation.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Check that the envelope is an upper bound of the angular correlation, and
+ * that the proposed candidates are distributed like the envelope, i.e. that
+ * the mean value of W / W_env is the efficiency and the mean value of P_2
+ * weighted with W / W_env is the one of the angular correlation.
+ */
+void test_envelope(const AngularCorrelation &ang_cor,
+                   const double target_efficiency) {
+  const vector<double> c = ang_cor.get_legendre_coefficients();
+  const vector<double> d = ang_cor.get_associated_legendre_coefficients();
+  const AdaptiveEnvelope envelope(c, d, target_efficiency);
+
+  test_numerical_equality<double>(envelope.get_integral(), 4. * M_PI * c[0],
+                                  1e-12);
+  assert(envelope.get_efficiency() >= target_efficiency);
+  assert(envelope.get_efficiency() <= 1.);
+  assert(envelope.get_n_bound_evaluations() >= envelope.get_n_strata());
+  assert(envelope.get_construction_time() >= 0.);
+
+  for (size_t i = 0; i <= 100; ++i) {
+    const double theta = M_PI * i / 100.;
+    for (size_t j = 0; j <= 40; ++j) {
+      const double phi = 2. * M_PI * j / 40.;
+      assert(envelope(cos(theta), phi) >= ang_cor(theta, phi));
+    }
+  }
+
+  mt19937 random_engine(0);
+  uniform_real_distribution<double> uniform(0., 1.);
+  const size_t n = 1000000;
+  double sum_w = 0., sum_w_p_2 = 0., sum_w_p_2_2 = 0.;
+  for (size_t k = 0; k < n; ++k) {
+    double cos_theta, phi, bound;
+    envelope.propose(uniform(random_engine), uniform(random_engine),
+                     cos_theta, phi, bound);
+    assert(cos_theta >= -1. && cos_theta <= 1.);
+    assert(phi >= 0. && phi <= 2. * M_PI);
+    assert(bound == envelope(cos_theta, phi));
+    const double w = ang_cor(acos(cos_theta), phi) / bound;
+    sum_w += w;
+    sum_w_p_2 += w * 0.5 * (3. * cos_theta * cos_theta - 1.);
+    sum_w_p_2_2 += w * cos(2. * phi) * 3. * (1. - cos_theta * cos_theta);
+  }
+  test_numerical_equality<double>(sum_w / n, envelope.get_efficiency(), 1e-2);
+  test_numerical_equality<double>(sum_w_p_2 / sum_w, c[1] / (5. * c[0]),
+                                  1e-2);
+  test_numerical_equality<double>(sum_w_p_2_2 / sum_w,
+                                  d.empty() ? 0. : 12. * d[0] / (5. * c[0]),
+                                  3e-2);
+}
+
+int main() {
+  // The Bernstein bound of a polynomial is exact at the limits of the
+  // interval if the maximum is located there.
+  test_numerical_equality<double>(
+      AdaptiveEnvelope::bernstein_bound({0., 0., 1.}, -1., 1.), 1., 1e-14);
+  test_numerical_equality<double>(
+      AdaptiveEnvelope::bernstein_bound({1., -2.}, 0.25, 0.75), 0.5, 1e-14);
+  // The bound converges to the maximum for small intervals.
+  const double bound = AdaptiveEnvelope::bernstein_bound(
+      {0., 0., 0., -1.}, 0.5, 0.501);
+  assert(bound >= -0.125);
+  test_numerical_equality<double>(bound, -0.125, 1e-5);
+
+  // Sharply peaked cascade of E2 transitions.
+  const AngularCorrelation dir_dir(
+      State(0, parity_unknown),
+      {{Transition(em_unknown, 4, em_unknown, 6, 0.), State(4, parity_unknown)},
+       {Transition(em_unknown, 4, em_unknown, 6, 0.),
+        State(0, parity_unknown)}});
+  test_envelope(dir_dir, 0.9);
+
+  const AngularCorrelation pol_dir(
+      State(0, positive),
+      {{Transition(electric, 4, magnetic, 6, 0.), State(4, positive)},
+       {Transition(electric, 4, magnetic, 6, 0.), State(0, positive)}});
+  test_envelope(pol_dir, 0.9);
+
+  // The maximum number of strata has priority over the target efficiency.
+  const AdaptiveEnvelope coarse(pol_dir.get_legendre_coefficients(),
+                                pol_dir.get_associated_legendre_coefficients(),
+                                0.99, 4);
+  assert(coarse.get_n_strata() == 4);
+  assert(coarse.get_efficiency() < 0.99);
+
+  // An isotropic distribution is its own envelope.
+  const AdaptiveEnvelope isotropic({0.5});
+  assert(isotropic.get_n_strata() == 1);
+  test_numerical_equality<double>(isotropic.get_efficiency(), 1., 1e-10);
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    AdaptiveEnvelope({});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AdaptiveEnvelope({1.}, {}, 1.);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AdaptiveEnvelope({1.}, {}, 0.9, 0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -43,4 +43,36 @@ int main() {
   assert(av_coef.string_representation(3) ==
          "(-1)\\times\\left(-0.5\\right)\\times0.707+2\\times\\left(-0."
          "167\\right)\\times0\\times\\delta+0.5\\times0\\times\\delta^{2}");
+
+  // The constructor for a known F coefficient and the evaluation without an
+  // object give the same result as the full constructor.
+  for (int two_nu = 4; two_nu <= 8; two_nu += 4) {
+    const AlphavCoefficient alphav(two_nu, 4, 6, 0, 4);
+    const AlphavCoefficient alphav_f(
+        two_nu, 4, 6, 0, 4, FCoefficient(two_nu, 4, 4, 0, 4).get_value());
+    for (const double delta : {0., 0.3, -2.1}) {
+      assert(alphav_f(delta) == alphav(delta));
+      assert(AlphavCoefficient::evaluate(two_nu, 4, 6, 0, 4, delta) ==
+             alphav(delta));
+    }
+  }
+
+  // The terms with L' are calculated on demand. Copies made before and after
+  // that, and an object restored from the values, give the same results.
+  const AlphavCoefficient lazy(4, 4, 6, 0, 4);
+  const AlphavCoefficient lazy_copy(lazy);
+  const double alphav_0 = lazy(0.);
+  const double alphav_delta = lazy(0.3);
+  const AlphavCoefficient calculated_copy(lazy);
+  const AlphavCoefficient restored(4, 4, 6, 0, 4, lazy.get_f_values(),
+                                   lazy.get_kappa_values());
+  assert(alphav_0 == lazy.get_constant_coefficient());
+  assert(lazy_copy(0.3) == alphav_delta);
+  assert(calculated_copy(0.3) == alphav_delta);
+  assert(restored(0.3) == alphav_delta);
+  assert(lazy.derivative(0.) == lazy.get_linear_coefficient());
+  assert(AlphavCoefficient(4, 4, 6, 0, 4).derivative(0.) ==
+         lazy.get_linear_coefficient());
+  assert(AlphavCoefficient(4, 4, 6, 0, 4).string_representation(3) ==
+         restored.string_representation(3));
 }
\ No newline at end of file
@@ -23,11 +23,20 @@ using std::array;
 
 #include <cassert>
 
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
 #include <gsl/gsl_sf.h>
 
 #include "AngCorrRejectionSampler.hh"
 #include "AngularCorrelation.hh"
 #include "EulerAngleRotation.hh"
+#include "LegendreSeries.hh"
 #include "SphereRejectionSampler.hh"
 #include "TestUtilities.hh"
 
@@ -86,4 +95,115 @@ int main() {
   theta_phi_1 = euler_angle_transform::to_spherical(ang_cor_sam_2());
   assert(theta_phi_1[0] == 0.);
   assert(theta_phi_1[1] == M_PI_2);
-}
\ No newline at end of file
+
+  // With the exact maximum of the angular correlation as the envelope, the
+  // sampler is more efficient than with the upper limit.
+  AngCorrRejectionSampler ang_cor_sam_exact(ang_cor, seed, 1000, true);
+  AngCorrRejectionSampler ang_cor_sam_upper_limit(ang_cor, seed);
+  assert(ang_cor.get_maximum() < ang_cor.get_upper_limit());
+  assert(ang_cor_sam_exact.estimate_efficiency(1000) >
+         ang_cor_sam_upper_limit.estimate_efficiency(1000));
+
+  // For a sharply peaked angular correlation, even the exact maximum is a
+  // poor envelope. The adaptive envelope reaches its target efficiency, and
+  // the accepted directions are still distributed like W.
+  const AngularCorrelation ang_cor_peaked(
+      State(0, positive),
+      {{Transition(electric, 4, magnetic, 6, 0.), State(4, positive)},
+       {Transition(electric, 4, magnetic, 6, 0.), State(0, positive)}});
+  AngCorrRejectionSampler ang_cor_sam_peaked_exact(ang_cor_peaked, seed, 1000,
+                                                   true);
+  AngCorrRejectionSampler ang_cor_sam_adaptive(ang_cor_peaked, seed);
+  ang_cor_sam_adaptive.enable_adaptive_envelope(0.9);
+  assert(ang_cor_sam_adaptive.get_envelope().has_value());
+  const double efficiency_adaptive =
+      ang_cor_sam_adaptive.estimate_efficiency(100000);
+  assert(efficiency_adaptive >
+         ang_cor_sam_peaked_exact.estimate_efficiency(100000));
+  test_numerical_equality<double>(
+      efficiency_adaptive,
+      ang_cor_sam_adaptive.get_envelope()->get_efficiency(), 1e-2);
+
+  const vector<double> c = ang_cor_peaked.get_legendre_coefficients();
+  const vector<double> d =
+      ang_cor_peaked.get_associated_legendre_coefficients();
+  const size_t n_samples = 100000;
+  double sum_p_2 = 0., sum_p_2_2 = 0., sum_weights = 0.;
+  for (size_t k = 0; k < n_samples; ++k) {
+    theta_phi_1 = euler_angle_transform::to_spherical(ang_cor_sam_adaptive());
+    const double x = cos(theta_phi_1[0]);
+    sum_p_2 += 0.5 * (3. * x * x - 1.);
+    sum_p_2_2 += cos(2. * theta_phi_1[1]) * 3. * (1. - x * x);
+    sum_weights += ang_cor_sam_adaptive.sample_weighted().first;
+  }
+  test_numerical_equality<double>(sum_p_2 / n_samples, c[1] / (5. * c[0]),
+                                  1e-2);
+  test_numerical_equality<double>(sum_p_2_2 / n_samples,
+                                  12. * d[0] / (5. * c[0]), 3e-2);
+  test_numerical_equality<double>(sum_weights / n_samples,
+                                  efficiency_adaptive, 1e-2);
+
+  ang_cor_sam_adaptive.disable_envelope();
+  assert(!ang_cor_sam_adaptive.get_envelope().has_value());
+
+  // The samplers with a statically typed distribution give the same sequence
+  // of reference frames as AngCorrRejectionSampler.
+  AngCorrRejectionSampler ang_cor_sam_pol_dir(ang_cor, seed);
+  PolDirRejectionSampler pol_dir_sam(
+      W_pol_dir(ang_cor.get_initial_state(), ang_cor.get_cascade_steps()),
+      ang_cor.get_upper_limit(), seed);
+  for (unsigned int n = 0; n < 100; ++n) {
+    assert(ang_cor_sam_pol_dir.sample() == pol_dir_sam.sample());
+  }
+
+  AngularCorrelation ang_cor_dir_dir(
+      State(0, parity_unknown),
+      {{Transition(em_unknown, 4, em_unknown, 6, 0.), State(4, parity_unknown)},
+       {Transition(em_unknown, 4, em_unknown, 6, 0.),
+        State(0, parity_unknown)}});
+  AngCorrRejectionSampler ang_cor_sam_dir_dir(ang_cor_dir_dir, seed);
+  const W_dir_dir w_dir_dir(ang_cor_dir_dir.get_initial_state(),
+                            ang_cor_dir_dir.get_cascade_steps());
+  DirDirRejectionSampler dir_dir_sam(w_dir_dir, w_dir_dir.get_upper_limit(),
+                                     seed);
+  for (unsigned int n = 0; n < 100; ++n) {
+    assert(ang_cor_sam_dir_dir.sample() == dir_dir_sam.sample());
+  }
+
+  // The same holds for the adaptive envelope.
+  ang_cor_sam_dir_dir.enable_adaptive_envelope();
+  dir_dir_sam.enable_adaptive_envelope();
+  for (unsigned int n = 0; n < 100; ++n) {
+    assert(ang_cor_sam_dir_dir.sample() == dir_dir_sam.sample());
+  }
+
+  // The single-precision samplers propose the same candidates, and their
+  // weights deviate by less than legendre_series::float_relative_error.
+  DirDirRejectionSampler dir_dir_sam_double(
+      w_dir_dir, w_dir_dir.get_upper_limit(), seed);
+  DirDirRejectionSamplerFloat dir_dir_sam_float(
+      w_dir_dir, w_dir_dir.get_upper_limit(), seed);
+  const W_pol_dir w_pol_dir(ang_cor.get_initial_state(),
+                            ang_cor.get_cascade_steps());
+  PolDirRejectionSampler pol_dir_sam_double(
+      w_pol_dir, w_pol_dir.get_upper_limit(), seed);
+  PolDirRejectionSamplerFloat pol_dir_sam_float(
+      w_pol_dir, w_pol_dir.get_upper_limit(), seed);
+  for (unsigned int n = 0; n < 100; ++n) {
+    const pair<double, array<double, 3>> dir_dir_double =
+        dir_dir_sam_double.sample_weighted();
+    const pair<double, array<double, 3>> dir_dir_float =
+        dir_dir_sam_float.sample_weighted();
+    assert(dir_dir_double.second == dir_dir_float.second);
+    test_numerical_equality<double>(dir_dir_double.first, dir_dir_float.first,
+                                    legendre_series::float_relative_error);
+
+    const pair<double, array<double, 3>> pol_dir_double =
+        pol_dir_sam_double.sample_weighted();
+    const pair<double, array<double, 3>> pol_dir_float =
+        pol_dir_sam_float.sample_weighted();
+    assert(pol_dir_double.second == pol_dir_float.second);
+    test_numerical_equality<double>(pol_dir_double.first, pol_dir_float.first,
+                                    legendre_series::float_relative_error);
+  }
+}
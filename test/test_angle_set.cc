@@ -0,0 +1,182 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <cstdint>
+
+using std::uintptr_t;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngleSet.hh"
+#include "AngularCorrelation.hh"
+#include "DetectorArray.hh"
+#include "HypothesisMatrixEvaluator.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+int main() {
+  const double epsilon = 1e-12;
+
+  const vector<AngularCorrelation> ang_cors{
+      // Dir-dir correlation
+      AngularCorrelation(State(0, parity_unknown),
+                         {{Transition(em_unknown, 2, em_unknown, 4, 0.),
+                           State(2, parity_unknown)},
+                          {Transition(em_unknown, 2, em_unknown, 4, 0.),
+                           State(0, parity_unknown)}}),
+      // Pol-dir correlations
+      AngularCorrelation(
+          State(0, positive),
+          {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+           {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}}),
+      AngularCorrelation(
+          State(4, positive),
+          {{Transition(magnetic, 2, electric, 4, 0.5), State(6, positive)},
+           {Transition(magnetic, 2, electric, 4, 2.), State(4, positive)}})};
+
+  const vector<double> theta{0.1, 0.8, 1.5708, 2.7, 0.4,
+                             2.1, 3.0, 0.,     M_PI, 1.2};
+  const vector<double> phi{0., 1.3, 0.785, 5., 3.3, 0.2, 1., 0.5, 2., -0.7};
+  const size_t n_directions = theta.size();
+
+  // Layout of the basis: the rows are aligned to cache lines, and the
+  // padding contains zeros.
+  const AngleSet angle_set(theta, phi, 6);
+  assert(angle_set.get_n_directions() == n_directions);
+  assert(angle_set.get_nu_max() == 6);
+  assert(angle_set.get_n_rows() == 7);
+  const size_t leading_dimension = angle_set.get_leading_dimension();
+  assert(leading_dimension == 2 * AngleSet::alignment);
+  assert(reinterpret_cast<uintptr_t>(angle_set.get_basis()) %
+             (AngleSet::alignment * sizeof(double)) ==
+         0);
+  for (size_t i = 0; i < angle_set.get_n_rows(); ++i) {
+    for (size_t m = n_directions; m < leading_dimension; ++m) {
+      assert(angle_set.get_basis()[i * leading_dimension + m] == 0.);
+    }
+  }
+  const AngleSet copy = angle_set;
+  assert(reinterpret_cast<uintptr_t>(copy.get_basis()) %
+             (AngleSet::alignment * sizeof(double)) ==
+         0);
+
+  // The basis does not depend on how the directions are given.
+  vector<double> cos_theta(n_directions), cos_2phi(n_directions);
+  for (size_t m = 0; m < n_directions; ++m) {
+    cos_theta[m] = cos(theta[m]);
+    cos_2phi[m] = cos(2. * phi[m]);
+  }
+  const AngleSet angle_set_cos(n_directions, cos_theta.data(),
+                               cos_2phi.data(), 6);
+  for (size_t j = 0; j < angle_set.get_n_rows() * leading_dimension; ++j) {
+    test_numerical_equality<double>(angle_set.get_basis()[j],
+                                    angle_set_cos.get_basis()[j], epsilon);
+  }
+
+  // The evaluation gives the same values as the one of the angular
+  // correlation, also for a larger order of the basis.
+  vector<double> result(ang_cors.size() * n_directions),
+      expected(n_directions);
+  angle_set.evaluate(ang_cors, result.data());
+  for (size_t k = 0; k < ang_cors.size(); ++k) {
+    ang_cors[k].evaluate(n_directions, theta.data(), phi.data(),
+                         expected.data());
+    test_numerical_equality<double>(n_directions,
+                                    result.data() + k * n_directions,
+                                    expected.data(), epsilon);
+  }
+
+  // The matrix product uses the same basis.
+  const HypothesisMatrixEvaluator evaluator(angle_set);
+  assert(evaluator.get_n_directions() == n_directions);
+  assert(evaluator.get_nu_max() == 6);
+  assert(evaluator.get_basis() ==
+         HypothesisMatrixEvaluator(theta, phi, 6).get_basis());
+
+  // The set of relative directions of a detector array gives the
+  // coincidence matrix.
+  const DetectorArray detector_array(
+      {{0.5 * M_PI, 0.}, {0.25 * M_PI, M_PI}, {1.2, 4.}, {M_PI, 0.}},
+      {0., 0.2, 0.4, 0.6});
+  const size_t n_pairs = 16;
+  const AngleSet detector_angle_set = detector_array.angle_set(4);
+  assert(detector_angle_set.get_n_directions() == n_pairs);
+  vector<double> matrix(n_pairs), expected_matrix(n_pairs);
+  for (const auto &ang_cor : ang_cors) {
+    detector_angle_set.evaluate(ang_cor, matrix.data());
+    detector_array(ang_cor, expected_matrix.data());
+    test_numerical_equality<double>(n_pairs, matrix.data(),
+                                    expected_matrix.data(), epsilon);
+  }
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    AngleSet(theta, {0.}, 4);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AngleSet({}, {}, 4);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AngleSet(theta, phi, 3);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AngleSet(theta, phi, 2).evaluate(ang_cors[2], result.data());
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AngleSet(theta, phi, 2).evaluate({1.}, {1., 2.}, result.data());
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
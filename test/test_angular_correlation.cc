@@ -19,6 +19,14 @@
 
 #include <cassert>
 
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <utility>
+
+using std::move;
+
 #include <gsl/gsl_math.h>
 
 #include "AngularCorrelation.hh"
@@ -94,7 +102,108 @@ int main() {
     }
   }
 
-  // Test the copy constructor
+  // Test the rotated evaluation by comparing it to the unrotated angular
+  // correlation in the rotated coordinate system.
+  const vector<array<double, 3>> euler_angles{
+      {0., 0., 0.}, {M_PI_2, 0., 0.}, {0.3, 1.2, -0.5}, {2., 2.5, 4.}};
+  vector<double> thetas, phis;
+  for (double theta = 0.; theta < M_PI; theta += 0.1) {
+    for (double phi = 0.; phi < M_2_PI; phi += 0.1) {
+      thetas.push_back(theta);
+      phis.push_back(phi);
+    }
+  }
+  vector<double> results(thetas.size());
+
+  gsl_vector *Phi_Theta_Psi = gsl_vector_alloc(3);
+  gsl_vector *x_y_z = gsl_vector_alloc(3);
+  gsl_vector *xp_yp_zp = gsl_vector_alloc(3);
+
+  for (auto angles : euler_angles) {
+    ang_corr_0p_1p_0p.evaluate(thetas.size(), thetas.data(), phis.data(),
+                               angles, results.data());
+    for (size_t i = 0; i < 3; ++i) {
+      gsl_vector_set(Phi_Theta_Psi, i, angles[i]);
+    }
+    for (size_t i = 0; i < thetas.size(); ++i) {
+      gsl_vector_set(xp_yp_zp, 0, sin(thetas[i]) * cos(phis[i]));
+      gsl_vector_set(xp_yp_zp, 1, sin(thetas[i]) * sin(phis[i]));
+      gsl_vector_set(xp_yp_zp, 2, cos(thetas[i]));
+      euler_angle_transform::rotate_back(x_y_z, Phi_Theta_Psi, xp_yp_zp);
+      test_numerical_equality<double>(
+          results[i],
+          ang_corr_0p_1p_0p(acos(gsl_vector_get(x_y_z, 2)),
+                            atan2(gsl_vector_get(x_y_z, 1),
+                                  gsl_vector_get(x_y_z, 0))),
+          epsilon);
+    }
+
+    // The original z axis of the angular correlation is rotated to A*e_z.
+    gsl_vector_set(x_y_z, 0, 0.);
+    gsl_vector_set(x_y_z, 1, 0.);
+    gsl_vector_set(x_y_z, 2, 1.);
+    euler_angle_transform::rotate(xp_yp_zp, Phi_Theta_Psi, x_y_z);
+    const double theta_z = acos(gsl_vector_get(xp_yp_zp, 2));
+    const double phi_z =
+        atan2(gsl_vector_get(xp_yp_zp, 1), gsl_vector_get(xp_yp_zp, 0));
+    double result_z;
+    ang_corr_0p_1p_0p.evaluate(1, &theta_z, &phi_z, angles, &result_z);
+    test_numerical_equality<double>(result_z, ang_corr_0p_1p_0p(0., 0.),
+                                    epsilon);
+  }
+
+  gsl_vector_free(Phi_Theta_Psi);
+  gsl_vector_free(x_y_z);
+  gsl_vector_free(xp_yp_zp);
+
+  // Test the copy constructor. Copies share the expansion coefficients.
   AngularCorrelation ang_corr_0_1_0_prime = ang_corr_0_1_0;
   assert(ang_corr_0_1_0_prime(0.1, 0.2) == ang_corr_0_1_0(0.1, 0.2));
+  assert(ang_corr_0_1_0_prime.get_w_gamma_gamma() ==
+         ang_corr_0_1_0.get_w_gamma_gamma());
+
+  // Test the move constructor and the assignment operators.
+  AngularCorrelation ang_corr_moved(move(ang_corr_0_1_0_prime));
+  assert(ang_corr_moved.get_w_gamma_gamma() ==
+         ang_corr_0_1_0.get_w_gamma_gamma());
+  ang_corr_moved = ang_corr_0p_1p_0p;
+  assert(ang_corr_moved(0.1, 0.2) == ang_corr_0p_1p_0p(0.1, 0.2));
+  ang_corr_0_1_0_prime = move(ang_corr_moved);
+  assert(ang_corr_0_1_0_prime(0.1, 0.2) == ang_corr_0p_1p_0p(0.1, 0.2));
+
+  // The pol-dir correlation uses the A_nu coefficients of the decay of its
+  // dir-dir part.
+  const vector<AvCoefficient> &av_coefficients_decay =
+      w_pol_dir_0p_1p_0p.get_w_dir_dir().get_Av_coefficients_decay();
+  assert(av_coefficients_decay.size() == 2);
+  W_pol_dir w_pol_dir_copy = w_pol_dir_0p_1p_0p;
+  assert(&w_pol_dir_copy.get_w_dir_dir() ==
+         &w_pol_dir_0p_1p_0p.get_w_dir_dir());
+
+  // Setting the degree of polarization does not affect copies, and only the
+  // polarization-dependent part is scaled. The dir-dir part is the mean of
+  // two correlations with perpendicular polarization axes.
+  AngularCorrelation ang_corr_partial = ang_corr_0p_1p_0p;
+  assert(ang_corr_partial.get_polarization_degree() == 1.);
+  ang_corr_partial.set_polarization_degree(0.25);
+  assert(ang_corr_partial.get_polarization_degree() == 0.25);
+  assert(ang_corr_0p_1p_0p.get_polarization_degree() == 1.);
+  for (double theta = 0.; theta < M_PI; theta += 0.5) {
+    for (double phi = 0.; phi < M_2_PI; phi += 0.5) {
+      test_numerical_equality<double>(
+          ang_corr_partial(theta, phi),
+          0.625 * ang_corr_0p_1p_0p(theta, phi) +
+              0.375 * ang_corr_0p_1p_0p(theta, phi + M_PI_2),
+          epsilon);
+    }
+  }
+  assert(ang_corr_0_1_0.get_polarization_degree() == 0.);
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    ang_corr_0_1_0.set_polarization_degree(0.5);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
 }
\ No newline at end of file
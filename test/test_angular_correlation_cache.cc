@@ -0,0 +1,155 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <memory>
+
+using std::shared_ptr;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <thread>
+
+using std::thread;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "AngularCorrelationCache.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+vector<pair<Transition, State>> cascade_0_J_0(const int two_J,
+                                               const double delta) {
+  return {{Transition(electric, two_J, magnetic, two_J + 2, delta),
+           State(two_J, (two_J / 2) % 2 == 0 ? positive : negative)},
+          {Transition(electric, two_J, magnetic, two_J + 2, 0.),
+           State(0, positive)}};
+}
+
+int main() {
+
+  AngularCorrelationCache cache(2);
+  assert(cache.get_capacity() == 2);
+  assert(cache.get_hit_rate() == 0.);
+
+  // Identical cascades share the same object, which is equal to a newly
+  // constructed one.
+  const shared_ptr<const AngularCorrelation> ang_cor_1 =
+      cache.get(State(0, positive), cascade_0_J_0(2, 0.));
+  const shared_ptr<const AngularCorrelation> ang_cor_1_again =
+      cache.get(State(0, positive), cascade_0_J_0(2, 0.));
+  assert(ang_cor_1 == ang_cor_1_again);
+  assert(cache.get_hits() == 1);
+  assert(cache.get_misses() == 1);
+  test_numerical_equality<double>(
+      (*ang_cor_1)(0.3, 0.4),
+      AngularCorrelation(State(0, positive), cascade_0_J_0(2, 0.))(0.3, 0.4),
+      1e-14);
+
+  // -0 and +0 are the same mixing ratio, but any other change of the bits
+  // gives a new entry.
+  assert(cache.get(State(0, positive), cascade_0_J_0(2, -0.)) == ang_cor_1);
+  const shared_ptr<const AngularCorrelation> ang_cor_2 =
+      cache.get(State(0, positive), cascade_0_J_0(2, 1e-300));
+  assert(ang_cor_2 != ang_cor_1);
+  assert(cache.size() == 2);
+  test_numerical_equality<double>(cache.get_hit_rate(), 0.5, 1e-14);
+
+  // The least recently used entry is evicted, and its pointer stays valid.
+  cache.get(State(0, positive), cascade_0_J_0(2, 0.));
+  cache.get(State(0, positive), cascade_0_J_0(4, 0.));
+  assert(cache.size() == 2);
+  assert(cache.get_evictions() == 1);
+  assert(cache.get(State(0, positive), cascade_0_J_0(2, 0.)) == ang_cor_1);
+  assert(cache.get(State(0, positive), cascade_0_J_0(2, 1e-300)) != ang_cor_2);
+  test_numerical_equality<double>((*ang_cor_2)(0.3, 0.4),
+                                  (*ang_cor_1)(0.3, 0.4), 1e-12);
+
+  cache.set_capacity(1);
+  assert(cache.size() == 1);
+  cache.set_capacity(0);
+  assert(cache.size() == 0);
+  cache.get(State(0, positive), cascade_0_J_0(2, 0.));
+  assert(cache.size() == 0);
+
+  cache.clear();
+  assert(cache.get_hits() == 0 && cache.get_misses() == 0);
+  assert(cache.get_evictions() == 0);
+
+  // With a resolution, close mixing ratios share an entry.
+  AngularCorrelationCache cache_resolution(16, 1e-3);
+  const shared_ptr<const AngularCorrelation> ang_cor_delta =
+      cache_resolution.get(State(0, positive), cascade_0_J_0(2, 0.5));
+  assert(cache_resolution.get(State(0, positive),
+                              cascade_0_J_0(2, 0.5002)) == ang_cor_delta);
+  assert(cache_resolution.get(State(0, positive), cascade_0_J_0(2, 0.502)) !=
+         ang_cor_delta);
+  assert(ang_cor_delta->get_cascade_steps()[0].first.delta == 0.5);
+
+  // Invalid cascades are not cached.
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    cache_resolution.get(
+        State(0, positive),
+        {{Transition(magnetic, 2, magnetic, 4, 0.), State(2, negative)},
+         {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+  assert(cache_resolution.size() == 2);
+
+  error_thrown = false;
+  try {
+    AngularCorrelationCache cache_invalid(16, -1.);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  // Concurrent access from several threads.
+  AngularCorrelationCache cache_threads(4);
+  vector<thread> threads;
+  for (size_t i = 0; i < 4; ++i) {
+    threads.push_back(thread([&cache_threads]() {
+      for (size_t j = 0; j < 100; ++j) {
+        const int two_J = 2 * (1 + j % 3);
+        const shared_ptr<const AngularCorrelation> ang_cor =
+            cache_threads.get(State(0, positive), cascade_0_J_0(two_J, 0.));
+        assert((*ang_cor)(0.1, 0.2) > 0.);
+      }
+    }));
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  assert(cache_threads.size() == 3);
+  assert(cache_threads.get_hits() + cache_threads.get_misses() == 400);
+}
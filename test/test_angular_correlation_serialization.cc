@@ -0,0 +1,152 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <string>
+
+using std::string;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Check that a deserialized angular correlation is identical to the original
+ * one, also after a change of the mixing ratios.
+ */
+void test_round_trip(const AngularCorrelation &ang_cor) {
+  const vector<char> data = ang_cor.serialize();
+  AngularCorrelation restored =
+      AngularCorrelation::deserialize(data.data(), data.size());
+
+  assert(restored.get_legendre_coefficients() ==
+         ang_cor.get_legendre_coefficients());
+  assert(restored.get_associated_legendre_coefficients() ==
+         ang_cor.get_associated_legendre_coefficients());
+  assert(restored.get_polarization_degree() ==
+         ang_cor.get_polarization_degree());
+  assert(restored.get_w_gamma_gamma()->string_representation() ==
+         ang_cor.get_w_gamma_gamma()->string_representation());
+  assert(restored.serialize() == data);
+
+  const size_t n_steps = ang_cor.get_cascade_steps().size();
+  vector<double> deltas(n_steps);
+  AngularCorrelation changed = ang_cor;
+  for (size_t i = 0; i < n_steps; ++i) {
+    deltas[i] = 0.3 * (i + 1) - 0.5;
+    changed.set_delta(i, deltas[i]);
+    restored.set_delta(i, deltas[i]);
+  }
+  assert(restored.get_legendre_coefficients() ==
+         changed.get_legendre_coefficients());
+  assert(restored.get_associated_legendre_coefficients() ==
+         changed.get_associated_legendre_coefficients());
+  for (double theta = 0.; theta < M_PI; theta += 0.5) {
+    for (double phi = 0.; phi < M_2_PI; phi += 0.5) {
+      assert(restored(theta, phi) == changed(theta, phi));
+    }
+  }
+}
+
+int main() {
+  // Dir-dir and pol-dir correlations with and without unobserved
+  // intermediate transitions, and a partially polarized beam.
+  test_round_trip(AngularCorrelation(
+      State(0, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.), State(2, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, 0.),
+        State(0, parity_unknown)}}));
+  test_round_trip(AngularCorrelation(
+      State(3, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.5), State(5, positive)},
+       {Transition(magnetic, 2, electric, 4, -1.5), State(3, positive)}}));
+  test_round_trip(AngularCorrelation(
+      State(5, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.2),
+        State(7, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, 0.7),
+        State(5, parity_unknown)},
+       {Transition(em_unknown, 4, em_unknown, 6, 0.), State(1, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, -0.1),
+        State(3, parity_unknown)}}));
+  AngularCorrelation partial(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.1), State(2, positive)},
+       {Transition(magnetic, 2, electric, 4, 0.), State(0, positive)}});
+  partial.set_polarization_degree(-0.4);
+  test_round_trip(partial);
+
+  const vector<char> data = partial.serialize();
+
+  // Truncated data, additional data, a wrong magic string, and an invalid
+  // cascade.
+  [[maybe_unused]] bool error_thrown = false;
+  for (size_t size : {size_t(0), size_t(8), size_t(30), data.size() - 1}) {
+    error_thrown = false;
+    try {
+      AngularCorrelation::deserialize(data.data(), size);
+    } catch (const invalid_argument &e) {
+      error_thrown = true;
+    }
+    assert(error_thrown);
+  }
+
+  vector<char> modified(data);
+  modified.push_back(0);
+  error_thrown = false;
+  try {
+    AngularCorrelation::deserialize(modified.data(), modified.size());
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  modified = data;
+  modified[0] = 'X';
+  error_thrown = false;
+  try {
+    AngularCorrelation::deserialize(modified.data(), modified.size());
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  // The spin of the initial state is the first quantum number after the
+  // header of 24 bytes. Spin 1/2 mixes integer and half-integer spins.
+  modified = data;
+  modified[24] = 1;
+  error_thrown = false;
+  try {
+    AngularCorrelation::deserialize(modified.data(), modified.size());
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -0,0 +1,195 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <chrono>
+
+using std::chrono::microseconds;
+using std::chrono::seconds;
+
+#include <future>
+
+using std::future;
+
+#include <memory>
+
+using std::make_shared;
+using std::shared_ptr;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <thread>
+
+using std::thread;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "AngularCorrelationCache.hh"
+#include "AsyncEvaluationService.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+vector<pair<Transition, State>> cascade_0_J_0(const int two_J,
+                                               const double delta) {
+  return {{Transition(electric, two_J, magnetic, two_J + 2, delta),
+           State(two_J, (two_J / 2) % 2 == 0 ? positive : negative)},
+          {Transition(electric, two_J, magnetic, two_J + 2, 0.),
+           State(0, positive)}};
+}
+
+/**
+ * Compare the result of a request to a direct evaluation.
+ */
+void test_result(future<vector<double>> &result, const int two_J,
+                 const double delta, const vector<double> &theta,
+                 const vector<double> &phi) {
+  const vector<double> values = result.get();
+  assert(values.size() == theta.size());
+  const AngularCorrelation ang_cor(State(0, positive),
+                                   cascade_0_J_0(two_J, delta));
+  for (size_t i = 0; i < theta.size(); ++i) {
+    test_numerical_equality<double>(values[i], ang_cor(theta[i], phi[i]),
+                                    1e-12);
+  }
+}
+
+int main() {
+  const vector<double> theta{0.1, 0.8, 1.6, 2.7};
+  const vector<double> phi{0., 1.3, 0.7, 5.};
+
+  // A single request is answered after the maximum delay, although the batch
+  // is not full.
+  {
+    AsyncEvaluationService service(1, microseconds(1000), 16);
+    assert(service.get_n_workers() == 1);
+    assert(service.get_max_batch_delay() == microseconds(1000));
+    assert(service.get_max_batch_size() == 16);
+    future<vector<double>> result =
+        service.submit(State(0, positive), cascade_0_J_0(2, 0.3), theta, phi);
+    test_result(result, 2, 0.3, theta, phi);
+    assert(service.get_n_requests() == 1);
+    assert(service.get_n_batches() == 1);
+  }
+
+  // With a long delay, a batch is only processed when it is full. Identical
+  // cascades in a batch are evaluated together, and an invalid cascade does
+  // not affect the other requests.
+  {
+    const size_t n_requests = 8;
+    shared_ptr<AngularCorrelationCache> cache =
+        make_shared<AngularCorrelationCache>();
+    AsyncEvaluationService service(2, seconds(100), n_requests, cache);
+    assert(service.get_cache() == cache);
+
+    vector<future<vector<double>>> results;
+    for (size_t i = 0; i < n_requests - 1; ++i) {
+      results.push_back(service.submit(State(0, positive),
+                                       cascade_0_J_0(2 + 2 * (i % 2), 0.5),
+                                       theta, phi));
+    }
+    future<vector<double>> invalid = service.submit(
+        State(0, positive),
+        {{Transition(electric, 2, magnetic, 4, 0.), State(0, positive)},
+         {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}},
+        theta, phi);
+
+    for (size_t i = 0; i < n_requests - 1; ++i) {
+      test_result(results[i], 2 + 2 * (i % 2), 0.5, theta, phi);
+    }
+    [[maybe_unused]] bool error_thrown = false;
+    try {
+      invalid.get();
+    } catch (const invalid_argument &e) {
+      error_thrown = true;
+    }
+    assert(error_thrown);
+
+    assert(service.get_n_requests() == n_requests);
+    assert(service.get_n_batches() == 1);
+    assert(service.get_n_evaluations() == 2);
+    assert(cache->get_misses() == 3);
+  }
+
+  // Concurrent clients. The destructor processes the remaining requests.
+  {
+    const size_t n_clients = 4, n_requests_per_client = 200;
+    vector<vector<future<vector<double>>>> results(n_clients);
+    {
+      AsyncEvaluationService service(3, microseconds(50), 32);
+      vector<thread> clients;
+      for (size_t c = 0; c < n_clients; ++c) {
+        clients.emplace_back([&, c] {
+          for (size_t i = 0; i < n_requests_per_client; ++i) {
+            results[c].push_back(service.submit(
+                State(0, positive),
+                cascade_0_J_0(2 + 2 * ((c + i) % 2), 0.1 * (i % 3)),
+                vector<double>(theta.begin(), theta.begin() + 1 + i % 4),
+                vector<double>(phi.begin(), phi.begin() + 1 + i % 4)));
+          }
+        });
+      }
+      for (auto &t : clients) {
+        t.join();
+      }
+    }
+    for (size_t c = 0; c < n_clients; ++c) {
+      for (size_t i = 0; i < n_requests_per_client; ++i) {
+        test_result(results[c][i], 2 + 2 * ((c + i) % 2), 0.1 * (i % 3),
+                    vector<double>(theta.begin(), theta.begin() + 1 + i % 4),
+                    vector<double>(phi.begin(), phi.begin() + 1 + i % 4));
+      }
+    }
+  }
+
+  AsyncEvaluationService service;
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    service.submit(State(0, positive), cascade_0_J_0(2, 0.), theta, {0.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AsyncEvaluationService(1, microseconds(0), 0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AsyncEvaluationService(1, microseconds(0), 1, nullptr);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
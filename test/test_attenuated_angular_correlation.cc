@@ -0,0 +1,156 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "AttenuatedAngularCorrelation.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+void test_attenuated_angular_correlation(const AngularCorrelation &ang_cor) {
+
+  const size_t n_orders = ang_cor.get_nu_max() / 2 + 1;
+  const size_t n = 50;
+  vector<double> theta(n), phi(n), result(n);
+  for (size_t i = 0; i < n; ++i) {
+    theta[i] = M_PI * i / (n - 1.);
+    phi[i] = 2. * M_PI * ((7 * i) % n) / n;
+  }
+
+  // Without attenuation, the original angular correlation is recovered.
+  // Additional coefficients are ignored.
+  const AttenuatedAngularCorrelation point_detectors(
+      ang_cor, vector<double>(n_orders + 2, 1.));
+  assert(point_detectors.get_attenuation().size() == n_orders);
+  point_detectors.evaluate(n, theta.data(), phi.data(), result.data());
+  for (size_t i = 0; i < n; ++i) {
+    test_numerical_equality<double>(result[i], ang_cor(theta[i], phi[i]),
+                                    1e-12);
+    test_numerical_equality<double>(point_detectors(theta[i], phi[i]),
+                                    result[i], 1e-14);
+  }
+
+  // If all higher orders are suppressed, the angular correlation is isotropic.
+  vector<double> isotropic(n_orders, 0.);
+  isotropic[0] = 1.;
+  const AttenuatedAngularCorrelation isotropic_detectors(ang_cor, isotropic);
+  for (size_t i = 0; i < n; ++i) {
+    test_numerical_equality<double>(isotropic_detectors(theta[i], phi[i]), 1.,
+                                    1e-12);
+  }
+
+  // A cone-shaped detector and a point detector measure the mean value of the
+  // angular correlation inside the cone.
+  for (auto alpha : {0.1, 0.7, 2.}) {
+    const vector<double> q_cone =
+        AttenuatedAngularCorrelation::cone_attenuation_coefficients(
+            ang_cor.get_nu_max(), alpha);
+    assert(q_cone.size() == n_orders);
+    assert(q_cone[0] == 1.);
+
+    const AttenuatedAngularCorrelation cone_detector(
+        ang_cor, q_cone, vector<double>(n_orders, 1.));
+    for (size_t i = 0; i < n; ++i) {
+      test_numerical_equality<double>(
+          cone_detector(theta[i], phi[i]),
+          ang_cor.integrate_cone({theta[i], phi[i]}, alpha) /
+              (2. * M_PI * (1. - cos(alpha))),
+          1e-12);
+    }
+
+    // For two detectors, the attenuation coefficients are multiplied.
+    const AttenuatedAngularCorrelation two_cone_detectors(ang_cor, q_cone,
+                                                          q_cone);
+    for (size_t i = 0; i < n_orders; ++i) {
+      test_numerical_equality<double>(two_cone_detectors.get_attenuation()[i],
+                                      q_cone[i] * q_cone[i], 1e-14);
+    }
+  }
+
+  // Too few attenuation coefficients.
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    AttenuatedAngularCorrelation(ang_cor, vector<double>(n_orders - 1, 1.));
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AttenuatedAngularCorrelation(ang_cor, vector<double>(n_orders, 1.),
+                                 vector<double>(n_orders - 1, 1.));
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
+
+int main() {
+
+  // Dir-dir correlation
+  test_attenuated_angular_correlation(AngularCorrelation(
+      State(3, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.3),
+        State(5, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, -0.7),
+        State(3, parity_unknown)}}));
+
+  // Pol-dir correlation
+  test_attenuated_angular_correlation(AngularCorrelation(
+      State(4, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.5), State(6, positive)},
+       {Transition(magnetic, 2, electric, 4, 2.), State(4, positive)}}));
+
+  // Unobserved intermediate transition
+  test_attenuated_angular_correlation(AngularCorrelation(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.4), State(4, positive)},
+       {Transition(magnetic, 2, electric, 4, -0.2), State(4, positive)}}));
+
+  // Invalid opening angles
+  for (auto alpha : {0., -0.1, 4.}) {
+    [[maybe_unused]] bool error_thrown = false;
+    try {
+      AttenuatedAngularCorrelation::cone_attenuation_coefficients(4, alpha);
+    } catch (const invalid_argument &e) {
+      error_thrown = true;
+    }
+    assert(error_thrown);
+  }
+}
@@ -33,4 +33,31 @@ int main() {
   assert(av_coef.string_representation() == str_rep);
   assert(av_coef.string_representation(3) ==
          "1+2\\times0\\times\\delta+1\\times\\delta^{2}");
+
+  // Evaluation without an object gives the same result, also for a pure
+  // transition where the terms with L' are skipped.
+  for (int two_nu = 0; two_nu <= 8; two_nu += 4) {
+    const AvCoefficient av(two_nu, 4, 6, 0, 4);
+    for (const double delta : {0., 0.3, -2.1}) {
+      assert(AvCoefficient::evaluate(two_nu, 4, 6, 0, 4, delta) == av(delta));
+    }
+  }
+
+  // The terms with L' are calculated on demand. Copies made before and after
+  // that, and an object restored from the values, give the same results.
+  const AvCoefficient lazy(4, 4, 6, 0, 4);
+  const AvCoefficient lazy_copy(lazy);
+  const double av_0 = lazy(0.);
+  const double av_delta = lazy(0.3);
+  const AvCoefficient calculated_copy(lazy);
+  const AvCoefficient restored(4, 4, 6, 0, 4, lazy.get_f_values());
+  assert(av_0 == lazy.get_constant_coefficient());
+  assert(av_0 == lazy.get_constant_f_value());
+  assert(lazy_copy(0.3) == av_delta);
+  assert(calculated_copy(0.3) == av_delta);
+  assert(restored(0.3) == av_delta);
+  assert(AvCoefficient(4, 4, 6, 0, 4).derivative(0.) ==
+         lazy.get_linear_coefficient());
+  assert(AvCoefficient(4, 4, 6, 0, 4).string_representation(3) ==
+         restored.string_representation(3));
 }
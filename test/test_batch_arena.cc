@@ -0,0 +1,166 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <cstdint>
+
+using std::uint64_t;
+
+#include <memory>
+
+using std::dynamic_pointer_cast;
+using std::make_shared;
+using std::shared_ptr;
+
+#include <optional>
+
+using std::optional;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "BatchArena.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+#include "W_pol_dir.hh"
+
+extern "C" {
+int create_angular_correlation_handles(const size_t n_cascades,
+                                       size_t *offsets, int *two_J, short *par,
+                                       short *em_char, int *two_L,
+                                       short *em_charp, int *two_Lp,
+                                       double *delta, uint64_t *handles);
+void *get_angular_correlation_from_handle(const uint64_t handle);
+size_t release_angular_correlation_handles(const size_t n, uint64_t *handles);
+}
+
+int main() {
+  const State initial_state(0, positive);
+  const vector<pair<Transition, State>> pol_dir{
+      {Transition(electric, 2, magnetic, 4, 0.1), State(2, negative)},
+      {Transition(electric, 2, magnetic, 4, -0.3), State(0, positive)}};
+  const vector<pair<Transition, State>> dir_dir{
+      {Transition(2, 4, 0.1), State(2)},
+      {Transition(2, 4, -0.3), State(0)}};
+  const vector<State> states{State(2, negative), State(0, positive)};
+  const AngularCorrelation pol_dir_reference(initial_state, pol_dir);
+  const AngularCorrelation dir_dir_reference(initial_state, dir_dir);
+  const AngularCorrelation inferred_reference(initial_state, states);
+
+  // All coefficient cores of a batch fit into the arena.
+  shared_ptr<BatchArena> arena = make_shared<BatchArena>(
+      3, AngularCorrelation::batch_arena_slot_size);
+  optional<AngularCorrelation> pol_dir_batch, dir_dir_batch, inferred_batch;
+  assert(AngularCorrelation::try_create(
+             initial_state, pol_dir, pol_dir_batch,
+             BatchArena::Allocator<char>(arena, 0)) == cascade_valid);
+  assert(AngularCorrelation::try_create(
+             initial_state, dir_dir, dir_dir_batch,
+             BatchArena::Allocator<char>(arena, 1)) == cascade_valid);
+  assert(AngularCorrelation::try_create(
+             initial_state, states, inferred_batch,
+             BatchArena::Allocator<char>(arena, 2)) == cascade_valid);
+  assert(arena->get_n_heap_allocations() == 0);
+  assert(dynamic_pointer_cast<const W_pol_dir>(
+      pol_dir_batch->get_w_gamma_gamma()));
+  assert(!dynamic_pointer_cast<const W_pol_dir>(
+      dir_dir_batch->get_w_gamma_gamma()));
+
+  // The angular correlations keep the arena alive.
+  arena.reset();
+  for (double theta = 0.1; theta < 3.; theta += 0.5) {
+    for (double phi = 0.; phi < 6.; phi += 0.7) {
+      test_numerical_equality<double>((*pol_dir_batch)(theta, phi),
+                                      pol_dir_reference(theta, phi), 1e-12);
+      test_numerical_equality<double>((*dir_dir_batch)(theta, phi),
+                                      dir_dir_reference(theta, phi), 1e-12);
+      test_numerical_equality<double>((*inferred_batch)(theta, phi),
+                                      inferred_reference(theta, phi), 1e-12);
+    }
+  }
+
+  // Copies share the core until it is modified.
+  AngularCorrelation copy = *pol_dir_batch;
+  copy.set_delta(0, 0.5);
+  AngularCorrelation modified_reference = pol_dir_reference;
+  modified_reference.set_delta(0, 0.5);
+  test_numerical_equality<double>(copy(0.5, 0.2),
+                                  modified_reference(0.5, 0.2), 1e-12);
+  test_numerical_equality<double>((*pol_dir_batch)(0.5, 0.2),
+                                  pol_dir_reference(0.5, 0.2), 1e-12);
+  pol_dir_batch->set_delta(1, 0.2);
+  modified_reference = pol_dir_reference;
+  modified_reference.set_delta(1, 0.2);
+  test_numerical_equality<double>((*pol_dir_batch)(0.5, 0.2),
+                                  modified_reference(0.5, 0.2), 1e-12);
+  pol_dir_batch.reset();
+  dir_dir_batch.reset();
+  modified_reference = pol_dir_reference;
+  modified_reference.set_delta(0, 0.5);
+  test_numerical_equality<double>(copy(0.5, 0.2),
+                                  modified_reference(0.5, 0.2), 1e-12);
+
+  // A slot that is too small only costs heap allocations.
+  arena = make_shared<BatchArena>(1, 0);
+  const BatchArena::Allocator<char> heap_allocator(arena, 0);
+  optional<AngularCorrelation> heap;
+  assert(AngularCorrelation::try_create(initial_state, pol_dir, heap,
+                                        heap_allocator) == cascade_valid);
+  assert(arena->get_n_heap_allocations() == 2);
+  test_numerical_equality<double>((*heap)(0.5, 0.2),
+                                  pol_dir_reference(0.5, 0.2), 1e-12);
+
+  // An invalid cascade resets the angular correlation.
+  const vector<pair<Transition, State>> invalid{
+      {Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+      {Transition(electric, 2, magnetic, 4, 0.), State(8, positive)}};
+  assert(AngularCorrelation::try_create(initial_state, invalid, heap,
+                                        heap_allocator) != cascade_valid);
+  assert(!heap);
+
+  // Batches from the C interface.
+  size_t offsets[4]{0, 2, 4, 6};
+  int two_J[9]{0, 2, 0, 0, 2, 0, 0, 2, 0};
+  short par[9]{positive, negative, positive, positive, negative,
+               positive, positive, negative, positive};
+  short em_char[6]{electric, electric, electric, electric, electric, electric};
+  int two_L[6]{2, 2, 2, 2, 2, 2};
+  short em_charp[6]{magnetic, magnetic, magnetic, magnetic, magnetic, magnetic};
+  int two_Lp[6]{4, 4, 4, 4, 4, 4};
+  double delta[6]{0.1, -0.3, 0.1, -0.3, 0.1, -0.3};
+  uint64_t handles[3];
+  assert(create_angular_correlation_handles(3, offsets, two_J, par, em_char,
+                                            two_L, em_charp, two_Lp, delta,
+                                            handles) == cascade_valid);
+  for (size_t k = 0; k < 3; ++k) {
+    test_numerical_equality<double>(
+        (*(AngularCorrelation *)get_angular_correlation_from_handle(
+            handles[k]))(0.5, 0.2),
+        pol_dir_reference(0.5, 0.2), 1e-12);
+  }
+  assert(release_angular_correlation_handles(3, handles) == 3);
+}
@@ -0,0 +1,189 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <memory>
+
+using std::dynamic_pointer_cast;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_sf.h>
+
+#include "AngularCorrelation.hh"
+#include "LegendreSeries.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+#include "W_dir_dir.hh"
+#include "W_pol_dir.hh"
+
+/**
+ * Compare the batch evaluation of an angular correlation to the call operator.
+ * The number of directions is not a multiple of the block size to test the
+ * handling of incomplete blocks.
+ */
+void test_batch_evaluation(const AngularCorrelation &ang_cor) {
+
+  const size_t n = 3 * legendre_series::block_size + 7;
+  vector<double> theta(n), phi(n), result(n);
+  for (size_t i = 0; i < n; ++i) {
+    theta[i] = M_PI * i / (n - 1.);
+    phi[i] = 2. * M_PI * ((7 * i) % n) / n;
+  }
+
+  ang_cor.evaluate(n, theta.data(), phi.data(), result.data());
+
+  for (size_t i = 0; i < n; ++i) {
+    test_numerical_equality<double>(result[i], ang_cor(theta[i], phi[i]),
+                                    1e-10);
+  }
+
+  // Same with the cosines of the polar angles as input.
+  vector<double> cos_theta(n), result_cos_theta(n);
+  for (size_t i = 0; i < n; ++i) {
+    cos_theta[i] = cos(theta[i]);
+  }
+
+  ang_cor.evaluate_cos_theta(n, cos_theta.data(), phi.data(),
+                             result_cos_theta.data());
+
+  for (size_t i = 0; i < n; ++i) {
+    test_numerical_equality<double>(result_cos_theta[i], result[i], 1e-12);
+  }
+
+  // Same with unit vectors as input.
+  vector<double> xyz(3 * n), result_xyz(n);
+  for (size_t i = 0; i < n; ++i) {
+    xyz[3 * i] = sin(theta[i]) * cos(phi[i]);
+    xyz[3 * i + 1] = sin(theta[i]) * sin(phi[i]);
+    xyz[3 * i + 2] = cos(theta[i]);
+  }
+
+  ang_cor.evaluate(n, xyz.data(), result_xyz.data());
+
+  for (size_t i = 0; i < n; ++i) {
+    test_numerical_equality<double>(result_xyz[i], result[i], 1e-12);
+    test_numerical_equality<double>(
+        ang_cor.evaluate({xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2]}),
+        result[i], 1e-12);
+  }
+
+  // Rotated angular correlation
+  const array<double, 3> Phi_Theta_Psi{0.3, 1.2, -0.7};
+  vector<double> result_rotated(n);
+  ang_cor.evaluate(n, theta.data(), phi.data(), Phi_Theta_Psi,
+                   result_rotated.data());
+  ang_cor.evaluate(n, xyz.data(), Phi_Theta_Psi, result_xyz.data());
+
+  for (size_t i = 0; i < n; ++i) {
+    test_numerical_equality<double>(result_xyz[i], result_rotated[i], 1e-12);
+  }
+
+  // Same in single precision.
+  vector<float> cos_theta_float(cos_theta.begin(), cos_theta.end()),
+      phi_float(phi.begin(), phi.end()), result_float(n);
+  const auto w_gamma_gamma = ang_cor.get_w_gamma_gamma();
+  if (const auto w_pol_dir =
+          dynamic_pointer_cast<const W_pol_dir>(w_gamma_gamma)) {
+    w_pol_dir->evaluate_cos_theta(n, cos_theta_float.data(), phi_float.data(),
+                                  result_float.data());
+  } else {
+    dynamic_pointer_cast<const W_dir_dir>(w_gamma_gamma)
+        ->evaluate_cos_theta(n, cos_theta_float.data(), phi_float.data(),
+                             result_float.data());
+  }
+
+  const double float_tolerance =
+      legendre_series::float_relative_error * w_gamma_gamma->get_upper_limit();
+  for (size_t i = 0; i < n; ++i) {
+    test_numerical_equality<double>(result_float[i], result[i],
+                                    float_tolerance);
+  }
+}
+
+int main() {
+
+  // Test the Legendre series with a single nonzero coefficient against GSL.
+  const size_t n_x = 101;
+  vector<double> x(n_x), result(n_x);
+  for (size_t k = 0; k < n_x; ++k) {
+    x[k] = -1. + 2. * k / (n_x - 1.);
+  }
+
+  for (size_t i = 0; i < 10; ++i) {
+    vector<double> coefficients(i + 1, 0.);
+    coefficients[i] = 1.;
+
+    legendre_series::legendre(n_x, x.data(), i + 1, coefficients.data(),
+                              result.data());
+    for (size_t k = 0; k < n_x; ++k) {
+      test_numerical_equality<double>(
+          result[k], gsl_sf_legendre_Pl(2 * i, x[k]), 1e-10);
+    }
+
+    legendre_series::associated_legendre_2(
+        n_x, x.data(), i + 1, coefficients.data(), result.data());
+    for (size_t k = 0; k < n_x; ++k) {
+      test_numerical_equality<double>(
+          result[k], gsl_sf_legendre_Plm(2 * i + 2, 2, x[k]), 1e-8);
+    }
+  }
+
+  // Dir-dir correlation
+  test_batch_evaluation(AngularCorrelation(
+      State(3, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.3),
+        State(5, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, -0.7),
+        State(3, parity_unknown)}}));
+
+  // Pol-dir correlations with both possible EM characters
+  test_batch_evaluation(AngularCorrelation(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}}));
+  test_batch_evaluation(AngularCorrelation(
+      State(4, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.5), State(6, positive)},
+       {Transition(magnetic, 2, electric, 4, 2.), State(4, positive)}}));
+
+  // Higher orders of the expansion
+  test_batch_evaluation(AngularCorrelation(
+      State(0, positive),
+      {{Transition(magnetic, 6, electric, 8, 0.), State(6, positive)},
+       {Transition(magnetic, 6, electric, 8, 0.), State(0, positive)}}));
+
+  // Unobserved intermediate transition
+  test_batch_evaluation(AngularCorrelation(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.4), State(4, positive)},
+       {Transition(magnetic, 2, electric, 4, -0.2), State(4, positive)}}));
+}
@@ -0,0 +1,137 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "CascadeHypothesisScanner.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Check that all hypotheses describe valid cascades, and compare the
+ * evaluation from the coefficient table to the angular correlations.
+ */
+void test_hypotheses(CascadeHypothesisScanner &scanner) {
+
+  scanner.scan(1);
+  const vector<double> coefficients_single_thread = scanner.get_coefficients();
+  scanner.scan(4);
+  assert(scanner.get_coefficients() == coefficients_single_thread);
+  assert(scanner.get_offsets().size() == scanner.get_n_hypotheses() + 1);
+  assert(scanner.get_offsets().back() == scanner.get_coefficients().size());
+
+  const vector<double> theta{0.1, 0.8, 0.5 * M_PI, 2.7};
+  const vector<double> phi{0., 1.3, 0.25 * M_PI, 5.};
+  vector<double> result(theta.size());
+
+  for (size_t k = 0; k < scanner.get_n_hypotheses(); ++k) {
+    const vector<State> states = scanner.get_states(k);
+    assert(states.size() == scanner.get_n_levels());
+
+    // The inferred cascade passes all checks of the full constructor.
+    const AngularCorrelation ang_cor = scanner.get_angular_correlation(k);
+    const AngularCorrelation ang_cor_checked(states[0],
+                                             ang_cor.get_cascade_steps());
+    assert(ang_cor.get_nu_max() / 2 + 1 ==
+           (int)scanner.get_n_legendre_coefficients()[k]);
+
+    scanner.evaluate(k, theta.size(), theta.data(), phi.data(), result.data());
+    for (size_t i = 0; i < theta.size(); ++i) {
+      test_numerical_equality<double>(result[i], ang_cor(theta[i], phi[i]),
+                                      1e-12);
+    }
+  }
+}
+
+int main() {
+
+  // 0+ -> J -> 0+ with J <= 3. Transitions between two spin-0 states and
+  // octupole transitions are rejected.
+  const vector<State> candidates =
+      CascadeHypothesisScanner::spin_parity_candidates(0, 6);
+  assert(candidates.size() == 8);
+  CascadeHypothesisScanner scanner_0_J_0(
+      {{State(0, positive)}, candidates, {State(0, positive)}});
+  assert(scanner_0_J_0.get_n_hypotheses() == 4);
+  assert(scanner_0_J_0.get_states(0)[1].two_J == 2);
+  assert(scanner_0_J_0.get_states(0)[1].parity == negative);
+  assert(scanner_0_J_0.get_states(3)[1].two_J == 4);
+  assert(scanner_0_J_0.get_states(3)[1].parity == positive);
+  test_hypotheses(scanner_0_J_0);
+
+  // Octupole transitions are accepted if requested.
+  assert(CascadeHypothesisScanner(
+             {{State(0, positive)}, candidates, {State(0, positive)}}, 6)
+             .get_n_hypotheses() == 6);
+
+  // Integer and half-integer angular momenta are not mixed.
+  CascadeHypothesisScanner scanner_half_integer(
+      {{State(3, positive)},
+       {State(2, positive), State(5, positive), State(5, negative)},
+       {State(3, positive), State(4, positive)}});
+  assert(scanner_half_integer.get_n_hypotheses() == 2);
+  test_hypotheses(scanner_half_integer);
+
+  // Unknown parities and a cascade with an unobserved intermediate
+  // transition.
+  CascadeHypothesisScanner scanner_4_levels(
+      {{State(0, positive)},
+       CascadeHypothesisScanner::spin_parity_candidates(2, 6),
+       CascadeHypothesisScanner::spin_parity_candidates(0, 8,
+                                                        {parity_unknown}),
+       {State(0, positive), State(4, positive)}});
+  assert(scanner_4_levels.get_n_hypotheses() > 0);
+  test_hypotheses(scanner_4_levels);
+
+  // Invalid input
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    CascadeHypothesisScanner({{State(0, positive)}, candidates});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  CascadeHypothesisScanner not_scanned(
+      {{State(0, positive)}, candidates, {State(0, positive)}});
+  double theta = 0., phi = 0., result;
+  try {
+    not_scanned.evaluate(0, 1, &theta, &phi, &result);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -0,0 +1,201 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "CascadeMixture.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * 0+ -> 1- -> 0+, pol-dir.
+ */
+const AngularCorrelation branch_1(
+    State(0, positive),
+    {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+     {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+
+/**
+ * 0+ -> 2+ -> 0+, pol-dir.
+ */
+const AngularCorrelation branch_2(
+    State(0, positive),
+    {{Transition(electric, 4, magnetic, 6, 0.), State(4, positive)},
+     {Transition(electric, 4, magnetic, 6, 0.), State(0, positive)}});
+
+/**
+ * 0 -> 2 -> 0, dir-dir.
+ */
+const AngularCorrelation branch_3(
+    State(0, parity_unknown),
+    {{Transition(em_unknown, 4, em_unknown, 6, 0.), State(4, parity_unknown)},
+     {Transition(em_unknown, 4, em_unknown, 6, 0.),
+      State(0, parity_unknown)}});
+
+int main() {
+  const double epsilon = 1e-10;
+
+  CascadeMixture mixture({branch_1, branch_2, branch_3}, {1., 2., 1.},
+                         {0, 1, 1}, 1);
+  assert(mixture.get_n_branches() == 3);
+  assert(mixture.get_n_observables() == 2);
+  assert(mixture.get_observable(1) == 1);
+  test_numerical_equality<double>(mixture.get_weight(0), 0.25, epsilon);
+  test_numerical_equality<double>(mixture.get_weight(1), 0.5, epsilon);
+  test_numerical_equality<double>(mixture.get_observable_probability(0), 0.25,
+                                  epsilon);
+  test_numerical_equality<double>(mixture.get_observable_probability(1), 0.75,
+                                  epsilon);
+  test_numerical_equality<double>(
+      mixture.get_upper_limit(),
+      0.25 * branch_1.get_upper_limit() + 0.5 * branch_2.get_upper_limit() +
+          0.25 * branch_3.get_upper_limit(),
+      epsilon);
+  assert(mixture.get_mixture().get_nu_max() == 4);
+  assert(mixture.get_mixture().is_polarized());
+  assert(mixture.get_observable_mixture(0).get_nu_max() == 2);
+
+  // The collapsed expansions are the weighted sums of the branches.
+  const vector<double> theta{0., 0.3, 0.5 * M_PI, 2.},
+      phi{0., 1., 0.5 * M_PI, 4.};
+  vector<double> w(theta.size()), w_0(theta.size()), w_1(theta.size());
+  mixture.evaluate(theta.size(), theta.data(), phi.data(), w.data());
+  mixture.evaluate(0, theta.size(), theta.data(), phi.data(), w_0.data());
+  mixture.evaluate(1, theta.size(), theta.data(), phi.data(), w_1.data());
+  for (size_t i = 0; i < theta.size(); ++i) {
+    const double w_branch_1 = 0.25 * branch_1(theta[i], phi[i]),
+                 w_branch_2 = 0.5 * branch_2(theta[i], phi[i]),
+                 w_branch_3 = 0.25 * branch_3(theta[i], phi[i]);
+    test_numerical_equality<double>(
+        w[i], w_branch_1 + w_branch_2 + w_branch_3, epsilon);
+    test_numerical_equality<double>(mixture(theta[i], phi[i]), w[i],
+                                    epsilon);
+    test_numerical_equality<double>(w_0[i], w_branch_1, epsilon);
+    test_numerical_equality<double>(w_1[i], w_branch_2 + w_branch_3,
+                                    epsilon);
+  }
+
+  // The frequencies of the sampled branches are given by the weights, and
+  // the sampled directions follow the combined distribution.
+  // For a normalized distribution, the expectation value of
+  // P_2[cos(theta)] is c_1 / (5 c_0).
+  const size_t n = 100000;
+  vector<size_t> branches(n);
+  vector<double> theta_sampled(n), phi_sampled(n);
+  mixture.sample(n, branches.data(), theta_sampled.data(), phi_sampled.data());
+  array<size_t, 3> n_branch{0, 0, 0};
+  double p_2 = 0.;
+  for (size_t i = 0; i < n; ++i) {
+    ++n_branch[branches[i]];
+    const double cos_theta = cos(theta_sampled[i]);
+    p_2 += 0.5 * (3. * cos_theta * cos_theta - 1.);
+  }
+  for (size_t j = 0; j < 3; ++j) {
+    test_numerical_equality<double>(static_cast<double>(n_branch[j]) / n,
+                                    mixture.get_weight(j), 1e-2);
+  }
+  const vector<double> c = mixture.get_mixture().get_legendre_coefficients();
+  test_numerical_equality<double>(p_2 / n, c[1] / (5. * c[0]), 1e-2);
+
+  // Reseeding reproduces the sequence, and the block mode gives the same
+  // result as consecutive calls.
+  mixture.reseed(1);
+  for (size_t i = 0; i < 100; ++i) {
+    const pair<size_t, array<double, 2>> event = mixture.sample();
+    assert(event.first == branches[i]);
+    assert(event.second[0] == theta_sampled[i]);
+    assert(event.second[1] == phi_sampled[i]);
+  }
+
+  // A branch with zero weight is never sampled.
+  CascadeMixture single({branch_1, branch_2}, {0., 1.});
+  assert(single.get_n_observables() == 1);
+  for (size_t i = 0; i < 1000; ++i) {
+    assert(single.sample_branch() == 1);
+  }
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    CascadeMixture({}, {});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    CascadeMixture({branch_1, branch_2}, {1.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    CascadeMixture({branch_1, branch_2}, {1., 1.}, {0});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    CascadeMixture({branch_1, branch_2}, {1., -1.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    CascadeMixture({branch_1, branch_2}, {0., 0.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    mixture.evaluate(2, theta.size(), theta.data(), phi.data(), w.data());
+  } catch (const out_of_range &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -0,0 +1,165 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "CascadePrefixBuilder.hh"
+#include "State.hh"
+#include "Transition.hh"
+
+/**
+ * Set the steps of the builder from the given step on, and compare the
+ * coefficients bit by bit to an AngularCorrelation object.
+ */
+void test_cascade(CascadePrefixBuilder &builder, const State &initial_state,
+                  const vector<pair<Transition, State>> &cascade_steps,
+                  const size_t first_step = 0) {
+  if (first_step == 0) {
+    builder.set_initial_state(initial_state);
+  }
+  for (size_t i = first_step; i < cascade_steps.size(); ++i) {
+    builder.set_step(i, cascade_steps[i].first, cascade_steps[i].second);
+    assert(builder.get_n_set_steps() == i + 1);
+  }
+
+  const AngularCorrelation ang_cor(initial_state, cascade_steps);
+  assert(builder.get_legendre_coefficients() ==
+         ang_cor.get_legendre_coefficients());
+  assert(builder.get_associated_legendre_coefficients() ==
+         ang_cor.get_associated_legendre_coefficients());
+}
+
+int main() {
+  // Direction-direction and polarization-direction correlations with two
+  // steps.
+  CascadePrefixBuilder two_steps(2);
+  assert(two_steps.get_n_steps() == 2);
+  test_cascade(two_steps, State(3),
+               {{Transition(2, 4, 0.3), State(5)},
+                {Transition(2, 4, -0.7), State(3)}});
+  test_cascade(
+      two_steps, State(0, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.2), State(2, positive)},
+       {Transition(magnetic, 2, electric, 4, 1.4), State(4, positive)}});
+  test_cascade(
+      two_steps, State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+
+  // Replacing only the last step reuses the excitation.
+  test_cascade(
+      two_steps, State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, -2.1), State(4, positive)}},
+      1);
+
+  // Cascades with unobserved intermediate transitions. The prefix of the
+  // first two steps is shared.
+  CascadePrefixBuilder four_steps(4);
+  const State initial_state(1, positive);
+  const pair<Transition, State> excitation{
+      Transition(magnetic, 2, electric, 4, 0.5), State(3, positive)};
+  const pair<Transition, State> intermediate{
+      Transition(electric, 4, magnetic, 6, -0.4), State(7, positive)};
+  test_cascade(
+      four_steps, initial_state,
+      {excitation,
+       intermediate,
+       {Transition(magnetic, 2, electric, 4, 0.1), State(5, positive)},
+       {Transition(magnetic, 2, electric, 4, 2.), State(3, positive)}});
+  test_cascade(
+      four_steps, initial_state,
+      {excitation,
+       intermediate,
+       {Transition(electric, 2, magnetic, 4, 0.), State(9, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.3), State(7, positive)}},
+      2);
+  test_cascade(
+      four_steps, initial_state,
+      {excitation,
+       intermediate,
+       {Transition(electric, 2, magnetic, 4, 0.), State(9, negative)},
+       {Transition(electric, 4, magnetic, 6, -1.1), State(5, negative)}},
+      3);
+
+  // A three-step cascade with an unknown EM character has no associated
+  // Legendre coefficients.
+  CascadePrefixBuilder three_steps(3);
+  test_cascade(three_steps, State(4),
+               {{Transition(4, 6, 0.2), State(6)},
+                {Transition(2, 4, 0.6), State(4)},
+                {Transition(4, 6, -0.3), State(0)}});
+  assert(three_steps.get_associated_legendre_coefficients().empty());
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    CascadePrefixBuilder(1);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  CascadePrefixBuilder incomplete(3);
+  error_thrown = false;
+  try {
+    incomplete.set_step(0, Transition(2, 4, 0.), State(2));
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  incomplete.set_initial_state(State(0));
+  error_thrown = false;
+  try {
+    incomplete.set_step(1, Transition(2, 4, 0.), State(2));
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  incomplete.set_step(0, Transition(2, 4, 0.), State(2));
+  error_thrown = false;
+  try {
+    incomplete.get_legendre_coefficients();
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    incomplete.set_step(3, Transition(2, 4, 0.), State(2));
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -21,20 +21,49 @@
 
 using std::array;
 
+#include <cassert>
+
+#include <cmath>
+
 #include <memory>
 
 using std::make_shared;
 using std::shared_ptr;
 
+#include <utility>
+
+using std::pair;
+
 #include <vector>
 
 using std::vector;
 
 #include <gsl/gsl_math.h>
 
+#include "AngCorrRejectionSampler.hh"
+#include "AngularCorrelation.hh"
 #include "CascadeSampler.hh"
 #include "DeterministicReferenceFrameSampler.hh"
+#include "SphereRejectionSampler.hh"
+#include "SpotlightSampler.hh"
+#include "State.hh"
 #include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Create a cascade sampler with an isotropic first step and two angular
+ * correlations, whose random number generators are initialized with the given
+ * seed.
+ */
+CascadeSampler create_cascade_sampler(AngularCorrelation &ang_cor_1,
+                                      AngularCorrelation &ang_cor_2,
+                                      const int seed) {
+  return CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+      make_shared<SphereRejectionSampler>(
+          [](const double, const double) { return 1.; }, 1., seed),
+      make_shared<AngCorrRejectionSampler>(ang_cor_1, seed + 1),
+      make_shared<AngCorrRejectionSampler>(ang_cor_2, seed + 2)});
+}
 
 int main() {
   const double epsilon = 1e-8;
@@ -51,4 +80,228 @@ int main() {
       3, cascade[0].data(), array<double, 3>{0, -M_PI_2, 0}.data(), epsilon);
   test_numerical_equality<double>(3, cascade[1].data(),
                                   array<double, 3>{0, M_PI, 0}.data(), epsilon);
-}
\ No newline at end of file
+
+  // The batch mode gives the same result as consecutive calls of the call
+  // operator. The number of events is not a multiple of the block size to test
+  // the handling of incomplete blocks.
+  AngularCorrelation ang_cor_1(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+  AngularCorrelation ang_cor_2(
+      State(4, positive),
+      {{Transition(electric, 4, magnetic, 6, 0.), State(0, positive)},
+       {Transition(electric, 4, magnetic, 6, 0.), State(4, positive)}});
+
+  CascadeSampler cascade_sampler_single =
+      create_cascade_sampler(ang_cor_1, ang_cor_2, 0);
+  CascadeSampler cascade_sampler_batch =
+      create_cascade_sampler(ang_cor_1, ang_cor_2, 0);
+
+  const size_t n_events = 2 * CascadeSampler::block_size + 5;
+  const size_t n_steps = 3;
+  vector<double> Phi_Theta_Psi(3 * n_steps * n_events);
+  cascade_sampler_batch.sample(n_events, Phi_Theta_Psi.data());
+
+  for (size_t k = 0; k < n_events; ++k) {
+    const vector<array<double, 3>> cascade_single = cascade_sampler_single();
+    for (size_t i = 0; i < n_steps; ++i) {
+      for (size_t j = 0; j < 3; ++j) {
+        test_numerical_equality<double>(
+            Phi_Theta_Psi[(3 * i + j) * n_events + k], cascade_single[i][j],
+            epsilon);
+      }
+    }
+  }
+
+  // The weighted block mode gives the same result as consecutive calls of the
+  // weighted call operator.
+  CascadeSampler cascade_sampler_weighted_single =
+      create_cascade_sampler(ang_cor_1, ang_cor_2, 0);
+  CascadeSampler cascade_sampler_weighted_batch =
+      create_cascade_sampler(ang_cor_1, ang_cor_2, 0);
+
+  vector<double> weights(n_events), weights_euler(n_events);
+  cascade_sampler_weighted_batch.sample_weighted(
+      n_events, Phi_Theta_Psi.data(), n_events, weights.data());
+
+  for (size_t k = 0; k < n_events; ++k) {
+    const pair<double, vector<array<double, 3>>> cascade_single =
+        cascade_sampler_weighted_single.sample_weighted();
+    test_numerical_equality<double>(weights[k], cascade_single.first, epsilon);
+    for (size_t i = 0; i < n_steps; ++i) {
+      for (size_t j = 0; j < 3; ++j) {
+        test_numerical_equality<double>(
+            Phi_Theta_Psi[(3 * i + j) * n_events + k],
+            cascade_single.second[i][j], epsilon);
+      }
+    }
+  }
+  test_numerical_equality<double>(
+      cascade_sampler_weighted_batch.get_sum_of_weights(),
+      cascade_sampler_weighted_single.get_sum_of_weights(), epsilon);
+  test_numerical_equality<double>(
+      cascade_sampler_weighted_batch.get_sum_of_squared_weights(),
+      cascade_sampler_weighted_single.get_sum_of_squared_weights(), epsilon);
+
+  // The rotation matrices are the same as the ones of the Euler angles, both
+  // for single cascades and in the block mode. The direction and the
+  // polarization axis are orthogonal unit vectors.
+  for (const bool spotlight : {false, true}) {
+    CascadeSampler cascade_sampler_euler =
+        spotlight ? CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+                        make_shared<SpotlightSampler>(
+                            array<double, 2>{0.5, 0.2}, 0.1, 0),
+                        make_shared<AngCorrRejectionSampler>(ang_cor_1, 1)})
+                  : create_cascade_sampler(ang_cor_1, ang_cor_2, 0);
+    CascadeSampler cascade_sampler_matrix =
+        spotlight ? CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+                        make_shared<SpotlightSampler>(
+                            array<double, 2>{0.5, 0.2}, 0.1, 0),
+                        make_shared<AngCorrRejectionSampler>(ang_cor_1, 1)})
+                  : create_cascade_sampler(ang_cor_1, ang_cor_2, 0);
+    const size_t n_steps_matrix = cascade_sampler_matrix.get_n_steps();
+
+    vector<euler_angle_transform::RotationMatrix> A(n_steps_matrix * n_events);
+    cascade_sampler_matrix.sample_rotation_matrices(n_events, A.data(),
+                                                    n_events);
+    for (size_t k = 0; k < n_events; ++k) {
+      const vector<array<double, 3>> cascade_euler = cascade_sampler_euler();
+      for (size_t i = 0; i < n_steps_matrix; ++i) {
+        const euler_angle_transform::RotationMatrix A_euler =
+            euler_angle_transform::rotation_matrix(cascade_euler[i]);
+        test_numerical_equality(A[i * n_events + k], A_euler, epsilon);
+        const array<double, 3> r =
+            euler_angle_transform::direction(A[i * n_events + k]);
+        const array<double, 3> e =
+            euler_angle_transform::polarization_axis(A[i * n_events + k]);
+        test_numerical_equality<double>(r[0] * r[0] + r[1] * r[1] + r[2] * r[2],
+                                        1., epsilon);
+        test_numerical_equality<double>(e[0] * e[0] + e[1] * e[1] + e[2] * e[2],
+                                        1., epsilon);
+        test_numerical_equality<double>(r[0] * e[0] + r[1] * e[1] + r[2] * e[2],
+                                        0., epsilon);
+      }
+    }
+
+    const vector<euler_angle_transform::RotationMatrix> A_single =
+        cascade_sampler_matrix.sample_rotation_matrices();
+    const vector<array<double, 3>> cascade_euler = cascade_sampler_euler();
+    for (size_t i = 0; i < n_steps_matrix; ++i) {
+      test_numerical_equality(
+          A_single[i], euler_angle_transform::rotation_matrix(cascade_euler[i]),
+          epsilon);
+    }
+
+    const pair<double, vector<euler_angle_transform::RotationMatrix>>
+        A_weighted = cascade_sampler_matrix.sample_weighted_rotation_matrices();
+    const pair<double, vector<array<double, 3>>> cascade_euler_weighted =
+        cascade_sampler_euler.sample_weighted();
+    test_numerical_equality<double>(A_weighted.first,
+                                    cascade_euler_weighted.first, epsilon);
+    for (size_t i = 0; i < n_steps_matrix; ++i) {
+      test_numerical_equality(A_weighted.second[i],
+                              euler_angle_transform::rotation_matrix(
+                                  cascade_euler_weighted.second[i]),
+                              epsilon);
+    }
+
+    cascade_sampler_matrix.sample_weighted_rotation_matrices(
+        n_events, A.data(), n_events, weights.data());
+    cascade_sampler_euler.sample_weighted(n_events, Phi_Theta_Psi.data(),
+                                          n_events, weights_euler.data());
+    for (size_t k = 0; k < n_events; ++k) {
+      test_numerical_equality<double>(weights[k], weights_euler[k], epsilon);
+      for (size_t i = 0; i < n_steps_matrix; ++i) {
+        const euler_angle_transform::RotationMatrix A_euler =
+            euler_angle_transform::rotation_matrix(
+                {Phi_Theta_Psi[3 * i * n_events + k],
+                 Phi_Theta_Psi[(3 * i + 1) * n_events + k],
+                 Phi_Theta_Psi[(3 * i + 2) * n_events + k]});
+        test_numerical_equality(A[i * n_events + k], A_euler, epsilon);
+      }
+    }
+  }
+
+  // Since the angular correlations are normalized to 4 pi, the mean weight of
+  // a step is the inverse of the envelope, and the weights of the steps are
+  // independent.
+  const size_t n_weighted = 100000;
+  weights.resize(n_weighted);
+  Phi_Theta_Psi.resize(3 * n_steps * n_weighted);
+  cascade_sampler_weighted_batch.reset_weight_sums();
+  cascade_sampler_weighted_batch.sample_weighted(
+      n_weighted, Phi_Theta_Psi.data(), n_weighted, weights.data());
+  const double sum_of_weights =
+      cascade_sampler_weighted_batch.get_sum_of_weights();
+  const double sum_of_squared_weights =
+      cascade_sampler_weighted_batch.get_sum_of_squared_weights();
+  test_numerical_equality<double>(
+      sum_of_weights / n_weighted,
+      1. / (ang_cor_1.get_upper_limit() * ang_cor_2.get_upper_limit()), 5e-3);
+  test_numerical_equality<double>(
+      cascade_sampler_weighted_batch.get_effective_sample_size(),
+      sum_of_weights * sum_of_weights / sum_of_squared_weights, 1e-6);
+  assert(cascade_sampler_weighted_batch.get_effective_sample_size() <
+         n_weighted);
+
+  cascade_sampler_weighted_batch.reset_weight_sums();
+  assert(cascade_sampler_weighted_batch.get_sum_of_weights() == 0.);
+  assert(cascade_sampler_weighted_batch.get_effective_sample_size() == 0.);
+
+  // Weighted and unweighted samples give the same expectation value of
+  // cos^2(theta) for the direction of a single step.
+  CascadeSampler single_step_unweighted(
+      vector<shared_ptr<ReferenceFrameSampler>>{
+          make_shared<AngCorrRejectionSampler>(ang_cor_1, 1)});
+  CascadeSampler single_step_weighted(vector<shared_ptr<ReferenceFrameSampler>>{
+      make_shared<AngCorrRejectionSampler>(ang_cor_1, 2)});
+
+  double cos2_unweighted = 0., cos2_weighted = 0.;
+  for (size_t k = 0; k < n_weighted; ++k) {
+    const double cos_theta_unweighted = cos(
+        euler_angle_transform::to_spherical(single_step_unweighted()[0])[0]);
+    cos2_unweighted += cos_theta_unweighted * cos_theta_unweighted;
+
+    const pair<double, vector<array<double, 3>>> weighted =
+        single_step_weighted.sample_weighted();
+    const double cos_theta_weighted =
+        cos(euler_angle_transform::to_spherical(weighted.second[0])[0]);
+    cos2_weighted += weighted.first * cos_theta_weighted * cos_theta_weighted;
+  }
+  test_numerical_equality<double>(
+      cos2_unweighted / n_weighted,
+      cos2_weighted / single_step_weighted.get_sum_of_weights(), 5e-3);
+
+  // Statistics of the individual steps. The efficiency of the rejection
+  // sampling is the inverse of the envelope for normalized angular
+  // correlations.
+  CascadeSampler cascade_sampler_statistics =
+      create_cascade_sampler(ang_cor_1, ang_cor_2, 0);
+  cascade_sampler_statistics.enable_statistics();
+  assert(cascade_sampler_statistics.statistics_enabled());
+  Phi_Theta_Psi.resize(3 * n_steps * n_weighted);
+  cascade_sampler_statistics.sample(n_weighted, Phi_Theta_Psi.data());
+  cascade_sampler_statistics();
+  assert(cascade_sampler_statistics.get_n_events() == n_weighted + 1);
+  assert(cascade_sampler_statistics.get_step_statistics(0).get_acceptance() ==
+         1.);
+  test_numerical_equality<double>(
+      cascade_sampler_statistics.get_step_statistics(1).get_acceptance(),
+      1. / ang_cor_1.get_upper_limit(), 1e-2);
+  test_numerical_equality<double>(
+      cascade_sampler_statistics.get_step_statistics(2).get_acceptance(),
+      1. / ang_cor_2.get_upper_limit(), 1e-2);
+  for (size_t i = 0; i < n_steps; ++i) {
+    assert(cascade_sampler_statistics.get_step_statistics(i).n_accepted ==
+           n_weighted + 1);
+    assert(cascade_sampler_statistics.get_step_seconds(i) > 0.);
+  }
+
+  cascade_sampler_statistics.reset_statistics();
+  assert(cascade_sampler_statistics.get_n_events() == 0);
+  for (size_t i = 0; i < n_steps; ++i) {
+    assert(cascade_sampler_statistics.get_step_statistics(i).n_samples == 0);
+    assert(cascade_sampler_statistics.get_step_seconds(i) == 0.);
+  }
+}
@@ -0,0 +1,194 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <memory>
+
+using std::unique_ptr;
+
+#include <string>
+
+using std::string;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "State.hh"
+#include "Transition.hh"
+
+extern "C" {
+int validate_cascade(const size_t n_cas_ste, int *two_J, short *par,
+                     short *em_char, int *two_L, short *em_charp, int *two_Lp,
+                     const size_t message_length, char *message);
+void *try_create_angular_correlation(const size_t n_cas_ste, int *two_J,
+                                     short *par, short *em_char, int *two_L,
+                                     short *em_charp, int *two_Lp,
+                                     double *delta, int *status,
+                                     const size_t message_length,
+                                     char *message);
+void free_angular_correlation(AngularCorrelation *angular_correlation);
+}
+
+/**
+ * \brief Check that an invalid cascade is reported with the expected status,
+ * that the message is only formatted on request, and that the constructor
+ * throws the same message.
+ */
+void test_invalid_cascade(const State initial_state,
+                          const vector<pair<Transition, State>> cascade_steps,
+                          const CascadeStatus expected_status) {
+  assert(AngularCorrelation::validate(initial_state, cascade_steps) ==
+         expected_status);
+
+  string message = "unchanged";
+  assert(AngularCorrelation::validate(initial_state, cascade_steps, &message) ==
+         expected_status);
+  assert(message != "unchanged" && !message.empty());
+
+  unique_ptr<AngularCorrelation> ang_cor(
+      new AngularCorrelation(State(0), {State(2), State(0)}));
+  assert(AngularCorrelation::try_create(initial_state, cascade_steps,
+                                        ang_cor) == expected_status);
+  assert(ang_cor == nullptr);
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    AngularCorrelation(initial_state, cascade_steps);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+    assert(string(e.what()) == message);
+  }
+  assert(error_thrown);
+}
+
+int main() {
+
+  // Valid cascades
+  const vector<pair<Transition, State>> cascade_steps{
+      {Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+      {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}};
+  string message = "unchanged";
+  assert(AngularCorrelation::validate(State(0, positive), cascade_steps,
+                                      &message) == cascade_valid);
+  assert(message == "unchanged");
+
+  unique_ptr<AngularCorrelation> ang_cor;
+  assert(AngularCorrelation::try_create(State(0, positive), cascade_steps,
+                                        ang_cor) == cascade_valid);
+  assert(ang_cor != nullptr);
+  assert((*ang_cor)(0.4, 0.7) ==
+         AngularCorrelation(State(0, positive), cascade_steps)(0.4, 0.7));
+
+  assert(AngularCorrelation::try_create(
+             State(0, positive), {State(2, negative), State(0, positive)},
+             ang_cor) == cascade_valid);
+  assert(ang_cor->get_cascade_steps()[0].first.em_char == electric);
+
+  // Invalid cascades
+  test_invalid_cascade(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)}},
+      cascade_too_short);
+  test_invalid_cascade(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(1, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}},
+      cascade_mixed_spins);
+  test_invalid_cascade(
+      State(0, positive),
+      {{Transition(electric, 10, electric, 12, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}},
+      cascade_triangle_inequality);
+  test_invalid_cascade(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(magnetic, 2, magnetic, 4, 0.), State(0, positive)}},
+      cascade_invalid_em_character);
+  test_invalid_cascade(
+      State(0, positive),
+      {{Transition(electric, 2, em_unknown, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}},
+      cascade_incomplete_em_character);
+  test_invalid_cascade(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, parity_unknown)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}},
+      cascade_missing_parity);
+
+  // Transition inference
+  assert(AngularCorrelation::validate(
+             State(0, positive), {State(0, negative), State(2, positive)},
+             &message) == cascade_spin_0_to_0);
+  assert(AngularCorrelation::validate(State(0, positive),
+                                      {State(3, negative), State(2, positive)},
+                                      &message) == cascade_mixed_spins);
+  assert(AngularCorrelation::try_create(State(0, positive),
+                                        {State(2, negative)},
+                                        ang_cor) == cascade_too_short);
+  assert(ang_cor == nullptr);
+
+  // C interface. Invalid quantum numbers are reported instead of being passed
+  // to the constructors of State and Transition.
+  int two_J[3]{0, 2, 0};
+  short par[3]{positive, negative, positive};
+  short em_char[2]{electric, electric};
+  int two_L[2]{2, 2};
+  short em_charp[2]{magnetic, magnetic};
+  int two_Lp[2]{4, 4};
+  double delta[2]{0., 0.};
+  char buffer[16];
+
+  assert(validate_cascade(2, two_J, par, em_char, two_L, em_charp, two_Lp, 0,
+                          nullptr) == cascade_valid);
+  int status = -1;
+  AngularCorrelation *c_ang_cor =
+      (AngularCorrelation *)try_create_angular_correlation(
+          2, two_J, par, em_char, two_L, em_charp, two_Lp, delta, &status, 0,
+          nullptr);
+  assert(status == cascade_valid);
+  assert(c_ang_cor != nullptr);
+  free_angular_correlation(c_ang_cor);
+
+  two_J[1] = -2;
+  assert(validate_cascade(2, two_J, par, em_char, two_L, em_charp, two_Lp,
+                          sizeof(buffer),
+                          buffer) == cascade_invalid_quantum_number);
+  two_J[1] = 2;
+  two_Lp[1] = 2;
+  assert(try_create_angular_correlation(2, two_J, par, em_char, two_L,
+                                        em_charp, two_Lp, delta, &status, 0,
+                                        nullptr) == nullptr);
+  assert(status == cascade_invalid_quantum_number);
+  two_Lp[1] = 4;
+
+  // Long messages are truncated.
+  em_char[1] = magnetic;
+  assert(try_create_angular_correlation(2, two_J, par, em_char, two_L,
+                                        em_charp, two_Lp, delta, &status,
+                                        sizeof(buffer), buffer) == nullptr);
+  assert(status == cascade_invalid_em_character);
+  assert(string(buffer) == "Incorrect elect");
+}
@@ -0,0 +1,309 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <atomic>
+
+using std::atomic;
+
+#include <cassert>
+
+#include <filesystem>
+
+using std::filesystem::exists;
+using std::filesystem::file_size;
+using std::filesystem::remove;
+using std::filesystem::resize_file;
+
+#include <fstream>
+
+using std::fstream;
+
+#include <stdexcept>
+
+using std::out_of_range;
+using std::runtime_error;
+
+#include <string>
+
+using std::string;
+
+#include <thread>
+
+using std::thread;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "CoefficientTable.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+extern "C" {
+size_t coefficient_table_n_cascade_steps(CoefficientTable *coefficient_table,
+                                         const size_t index);
+int get_coefficient_table_cascade(CoefficientTable *coefficient_table,
+                                  const size_t index, int *two_J, short *par,
+                                  short *em_char, int *two_L, short *em_charp,
+                                  int *two_Lp, double *delta);
+int evaluate_coefficient_table(CoefficientTable *coefficient_table,
+                               const size_t index, const size_t n_angles,
+                               double *theta, double *phi, double *result);
+}
+
+/**
+ * Check that a damaged file is rejected by the constructor.
+ */
+void test_invalid_file(const string &file_name) {
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    CoefficientTable table(file_name);
+  } catch (const runtime_error &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
+
+/**
+ * Overwrite a number of bytes of a file at a given position.
+ */
+void overwrite(const string &file_name, const size_t position,
+               const string &bytes) {
+  fstream file(file_name, fstream::binary | fstream::in | fstream::out);
+  file.seekp(position);
+  file.write(bytes.data(), bytes.size());
+}
+
+int main() {
+
+  const string file_name = "test_coefficient_table.bin";
+
+  const vector<AngularCorrelation> ang_cors{
+      // Dir-dir correlation
+      AngularCorrelation(State(3, parity_unknown),
+                         {{Transition(em_unknown, 2, em_unknown, 4, 0.3),
+                           State(5, parity_unknown)},
+                          {Transition(em_unknown, 2, em_unknown, 4, -0.7),
+                           State(3, parity_unknown)}}),
+      // Pol-dir correlation
+      AngularCorrelation(
+          State(4, positive),
+          {{Transition(magnetic, 2, electric, 4, 0.5), State(6, positive)},
+           {Transition(magnetic, 2, electric, 4, 2.), State(4, positive)}}),
+      // Unobserved intermediate transition, higher orders
+      AngularCorrelation(
+          State(0, positive),
+          {{Transition(magnetic, 6, electric, 8, 0.), State(6, positive)},
+           {Transition(electric, 2, magnetic, 4, 0.4), State(4, negative)},
+           {Transition(magnetic, 4, electric, 6, -0.2), State(0, positive)}})};
+
+  CoefficientTable::write(file_name, ang_cors);
+
+  {
+    const CoefficientTable table(file_name);
+    assert(table.size() == ang_cors.size());
+
+    const vector<double> theta{0., 0.3, 1.2, 0.5 * M_PI, 2.9};
+    const vector<double> phi{0., 2.1, 0.5 * M_PI, 0.7, 5.};
+    vector<double> result(theta.size());
+
+    for (size_t i = 0; i < ang_cors.size(); ++i) {
+      assert(table.get_nu_max(i) == ang_cors[i].get_nu_max());
+
+      // The quantum numbers are restored exactly.
+      const State initial_state = table.get_initial_state(i);
+      assert(initial_state.two_J == ang_cors[i].get_initial_state().two_J);
+      assert(initial_state.parity == ang_cors[i].get_initial_state().parity);
+      const vector<pair<Transition, State>> cascade_steps =
+          table.get_cascade_steps(i);
+      assert(cascade_steps.size() == ang_cors[i].get_cascade_steps().size());
+      for (size_t j = 0; j < cascade_steps.size(); ++j) {
+        const Transition transition = ang_cors[i].get_cascade_steps()[j].first;
+        assert(cascade_steps[j].first.em_char == transition.em_char);
+        assert(cascade_steps[j].first.two_L == transition.two_L);
+        assert(cascade_steps[j].first.em_charp == transition.em_charp);
+        assert(cascade_steps[j].first.two_Lp == transition.two_Lp);
+        assert(cascade_steps[j].first.delta == transition.delta);
+        assert(cascade_steps[j].second.two_J ==
+               ang_cors[i].get_cascade_steps()[j].second.two_J);
+        assert(cascade_steps[j].second.parity ==
+               ang_cors[i].get_cascade_steps()[j].second.parity);
+      }
+
+      // The coefficients are stored bit by bit.
+      const vector<double> c = ang_cors[i].get_legendre_coefficients();
+      for (size_t j = 0; j < c.size(); ++j) {
+        assert(table.get_legendre_coefficients(i)[j] == c[j]);
+      }
+      const vector<double> d =
+          ang_cors[i].get_associated_legendre_coefficients();
+      assert((table.get_associated_legendre_coefficients(i) == nullptr) ==
+             d.empty());
+      for (size_t j = 0; j < d.size(); ++j) {
+        assert(table.get_associated_legendre_coefficients(i)[j] == d[j]);
+      }
+
+      table.evaluate(i, theta.size(), theta.data(), phi.data(), result.data());
+      for (size_t j = 0; j < theta.size(); ++j) {
+        test_numerical_equality<double>(result[j],
+                                        ang_cors[i](theta[j], phi[j]), 1e-12);
+        test_numerical_equality<double>(table(i, theta[j], phi[j]), result[j],
+                                        1e-14);
+      }
+
+      // The full angular correlation can be reconstructed.
+      test_numerical_equality<double>(
+          table.get_angular_correlation(i)(0.3, 0.4), ang_cors[i](0.3, 0.4),
+          1e-12);
+    }
+
+    [[maybe_unused]] bool error_thrown = false;
+    try {
+      table(ang_cors.size(), 0., 0.);
+    } catch (const out_of_range &e) {
+      error_thrown = true;
+    }
+    assert(error_thrown);
+  }
+
+  // The C interface reports an invalid index with its return value instead of
+  // an exception.
+  {
+    CoefficientTable table(file_name);
+    int two_J[4];
+    short par[4], em_char[3], em_charp[3];
+    int two_L[3], two_Lp[3];
+    double delta[3];
+    double theta = 0.3, phi = 0.4, result;
+
+    assert(coefficient_table_n_cascade_steps(&table, 2) == 3);
+    assert(get_coefficient_table_cascade(&table, 2, two_J, par, em_char, two_L,
+                                         em_charp, two_Lp, delta) == 1);
+    assert(two_J[3] == 0 && two_L[0] == 6 && delta[2] == -0.2);
+    assert(evaluate_coefficient_table(&table, 1, 1, &theta, &phi, &result) ==
+           1);
+    test_numerical_equality<double>(result, ang_cors[1](theta, phi), 1e-12);
+
+    const size_t index = ang_cors.size();
+    assert(coefficient_table_n_cascade_steps(&table, index) == 0);
+    assert(get_coefficient_table_cascade(&table, index, two_J, par, em_char,
+                                         two_L, em_charp, two_Lp, delta) == 0);
+    assert(evaluate_coefficient_table(&table, index, 1, &theta, &phi,
+                                      &result) == 0);
+  }
+
+  // A missing table is built only once, even if several threads open it at
+  // the same time. Replacing the file does not affect an existing mapping.
+  const string shared_file_name = "test_coefficient_table_shared.bin";
+  remove(shared_file_name);
+  atomic<int> n_builds{0};
+  const auto build = [&]() {
+    ++n_builds;
+    return ang_cors;
+  };
+  vector<thread> threads;
+  for (size_t i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      const CoefficientTable table(shared_file_name, build);
+      assert(table.size() == ang_cors.size());
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  assert(n_builds == 1);
+  {
+    const CoefficientTable table(shared_file_name, build);
+    assert(n_builds == 1);
+    CoefficientTable::write(shared_file_name, {});
+    assert(table.size() == ang_cors.size());
+    test_numerical_equality<double>(table(1, 0.3, 0.4), ang_cors[1](0.3, 0.4),
+                                    1e-12);
+    assert(CoefficientTable(shared_file_name).size() == 0);
+  }
+  remove(shared_file_name);
+
+  // Errors of the function that builds the table are passed on, and no file
+  // is written.
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    CoefficientTable(shared_file_name, []() -> vector<AngularCorrelation> {
+      throw runtime_error("Build failed.");
+    });
+  } catch (const runtime_error &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+  assert(!exists(shared_file_name));
+  remove(shared_file_name + ".lock");
+
+  // An empty table is valid.
+  CoefficientTable::write(file_name, {});
+  assert(CoefficientTable(file_name).size() == 0);
+
+  // Damaged or foreign files are rejected.
+  test_invalid_file("does_not_exist.bin");
+
+  CoefficientTable::write(file_name, ang_cors);
+  overwrite(file_name, 0, "ALPACAXX");
+  test_invalid_file(file_name);
+
+  CoefficientTable::write(file_name, ang_cors);
+  overwrite(file_name, 8, string("\x02\0\0\0", 4));
+  test_invalid_file(file_name);
+
+  CoefficientTable::write(file_name, ang_cors);
+  overwrite(file_name, 12, string("\x01\x02\x03\x04", 4));
+  test_invalid_file(file_name);
+
+  // Offset of the first index entry beyond the end of the file.
+  CoefficientTable::write(file_name, ang_cors);
+  overwrite(file_name, 48, string(8, '\x7f'));
+  test_invalid_file(file_name);
+
+  // Numbers of cascade steps and coefficients whose sizes would wrap around in
+  // 32-bit arithmetic, and too few cascade steps. The index entries start at
+  // byte 48; the numbers follow the 8-byte offset.
+  CoefficientTable::write(file_name, {ang_cors[0]});
+  overwrite(file_name, 56, string("\xff\xff\xff\xff", 4));
+  test_invalid_file(file_name);
+
+  CoefficientTable::write(file_name, {ang_cors[0]});
+  overwrite(file_name, 60, string("\x01\0\0\x80\0\0\0\x80", 8));
+  test_invalid_file(file_name);
+
+  for (const char n_cascade_steps : {'\0', '\x01'}) {
+    CoefficientTable::write(file_name, {ang_cors[0]});
+    overwrite(file_name, 56, string(1, n_cascade_steps));
+    test_invalid_file(file_name);
+  }
+
+  // Truncated file, and file with trailing bytes
+  CoefficientTable::write(file_name, ang_cors);
+  resize_file(file_name, file_size(file_name) - sizeof(double));
+  test_invalid_file(file_name);
+
+  CoefficientTable::write(file_name, ang_cors);
+  resize_file(file_name, file_size(file_name) + sizeof(double));
+  test_invalid_file(file_name);
+
+  remove(file_name);
+}
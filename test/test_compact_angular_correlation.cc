@@ -0,0 +1,121 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::runtime_error;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "CompactAngularCorrelation.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Compare the compact representation of an angular correlation to the
+ * original object.
+ */
+void test_compact_angular_correlation(const AngularCorrelation &ang_cor) {
+  const CompactAngularCorrelation compact(ang_cor);
+
+  assert(compact.get_nu_max() == ang_cor.get_nu_max());
+  assert(!compact.has_cascade());
+  assert(compact.get_size_in_bytes() <=
+         sizeof(compact) + (ang_cor.get_nu_max() + 1) * sizeof(double));
+
+  const size_t n = 150;
+  vector<double> theta(n), phi(n), result(n), result_compact(n);
+  for (size_t i = 0; i < n; ++i) {
+    theta[i] = M_PI * i / (n - 1.);
+    phi[i] = 2. * M_PI * ((13 * i) % n) / n;
+  }
+  ang_cor.evaluate(n, theta.data(), phi.data(), result.data());
+  compact.evaluate(n, theta.data(), phi.data(), result_compact.data());
+  for (size_t i = 0; i < n; ++i) {
+    test_numerical_equality<double>(result_compact[i], result[i], 1e-12);
+    test_numerical_equality<double>(compact(theta[i], phi[i]), result[i],
+                                    1e-12);
+  }
+
+  // The string representation is only available if the cascade was kept.
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    compact.string_representation();
+  } catch (const runtime_error &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  const CompactAngularCorrelation compact_with_cascade(ang_cor, true);
+  assert(compact_with_cascade.has_cascade());
+  assert(compact_with_cascade.string_representation(3) ==
+         ang_cor.get_w_gamma_gamma()->string_representation(3));
+  assert(compact_with_cascade.get_angular_correlation()(0.4, 0.2) ==
+         ang_cor(0.4, 0.2));
+}
+
+int main() {
+
+  // Dir-dir correlation
+  test_compact_angular_correlation(AngularCorrelation(
+      State(3, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.3),
+        State(5, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, -0.7),
+        State(3, parity_unknown)}}));
+
+  // Pol-dir correlations with both possible EM characters
+  test_compact_angular_correlation(AngularCorrelation(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}}));
+  test_compact_angular_correlation(AngularCorrelation(
+      State(4, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.5), State(6, positive)},
+       {Transition(magnetic, 2, electric, 4, 2.), State(4, positive)}}));
+
+  // Unobserved intermediate transition
+  test_compact_angular_correlation(AngularCorrelation(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.4), State(4, positive)},
+       {Transition(magnetic, 2, electric, 4, -0.2), State(4, positive)}}));
+
+  // Construction from coefficients
+  const CompactAngularCorrelation isotropic({1.});
+  assert(isotropic(0.3, 1.2) == 1.);
+  assert(!isotropic.is_polarized());
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    CompactAngularCorrelation({1., 0.5}, {0.1, 0.2});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
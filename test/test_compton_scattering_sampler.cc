@@ -0,0 +1,237 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+using std::abs;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include "ComptonScatteringSampler.hh"
+#include "EulerAngleRotation.hh"
+#include "TestUtilities.hh"
+
+/**
+ * Integral of the Klein-Nishina cross section over a range of the scattering
+ * angles with the midpoint rule, in units of r_e^2 / 2.
+ */
+double integrate_numerically(const double energy,
+                             const double polarization_degree,
+                             const double cos_theta_min,
+                             const double cos_theta_max, const double phi_min,
+                             const double phi_max) {
+  const size_t n = 2000;
+  const double k = energy / ComptonScatteringSampler::electron_mass;
+  const double d_cos_theta = (cos_theta_max - cos_theta_min) / n;
+  const double d_phi = (phi_max - phi_min) / n;
+
+  double integral = 0.;
+  for (size_t i = 0; i < n; ++i) {
+    const double cos_theta = cos_theta_min + (i + 0.5) * d_cos_theta;
+    const double epsilon = 1. / (1. + k * (1. - cos_theta));
+    const double sin2_theta = 1. - cos_theta * cos_theta;
+    for (size_t j = 0; j < n; ++j) {
+      const double phi = phi_min + (j + 0.5) * d_phi;
+      integral += epsilon * epsilon *
+                  (epsilon + 1. / epsilon - sin2_theta -
+                   polarization_degree * sin2_theta * cos(2. * phi));
+    }
+  }
+
+  return integral * d_cos_theta * d_phi;
+}
+
+int main() {
+  const double epsilon = 1e-12;
+
+  // The integrals in closed form agree with a numerical quadrature for
+  // energies below and above the electron mass.
+  for (double energy : {0.1, 1., 10.}) {
+    ComptonScatteringSampler compton(energy, 0, 0.6);
+    test_numerical_equality<double>(compton.integrate(-1., 1., 0., 2. * M_PI),
+                                    1., epsilon);
+    test_numerical_equality<double>(
+        compton.integrate(-0.4, 0.7, 0.3, 1.9),
+        integrate_numerically(energy, 0.6, -0.4, 0.7, 0.3, 1.9) /
+            integrate_numerically(energy, 0.6, -1., 1., 0., 2. * M_PI),
+        1e-5);
+
+    // Asymmetry of detectors in four quadrants.
+    const double perpendicular =
+        compton.integrate(-0.5, 0.5, M_PI_4, 3. * M_PI_4);
+    const double parallel = compton.integrate(-0.5, 0.5, -M_PI_4, M_PI_4);
+    test_numerical_equality<double>(
+        compton.expected_asymmetry(-0.5, 0.5),
+        (perpendicular - parallel) / (perpendicular + parallel), epsilon);
+  }
+
+  // At low energies, the analyzing power at a scattering angle of 90 degrees
+  // approaches that of Thomson scattering, 1. It vanishes for forward and
+  // backward scattering.
+  ComptonScatteringSampler thomson(1e-3, 0);
+  test_numerical_equality<double>(thomson.analyzing_power(0.), 1., 1e-5);
+  test_numerical_equality<double>(thomson.analyzing_power(1.), 0., epsilon);
+  test_numerical_equality<double>(thomson.analyzing_power(-1.), 0., epsilon);
+  // A partial polarization reduces the asymmetry, and a negative one changes
+  // its sign.
+  ComptonScatteringSampler unpolarized(1., 0, 0.);
+  ComptonScatteringSampler rotated(1., 0, -0.5);
+  ComptonScatteringSampler compton(1., 1);
+  test_numerical_equality<double>(unpolarized.expected_asymmetry(-0.5, 0.5),
+                                  0., epsilon);
+  test_numerical_equality<double>(rotated.expected_asymmetry(-0.5, 0.5),
+                                  -0.5 * compton.expected_asymmetry(-0.5, 0.5),
+                                  epsilon);
+  assert(compton.get_energy() == 1.);
+  assert(rotated.get_polarization_degree() == -0.5);
+
+  // Kinematics and distribution of the sampled scattering angles.
+  const size_t n = 200000;
+  const euler_angle_transform::RotationMatrix A =
+      euler_angle_transform::rotation_matrix({0.3, 1.2, -0.7});
+  const array<double, 3> direction = euler_angle_transform::direction(A);
+  const array<double, 3> polarization_axis =
+      euler_angle_transform::polarization_axis(A);
+  const double k = 1. / ComptonScatteringSampler::electron_mass;
+  size_t n_perpendicular = 0, n_parallel = 0, n_box = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const array<double, 6> result = compton(A);
+    const double cos_theta = result[1], phi = result[2];
+    const double sin_theta = sqrt(1. - cos_theta * cos_theta);
+    test_numerical_equality<double>(result[0], 1. / (1. + k * (1. - cos_theta)),
+                                    epsilon);
+    test_numerical_equality<double>(result[3] * direction[0] +
+                                        result[4] * direction[1] +
+                                        result[5] * direction[2],
+                                    cos_theta, epsilon);
+    test_numerical_equality<double>(result[3] * polarization_axis[0] +
+                                        result[4] * polarization_axis[1] +
+                                        result[5] * polarization_axis[2],
+                                    sin_theta * cos(phi), epsilon);
+
+    if (cos_theta >= -0.5 && cos_theta <= 0.5) {
+      if (abs(cos(phi)) < M_SQRT1_2) {
+        ++n_perpendicular;
+      } else {
+        ++n_parallel;
+      }
+    }
+    if (cos_theta >= -0.4 && cos_theta <= 0.7 && phi >= 0.3 && phi <= 1.9) {
+      ++n_box;
+    }
+  }
+  const double n_sector = static_cast<double>(n_perpendicular + n_parallel);
+  test_numerical_equality<double>(
+      (static_cast<double>(n_perpendicular) - static_cast<double>(n_parallel)) /
+          n_sector,
+      compton.expected_asymmetry(-0.5, 0.5), 5. / sqrt(n_sector));
+  const double expected_box = compton.integrate(-0.4, 0.7, 0.3, 1.9);
+  test_numerical_equality<double>(static_cast<double>(n_box) / n, expected_box,
+                                  5. * sqrt(expected_box / n));
+
+  // The block mode gives the same results as consecutive calls of the call
+  // operator. Individual energies are equivalent to a sampler with a
+  // different energy.
+  const size_t n_block = 100;
+  vector<euler_angle_transform::RotationMatrix> frames(n_block);
+  for (size_t i = 0; i < n_block; ++i) {
+    frames[i] = euler_angle_transform::rotation_matrix({0.1 * i, 0.02 * i, 0.});
+  }
+  vector<double> result(ComptonScatteringSampler::n_components * n_block);
+  compton.reseed(2, 3);
+  compton.sample(n_block, frames.data(), result.data());
+  compton.reseed(2, 3);
+  for (size_t i = 0; i < n_block; ++i) {
+    const array<double, 6> single = compton(frames[i]);
+    for (size_t j = 0; j < ComptonScatteringSampler::n_components; ++j) {
+      assert(result[j * n_block + i] == single[j]);
+    }
+  }
+
+  const vector<double> energies(n_block, 2.);
+  ComptonScatteringSampler compton_2(2., 1);
+  compton.reseed(4);
+  compton_2.reseed(4);
+  const size_t leading_dimension = n_block + 5;
+  vector<double> result_2(ComptonScatteringSampler::n_components *
+                          leading_dimension);
+  compton.sample(n_block, frames.data(), energies.data(), result.data(),
+                 n_block);
+  compton_2.sample(n_block, frames.data(), nullptr, result_2.data(),
+                   leading_dimension);
+  for (size_t i = 0; i < n_block; ++i) {
+    for (size_t j = 0; j < ComptonScatteringSampler::n_components; ++j) {
+      test_numerical_equality<double>(result[j * n_block + i],
+                                      result_2[j * leading_dimension + i],
+                                      epsilon);
+    }
+  }
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    ComptonScatteringSampler(0., 0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    ComptonScatteringSampler(1., 0, 1.5);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    compton.integrate(0.5, -0.5, 0., M_PI);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    compton.integrate(-0.5, 1.5, 0., M_PI);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    compton.expected_asymmetry(-0.5, 0.5, 0.);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -0,0 +1,183 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cmath>
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_sf.h>
+
+#include "AngularCorrelation.hh"
+#include "LegendreSeries.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Integrate an angular correlation over a cone with the midpoint rule in the
+ * coordinate system of the cone, whose z axis is the axis of the cone.
+ */
+double integrate_cone_numerically(const AngularCorrelation &ang_cor,
+                                  const array<double, 2> theta_phi,
+                                  const double opening_angle) {
+  const array<double, 3> axis{sin(theta_phi[0]) * cos(theta_phi[1]),
+                              sin(theta_phi[0]) * sin(theta_phi[1]),
+                              cos(theta_phi[0])};
+  const array<double, 3> e_1{cos(theta_phi[0]) * cos(theta_phi[1]),
+                             cos(theta_phi[0]) * sin(theta_phi[1]),
+                             -sin(theta_phi[0])};
+  const array<double, 3> e_2{-sin(theta_phi[1]), cos(theta_phi[1]), 0.};
+
+  const size_t n_z = 400, n_phi = 400;
+  const double cos_alpha = cos(opening_angle);
+  const double delta_z = (1. - cos_alpha) / n_z;
+  const double delta_phi = 2. * M_PI / n_phi;
+
+  double integral = 0.;
+  for (size_t i = 0; i < n_z; ++i) {
+    const double z = cos_alpha + (i + 0.5) * delta_z;
+    const double rho = sqrt(1. - z * z);
+    for (size_t j = 0; j < n_phi; ++j) {
+      const double phi = (j + 0.5) * delta_phi;
+      array<double, 3> r;
+      for (size_t k = 0; k < 3; ++k) {
+        r[k] = z * axis[k] + rho * (cos(phi) * e_1[k] + sin(phi) * e_2[k]);
+      }
+      integral += ang_cor(acos(r[2]), atan2(r[1], r[0]));
+    }
+  }
+
+  return integral * delta_z * delta_phi;
+}
+
+void test_cone_integral(const AngularCorrelation &ang_cor) {
+
+  const vector<array<double, 2>> axes{
+      {0., 0.}, {0.5 * M_PI, 0.}, {0.3, 1.2}, {2.1, 4.}, {M_PI, 0.}};
+  const vector<double> opening_angles{1e-3, 0.1, 0.4, 1.3, 2.5, M_PI};
+
+  // Compare to a numerical integration.
+  for (auto axis : axes) {
+    for (auto alpha : {0.2, 0.9}) {
+      test_numerical_equality<double>(
+          ang_cor.integrate_cone(axis, alpha),
+          integrate_cone_numerically(ang_cor, axis, alpha), 1e-4);
+    }
+  }
+
+  for (auto axis : axes) {
+    const array<double, 2> opposite_axis{M_PI - axis[0], axis[1] + M_PI};
+    for (auto alpha : opening_angles) {
+      // A cone and the complementary cone around the opposite axis cover the
+      // sphere, on which the angular correlation is normalized to 4 pi.
+      test_numerical_equality<double>(
+          ang_cor.integrate_cone(axis, alpha) +
+              ang_cor.integrate_cone(opposite_axis, M_PI - alpha),
+          4. * M_PI, 1e-12);
+    }
+
+    // For a small cone, the integral is the solid angle times the value on
+    // the axis.
+    const double alpha = 1e-3;
+    test_numerical_equality<double>(ang_cor.integrate_cone(axis, alpha) /
+                                        (2. * M_PI * (1. - cos(alpha))),
+                                    ang_cor(axis[0], axis[1]), 1e-5);
+  }
+
+  // Many cones at once, with repeated and changing opening angles.
+  vector<double> theta, phi, alpha;
+  for (auto axis : axes) {
+    for (size_t i = 0; i < opening_angles.size(); ++i) {
+      theta.push_back(axis[0]);
+      phi.push_back(axis[1]);
+      alpha.push_back(opening_angles[i / 2]);
+    }
+  }
+  vector<double> result(theta.size());
+  ang_cor.integrate_cone(theta.size(), theta.data(), phi.data(), alpha.data(),
+                         result.data());
+  for (size_t i = 0; i < theta.size(); ++i) {
+    test_numerical_equality<double>(
+        result[i], ang_cor.integrate_cone({theta[i], phi[i]}, alpha[i]),
+        1e-14);
+  }
+}
+
+int main() {
+
+  // Integrals of the Legendre polynomials over a cone.
+  const size_t n_orders = 8;
+  double cone_integrals[n_orders];
+  for (auto alpha : {0.01, 0.5, 1.5, 2.9}) {
+    legendre_series::cone_integrals(n_orders, cos(alpha), cone_integrals);
+    for (size_t i = 0; i < n_orders; ++i) {
+      const size_t n_x = 100000;
+      const double delta_x = (1. - cos(alpha)) / n_x;
+      double integral = 0.;
+      for (size_t k = 0; k < n_x; ++k) {
+        integral +=
+            gsl_sf_legendre_Pl(2 * i, cos(alpha) + (k + 0.5) * delta_x);
+      }
+      test_numerical_equality<double>(cone_integrals[i],
+                                      2. * M_PI * integral * delta_x, 1e-6);
+    }
+  }
+
+  // Dir-dir correlation
+  test_cone_integral(AngularCorrelation(
+      State(3, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.3),
+        State(5, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, -0.7),
+        State(3, parity_unknown)}}));
+
+  // Pol-dir correlations with both possible EM characters
+  test_cone_integral(AngularCorrelation(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}}));
+  test_cone_integral(AngularCorrelation(
+      State(4, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.5), State(6, positive)},
+       {Transition(magnetic, 2, electric, 4, 2.), State(4, positive)}}));
+
+  // Higher orders of the expansion
+  test_cone_integral(AngularCorrelation(
+      State(0, positive),
+      {{Transition(magnetic, 6, electric, 8, 0.), State(6, positive)},
+       {Transition(magnetic, 6, electric, 8, 0.), State(0, positive)}}));
+
+  // Unobserved intermediate transition
+  test_cone_integral(AngularCorrelation(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.4), State(4, positive)},
+       {Transition(magnetic, 2, electric, 4, -0.2), State(4, positive)}}));
+}
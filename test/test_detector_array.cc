@@ -0,0 +1,129 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "DetectorArray.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+int main() {
+
+  const vector<array<double, 2>> theta_phi{
+      {0.5 * M_PI, 0.},        {0.5 * M_PI, 0.5 * M_PI}, {0.25 * M_PI, M_PI},
+      {0.3, 1.},               {1.2, 4.},                {2., -0.5},
+      {M_PI, 0.},              {0.1, 0.2}};
+  const size_t n_detectors = theta_phi.size();
+  const vector<double> chi{0., 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7};
+
+  const DetectorArray detector_array(theta_phi, chi);
+  assert(detector_array.get_n_detectors() == n_detectors);
+  assert(detector_array.get_cos_theta().size() == n_detectors * n_detectors);
+
+  const vector<AngularCorrelation> ang_cors{
+      // Dir-dir correlation
+      AngularCorrelation(State(0, parity_unknown),
+                         {{Transition(em_unknown, 2, em_unknown, 4, 0.),
+                           State(2, parity_unknown)},
+                          {Transition(em_unknown, 2, em_unknown, 4, 0.),
+                           State(0, parity_unknown)}}),
+      // Pol-dir correlations
+      AngularCorrelation(
+          State(0, positive),
+          {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+           {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}}),
+      AngularCorrelation(
+          State(4, positive),
+          {{Transition(magnetic, 2, electric, 4, 0.5), State(6, positive)},
+           {Transition(magnetic, 2, electric, 4, 2.), State(4, positive)}})};
+
+  vector<double> matrices(ang_cors.size() * n_detectors * n_detectors);
+  detector_array(ang_cors, matrices.data());
+
+  for (size_t k = 0; k < ang_cors.size(); ++k) {
+    // Compare to the rotated evaluation of the angular correlation, where the
+    // second detector is located in the direction of the rotated z axis.
+    for (size_t i = 0; i < n_detectors; ++i) {
+      for (size_t j = 0; j < n_detectors; ++j) {
+        const double theta = theta_phi[j][0], phi = theta_phi[j][1];
+        double w;
+        ang_cors[k].evaluate(1, &theta, &phi,
+                             detector_array.get_Phi_Theta_Psi()[i], &w);
+        test_numerical_equality<double>(
+            matrices[(k * n_detectors + i) * n_detectors + j], w, 1e-12);
+      }
+      // Both photons in the same detector.
+      test_numerical_equality<double>(
+          matrices[(k * n_detectors + i) * n_detectors + i],
+          ang_cors[k](0., 0.), 1e-12);
+    }
+  }
+
+  // The dir-dir correlation depends only on the angle between the detectors.
+  for (size_t i = 0; i < n_detectors; ++i) {
+    for (size_t j = 0; j < n_detectors; ++j) {
+      const double cos_angle =
+          sin(theta_phi[i][0]) * sin(theta_phi[j][0]) *
+              cos(theta_phi[i][1] - theta_phi[j][1]) +
+          cos(theta_phi[i][0]) * cos(theta_phi[j][0]);
+      test_numerical_equality<double>(
+          matrices[i * n_detectors + j],
+          ang_cors[0](acos(fmax(-1., fmin(1., cos_angle))), 0.), 1e-12);
+    }
+  }
+
+  // The pol-dir correlation of a 0+ -> 1- -> 0+ cascade is maximal
+  // perpendicular to the polarization axis, which is the x axis for a detector
+  // along the z axis with chi = 0.
+  const DetectorArray detector_array_z({{0., 0.}, {0.5 * M_PI, 0.},
+                                        {0.5 * M_PI, 0.5 * M_PI}});
+  vector<double> matrix_z(9);
+  detector_array_z(ang_cors[1], matrix_z.data());
+  test_numerical_equality<double>(matrix_z[1], ang_cors[1](0.5 * M_PI, 0.),
+                                  1e-12);
+  test_numerical_equality<double>(matrix_z[2],
+                                  ang_cors[1](0.5 * M_PI, 0.5 * M_PI), 1e-12);
+
+  // The number of angles chi must match the number of detectors.
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    DetectorArray(theta_phi, {0., 1.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
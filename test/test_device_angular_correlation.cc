@@ -0,0 +1,169 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::out_of_range;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "DeviceAngularCorrelation.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Mean of a function of the sampled directions, which is compared to the
+ * expectation value for the angular correlation.
+ */
+template <typename F>
+double mean(const size_t n, const double *Theta, const double *Psi, F f) {
+  double sum = 0.;
+  for (size_t k = 0; k < n; ++k) {
+    // See euler_angle_transform::from_spherical().
+    sum += f(cos(Theta[k]), 0.5 * M_PI - Psi[k]);
+  }
+  return sum / n;
+}
+
+int main() {
+
+  const vector<AngularCorrelation> ang_cors{
+      // Dir-dir correlation
+      AngularCorrelation(State(0, parity_unknown),
+                         {{Transition(em_unknown, 2, em_unknown, 4, 0.),
+                           State(2, parity_unknown)},
+                          {Transition(em_unknown, 2, em_unknown, 4, 0.),
+                           State(0, parity_unknown)}}),
+      // Pol-dir correlation
+      AngularCorrelation(
+          State(0, positive),
+          {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+           {Transition(electric, 2, magnetic, 4, 0.3), State(0, positive)}}),
+      // Pol-dir correlation with a term of order 4
+      AngularCorrelation(
+          State(0, positive),
+          {{Transition(electric, 4, magnetic, 6, 0.), State(4, positive)},
+           {Transition(electric, 4, magnetic, 6, 0.), State(0, positive)}}),
+  };
+  assert(ang_cors[2].get_legendre_coefficients().size() == 3);
+
+  DeviceAngularCorrelation device_ang_cors(ang_cors);
+  assert(device_ang_cors.size() == 3);
+  assert(DeviceAngularCorrelation::get_backend() != nullptr);
+
+  // Evaluation.
+  const size_t n_angles = 1000;
+  vector<double> theta(n_angles), phi(n_angles), expected(n_angles),
+      result(n_angles);
+  for (size_t k = 0; k < n_angles; ++k) {
+    theta[k] = M_PI * k / (n_angles - 1);
+    phi[k] = 2. * M_PI * ((7 * k) % n_angles) / n_angles;
+  }
+  for (size_t i = 0; i < ang_cors.size(); ++i) {
+    test_numerical_equality<double>(device_ang_cors.get_upper_limit(i),
+                                    ang_cors[i].get_upper_limit(), 1e-15);
+    ang_cors[i].evaluate(n_angles, theta.data(), phi.data(), expected.data());
+    device_ang_cors.evaluate(i, n_angles, theta.data(), phi.data(),
+                             result.data());
+    test_numerical_equality<double>(n_angles, result.data(), expected.data(),
+                                    1e-10);
+  }
+
+  // Sampling. The expectation values of the Legendre polynomials are given by
+  // their orthogonality relations:
+  //
+  // <P_2> = c_1 / (5 c_0), <P_4> = c_2 / (9 c_0),
+  // <cos(2 phi) P_2^2> = 12 d_0 / (5 c_0).
+  const size_t n_events = 200000;
+  vector<double> Phi(n_events), Theta(n_events), Psi(n_events);
+  for (size_t i = 0; i < ang_cors.size(); ++i) {
+    const vector<double> c = ang_cors[i].get_legendre_coefficients();
+    device_ang_cors.reseed(1, i);
+    device_ang_cors.sample(i, n_events, Phi.data(), Theta.data(), Psi.data());
+    for (size_t k = 0; k < n_events; ++k) {
+      assert(Phi[k] >= 0. && Phi[k] < 2. * M_PI);
+      assert(Theta[k] >= 0. && Theta[k] <= M_PI);
+    }
+    test_numerical_equality<double>(
+        mean(n_events, Theta.data(), Psi.data(),
+             [](const double x, const double) {
+               return 0.5 * (3. * x * x - 1.);
+             }),
+        c[1] / (5. * c[0]), 1e-2);
+    test_numerical_equality<double>(
+        mean(n_events, Theta.data(), Psi.data(),
+             [](const double x, const double) {
+               return (35. * x * x * x * x - 30. * x * x + 3.) / 8.;
+             }),
+        c.size() > 2 ? c[2] / (9. * c[0]) : 0., 1e-2);
+
+    const vector<double> d =
+        ang_cors[i].get_associated_legendre_coefficients();
+    test_numerical_equality<double>(
+        mean(n_events, Theta.data(), Psi.data(),
+             [](const double x, const double phi_) {
+               return cos(2. * phi_) * 3. * (1. - x * x);
+             }),
+        d.empty() ? 0. : 12. * d[0] / (5. * c[0]), 2e-2);
+  }
+
+  // The events only depend on the seed, the stream, and the index of the
+  // event since the last reseed().
+  const size_t n_half = 1001;
+  vector<double> Phi_2(2 * n_half), Theta_2(2 * n_half), Psi_2(2 * n_half);
+  device_ang_cors.reseed(2, 3);
+  device_ang_cors.sample(1, 2 * n_half, Phi.data(), Theta.data(), Psi.data());
+  device_ang_cors.reseed(2, 3);
+  device_ang_cors.sample(1, n_half, Phi_2.data(), Theta_2.data(),
+                         Psi_2.data());
+  device_ang_cors.sample(1, n_half, Phi_2.data() + n_half,
+                         Theta_2.data() + n_half, Psi_2.data() + n_half);
+  for (size_t k = 0; k < 2 * n_half; ++k) {
+    assert(Phi[k] == Phi_2[k]);
+    assert(Theta[k] == Theta_2[k]);
+    assert(Psi[k] == Psi_2[k]);
+  }
+  device_ang_cors.reseed(2, 4);
+  device_ang_cors.sample(1, 1, Phi_2.data(), Theta_2.data(), Psi_2.data());
+  assert(Phi_2[0] != Phi[0]);
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    device_ang_cors.evaluate(3, 1, theta.data(), phi.data(), result.data());
+  } catch (const out_of_range &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    device_ang_cors.sample(3, 1, Phi.data(), Theta.data(), Psi.data());
+  } catch (const out_of_range &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
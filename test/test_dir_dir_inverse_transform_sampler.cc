@@ -0,0 +1,164 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+#include <algorithm>
+
+using std::max;
+using std::sort;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <memory>
+
+using std::make_shared;
+using std::shared_ptr;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "CascadeSampler.hh"
+#include "DirDirInverseTransformSampler.hh"
+#include "EulerAngleRotation.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Test the inverse-transform sampler by comparing its cumulative distribution
+ * function to a numerical integration of the angular correlation, and the
+ * empirical distribution of sampled directions to the cumulative distribution
+ * function (Kolmogorov-Smirnov test).
+ */
+void test_dir_dir_inverse_transform_sampler(const AngularCorrelation &ang_cor) {
+
+  DirDirInverseTransformSampler sampler(ang_cor, 0);
+
+  // The cumulative distribution function is the normalized integral of the
+  // angular correlation over x = cos(theta). Integrate with the trapezoidal
+  // rule.
+  const unsigned int n_x = 10001;
+  double integral = 0., w_previous = ang_cor(M_PI, 0.);
+  test_numerical_equality<double>(sampler.cdf(-1.), 0., 1e-14);
+  for (unsigned int i = 1; i < n_x; ++i) {
+    const double x = -1. + 2. * i / (n_x - 1);
+    const double w = ang_cor(acos(x), 0.);
+    integral += (w + w_previous) / (n_x - 1);
+    w_previous = w;
+    // The angular correlation is normalized to 4 pi, i.e. its integral over x
+    // is 2.
+    test_numerical_equality<double>(sampler.cdf(x), 0.5 * integral, 1e-6);
+  }
+  test_numerical_equality<double>(sampler.cdf(1.), 1., 1e-14);
+
+  for (double u : {0., 1e-10, 0.1, 0.5, 0.77, 1. - 1e-10, 1.}) {
+    test_numerical_equality<double>(sampler.cdf(sampler.inverse_cdf(u)), u,
+                                    1e-12);
+  }
+
+  // Every draw is accepted.
+  const unsigned int n_samples = 20000;
+  vector<double> x(n_samples);
+  for (unsigned int i = 0; i < n_samples; ++i) {
+    const pair<unsigned int, array<double, 3>> frame = sampler.sample();
+    assert(frame.first == 1);
+    x[i] = cos(euler_angle_transform::to_spherical(frame.second)[0]);
+  }
+
+  sort(x.begin(), x.end());
+  double d = 0.;
+  for (unsigned int i = 0; i < n_samples; ++i) {
+    const double cdf = sampler.cdf(x[i]);
+    d = max(d, max(fabs(cdf - (double)i / n_samples),
+                   fabs(cdf - (double)(i + 1) / n_samples)));
+  }
+  // The critical value of the Kolmogorov-Smirnov statistic for a significance
+  // level of 0.001 is approximately 1.95 / sqrt(n).
+  assert(d < 1.95 / sqrt(n_samples));
+}
+
+int main() {
+
+  // 0 -> 1 -> 0
+  const AngularCorrelation ang_cor_1(
+      State(0, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.), State(2, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, 0.),
+        State(0, parity_unknown)}});
+  test_dir_dir_inverse_transform_sampler(ang_cor_1);
+
+  // 0 -> 2 -> 0, which has a maximum at x = 0 and at x = +-1
+  const AngularCorrelation ang_cor_2(
+      State(0, parity_unknown),
+      {{Transition(em_unknown, 4, em_unknown, 6, 0.), State(4, parity_unknown)},
+       {Transition(em_unknown, 4, em_unknown, 6, 0.),
+        State(0, parity_unknown)}});
+  test_dir_dir_inverse_transform_sampler(ang_cor_2);
+
+  // Mixed transitions and an unobserved intermediate transition.
+  const AngularCorrelation ang_cor_3(
+      State(3, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.7),
+        State(5, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, -0.3),
+        State(3, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, 2.),
+        State(1, parity_unknown)}});
+  test_dir_dir_inverse_transform_sampler(ang_cor_3);
+
+  // Isotropic distribution
+  const AngularCorrelation ang_cor_4(
+      State(1, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.), State(1, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, 0.),
+        State(1, parity_unknown)}});
+  test_dir_dir_inverse_transform_sampler(ang_cor_4);
+
+  // Reseeding reproduces the sequence, and the sampler can be used in a
+  // cascade.
+  CascadeSampler cascade_sampler(vector<shared_ptr<ReferenceFrameSampler>>{
+      make_shared<DirDirInverseTransformSampler>(ang_cor_1, 0),
+      make_shared<DirDirInverseTransformSampler>(ang_cor_2, 0)});
+  cascade_sampler.reseed(1);
+  const vector<array<double, 3>> cascade = cascade_sampler();
+  cascade_sampler.reseed(1);
+  assert(cascade_sampler() == cascade);
+
+  // Pol-dir correlations are not supported.
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    DirDirInverseTransformSampler(
+        AngularCorrelation(
+            State(0, positive),
+            {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+             {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}}),
+        0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
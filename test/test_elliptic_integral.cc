@@ -17,16 +17,18 @@
     Copyright (C) 2021-2023 Udo Friman-Gayer
 */
 
+#include <cassert>
 #include <cmath>
+#include <stdexcept>
 #include <vector>
 
 #include <gsl/gsl_math.h>
-#include <gsl/gsl_sf_ellint.h>
-#include <gsl/gsl_sf_elljac.h>
 
+#include "CarlsonEllipticIntegral.hh"
 #include "SpherePointSampler.hh"
 #include "TestUtilities.hh"
 
+using std::invalid_argument;
 using std::vector;
 
 /**
@@ -61,6 +63,21 @@ double one_over_k_to_m(const double one_over_k) {
   return pow(1. / one_over_k, 2);
 }
 
+/**
+ * \brief Elliptic integral of the second kind by Simpson's rule
+ */
+double elliptic_integral_2nd_kind_simpson(const double phi, const double m) {
+  const unsigned int n = 100000;
+  const double h = phi / n;
+  double sum = 0.;
+  for (unsigned int i = 0; i <= n; ++i) {
+    const double sin_theta = sin(i * h);
+    sum += (i == 0 || i == n ? 1. : (i % 2 ? 4. : 2.)) *
+           sqrt(1. - m * sin_theta * sin_theta);
+  }
+  return sum * h / 3.;
+}
+
 int main() {
 
   const double epsilon{1e-8};
@@ -83,4 +100,67 @@ int main() {
         M_PI_2, one_over_k_to_m(val[0]));
     test_numerical_equality<double>(ell_int_num, val[1], epsilon);
   }
+
+  /**
+   * Test values of the symmetric integrals from Ref. \cite Carlson1995
+   */
+  test_numerical_equality<double>(carlson_elliptic_integral::R_F(1., 2., 0.),
+                                  1.3110287771461, 1e-13);
+  test_numerical_equality<double>(carlson_elliptic_integral::R_F(2., 3., 4.),
+                                  0.58408284167715, 1e-13);
+  test_numerical_equality<double>(carlson_elliptic_integral::R_D(0., 2., 1.),
+                                  1.7972103521034, 1e-13);
+  test_numerical_equality<double>(carlson_elliptic_integral::R_D(2., 3., 4.),
+                                  0.16510527294261, 1e-13);
+  test_numerical_equality<double>(
+      carlson_elliptic_integral::R_D(2., 3., 4., approximate_precision),
+      0.16510527294261, 1e-9);
+
+  /**
+   * For negative m, as required by the SpherePointSampler, and for angles
+   * beyond pi / 2, compare to a numerical integration. The approximate
+   * precision is sufficient for the sampler.
+   */
+  const SpherePointSampler sph_pt_samp_approximate(approximate_precision);
+  assert(sph_pt_samp_approximate.get_precision() == approximate_precision);
+  for (auto m : {0.5, -0.1, -10., -1e4}) {
+    for (auto phi : {0.3, M_PI_2, 2.5, 5.}) {
+      const double reference = elliptic_integral_2nd_kind_simpson(phi, m);
+      test_numerical_equality<double>(
+          sph_pt_samp.elliptic_integral_2nd_kind_arbitrary_m(phi, m),
+          reference, 1e-10);
+      test_numerical_equality<double>(
+          sph_pt_samp_approximate.elliptic_integral_2nd_kind_arbitrary_m(phi,
+                                                                         m),
+          reference, 1e-8);
+    }
+  }
+
+  // F is the inverse of the Jacobi amplitude, i.e. its derivative with
+  // respect to phi is 1 / Delta.
+  const double h = 1e-5;
+  for (auto m : {0.5, -10., -1e4}) {
+    const double phi = 0.7;
+    test_numerical_equality<double>(
+        (carlson_elliptic_integral::F(phi + h, m) -
+         carlson_elliptic_integral::F(phi - h, m)) /
+            (2. * h),
+        1. / sqrt(1. - m * sin(phi) * sin(phi)), 1e-8);
+  }
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    carlson_elliptic_integral::R_F(-1., 1., 1.);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    carlson_elliptic_integral::E(M_PI_2, 2.);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
 }
\ No newline at end of file
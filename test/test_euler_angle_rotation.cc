@@ -19,6 +19,8 @@
 
 #include <array>
 
+using std::array;
+
 #include <iostream>
 
 using std::exception;
@@ -211,6 +213,49 @@ int main() {
                                   Phi_Theta_Psi_reconstructed, z_axis);
     test_numerical_equality(z_axis_transformed_from_reconstructed_matrix,
                             z_axis_transformed, epsilon);
+
+    // (6) Repeat (1) and (2) with the fixed-size rotation matrix, and verify
+    // that its transpose is its inverse.
+    const euler_angle_transform::RotationMatrix A =
+        euler_angle_transform::rotation_matrix(test.Phi_Theta_Psi);
+    test_numerical_equality<double>(
+        3, euler_angle_transform::apply(A, test.initial_axis).data(),
+        test.target_axis.data(), epsilon);
+    test_numerical_equality<double>(
+        3,
+        euler_angle_transform::apply(euler_angle_transform::transpose(A),
+                                     test.target_axis)
+            .data(),
+        test.initial_axis.data(), epsilon);
+    const euler_angle_transform::RotationMatrix A_AT =
+        euler_angle_transform::multiply(A, euler_angle_transform::transpose(A));
+    for (size_t i = 0; i < 3; ++i) {
+      for (size_t j = 0; j < 3; ++j) {
+        test_numerical_equality<double>(A_AT[i][j], i == j ? 1. : 0., epsilon);
+      }
+    }
+  }
+
+  // (7) Verify that the composition of two rotations by
+  // euler_angle_transform::rotate is the same as applying the second and the
+  // first rotation one after the other.
+  const array<double, 3> Phi_Theta_Psi_1{0.3, 1.2, -2.1},
+      Phi_Theta_Psi_2{-1.7, 2.5, 0.4};
+  const array<double, 3> Phi_Theta_Psi_12 =
+      euler_angle_transform::rotate(Phi_Theta_Psi_1, Phi_Theta_Psi_2);
+  for (auto axis : vector<array<double, 3>>{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}) {
+    test_numerical_equality<double>(
+        3,
+        euler_angle_transform::apply(
+            euler_angle_transform::rotation_matrix(Phi_Theta_Psi_12), axis)
+            .data(),
+        euler_angle_transform::apply(
+            euler_angle_transform::rotation_matrix(Phi_Theta_Psi_1),
+            euler_angle_transform::apply(
+                euler_angle_transform::rotation_matrix(Phi_Theta_Psi_2),
+                axis))
+            .data(),
+        epsilon);
   }
 
   gsl_vector_free(x_axis);
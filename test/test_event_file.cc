@@ -0,0 +1,305 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <filesystem>
+
+using std::filesystem::file_size;
+using std::filesystem::remove;
+using std::filesystem::resize_file;
+
+#include <fstream>
+
+using std::fstream;
+
+#include <memory>
+
+using std::make_shared;
+using std::shared_ptr;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+using std::runtime_error;
+
+#include <string>
+
+using std::string;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngCorrRejectionSampler.hh"
+#include "AngularCorrelation.hh"
+#include "CascadeSampler.hh"
+#include "EventFile.hh"
+#include "SpotlightSampler.hh"
+#include "State.hh"
+#include "Transition.hh"
+
+const AngularCorrelation ang_cor(
+    State(0, positive),
+    {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+     {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+
+/**
+ * Create a cascade sampler with a beam-like first step and an angular
+ * correlation.
+ */
+CascadeSampler create_cascade_sampler() {
+  return CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+      make_shared<SpotlightSampler>(array<double, 2>{0.5, 0.2}, 0.1, 1),
+      make_shared<AngCorrRejectionSampler>(ang_cor, 2)});
+}
+
+/**
+ * Check that a damaged file is rejected by the constructor.
+ */
+void test_invalid_file(const string &file_name) {
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    EventFileReader reader(file_name);
+  } catch (const runtime_error &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
+
+/**
+ * Overwrite a number of bytes of a file at a given position.
+ */
+void overwrite(const string &file_name, const size_t position,
+               const string &bytes) {
+  fstream file(file_name, fstream::binary | fstream::in | fstream::out);
+  file.seekp(position);
+  file.write(bytes.data(), bytes.size());
+}
+
+int main() {
+
+  const string file_name = "test_event_file.bin";
+  const size_t chunk_size = 100, n_events = 250;
+  const size_t n_columns = CascadeSampler::n_components * 2;
+
+  // Sample events in pieces that do not coincide with the chunks and compare
+  // them to a single call of the block mode.
+  CascadeSampler cascade_sampler = create_cascade_sampler();
+  vector<double> Phi_Theta_Psi(n_columns * n_events);
+  cascade_sampler.sample(n_events, Phi_Theta_Psi.data());
+
+  cascade_sampler = create_cascade_sampler();
+  {
+    EventFileWriter writer(file_name, 2, CascadeSampler::n_components, false,
+                           chunk_size);
+    assert(writer.get_n_columns() == n_columns);
+    writer.sample(cascade_sampler, 30);
+    writer.sample(cascade_sampler, 120);
+    writer.sample(cascade_sampler, 100);
+    assert(writer.get_n_events() == n_events);
+    // The file is closed by the destructor.
+  }
+  assert(file_size(file_name) ==
+         sizeof(event_file::Header) + 3 * n_columns * chunk_size * 8);
+
+  {
+    const EventFileReader reader(file_name);
+    assert(reader.get_n_events() == n_events);
+    assert(reader.get_n_steps() == 2);
+    assert(reader.get_n_components() == CascadeSampler::n_components);
+    assert(!reader.is_weighted());
+    assert(reader.get_n_columns() == n_columns);
+    assert(reader.get_chunk_size() == chunk_size);
+    assert(reader.get_n_chunks() == 3);
+    assert(reader.get_chunk_length(0) == chunk_size);
+    assert(reader.get_chunk_length(2) == 50);
+
+    for (size_t c = 0; c < 3; ++c) {
+      for (size_t l = 0; l < n_columns; ++l) {
+        const double *column = reader.get_column(c, l);
+        for (size_t k = 0; k < reader.get_chunk_length(c); ++k) {
+          assert(column[k] ==
+                 Phi_Theta_Psi[l * n_events + c * chunk_size + k]);
+        }
+      }
+    }
+    // The last chunk is padded with zeros.
+    assert(reader.get_column(2, 0)[50] == 0.);
+
+    // Read a range across a chunk boundary.
+    vector<double> values(n_columns * 120);
+    reader.read(90, 120, values.data(), 120);
+    for (size_t l = 0; l < n_columns; ++l) {
+      for (size_t k = 0; k < 120; ++k) {
+        assert(values[l * 120 + k] == Phi_Theta_Psi[l * n_events + 90 + k]);
+      }
+    }
+
+    [[maybe_unused]] bool error_thrown = false;
+    try {
+      reader.read(200, 51, values.data(), 120);
+    } catch (const out_of_range &e) {
+      error_thrown = true;
+    }
+    assert(error_thrown);
+
+    error_thrown = false;
+    try {
+      reader.get_column(3, 0);
+    } catch (const out_of_range &e) {
+      error_thrown = true;
+    }
+    assert(error_thrown);
+
+    error_thrown = false;
+    try {
+      reader.get_column(0, n_columns);
+    } catch (const out_of_range &e) {
+      error_thrown = true;
+    }
+    assert(error_thrown);
+
+    error_thrown = false;
+    try {
+      reader.read(0, 1, values.data(), 1, values.data());
+    } catch (const invalid_argument &e) {
+      error_thrown = true;
+    }
+    assert(error_thrown);
+  }
+
+  // Weighted events, written from the block mode of the sampler and from an
+  // existing array.
+  CascadeSampler weighted_sampler = create_cascade_sampler();
+  vector<double> weights(n_events);
+  weighted_sampler.sample_weighted(n_events, Phi_Theta_Psi.data(), n_events,
+                                   weights.data());
+  weighted_sampler = create_cascade_sampler();
+  {
+    EventFileWriter writer(file_name, 2, CascadeSampler::n_components, true,
+                           chunk_size);
+    assert(writer.get_n_columns() == n_columns + 1);
+    writer.sample_weighted(weighted_sampler, 150);
+    writer.write(100, Phi_Theta_Psi.data() + 150, n_events,
+                 weights.data() + 150);
+    writer.close();
+
+    [[maybe_unused]] bool error_thrown = false;
+    try {
+      writer.sample_weighted(weighted_sampler, 1);
+    } catch (const runtime_error &e) {
+      error_thrown = true;
+    }
+    assert(error_thrown);
+  }
+  {
+    const EventFileReader reader(file_name);
+    assert(reader.is_weighted());
+    assert(reader.get_n_columns() == n_columns + 1);
+    vector<double> values(n_columns * n_events), read_weights(n_events);
+    reader.read(0, n_events, values.data(), n_events, read_weights.data());
+    assert(values == Phi_Theta_Psi);
+    assert(read_weights == weights);
+  }
+
+  // Files without events.
+  EventFileWriter(file_name, 2, CascadeSampler::n_components).close();
+  {
+    const EventFileReader reader(file_name);
+    assert(reader.get_n_events() == 0);
+    assert(reader.get_n_chunks() == 0);
+  }
+
+  // Mismatches between the writer and the events.
+  {
+    EventFileWriter writer(file_name, 3, CascadeSampler::n_components);
+
+    [[maybe_unused]] bool error_thrown = false;
+    try {
+      writer.sample(cascade_sampler, 1);
+    } catch (const invalid_argument &e) {
+      error_thrown = true;
+    }
+    assert(error_thrown);
+
+    error_thrown = false;
+    try {
+      writer.sample_weighted(cascade_sampler, 1);
+    } catch (const invalid_argument &e) {
+      error_thrown = true;
+    }
+    assert(error_thrown);
+
+    error_thrown = false;
+    try {
+      writer.write(1, Phi_Theta_Psi.data(), 1, weights.data());
+    } catch (const invalid_argument &e) {
+      error_thrown = true;
+    }
+    assert(error_thrown);
+  }
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    EventFileWriter(file_name, 2, CascadeSampler::n_components, false, 0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  // Damaged files.
+  const auto write_file = [&]() {
+    EventFileWriter writer(file_name, 2, CascadeSampler::n_components, false,
+                           chunk_size);
+    writer.write(n_events, Phi_Theta_Psi.data(), n_events);
+  };
+
+  write_file();
+  overwrite(file_name, 0, "ALPACAXX");
+  test_invalid_file(file_name);
+
+  write_file();
+  overwrite(file_name, 8, string("\x02\0\0\0", 4));
+  test_invalid_file(file_name);
+
+  write_file();
+  overwrite(file_name, 12, string("\x01\x02\x03\x04", 4));
+  test_invalid_file(file_name);
+
+  // Number of events that does not match the data section.
+  write_file();
+  overwrite(file_name, 40, string(8, '\x7f'));
+  test_invalid_file(file_name);
+
+  write_file();
+  resize_file(file_name, file_size(file_name) - sizeof(double));
+  test_invalid_file(file_name);
+
+  write_file();
+  resize_file(file_name, file_size(file_name) + sizeof(double));
+  test_invalid_file(file_name);
+
+  remove(file_name);
+}
@@ -0,0 +1,212 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <memory>
+
+using std::make_shared;
+using std::shared_ptr;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngCorrRejectionSampler.hh"
+#include "AngularCorrelation.hh"
+#include "CascadeSampler.hh"
+#include "EulerAngleRotation.hh"
+#include "EventReweighter.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+int main() {
+  // 0 -> 1 -> 0 cascades of dipole transitions and 0+ -> 2+ -> 0+ cascades of
+  // E2 transitions.
+  const AngularCorrelation dipole(
+      State(0, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.), State(2, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, 0.),
+        State(0, parity_unknown)}});
+  const AngularCorrelation dipole_pol_dir(
+      State(0, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.), State(2, positive)},
+       {Transition(magnetic, 2, electric, 4, 0.), State(0, positive)}});
+  const AngularCorrelation quadrupole(
+      State(0, positive),
+      {{Transition(electric, 4, magnetic, 6, 0.), State(4, positive)},
+       {Transition(electric, 4, magnetic, 6, 0.), State(0, positive)}});
+
+  // The weight of a single event is the ratio of the angular correlations at
+  // the local angles of each step, for both input formats.
+  const array<double, 2> theta_phi_0{0.7, 1.1}, theta_phi_1{2.1, -0.4};
+  const euler_angle_transform::RotationMatrix A_0 =
+      euler_angle_transform::rotation_matrix(
+          euler_angle_transform::from_spherical(theta_phi_0, 0.3));
+  const euler_angle_transform::RotationMatrix A_1 =
+      euler_angle_transform::multiply(
+          A_0, euler_angle_transform::rotation_matrix(
+                   euler_angle_transform::from_spherical(theta_phi_1, -1.2)));
+  const array<double, 3> Phi_Theta_Psi_0 = euler_angle_transform::angles(A_0),
+                         Phi_Theta_Psi_1 = euler_angle_transform::angles(A_1);
+  const vector<double> Phi_Theta_Psi{
+      Phi_Theta_Psi_0[0], Phi_Theta_Psi_0[1], Phi_Theta_Psi_0[2],
+      Phi_Theta_Psi_1[0], Phi_Theta_Psi_1[1], Phi_Theta_Psi_1[2]};
+  const vector<euler_angle_transform::RotationMatrix> A{A_0, A_1};
+
+  const double ratio_0 = quadrupole(theta_phi_0[0], theta_phi_0[1]) /
+                         dipole_pol_dir(theta_phi_0[0], theta_phi_0[1]);
+  const double ratio_1 = dipole(theta_phi_1[0], theta_phi_1[1]) /
+                         dipole_pol_dir(theta_phi_1[0], theta_phi_1[1]);
+
+  EventReweighter single({dipole_pol_dir, dipole_pol_dir},
+                         {{dipole_pol_dir, dipole_pol_dir},
+                          {quadrupole, dipole}});
+  assert(single.get_n_hypotheses() == 2);
+  vector<double> weights(2);
+  single(1, Phi_Theta_Psi.data(), 1, weights.data());
+  test_numerical_equality<double>(weights[0], 1., 1e-12);
+  test_numerical_equality<double>(weights[1], ratio_0 * ratio_1, 1e-10);
+  single(1, A.data(), 1, weights.data());
+  test_numerical_equality<double>(weights[0], 1., 1e-12);
+  test_numerical_equality<double>(weights[1], ratio_0 * ratio_1, 1e-10);
+  assert(single.get_statistics(1).n_events == 2);
+  test_numerical_equality<double>(single.get_statistics(1).maximum_weight,
+                                  ratio_0 * ratio_1, 1e-10);
+
+  // Only the second step is reweighted.
+  EventReweighter second_step({dipole_pol_dir}, {{dipole}}, 1);
+  second_step(1, Phi_Theta_Psi.data(), 1, weights.data());
+  test_numerical_equality<double>(weights[0], ratio_1, 1e-10);
+  second_step(1, A.data(), 1, weights.data());
+  test_numerical_equality<double>(weights[0], ratio_1, 1e-10);
+
+  // Generate a sample with the reference and reweight it. The mean values of
+  // the Legendre polynomials over the reweighted events are the ones of the
+  // hypothesis, for the direction of the first step in the laboratory frame
+  // and for the angle between the first and the second step.
+  const size_t n_events = 200000;
+  CascadeSampler cascade_sampler(vector<shared_ptr<ReferenceFrameSampler>>{
+      make_shared<AngCorrRejectionSampler>(dipole, 0),
+      make_shared<AngCorrRejectionSampler>(dipole, 1)});
+  vector<double> events(6 * n_events);
+  cascade_sampler.sample(n_events, events.data());
+
+  EventReweighter reweighter({dipole, dipole},
+                             {{dipole, dipole}, {quadrupole, quadrupole}});
+  weights.resize(2 * n_events);
+  reweighter(n_events, events.data(), n_events, weights.data());
+
+  const vector<double> c = quadrupole.get_legendre_coefficients();
+  const vector<double> d = quadrupole.get_associated_legendre_coefficients();
+  double sum_p_2_0 = 0., sum_p_2_2_0 = 0., sum_p_2_1 = 0.;
+  for (size_t k = 0; k < n_events; ++k) {
+    assert(weights[k] == 1.);
+    const double w = weights[n_events + k];
+
+    const euler_angle_transform::RotationMatrix B_0 =
+        euler_angle_transform::rotation_matrix(
+            {events[k], events[n_events + k], events[2 * n_events + k]});
+    const euler_angle_transform::RotationMatrix B_1 =
+        euler_angle_transform::rotation_matrix({events[3 * n_events + k],
+                                                events[4 * n_events + k],
+                                                events[5 * n_events + k]});
+    const array<double, 3> direction_0 = euler_angle_transform::direction(B_0),
+                           direction_1 = euler_angle_transform::direction(B_1);
+    const double x_0 = direction_0[2];
+    const double cos_2_phi_0 =
+        (direction_0[0] * direction_0[0] - direction_0[1] * direction_0[1]) /
+        (1. - x_0 * x_0);
+    const double x_01 = direction_0[0] * direction_1[0] +
+                        direction_0[1] * direction_1[1] +
+                        direction_0[2] * direction_1[2];
+
+    sum_p_2_0 += w * 0.5 * (3. * x_0 * x_0 - 1.);
+    sum_p_2_2_0 += w * cos_2_phi_0 * 3. * (1. - x_0 * x_0);
+    sum_p_2_1 += w * 0.5 * (3. * x_01 * x_01 - 1.);
+  }
+  const ReweightingStatistics &statistics = reweighter.get_statistics(1);
+  assert(statistics.n_events == n_events);
+  test_numerical_equality<double>(statistics.get_mean_weight(), 1., 1e-2);
+  test_numerical_equality<double>(sum_p_2_0 / statistics.sum_of_weights,
+                                  c[1] / (5. * c[0]), 1e-2);
+  test_numerical_equality<double>(sum_p_2_2_0 / statistics.sum_of_weights,
+                                  12. * d[0] / (5. * c[0]), 3e-2);
+  test_numerical_equality<double>(sum_p_2_1 / statistics.sum_of_weights,
+                                  c[1] / (5. * c[0]), 1e-2);
+
+  // The reference itself is perfectly covered, the E2 cascade is not.
+  test_numerical_equality<double>(reweighter.get_statistics(0).get_coverage(),
+                                  1., 1e-12);
+  assert(statistics.get_coverage() < 1.);
+  assert(statistics.get_effective_sample_size() < n_events);
+  const vector<size_t> poorly_covered =
+      reweighter.get_poorly_covered_hypotheses(
+          0.5 * (1. + statistics.get_coverage()));
+  assert(poorly_covered.size() == 1 && poorly_covered[0] == 1);
+  assert(reweighter.get_poorly_covered_hypotheses(0.).empty());
+
+  reweighter.reset_statistics();
+  assert(reweighter.get_statistics(1).n_events == 0);
+  assert(reweighter.get_statistics(1).get_coverage() == 0.);
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    reweighter.get_statistics(2);
+  } catch (const out_of_range &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    EventReweighter({dipole}, {});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    EventReweighter({dipole}, {{dipole, dipole}});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    EventReweighter({}, {{}});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
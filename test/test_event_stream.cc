@@ -0,0 +1,230 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <memory>
+
+using std::make_shared;
+using std::shared_ptr;
+
+#include <set>
+
+using std::set;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngCorrRejectionSampler.hh"
+#include "AngularCorrelation.hh"
+#include "CascadeSampler.hh"
+#include "DeterministicReferenceFrameSampler.hh"
+#include "EventStream.hh"
+#include "FourMomentumSampler.hh"
+#include "SpotlightSampler.hh"
+#include "State.hh"
+#include "Transition.hh"
+
+const AngularCorrelation ang_cor_1(
+    State(0, positive),
+    {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+     {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+const AngularCorrelation ang_cor_2(
+    State(4, positive),
+    {{Transition(electric, 4, magnetic, 6, 0.), State(0, positive)},
+     {Transition(electric, 4, magnetic, 6, 0.), State(4, positive)}});
+
+const unsigned int master_seed = 42;
+const size_t chunk_size = 100;
+
+/**
+ * Create a cascade sampler with a beam-like first step and two angular
+ * correlations. The seeds are irrelevant, because the stream reseeds all
+ * random number engines.
+ */
+CascadeSampler create_cascade_sampler() {
+  return CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+      make_shared<SpotlightSampler>(array<double, 2>{0.5, 0.2}, 0.1, 0),
+      make_shared<AngCorrRejectionSampler>(ang_cor_1, 0),
+      make_shared<AngCorrRejectionSampler>(ang_cor_2, 0)});
+}
+
+/**
+ * Create a four-momentum sampler for the capture of a photon along the z axis
+ * by a 12C nucleus and the emission of a photon to the ground state.
+ */
+FourMomentumSampler create_four_momentum_sampler() {
+  return FourMomentumSampler(
+      CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+          make_shared<DeterministicReferenceFrameSampler>(
+              array<double, 3>{0., 0., 0.}),
+          make_shared<AngCorrRejectionSampler>(ang_cor_1, 0)}),
+      {0., 4.4, 0.}, 11177.9, {0., 0., 0.}, 1e-6, 0);
+}
+
+/**
+ * Chunk c of a stream, sampled by a single sampler which was seeded with the
+ * master seed and c.
+ */
+template <typename Sampler>
+vector<double> reference_chunk(Sampler &sampler, const size_t event_size,
+                               const unsigned long long c) {
+  vector<double> events(chunk_size * event_size);
+  sampler.reseed(master_seed, c);
+  sampler.sample(chunk_size, events.data(), chunk_size);
+  return events;
+}
+
+int main() {
+
+  const unsigned long long n_chunks = 10;
+  CascadeSampler cascade_sampler = create_cascade_sampler();
+
+  // In the deterministic mode, the chunks leave the ring in the order of their
+  // stream indices, independent of the number of threads.
+  for (unsigned int n_threads : {1, 3, 8}) {
+    EventStream<CascadeSampler> stream(create_cascade_sampler, master_seed,
+                                       n_threads, 4, chunk_size, true,
+                                       n_chunks);
+    assert(stream.get_n_threads() == n_threads);
+    assert(stream.get_depth() == 4);
+    assert(stream.get_chunk_size() == chunk_size);
+    assert(stream.get_event_size() == 3 * 3);
+    assert(stream.is_deterministic());
+
+    vector<double> events(chunk_size * stream.get_event_size());
+    unsigned long long chunk;
+    for (unsigned long long c = 0; c < n_chunks; ++c) {
+      assert(stream.pop(events.data(), &chunk));
+      assert(chunk == c);
+      assert(events ==
+             reference_chunk(cascade_sampler, stream.get_event_size(), c));
+    }
+    assert(!stream.pop(events.data()));
+  }
+
+  // In the non-deterministic mode, the order may differ, but the content of
+  // the chunks is the same.
+  {
+    EventStream<CascadeSampler> stream(create_cascade_sampler, master_seed, 4,
+                                       2, chunk_size, false, n_chunks);
+    assert(!stream.is_deterministic());
+    vector<double> events(chunk_size * stream.get_event_size());
+    unsigned long long chunk;
+    set<unsigned long long> chunks;
+    while (stream.pop(events.data(), &chunk)) {
+      assert(chunks.insert(chunk).second);
+      assert(events ==
+             reference_chunk(cascade_sampler, stream.get_event_size(), chunk));
+    }
+    assert(chunks.size() == n_chunks);
+    assert(*chunks.rbegin() == n_chunks - 1);
+  }
+
+  // A ring with a single slot holds one chunk at a time, so no chunk is
+  // overwritten before it was taken, even with several workers.
+  for (bool deterministic : {true, false}) {
+    EventStream<CascadeSampler> stream(create_cascade_sampler, master_seed, 4,
+                                       1, chunk_size, deterministic, n_chunks);
+    assert(stream.get_depth() == 1);
+    vector<double> events(chunk_size * stream.get_event_size());
+    unsigned long long chunk;
+    set<unsigned long long> chunks;
+    while (stream.pop(events.data(), &chunk)) {
+      assert(chunks.insert(chunk).second);
+      assert(!deterministic || chunk == chunks.size() - 1);
+      assert(events ==
+             reference_chunk(cascade_sampler, stream.get_event_size(), chunk));
+    }
+    assert(chunks.size() == n_chunks);
+  }
+
+  // A Consumer hands out the events of the chunks one by one.
+  {
+    EventStream<CascadeSampler> stream(create_cascade_sampler, master_seed, 2,
+                                       4, chunk_size, true, 2);
+    EventStream<CascadeSampler>::Consumer consumer(stream);
+    const size_t event_size = stream.get_event_size();
+    vector<double> event(event_size);
+    for (unsigned long long c = 0; c < 2; ++c) {
+      const vector<double> events =
+          reference_chunk(cascade_sampler, event_size, c);
+      for (size_t k = 0; k < chunk_size; ++k) {
+        assert(consumer.next(event.data()));
+        for (size_t l = 0; l < event_size; ++l) {
+          assert(event[l] == events[l * chunk_size + k]);
+        }
+      }
+    }
+    assert(!consumer.next(event.data()));
+  }
+
+  // Stream of four momenta.
+  {
+    FourMomentumSampler four_momentum_sampler = create_four_momentum_sampler();
+    EventStream<FourMomentumSampler> stream(create_four_momentum_sampler,
+                                            master_seed, 2, 2, chunk_size,
+                                            true, 3);
+    assert(stream.get_event_size() == 4 * 2);
+    vector<double> events(chunk_size * stream.get_event_size());
+    for (unsigned long long c = 0; c < 3; ++c) {
+      assert(stream.pop(events.data()));
+      assert(events == reference_chunk(four_momentum_sampler,
+                                       stream.get_event_size(), c));
+    }
+    assert(!stream.pop(events.data()));
+  }
+
+  // An unbounded stream can be stopped while the workers wait for free slots.
+  {
+    EventStream<CascadeSampler> stream(create_cascade_sampler, master_seed, 3,
+                                       2, chunk_size);
+    vector<double> events(chunk_size * stream.get_event_size());
+    for (unsigned long long c = 0; c < 5; ++c) {
+      assert(stream.pop(events.data()));
+    }
+    stream.stop();
+    assert(!stream.pop(events.data()));
+  }
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    EventStream<CascadeSampler>(create_cascade_sampler, master_seed, 1, 0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    EventStream<CascadeSampler>(create_cascade_sampler, master_seed, 1, 8, 0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
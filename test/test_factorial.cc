@@ -0,0 +1,49 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <gsl/gsl_sf.h>
+
+#include "Factorial.hh"
+#include "TestUtilities.hh"
+
+int main() {
+
+  static_assert(factorial::factorial(0) == 1.);
+  static_assert(factorial::factorial(5) == 120.);
+  static_assert(factorial::ratio(6, 2) == 360.);
+  static_assert(factorial::ratio(2, 6) == 1. / 360.);
+
+  for (unsigned int n = 0; n <= factorial::n_max; ++n) {
+    test_numerical_equality<double>(factorial::factorial(n) / gsl_sf_fact(n),
+                                    1., 1e-13);
+  }
+
+  // Ratios which appear in the coefficients of the angular correlations.
+  for (unsigned int nu = 2; nu <= 40; nu += 2) {
+    test_numerical_equality<double>(factorial::ratio(nu - 2, nu + 2) *
+                                        gsl_sf_fact(nu + 2) /
+                                        gsl_sf_fact(nu - 2),
+                                    1., 1e-14);
+  }
+
+  // The ratio does not overflow for large arguments.
+  test_numerical_equality<double>(factorial::ratio(1002, 1000), 1002. * 1001.,
+                                  1e-10);
+  test_numerical_equality<double>(factorial::ratio(17, 17), 1., 1e-16);
+}
@@ -0,0 +1,226 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <memory>
+
+using std::make_shared;
+using std::shared_ptr;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngCorrRejectionSampler.hh"
+#include "AngularCorrelation.hh"
+#include "CascadeSampler.hh"
+#include "DeterministicReferenceFrameSampler.hh"
+#include "FourMomentumSampler.hh"
+#include "SpotlightSampler.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+const AngularCorrelation ang_cor(
+    State(0, positive),
+    {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+     {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+
+/**
+ * Create a four-momentum sampler for the capture of a photon along the z axis
+ * with an energy of 4.4 MeV by a 12C nucleus and the emission of a photon
+ * to the ground state.
+ */
+FourMomentumSampler create_four_momentum_sampler(const double temperature,
+                                                 const int seed) {
+  return FourMomentumSampler(
+      CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+          make_shared<DeterministicReferenceFrameSampler>(
+              array<double, 3>{0., 0., 0.}),
+          make_shared<AngCorrRejectionSampler>(ang_cor, seed)}),
+      {0., 4.4, 0.}, 11177.9, {0., 0., 0.}, temperature, seed);
+}
+
+/**
+ * Check conservation of four momentum for a capture and an emission by a
+ * nucleus at rest, and that the photons are massless.
+ */
+void test_conservation(const vector<double> &p, const size_t k,
+                       const size_t n, const double mass,
+                       const double epsilon) {
+  array<double, 4> nucleus{mass, 0., 0., 0.};
+  for (size_t j = 0; j < 4; ++j) {
+    nucleus[j] += p[j * n + k] - p[(4 + j) * n + k];
+  }
+  test_numerical_equality<double>(
+      sqrt(nucleus[0] * nucleus[0] - nucleus[1] * nucleus[1] -
+           nucleus[2] * nucleus[2] - nucleus[3] * nucleus[3]),
+      mass, epsilon);
+  for (size_t i = 0; i < 2; ++i) {
+    test_numerical_equality<double>(
+        p[4 * i * n + k] * p[4 * i * n + k],
+        p[(4 * i + 1) * n + k] * p[(4 * i + 1) * n + k] +
+            p[(4 * i + 2) * n + k] * p[(4 * i + 2) * n + k] +
+            p[(4 * i + 3) * n + k] * p[(4 * i + 3) * n + k],
+        epsilon);
+  }
+}
+
+int main() {
+  const double epsilon = 1e-8;
+  const double mass = 11177.9, e_1 = 4.4;
+
+  // Capture and emission by a nucleus at rest. The energies are compared to
+  // the expressions in the documentation of FourMomentumSampler.
+  const double Theta = 2.;
+  FourMomentumSampler deterministic(
+      CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+          make_shared<DeterministicReferenceFrameSampler>(
+              array<double, 3>{0., 0., 0.}),
+          make_shared<DeterministicReferenceFrameSampler>(
+              array<double, 3>{0., Theta, 0.})}),
+      {0., e_1, 0.}, mass);
+  assert(deterministic.get_n_steps() == 2);
+  vector<array<double, 4>> p_deterministic = deterministic();
+
+  const double e_gamma = e_1 * (1. + e_1 / (2. * mass));
+  test_numerical_equality<double>(
+      4, p_deterministic[0].data(),
+      array<double, 4>{e_gamma, 0., 0., e_gamma}.data(), epsilon);
+
+  const double e_gamma_rest =
+      e_1 * (1. + e_1 / (2. * mass)) / (1. + e_1 / mass);
+  const double beta =
+      e_gamma / sqrt((mass + e_1) * (mass + e_1) + e_gamma * e_gamma);
+  const double gamma = 1. / sqrt(1. - beta * beta);
+  // The angle in the rest frame is Theta, the one in the laboratory frame is
+  // given by the aberration formula.
+  const double cos_theta = (cos(Theta) + beta) / (1. + beta * cos(Theta));
+  test_numerical_equality<double>(
+      p_deterministic[1][0],
+      e_gamma_rest / (gamma * (1. - beta * cos_theta)), epsilon);
+  test_numerical_equality<double>(p_deterministic[1][3] / p_deterministic[1][0],
+                                  cos_theta, epsilon);
+
+  // Emission by a nucleus at rest.
+  FourMomentumSampler emission(
+      CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+          make_shared<SpotlightSampler>(array<double, 2>{0.5, 0.2}, 0)}),
+      {e_1, 0.}, mass);
+  const array<double, 4> p_emission = emission()[0];
+  const array<double, 3> direction = euler_angle_transform::direction(
+      euler_angle_transform::rotation_matrix(
+          euler_angle_transform::from_spherical({0.5, 0.2})));
+  test_numerical_equality<double>(p_emission[0], e_gamma_rest, epsilon);
+  for (size_t j = 0; j < 3; ++j) {
+    test_numerical_equality<double>(p_emission[j + 1],
+                                    e_gamma_rest * direction[j], epsilon);
+  }
+
+  // The block mode gives the same result as consecutive calls of the call
+  // operator, and four momentum is conserved.
+  const size_t n_events = 2 * CascadeSampler::block_size + 5;
+  FourMomentumSampler single = create_four_momentum_sampler(0., 1);
+  FourMomentumSampler batch = create_four_momentum_sampler(0., 1);
+  vector<double> p(8 * n_events);
+  batch.sample(n_events, p.data());
+  for (size_t k = 0; k < n_events; ++k) {
+    const vector<array<double, 4>> p_single = single();
+    for (size_t i = 0; i < 2; ++i) {
+      for (size_t j = 0; j < 4; ++j) {
+        test_numerical_equality<double>(p[(4 * i + j) * n_events + k],
+                                        p_single[i][j], epsilon);
+      }
+    }
+    test_conservation(p, k, n_events, mass, epsilon);
+  }
+
+  // Thermal motion. Reseeding reproduces the same events. The standard
+  // deviation of the energy of the captured photon is given by the Doppler
+  // shift, E_gamma sqrt(k_B T / M).
+  const double temperature = 1e-6;
+  const size_t n_thermal = 100000;
+  FourMomentumSampler thermal = create_four_momentum_sampler(temperature, 2);
+  FourMomentumSampler thermal_reseeded =
+      create_four_momentum_sampler(temperature, 3);
+  thermal.reseed(4, 5);
+  thermal_reseeded.reseed(4, 5);
+  p.resize(8 * n_thermal);
+  vector<double> p_reseeded(8 * n_thermal);
+  thermal.sample(n_thermal, p.data());
+  thermal_reseeded.sample(n_thermal, p_reseeded.data());
+  double sum = 0., sum_of_squares = 0.;
+  for (size_t k = 0; k < n_thermal; ++k) {
+    assert(p[k] == p_reseeded[k]);
+    assert(p[4 * n_thermal + k] == p_reseeded[4 * n_thermal + k]);
+    sum += p[k];
+    sum_of_squares += p[k] * p[k];
+  }
+  const double mean = sum / n_thermal;
+  test_numerical_equality<double>(mean, e_gamma, 1e-6);
+  test_numerical_equality<double>(
+      sqrt(sum_of_squares / n_thermal - mean * mean) /
+          (e_gamma * sqrt(temperature / mass)),
+      1., 2e-2);
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    FourMomentumSampler(
+        CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+            make_shared<SpotlightSampler>(array<double, 2>{0.5, 0.2}, 0)}),
+        {e_1, 0., 0.}, mass);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    FourMomentumSampler(
+        CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+            make_shared<SpotlightSampler>(array<double, 2>{0.5, 0.2}, 0),
+            make_shared<SpotlightSampler>(array<double, 2>{0.5, 0.2}, 0)}),
+        {0., 1., 2.}, mass);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    FourMomentumSampler(
+        CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+            make_shared<SpotlightSampler>(array<double, 2>{0.5, 0.2}, 0)}),
+        {e_1, 0.}, mass, {0., 0., 1.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
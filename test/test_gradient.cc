@@ -0,0 +1,200 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "LegendreSeries.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Compare the analytical gradient of an angular correlation to central finite
+ * differences.
+ */
+void test_gradient(const AngularCorrelation &ang_cor,
+                   const vector<double> &deltas) {
+
+  const double h = 1e-6;
+  const double epsilon = 1e-7;
+  const size_t n_cascade_steps = deltas.size();
+  const size_t row_length = n_cascade_steps + 2;
+
+  const size_t n = legendre_series::block_size + 5;
+  vector<double> theta(n), phi(n), result(n), gradient(n * row_length);
+  for (size_t k = 0; k < n; ++k) {
+    theta[k] = 0.05 + 3. * k / (n - 1.);
+    phi[k] = 2. * M_PI * ((5 * k) % n) / n;
+  }
+
+  ang_cor.evaluate_with_gradient(n, theta.data(), phi.data(), deltas,
+                                 result.data(), gradient.data());
+
+  for (size_t k = 0; k < n; ++k) {
+    test_numerical_equality<double>(result[k],
+                                    ang_cor(theta[k], phi[k], deltas), 1e-12);
+
+    const double *g = gradient.data() + k * row_length;
+    test_numerical_equality<double>(
+        g[0],
+        (ang_cor(theta[k] + h, phi[k], deltas) -
+         ang_cor(theta[k] - h, phi[k], deltas)) /
+            (2. * h),
+        epsilon);
+    test_numerical_equality<double>(
+        g[1],
+        (ang_cor(theta[k], phi[k] + h, deltas) -
+         ang_cor(theta[k], phi[k] - h, deltas)) /
+            (2. * h),
+        epsilon);
+    for (size_t j = 0; j < n_cascade_steps; ++j) {
+      vector<double> deltas_plus(deltas), deltas_minus(deltas);
+      deltas_plus[j] += h;
+      deltas_minus[j] -= h;
+      test_numerical_equality<double>(
+          g[2 + j],
+          (ang_cor(theta[k], phi[k], deltas_plus) -
+           ang_cor(theta[k], phi[k], deltas_minus)) /
+              (2. * h),
+          epsilon);
+    }
+  }
+
+  // Single direction
+  const vector<double> w_gradient =
+      ang_cor.evaluate_with_gradient(theta[3], phi[3], deltas);
+  assert(w_gradient.size() == n_cascade_steps + 3);
+  test_numerical_equality<double>(w_gradient[0], result[3], 1e-14);
+  for (size_t i = 0; i < row_length; ++i) {
+    test_numerical_equality<double>(w_gradient[i + 1],
+                                    gradient[3 * row_length + i], 1e-14);
+  }
+}
+
+int main() {
+
+  // Derivatives of the Legendre series.
+  const size_t n_x = 101;
+  const double h = 1e-6;
+  vector<double> x(n_x), x_plus(n_x), x_minus(n_x), derivative(n_x),
+      plus(n_x), minus(n_x);
+  for (size_t k = 0; k < n_x; ++k) {
+    x[k] = -1. + 2. * k / (n_x - 1.);
+    x_plus[k] = x[k] + h;
+    x_minus[k] = x[k] - h;
+  }
+  const vector<double> coefficients{0.3, -1.2, 0.7, 0.4, -0.1};
+  legendre_series::legendre_derivative(n_x, x.data(), coefficients.size(),
+                                       coefficients.data(), derivative.data());
+  legendre_series::legendre(n_x, x_plus.data(), coefficients.size(),
+                            coefficients.data(), plus.data());
+  legendre_series::legendre(n_x, x_minus.data(), coefficients.size(),
+                            coefficients.data(), minus.data());
+  for (size_t k = 0; k < n_x; ++k) {
+    test_numerical_equality<double>(derivative[k],
+                                    (plus[k] - minus[k]) / (2. * h), 1e-6);
+  }
+  legendre_series::associated_legendre_2_derivative(
+      n_x, x.data(), coefficients.size(), coefficients.data(),
+      derivative.data());
+  legendre_series::associated_legendre_2(n_x, x_plus.data(),
+                                         coefficients.size(),
+                                         coefficients.data(), plus.data());
+  legendre_series::associated_legendre_2(n_x, x_minus.data(),
+                                         coefficients.size(),
+                                         coefficients.data(), minus.data());
+  for (size_t k = 0; k < n_x; ++k) {
+    test_numerical_equality<double>(derivative[k],
+                                    (plus[k] - minus[k]) / (2. * h), 1e-4);
+  }
+
+  // Dir-dir correlation
+  const AngularCorrelation dir_dir(
+      State(3, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.), State(5, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, 0.),
+        State(3, parity_unknown)}});
+  test_gradient(dir_dir, {0.3, -0.7});
+  test_gradient(dir_dir, {-2.1, 0.});
+
+  // Pol-dir correlations with both possible EM characters
+  const AngularCorrelation pol_dir_electric(
+      State(3, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(5, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(3, positive)}});
+  test_gradient(pol_dir_electric, {0.5, 0.5});
+  const AngularCorrelation pol_dir_magnetic(
+      State(4, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.), State(6, positive)},
+       {Transition(magnetic, 2, electric, 4, 0.), State(4, positive)}});
+  test_gradient(pol_dir_magnetic, {-1.3, 0.2});
+
+  // Higher orders of the expansion
+  test_gradient(
+      AngularCorrelation(
+          State(5, positive),
+          {{Transition(electric, 4, magnetic, 6, 0.), State(9, positive)},
+           {Transition(electric, 4, magnetic, 6, 0.), State(5, positive)}}),
+      {0.4, 0.9});
+
+  // Unobserved intermediate transitions
+  test_gradient(
+      AngularCorrelation(
+          State(0, positive),
+          {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+           {Transition(electric, 2, magnetic, 4, 0.), State(4, positive)},
+           {Transition(magnetic, 2, electric, 4, 0.), State(4, positive)}}),
+      {0.1, 0.4, -0.2});
+  test_gradient(
+      AngularCorrelation(
+          State(3, parity_unknown),
+          {{Transition(em_unknown, 2, em_unknown, 4, 0.),
+            State(5, parity_unknown)},
+           {Transition(em_unknown, 2, em_unknown, 4, 0.),
+            State(7, parity_unknown)},
+           {Transition(em_unknown, 2, em_unknown, 4, 0.),
+            State(5, parity_unknown)},
+           {Transition(em_unknown, 2, em_unknown, 4, 0.),
+            State(3, parity_unknown)}}),
+      {0.2, -0.6, 1.1, 0.3});
+
+  // The number of mixing ratios must match the number of cascade steps.
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    dir_dir.evaluate_with_gradient(0., 0., {0.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -0,0 +1,226 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <cstdint>
+
+using std::uint64_t;
+
+#include <optional>
+
+using std::optional;
+
+#include <thread>
+
+using std::thread;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "HandleTable.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+extern "C" {
+uint64_t try_create_angular_correlation_handle(
+    const size_t n_cas_ste, int *two_J, short *par, short *em_char, int *two_L,
+    short *em_charp, int *two_Lp, double *delta, int *status,
+    const size_t message_length, char *message);
+int create_angular_correlation_handles(const size_t n_cascades,
+                                       size_t *offsets, int *two_J, short *par,
+                                       short *em_char, int *two_L,
+                                       short *em_charp, int *two_Lp,
+                                       double *delta, uint64_t *handles);
+void *get_angular_correlation_from_handle(const uint64_t handle);
+int retain_angular_correlation_handle(const uint64_t handle);
+int release_angular_correlation_handle(const uint64_t handle);
+size_t release_angular_correlation_handles(const size_t n, uint64_t *handles);
+size_t get_n_angular_correlation_handles();
+}
+
+/**
+ * \brief Object that counts its live instances.
+ */
+struct Counted {
+  static int n_live;
+  int value;
+
+  explicit Counted(const int val) : value(val) { ++n_live; }
+  Counted(const Counted &counted) : value(counted.value) { ++n_live; }
+  ~Counted() { --n_live; }
+};
+
+int Counted::n_live = 0;
+
+int main() {
+  using Handle = HandleTable<Counted>::Handle;
+
+  // Reference counting and the detection of stale handles.
+  HandleTable<Counted> table(4);
+  const Handle first = table.insert(Counted(1));
+  assert(first != HandleTable<Counted>::invalid_handle);
+  assert(table.get(first)->value == 1);
+  assert(table.retain(first));
+  assert(table.get_reference_count(first) == 2);
+  assert(table.release(first));
+  assert(Counted::n_live == 1);
+  assert(table.release(first));
+  assert(Counted::n_live == 0);
+  assert(table.get(first) == nullptr);
+  assert(!table.release(first));
+  assert(!table.retain(first));
+  assert(table.get(HandleTable<Counted>::invalid_handle) == nullptr);
+
+  // The free slot is reused with a new handle.
+  const Handle second = table.insert(Counted(2));
+  assert(second != first);
+  assert(table.get(first) == nullptr);
+  assert(table.get(second)->value == 2);
+  assert(table.size() == 1);
+  assert(table.get_n_blocks() == 1);
+
+  // A batch allocates at most a single block, and empty elements are
+  // skipped.
+  const size_t n = 1000;
+  vector<optional<Counted>> objects(n);
+  for (size_t i = 0; i < n; ++i) {
+    if (i % 10 != 0) {
+      objects[i].emplace(static_cast<int>(i));
+    }
+  }
+  vector<Handle> handles(n);
+  table.insert(n, objects.data(), handles.data());
+  assert(table.get_n_blocks() == 2);
+  assert(table.size() == 1 + n - n / 10);
+  for (size_t i = 0; i < n; ++i) {
+    if (i % 10 == 0) {
+      assert(handles[i] == HandleTable<Counted>::invalid_handle);
+    } else {
+      assert(table.get(handles[i])->value == static_cast<int>(i));
+    }
+  }
+  assert(table.release(n, handles.data()) == n - n / 10);
+  assert(table.size() == 1);
+  objects.clear();
+  assert(Counted::n_live == 1);
+
+  // The second batch fits into the free slots.
+  const size_t capacity = table.capacity();
+  objects.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    if (i % 10 != 0) {
+      objects[i].emplace(static_cast<int>(i));
+    }
+  }
+  table.insert(n, objects.data(), handles.data());
+  assert(table.get_n_blocks() == 2);
+  assert(table.capacity() == capacity);
+
+  // Concurrent references.
+  vector<thread> threads;
+  for (size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&]() {
+      for (size_t i = 0; i < n; ++i) {
+        table.retain(handles[i]);
+        table.release(handles[i]);
+      }
+    });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  for (size_t i = 0; i < n; ++i) {
+    assert(table.get_reference_count(handles[i]) == (i % 10 != 0 ? 1 : 0));
+  }
+  table.release(n, handles.data());
+  assert(table.size() == 1);
+
+  // C interface: a 0+ -> 1- -> 0+ cascade, an invalid cascade, and a cascade
+  // with inferred transitions.
+  const size_t n_before = get_n_angular_correlation_handles();
+  const AngularCorrelation ang_cor(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+
+  int two_J[3]{0, 2, 0};
+  short par[3]{positive, negative, positive};
+  short em_char[2]{electric, electric};
+  int two_L[2]{2, 2};
+  short em_charp[2]{magnetic, magnetic};
+  int two_Lp[2]{4, 4};
+  double delta[2]{0., 0.};
+  int status = -1;
+  const uint64_t handle = try_create_angular_correlation_handle(
+      2, two_J, par, em_char, two_L, em_charp, two_Lp, delta, &status, 0,
+      nullptr);
+  assert(status == cascade_valid);
+  const AngularCorrelation *c_ang_cor =
+      (AngularCorrelation *)get_angular_correlation_from_handle(handle);
+  test_numerical_equality<double>((*c_ang_cor)(0.5, 0.2), ang_cor(0.5, 0.2),
+                                  1e-12);
+  assert(get_n_angular_correlation_handles() == n_before + 1);
+
+  two_Lp[1] = 2;
+  assert(try_create_angular_correlation_handle(2, two_J, par, em_char, two_L,
+                                               em_charp, two_Lp, delta,
+                                               &status, 0, nullptr) == 0);
+  assert(status == cascade_invalid_quantum_number);
+
+  size_t offsets[3]{0, 2, 4};
+  int two_J_batch[6]{0, 2, 0, 0, 2, 0};
+  short par_batch[6]{positive, negative, positive,
+                     positive, negative, positive};
+  short em_char_batch[4]{electric, electric, electric, electric};
+  int two_L_batch[4]{2, 2, 2, 2};
+  short em_charp_batch[4]{magnetic, magnetic, magnetic, magnetic};
+  int two_Lp_batch[4]{4, 4, 4, 2};
+  double delta_batch[4]{0., 0., 0., 0.};
+  uint64_t batch[2];
+  assert(create_angular_correlation_handles(
+             2, offsets, two_J_batch, par_batch, em_char_batch, two_L_batch,
+             em_charp_batch, two_Lp_batch, delta_batch,
+             batch) == cascade_invalid_quantum_number);
+  assert(batch[0] != 0 && batch[1] == 0);
+  test_numerical_equality<double>(
+      (*(AngularCorrelation *)get_angular_correlation_from_handle(batch[0]))(
+          0.5, 0.2),
+      ang_cor(0.5, 0.2), 1e-12);
+
+  uint64_t inferred[2];
+  assert(create_angular_correlation_handles(2, offsets, two_J_batch, par_batch,
+                                            nullptr, nullptr, nullptr, nullptr,
+                                            nullptr,
+                                            inferred) == cascade_valid);
+  assert(get_n_angular_correlation_handles() == n_before + 4);
+
+  // Python finalizers may release a handle after an explicit release.
+  assert(retain_angular_correlation_handle(handle));
+  assert(release_angular_correlation_handle(handle));
+  assert(release_angular_correlation_handle(handle));
+  assert(!release_angular_correlation_handle(handle));
+  assert(get_angular_correlation_from_handle(handle) == nullptr);
+  assert(release_angular_correlation_handles(2, batch) == 1);
+  assert(release_angular_correlation_handles(2, inferred) == 2);
+  assert(get_n_angular_correlation_handles() == n_before);
+}
@@ -0,0 +1,183 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "HealpixMap.hh"
+#include "RotatedAngularCorrelation.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+int main() {
+  const double epsilon = 1e-12;
+
+  // Pixel centers for the lowest resolution, which has three rings with
+  // four pixels each.
+  HealpixMap lowest(1);
+  assert(lowest.get_n_pixels() == 12);
+  for (size_t p = 0; p < 12; ++p) {
+    const array<double, 2> theta_phi = lowest.pixel_center(p);
+    test_numerical_equality<double>(cos(theta_phi[0]),
+                                    (1. - static_cast<double>(p / 4)) * 2. / 3.,
+                                    epsilon);
+    test_numerical_equality<double>(
+        theta_phi[1], (static_cast<double>(p % 4) + (p / 4 == 1 ? 0. : 0.5)) *
+                          M_PI_2,
+        epsilon);
+  }
+
+  // The conversion from the nested to the ring ordering is a permutation, and
+  // the pixel that contains the center of a pixel is the pixel itself.
+  const size_t nside = 8;
+  HealpixMap ring(nside, ring_ordering, 4, 2);
+  HealpixMap nested(nside, nested_ordering, 4, 2);
+  const size_t n_pixels = ring.get_n_pixels();
+  vector<bool> found(n_pixels, false);
+  for (size_t p = 0; p < n_pixels; ++p) {
+    const size_t r = HealpixMap::nested_to_ring(nside, p);
+    assert(r < n_pixels && !found[r]);
+    found[r] = true;
+
+    const array<double, 2> theta_phi_ring = ring.pixel_center(r);
+    const array<double, 2> theta_phi_nested = nested.pixel_center(p);
+    test_numerical_equality<double>(theta_phi_ring[0], theta_phi_nested[0],
+                                    epsilon);
+    test_numerical_equality<double>(theta_phi_ring[1], theta_phi_nested[1],
+                                    epsilon);
+    assert(ring.pixel(theta_phi_ring[0], theta_phi_ring[1]) == r);
+    assert(nested.pixel(theta_phi_nested[0], theta_phi_nested[1]) == p);
+  }
+
+  // In the ring ordering, the pixels are sorted by the polar angle, and by
+  // the azimuthal angle within a ring.
+  for (size_t r = 1; r < n_pixels; ++r) {
+    const array<double, 2> previous = ring.pixel_center(r - 1);
+    const array<double, 2> current = ring.pixel_center(r);
+    assert(current[0] > previous[0] - epsilon);
+    assert(current[0] > previous[0] + epsilon || current[1] > previous[1]);
+  }
+
+  // An isotropic distribution has the same fraction in every pixel.
+  const vector<double> isotropic = ring.expected_fractions(
+      RotatedAngularCorrelation({2.}, {}, {0., 0., 0.}));
+  for (size_t r = 0; r < n_pixels; ++r) {
+    test_numerical_equality<double>(isotropic[r], 1. / n_pixels, epsilon);
+  }
+
+  // The fractions of an angular correlation add up to 1, they do not depend
+  // on the ordering, and the unrotated map is symmetric with respect to the
+  // plane z = 0.
+  const AngularCorrelation ang_cor(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+  const array<double, 3> Phi_Theta_Psi{0.3, 1.2, -0.7};
+
+  const vector<double> unrotated = ring.expected_fractions(ang_cor);
+  const vector<double> rotated =
+      ring.expected_fractions(ang_cor, Phi_Theta_Psi);
+  const vector<double> rotated_nested =
+      nested.expected_fractions(ang_cor, Phi_Theta_Psi);
+  const vector<double> rotated_expansion = ring.expected_fractions(
+      RotatedAngularCorrelation(ang_cor, Phi_Theta_Psi));
+  double sum_unrotated = 0., sum_rotated = 0.;
+  for (size_t p = 0; p < n_pixels; ++p) {
+    const size_t r = HealpixMap::nested_to_ring(nside, p);
+    sum_unrotated += unrotated[r];
+    sum_rotated += rotated[r];
+    test_numerical_equality<double>(rotated_nested[p], rotated[r], epsilon);
+    test_numerical_equality<double>(rotated_expansion[r], rotated[r],
+                                    epsilon);
+    const array<double, 2> theta_phi = ring.pixel_center(r);
+    test_numerical_equality<double>(
+        unrotated[r], unrotated[ring.pixel(M_PI - theta_phi[0], theta_phi[1])],
+        epsilon);
+  }
+  test_numerical_equality<double>(sum_unrotated, 1., epsilon);
+  test_numerical_equality<double>(sum_rotated, 1., epsilon);
+
+  // Convergence of the quadrature: a finer subdivision changes the fractions
+  // by a small fraction of their size. For a fine resolution, the fraction
+  // is approximately the value of the normalized angular correlation at the
+  // center of a pixel, multiplied by the solid angle of the pixel.
+  const vector<double> fine =
+      HealpixMap(nside, ring_ordering, 4, 5)
+          .expected_fractions(ang_cor, Phi_Theta_Psi);
+  const RotatedAngularCorrelation rot_ang_cor(ang_cor, Phi_Theta_Psi);
+  const double normalization =
+      ang_cor.get_legendre_coefficients()[0] * n_pixels;
+  for (size_t r = 0; r < n_pixels; ++r) {
+    test_numerical_equality<double>(fine[r] * n_pixels, rotated[r] * n_pixels,
+                                    1e-3);
+    const array<double, 2> theta_phi = ring.pixel_center(r);
+    test_numerical_equality<double>(
+        fine[r] * n_pixels,
+        rot_ang_cor(theta_phi[0], theta_phi[1]) / normalization * n_pixels,
+        2e-2);
+  }
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    HealpixMap(3);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    HealpixMap(nside, ring_ordering, 0).expected_fractions(ang_cor);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    ring.pixel_center(n_pixels);
+  } catch (const out_of_range &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    ring.get_integral(0, 1, 0);
+  } catch (const out_of_range &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -0,0 +1,201 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "HypothesisDiscriminator.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+int main() {
+  const double epsilon = 1e-10;
+
+  // Spin-parity hypotheses for a state excited from and decaying to a 0+
+  // ground state by polarized photons.
+  const vector<AngularCorrelation> hypotheses{
+      AngularCorrelation(
+          State(0, positive),
+          {{Transition(magnetic, 2, electric, 4, 0.), State(2, positive)},
+           {Transition(magnetic, 2, electric, 4, 0.), State(0, positive)}}),
+      AngularCorrelation(
+          State(0, positive),
+          {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+           {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}}),
+      AngularCorrelation(
+          State(0, positive),
+          {{Transition(electric, 4, magnetic, 6, 0.), State(4, positive)},
+           {Transition(electric, 4, magnetic, 6, 0.), State(0, positive)}})};
+  const HypothesisDiscriminator discriminator(hypotheses);
+  const size_t n_hypotheses = discriminator.get_n_hypotheses();
+  assert(n_hypotheses == 3);
+
+  // Maps on a grid of directions, compared to single evaluations.
+  const size_t n_theta = 19, n_phi = 24, n = n_theta * n_phi;
+  vector<double> theta(n), phi(n);
+  for (size_t i = 0; i < n_theta; ++i) {
+    for (size_t j = 0; j < n_phi; ++j) {
+      theta[i * n_phi + j] = i * M_PI / (n_theta - 1);
+      phi[i * n_phi + j] = j * 2. * M_PI / n_phi;
+    }
+  }
+  vector<double> ratio(n_hypotheses * n_hypotheses * n),
+      asymmetry_difference(n_hypotheses * n_hypotheses * n),
+      chi_squared(n_hypotheses * n_hypotheses * n);
+  discriminator.evaluate(n, theta.data(), phi.data(), nullptr,
+                         asymmetry_difference.data(), chi_squared.data());
+  discriminator.evaluate(n, theta.data(), phi.data(), ratio.data(), nullptr,
+                         nullptr);
+
+  for (size_t a = 0; a < n_hypotheses; ++a) {
+    for (size_t b = 0; b < n_hypotheses; ++b) {
+      for (size_t k = 0; k < n; ++k) {
+        const size_t index = (a * n_hypotheses + b) * n + k;
+        const double w_a = hypotheses[a](theta[k], phi[k]);
+        const double w_b = hypotheses[b](theta[k], phi[k]);
+        const double w_a_perpendicular =
+            hypotheses[a](theta[k], phi[k] + M_PI_2);
+        const double w_b_perpendicular =
+            hypotheses[b](theta[k], phi[k] + M_PI_2);
+
+        if (w_b > epsilon) {
+          test_numerical_equality<double>(ratio[index], w_a / w_b, epsilon);
+        }
+        if (w_a + w_a_perpendicular > epsilon &&
+            w_b + w_b_perpendicular > epsilon) {
+          test_numerical_equality<double>(
+              asymmetry_difference[index],
+              (w_a - w_a_perpendicular) / (w_a + w_a_perpendicular) -
+                  (w_b - w_b_perpendicular) / (w_b + w_b_perpendicular),
+              epsilon);
+        }
+        test_numerical_equality<double>(
+            chi_squared[index], 2. * (w_a - w_b) * (w_a - w_b) / (w_a + w_b),
+            epsilon);
+        test_numerical_equality<double>(
+            chi_squared[index], chi_squared[(b * n_hypotheses + a) * n + k],
+            epsilon);
+      }
+    }
+  }
+
+  // The analytic derivatives agree with finite differences.
+  const double h = 1e-6;
+  for (size_t a = 0; a < n_hypotheses; ++a) {
+    for (size_t b = 0; b < n_hypotheses; ++b) {
+      const array<double, 3> chi2 =
+          discriminator.chi_squared_with_gradient(a, b, 1.1, 0.4);
+      const double w_a = hypotheses[a](1.1, 0.4), w_b = hypotheses[b](1.1, 0.4);
+      test_numerical_equality<double>(
+          chi2[0], 2. * (w_a - w_b) * (w_a - w_b) / (w_a + w_b), epsilon);
+      test_numerical_equality<double>(
+          chi2[1],
+          (discriminator.chi_squared_with_gradient(a, b, 1.1 + h, 0.4)[0] -
+           discriminator.chi_squared_with_gradient(a, b, 1.1 - h, 0.4)[0]) /
+              (2. * h),
+          1e-6);
+      test_numerical_equality<double>(
+          chi2[2],
+          (discriminator.chi_squared_with_gradient(a, b, 1.1, 0.4 + h)[0] -
+           discriminator.chi_squared_with_gradient(a, b, 1.1, 0.4 - h)[0]) /
+              (2. * h),
+          1e-6);
+    }
+  }
+
+  // The 1+ and 1- hypotheses only differ by the sign of the term
+  // proportional to cos(2 phi), and the 1- hypothesis vanishes at theta =
+  // pi / 2 and phi = 0, where chi^2 assumes its maximum of 3.
+  const array<double, 3> refined_1 = discriminator.refine(0, 1, 1.3, 0.2);
+  test_numerical_equality<double>(refined_1[0], M_PI_2, 1e-6);
+  test_numerical_equality<double>(refined_1[1], 0., 1e-6);
+  test_numerical_equality<double>(refined_1[2], 3., 1e-10);
+
+  // Starting from the maximum of the map, the refinement finds at least the
+  // same value, and the gradient vanishes at the result.
+  for (size_t b = 1; b < n_hypotheses; ++b) {
+    size_t k_max = 0;
+    for (size_t k = 1; k < n; ++k) {
+      if (chi_squared[b * n + k] > chi_squared[b * n + k_max]) {
+        k_max = k;
+      }
+    }
+    const array<double, 3> refined =
+        discriminator.refine(0, b, theta[k_max], phi[k_max]);
+    assert(refined[2] >= chi_squared[b * n + k_max]);
+    assert(refined[0] >= 0. && refined[0] <= M_PI);
+    assert(refined[1] >= 0. && refined[1] < 2. * M_PI);
+    const array<double, 3> gradient = discriminator.chi_squared_with_gradient(
+        0, b, refined[0], refined[1]);
+    test_numerical_equality<double>(gradient[2], 0., 1e-6);
+    if (refined[0] > 1e-6 && refined[0] < M_PI - 1e-6) {
+      test_numerical_equality<double>(gradient[1], 0., 1e-6);
+    }
+  }
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    HypothesisDiscriminator({hypotheses[0]});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    discriminator.chi_squared_with_gradient(0, n_hypotheses, 1., 1.);
+  } catch (const out_of_range &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    discriminator.refine(n_hypotheses, 0, 1., 1.);
+  } catch (const out_of_range &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    discriminator.refine(0, 1, 1., 1., 100, 0.);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
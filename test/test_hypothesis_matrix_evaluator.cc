@@ -0,0 +1,149 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include "CascadeHypothesisScanner.hh"
+#include "HypothesisMatrixEvaluator.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+
+int main() {
+  const double epsilon = 1e-12;
+
+  // Hypotheses with pol-dir and dir-dir correlations, and with different
+  // orders of the Legendre expansion.
+  CascadeHypothesisScanner scanner(
+      {{State(0, positive)},
+       CascadeHypothesisScanner::spin_parity_candidates(2, 6),
+       CascadeHypothesisScanner::spin_parity_candidates(0, 8,
+                                                        {parity_unknown}),
+       {State(0, positive), State(4, positive)}});
+  scanner.scan(1);
+  const size_t n_hypotheses = scanner.get_n_hypotheses();
+  assert(n_hypotheses > 0);
+
+  const vector<double> theta{0.1, 0.8, 1.5708, 2.7, 0.4, 2.1, 3.0};
+  const vector<double> phi{0., 1.3, 0.785, 5., 3.3, 0.2, 1.};
+  const size_t n_directions = theta.size();
+
+  const HypothesisMatrixEvaluator evaluator(theta, phi, 8);
+  assert(evaluator.get_n_directions() == n_directions);
+  assert(evaluator.get_nu_max() == 8);
+  assert(evaluator.get_basis().size() == 9 * n_directions);
+
+  // The matrix product gives the same values as the evaluation of single
+  // hypotheses.
+  vector<double> result(n_hypotheses * n_directions);
+  evaluator.evaluate(scanner, result.data());
+  vector<double> expected(n_directions);
+  for (size_t k = 0; k < n_hypotheses; ++k) {
+    scanner.evaluate(k, n_directions, theta.data(), phi.data(),
+                     expected.data());
+    test_numerical_equality<double>(n_directions,
+                                    result.data() + k * n_directions,
+                                    expected.data(), epsilon);
+  }
+
+  // The rates of a scaled hypothesis are reproduced exactly by this
+  // hypothesis, and chi^2 of the others is larger.
+  const size_t k_true = n_hypotheses / 2;
+  vector<double> rates(n_directions), uncertainties(n_directions);
+  for (size_t m = 0; m < n_directions; ++m) {
+    rates[m] = 250. * result[k_true * n_directions + m];
+    uncertainties[m] = 1. + 0.1 * m;
+  }
+  vector<double> chi2(n_hypotheses), scale(n_hypotheses),
+      result_chi2(n_hypotheses * n_directions);
+  evaluator.chi_squared(scanner, rates.data(), uncertainties.data(),
+                        chi2.data(), scale.data(), result_chi2.data());
+  assert(result_chi2 == result);
+  test_numerical_equality<double>(scale[k_true], 250., 1e-10);
+  assert(chi2[k_true] < 1e-16 * rates[0] * rates[0]);
+
+  // Comparison to a direct calculation of chi^2.
+  for (size_t k = 0; k < n_hypotheses; ++k) {
+    double chi2_k = 0.;
+    for (size_t m = 0; m < n_directions; ++m) {
+      const double residual =
+          (rates[m] - scale[k] * result[k * n_directions + m]) /
+          uncertainties[m];
+      chi2_k += residual * residual;
+    }
+    test_numerical_equality<double>(chi2[k], chi2_k, epsilon * chi2_k);
+  }
+
+  // The scale factors are optional, and the values of W are not needed.
+  vector<double> chi2_only(n_hypotheses);
+  evaluator.chi_squared(scanner, rates.data(), uncertainties.data(),
+                        chi2_only.data(), nullptr);
+  assert(chi2_only == chi2);
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    HypothesisMatrixEvaluator(theta, {0.}, 4);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    HypothesisMatrixEvaluator(theta, phi, 3);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    HypothesisMatrixEvaluator(theta, phi, 0).evaluate(scanner, result.data());
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  uncertainties[0] = 0.;
+  try {
+    evaluator.chi_squared(scanner, rates.data(), uncertainties.data(),
+                          chi2.data(), nullptr);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  const CascadeHypothesisScanner not_scanned(
+      {{State(0, positive)}, {State(2, negative)}, {State(0, positive)}});
+  try {
+    evaluator.evaluate(not_scanned, result.data());
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -0,0 +1,242 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <cmath>
+
+#include <random>
+
+using std::mt19937_64;
+using std::uniform_real_distribution;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::runtime_error;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "AttenuatedAngularCorrelation.hh"
+#include "LegendreFitter.hh"
+#include "MixingRatioInverter.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Elastic 3/2+ -> 5/2+ -> 3/2+ cascade with the same mixing ratio for both
+ * transitions.
+ */
+AngularCorrelation create_angular_correlation(const double delta) {
+  return AngularCorrelation(
+      State(3, positive),
+      {{Transition(magnetic, 2, electric, 4, delta), State(5, positive)},
+       {Transition(magnetic, 2, electric, 4, delta), State(3, positive)}});
+}
+
+/**
+ * Normalized coefficients of an angular correlation in the order of
+ * LegendreFitResult.
+ */
+vector<double> normalized_coefficients(const AngularCorrelation &ang_cor) {
+  vector<double> coefficients = ang_cor.get_legendre_coefficients();
+  const vector<double> associated_legendre_coefficients =
+      ang_cor.get_associated_legendre_coefficients();
+  coefficients.insert(coefficients.end(),
+                      associated_legendre_coefficients.begin(),
+                      associated_legendre_coefficients.end());
+  const double c_0 = coefficients[0];
+  for (auto &c : coefficients) {
+    c /= c_0;
+  }
+  return coefficients;
+}
+
+int main() {
+  const double delta = 0.3;
+  const AngularCorrelation ang_cor = create_angular_correlation(delta);
+  assert(ang_cor.get_nu_max() == 4);
+  const vector<double> expected = normalized_coefficients(ang_cor);
+
+  // Counts without statistical fluctuations in detectors with a finite size
+  // reproduce the coefficients exactly.
+  const vector<double> attenuation{1., 0.95, 0.85};
+  const AttenuatedAngularCorrelation attenuated(ang_cor, attenuation);
+  LegendreFitter counts_fitter(4, true);
+  assert(counts_fitter.get_n_coefficients() == 5);
+  for (size_t i = 0; i < 6; ++i) {
+    for (size_t j = 0; j < 8; ++j) {
+      const double theta = 0.2 + 0.5 * i, phi = 0.25 * M_PI * j,
+                   efficiency = 0.5 + 0.1 * j;
+      counts_fitter.add_counts(theta, phi,
+                               1e6 * efficiency * attenuated(theta, phi),
+                               efficiency, attenuation);
+    }
+  }
+  assert(counts_fitter.get_n_entries() == 48);
+  const LegendreFitResult counts_result = counts_fitter.fit();
+  assert(counts_result.n_degrees_of_freedom == 43);
+  assert(counts_result.chi2 < 1e-4);
+  test_numerical_equality<double>(counts_result.amplitude,
+                                  1e6 * ang_cor.get_legendre_coefficients()[0],
+                                  1e-3);
+  for (size_t i = 0; i < 5; ++i) {
+    test_numerical_equality<double>(counts_result.coefficients[i],
+                                    expected[i], 1e-8);
+    assert(counts_result.covariance[i] == 0.);
+    assert(counts_result.covariance[i * 5 + i] >= 0.);
+  }
+
+  // The polynomials of the coefficients reproduce the angular correlation for
+  // a given mixing ratio.
+  const AngularCorrelation ang_cor_template = create_angular_correlation(0.);
+  const MixingRatioInverter inverter(ang_cor_template, {1., 1.});
+  const vector<vector<double>> polynomials =
+      inverter.coefficient_polynomials();
+  assert(polynomials.size() == 5);
+  vector<double> values(5);
+  for (size_t i = 0; i < 5; ++i) {
+    for (size_t k = polynomials[i].size(); k > 0; --k) {
+      values[i] = values[i] * delta + polynomials[i][k - 1];
+    }
+  }
+  for (size_t i = 0; i < 5; ++i) {
+    test_numerical_equality<double>(values[i] / values[0], expected[i],
+                                    1e-10);
+  }
+
+  // The best-matching mixing ratio reproduces the fitted coefficients. The
+  // value of x may be a different solution with the same coefficients.
+  const MixingRatioFitResult mixing_ratio_result =
+      counts_fitter.fit_mixing_ratio(inverter);
+  assert(mixing_ratio_result.chi2 < 1e-6);
+  const vector<double> best_match =
+      normalized_coefficients(create_angular_correlation(mixing_ratio_result.x));
+  for (size_t i = 0; i < 5; ++i) {
+    test_numerical_equality<double>(mixing_ratio_result.coefficients[i],
+                                    expected[i], 1e-6);
+    test_numerical_equality<double>(best_match[i], expected[i], 1e-6);
+  }
+
+  // Events from the angular correlation, with a uniform acceptance. The
+  // deviations from the exact coefficients are compatible with the
+  // uncertainties.
+  mt19937_64 random_engine(0);
+  uniform_real_distribution<double> uniform(0., 1.);
+  const double upper_limit = ang_cor.get_upper_limit();
+  LegendreFitter events_fitter(4, true);
+  vector<double> theta, phi;
+  while (theta.size() < 200000) {
+    const double theta_k = acos(2. * uniform(random_engine) - 1.),
+                 phi_k = 2. * M_PI * uniform(random_engine);
+    if (upper_limit * uniform(random_engine) < ang_cor(theta_k, phi_k)) {
+      theta.push_back(theta_k);
+      phi.push_back(phi_k);
+    }
+  }
+  events_fitter.add_events(theta.size() - 1, theta.data(), phi.data());
+  events_fitter.add_event(theta.back(), phi.back());
+  assert(events_fitter.get_n_entries() == theta.size());
+  const LegendreFitResult events_result = events_fitter.fit();
+  assert(events_result.coefficients[0] == 1.);
+  assert(events_result.amplitude == (double)theta.size());
+  for (size_t i = 1; i < 5; ++i) {
+    assert(fabs(events_result.coefficients[i] - expected[i]) <
+           5. * sqrt(events_result.covariance[i * 5 + i]));
+  }
+  // Uniform weights do not change the result.
+  LegendreFitter weighted_fitter(4, true);
+  const vector<double> weights(theta.size(), 2.);
+  weighted_fitter.add_events(theta.size(), theta.data(), phi.data(),
+                             weights.data());
+  const LegendreFitResult weighted_result = weighted_fitter.fit();
+  for (size_t i = 0; i < 25; ++i) {
+    test_numerical_equality<double>(weighted_result.covariance[i],
+                                    events_result.covariance[i], 1e-10);
+  }
+
+  // A fit of a dir-dir distribution to the same events only contains the
+  // coefficients c_i.
+  LegendreFitter unpolarized_fitter(4);
+  assert(!unpolarized_fitter.is_polarized());
+  unpolarized_fitter.add_events(theta.size(), theta.data(), phi.data());
+  const LegendreFitResult unpolarized_result = unpolarized_fitter.fit();
+  assert(unpolarized_result.coefficients.size() == 3);
+  for (size_t i = 0; i < 3; ++i) {
+    test_numerical_equality<double>(unpolarized_result.coefficients[i],
+                                    events_result.coefficients[i], 1e-12);
+  }
+
+  events_fitter.reset();
+  assert(events_fitter.get_n_entries() == 0);
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    events_fitter.fit();
+  } catch (const runtime_error &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    counts_fitter.add_event(0.1, 0.2);
+  } catch (const runtime_error &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    counts_fitter.add_counts(0.1, 0.2, 100., 1., {1., 0.9});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  // Two detectors cannot determine five coefficients.
+  LegendreFitter underdetermined_fitter(4, true);
+  underdetermined_fitter.add_counts(0.5 * M_PI, 0., 100.);
+  underdetermined_fitter.add_counts(0.5 * M_PI, 0.5 * M_PI, 120.);
+  error_thrown = false;
+  try {
+    underdetermined_fitter.fit();
+  } catch (const runtime_error &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    LegendreFitter(3);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
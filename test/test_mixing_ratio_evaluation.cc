@@ -0,0 +1,243 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Set the multipole mixing ratios of a cascade.
+ */
+vector<pair<Transition, State>>
+set_deltas(const vector<pair<Transition, State>> cascade_steps,
+           const vector<double> deltas) {
+  vector<pair<Transition, State>> new_cascade_steps;
+  for (size_t i = 0; i < cascade_steps.size(); ++i) {
+    const Transition t = cascade_steps[i].first;
+    new_cascade_steps.push_back(
+        {Transition(t.em_char, t.two_L, t.em_charp, t.two_Lp, deltas[i]),
+         cascade_steps[i].second});
+  }
+  return new_cascade_steps;
+}
+
+/**
+ * Compare the evaluation of an angular correlation for arbitrary mixing ratios
+ * to angular correlations that were constructed with these mixing ratios.
+ */
+void test_mixing_ratio_evaluation(
+    const State initial_state,
+    const vector<pair<Transition, State>> cascade_steps,
+    const vector<vector<double>> deltas) {
+
+  const double epsilon = 1e-10;
+  const AngularCorrelation ang_cor(initial_state, cascade_steps);
+  const double w_original = ang_cor(0.3, 0.4);
+
+  for (auto d : deltas) {
+    const AngularCorrelation ang_cor_delta(initial_state,
+                                           set_deltas(cascade_steps, d));
+    for (double theta = 0.; theta < M_PI; theta += 0.5) {
+      for (double phi = 0.; phi < M_2_PI; phi += 0.5) {
+        test_numerical_equality<double>(ang_cor(theta, phi, d),
+                                        ang_cor_delta(theta, phi), epsilon);
+      }
+    }
+  }
+
+  // Scan of the mixing ratios for many directions at once.
+  const size_t n_cascade_steps = cascade_steps.size();
+  const vector<double> theta{0., 0.3, 1.2, 0.5 * M_PI, 2.9};
+  const vector<double> phi{0., 2.1, 0.5 * M_PI, 0.7, 5.};
+  vector<double> deltas_flat;
+  for (auto d : deltas) {
+    deltas_flat.insert(deltas_flat.end(), d.begin(), d.end());
+  }
+  vector<double> result(deltas.size() * theta.size());
+  ang_cor.scan_deltas(deltas.size(), deltas_flat.data(), theta.size(),
+                      theta.data(), phi.data(), result.data());
+  for (size_t k = 0; k < deltas.size(); ++k) {
+    assert(deltas[k].size() == n_cascade_steps);
+    for (size_t i = 0; i < theta.size(); ++i) {
+      test_numerical_equality<double>(result[k * theta.size() + i],
+                                      ang_cor(theta[i], phi[i], deltas[k]),
+                                      epsilon);
+    }
+  }
+
+  // Analyzing power for pairs of directions, in both conventions, and for
+  // the scan of the mixing ratios.
+  const vector<double> thetap{0.2, 0.3, 1.2, 0.5 * M_PI, 2.5};
+  const vector<double> phip{0.5 * M_PI, 0.6, 0., 0.5 * M_PI, 1.};
+  const double PQ = 0.8;
+  vector<double> ana_pow(theta.size()), ana_pow_kpz(theta.size());
+  ang_cor.analyzing_power(theta.size(), theta.data(), thetap.data(),
+                          phi.data(), phip.data(), PQ, natural_convention,
+                          ana_pow.data());
+  ang_cor.analyzing_power(theta.size(), theta.data(), thetap.data(),
+                          phi.data(), phip.data(), PQ, kpz_convention,
+                          ana_pow_kpz.data());
+  for (size_t i = 0; i < theta.size(); ++i) {
+    const double w = ang_cor(theta[i], phi[i]),
+                 wp = ang_cor(thetap[i], phip[i]);
+    test_numerical_equality<double>(ana_pow[i], PQ * (w - wp) / (w + wp),
+                                    epsilon);
+    assert(ana_pow_kpz[i] == -ana_pow[i]);
+  }
+
+  vector<double> ana_pow_scan(deltas.size() * theta.size());
+  ang_cor.scan_analyzing_power(deltas.size(), deltas_flat.data(),
+                               theta.size(), theta.data(), thetap.data(),
+                               phi.data(), phip.data(), PQ, kpz_convention,
+                               ana_pow_scan.data());
+  for (size_t k = 0; k < deltas.size(); ++k) {
+    for (size_t i = 0; i < theta.size(); ++i) {
+      const double w = ang_cor(theta[i], phi[i], deltas[k]),
+                   wp = ang_cor(thetap[i], phip[i], deltas[k]);
+      test_numerical_equality<double>(ana_pow_scan[k * theta.size() + i],
+                                      -PQ * (w - wp) / (w + wp), epsilon);
+    }
+  }
+
+  // Changing the mixing ratios one step at a time gives the same angular
+  // correlation as a new object. The copy shares the W_gamma_gamma object
+  // with the original one until the first change.
+  AngularCorrelation ang_cor_set(ang_cor);
+  for (auto d : deltas) {
+    const AngularCorrelation ang_cor_delta(initial_state,
+                                           set_deltas(cascade_steps, d));
+    for (size_t i = 0; i < n_cascade_steps; ++i) {
+      ang_cor_set.set_delta(i, d[i]);
+      assert(ang_cor_set.get_cascade_steps()[i].first.delta == d[i]);
+    }
+    vector<double> legendre = ang_cor_set.get_legendre_coefficients();
+    vector<double> legendre_delta =
+        ang_cor_delta.get_legendre_coefficients();
+    assert(legendre.size() == legendre_delta.size());
+    test_numerical_equality<double>(legendre.size(), legendre.data(),
+                                    legendre_delta.data(), epsilon);
+    vector<double> associated_legendre =
+        ang_cor_set.get_associated_legendre_coefficients();
+    vector<double> associated_legendre_delta =
+        ang_cor_delta.get_associated_legendre_coefficients();
+    assert(associated_legendre.size() == associated_legendre_delta.size());
+    test_numerical_equality<double>(
+        associated_legendre.size(), associated_legendre.data(),
+        associated_legendre_delta.data(), epsilon);
+    for (size_t i = 0; i < theta.size(); ++i) {
+      test_numerical_equality<double>(ang_cor_set(theta[i], phi[i]),
+                                      ang_cor_delta(theta[i], phi[i]),
+                                      epsilon);
+    }
+  }
+
+  // The mixing ratios of the original object are unchanged.
+  assert(ang_cor(0.3, 0.4) == w_original);
+}
+
+int main() {
+
+  // Dir-dir correlation, both transitions mixed.
+  test_mixing_ratio_evaluation(
+      State(3, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.), State(5, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, 0.),
+        State(3, parity_unknown)}},
+      {{0., 0.}, {0.5, 0.}, {0., -1.5}, {-2., 3.}, {1e3, 0.1}});
+
+  // Pol-dir correlation, both transitions mixed.
+  test_mixing_ratio_evaluation(
+      State(3, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.), State(5, positive)},
+       {Transition(magnetic, 2, electric, 4, 0.), State(3, positive)}},
+      {{0., 0.}, {0.5, 0.}, {0., -1.5}, {-2., 3.}, {1e3, 0.1}});
+
+  // Pol-dir correlation with an unobserved intermediate transition.
+  const vector<pair<Transition, State>> cascade_steps_3{
+      {Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+      {Transition(electric, 2, magnetic, 4, 0.), State(4, positive)},
+      {Transition(magnetic, 2, electric, 4, 0.), State(4, positive)}};
+  test_mixing_ratio_evaluation(
+      State(0, positive), cascade_steps_3,
+      {{0., 0., 0.}, {0.1, 0., 0.}, {0., 0.7, 0.}, {0.2, -0.4, 5.}});
+
+  // Pol-dir correlation with two unobserved intermediate transitions. There
+  // is one polarization-dependent coefficient for each nonzero even order.
+  const vector<pair<Transition, State>> cascade_steps_4{
+      {Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+      {Transition(electric, 2, magnetic, 4, 0.), State(4, positive)},
+      {Transition(magnetic, 2, electric, 4, 0.), State(4, positive)},
+      {Transition(magnetic, 2, electric, 4, 0.), State(2, positive)}};
+  test_mixing_ratio_evaluation(State(0, positive), cascade_steps_4,
+                               {{0., 0., 0., 0.},
+                                {0.3, 0., 0., 0.},
+                                {0., -0.6, 0.4, 0.},
+                                {0.2, 1.1, -0.3, 2.}});
+  AngularCorrelation ang_cor_4(State(0, positive), cascade_steps_4);
+  ang_cor_4.set_delta(2, 0.5);
+  assert(ang_cor_4.get_associated_legendre_coefficients().size() ==
+         ang_cor_4.get_legendre_coefficients().size() - 1);
+
+  // The number of mixing ratios must match the number of cascade steps.
+  const AngularCorrelation ang_cor_3(State(0, positive), cascade_steps_3);
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    ang_cor_3(0., 0., {0., 0.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  const double theta = 0.5 * M_PI, phi = 0., phip = 0.5 * M_PI;
+  double ana_pow;
+  try {
+    ang_cor_3.analyzing_power(1, &theta, &theta, &phi, &phip, 1.1,
+                              natural_convention, &ana_pow);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AngularCorrelation(ang_cor_3).set_delta(3, 0.);
+  } catch (const out_of_range &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
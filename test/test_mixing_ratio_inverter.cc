@@ -0,0 +1,235 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "MixingRatioInverter.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+double evaluate_power_series(const vector<double> &p, const double x) {
+  double result = 0.;
+  for (size_t k = p.size(); k > 0; --k) {
+    result = result * x + p[k - 1];
+  }
+  return result;
+}
+
+bool inside_intervals(const vector<array<double, 2>> &intervals,
+                      const double x) {
+  for (auto interval : intervals) {
+    if (x >= interval[0] && x <= interval[1]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Compare the inversion of a function of the variable to a dense grid
+ * evaluation.
+ * Grid points whose function value is very close to the limits of the range
+ * are skipped, because their classification is sensitive to rounding errors.
+ * The finite limits of the intervals must be located exactly at the limits of
+ * the range.
+ */
+template <typename F>
+void compare_to_grid(F f, const vector<array<double, 2>> &arctan_intervals,
+                     const double lower, const double upper) {
+
+  for (size_t i = 1; i < arctan_intervals.size(); ++i) {
+    assert(arctan_intervals[i][0] > arctan_intervals[i - 1][1]);
+  }
+
+  for (auto interval : arctan_intervals) {
+    assert(interval[0] <= interval[1]);
+    for (auto limit : interval) {
+      if (fabs(limit) < M_PI_2) {
+        const double f_limit = f(tan(limit));
+        assert(fabs(f_limit - lower) < 1e-8 || fabs(f_limit - upper) < 1e-8);
+      }
+    }
+  }
+
+  const size_t n_grid = 100001;
+  for (size_t k = 1; k < n_grid - 1; ++k) {
+    const double arctan_x = -M_PI_2 + M_PI * k / (n_grid - 1.);
+    const double f_x = f(tan(arctan_x));
+    if (fabs(f_x - lower) < 1e-6 || fabs(f_x - upper) < 1e-6) {
+      continue;
+    }
+    assert(inside_intervals(arctan_intervals, arctan_x) ==
+           (f_x >= lower && f_x <= upper));
+  }
+}
+
+void test_analyzing_power(const MixingRatioInverter &inverter,
+                          const AngularCorrelation &ang_cor, const double theta,
+                          const double PQ, const double x_0,
+                          const double uncertainty) {
+  auto analyzing_power = [&](const double x) {
+    const vector<double> deltas = inverter.get_deltas(x);
+    const double w_para = ang_cor(theta, 0., deltas);
+    const double w_perp = ang_cor(theta, M_PI_2, deltas);
+    return PQ * (w_para - w_perp) / (w_para + w_perp);
+  };
+
+  const double value = analyzing_power(x_0);
+  const vector<array<double, 2>> arctan_intervals =
+      inverter.invert_analyzing_power(theta, theta, 0., M_PI_2, PQ, value,
+                                      uncertainty, true);
+  assert(inside_intervals(arctan_intervals, atan(x_0)));
+  compare_to_grid(analyzing_power, arctan_intervals, value - uncertainty,
+                  value + uncertainty);
+
+  // Same intervals in terms of the variable itself.
+  const vector<array<double, 2>> intervals = inverter.invert_analyzing_power(
+      theta, theta, 0., M_PI_2, PQ, value, uncertainty);
+  assert(intervals.size() == arctan_intervals.size());
+  for (size_t i = 0; i < intervals.size(); ++i) {
+    for (size_t j = 0; j < 2; ++j) {
+      test_numerical_equality<double>(atan(intervals[i][j]),
+                                      arctan_intervals[i][j], 1e-12);
+    }
+  }
+
+  // Without an uncertainty, only single values remain, one of which is x_0.
+  const vector<array<double, 2>> points = inverter.invert_analyzing_power(
+      theta, theta, 0., M_PI_2, PQ, value, 0.);
+  bool found_x_0 = false;
+  for (auto point : points) {
+    test_numerical_equality<double>(point[0], point[1], 1e-12);
+    test_numerical_equality<double>(analyzing_power(point[0]), value, 1e-8);
+    if (fabs(point[0] - x_0) < 1e-6) {
+      found_x_0 = true;
+    }
+  }
+  assert(found_x_0);
+}
+
+int main() {
+
+  // Elastic pol-dir cascade with the same mixing ratio for both steps.
+  const AngularCorrelation ang_cor_pol_dir(
+      State(3, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.), State(5, positive)},
+       {Transition(magnetic, 2, electric, 4, 0.), State(3, positive)}});
+  const MixingRatioInverter tied(ang_cor_pol_dir, {1., 1.});
+  assert(tied.get_n_variable_deltas() == 2);
+
+  // The unnormalized angular correlation is a quartic polynomial.
+  const vector<double> w_tilde = tied.polynomial(1.1, 0.4);
+  const vector<double> normalization = tied.normalization_polynomial();
+  assert(w_tilde.size() == 5);
+  assert(normalization.size() == 5);
+  for (double x = -3.; x < 3.; x += 0.37) {
+    test_numerical_equality<double>(
+        evaluate_power_series(w_tilde, x) /
+            evaluate_power_series(normalization, x),
+        ang_cor_pol_dir(1.1, 0.4, {x, x}), 1e-10);
+  }
+
+  test_analyzing_power(tied, ang_cor_pol_dir, 0.5 * M_PI, 1., 0.3, 0.05);
+  test_analyzing_power(tied, ang_cor_pol_dir, 0.5 * M_PI, -0.7, -2.5, 0.02);
+  test_analyzing_power(tied, ang_cor_pol_dir, 2.2, 1., 10., 0.1);
+
+  // Opposite signs of the mixing ratios, and a fixed mixing ratio.
+  test_analyzing_power(MixingRatioInverter(ang_cor_pol_dir, {-1., 1.}),
+                       ang_cor_pol_dir, 0.5 * M_PI, 1., 0.8, 0.05);
+  const MixingRatioInverter fixed(ang_cor_pol_dir, {0., 1.}, {0.4, 0.});
+  assert(fixed.get_n_variable_deltas() == 1);
+  test_analyzing_power(fixed, ang_cor_pol_dir, 0.5 * M_PI, 1., -0.2, 0.03);
+
+  // Inversion of a dir-dir angular correlation.
+  const AngularCorrelation ang_cor_dir_dir(
+      State(3, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.), State(5, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, 0.),
+        State(3, parity_unknown)}});
+  const MixingRatioInverter dir_dir(ang_cor_dir_dir, {0., 1.}, {-0.3, 0.});
+  const double w_0 = ang_cor_dir_dir(0.2, 0., {-0.3, 1.5});
+  const vector<array<double, 2>> arctan_intervals =
+      dir_dir.invert_angular_correlation(0.2, 0., w_0, 0.02, true);
+  assert(inside_intervals(arctan_intervals, atan(1.5)));
+  compare_to_grid(
+      [&](const double x) {
+        return ang_cor_dir_dir(0.2, 0., dir_dir.get_deltas(x));
+      },
+      arctan_intervals, w_0 - 0.02, w_0 + 0.02);
+
+  // Without any variable, the solution set is either empty or the entire
+  // real axis.
+  const MixingRatioInverter constant(ang_cor_dir_dir, {0., 0.}, {0.1, 0.2});
+  const double w_constant = ang_cor_dir_dir(0.2, 0., {0.1, 0.2});
+  const vector<array<double, 2>> everything =
+      constant.invert_angular_correlation(0.2, 0., w_constant, 0.01);
+  assert(everything.size() == 1);
+  assert(std::isinf(everything[0][0]) && everything[0][0] < 0.);
+  assert(std::isinf(everything[0][1]) && everything[0][1] > 0.);
+  assert(constant.invert_angular_correlation(0.2, 0., w_constant + 0.1, 0.01)
+             .empty());
+
+  // Invalid input
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    MixingRatioInverter(ang_cor_dir_dir, {1.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    MixingRatioInverter(ang_cor_dir_dir, {1., 1.}, {0.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    tied.invert_analyzing_power(0.5 * M_PI, 0.5 * M_PI, 0., M_PI_2, 1., 0.,
+                                -0.1);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -0,0 +1,238 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "MixingRatioPropagator.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Elastic 3/2+ -> 5/2+ -> 3/2+ cascade.
+ */
+const AngularCorrelation ang_cor(
+    State(3, positive),
+    {{Transition(magnetic, 2, electric, 4, 0.), State(5, positive)},
+     {Transition(magnetic, 2, electric, 4, 0.), State(3, positive)}});
+
+/**
+ * Alternative spin hypothesis 3/2+ -> 3/2+ -> 3/2+.
+ */
+const AngularCorrelation ang_cor_alternative(
+    State(3, positive),
+    {{Transition(magnetic, 2, electric, 4, 0.), State(3, positive)},
+     {Transition(magnetic, 2, electric, 4, 0.), State(3, positive)}});
+
+int main() {
+  const double epsilon = 1e-10;
+  const double delta = 0.3, sigma = 0.01;
+  const vector<double> theta{0.5 * M_PI, 0.5 * M_PI, 0.3 * M_PI};
+  const vector<double> phi{0., 0.5 * M_PI, 1.};
+
+  // Fixed mixing ratios reproduce the angular correlation, and all
+  // quantiles are equal to the mean.
+  MixingRatioPropagator fixed(ang_cor, {{fixed_delta, delta},
+                                        {proportional_delta, 1., 0., 0}});
+  const PropagationResult result_fixed =
+      fixed.angular_correlation(10, theta, phi);
+  assert(result_fixed.n_draws == 10);
+  assert(result_fixed.n_observables == theta.size());
+  assert(result_fixed.samples.size() == 10 * theta.size());
+  assert(result_fixed.quantiles.size() == 3 * theta.size());
+  for (size_t i = 0; i < theta.size(); ++i) {
+    const double w = ang_cor(theta[i], phi[i], {delta, delta});
+    test_numerical_equality<double>(result_fixed.mean[i], w, epsilon);
+    for (size_t q = 0; q < 3; ++q) {
+      test_numerical_equality<double>(
+          result_fixed.quantiles[q * theta.size() + i], w, epsilon);
+    }
+    for (size_t j = 0; j < theta.size(); ++j) {
+      test_numerical_equality<double>(
+          result_fixed.covariance[i * theta.size() + j], 0., epsilon);
+    }
+  }
+
+  // Proportional mixing ratios.
+  MixingRatioPropagator opposite(
+      ang_cor,
+      {{gaussian_delta, delta, sigma}, {proportional_delta, -1., 0., 0}});
+  const vector<double> deltas = opposite.draw_deltas(0, 10);
+  for (size_t k = 0; k < 10; ++k) {
+    assert(deltas[2 * k + 1] == -deltas[2 * k]);
+  }
+
+  // For a small uncertainty, the standard deviation is given by linear
+  // error propagation, and the median is close to the central value.
+  // The same seed reproduces the same draws.
+  const size_t n_draws = 20000;
+  MixingRatioPropagator gaussian(
+      ang_cor, {{gaussian_delta, delta, sigma}, {fixed_delta, delta}}, 1);
+  MixingRatioPropagator arctan(
+      ang_cor, {{gaussian_arctan_delta, delta, sigma}, {fixed_delta, delta}},
+      1);
+  const PropagationResult result_gaussian =
+      gaussian.angular_correlation(n_draws, theta, phi);
+  const PropagationResult result_arctan =
+      arctan.angular_correlation(n_draws, theta, phi);
+  gaussian.reseed(1);
+  const PropagationResult result_reseeded =
+      gaussian.angular_correlation(n_draws, theta, phi);
+  for (size_t k = 0; k < n_draws * theta.size(); ++k) {
+    assert(result_gaussian.samples[k] == result_reseeded.samples[k]);
+  }
+  for (size_t i = 0; i < theta.size(); ++i) {
+    const vector<double> gradient =
+        ang_cor.evaluate_with_gradient(theta[i], phi[i], {delta, delta});
+    test_numerical_equality<double>(result_gaussian.mean[i], gradient[0],
+                                    1e-3);
+    test_numerical_equality<double>(result_gaussian.quantiles[theta.size() + i],
+                                    gradient[0], 1e-3);
+    test_numerical_equality<double>(
+        sqrt(result_gaussian.covariance[i * theta.size() + i]) /
+            fabs(gradient[3] * sigma),
+        1., 3e-2);
+    // In arctan(delta), the standard deviation is larger by a factor of
+    // d delta / d arctan(delta) = 1 + delta^2.
+    test_numerical_equality<double>(
+        sqrt(result_arctan.covariance[i * theta.size() + i]) /
+            fabs(gradient[3] * sigma * (1. + delta * delta)),
+        1., 3e-2);
+    // Lower and upper quantiles of a normal distribution.
+    test_numerical_equality<double>(
+        (result_gaussian.quantiles[2 * theta.size() + i] -
+         result_gaussian.quantiles[i]) /
+            (2. * fabs(gradient[3] * sigma)),
+        1., 5e-2);
+  }
+
+  // Spin hypotheses with fixed mixing ratios only give two distinct values.
+  MixingRatioPropagator hypotheses(
+      {ang_cor, ang_cor_alternative},
+      {{{fixed_delta, delta}, {fixed_delta, delta}},
+       {{fixed_delta, delta}, {fixed_delta, delta}}},
+      {1., 3.}, 2);
+  assert(hypotheses.get_n_hypotheses() == 2);
+  const PropagationResult result_hypotheses =
+      hypotheses.angular_correlation(n_draws, {theta[2]}, {phi[2]});
+  const double w = ang_cor(theta[2], phi[2], {delta, delta});
+  const double w_alternative =
+      ang_cor_alternative(theta[2], phi[2], {delta, delta});
+  size_t n_alternative = 0;
+  for (size_t k = 0; k < n_draws; ++k) {
+    if (fabs(result_hypotheses.samples[k] - w_alternative) < epsilon) {
+      ++n_alternative;
+    } else {
+      test_numerical_equality<double>(result_hypotheses.samples[k], w,
+                                      epsilon);
+    }
+  }
+  test_numerical_equality<double>(static_cast<double>(n_alternative) / n_draws,
+                                  0.75, 2e-2);
+  test_numerical_equality<double>(
+      result_hypotheses.mean[0],
+      (static_cast<double>(n_draws - n_alternative) * w +
+       static_cast<double>(n_alternative) * w_alternative) /
+          n_draws,
+      epsilon);
+
+  // Analyzing power.
+  const double PQ = 0.9;
+  const PropagationResult result_analyzing_power =
+      fixed.analyzing_power(10, {0.5 * M_PI}, {0.5 * M_PI}, {0.}, {0.5 * M_PI},
+                            PQ);
+  const double w_parallel = ang_cor(0.5 * M_PI, 0., {delta, delta});
+  const double w_perpendicular =
+      ang_cor(0.5 * M_PI, 0.5 * M_PI, {delta, delta});
+  test_numerical_equality<double>(
+      result_analyzing_power.mean[0],
+      PQ * (w_parallel - w_perpendicular) / (w_parallel + w_perpendicular),
+      epsilon);
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    MixingRatioPropagator(ang_cor, {{fixed_delta, delta}});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    MixingRatioPropagator(ang_cor, {{proportional_delta, 1., 0., 1},
+                                    {fixed_delta, delta}});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    MixingRatioPropagator(ang_cor, {{gaussian_delta, delta, -1.},
+                                    {fixed_delta, delta}});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    MixingRatioPropagator({ang_cor, ang_cor_alternative},
+                          {{{fixed_delta, delta}, {fixed_delta, delta}}},
+                          {1., 1.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    fixed.angular_correlation(1, theta, phi);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    fixed.angular_correlation(10, theta, {0.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    fixed.angular_correlation(10, theta, phi, {1.5});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -0,0 +1,128 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+#include <cassert>
+
+#include <memory>
+
+using std::make_shared;
+using std::shared_ptr;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngCorrRejectionSampler.hh"
+#include "AngularCorrelation.hh"
+#include "CascadeSampler.hh"
+#include "ParallelCascadeSampler.hh"
+#include "SpotlightSampler.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+AngularCorrelation ang_cor_1(
+    State(0, positive),
+    {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+     {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+AngularCorrelation ang_cor_2(
+    State(4, positive),
+    {{Transition(electric, 4, magnetic, 6, 0.), State(0, positive)},
+     {Transition(electric, 4, magnetic, 6, 0.), State(4, positive)}});
+
+/**
+ * Create a cascade sampler with a beam-like first step and two angular
+ * correlations. The seeds are irrelevant, because the parallel sampler
+ * reseeds all random number engines.
+ */
+CascadeSampler create_cascade_sampler() {
+  return CascadeSampler(vector<shared_ptr<ReferenceFrameSampler>>{
+      make_shared<SpotlightSampler>(array<double, 2>{0.5, 0.2}, 0.1, 0),
+      make_shared<AngCorrRejectionSampler>(ang_cor_1, 0),
+      make_shared<AngCorrRejectionSampler>(ang_cor_2, 0)});
+}
+
+vector<double> sample(const unsigned int n_threads, const size_t chunk_size,
+                      const size_t n_events) {
+  ParallelCascadeSampler parallel_cascade_sampler(create_cascade_sampler, 42,
+                                                  n_threads, chunk_size);
+  assert(parallel_cascade_sampler.get_n_threads() == n_threads);
+  vector<double> Phi_Theta_Psi(3 * parallel_cascade_sampler.get_n_steps() *
+                               n_events);
+  parallel_cascade_sampler.sample(n_events, Phi_Theta_Psi.data());
+
+  return Phi_Theta_Psi;
+}
+
+int main() {
+
+  const size_t chunk_size = 100;
+  const size_t n_events = 10 * chunk_size + 37;
+
+  // The result does not depend on the number of threads.
+  const vector<double> Phi_Theta_Psi_1 = sample(1, chunk_size, n_events);
+  for (unsigned int n_threads : {2, 3, 8}) {
+    assert(sample(n_threads, chunk_size, n_events) == Phi_Theta_Psi_1);
+  }
+
+  // Each chunk is the same as the output of a single CascadeSampler that was
+  // seeded with the master seed and the index of the chunk.
+  CascadeSampler cascade_sampler = create_cascade_sampler();
+  vector<double> Phi_Theta_Psi_chunk(3 * 3 * chunk_size);
+  for (size_t c : {0, 3}) {
+    cascade_sampler.reseed(42, c);
+    cascade_sampler.sample(chunk_size, Phi_Theta_Psi_chunk.data());
+    for (size_t i = 0; i < 3 * 3; ++i) {
+      for (size_t k = 0; k < chunk_size; ++k) {
+        assert(Phi_Theta_Psi_chunk[i * chunk_size + k] ==
+               Phi_Theta_Psi_1[i * n_events + c * chunk_size + k]);
+      }
+    }
+  }
+
+  // Different chunks use independent random number streams.
+  assert(Phi_Theta_Psi_1[3 * n_events] !=
+         Phi_Theta_Psi_1[3 * n_events + chunk_size]);
+
+  // Consecutive calls continue with new streams.
+  ParallelCascadeSampler parallel_cascade_sampler(create_cascade_sampler, 42, 2,
+                                                  chunk_size);
+  vector<double> Phi_Theta_Psi_a(3 * 3 * chunk_size),
+      Phi_Theta_Psi_b(3 * 3 * chunk_size);
+  parallel_cascade_sampler.sample(chunk_size, Phi_Theta_Psi_a.data());
+  parallel_cascade_sampler.sample(chunk_size, Phi_Theta_Psi_b.data());
+  for (size_t i = 0; i < 3 * 3 * chunk_size; ++i) {
+    assert(Phi_Theta_Psi_a[i] == Phi_Theta_Psi_1[(i / chunk_size) * n_events +
+                                                 i % chunk_size]);
+    assert(Phi_Theta_Psi_b[i] ==
+           Phi_Theta_Psi_1[(i / chunk_size) * n_events + chunk_size +
+                           i % chunk_size]);
+  }
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    ParallelCascadeSampler(create_cascade_sampler, 42, 1, 0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
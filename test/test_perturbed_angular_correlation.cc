@@ -0,0 +1,183 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "PerturbedAngularCorrelation.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+int main() {
+  const double epsilon = 1e-12;
+
+  // Cosine series of the Legendre polynomials P_2 and P_4.
+  const vector<vector<double>> F =
+      PerturbedAngularCorrelation::fourier_coefficients(4);
+  assert(F.size() == 3);
+  for (double alpha = 0.; alpha < 3.2; alpha += 0.1) {
+    const double x = cos(alpha);
+    test_numerical_equality<double>(F[0][0], 1., epsilon);
+    test_numerical_equality<double>(F[1][0] + F[1][1] * cos(2. * alpha),
+                                    0.5 * (3. * x * x - 1.), epsilon);
+    test_numerical_equality<double>(
+        F[2][0] + F[2][1] * cos(2. * alpha) + F[2][2] * cos(4. * alpha),
+        0.125 * (35. * x * x * x * x - 30. * x * x + 3.), epsilon);
+  }
+
+  // 4+ -> 2+ -> 0+ cascade.
+  const AngularCorrelation ang_cor(
+      State(8), {{Transition(4, 6, 0.), State(4)},
+                 {Transition(4, 6, 0.), State(0)}});
+  const vector<double> c = ang_cor.get_legendre_coefficients();
+  assert(c.size() == 3);
+
+  // Without perturbations, the correlation does not depend on the time.
+  const PerturbedAngularCorrelation unperturbed(ang_cor);
+  for (double theta = 0.; theta < 3.2; theta += 0.2) {
+    test_numerical_equality<double>(unperturbed(theta, 0.),
+                                    ang_cor(theta, 0.), epsilon);
+    test_numerical_equality<double>(unperturbed(theta, 17.),
+                                    ang_cor(theta, 0.), epsilon);
+  }
+
+  // Static quadrupole interaction for I = 5/2. The amplitudes of G_22 are
+  // (7, 13, 10, 5) / 35 at the frequencies (0, 1, 2, 3) times 6 omega_Q
+  // [see, e.g., FrauenfelderSteffen1965].
+  const double omega_Q = 0.3;
+  const PerturbationFactor quadrupole_5_2 =
+      PerturbationFactor::static_quadrupole(5, omega_Q, 4);
+  assert(quadrupole_5_2.amplitudes.size() == 3);
+  assert(quadrupole_5_2.amplitudes[0].size() == 1);
+  assert(quadrupole_5_2.amplitudes[1].size() == 4);
+  const vector<double> s_2{7. / 35., 13. / 35., 10. / 35., 5. / 35.};
+  for (size_t n = 0; n < 4; ++n) {
+    test_numerical_equality<double>(quadrupole_5_2.amplitudes[1][n], s_2[n],
+                                    epsilon);
+    test_numerical_equality<double>(quadrupole_5_2.frequencies[1][n],
+                                    6. * n * omega_Q, epsilon);
+  }
+  test_numerical_equality<double>(quadrupole_5_2.amplitudes[2][0], 1. / 9.,
+                                  epsilon);
+  for (size_t i = 0; i < 3; ++i) {
+    test_numerical_equality<double>(quadrupole_5_2(i, 0.), 1., epsilon);
+  }
+  test_numerical_equality<double>(quadrupole_5_2(0, 5.), 1., epsilon);
+
+  // The order 6 does not couple to a spin of 1.
+  const PerturbationFactor quadrupole_1 =
+      PerturbationFactor::static_quadrupole(2, omega_Q, 4);
+  assert(quadrupole_1.amplitudes[2].empty());
+  test_numerical_equality<double>(quadrupole_1(2, 0.), 0., epsilon);
+
+  // Relaxation and a product of factors.
+  const vector<double> rates{0., 0.2, 0.5};
+  const PerturbedAngularCorrelation relaxed(
+      ang_cor,
+      {PerturbationFactor::static_quadrupole(4, omega_Q, 4),
+       PerturbationFactor::relaxation(rates)});
+  const PerturbationFactor quadrupole_2 =
+      PerturbationFactor::static_quadrupole(4, omega_Q, 4);
+  const double t = 2.3;
+  const vector<double> G = relaxed.get_perturbation_coefficients(t);
+  for (size_t i = 0; i < 3; ++i) {
+    test_numerical_equality<double>(G[i],
+                                    quadrupole_2(i, t) * exp(-rates[i] * t),
+                                    epsilon);
+  }
+  const double theta_0 = 1.1;
+  test_numerical_equality<double>(
+      relaxed(theta_0, t),
+      c[0] * G[0] +
+          c[1] * G[1] * 0.5 * (3. * cos(theta_0) * cos(theta_0) - 1.) +
+          c[2] * G[2] * 0.125 *
+              (35. * pow(cos(theta_0), 4) - 30. * pow(cos(theta_0), 2) + 3.),
+      epsilon);
+
+  // The Larmor precession rotates the unperturbed pattern.
+  const double omega_L = 0.7;
+  const PerturbedAngularCorrelation precession(ang_cor, {}, omega_L);
+  for (double theta = 0.; theta < 6.3; theta += 0.3) {
+    for (double time = 0.; time < 10.; time += 0.7) {
+      test_numerical_equality<double>(precession(theta, time),
+                                      ang_cor(theta - omega_L * time, 0.),
+                                      epsilon);
+    }
+  }
+
+  // The evaluation on a grid is the same as the evaluation of single points.
+  const PerturbedAngularCorrelation combined(
+      ang_cor,
+      {PerturbationFactor::static_quadrupole(4, omega_Q, 4),
+       PerturbationFactor::relaxation(rates)},
+      -omega_L);
+  const size_t n_times = 20000, n_angles = 4;
+  vector<double> times(n_times);
+  for (size_t l = 0; l < n_times; ++l) {
+    times[l] = 1e-3 * l;
+  }
+  vector<double> angles{0.5 * M_PI, 0.75 * M_PI, M_PI, 1.25 * M_PI};
+  vector<double> grid(n_times * n_angles);
+  combined.evaluate(n_times, times.data(), n_angles, angles.data(),
+                    grid.data());
+  for (size_t l = 0; l < n_times; l += 97) {
+    for (size_t k = 0; k < n_angles; ++k) {
+      test_numerical_equality<double>(grid[l * n_angles + k],
+                                      combined(angles[k], times[l]), epsilon);
+    }
+  }
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    PerturbedAngularCorrelation(vector<double>{});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    PerturbationFactor::relaxation({0., -1.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    PerturbedAngularCorrelation(AngularCorrelation(
+        State(0, positive),
+        {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+         {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}}));
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
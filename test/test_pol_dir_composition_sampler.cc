@@ -0,0 +1,129 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+#include <cassert>
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "EulerAngleRotation.hh"
+#include "PolDirCompositionSampler.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Test the composition sampler for pol-dir correlations.
+ *
+ * The conditional cumulative distribution function of the azimuthal angle is
+ * compared to the analytical expression, where the ratio r is obtained from
+ * the values of the angular correlation at phi = 0 and phi = pi/4.
+ * After that, the mean value of cos(2 phi) sin^2(theta), which is sensitive to
+ * the polarization-dependent part, is compared between sampled directions and
+ * a numerical integration over the sphere.
+ */
+void test_pol_dir_composition_sampler(const AngularCorrelation &ang_cor) {
+
+  PolDirCompositionSampler sampler(ang_cor, 0);
+
+  for (double x : {-0.9, -0.3, 0., 0.4, 0.8}) {
+    const double r =
+        ang_cor(acos(x), 0.) / ang_cor(acos(x), 0.25 * M_PI) - 1.;
+    for (double v : {0., 0.05, 0.3, 0.5, 0.9, 1.}) {
+      const double phi = sampler.inverse_conditional_cdf(x, v);
+      test_numerical_equality<double>(
+          0.5 * M_1_PI * (phi + 0.5 * r * sin(2. * phi)), v, 1e-12);
+    }
+  }
+
+  const unsigned int n_theta = 400, n_phi = 400;
+  double expectation = 0.;
+  for (unsigned int i = 0; i < n_theta; ++i) {
+    const double theta = M_PI * (i + 0.5) / n_theta;
+    for (unsigned int j = 0; j < n_phi; ++j) {
+      const double phi = 2. * M_PI * (j + 0.5) / n_phi;
+      expectation += ang_cor(theta, phi) * cos(2. * phi) * pow(sin(theta), 3);
+    }
+  }
+  expectation *= M_PI / n_theta * 2. * M_PI / n_phi / (4. * M_PI);
+
+  const unsigned int n_samples = 100000;
+  double mean = 0.;
+  for (unsigned int i = 0; i < n_samples; ++i) {
+    const pair<unsigned int, array<double, 3>> frame = sampler.sample();
+    assert(frame.first == 1);
+    const array<double, 2> theta_phi =
+        euler_angle_transform::to_spherical(frame.second);
+    mean += cos(2. * theta_phi[1]) * pow(sin(theta_phi[0]), 2);
+  }
+  mean /= n_samples;
+
+  // The standard deviation of the test function is smaller than 1.
+  test_numerical_equality<double>(mean, expectation, 5. / sqrt(n_samples));
+}
+
+int main() {
+
+  // 0+ -> 1+ -> 0+ and 0+ -> 1- -> 0+, which have the largest possible
+  // polarization effect.
+  test_pol_dir_composition_sampler(AngularCorrelation(
+      State(0, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.), State(2, positive)},
+       {Transition(magnetic, 2, electric, 4, 0.), State(0, positive)}}));
+  test_pol_dir_composition_sampler(AngularCorrelation(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}}));
+
+  // Mixed transitions
+  test_pol_dir_composition_sampler(AngularCorrelation(
+      State(3, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.5), State(5, positive)},
+       {Transition(magnetic, 2, electric, 4, -1.5), State(3, positive)}}));
+
+  // Partially polarized photons
+  for (double P : {0.4, -0.6}) {
+    AngularCorrelation partial(
+        State(3, positive),
+        {{Transition(magnetic, 2, electric, 4, 0.5), State(5, positive)},
+         {Transition(magnetic, 2, electric, 4, -1.5), State(3, positive)}});
+    partial.set_polarization_degree(P);
+    test_pol_dir_composition_sampler(partial);
+  }
+
+  // Dir-dir correlations are not supported.
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    PolDirCompositionSampler(
+        AngularCorrelation(State(0, parity_unknown),
+                           {{Transition(em_unknown, 2, em_unknown, 4, 0.),
+                             State(2, parity_unknown)},
+                            {Transition(em_unknown, 2, em_unknown, 4, 0.),
+                             State(0, parity_unknown)}}),
+        0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
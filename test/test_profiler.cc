@@ -0,0 +1,132 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <cstdint>
+
+using std::uint64_t;
+
+#include <sstream>
+
+using std::stringstream;
+
+#include <string>
+
+using std::string;
+
+#include <thread>
+
+using std::thread;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include "AngularCorrelation.hh"
+#include "Profiler.hh"
+#include "State.hh"
+#include "Transition.hh"
+#include "WignerSymbolCache.hh"
+
+void profiled_function() { ALPACA_PROFILE_SCOPE("test_profiler"); }
+
+int main() {
+
+  // Counters can be used directly, independent of the build option.
+  profiler::Counter &c = profiler::counter("test_counter");
+  assert(&profiler::counter("test_counter") == &c);
+  assert(c.calls == 0);
+  {
+    profiler::ScopedTimer timer(c);
+  }
+  {
+    profiler::ScopedTimer timer(c);
+  }
+  assert(c.calls == 2);
+
+  // Concurrent timers in several threads.
+  vector<thread> threads;
+  for (size_t i = 0; i < 4; ++i) {
+    threads.push_back(thread([&c]() {
+      for (size_t j = 0; j < 1000; ++j) {
+        profiler::ScopedTimer timer(c);
+      }
+    }));
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  assert(c.calls == 4002);
+
+  stringstream text, json;
+  profiler::report_text(text);
+  profiler::report_json(json);
+  assert(text.str().find("test_counter") != string::npos);
+  assert(json.str().find("\"test_counter\": {\"calls\": 4002") != string::npos);
+
+  profiler::reset();
+  assert(c.calls == 0);
+  assert(c.nanoseconds == 0);
+
+  // The hooks in the library are only active with ALPACA_ENABLE_PROFILING.
+  WignerSymbolCache::clear();
+  profiled_function();
+  const AngularCorrelation ang_cor(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+  ang_cor.get_upper_limit();
+
+#ifdef ALPACA_ENABLE_PROFILING
+  assert(profiler::counter("test_profiler").calls == 1);
+  assert(profiler::counter("wigner_recursion::coupling_3j").calls > 0);
+  assert(profiler::counter("wigner_recursion::coupling_6j").calls > 0);
+  assert(profiler::counter("FCoefficient::FCoefficient").calls > 0);
+  assert(profiler::counter("W_pol_dir::get_upper_limit").calls == 1);
+
+  // For pure transitions, only the F coefficients with L are calculated on
+  // construction. The ones with L' follow when they are needed.
+  const vector<pair<Transition, State>> cascade_steps{
+      {Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+      {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}};
+  profiler::Counter &f_counter =
+      profiler::counter("FCoefficient::FCoefficient");
+  profiler::reset();
+  AngularCorrelation pure(State(0, positive), cascade_steps);
+  const uint64_t n_f_pure = f_counter.calls;
+  pure.set_delta(0, 0.1);
+  assert(f_counter.calls > n_f_pure);
+
+  profiler::reset();
+  const AngularCorrelation mixed(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.1), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+  assert(f_counter.calls > n_f_pure);
+#else
+  stringstream text_disabled;
+  profiler::report_text(text_disabled);
+  assert(text_disabled.str().find("test_profiler") == string::npos);
+#endif
+}
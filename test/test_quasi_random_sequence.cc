@@ -0,0 +1,157 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <cstdint>
+
+using std::uint32_t;
+
+#include <random>
+
+using std::seed_seq;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include "QuasiRandomSequence.hh"
+#include "TestUtilities.hh"
+
+/**
+ * Check that the first 2^m points of two dimensions form a (t, m, 2)-net,
+ * i.e. that each elementary interval with the area 2^(t - m) contains exactly
+ * 2^t points.
+ */
+void test_net(const vector<double> &u, const unsigned int n_dimensions,
+              const unsigned int d_1, const unsigned int d_2,
+              const unsigned int m, const unsigned int t) {
+  const size_t n = 1U << m;
+  for (unsigned int k = 0; k <= m - t; ++k) {
+    const unsigned int l = m - t - k;
+    vector<size_t> counts(1U << (m - t), 0);
+    for (size_t i = 0; i < n; ++i) {
+      const size_t x =
+          static_cast<size_t>(u[i * n_dimensions + d_1] * (1U << k));
+      const size_t y =
+          static_cast<size_t>(u[i * n_dimensions + d_2] * (1U << l));
+      ++counts[(x << l) | y];
+    }
+    for (auto c : counts) {
+      assert(c == (1U << t));
+    }
+  }
+}
+
+int main() {
+  const unsigned int m = 10;
+  const size_t n = 1U << m;
+  const unsigned int n_dimensions = ScrambledSobolSequence::max_dimensions;
+
+  ScrambledSobolSequence sequence(n_dimensions, 1);
+  assert(sequence.get_n_dimensions() == n_dimensions);
+  vector<double> u(n * n_dimensions);
+  sequence.generate(n, u.data());
+  assert(sequence.get_index() == n);
+
+  // All coordinates are in [0, 1), and each of the first 2^m points is in
+  // a different interval of length 2^-m in each dimension.
+  for (unsigned int d = 0; d < n_dimensions; ++d) {
+    vector<size_t> counts(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+      assert(u[i * n_dimensions + d] >= 0. && u[i * n_dimensions + d] < 1.);
+      ++counts[static_cast<size_t>(u[i * n_dimensions + d] * n)];
+    }
+    for (auto c : counts) {
+      assert(c == 1);
+    }
+  }
+
+  // The first two dimensions form a (0, m, 2)-net, which is preserved by
+  // the scrambling.
+  test_net(u, n_dimensions, 0, 1, m, 0);
+
+  // Jumping to an index gives the same points as the stream.
+  vector<double> point(n_dimensions);
+  sequence.set_index(37);
+  sequence(point.data());
+  for (unsigned int d = 0; d < n_dimensions; ++d) {
+    assert(point[d] == u[37 * n_dimensions + d]);
+  }
+
+  // Reseeding restarts the sequence, and different seeds give different
+  // scramblings.
+  sequence.seed(1);
+  sequence(point.data());
+  assert(point[0] == u[0]);
+  sequence.seed(2);
+  sequence(point.data());
+  assert(point[0] != u[0]);
+
+  seed_seq seq_1{3, 4}, seq_2{3, 4};
+  ScrambledSobolSequence sequence_1(2), sequence_2(2, 5);
+  sequence_1.seed(seq_1);
+  sequence_2.seed(seq_2);
+  for (size_t i = 0; i < 10; ++i) {
+    double u_1[2], u_2[2];
+    sequence_1(u_1);
+    sequence_2(u_2);
+    assert(u_1[0] == u_2[0] && u_1[1] == u_2[1]);
+  }
+
+  // The permutation of each bit only depends on the more significant bits,
+  // so two numbers that differ only in the least significant bit are mapped
+  // to numbers that differ only in the least significant bit.
+  const uint32_t x = 0x12345678U, y = 0x12345679U;
+  assert((ScrambledSobolSequence::owen_scramble(x, 9) ^
+          ScrambledSobolSequence::owen_scramble(y, 9)) == 1U);
+
+  // The mean value of a smooth function converges faster than for
+  // pseudo-random numbers. The integral of x_0 x_1 x_2 x_3 over the unit
+  // hypercube is 1/16.
+  ScrambledSobolSequence sequence_4(4, 6);
+  double sum = 0.;
+  const size_t n_integral = 1U << 14;
+  for (size_t i = 0; i < n_integral; ++i) {
+    double v[4];
+    sequence_4(v);
+    sum += v[0] * v[1] * v[2] * v[3];
+  }
+  test_numerical_equality<double>(sum / n_integral, 1. / 16., 1e-5);
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    ScrambledSobolSequence(0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    ScrambledSobolSequence(ScrambledSobolSequence::max_dimensions + 1);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -0,0 +1,112 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cstdint>
+
+using std::uint64_t;
+
+#include <random>
+
+using std::mt19937;
+using std::seed_seq;
+using std::uniform_real_distribution;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "RandomEngine.hh"
+#include "TestUtilities.hh"
+#include "TypedSphereRejectionSampler.hh"
+
+int main() {
+
+  // Reference values of xoshiro256++ for the initial state (1, 2, 3, 4).
+  Xoshiro256PlusPlus xoshiro(array<uint64_t, 4>{1, 2, 3, 4});
+  const array<uint64_t, 5> reference{41943041ULL, 58720359ULL,
+                                     3588806011781223ULL, 3591011842654386ULL,
+                                     9228616714210784205ULL};
+  for (auto r : reference) {
+    assert(xoshiro() == r);
+  }
+
+  // Equal seeds give equal sequences, different seeds different ones.
+  Xoshiro256PlusPlus xoshiro_1(42), xoshiro_2(42), xoshiro_3(43);
+  for (size_t i = 0; i < 10; ++i) {
+    const uint64_t r = xoshiro_1();
+    assert(xoshiro_2() == r);
+    assert(xoshiro_3() != r);
+  }
+
+  seed_seq seq_1{1, 2, 3}, seq_2{1, 2, 3};
+  xoshiro_1.seed(seq_1);
+  xoshiro_2.seed(seq_2);
+  assert(xoshiro_1() == xoshiro_2());
+
+  // The generic fill_uniform() is identical to consecutive calls of
+  // std::uniform_real_distribution.
+  const size_t n = 100000;
+  vector<double> u(n);
+  mt19937 mt_1(0), mt_2(0);
+  uniform_real_distribution<double> uniform_random;
+  fill_uniform(mt_1, u.data(), n);
+  for (size_t i = 0; i < n; ++i) {
+    assert(u[i] == uniform_random(mt_2));
+  }
+
+  // Uniform random numbers from xoshiro256++ are in [0, 1) with the expected
+  // mean and variance.
+  fill_uniform(xoshiro, u.data(), n);
+  double sum = 0., sum_of_squares = 0.;
+  for (size_t i = 0; i < n; ++i) {
+    assert(u[i] >= 0. && u[i] < 1.);
+    sum += u[i];
+    sum_of_squares += u[i] * u[i];
+  }
+  test_numerical_equality<double>(sum / n, 0.5, 5e-3);
+  test_numerical_equality<double>(sum_of_squares / n - (sum / n) * (sum / n),
+                                  1. / 12., 2e-3);
+
+  // Rejection sampling with xoshiro256++, see also
+  // test_sphere_rejection_sampler.
+  auto distribution = []([[maybe_unused]] const double theta,
+                         const double phi) { return phi < M_PI ? 1. : 0.; };
+  TypedSphereRejectionSampler<decltype(distribution), Xoshiro256PlusPlus>
+      sampler(distribution, 1., 0);
+  test_numerical_equality<double>(sampler.estimate_efficiency(100000), 0.5,
+                                  5e-3);
+
+  // Reseeding makes the sequence reproducible.
+  TypedSphereRejectionSampler<decltype(distribution), Xoshiro256PlusPlus>
+      sampler_2(distribution, 1., 1);
+  seed_seq seq_3{4, 5, 6}, seq_4{4, 5, 6};
+  sampler.reseed(seq_3);
+  sampler_2.reseed(seq_4);
+  for (size_t i = 0; i < 10; ++i) {
+    assert(sampler() == sampler_2());
+  }
+}
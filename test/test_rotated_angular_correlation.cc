@@ -0,0 +1,214 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "EulerAngleRotation.hh"
+#include "RotatedAngularCorrelation.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Compare the expansion of a rotated angular correlation in the laboratory
+ * frame to the rotation of each direction.
+ */
+void test_rotated_angular_correlation(const AngularCorrelation &ang_cor,
+                                      const array<double, 3> Phi_Theta_Psi) {
+  const RotatedAngularCorrelation rotated(ang_cor, Phi_Theta_Psi);
+  assert(rotated.get_nu_max() == ang_cor.get_nu_max());
+  assert(rotated.get_Phi_Theta_Psi() == Phi_Theta_Psi);
+
+  const double epsilon = 1e-12 * ang_cor.get_upper_limit();
+
+  const size_t n = 150;
+  vector<double> theta(n), phi(n), xyz(3 * n), result(n), result_rotated(n),
+      result_rotated_xyz(n);
+  for (size_t i = 0; i < n; ++i) {
+    theta[i] = M_PI * i / (n - 1.);
+    phi[i] = 2. * M_PI * ((13 * i) % n) / n;
+    xyz[3 * i] = sin(theta[i]) * cos(phi[i]);
+    xyz[3 * i + 1] = sin(theta[i]) * sin(phi[i]);
+    xyz[3 * i + 2] = cos(theta[i]);
+  }
+  ang_cor.evaluate(n, theta.data(), phi.data(), Phi_Theta_Psi, result.data());
+  rotated.evaluate(n, theta.data(), phi.data(), result_rotated.data());
+  rotated.evaluate(n, xyz.data(), result_rotated_xyz.data());
+  for (size_t i = 0; i < n; ++i) {
+    test_numerical_equality<double>(result_rotated[i], result[i], epsilon);
+    test_numerical_equality<double>(result_rotated_xyz[i], result[i],
+                                    epsilon);
+    test_numerical_equality<double>(rotated(theta[i], phi[i]), result[i],
+                                    epsilon);
+    test_numerical_equality<double>(
+        rotated.evaluate({xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2]}),
+        result[i], epsilon);
+  }
+
+  // On a grid of polar and azimuthal angles, the separated evaluation agrees
+  // with the evaluation of each direction.
+  const size_t n_theta = 37, n_phi = 23, n_grid = n_theta * n_phi;
+  vector<double> theta_axis(n_theta), phi_axis(n_phi), theta_grid(n_grid),
+      phi_grid(n_grid), result_grid(n_grid), result_unrotated(n_grid),
+      result_grid_rotated(n_grid), result_grid_expansion(n_grid),
+      result_grid_unrotated(n_grid);
+  for (size_t i = 0; i < n_theta; ++i) {
+    theta_axis[i] = M_PI * i / (n_theta - 1.);
+  }
+  for (size_t j = 0; j < n_phi; ++j) {
+    phi_axis[j] = 2. * M_PI * j / (n_phi - 1.) - 0.5;
+  }
+  for (size_t i = 0; i < n_theta; ++i) {
+    for (size_t j = 0; j < n_phi; ++j) {
+      theta_grid[i * n_phi + j] = theta_axis[i];
+      phi_grid[i * n_phi + j] = phi_axis[j];
+    }
+  }
+  ang_cor.evaluate(n_grid, theta_grid.data(), phi_grid.data(), Phi_Theta_Psi,
+                   result_grid.data());
+  ang_cor.evaluate(n_grid, theta_grid.data(), phi_grid.data(),
+                   result_unrotated.data());
+  ang_cor.evaluate_grid(n_theta, theta_axis.data(), n_phi, phi_axis.data(),
+                        Phi_Theta_Psi, result_grid_rotated.data());
+  rotated.evaluate_grid(n_theta, theta_axis.data(), n_phi, phi_axis.data(),
+                        result_grid_expansion.data());
+  ang_cor.evaluate_grid(n_theta, theta_axis.data(), n_phi, phi_axis.data(),
+                        result_grid_unrotated.data());
+  for (size_t k = 0; k < n_grid; ++k) {
+    test_numerical_equality<double>(result_grid_rotated[k], result_grid[k],
+                                    epsilon);
+    test_numerical_equality<double>(result_grid_expansion[k], result_grid[k],
+                                    epsilon);
+    test_numerical_equality<double>(result_grid_unrotated[k],
+                                    result_unrotated[k], epsilon);
+  }
+
+  // The rotation does not mix different orders, and it preserves the norm of
+  // the coefficients of each order.
+  const RotatedAngularCorrelation unrotated(ang_cor, {0., 0., 0.});
+  for (int l = 0; l <= ang_cor.get_nu_max() + 1; ++l) {
+    double norm = 0., norm_unrotated = 0.;
+    for (int m = -l; m <= l; ++m) {
+      norm += rotated.get_coefficient(l, m) * rotated.get_coefficient(l, m);
+      norm_unrotated += unrotated.get_coefficient(l, m) *
+                        unrotated.get_coefficient(l, m);
+      if (m != 0 && m != 2) {
+        test_numerical_equality<double>(unrotated.get_coefficient(l, m), 0.,
+                                        1e-14);
+      }
+    }
+    if (l % 2 == 1 || l > ang_cor.get_nu_max()) {
+      assert(norm == 0.);
+    }
+    test_numerical_equality<double>(norm, norm_unrotated, 1e-12);
+  }
+}
+
+int main() {
+
+  // The Wigner D-matrices are orthogonal, and the identity for a vanishing
+  // rotation.
+  const int l_max = 12;
+  const vector<vector<double>> D = RotatedAngularCorrelation::wigner_D_matrices(
+      l_max, euler_angle_transform::rotation_matrix({0.3, 2.1, -1.2}));
+  const vector<vector<double>> D_identity =
+      RotatedAngularCorrelation::wigner_D_matrices(
+          l_max, euler_angle_transform::rotation_matrix({0., 0., 0.}));
+  assert(D.size() == l_max + 1);
+  for (int l = 0; l <= l_max; ++l) {
+    const int n_m = 2 * l + 1;
+    assert(D[l].size() == (size_t)(n_m * n_m));
+    for (int i = 0; i < n_m; ++i) {
+      for (int j = 0; j < n_m; ++j) {
+        double product = 0.;
+        for (int k = 0; k < n_m; ++k) {
+          product += D[l][i * n_m + k] * D[l][j * n_m + k];
+        }
+        test_numerical_equality<double>(product, i == j ? 1. : 0., 1e-12);
+        test_numerical_equality<double>(D_identity[l][i * n_m + j],
+                                        i == j ? 1. : 0., 1e-14);
+      }
+    }
+  }
+
+  // Dir-dir correlation
+  test_rotated_angular_correlation(
+      AngularCorrelation(State(3, parity_unknown),
+                         {{Transition(em_unknown, 2, em_unknown, 4, 0.3),
+                           State(5, parity_unknown)},
+                          {Transition(em_unknown, 2, em_unknown, 4, -0.7),
+                           State(3, parity_unknown)}}),
+      {0.3, 2.1, -1.2});
+
+  // Pol-dir correlations with both possible EM characters
+  const AngularCorrelation pol_dir(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+  test_rotated_angular_correlation(pol_dir, {0., 0., 0.});
+  test_rotated_angular_correlation(pol_dir, {0.5 * M_PI, 0.5 * M_PI, 0.});
+  test_rotated_angular_correlation(pol_dir, {-0.7, 0.4, 5.3});
+  test_rotated_angular_correlation(
+      AngularCorrelation(
+          State(4, positive),
+          {{Transition(magnetic, 2, electric, 4, 0.5), State(6, positive)},
+           {Transition(magnetic, 2, electric, 4, 2.), State(4, positive)}}),
+      {1.1, 2.9, 0.2});
+
+  // Higher multipolarities
+  test_rotated_angular_correlation(
+      AngularCorrelation(
+          State(0, positive),
+          {{Transition(electric, 6, magnetic, 8, 0.), State(6, negative)},
+           {Transition(electric, 6, magnetic, 8, 0.), State(0, positive)}}),
+      {2.2, 1.3, 0.9});
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    RotatedAngularCorrelation({1., 0.5}, {0.1, 0.2}, {0., 0., 0.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    RotatedAngularCorrelation({1.}, {}, {0., 0., 0.}).get_coefficient(1, 2);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
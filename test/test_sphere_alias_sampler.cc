@@ -0,0 +1,190 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <memory>
+
+using std::make_shared;
+using std::shared_ptr;
+
+#include <random>
+
+using std::seed_seq;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::out_of_range;
+
+#include <utility>
+
+using std::pair;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AliasTable.hh"
+#include "AngularCorrelation.hh"
+#include "CascadeSampler.hh"
+#include "DeterministicReferenceFrameSampler.hh"
+#include "EulerAngleRotation.hh"
+#include "SphereAliasSampler.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+int main() {
+  const double epsilon = 1e-10;
+
+  // Alias table: the probability of an index is the sum of the thresholds of
+  // its own column and of the complements of the columns that point to it.
+  // This is tested by scanning the unit interval with a fine grid.
+  const vector<double> weights{0., 1., 3., 0.5, 2.5};
+  AliasTable alias_table(weights);
+  assert(alias_table.size() == weights.size());
+  const size_t n_u = 1000000;
+  vector<size_t> counts(weights.size(), 0);
+  for (size_t k = 0; k < n_u; ++k) {
+    ++counts[alias_table((k + 0.5) / n_u)];
+  }
+  for (size_t i = 0; i < weights.size(); ++i) {
+    test_numerical_equality<double>(alias_table.get_probability(i),
+                                    weights[i] / 7., epsilon);
+    test_numerical_equality<double>(static_cast<double>(counts[i]) / n_u,
+                                    weights[i] / 7., 1e-5);
+  }
+  assert(alias_table(0.999999999999) < weights.size());
+
+  // Pol-dir correlation 0+ -> 1- -> 0+.
+  const AngularCorrelation ang_cor(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}});
+  const vector<double> c = ang_cor.get_legendre_coefficients(),
+                       d = ang_cor.get_associated_legendre_coefficients();
+
+  SphereAliasSampler sampler(ang_cor, 100, 100, 0);
+  assert(sampler.get_n_cos_theta() == 100);
+  assert(sampler.get_n_phi() == 100);
+  test_numerical_equality<double>(
+      sampler.get_cell_probability(50, 0) / sampler.get_cell_probability(0, 0),
+      ang_cor(acos(0.01), M_PI / 100.) /
+          ang_cor(acos(-1. + 0.01), M_PI / 100.),
+      epsilon);
+
+  // For a normalized distribution, the expectation values of
+  // P_2[cos(theta)] and cos(2 phi) are c_1 / (5 c_0) and d_0 / c_0.
+  const size_t n = 200000;
+  double p_2 = 0., cos_2_phi = 0.;
+  for (size_t i = 0; i < n; ++i) {
+    const pair<unsigned int, array<double, 3>> n_tries_and_frame =
+        sampler.sample();
+    assert(n_tries_and_frame.first == 1);
+    const array<double, 2> theta_phi =
+        euler_angle_transform::to_spherical(n_tries_and_frame.second);
+    const double cos_theta = cos(theta_phi[0]);
+    p_2 += 0.5 * (3. * cos_theta * cos_theta - 1.);
+    cos_2_phi += cos(2. * theta_phi[1]);
+  }
+  test_numerical_equality<double>(p_2 / n, c[1] / (5. * c[0]), 5e-3);
+  test_numerical_equality<double>(cos_2_phi / n, d[0] / c[0], 5e-3);
+
+  // The rotation matrices use the same random numbers as the Euler angles.
+  seed_seq seq_1{1, 2}, seq_2{1, 2};
+  sampler.reseed(seq_1);
+  SphereAliasSampler sampler_reseeded(ang_cor, 100, 100, 3);
+  sampler_reseeded.reseed(seq_2);
+  for (size_t i = 0; i < 100; ++i) {
+    array<double, 3> direction = euler_angle_transform::direction(
+        euler_angle_transform::rotation_matrix(sampler.sample().second));
+    array<double, 3> direction_reseeded =
+        euler_angle_transform::direction(
+            sampler_reseeded.sample_rotation_matrix().second);
+    test_numerical_equality<double>(3, direction.data(),
+                                    direction_reseeded.data(), epsilon);
+  }
+
+  // The sampler can be used in a cascade.
+  CascadeSampler cascade_sampler(vector<shared_ptr<ReferenceFrameSampler>>{
+      make_shared<DeterministicReferenceFrameSampler>(
+          array<double, 3>{0., 0., 0.}),
+      make_shared<SphereAliasSampler>(ang_cor, 50, 50, 4)});
+  assert(cascade_sampler().size() == 2);
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    AliasTable({});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AliasTable({1., -1.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    AliasTable({0., 0.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    SphereAliasSampler([](const double, const double) { return 1.; }, 0, 10,
+                       0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    SphereAliasSampler(
+        [](const double theta, const double) { return cos(theta); }, 10, 10,
+        0);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    sampler.get_cell_probability(100, 0);
+  } catch (const out_of_range &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -17,13 +17,63 @@
     Copyright (C) 2021-2023 Udo Friman-Gayer
 */
 
+#include <algorithm>
+
+using std::equal;
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <cstdio>
+
+#include <filesystem>
+
+using std::filesystem::file_size;
+using std::filesystem::resize_file;
+
+#include <fstream>
+
+using std::ofstream;
+
+#include <memory>
+
+using std::shared_ptr;
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <string>
+
+using std::string;
+
+#include <thread>
+
+using std::thread;
+
+#include <vector>
+
+using std::vector;
+
 #include <gsl/gsl_math.h>
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include "SphereIntegrator.hh"
+#include "SpherePointCache.hh"
+#include "SphereRegion.hh"
 #include "TestUtilities.hh"
 
 int main() {
 
+  SpherePointCache::clear();
+
   SphereIntegrator sph_int;
 
   double integral_num = sph_int(
@@ -34,4 +84,232 @@ int main() {
       [](double theta, [[maybe_unused]] double phi) { return theta > M_PI_2; });
 
   test_numerical_equality<double>(integral_num, 2. * M_PI, 1e-3);
-}
\ No newline at end of file
+
+  // The point set was calculated once and is reused by later integrations.
+  assert(SpherePointCache::size() == 1);
+  assert(SpherePointCache::get_misses() == 1);
+  assert(SpherePointCache::get_hits() == 0);
+
+  // Several integrands at once. Integrals of cos^2(theta) and sin^2(theta)
+  // over the lower hemisphere are 2 pi / 3 and 4 pi / 3.
+  const vector<double> integrals = sph_int(
+      {[]([[maybe_unused]] const double theta,
+          [[maybe_unused]] const double phi) { return 1.; },
+       [](const double theta, [[maybe_unused]] const double phi) {
+         return cos(theta) * cos(theta);
+       },
+       [](const double theta, [[maybe_unused]] const double phi) {
+         return sin(theta) * sin(theta);
+       }},
+      100000,
+      [](const double theta, [[maybe_unused]] const double phi) {
+        return theta > M_PI_2;
+      });
+  assert(integrals.size() == 3);
+  assert(integrals[0] == integral_num);
+  test_numerical_equality<double>(integrals[1], 2. * M_PI / 3., 1e-3);
+  test_numerical_equality<double>(integrals[2], 4. * M_PI / 3., 1e-3);
+  assert(SpherePointCache::get_misses() == 1);
+  assert(SpherePointCache::get_hits() == 1);
+
+  // Batched integrands give the same result.
+  const vector<double> integrals_batch = sph_int.integrate_batch(
+      {[](const size_t m, const double *theta, [[maybe_unused]] const double *,
+          double *result) {
+         for (size_t i = 0; i < m; ++i) {
+           result[i] = cos(theta[i]) * cos(theta[i]);
+         }
+       }},
+      100000,
+      [](const double theta, [[maybe_unused]] const double phi) {
+        return theta > M_PI_2;
+      });
+  test_numerical_equality<double>(integrals_batch[0], integrals[1], 1e-10);
+
+  // Randomized quasi-Monte Carlo integration. For the smooth integrand
+  // cos^2(theta) on the full sphere (4 pi / 3), the error is much smaller than
+  // for the same number of pseudo-random points, and it is covered by the
+  // estimated uncertainty. The discontinuity at the boundary of the lower
+  // hemisphere reduces the accuracy.
+  const SphereIntegrator::BatchIntegrand cos_squared =
+      [](const size_t m, const double *theta, [[maybe_unused]] const double *,
+         double *result) {
+        for (size_t i = 0; i < m; ++i) {
+          result[i] = cos(theta[i]) * cos(theta[i]);
+        }
+      };
+  const vector<IntegralEstimate> estimates = sph_int.integrate_qmc(
+      {cos_squared}, 1U << 14,
+      []([[maybe_unused]] const double theta,
+         [[maybe_unused]] const double phi) { return true; });
+  assert(estimates.size() == 1);
+  assert(estimates[0].uncertainty > 0.);
+  assert(estimates[0].uncertainty < 1e-5);
+  test_numerical_equality<double>(estimates[0].value, 4. * M_PI / 3.,
+                                  5. * estimates[0].uncertainty);
+
+  const vector<IntegralEstimate> estimates_hemisphere = sph_int.integrate_qmc(
+      {cos_squared}, 1U << 14,
+      [](const double theta, [[maybe_unused]] const double phi) {
+        return theta > M_PI_2;
+      },
+      16, 1);
+  test_numerical_equality<double>(estimates_hemisphere[0].value,
+                                  2. * M_PI / 3.,
+                                  5. * estimates_hemisphere[0].uncertainty);
+  assert(estimates_hemisphere[0].uncertainty < 1e-3);
+
+  [[maybe_unused]] bool error_thrown_qmc = false;
+  try {
+    sph_int.integrate_qmc(
+        {cos_squared}, 1000,
+        []([[maybe_unused]] const double theta,
+           [[maybe_unused]] const double phi) { return true; },
+        1);
+  } catch (const invalid_argument &e) {
+    error_thrown_qmc = true;
+  }
+  assert(error_thrown_qmc);
+
+  // Integration over a small cone with points inside the cone only. The
+  // integral of cos^2 of the angle gamma to the axis is
+  // 2 pi (1 - cos^3(alpha)) / 3. Selecting the points from the entire sphere
+  // is much less accurate for the same number of points.
+  const array<double, 2> axis{1., 2.};
+  const double opening_angle = 0.1;
+  const auto cos_gamma = [&axis](const double theta, const double phi) {
+    return cos(theta) * cos(axis[0]) +
+           sin(theta) * sin(axis[0]) * cos(phi - axis[1]);
+  };
+  const double integral_cone_exact =
+      2. * M_PI * (1. - pow(cos(opening_angle), 3)) / 3.;
+  const SphereRegion cone(axis, opening_angle);
+  const double integral_cone = sph_int(
+      [&cos_gamma](const double theta, const double phi) {
+        return cos_gamma(theta, phi) * cos_gamma(theta, phi);
+      },
+      1000, cone);
+  test_numerical_equality<double>(integral_cone, integral_cone_exact, 1e-6);
+  const double integral_cone_selected = sph_int(
+      [&cos_gamma](const double theta, const double phi) {
+        return cos_gamma(theta, phi) * cos_gamma(theta, phi);
+      },
+      1000, [&cos_gamma, opening_angle](const double theta, const double phi) {
+        return cos_gamma(theta, phi) >= cos(opening_angle);
+      });
+  assert(fabs(integral_cone_selected - integral_cone_exact) >
+         fabs(integral_cone - integral_cone_exact));
+
+  // The overloads for several functions and for batched integrands give the
+  // same result.
+  const SphereRegion lower_hemisphere({M_PI_2, M_PI}, {0., 2. * M_PI});
+  const vector<double> integrals_region = sph_int(
+      {[]([[maybe_unused]] const double theta,
+          [[maybe_unused]] const double phi) { return 1.; },
+       [](const double theta, [[maybe_unused]] const double phi) {
+         return cos(theta) * cos(theta);
+       }},
+      1000, lower_hemisphere);
+  test_numerical_equality<double>(integrals_region[0], 2. * M_PI, 1e-10);
+  test_numerical_equality<double>(integrals_region[1], 2. * M_PI / 3., 1e-5);
+  const vector<double> integrals_region_batch =
+      sph_int.integrate_batch({cos_squared}, 1000, lower_hemisphere);
+  test_numerical_equality<double>(integrals_region_batch[0],
+                                  integrals_region[1], 1e-10);
+
+  // Round trip of the cache through a file.
+  const shared_ptr<const array<vector<double>, 2>> point_set =
+      SpherePointCache::get(1000);
+  const char *file_name = "test_sphere_integrator_cache.bin";
+  SpherePointCache::save(file_name);
+  SpherePointCache::clear();
+  SpherePointCache::load(file_name);
+  assert(SpherePointCache::size() == 2);
+  assert(*SpherePointCache::get(1000) == *point_set);
+  assert(SpherePointCache::get_misses() == 0);
+
+  // Invalid files are rejected and leave the cache unchanged.
+  ofstream invalid_file(file_name);
+  invalid_file << "not a cache";
+  invalid_file.close();
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    SpherePointCache::load(file_name);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+  assert(SpherePointCache::size() == 2);
+  remove(file_name);
+
+  // An attached file is read in place, and the integrals do not change.
+  SpherePointCache::save(file_name);
+  SpherePointCache::clear();
+  SpherePointCache::attach(file_name);
+  assert(SpherePointCache::get_n_attached() == 2);
+  const SpherePointCache::PointSetView view = SpherePointCache::get_view(1000);
+  assert(view.n == 1000);
+  assert(equal(view.theta, view.theta + 1000, (*point_set)[0].begin()));
+  assert(equal(view.phi, view.phi + 1000, (*point_set)[1].begin()));
+  assert(sph_int.integrate_batch(
+             {cos_squared}, 100000,
+             [](const double theta, [[maybe_unused]] const double phi) {
+               return theta > M_PI_2;
+             })[0] == integrals_batch[0]);
+  assert(SpherePointCache::size() == 0);
+  assert(SpherePointCache::get_misses() == 0);
+  assert(SpherePointCache::get_hits() == 2);
+
+  // The view stays valid when the file is detached and removed.
+  SpherePointCache::detach();
+  remove(file_name);
+  assert(SpherePointCache::get_n_attached() == 0);
+  assert(equal(view.theta, view.theta + 1000, (*point_set)[0].begin()));
+
+  // Truncated files are rejected.
+  SpherePointCache::get(1000);
+  SpherePointCache::save(file_name);
+  resize_file(file_name, file_size(file_name) - sizeof(double));
+  error_thrown = false;
+  try {
+    SpherePointCache::attach(file_name);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+  assert(SpherePointCache::get_n_attached() == 0);
+  remove(file_name);
+
+  // A missing file is created only once, even if several threads attach it
+  // at the same time, and another process attaches it without a calculation.
+  const string shared_file_name = "test_sphere_integrator_shared.bin";
+  remove(shared_file_name.c_str());
+  SpherePointCache::clear();
+  vector<thread> threads;
+  for (size_t i = 0; i < 4; ++i) {
+    threads.emplace_back(
+        [&]() { SpherePointCache::attach(shared_file_name, {500}); });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  assert(SpherePointCache::get_misses() == 1);
+  assert(SpherePointCache::get_n_attached() == 1);
+
+  const pid_t pid = fork();
+  if (pid == 0) {
+    SpherePointCache::clear();
+    SpherePointCache::attach(shared_file_name, {500});
+    SpherePointCache::get_view(500);
+    _exit(SpherePointCache::get_misses() == 0 &&
+                  SpherePointCache::get_hits() == 1
+              ? 0
+              : 1);
+  }
+  int child_status;
+  waitpid(pid, &child_status, 0);
+  assert(WIFEXITED(child_status) && WEXITSTATUS(child_status) == 0);
+  SpherePointCache::clear();
+  remove(shared_file_name.c_str());
+  remove((shared_file_name + ".lock").c_str());
+}
@@ -37,6 +37,30 @@ int main() {
                                     radius_squared, 1e-5);
   }
 
+  // The warm-started iteration in sample() gives the same points as
+  // find_Theta_j() with the initial guess of Koay, also with several threads.
+  const unsigned int n_spiral = 1000;
+  const double c = sph_poi_sam.find_c(n_spiral);
+  const array<vector<double>, 2> theta_phi = sph_poi_sam.sample(n_spiral);
+  const array<vector<double>, 2> theta_phi_parallel =
+      sph_poi_sam.sample(n_spiral, 4);
+  for (unsigned int j = 1; j <= n_spiral; ++j) {
+    const double Theta_j = sph_poi_sam.find_Theta_j(j, n_spiral, c);
+    test_numerical_equality<double>(theta_phi[0][j - 1], Theta_j, 1e-6);
+    test_numerical_equality<double>(theta_phi[1][j - 1], c * Theta_j, 1e-4);
+    test_numerical_equality<double>(theta_phi_parallel[0][j - 1], Theta_j,
+                                    1e-6);
+  }
+
+  // With the approximate precision of the elliptic integrals, the points
+  // agree within the convergence criterion.
+  const array<vector<double>, 2> theta_phi_approximate =
+      SpherePointSampler(approximate_precision).sample(n_spiral);
+  for (unsigned int j = 0; j < n_spiral; ++j) {
+    test_numerical_equality<double>(theta_phi_approximate[0][j],
+                                    theta_phi[0][j], 1e-6);
+  }
+
   // Test various error messages that should be displayed when the numerical
   // fixed-point searches fail.
   bool error_thrown = false;
@@ -0,0 +1,131 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "SphereQuadrature.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+
+/**
+ * Exact integral of the monomial x^a y^b z^c over the unit sphere.
+ */
+double integral_monomial(const unsigned int a, const unsigned int b,
+                         const unsigned int c) {
+  if (a % 2 || b % 2 || c % 2) {
+    return 0.;
+  }
+  return 2. * tgamma(0.5 * (a + 1)) * tgamma(0.5 * (b + 1)) *
+         tgamma(0.5 * (c + 1)) / tgamma(0.5 * (a + b + c + 3));
+}
+
+/**
+ * Check that a rule integrates all monomials up to its degree exactly.
+ */
+void test_exactness(const SphereQuadrature &quadrature) {
+  const unsigned int degree = quadrature.get_degree();
+  for (unsigned int a = 0; a <= degree; ++a) {
+    for (unsigned int b = 0; a + b <= degree; ++b) {
+      for (unsigned int c = 0; a + b + c <= degree; ++c) {
+        test_numerical_equality<double>(
+            quadrature([a, b, c](const double theta, const double phi) {
+              return pow(sin(theta) * cos(phi), a) *
+                     pow(sin(theta) * sin(phi), b) * pow(cos(theta), c);
+            }),
+            integral_monomial(a, b, c), 1e-12);
+      }
+    }
+  }
+}
+
+int main() {
+
+  // Lebedev rules
+  const unsigned int n_points_lebedev[7] = {6, 14, 26, 38, 50, 74, 86};
+  for (unsigned int i = 0; i < 7; ++i) {
+    const SphereQuadrature quadrature(2 * i + 3);
+    assert(quadrature.get_degree() == 2 * i + 3);
+    assert(quadrature.get_n_points() == n_points_lebedev[i]);
+    test_exactness(quadrature);
+  }
+
+  // The smallest rule of at least the requested degree is selected.
+  assert(SphereQuadrature(0).get_degree() == 3);
+  assert(SphereQuadrature(4).get_degree() == 5);
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    SphereQuadrature(SphereQuadrature::max_lebedev_degree + 1);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  // Gauss-Legendre-trapezoid rules
+  for (unsigned int degree = 0; degree <= 20; ++degree) {
+    const SphereQuadrature quadrature(degree, gauss_legendre_trapezoid);
+    assert(quadrature.get_degree() >= degree);
+    assert(quadrature.get_n_points() == (degree / 2 + 1) * (degree + 1));
+    test_exactness(quadrature);
+  }
+
+  // Angular correlations are integrated exactly by the rule for their maximum
+  // order of the Legendre expansion.
+  const AngularCorrelation ang_cor_dir_dir(
+      State(3, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.3),
+        State(5, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, -0.7),
+        State(3, parity_unknown)}});
+  const AngularCorrelation ang_cor_pol_dir(
+      State(0, positive),
+      {{Transition(magnetic, 6, electric, 8, 0.), State(6, positive)},
+       {Transition(magnetic, 6, electric, 8, 0.), State(0, positive)}});
+
+  for (auto ang_cor : {ang_cor_dir_dir, ang_cor_pol_dir}) {
+    for (auto rule : {lebedev, gauss_legendre_trapezoid}) {
+      const SphereQuadrature quadrature(ang_cor, rule);
+      assert(quadrature.get_degree() >= (unsigned int)ang_cor.get_nu_max());
+      test_numerical_equality<double>(quadrature(ang_cor), 4. * M_PI, 1e-12);
+    }
+  }
+
+  // Integral of (x^2 - y^2) W = sin^2(theta) cos(2 phi) W over the sphere,
+  // which is nonzero only for the pol-dir correlation. Since x^2 - y^2 has
+  // degree 2, the rules for nu_max + 2 integrate it exactly.
+  const unsigned int degree = ang_cor_pol_dir.get_nu_max() + 2;
+  auto x2_y2_w = [&ang_cor_pol_dir](const double theta, const double phi) {
+    return pow(sin(theta), 2) * cos(2. * phi) * ang_cor_pol_dir(theta, phi);
+  };
+  const double integral_x2_y2_w = SphereQuadrature(degree)(x2_y2_w);
+  assert(fabs(integral_x2_y2_w) > 0.1);
+  test_numerical_equality<double>(
+      integral_x2_y2_w,
+      SphereQuadrature(degree, gauss_legendre_trapezoid)(x2_y2_w), 1e-12);
+}
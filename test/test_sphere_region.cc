@@ -0,0 +1,138 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <cmath>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "SphereRegion.hh"
+#include "TestUtilities.hh"
+
+/**
+ * \brief Check that all points are inside the region, and return the sum of
+ * the weights.
+ */
+double check_points(const SphereRegion &region, const unsigned int n) {
+  vector<double> theta, phi, weight;
+  region.sample(n, theta, phi, weight);
+  assert(theta.size() == phi.size() && theta.size() == weight.size());
+
+  double solid_angle = 0.;
+  for (size_t i = 0; i < theta.size(); ++i) {
+    assert(theta[i] >= 0. && theta[i] <= M_PI);
+    assert(phi[i] >= 0. && phi[i] < 2. * M_PI);
+    assert(region.contains(theta[i], phi[i]));
+    solid_angle += weight[i];
+  }
+
+  return solid_angle;
+}
+
+int main() {
+  const double epsilon = 1e-10;
+  const unsigned int n = 10000;
+
+  // Cone around a direction that is not the z axis.
+  const array<double, 2> axis{1., 2.};
+  const double opening_angle = 0.1;
+  const SphereRegion cone(axis, opening_angle);
+  assert(cone.get_n_parts() == 1);
+  test_numerical_equality<double>(cone.get_solid_angle_of_parts(),
+                                  2. * M_PI * (1. - cos(opening_angle)),
+                                  epsilon);
+  test_numerical_equality<double>(check_points(cone, n),
+                                  cone.get_solid_angle_of_parts(), epsilon);
+  assert(cone.contains(axis[0], axis[1]));
+  assert(cone.contains(axis[0] + 0.99 * opening_angle, axis[1]));
+  assert(!cone.contains(axis[0] + 1.01 * opening_angle, axis[1]));
+  assert(!cone.contains(M_PI - axis[0], axis[1] + M_PI));
+
+  // Box with an azimuthal range that crosses phi = 0.
+  const SphereRegion box({0.5, 1.5}, {-M_PI_4, M_PI_4});
+  test_numerical_equality<double>(box.get_solid_angle_of_parts(),
+                                  M_PI_2 * (cos(0.5) - cos(1.5)), epsilon);
+  test_numerical_equality<double>(check_points(box, n),
+                                  box.get_solid_angle_of_parts(), epsilon);
+  assert(box.contains(1., 2. * M_PI - 0.1));
+  assert(box.contains(1., 0.1));
+  assert(!box.contains(1., M_PI));
+  assert(!box.contains(0.4, 0.));
+
+  // Union of overlapping boxes, whose solid angle is the one of the cap
+  // theta <= 3 pi / 4. The overlap is not counted twice.
+  const SphereRegion overlapping(vector<SphereRegion>{
+      SphereRegion({0., M_PI_2}, {0., 2. * M_PI}),
+      SphereRegion({M_PI_4, 3. * M_PI_4}, {0., 2. * M_PI})});
+  assert(overlapping.get_n_parts() == 2);
+  test_numerical_equality<double>(check_points(overlapping, n),
+                                  2. * M_PI * (1. + M_SQRT1_2), 1e-3);
+
+  // Union of disjoint regions.
+  const SphereRegion disjoint(vector<SphereRegion>{cone, box});
+  test_numerical_equality<double>(check_points(disjoint, n),
+                                  cone.get_solid_angle_of_parts() +
+                                      box.get_solid_angle_of_parts(),
+                                  epsilon);
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    SphereRegion(axis, 0.);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    SphereRegion({1., 0.5}, {0., 1.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    SphereRegion({0.5, 1.}, {0., 7.});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    SphereRegion(vector<SphereRegion>{});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -23,9 +23,19 @@ using std::array;
 
 #include <cassert>
 
+#include <random>
+
+using std::mt19937;
+using std::uniform_real_distribution;
+
+#include <vector>
+
+using std::vector;
+
 #include <gsl/gsl_math.h>
 
 #include "EulerAngleRotation.hh"
+#include "QuasiRandomSequence.hh"
 #include "SphereRejectionSampler.hh"
 #include "TestUtilities.hh"
 
@@ -69,4 +79,130 @@ int main() {
   assert(theta_phi_default.second[0] == 0.);
   assert(theta_phi_default.second[1] == 0.);
   assert(theta_phi_default.second[2] == 0.);
-}
\ No newline at end of file
+
+  // The candidates are generated in blocks, with four uniform random numbers
+  // per candidate. For a constant distribution, every candidate is accepted.
+  SphereRejectionSampler sph_rej_sam_4(
+      []([[maybe_unused]] const double theta,
+         [[maybe_unused]] const double phi) { return 1.; },
+      1., 0);
+  mt19937 random_engine(0);
+  uniform_real_distribution<double> uniform_random;
+  for (size_t i = 0; i < SphereRejectionSampler::candidate_block_size + 10;
+       ++i) {
+    const double cos_theta = 2. * uniform_random(random_engine) - 1.;
+    const double phi = 2. * M_PI * uniform_random(random_engine);
+    uniform_random(random_engine);
+    const double Phi = 2. * M_PI * uniform_random(random_engine);
+    array<double, 3> Phi_Theta_Psi =
+        euler_angle_transform::from_spherical({acos(cos_theta), phi}, Phi);
+    pair<unsigned int, array<double, 3>> sample = sph_rej_sam_4.sample();
+    assert(sample.first == 1);
+    test_numerical_equality<double>(3, sample.second.data(),
+                                    Phi_Theta_Psi.data(), 1e-12);
+  }
+
+  // Quasi-random candidates are the points of a four-dimensional scrambled
+  // Sobol sequence.
+  sph_rej_sam_4.enable_quasi_random(1);
+  assert(sph_rej_sam_4.quasi_random_enabled());
+  ScrambledSobolSequence sobol(4, 1);
+  for (size_t i = 0; i < SphereRejectionSampler::candidate_block_size + 10;
+       ++i) {
+    double u[4];
+    sobol(u);
+    array<double, 3> Phi_Theta_Psi = euler_angle_transform::from_spherical(
+        {acos(2. * u[0] - 1.), 2. * M_PI * u[1]}, 2. * M_PI * u[3]);
+    pair<unsigned int, array<double, 3>> sample = sph_rej_sam_4.sample();
+    assert(sample.first == 1);
+    test_numerical_equality<double>(3, sample.second.data(),
+                                    Phi_Theta_Psi.data(), 1e-12);
+  }
+
+  // In the weighted mode, the mean value of the weights converges to the
+  // efficiency faster than with pseudo-random candidates.
+  SphereRejectionSampler sph_rej_sam_weighted(
+      [](const double theta, [[maybe_unused]] const double phi) {
+        return cos(theta) * cos(theta);
+      },
+      1., 0);
+  sph_rej_sam_weighted.enable_quasi_random();
+  const size_t n_weighted = 1U << 14;
+  double sum_of_weights = 0.;
+  for (size_t i = 0; i < n_weighted; ++i) {
+    sum_of_weights += sph_rej_sam_weighted.sample_weighted().first;
+  }
+  test_numerical_equality<double>(sum_of_weights / n_weighted, 1. / 3., 1e-5);
+
+  sph_rej_sam_weighted.disable_quasi_random();
+  assert(!sph_rej_sam_weighted.quasi_random_enabled());
+
+  // The block mode gives the same result as consecutive calls of sample(),
+  // also across the boundaries of the blocks of candidates.
+  SphereRejectionSampler sph_rej_sam_single(
+      []([[maybe_unused]] const double theta, const double phi) {
+        return phi < M_PI ? 1. : 0.;
+      },
+      1., 0);
+  SphereRejectionSampler sph_rej_sam_block(
+      []([[maybe_unused]] const double theta, const double phi) {
+        return phi < M_PI ? 1. : 0.;
+      },
+      1., 0);
+  const size_t n = 3 * SphereRejectionSampler::candidate_block_size + 3;
+  vector<double> Phi(n), Theta(n), Psi(n);
+  sph_rej_sam_block(n, Phi.data(), Theta.data(), Psi.data());
+  for (size_t i = 0; i < n; ++i) {
+    const array<double, 3> Phi_Theta_Psi = sph_rej_sam_single();
+    assert(Phi[i] == Phi_Theta_Psi[0]);
+    assert(Theta[i] == Phi_Theta_Psi[1]);
+    assert(Psi[i] == Phi_Theta_Psi[2]);
+  }
+
+  // The statistics are only collected if they are enabled.
+  assert(!sph_rej_sam_block.statistics_enabled());
+  assert(sph_rej_sam_block.get_statistics().n_samples == 0);
+
+  sph_rej_sam_block.enable_statistics();
+  const size_t n_statistics = 100000;
+  Phi.resize(n_statistics);
+  Theta.resize(n_statistics);
+  Psi.resize(n_statistics);
+  sph_rej_sam_block(n_statistics, Phi.data(), Theta.data(), Psi.data());
+  sph_rej_sam_block.sample();
+  const SamplingStatistics statistics = sph_rej_sam_block.get_statistics();
+  assert(statistics.n_samples == n_statistics + 1);
+  assert(statistics.n_accepted == n_statistics + 1);
+  assert(statistics.n_failures == 0);
+  test_numerical_equality<double>(statistics.get_acceptance(), 0.5, 1e-2);
+
+  // For an acceptance of 1/2, half of the reference frames are accepted at
+  // the first try, and a quarter after two or three tries.
+  size_t n_histogram = 0;
+  for (auto n_bin : statistics.tries_histogram) {
+    n_histogram += n_bin;
+  }
+  assert(n_histogram == statistics.n_accepted);
+  test_numerical_equality<double>(
+      (double)statistics.tries_histogram[0] / statistics.n_accepted, 0.5, 1e-2);
+  test_numerical_equality<double>(
+      (double)statistics.tries_histogram[1] / statistics.n_accepted, 0.375,
+      1e-2);
+
+  sph_rej_sam_block.reset_statistics();
+  assert(sph_rej_sam_block.get_statistics().n_tries == 0);
+
+  // Failures are counted separately, with the maximum number of tries.
+  sph_rej_sam_3.enable_statistics();
+  sph_rej_sam_3.sample();
+  sph_rej_sam_3.sample();
+  assert(sph_rej_sam_3.get_statistics().n_samples == 2);
+  assert(sph_rej_sam_3.get_statistics().n_accepted == 0);
+  assert(sph_rej_sam_3.get_statistics().n_failures == 2);
+  assert(sph_rej_sam_3.get_statistics().n_tries == 2000);
+  assert(sph_rej_sam_3.get_statistics().get_acceptance() == 0.);
+
+  sph_rej_sam_3.enable_statistics(false);
+  sph_rej_sam_3.sample();
+  assert(sph_rej_sam_3.get_statistics().n_samples == 2);
+}
@@ -17,6 +17,8 @@
     Copyright (C) 2021-2023 Udo Friman-Gayer
 */
 
+#include <cassert>
+
 #include <fstream>
 
 using std::ofstream;
@@ -29,6 +31,10 @@ using std::endl;
 
 using std::stringstream;
 
+#include <string>
+
+using std::string;
+
 #include "State.hh"
 #include "Transition.hh"
 #include "W_dir_dir.hh"
@@ -95,4 +101,17 @@ int main() {
   texfile_buffer << "\\end{document}\n";
   texfile << texfile_buffer.str();
   texfile.close();
+
+  // Writing all representations into a single buffer gives the same result as
+  // the concatenation of the individual strings.
+  string concatenated, buffer = "%";
+  buffer.reserve(1 << 16);
+  for (auto w : w_gamma_gamma) {
+    concatenated += w->string_representation() +
+                    w->string_representation(precision) + "\n";
+    w->write_string_representation(buffer);
+    w->write_string_representation(buffer, precision);
+    buffer += "\n";
+  }
+  assert(buffer == "%" + concatenated);
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <array>
+
+using std::array;
+
+#include <cassert>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "State.hh"
+#include "TabulatedAngularCorrelation.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+#include "TypedSphereRejectionSampler.hh"
+
+/**
+ * Compare the tabulated angular correlation to the original object, and check
+ * that the deviation is within the certified error bound.
+ */
+void test_tabulated_angular_correlation(const AngularCorrelation &ang_cor,
+                                        const double max_error) {
+  const TabulatedAngularCorrelation tabulated(ang_cor, max_error);
+
+  assert(tabulated.get_nu_max() == ang_cor.get_nu_max());
+  assert(tabulated.is_polarized() ==
+         !ang_cor.get_associated_legendre_coefficients().empty());
+  assert(tabulated.get_error_bound() <= max_error);
+  if (ang_cor.get_nu_max() <= 2) {
+    assert(tabulated.get_n_intervals() == 1);
+  }
+
+  // Rounding errors of the table
+  const double epsilon = tabulated.get_error_bound() + 1e-12;
+
+  const size_t n = 1001;
+  vector<double> theta(n), phi(n), result(n), result_tabulated(n);
+  for (size_t i = 0; i < n; ++i) {
+    theta[i] = M_PI * i / (n - 1.);
+    phi[i] = 2. * M_PI * ((13 * i) % n) / n;
+  }
+  ang_cor.evaluate(n, theta.data(), phi.data(), result.data());
+  tabulated.evaluate(n, theta.data(), phi.data(), result_tabulated.data());
+  for (size_t i = 0; i < n; ++i) {
+    test_numerical_equality<double>(result_tabulated[i], result[i], epsilon);
+    test_numerical_equality<double>(tabulated(theta[i], phi[i]), result[i],
+                                    epsilon);
+    assert(result_tabulated[i] <= tabulated.get_upper_limit() + 1e-12);
+  }
+
+  // Rotated evaluation
+  const array<double, 3> Phi_Theta_Psi{0.3, 1.2, -0.7};
+  ang_cor.evaluate(n, theta.data(), phi.data(), Phi_Theta_Psi, result.data());
+  tabulated.evaluate(n, theta.data(), phi.data(), Phi_Theta_Psi,
+                     result_tabulated.data());
+  for (size_t i = 0; i < n; ++i) {
+    test_numerical_equality<double>(result_tabulated[i], result[i], epsilon);
+  }
+
+  // Copies share the table.
+  const TabulatedAngularCorrelation copy = tabulated;
+  test_numerical_equality<double>(copy(0.4, 0.2), tabulated(0.4, 0.2), 0.);
+}
+
+int main() {
+
+  // 0 -> 1 -> 0, exact with a single interval
+  test_tabulated_angular_correlation(
+      AngularCorrelation(
+          State(0, positive),
+          {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+           {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}}),
+      1e-6);
+
+  // 0 -> 2 -> 0
+  test_tabulated_angular_correlation(
+      AngularCorrelation(
+          State(0, positive),
+          {{Transition(electric, 4, magnetic, 6, 0.), State(4, positive)},
+           {Transition(electric, 4, magnetic, 6, 0.), State(0, positive)}}),
+      1e-6);
+
+  // Dir-dir correlation with mixed transitions
+  test_tabulated_angular_correlation(
+      AngularCorrelation(State(3, parity_unknown),
+                         {{Transition(em_unknown, 2, em_unknown, 4, 0.3),
+                           State(5, parity_unknown)},
+                          {Transition(em_unknown, 2, em_unknown, 4, -0.7),
+                           State(3, parity_unknown)}}),
+      1e-8);
+
+  // Higher orders of the expansion
+  const AngularCorrelation ang_cor(
+      State(0, positive),
+      {{Transition(magnetic, 6, electric, 8, 0.), State(6, positive)},
+       {Transition(magnetic, 6, electric, 8, 0.), State(0, positive)}});
+  test_tabulated_angular_correlation(ang_cor, 1e-3);
+  test_tabulated_angular_correlation(ang_cor, 1e-9);
+
+  // A smaller maximum error requires more intervals.
+  assert(TabulatedAngularCorrelation(ang_cor, 1e-9).get_n_intervals() >
+         TabulatedAngularCorrelation(ang_cor, 1e-3).get_n_intervals());
+
+  // The tabulated angular correlation can be used by a rejection sampler.
+  const TabulatedAngularCorrelation tabulated(ang_cor);
+  TypedSphereRejectionSampler<TabulatedAngularCorrelation> sampler(
+      tabulated, tabulated.get_upper_limit(), 0);
+  for (size_t i = 0; i < 100; ++i) {
+    assert(sampler.sample().first < 1000);
+  }
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    TabulatedAngularCorrelation(ang_cor, 0.);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    TabulatedAngularCorrelation(ang_cor, 1e-300);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    TabulatedAngularCorrelation({1., 0.5}, {0.1, 0.2});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
@@ -0,0 +1,139 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <atomic>
+
+using std::atomic;
+
+#include <cassert>
+
+#include <stdexcept>
+
+using std::runtime_error;
+
+#include <thread>
+
+using std::this_thread::get_id;
+using std::thread;
+
+#include <vector>
+
+using std::vector;
+
+#include "ThreadPool.hh"
+
+/**
+ * \brief Check that ThreadPool::parallel_for() calls the function exactly once
+ * for each index.
+ */
+void test_coverage(const size_t n, const size_t work_per_index) {
+  vector<atomic<unsigned int>> calls(n);
+  for (auto &c : calls) {
+    c = 0;
+  }
+  ThreadPool::parallel_for(
+      n,
+      [&calls](const size_t begin, const size_t end) {
+        assert(begin < end);
+        for (size_t i = begin; i < end; ++i) {
+          ++calls[i];
+        }
+      },
+      work_per_index);
+  for (size_t i = 0; i < n; ++i) {
+    assert(calls[i] == 1);
+  }
+}
+
+int main() {
+  ThreadPool::set_n_threads(0);
+  assert(ThreadPool::get_n_threads() ==
+         (thread::hardware_concurrency() == 0 ? 1
+                                              : thread::hardware_concurrency()));
+  assert(ThreadPool::get_min_work() == ThreadPool::default_min_work);
+
+  for (unsigned int n_threads : {1, 2, 3, 8}) {
+    ThreadPool::set_n_threads(n_threads);
+    assert(ThreadPool::get_n_threads() == n_threads);
+    for (size_t min_work : {1, 7, 1000}) {
+      ThreadPool::set_min_work(min_work);
+      for (size_t n : {0, 1, 2, 5, 999, 1000, 1001, 123457}) {
+        test_coverage(n, 1);
+        test_coverage(n, 3);
+      }
+    }
+  }
+
+  // Below the cutoff, and with a single thread, the function is called once in
+  // the calling thread.
+  ThreadPool::set_n_threads(4);
+  ThreadPool::set_min_work(ThreadPool::default_min_work);
+  for (unsigned int n_threads : {1, 4}) {
+    ThreadPool::set_n_threads(n_threads);
+    const size_t n = n_threads == 1 ? 10 * ThreadPool::default_min_work
+                                    : ThreadPool::default_min_work - 1;
+    [[maybe_unused]] size_t n_calls = 0;
+    ThreadPool::parallel_for(
+        n, [&n_calls, n]([[maybe_unused]] const size_t begin,
+                         [[maybe_unused]] const size_t end) {
+          ++n_calls;
+          assert(begin == 0 && end == n);
+        });
+    assert(n_calls == 1);
+  }
+  ThreadPool::set_n_threads(4);
+  [[maybe_unused]] const auto caller = get_id();
+  ThreadPool::parallel_for(100, [caller](const size_t, const size_t) {
+    assert(get_id() == caller);
+  });
+
+  // Exceptions are rethrown in the calling thread, and the pool remains usable.
+  ThreadPool::set_min_work(1);
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    ThreadPool::parallel_for(1000, [](const size_t begin, const size_t) {
+      if (begin > 0) {
+        throw runtime_error("Error in a worker.");
+      }
+    });
+  } catch (const runtime_error &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+  test_coverage(1000, 1);
+
+  // Nested calls and concurrent calls from several threads.
+  atomic<size_t> sum{0};
+  ThreadPool::parallel_for(16, [&sum](const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      ThreadPool::parallel_for(100, [&sum](const size_t b, const size_t e) {
+        sum += e - b;
+      });
+    }
+  });
+  assert(sum == 1600);
+
+  vector<thread> callers;
+  for (size_t i = 0; i < 4; ++i) {
+    callers.emplace_back([]() { test_coverage(10000, 1); });
+  }
+  for (auto &t : callers) {
+    t.join();
+  }
+}
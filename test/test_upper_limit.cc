@@ -17,13 +17,17 @@
     Copyright (C) 2021-2023 Udo Friman-Gayer
 */
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cmath>
 #include <vector>
 
 using std::array;
+using std::max;
 using std::vector;
 
+#include <gsl/gsl_math.h>
 #include <gsl/gsl_sf.h>
 
 #include "SpherePointSampler.hh"
@@ -553,6 +557,10 @@ vector<W_gamma_gamma *> ang_corrs{
  * Test by sampling values from different angular correlations and comparing
  * them to the upper limit. The almost uniform sampling is performed using the
  * SpherePointSampler.
+ * The exact maximum is compared to the upper limit and to the largest value on
+ * a fine grid of polar angles. For the latter, it is sufficient to consider
+ * the azimuthal angles \f$0\f$ and \f$\pi/2\f$, where \f$\cos \left( 2
+ * \varphi \right) = \pm 1\f$.
  */
 int main() {
 
@@ -561,11 +569,26 @@ int main() {
   const unsigned int n_sphere_points = 1000;
   array<vector<double>, 2> sphere_points = sph_poi_sam.sample(n_sphere_points);
 
-  double ang_cor_max{0.}, ang_cor_val{0.}, ang_cor_upp_lim{0.};
+  double ang_cor_max{0.}, ang_cor_val{0.}, ang_cor_upp_lim{0.},
+      ang_cor_exact_max{0.}, ang_cor_grid_max{0.};
+  const unsigned int n_theta = 20001;
 
   for (auto ang_cor : ang_corrs) {
     ang_cor_max = 0.;
     ang_cor_upp_lim = ang_cor->get_upper_limit();
+    ang_cor_exact_max = ang_cor->get_maximum();
+    assert(ang_cor_exact_max <= ang_cor_upp_lim * (1. + 1e-12));
+
+    ang_cor_grid_max = 0.;
+    for (unsigned int i = 0; i < n_theta; ++i) {
+      for (double phi : {0., M_PI_2}) {
+        ang_cor_val = fabs(ang_cor->operator()(M_PI * i / (n_theta - 1), phi));
+        assert(ang_cor_val <= ang_cor_exact_max * (1. + 1e-10));
+        ang_cor_grid_max = max(ang_cor_grid_max, ang_cor_val);
+      }
+    }
+    test_numerical_equality<double>(ang_cor_grid_max, ang_cor_exact_max,
+                                    1e-6);
 
     for (size_t i = 0; i < n_sphere_points; ++i) {
       ang_cor_val =
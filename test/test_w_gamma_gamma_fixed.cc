@@ -0,0 +1,167 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <stdexcept>
+
+using std::invalid_argument;
+
+#include <utility>
+
+using std::pair;
+
+#include <variant>
+
+using std::holds_alternative;
+using std::visit;
+
+#include <vector>
+
+using std::vector;
+
+#include <type_traits>
+
+using std::decay_t;
+using std::is_same_v;
+
+#include <gsl/gsl_math.h>
+
+#include "AngularCorrelation.hh"
+#include "State.hh"
+#include "TestUtilities.hh"
+#include "Transition.hh"
+#include "W_gamma_gamma_fixed.hh"
+
+/**
+ * Compare the fixed-order evaluation to the general implementation, and
+ * return the fixed-order correlation.
+ */
+W_gamma_gamma_fixed test_fixed_order(const State initial_state,
+                      const vector<pair<Transition, State>> cascade_steps,
+                      const int expected_nu_max) {
+  const AngularCorrelation ang_cor(initial_state, cascade_steps);
+  const auto w_gamma_gamma = ang_cor.get_w_gamma_gamma();
+  assert(w_gamma_gamma->get_nu_max() == expected_nu_max);
+
+  const W_gamma_gamma_fixed w_fixed = make_w_gamma_gamma_fixed(
+      w_gamma_gamma->get_nu_max(), w_gamma_gamma->get_legendre_coefficients(),
+      w_gamma_gamma->get_associated_legendre_coefficients());
+  assert(((expected_nu_max & ~1) <= fixed_order_nu_max_limit) ==
+         !holds_alternative<monostate>(w_fixed));
+
+  for (double theta = 0.; theta < M_PI; theta += 0.1) {
+    for (double phi = 0.; phi < 2. * M_PI; phi += 0.2) {
+      const double w = (*w_gamma_gamma)(theta, phi);
+      test_numerical_equality<double>(ang_cor(theta, phi), w, 1e-12);
+      visit(
+          [&](const auto &w_f) {
+            if constexpr (!is_same_v<decay_t<decltype(w_f)>, monostate>) {
+              test_numerical_equality<double>(w_f(theta, phi), w, 1e-12);
+            }
+          },
+          w_fixed);
+    }
+  }
+
+  return w_fixed;
+}
+
+int main() {
+
+  // 0 -> 1 -> 0
+  test_fixed_order(
+      State(0, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.), State(2, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, 0.),
+        State(0, parity_unknown)}},
+      2);
+  test_fixed_order(
+      State(0, positive),
+      {{Transition(electric, 2, magnetic, 4, 0.), State(2, negative)},
+       {Transition(electric, 2, magnetic, 4, 0.), State(0, positive)}},
+      2);
+  test_fixed_order(
+      State(0, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.), State(2, positive)},
+       {Transition(magnetic, 2, electric, 4, 0.), State(0, positive)}},
+      2);
+
+  // 0 -> 2 -> 0
+  test_fixed_order(
+      State(0, positive),
+      {{Transition(electric, 4, magnetic, 6, 0.), State(4, positive)},
+       {Transition(electric, 4, magnetic, 6, 0.), State(0, positive)}},
+      4);
+
+  // 1/2 -> 3/2 -> 1/2 with a mixed transition. The maximum order is odd for
+  // half-integer spins, but only the even orders up to 2 contribute.
+  assert(holds_alternative<W_pol_dir_fixed<2>>(test_fixed_order(
+      State(1, positive),
+      {{Transition(magnetic, 2, electric, 4, 0.3), State(3, positive)},
+       {Transition(magnetic, 2, electric, 4, -0.5), State(1, positive)}},
+      3)));
+  assert(holds_alternative<W_dir_dir_fixed<2>>(test_fixed_order(
+      State(1, parity_unknown),
+      {{Transition(em_unknown, 2, em_unknown, 4, 0.3),
+        State(3, parity_unknown)},
+       {Transition(em_unknown, 2, em_unknown, 4, -0.5),
+        State(1, parity_unknown)}},
+      3)));
+
+  // Higher orders, with an unobserved intermediate transition
+  test_fixed_order(
+      State(0, positive),
+      {{Transition(magnetic, 6, electric, 8, 0.), State(6, positive)},
+       {Transition(magnetic, 6, electric, 8, 0.), State(0, positive)}},
+      6);
+  test_fixed_order(
+      State(8, parity_unknown),
+      {{Transition(em_unknown, 8, em_unknown, 10, 0.1),
+        State(8, parity_unknown)},
+       {Transition(em_unknown, 8, em_unknown, 10, 0.),
+        State(16, parity_unknown)},
+       {Transition(em_unknown, 8, em_unknown, 10, 0.2),
+        State(8, parity_unknown)}},
+      8);
+
+  // No specialization for large orders.
+  test_fixed_order(
+      State(0, positive),
+      {{Transition(electric, 10, magnetic, 12, 0.), State(10, negative)},
+       {Transition(electric, 10, magnetic, 12, 0.), State(0, positive)}},
+      10);
+
+  // The number of coefficients must match the order.
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    W_dir_dir_fixed<4> w({1., 0.5});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+
+  error_thrown = false;
+  try {
+    W_pol_dir_fixed<2> w({1., 0.5}, {0.1, 0.2});
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
+}
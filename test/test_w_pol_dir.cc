@@ -20,6 +20,10 @@
 #include <cassert>
 #include <cmath>
 
+#include <stdexcept>
+
+using std::invalid_argument;
+
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_sf.h>
 
@@ -216,4 +220,46 @@ int main() {
       "P_{2}^{\\left|2\\right|}\\left[\\cos\\left(\\theta\\right)\\right]" +
       "\\left.\\right\\}";
   assert(w_0p_1p_1p_2p.string_representation() == str_rep_2);
+
+  // A partially polarized correlation is the weighted sum of the pol-dir and
+  // the dir-dir correlation. The upper limit remains valid.
+  epsilon = 1e-12;
+  const vector<pair<Transition, State>> cascade_steps{
+      {Transition(magnetic, 2, electric, 4, 0.5), State(5, positive)},
+      {Transition(magnetic, 2, electric, 4, -1.5), State(3, positive)}};
+  const W_pol_dir w_polarized(State(3, positive), cascade_steps);
+  const W_dir_dir w_unpolarized(State(3, positive), cascade_steps);
+  for (double P : {0.3, 0., -0.7}) {
+    W_pol_dir w_partial(State(3, positive), cascade_steps);
+    w_partial.set_polarization_degree(P);
+    assert(w_partial.get_polarization_degree() == P);
+    const double upper_limit = w_partial.get_upper_limit();
+    vector<double> theta, phi;
+    for (double t = 0.; t < M_PI; t += 0.5) {
+      for (double p = 0.; p < M_2_PI; p += 0.5) {
+        w_num = w_partial(t, p);
+        w_ana = P * w_polarized(t, p) + (1. - P) * w_unpolarized(t, p);
+        test_numerical_equality<double>(w_num, w_ana, epsilon);
+        assert(w_num <= upper_limit);
+        theta.push_back(t);
+        phi.push_back(p);
+      }
+    }
+
+    vector<double> w_vectorized(theta.size());
+    w_partial.evaluate(theta.size(), theta.data(), phi.data(),
+                       w_vectorized.data());
+    for (size_t i = 0; i < theta.size(); ++i) {
+      test_numerical_equality<double>(w_vectorized[i],
+                                      w_partial(theta[i], phi[i]), epsilon);
+    }
+  }
+
+  [[maybe_unused]] bool error_thrown = false;
+  try {
+    W_pol_dir(State(3, positive), cascade_steps).set_polarization_degree(1.1);
+  } catch (const invalid_argument &e) {
+    error_thrown = true;
+  }
+  assert(error_thrown);
 }
@@ -0,0 +1,114 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <cmath>
+
+using std::pow;
+using std::sqrt;
+
+#include <gsl/gsl_sf.h>
+
+#include "TestUtilities.hh"
+#include "WignerRecursion.hh"
+
+int main() {
+
+  // Comparison to the Racah formula for small angular momenta, including all
+  // cases where the symbols vanish.
+  for (int two_j2 = 0; two_j2 <= 10; ++two_j2) {
+    for (int two_j3 = 0; two_j3 <= 10; ++two_j3) {
+      for (int two_m2 = -two_j2; two_m2 <= two_j2; two_m2 += 2) {
+        for (int two_m3 = -two_j3; two_m3 <= two_j3; two_m3 += 2) {
+          const WignerSymbolSequence sequence =
+              wigner_recursion::coupling_3j_sequence(two_j2, two_j3, two_m2,
+                                                     two_m3);
+          for (int two_j1 = 0; two_j1 <= 22; ++two_j1) {
+            test_numerical_equality<double>(
+                sequence(two_j1),
+                gsl_sf_coupling_3j(two_j1, two_j2, two_j3, -two_m2 - two_m3,
+                                   two_m2, two_m3),
+                1e-14);
+          }
+        }
+      }
+    }
+  }
+
+  for (int two_j2 = 0; two_j2 <= 8; ++two_j2) {
+    for (int two_j3 = 0; two_j3 <= 8; ++two_j3) {
+      for (int two_l1 = 0; two_l1 <= 8; ++two_l1) {
+        for (int two_l2 = 0; two_l2 <= 8; ++two_l2) {
+          for (int two_l3 = 0; two_l3 <= 8; ++two_l3) {
+            const WignerSymbolSequence sequence =
+                wigner_recursion::coupling_6j_sequence(two_j2, two_j3, two_l1,
+                                                       two_l2, two_l3);
+            for (int two_j1 = 0; two_j1 <= 18; ++two_j1) {
+              test_numerical_equality<double>(
+                  sequence(two_j1),
+                  gsl_sf_coupling_6j(two_j1, two_j2, two_j3, two_l1, two_l2,
+                                     two_l3),
+                  1e-14);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Closed expression for large angular momenta:
+  //
+  // {a b c; 0 c b} = (-1)^(a + b + c) / sqrt((2b + 1)(2c + 1))
+  const int two_b = 121, two_c = 95;
+  const WignerSymbolSequence sequence_0 =
+      wigner_recursion::coupling_6j_sequence(two_b, two_c, 0, two_c, two_b);
+  assert(sequence_0.two_j1_min == two_b - two_c);
+  assert(sequence_0.two_j1_max == two_b + two_c);
+  for (int two_a = sequence_0.two_j1_min; two_a <= sequence_0.two_j1_max;
+       two_a += 2) {
+    test_numerical_equality<double>(
+        sequence_0(two_a),
+        pow(-1., (two_a + two_b + two_c) / 2) /
+            sqrt((two_b + 1.) * (two_c + 1.)),
+        1e-14);
+  }
+
+  // Orthogonality of the 6j symbols for large angular momenta.
+  const WignerSymbolSequence sequence_1 =
+      wigner_recursion::coupling_6j_sequence(80, 84, 60, 70, 72);
+  const WignerSymbolSequence sequence_2 =
+      wigner_recursion::coupling_6j_sequence(80, 84, 62, 70, 72);
+  double sum_11 = 0., sum_12 = 0.;
+  for (int two_j1 = sequence_1.two_j1_min; two_j1 <= sequence_1.two_j1_max;
+       two_j1 += 2) {
+    sum_11 += (two_j1 + 1.) * (60 + 1.) * sequence_1(two_j1) *
+              sequence_1(two_j1);
+    sum_12 += (two_j1 + 1.) * sequence_1(two_j1) * sequence_2(two_j1);
+  }
+  test_numerical_equality<double>(sum_11, 1., 1e-14);
+  test_numerical_equality<double>(sum_12, 0., 1e-14);
+
+  // Vanishing sequences.
+  assert(wigner_recursion::coupling_3j_sequence(2, 2, 3, 0).values.empty());
+  assert(wigner_recursion::coupling_6j_sequence(2, 2, 10, 2, 2).values.empty());
+  assert(wigner_recursion::coupling_6j_sequence(2, 2, 2, 1, 2).values.empty());
+  assert(wigner_recursion::coupling_6j_sequence(2, 2, 2, 2, 2)(-2) == 0.);
+  assert(wigner_recursion::coupling_6j_sequence(2, 2, 2, 2, 2)(3) == 0.);
+}
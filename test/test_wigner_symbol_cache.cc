@@ -0,0 +1,131 @@
+/*
+    This file is part of alpaca.
+
+    alpaca is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    alpaca is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with alpaca.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2021-2023 Udo Friman-Gayer
+*/
+
+#include <cassert>
+
+#include <thread>
+
+using std::thread;
+
+#include <vector>
+
+using std::vector;
+
+#include <gsl/gsl_sf.h>
+
+#include "FCoefficient.hh"
+#include "TestUtilities.hh"
+#include "WignerSymbolCache.hh"
+
+void compare_to_gsl() {
+  for (int two_ja = 0; two_ja < 8; ++two_ja) {
+    for (int two_jb = 0; two_jb < 8; ++two_jb) {
+      for (int two_jc = 0; two_jc < 8; ++two_jc) {
+        test_numerical_equality<double>(
+            WignerSymbolCache::coupling_3j(two_ja, two_jb, two_jc, 2, -2, 0),
+            gsl_sf_coupling_3j(two_ja, two_jb, two_jc, 2, -2, 0), 1e-14);
+        test_numerical_equality<double>(
+            WignerSymbolCache::coupling_6j(two_ja, two_ja, two_jc, two_jb,
+                                           two_jb, 4),
+            gsl_sf_coupling_6j(two_ja, two_ja, two_jc, two_jb, two_jb, 4),
+            1e-14);
+      }
+    }
+  }
+}
+
+int main() {
+
+  // The counts of the cache entries below assume that each symbol is
+  // calculated separately.
+  assert(WignerSymbolCache::get_backend() == recursion_backend);
+  WignerSymbolCache::set_backend(gsl_backend);
+  WignerSymbolCache::clear();
+  assert(WignerSymbolCache::size() == 0);
+  assert(WignerSymbolCache::get_hits() == 0);
+  assert(WignerSymbolCache::get_misses() == 0);
+
+  // The first pass calculates all values, the second one only reads the
+  // cache.
+  compare_to_gsl();
+  const size_t n_entries = WignerSymbolCache::size();
+  const size_t n_misses = WignerSymbolCache::get_misses();
+  assert(n_entries == 2 * 8 * 8 * 8);
+  assert(n_misses == n_entries);
+  assert(WignerSymbolCache::get_hits() == 0);
+
+  compare_to_gsl();
+  assert(WignerSymbolCache::size() == n_entries);
+  assert(WignerSymbolCache::get_misses() == n_misses);
+  assert(WignerSymbolCache::get_hits() == n_entries);
+
+  // Coefficients that vanish due to selection rules do not touch the cache.
+  WignerSymbolCache::clear();
+  assert(FCoefficient(2, 2, 2, 0, 0).get_value() == 0.);
+  assert(FCoefficient(6, 2, 2, 0, 2).get_value() == 0.);
+  assert(WignerSymbolCache::get_hits() + WignerSymbolCache::get_misses() == 0);
+
+  // Identical coefficients share the Wigner symbols.
+  const double f_value = FCoefficient(4, 2, 4, 2, 2).get_value();
+  const size_t n_misses_f = WignerSymbolCache::get_misses();
+  assert(n_misses_f == 2);
+  test_numerical_equality<double>(FCoefficient(4, 2, 4, 2, 2).get_value(),
+                                  f_value, 1e-14);
+  assert(WignerSymbolCache::get_misses() == n_misses_f);
+  assert(WignerSymbolCache::get_hits() == 2);
+
+  // The size of the cache is bounded.
+  WignerSymbolCache::clear();
+  WignerSymbolCache::set_max_size(10);
+  compare_to_gsl();
+  assert(WignerSymbolCache::size() == 2 * 10);
+  WignerSymbolCache::set_max_size(5);
+  assert(WignerSymbolCache::size() == 0);
+  WignerSymbolCache::set_max_size(0);
+  compare_to_gsl();
+  assert(WignerSymbolCache::size() == 0);
+  WignerSymbolCache::set_max_size(1 << 20);
+
+  // Concurrent access from several threads.
+  WignerSymbolCache::clear();
+  vector<thread> threads;
+  for (size_t i = 0; i < 4; ++i) {
+    threads.push_back(thread(compare_to_gsl));
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  assert(WignerSymbolCache::size() == n_entries);
+  assert(WignerSymbolCache::get_hits() + WignerSymbolCache::get_misses() ==
+         4 * n_entries);
+
+  // The recursion calculates all values of the first argument at once.
+  WignerSymbolCache::set_backend(recursion_backend);
+  WignerSymbolCache::clear();
+  compare_to_gsl();
+  assert(WignerSymbolCache::get_misses() < n_misses);
+
+  // All orders of an F coefficient with fixed angular momenta require only a
+  // single calculation of each symbol.
+  WignerSymbolCache::clear();
+  for (int two_nu = 0; two_nu <= 8; two_nu += 4) {
+    FCoefficient(two_nu, 2, 4, 2, 2);
+  }
+  assert(WignerSymbolCache::get_misses() == 2);
+}